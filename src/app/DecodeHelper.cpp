@@ -0,0 +1,44 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+// scantailor-decode-helper: decodes images on behalf of the application,
+// see IsolatedImageDecoder.  It's started by the application and isn't
+// meant to be run by hand.
+
+#include <QCoreApplication>
+#include <QString>
+#include <QStringList>
+#include <cstdio>
+
+#include "IsolatedImageDecoder.h"
+
+int main(int argc, char** argv) {
+  QCoreApplication app(argc, argv);
+
+  int socketFd = -1;
+  IsolatedImageDecoder::Limits limits;
+  for (const QString& arg : QCoreApplication::arguments().mid(1)) {
+    bool ok = true;
+    if (arg.startsWith(QLatin1String("--socket-fd="))) {
+      socketFd = arg.mid(12).toInt(&ok);
+    } else if (arg.startsWith(QLatin1String("--address-space-mb="))) {
+      limits.addressSpaceBytes = arg.mid(19).toULongLong(&ok) * 1024 * 1024;
+    } else if (arg.startsWith(QLatin1String("--image-mb="))) {
+      limits.imageBytes = arg.mid(11).toULongLong(&ok) * 1024 * 1024;
+    } else if (arg.startsWith(QLatin1String("--cpu-seconds="))) {
+      limits.cpuSeconds = arg.mid(14).toInt(&ok);
+    } else {
+      ok = false;
+    }
+    if (!ok) {
+      std::fprintf(stderr, "Unexpected argument: %s\n", qPrintable(arg));
+      return 2;
+    }
+  }
+
+  if (socketFd < 0) {
+    std::fprintf(stderr, "This program is started by ScanTailor and isn't meant to be run directly.\n");
+    return 2;
+  }
+  return IsolatedImageDecoder::serve(socketFd, limits);
+}
@@ -52,7 +52,6 @@
 #include "Application.h"
 #include "ProjectFolder.h"
 #include "ProjectFolderRelinker.h"
-#include "AutoRemovingFile.h"
 #include "BasicImageView.h"
 #include "ContentBoxPropagator.h"
 #include "DebugImageView.h"
@@ -98,6 +97,7 @@
 #include "SystemLoadWidget.h"
 #include "TabbedDebugImages.h"
 #include "ThumbnailFactory.h"
+#include "TiffBookContainer.h"
 #include "UnitsProvider.h"
 #include "Utils.h"
 #include "WorkerThreadPool.h"
@@ -109,6 +109,8 @@
 #include "filters/deskew/Settings.h"
 #include "filters/deskew/Task.h"
 #include "filters/fix_orientation/CacheDrivenTask.h"
+#include "filters/fix_orientation/Filter.h"
+#include "filters/fix_orientation/Settings.h"
 #include "filters/fix_orientation/Task.h"
 #include "filters/output/CacheDrivenTask.h"
 #include "filters/output/ColorParams.h"
@@ -699,6 +701,7 @@ MainWindow::MainWindow(bool restoreGeometry)
 
 MainWindow::~MainWindow() {
   m_interactiveQueue->cancelAndClear();
+  cancelSpeculativeTasks();
   if (m_batchQueue) {
     m_batchQueue->cancelAndClear();
   }
@@ -730,6 +733,7 @@ void MainWindow::switchToNewProject(const std::shared_ptr<ProjectPages>& pages,
                                     const ProjectReader* projectReader) {
   stopBatchProcessing(CLEAR_MAIN_AREA);
   m_interactiveQueue->cancelAndClear();
+  cancelSpeculativeTasks();
 
   if (!outDir.isEmpty()) {
     Utils::maybeCreateCacheDir(outDir);
@@ -1170,6 +1174,8 @@ void MainWindow::setOptionsWidget(FilterOptionsWidget* widget, const Ownership o
                SLOT(invalidateThumbnail(const PageId&)));
     disconnect(m_optionsWidget, SIGNAL(invalidateThumbnail(const PageInfo&)), this,
                SLOT(invalidateThumbnail(const PageInfo&)));
+    disconnect(m_optionsWidget, SIGNAL(invalidateThumbnails(const std::set<PageId>&)), this,
+               SLOT(invalidateThumbnails(const std::set<PageId>&)));
     disconnect(m_optionsWidget, SIGNAL(invalidateAllThumbnails()), this, SLOT(invalidateAllThumbnails()));
     disconnect(m_optionsWidget, SIGNAL(goToPage(const PageId&)), this, SLOT(goToPage(const PageId&)));
   }
@@ -1184,6 +1190,8 @@ void MainWindow::setOptionsWidget(FilterOptionsWidget* widget, const Ownership o
   connect(widget, SIGNAL(reloadRequested()), this, SLOT(reloadRequested()), Qt::QueuedConnection);
   connect(widget, SIGNAL(invalidateThumbnail(const PageId&)), this, SLOT(invalidateThumbnail(const PageId&)));
   connect(widget, SIGNAL(invalidateThumbnail(const PageInfo&)), this, SLOT(invalidateThumbnail(const PageInfo&)));
+  connect(widget, SIGNAL(invalidateThumbnails(const std::set<PageId>&)), this,
+          SLOT(invalidateThumbnails(const std::set<PageId>&)));
   connect(widget, SIGNAL(invalidateAllThumbnails()), this, SLOT(invalidateAllThumbnails()));
   connect(widget, SIGNAL(goToPage(const PageId&)), this, SLOT(goToPage(const PageId&)));
   connect(widget, SIGNAL(batchProcessingRequested(const std::set<PageId>&)), this,
@@ -1228,10 +1236,10 @@ void MainWindow::setImageWidget(QWidget* widget, const Ownership ownership, Debu
     }
   } else {
     m_tabbedDebugImages->addTab(widget, "Main");
-    AutoRemovingFile file;
+    std::shared_ptr<const DebugImageHandle> image;
     QString label;
-    while (!(file = debugImages->retrieveNext(&label)).get().isNull()) {
-      QWidget* view = new DebugImageView(file);
+    while ((image = debugImages->retrieveNext(&label))) {
+      QWidget* view = new DebugImageView(image);
       m_imageWidgetCleanup.add(view);
       m_tabbedDebugImages->addTab(view, label);
     }
@@ -1255,6 +1263,10 @@ void MainWindow::invalidateThumbnail(const PageInfo& pageInfo) {
   m_thumbSequence->invalidateThumbnail(pageInfo);
 }
 
+void MainWindow::invalidateThumbnails(const std::set<PageId>& pages) {
+  m_thumbSequence->invalidateThumbnails(pages);
+}
+
 void MainWindow::invalidateAllThumbnails() {
   m_thumbSequence->invalidateAllThumbnails();
 }
@@ -1272,16 +1284,17 @@ void MainWindow::batchProcessPages(const std::set<PageId>& pages) {
   }
 
   m_interactiveQueue->cancelAndClear();
+  cancelSpeculativeTasks();
 
   m_batchQueue = std::make_unique<ProcessingTaskQueue>();
 
   // Get the page sequence to look up PageInfo
   const PageSequence pageSequence = m_pages->toPageSequence(PAGE_VIEW);
 
-  // Add only the specified pages to the batch queue
-  for (const PageId& pageId : pages) {
-    const PageInfo& pageInfo = pageSequence.pageAt(pageId);
-    if (!pageInfo.isNull()) {
+  // Add only the specified pages to the batch queue, in a single pass over the sequence
+  // rather than a lookup per page.
+  for (const PageInfo& pageInfo : pageSequence) {
+    if (pages.find(pageInfo.id()) != pages.end()) {
       m_batchQueue->addProcessingTask(pageInfo, createCompositeTask(pageInfo, m_curFilter, /*batch=*/true, m_debug));
     }
   }
@@ -1597,6 +1610,7 @@ void MainWindow::filterSelectionChanged(const QItemSelection& selected) {
   }
 
   m_interactiveQueue->cancelAndClear();
+  cancelSpeculativeTasks();
   if (m_batchQueue) {
     // Should not happen, but just in case.
     m_batchQueue->cancelAndClear();
@@ -1734,6 +1748,7 @@ void MainWindow::startBatchProcessing() {
   }
 
   m_interactiveQueue->cancelAndClear();
+  cancelSpeculativeTasks();
 
   // Check if we're at Output but not all pages have their content sizes defined.
   // If so, we need a two-pass batch: first run Page Layout to gather all sizes,
@@ -2333,6 +2348,7 @@ void MainWindow::startBatchProcessingFrom(const PageInfo& startPage) {
   }
 
   m_interactiveQueue->cancelAndClear();
+  cancelSpeculativeTasks();
 
   m_batchQueue = std::make_unique<ProcessingTaskQueue>();
 
@@ -2472,6 +2488,14 @@ void MainWindow::filterResult(const BackgroundTaskPtr& task, const FilterResultP
   // for instance because thumbnail invalidation is done from here.
   result->updateUI(this);
 
+  if (!isBatchProcessingInProgress() && (task->type() == BackgroundTask::INTERACTIVE)) {
+    // The user is now looking at the page, so the workers are free to look ahead.
+    const PageInfo page(m_thumbSequence->selectionLeader());
+    if (!page.isNull()) {
+      scheduleSpeculativeTasks(page);
+    }
+  }
+
   if (isBatchProcessingInProgress()) {
     if (m_batchQueue->allProcessed()) {
       // Check if we're in a two-pass batch and need to start the second pass
@@ -2540,6 +2564,10 @@ void MainWindow::filterResult(const BackgroundTaskPtr& task, const FilterResultP
         reportManualBatchCompletion(batchElapsedMilliseconds, completedPageCount);
       }
       stopBatchProcessing();
+      if (const std::shared_ptr<TiffBookContainer> book = m_outFileNameGen.bookContainer()) {
+        // The pages replaced during the batch leave their old data behind.
+        book->compact();
+      }
 
       QApplication::alert(this);  // Flash the taskbar entry.
       if (m_checkBeepWhenFinished()) {
@@ -3406,6 +3434,7 @@ void MainWindow::loadPageInteractive(const PageInfo& page) {
   assert(!isBatchProcessingInProgress());
 
   m_interactiveQueue->cancelAndClear();
+  cancelSpeculativeTasks();
 
   if (isOutputFilter() && !checkReadyForOutput(&page.id())) {
     filterList->setBatchProcessingPossible(false);
@@ -3450,6 +3479,52 @@ void MainWindow::loadPageInteractive(const PageInfo& page) {
   m_workerThreadPool->submitTask(m_interactiveQueue->takeForProcessing());
 }  // MainWindow::loadPageInteractive
 
+void MainWindow::scheduleSpeculativeTasks(const PageInfo& page) {
+  cancelSpeculativeTasks();
+
+  // The content box is the costly analysis worth doing ahead of time.
+  // It's only started from the stages right before Select Content.
+  if ((m_curFilter != m_stages->deskewFilterIdx()) && (m_curFilter != m_stages->pageBoxFilterIdx())) {
+    return;
+  }
+
+  // The current page goes first, then the ones the user is likely to visit next.
+  for (const PageInfo& candidate :
+       {page, m_thumbSequence->nextPage(page.id()), m_thumbSequence->prevPage(page.id())}) {
+    if (candidate.isNull()) {
+      continue;
+    }
+    // The upstream stages only replay what they have stored, so that the speculation
+    // doesn't change anything the user would see.  Pages they have yet to process aren't
+    // worth trying, see fix_orientation::Filter::createSpeculativeTask() and the like.
+    if (!isSpeculationPossible(candidate)) {
+      continue;
+    }
+    const BackgroundTaskPtr task(createSpeculativeTask(candidate));
+    m_speculativeTasks.push_back(task);
+    m_workerThreadPool->submitTask(task);
+  }
+}
+
+bool MainWindow::isSpeculationPossible(const PageInfo& page) const {
+  if (ApplicationSettings::getInstance().isAutoOrientationDetectionEnabled()
+      && m_stages->fixOrientationFilter()->settings()->isOrientationDetectionNeeded(page.imageId())) {
+    return false;
+  }
+  if (!m_stages->pageSplitFilter()->settings()->getPageRecord(page.imageId()).params()) {
+    return false;
+  }
+  return !m_stages->deskewFilter()->settings()->isParamsNull(page.id())
+         && !m_stages->pageBoxFilter()->settings()->isParamsNull(page.id());
+}
+
+void MainWindow::cancelSpeculativeTasks() {
+  for (const BackgroundTaskPtr& task : m_speculativeTasks) {
+    task->cancel();
+  }
+  m_speculativeTasks.clear();
+}
+
 void MainWindow::updateWindowTitle() {
   QString projectName;
 
@@ -4096,6 +4171,16 @@ BackgroundTaskPtr MainWindow::createCompositeTask(const PageInfo& page,
                                         m_thumbnailCache, m_pages, fixOrientationTask);
 }  // MainWindow::createCompositeTask
 
+BackgroundTaskPtr MainWindow::createSpeculativeTask(const PageInfo& page) {
+  const auto selectContentTask = m_stages->selectContentFilter()->createSpeculativeTask(page.id());
+  const auto pageBoxTask = m_stages->pageBoxFilter()->createSpeculativeTask(page.id(), selectContentTask);
+  const auto deskewTask = m_stages->deskewFilter()->createSpeculativeTask(page.id(), pageBoxTask);
+  const auto pageSplitTask = m_stages->pageSplitFilter()->createSpeculativeTask(page, deskewTask);
+  const auto fixOrientationTask = m_stages->fixOrientationFilter()->createSpeculativeTask(page.id(), pageSplitTask);
+  return std::make_shared<LoadFileTask>(BackgroundTask::SPECULATIVE, page, m_thumbnailCache, m_pages,
+                                        fixOrientationTask);
+}
+
 std::shared_ptr<CompositeCacheDrivenTask> MainWindow::createCompositeCacheDrivenTask(const int lastFilterIdx) {
   std::shared_ptr<fix_orientation::CacheDrivenTask> fixOrientationTask;
   std::shared_ptr<page_split::CacheDrivenTask> pageSplitTask;
@@ -192,6 +192,8 @@ class MainWindow : public QMainWindow, private FilterUiInterface, private Ui::Ma
 
   void invalidateThumbnail(const PageInfo& pageInfo);
 
+  void invalidateThumbnails(const std::set<PageId>& pages) override;
+
   void invalidateAllThumbnails() override;
 
   void batchProcessPages(const std::set<PageId>& pages);
@@ -305,6 +307,19 @@ class MainWindow : public QMainWindow, private FilterUiInterface, private Ui::Ma
 
   void loadPageInteractive(const PageInfo& page);
 
+  /**
+   * \brief Runs the analysis of the next stage for \p page and its neighbours,
+   *        while the user is looking at the current one.
+   */
+  void scheduleSpeculativeTasks(const PageInfo& page);
+
+  /**
+   * \brief Whether all the stages before Select Content have processed \p page already.
+   */
+  bool isSpeculationPossible(const PageInfo& page) const;
+
+  void cancelSpeculativeTasks();
+
   void updateWindowTitle();
 
   bool closeProjectInteractive();
@@ -337,6 +352,8 @@ class MainWindow : public QMainWindow, private FilterUiInterface, private Ui::Ma
 
   BackgroundTaskPtr createCompositeTask(const PageInfo& page, int lastFilterIdx, bool batch, bool debug);
 
+  BackgroundTaskPtr createSpeculativeTask(const PageInfo& page);
+
   std::shared_ptr<CompositeCacheDrivenTask> createCompositeCacheDrivenTask(int lastFilterIdx);
 
   void createBatchProcessingWidget();
@@ -412,6 +429,7 @@ class MainWindow : public QMainWindow, private FilterUiInterface, private Ui::Ma
   std::unique_ptr<WorkerThreadPool> m_workerThreadPool;
   std::unique_ptr<ProcessingTaskQueue> m_batchQueue;
   std::unique_ptr<ProcessingTaskQueue> m_interactiveQueue;
+  std::vector<BackgroundTaskPtr> m_speculativeTasks;
   QStackedLayout* m_imageFrameLayout;
   QStackedLayout* m_optionsFrameLayout;
   QPointer<FilterOptionsWidget> m_optionsWidget;
@@ -7,10 +7,12 @@
 
 #include <QtCore/QDir>
 #include <QtWidgets/QMessageBox>
+#include <algorithm>
 #include <cmath>
 
 #include "Application.h"
 #include "OpenGLSupport.h"
+#include "ThreadPlacement.h"
 
 SettingsDialog::SettingsDialog(QWidget* parent) : QDialog(parent) {
   ui.setupUi(this);
@@ -47,11 +49,28 @@ SettingsDialog::SettingsDialog(QWidget* parent) : QDialog(parent) {
     ui.languageBox->setEnabled(ui.languageBox->count() > 1);
   }
 
+  ui.threadPlacementBox->addItem(tr("Any CPU"), threadPlacementPolicyToString(ThreadPlacementPolicy::ANY_CPU));
+  ui.threadPlacementBox->addItem(tr("Physical cores only"),
+                                 threadPlacementPolicyToString(ThreadPlacementPolicy::PHYSICAL_CORES));
+  ui.threadPlacementBox->addItem(tr("Single L3 cache domain"),
+                                 threadPlacementPolicyToString(ThreadPlacementPolicy::SINGLE_L3_DOMAIN));
+  ui.threadPlacementBox->addItem(tr("Single NUMA node"),
+                                 threadPlacementPolicyToString(ThreadPlacementPolicy::SINGLE_NUMA_NODE));
+  ui.threadPlacementBox->addItem(tr("Keep each page on its NUMA node"),
+                                 threadPlacementPolicyToString(ThreadPlacementPolicy::NODE_LOCAL_PAGES));
+  ui.threadPlacementBox->setCurrentIndex(std::max(0, ui.threadPlacementBox->findData(settings.getThreadPlacement())));
+#ifndef Q_OS_LINUX
+  ui.threadPlacementLabel->setEnabled(false);
+  ui.threadPlacementBox->setEnabled(false);
+#endif
+
   ui.blackOnWhiteDetectionCB->setChecked(settings.isBlackOnWhiteDetectionEnabled());
   ui.blackOnWhiteDetectionAtOutputCB->setEnabled(ui.blackOnWhiteDetectionCB->isChecked());
   ui.blackOnWhiteDetectionAtOutputCB->setChecked(settings.isBlackOnWhiteDetectionOutputEnabled());
   connect(ui.blackOnWhiteDetectionCB, SIGNAL(clicked(bool)), SLOT(blackOnWhiteDetectionToggled(bool)));
 
+  ui.autoOrientationDetectionCB->setChecked(settings.isAutoOrientationDetectionEnabled());
+
   ui.highlightDeviationCB->setChecked(settings.isHighlightDeviationEnabled());
 
   ui.deskewDeviationCoefSB->setValue(settings.getDeskewDeviationCoef());
@@ -82,6 +101,7 @@ void SettingsDialog::commitChanges() {
   settings.setHighlightDeviationEnabled(ui.highlightDeviationCB->isChecked());
   settings.setColorScheme(ui.colorSchemeBox->currentData().toString());
   settings.setLanguage(ui.languageBox->currentData().toString());
+  settings.setThreadPlacement(ui.threadPlacementBox->currentData().toString());
 
   settings.setDeskewDeviationCoef(ui.deskewDeviationCoefSB->value());
   settings.setDeskewDeviationThreshold(ui.deskewDeviationThresholdSB->value());
@@ -92,6 +112,7 @@ void SettingsDialog::commitChanges() {
 
   settings.setBlackOnWhiteDetectionEnabled(ui.blackOnWhiteDetectionCB->isChecked());
   settings.setBlackOnWhiteDetectionOutputEnabled(ui.blackOnWhiteDetectionAtOutputCB->isChecked());
+  settings.setAutoOrientationDetectionEnabled(ui.autoOrientationDetectionCB->isChecked());
 
   {
     const int quality = ui.thumbnailQualitySB->value();
@@ -20,8 +20,10 @@
 #include <boost/lambda/lambda.hpp>
 #include <boost/multi_index/hashed_index.hpp>
 #include <boost/multi_index/mem_fun.hpp>
+#include <boost/multi_index/random_access_index.hpp>
 #include <boost/multi_index/sequenced_index.hpp>
 #include <boost/multi_index_container.hpp>
+#include <algorithm>
 #include <functional>
 #include <memory>
 
@@ -52,6 +54,9 @@ class ThumbnailSequence::Item {
   mutable CompositeItem* composite;
   mutable bool incompleteThumbnail;
 
+  // Cached PageOrderProvider::sortKey() of the page.
+  mutable PageOrderKey orderKey;
+
  private:
   mutable bool m_isSelected;
   mutable bool m_isSelectionLeader;
@@ -102,6 +107,8 @@ class ThumbnailSequence::Impl {
 
   void invalidateThumbnail(const PageInfo& pageInfo);
 
+  void invalidateThumbnails(const std::set<PageId>& pages);
+
   void invalidateAllThumbnails();
 
   bool setSelection(const PageId& pageId, SelectionAction selectionAction);
@@ -154,7 +161,7 @@ class ThumbnailSequence::Impl {
   using Container = multi_index_container<
       Item,
       indexed_by<hashed_unique<tag<ItemsByIdTag>, const_mem_fun<Item, const PageId&, &Item::pageId>, std::hash<PageId>>,
-                 sequenced<tag<ItemsInOrderTag>>,
+                 random_access<tag<ItemsInOrderTag>>,
                  sequenced<tag<SelectedThenUnselectedTag>>>>;
 
   using ItemsById = Container::index<ItemsByIdTag>::type;
@@ -167,6 +174,14 @@ class ThumbnailSequence::Impl {
 
   void invalidateThumbnailImpl(ItemsById::iterator idIt);
 
+  void recreateCompositeItem(ItemsById::iterator idIt);
+
+  void rememberSelectionLeaderGeometry(ItemsById::iterator idIt);
+
+  void notifySelectionLeaderInvalidated();
+
+  void updateOrderKey(const Item& item) const;
+
   void sceneContextMenuEvent(QGraphicsSceneContextMenuEvent* evt);
 
   void selectItemNoModifiers(const ItemsById::iterator& it);
@@ -186,13 +201,13 @@ class ThumbnailSequence::Impl {
   void clearSelection();
 
   /**
-   * Calculates the insertion position for an item with the given PageId
-   * based on m_orderProvider.
+   * Calculates the insertion position for an item with the given sort key
+   * based on m_orderProvider.  Items in [begin, end) are expected to be
+   * ordered by their cached keys, which allows a binary search.
    *
    * \param begin Beginning of the interval to consider.
    * \param end End of the interval to consider.
-   * \param pageId The item to find insertion position for.
-   * \param pageIncomplete Whether the page is represented by IncompleteThumbnail.
+   * \param orderKey The sort key of the item to find insertion position for.
    * \param hint The place to start the search.  Must be within [begin, end].
    * \param distFromHint If provided, the distance from \p hint
    *        to the calculated insertion position will be written there.
@@ -201,8 +216,7 @@ class ThumbnailSequence::Impl {
    */
   ItemsInOrder::iterator itemInsertPosition(ItemsInOrder::iterator begin,
                                             ItemsInOrder::iterator end,
-                                            const PageId& pageId,
-                                            bool pageIncomplete,
+                                            const PageOrderKey& orderKey,
                                             ItemsInOrder::iterator hint,
                                             int* distFromHint = nullptr);
 
@@ -357,6 +371,10 @@ void ThumbnailSequence::invalidateThumbnail(const PageInfo& pageInfo) {
   m_impl->invalidateThumbnail(pageInfo);
 }
 
+void ThumbnailSequence::invalidateThumbnails(const std::set<PageId>& pages) {
+  m_impl->invalidateThumbnails(pages);
+}
+
 void ThumbnailSequence::invalidateAllThumbnails() {
   m_impl->invalidateAllThumbnails();
 }
@@ -607,11 +625,16 @@ int ThumbnailSequence::Impl::getGraphicsViewWidth() const {
 }
 
 void ThumbnailSequence::Impl::orderItems() {
-  // Sort pages in m_itemsInOrder using m_orderProvider.
+  // Sort pages in m_itemsInOrder by the keys m_orderProvider gave them.
+  // The sort is stable, so pages with equal keys keep their relative order.
   if (m_orderProvider) {
-    m_itemsInOrder.sort([this](const Item& lhs, const Item& rhs) {
-      return m_orderProvider->precedes(lhs.pageId(), lhs.incompleteThumbnail, rhs.pageId(), rhs.incompleteThumbnail);
-    });
+    m_itemsInOrder.sort([](const Item& lhs, const Item& rhs) { return lhs.orderKey < rhs.orderKey; });
+  }
+}
+
+void ThumbnailSequence::Impl::updateOrderKey(const Item& item) const {
+  if (m_orderProvider) {
+    item.orderKey = m_orderProvider->sortKey(item.pageId(), item.incompleteThumbnail);
   }
 }
 
@@ -672,28 +695,54 @@ void ThumbnailSequence::Impl::updateSceneItemsPos() {
 }
 
 void ThumbnailSequence::Impl::invalidateThumbnailImpl(const ItemsById::iterator idIt) {
+  recreateCompositeItem(idIt);
+
+  ItemsInOrder::iterator afterOld(m_items.project<ItemsInOrderTag>(idIt));
+  // Notice afterOld++ below.
+  // Move our item to the beginning of m_itemsInOrder, to make it out of range
+  // we are going to pass to itemInsertPosition().
+  m_itemsInOrder.relocate(m_itemsInOrder.begin(), afterOld++);
+  const ItemsInOrder::iterator afterNew(
+      itemInsertPosition(++m_itemsInOrder.begin(), m_itemsInOrder.end(), idIt->orderKey, afterOld));
+  // Move our item to its intended position.
+  m_itemsInOrder.relocate(afterNew, m_itemsInOrder.begin());
+}  // ThumbnailSequence::Impl::invalidateThumbnailImpl
+
+void ThumbnailSequence::Impl::recreateCompositeItem(const ItemsById::iterator idIt) {
   CompositeItem* const newComposite = getCompositeItem(&*idIt, idIt->pageInfo).release();
   CompositeItem* const oldComposite = idIt->composite;
   const QPointF oldPos(oldComposite->pos());
 
   idIt->composite = newComposite;
   idIt->incompleteThumbnail = newComposite->incompleteThumbnail();
+  updateOrderKey(*idIt);
   delete oldComposite;
 
   newComposite->updateAppearence(idIt->isSelected(), idIt->isSelectionLeader());
   newComposite->setPos(oldPos);
   m_graphicsScene.addItem(newComposite);
+}
 
-  ItemsInOrder::iterator afterOld(m_items.project<ItemsInOrderTag>(idIt));
-  // Notice afterOld++ below.
-  // Move our item to the beginning of m_itemsInOrder, to make it out of range
-  // we are going to pass to itemInsertPosition().
-  m_itemsInOrder.relocate(m_itemsInOrder.begin(), afterOld++);
-  const ItemsInOrder::iterator afterNew(itemInsertPosition(++m_itemsInOrder.begin(), m_itemsInOrder.end(),
-                                                           idIt->pageInfo.id(), idIt->incompleteThumbnail, afterOld));
-  // Move our item to its intended position.
-  m_itemsInOrder.relocate(afterNew, m_itemsInOrder.begin());
-}  // ThumbnailSequence::Impl::invalidateThumbnailImpl
+void ThumbnailSequence::Impl::rememberSelectionLeaderGeometry(const ItemsById::iterator idIt) {
+  if (m_selectionLeader == &*idIt && !m_selectionLeaderInvalidated) {
+    m_selectionLeaderInvalidated = true;
+    m_invalidatedSelectionLeaderPageId = idIt->pageId();
+    m_oldSelectionLeaderSize = idIt->composite->boundingRect().size();
+    m_oldSelectionLeaderPos = idIt->composite->pos();
+  }
+}
+
+void ThumbnailSequence::Impl::notifySelectionLeaderInvalidated() {
+  if (m_selectionLeaderInvalidated && m_selectionLeader
+      && m_selectionLeader->pageId() == m_invalidatedSelectionLeaderPageId
+      && (m_oldSelectionLeaderSize != m_selectionLeader->composite->boundingRect().size()
+          || m_oldSelectionLeaderPos != m_selectionLeader->composite->pos())) {
+    m_owner.emitNewSelectionLeader(
+        m_selectionLeader->pageInfo, m_selectionLeader->composite, REDUNDANT_SELECTION);
+  }
+  m_selectionLeaderInvalidated = false;
+  m_invalidatedSelectionLeaderPageId = PageId();
+}
 
 void ThumbnailSequence::Impl::flushPendingThumbnailInvalidations() {
   m_thumbnailInvalidationFlushScheduled = false;
@@ -706,27 +755,32 @@ void ThumbnailSequence::Impl::flushPendingThumbnailInvalidations() {
   for (const PageId& pageId : pending) {
     const ItemsById::iterator idIt(m_itemsById.find(pageId));
     if (idIt != m_itemsById.end()) {
-      if (m_selectionLeader == &*idIt && !m_selectionLeaderInvalidated) {
-        m_selectionLeaderInvalidated = true;
-        m_invalidatedSelectionLeaderPageId = pageId;
-        m_oldSelectionLeaderSize = idIt->composite->boundingRect().size();
-        m_oldSelectionLeaderPos = idIt->composite->pos();
-      }
+      rememberSelectionLeaderGeometry(idIt);
       invalidateThumbnailImpl(idIt);
     }
   }
 
   updateSceneItemsPos();
+  notifySelectionLeaderInvalidated();
+}
 
-  if (m_selectionLeaderInvalidated && m_selectionLeader
-      && m_selectionLeader->pageId() == m_invalidatedSelectionLeaderPageId
-      && (m_oldSelectionLeaderSize != m_selectionLeader->composite->boundingRect().size()
-          || m_oldSelectionLeaderPos != m_selectionLeader->composite->pos())) {
-    m_owner.emitNewSelectionLeader(
-        m_selectionLeader->pageInfo, m_selectionLeader->composite, REDUNDANT_SELECTION);
+void ThumbnailSequence::Impl::invalidateThumbnails(const std::set<PageId>& pages) {
+  // Relocating every item on its own would cost a pass over the strip per page,
+  // so recreate them all first and then sort once.
+  std::set<PageId> pending;
+  pending.swap(m_pendingThumbnailInvalidations);
+  pending.insert(pages.begin(), pages.end());
+  for (const PageId& pageId : pending) {
+    const ItemsById::iterator idIt(m_itemsById.find(pageId));
+    if (idIt != m_itemsById.end()) {
+      rememberSelectionLeaderGeometry(idIt);
+      recreateCompositeItem(idIt);
+    }
   }
-  m_selectionLeaderInvalidated = false;
-  m_invalidatedSelectionLeaderPageId = PageId();
+
+  orderItems();
+  updateSceneItemsPos();
+  notifySelectionLeaderInvalidated();
 }
 
 void ThumbnailSequence::Impl::invalidateAllThumbnails() {
@@ -745,6 +799,7 @@ void ThumbnailSequence::Impl::invalidateAllThumbnails() {
 
     ordIt->composite = newComposite;
     ordIt->incompleteThumbnail = newComposite->incompleteThumbnail();
+    updateOrderKey(*ordIt);
     delete oldComposite;
 
     newComposite->updateAppearence(ordIt->isSelected(), ordIt->isSelectionLeader());
@@ -978,9 +1033,12 @@ void ThumbnailSequence::Impl::insert(const PageInfo& newPage, BeforeOrAfter befo
     }
   }
 
+  PageOrderKey orderKey;
+  if (m_orderProvider) {
+    orderKey = m_orderProvider->sortKey(newPage.id(), /*incomplete=*/true);
+  }
   // If m_orderProvider is not set, ordIt won't change.
-  ordIt = itemInsertPosition(m_itemsInOrder.begin(), m_itemsInOrder.end(), newPage.id(),
-                             /*pageIncomplete=*/true, ordIt);
+  ordIt = itemInsertPosition(m_itemsInOrder.begin(), m_itemsInOrder.end(), orderKey, ordIt);
 
   double offset = 0.0;
   if (!m_items.empty()) {
@@ -998,7 +1056,8 @@ void ThumbnailSequence::Impl::insert(const PageInfo& newPage, BeforeOrAfter befo
 
   const QPointF posDelta(0.0, composite->boundingRect().height() + SPACING);
 
-  const Item item(newPage, composite.get());
+  Item item(newPage, composite.get());
+  item.orderKey = orderKey;
   const std::pair<ItemsInOrder::iterator, bool> ins(m_itemsInOrder.insert(ordIt, item));
   composite->setItem(&*ins.first);
   m_graphicsScene.addItem(composite.release());
@@ -1274,12 +1333,10 @@ void ThumbnailSequence::Impl::clear() {
   m_invalidatedSelectionLeaderPageId = PageId();
   m_selectionLeader = nullptr;
 
-  ItemsInOrder::iterator it(m_itemsInOrder.begin());
-  const ItemsInOrder::iterator end(m_itemsInOrder.end());
-  while (it != end) {
-    delete it->composite;
-    m_itemsInOrder.erase(it++);
+  for (const Item& item : m_itemsInOrder) {
+    delete item.composite;
   }
+  m_items.clear();
 
   assert(m_graphicsScene.items().empty());
 
@@ -1301,8 +1358,7 @@ void ThumbnailSequence::Impl::clearSelection() {
 ThumbnailSequence::Impl::ItemsInOrder::iterator ThumbnailSequence::Impl::itemInsertPosition(
     const ItemsInOrder::iterator begin,
     const ItemsInOrder::iterator end,
-    const PageId& pageId,
-    const bool pageIncomplete,
+    const PageOrderKey& orderKey,
     const ItemsInOrder::iterator hint,
     int* distFromHint) {
   // Note that to preserve stable ordering, this function *must* return hint,
@@ -1315,37 +1371,17 @@ ThumbnailSequence::Impl::ItemsInOrder::iterator ThumbnailSequence::Impl::itemIns
     return hint;
   }
 
-  ItemsInOrder::iterator insPos(hint);
-  int dist = 0;
-  // While the element immediately preceeding insPos is supposed to
-  // follow the page we are inserting, move insPos one element back.
-  while (insPos != begin) {
-    ItemsInOrder::iterator prev(insPos);
-    --prev;
-    const bool precedes = m_orderProvider->precedes(pageId, pageIncomplete, prev->pageId(), prev->incompleteThumbnail);
-    if (precedes) {
-      insPos = prev;
-      --dist;
-    } else {
-      break;
-    }
-  }
-
-  // While the element pointed to by insPos is supposed to precede
-  // the page we are inserting, advance insPos.
-  while (insPos != end) {
-    const bool precedes
-        = m_orderProvider->precedes(insPos->pageId(), insPos->incompleteThumbnail, pageId, pageIncomplete);
-    if (precedes) {
-      ++insPos;
-      ++dist;
-    } else {
-      break;
-    }
+  // Move left of hint past the items that are supposed to follow ours.
+  ItemsInOrder::iterator insPos(std::upper_bound(
+      begin, hint, orderKey, [](const PageOrderKey& key, const Item& item) { return key < item.orderKey; }));
+  if (insPos == hint) {
+    // Otherwise, move right of hint past the items that are supposed to precede ours.
+    insPos = std::lower_bound(hint, end, orderKey,
+                              [](const Item& item, const PageOrderKey& key) { return item.orderKey < key; });
   }
 
   if (distFromHint) {
-    *distFromHint = dist;
+    *distFromHint = static_cast<int>(insPos - hint);
   }
   return insPos;
 }  // ThumbnailSequence::Impl::itemInsertPosition
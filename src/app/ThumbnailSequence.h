@@ -117,6 +117,14 @@ class ThumbnailSequence : public QObject {
    */
   void invalidateThumbnail(const PageInfo& pageInfo);
 
+  /**
+   * \brief Updates appearance and possibly positions of several thumbnails at once.
+   *
+   * The thumbnails are reordered and laid out once for the whole set, so this
+   * is the one to use after a change was applied to a range of pages.
+   */
+  void invalidateThumbnails(const std::set<PageId>& pages);
+
   /**
    * \brief Updates appearance of all thumbnails and possibly their order.
    *
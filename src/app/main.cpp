@@ -48,6 +48,25 @@ int main(int argc, char* argv[]) {
 
   QStringList args = Application::arguments();
 
+  // --thread-placement=<policy> overrides the setting for this session.
+  // It's passed on to WorkerThreadPool the same way SCANTAILOR_BATCH_THREADS is.
+  for (auto it = args.begin(); it != args.end();) {
+    const QString prefix = QStringLiteral("--thread-placement=");
+    if (it->startsWith(prefix)) {
+      qputenv("SCANTAILOR_THREAD_PLACEMENT", it->mid(prefix.size()).toLocal8Bit());
+      it = args.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  // --isolated-decoding decodes the input images in a helper process,
+  // so that a corrupt file can only fail its own page.
+  const int isolatedDecodingArgs = args.removeAll(QStringLiteral("--isolated-decoding"));
+  if (isolatedDecodingArgs > 0) {
+    qputenv("SCANTAILOR_ISOLATED_DECODING", "1");
+  }
+
   // This information is used by QSettings.
   Application::setApplicationName(APPLICATION_NAME);
   Application::setOrganizationName(ORGANIZATION_NAME);
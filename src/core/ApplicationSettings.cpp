@@ -15,6 +15,7 @@ const int ApplicationSettings::DEFAULT_TIFF_BW_COMPRESSION = COMPRESSION_CCITTFA
 const int ApplicationSettings::DEFAULT_TIFF_COLOR_COMPRESSION = COMPRESSION_LZW;
 const bool ApplicationSettings::DEFAULT_BLACK_ON_WHITE_DETECTION = true;
 const bool ApplicationSettings::DEFAULT_BLACK_ON_WHITE_DETECTION_OUTPUT = true;
+const bool ApplicationSettings::DEFAULT_AUTO_ORIENTATION_DETECTION = false;
 const bool ApplicationSettings::DEFAULT_HIGHLIGHT_DEVIATION = true;
 const double ApplicationSettings::DEFAULT_DESKEW_DEVIATION_COEF = 1.5;
 const double ApplicationSettings::DEFAULT_DESKEW_DEVIATION_THRESHOLD = 1.0;
@@ -33,6 +34,7 @@ const bool ApplicationSettings::DEFAULT_JPEG_OUTPUT = false;
 const int ApplicationSettings::DEFAULT_JPEG_QUALITY = 90;
 const bool ApplicationSettings::DEFAULT_TEMP_CLEANUP_WARNING = true;
 const bool ApplicationSettings::DEFAULT_PDF_RECOMMENDED_NAME = false;
+const QString ApplicationSettings::DEFAULT_THREAD_PLACEMENT = "any";
 
 const QString ApplicationSettings::ROOT_KEY = "settings";
 const QString ApplicationSettings::OPENGL_STATE_KEY = "enable_opengl";
@@ -42,6 +44,7 @@ const QString ApplicationSettings::TIFF_BW_COMPRESSION_KEY = "bw_compression";
 const QString ApplicationSettings::TIFF_COLOR_COMPRESSION_KEY = "color_compression";
 const QString ApplicationSettings::BLACK_ON_WHITE_DETECTION_KEY = "black_on_white_detection";
 const QString ApplicationSettings::BLACK_ON_WHITE_DETECTION_OUTPUT_KEY = "black_on_white_detection_at_output";
+const QString ApplicationSettings::AUTO_ORIENTATION_DETECTION_KEY = "auto_orientation_detection";
 const QString ApplicationSettings::HIGHLIGHT_DEVIATION_KEY = "highlight_deviation";
 const QString ApplicationSettings::DESKEW_DEVIATION_COEF_KEY = "deskew_deviation_coef";
 const QString ApplicationSettings::DESKEW_DEVIATION_THRESHOLD_KEY = "deskew_deviation_threshold";
@@ -60,6 +63,7 @@ const QString ApplicationSettings::JPEG_OUTPUT_KEY = "jpeg_output";
 const QString ApplicationSettings::JPEG_QUALITY_KEY = "jpeg_quality";
 const QString ApplicationSettings::TEMP_CLEANUP_WARNING_KEY = "temp_cleanup_warning";
 const QString ApplicationSettings::PDF_RECOMMENDED_NAME_KEY = "pdf_recommended_name";
+const QString ApplicationSettings::THREAD_PLACEMENT_KEY = "thread_placement";
 
 QString ApplicationSettings::getKey(const QString& keyName) {
   return ApplicationSettings::ROOT_KEY + '/' + keyName;
@@ -129,6 +133,14 @@ void ApplicationSettings::setBlackOnWhiteDetectionOutputEnabled(bool enabled) {
   m_settings.setValue(getKey(BLACK_ON_WHITE_DETECTION_OUTPUT_KEY), enabled);
 }
 
+bool ApplicationSettings::isAutoOrientationDetectionEnabled() const {
+  return m_settings.value(getKey(AUTO_ORIENTATION_DETECTION_KEY), DEFAULT_AUTO_ORIENTATION_DETECTION).toBool();
+}
+
+void ApplicationSettings::setAutoOrientationDetectionEnabled(bool enabled) {
+  m_settings.setValue(getKey(AUTO_ORIENTATION_DETECTION_KEY), enabled);
+}
+
 bool ApplicationSettings::isHighlightDeviationEnabled() const {
   return m_settings.value(getKey(HIGHLIGHT_DEVIATION_KEY), DEFAULT_HIGHLIGHT_DEVIATION).toBool();
 }
@@ -275,3 +287,11 @@ bool ApplicationSettings::isPdfRecommendedNameEnabled() const {
 void ApplicationSettings::setPdfRecommendedNameEnabled(bool enabled) {
   m_settings.setValue(getKey(PDF_RECOMMENDED_NAME_KEY), enabled);
 }
+
+QString ApplicationSettings::getThreadPlacement() const {
+  return m_settings.value(getKey(THREAD_PLACEMENT_KEY), DEFAULT_THREAD_PLACEMENT).toString();
+}
+
+void ApplicationSettings::setThreadPlacement(const QString& policy) {
+  m_settings.setValue(getKey(THREAD_PLACEMENT_KEY), policy);
+}
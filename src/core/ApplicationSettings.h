@@ -56,6 +56,10 @@ class ApplicationSettings {
 
   void setBlackOnWhiteDetectionOutputEnabled(bool enabled);
 
+  bool isAutoOrientationDetectionEnabled() const;
+
+  void setAutoOrientationDetectionEnabled(bool enabled);
+
   bool isHighlightDeviationEnabled() const;
 
   void setHighlightDeviationEnabled(bool enabled);
@@ -120,6 +124,15 @@ class ApplicationSettings {
 
   void setPdfRecommendedNameEnabled(bool enabled);
 
+  /**
+   * \brief How worker threads are placed on CPUs.
+   *
+   * \see threadPlacementPolicyFromString()
+   */
+  QString getThreadPlacement() const;
+
+  void setThreadPlacement(const QString& policy);
+
  private:
   static inline QString getKey(const QString& keyName);
 
@@ -130,6 +143,7 @@ class ApplicationSettings {
   static const int DEFAULT_TIFF_COLOR_COMPRESSION;
   static const bool DEFAULT_BLACK_ON_WHITE_DETECTION;
   static const bool DEFAULT_BLACK_ON_WHITE_DETECTION_OUTPUT;
+  static const bool DEFAULT_AUTO_ORIENTATION_DETECTION;
   static const bool DEFAULT_HIGHLIGHT_DEVIATION;
   static const double DEFAULT_DESKEW_DEVIATION_COEF;
   static const double DEFAULT_DESKEW_DEVIATION_THRESHOLD;
@@ -148,6 +162,7 @@ class ApplicationSettings {
   static const int DEFAULT_JPEG_QUALITY;
   static const bool DEFAULT_TEMP_CLEANUP_WARNING;
   static const bool DEFAULT_PDF_RECOMMENDED_NAME;
+  static const QString DEFAULT_THREAD_PLACEMENT;
 
   static const QString ROOT_KEY;
   static const QString OPENGL_STATE_KEY;
@@ -157,6 +172,7 @@ class ApplicationSettings {
   static const QString TIFF_COLOR_COMPRESSION_KEY;
   static const QString BLACK_ON_WHITE_DETECTION_KEY;
   static const QString BLACK_ON_WHITE_DETECTION_OUTPUT_KEY;
+  static const QString AUTO_ORIENTATION_DETECTION_KEY;
   static const QString HIGHLIGHT_DEVIATION_KEY;
   static const QString DESKEW_DEVIATION_COEF_KEY;
   static const QString DESKEW_DEVIATION_THRESHOLD_KEY;
@@ -175,6 +191,7 @@ class ApplicationSettings {
   static const QString JPEG_QUALITY_KEY;
   static const QString TEMP_CLEANUP_WARNING_KEY;
   static const QString PDF_RECOMMENDED_NAME_KEY;
+  static const QString THREAD_PLACEMENT_KEY;
 
   QSettings m_settings;
 };
@@ -14,7 +14,11 @@
 
 class BackgroundTask : public AbstractCommand<FilterResultPtr>, public TaskStatus {
  public:
-  enum Type { INTERACTIVE, BATCH };
+  /**
+   * SPECULATIVE tasks do work ahead of the user asking for it.  They run
+   * at the lowest priority, and whatever they produce is not shown.
+   */
+  enum Type { INTERACTIVE, BATCH, SPECULATIVE };
 
   class CancelledException : public std::exception {
    public:
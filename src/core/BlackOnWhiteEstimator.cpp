@@ -4,12 +4,17 @@
 #include "BlackOnWhiteEstimator.h"
 
 #include <imageproc/Binarize.h>
+#include <imageproc/BinaryThreshold.h>
 #include <imageproc/Grayscale.h>
 #include <imageproc/Morphology.h>
 #include <imageproc/PolygonRasterizer.h>
 #include <imageproc/RasterOp.h>
+#include <imageproc/Scale.h>
 #include <imageproc/Transform.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <stdexcept>
 
 #include "DebugImages.h"
@@ -18,6 +23,32 @@
 
 using namespace imageproc;
 
+namespace {
+std::atomic<int> numEstimates(0);
+std::atomic<int> numFallbacks(0);
+
+// The most of the inner area of a page the dark pixels may take
+// for the page to be surely black on white.
+const double MAX_INNER_DARK_SHARE_BLACK_ON_WHITE = 0.45;
+// The least of the inner area and of the border area around it the dark
+// pixels must take for the page to be surely white on black.  A dark photo
+// may take much of the inner area, but rarely the borders as well.
+const double MIN_INNER_DARK_SHARE_WHITE_ON_BLACK = 0.5;
+const double MIN_BORDER_DARK_SHARE_WHITE_ON_BLACK = 0.75;
+
+double darkShare(const GrayscaleHistogram& hist, const BinaryThreshold threshold) {
+  int dark = 0;
+  int total = 0;
+  for (int level = 0; level < 256; ++level) {
+    total += hist[level];
+    if (level < threshold) {
+      dark += hist[level];
+    }
+  }
+  return total == 0 ? 0.5 : double(dark) / total;
+}
+}  // namespace
+
 bool BlackOnWhiteEstimator::isBlackOnWhiteRefining(const imageproc::GrayImage& grayImage,
                                                    const ImageTransformation& xform,
                                                    const TaskStatus& status,
@@ -71,6 +102,13 @@ bool BlackOnWhiteEstimator::isBlackOnWhite(const imageproc::GrayImage& grayImage
                                            const ImageTransformation& xform,
                                            const TaskStatus& status,
                                            DebugImages* dbg) {
+  ++numEstimates;
+  const Decision decision = decideByHistogram(grayImage, xform);
+  if (decision != UNDECIDED) {
+    return decision == BLACK_ON_WHITE;
+  }
+
+  ++numFallbacks;
   if (isBlackOnWhite(grayImage, xform.resultingPreCropArea())) {
     return true;
   } else {
@@ -79,6 +117,32 @@ bool BlackOnWhiteEstimator::isBlackOnWhite(const imageproc::GrayImage& grayImage
   }
 }
 
+bool BlackOnWhiteEstimator::isBlackOnWhite(const BinaryImage& image,
+                                           const ImageTransformation& xform,
+                                           const TaskStatus& status,
+                                           DebugImages* dbg) {
+  ++numEstimates;
+  QSize proxySize(image.size());
+  const Dpi origDpi(xform.origDpi());
+  if ((origDpi.horizontal() > 75) && (origDpi.vertical() > 75)) {
+    proxySize = QSize(std::max(1, static_cast<int>(std::lround(image.width() * 75.0 / origDpi.horizontal()))),
+                      std::max(1, static_cast<int>(std::lround(image.height() * 75.0 / origDpi.vertical()))));
+  }
+  const QTransform toProxy(QTransform::fromScale(double(proxySize.width()) / image.width(),
+                                                 double(proxySize.height()) / image.height()));
+  const Decision decision = decideByHistogram(scaleToGray(image, proxySize), xform, toProxy);
+  if (decision != UNDECIDED) {
+    return decision == BLACK_ON_WHITE;
+  }
+
+  ++numFallbacks;
+  if (isBlackOnWhite(image, xform.resultingPreCropArea())) {
+    return true;
+  } else {
+    return isBlackOnWhiteRefining(GrayImage(image.toQImage()), xform, status, dbg);
+  }
+}
+
 bool BlackOnWhiteEstimator::isBlackOnWhite(const GrayImage& img, const BinaryImage& mask) {
   if (img.isNull()) {
     throw std::invalid_argument("BlackOnWhiteEstimator: image is null.");
@@ -104,3 +168,73 @@ bool BlackOnWhiteEstimator::isBlackOnWhite(const GrayImage& img, const QPolygonF
   PolygonRasterizer::fillExcept(mask, WHITE, cropArea, Qt::WindingFill);
   return isBlackOnWhite(img, mask);
 }
+
+bool BlackOnWhiteEstimator::isBlackOnWhite(const BinaryImage& img, const QPolygonF& cropArea) {
+  if (img.isNull()) {
+    throw std::invalid_argument("BlackOnWhiteEstimator: image is null.");
+  }
+  if (cropArea.intersected(QRectF(img.rect())).isEmpty()) {
+    throw std::invalid_argument("BlackOnWhiteEstimator: the cropping area is wrong.");
+  }
+
+  BinaryImage mask(img.size(), BLACK);
+  PolygonRasterizer::fillExcept(mask, WHITE, cropArea, Qt::WindingFill);
+  BinaryImage blackInside(img);
+  rasterOp<RopAnd<RopSrc, RopDst>>(blackInside, mask);
+  return (2 * blackInside.countBlackPixels() <= mask.countBlackPixels());
+}
+
+BlackOnWhiteEstimator::Decision BlackOnWhiteEstimator::decideByHistogram(const GrayImage& grayImage,
+                                                                         const ImageTransformation& xform,
+                                                                         const QTransform& toGrayImage) {
+  ImageTransformation xform75dpi(xform);
+  xform75dpi.preScaleToDpi(Dpi(75, 75));
+  const QRect rect75dpi(xform75dpi.resultingRect().toRect());
+  if (rect75dpi.isEmpty()) {
+    return UNDECIDED;
+  }
+
+  const GrayImage gray75(transformToGray(grayImage, toGrayImage.inverted() * xform75dpi.transform(), rect75dpi,
+                                         OutsidePixels::assumeColor(Qt::white)));
+  const QPolygonF cropArea(xform75dpi.resultingPreCropArea().translated(-rect75dpi.topLeft()));
+  BinaryImage pageMask(gray75.size(), BLACK);
+  PolygonRasterizer::fillExcept(pageMask, WHITE, cropArea, Qt::WindingFill);
+
+  // The borders of a page may be dark because of the scanner background,
+  // so they only serve to confirm a white on black page.
+  const QRect pageRect(cropArea.boundingRect().toRect().intersected(gray75.rect()));
+  const QRect innerRect(pageRect.adjusted(pageRect.width() / 5, pageRect.height() / 5, -pageRect.width() / 5,
+                                          -pageRect.height() / 5));
+  if (innerRect.isEmpty()) {
+    return UNDECIDED;
+  }
+  BinaryImage innerMask(gray75.size(), WHITE);
+  innerMask.fill(innerRect, BLACK);
+  rasterOp<RopAnd<RopSrc, RopDst>>(innerMask, pageMask);
+
+  const GrayscaleHistogram pageHist(gray75, pageMask);
+  const GrayscaleHistogram innerHist(gray75, innerMask);
+  GrayscaleHistogram borderHist(pageHist);
+  for (int level = 0; level < 256; ++level) {
+    borderHist[level] -= innerHist[level];
+  }
+
+  const BinaryThreshold threshold(BinaryThreshold::otsuThreshold(pageHist));
+  const double pageDarkShare = darkShare(pageHist, threshold);
+  const double innerDarkShare = darkShare(innerHist, threshold);
+  const double borderDarkShare = darkShare(borderHist, threshold);
+
+  // The full resolution estimation says "black on white" for up to a half of dark pixels.
+  if ((innerDarkShare <= MAX_INNER_DARK_SHARE_BLACK_ON_WHITE) && (pageDarkShare <= 0.5)) {
+    return BLACK_ON_WHITE;
+  }
+  if ((innerDarkShare >= MIN_INNER_DARK_SHARE_WHITE_ON_BLACK)
+      && (borderDarkShare >= MIN_BORDER_DARK_SHARE_WHITE_ON_BLACK)) {
+    return WHITE_ON_BLACK;
+  }
+  return UNDECIDED;
+}
+
+BlackOnWhiteEstimator::Statistics BlackOnWhiteEstimator::statistics() {
+  return {numEstimates.load(), numFallbacks.load()};
+}
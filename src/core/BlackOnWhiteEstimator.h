@@ -20,11 +20,36 @@ class BinaryImage;
 
 class BlackOnWhiteEstimator {
  public:
+  struct Statistics {
+    int numEstimates;
+    int numFallbacks;
+  };
+
+  /**
+   * \brief Decides whether the page is dark text on light background.
+   *
+   * A quick look at the gray levels of a 75 DPI copy of the page settles
+   * most pages.  Only the pages it isn't sure about go through the full
+   * resolution estimation and, if that says "white on black", through
+   * isBlackOnWhiteRefining().
+   */
   static bool isBlackOnWhite(const imageproc::GrayImage& grayImage,
                              const ImageTransformation& xform,
                              const TaskStatus& status,
                              DebugImages* dbg = nullptr);
 
+  /**
+   * \brief The same for a bitonal page.
+   *
+   * The quick look works on gray levels shrunk straight from the bits.
+   * A grayscale copy of the page is only made for the pages it isn't sure
+   * about and that look white on black by their black pixel count.
+   */
+  static bool isBlackOnWhite(const imageproc::BinaryImage& image,
+                             const ImageTransformation& xform,
+                             const TaskStatus& status,
+                             DebugImages* dbg = nullptr);
+
   static bool isBlackOnWhiteRefining(const imageproc::GrayImage& grayImage,
                                      const ImageTransformation& xform,
                                      const TaskStatus& status,
@@ -33,6 +58,28 @@ class BlackOnWhiteEstimator {
   static bool isBlackOnWhite(const imageproc::GrayImage& img, const imageproc::BinaryImage& mask);
 
   static bool isBlackOnWhite(const imageproc::GrayImage& img, const QPolygonF& cropArea);
+
+  /**
+   * \brief The same for a bitonal page: whether at most half of \p cropArea is black.
+   */
+  static bool isBlackOnWhite(const imageproc::BinaryImage& img, const QPolygonF& cropArea);
+
+  /**
+   * \brief How many pages isBlackOnWhite() was asked about since the start,
+   *        and how many of them the quick look couldn't settle.
+   */
+  static Statistics statistics();
+
+ private:
+  enum Decision { BLACK_ON_WHITE, WHITE_ON_BLACK, UNDECIDED };
+
+  /**
+   * \param toGrayImage Maps the original image coordinates of \p xform to \p grayImage,
+   *        which may be a downscaled copy of the original image.
+   */
+  static Decision decideByHistogram(const imageproc::GrayImage& grayImage,
+                                    const ImageTransformation& xform,
+                                    const QTransform& toGrayImage = QTransform());
 };
 
 
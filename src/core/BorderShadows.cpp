@@ -0,0 +1,54 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include "BorderShadows.h"
+
+#include <BinaryImage.h>
+#include <Connectivity.h>
+#include <Morphology.h>
+#include <RasterOp.h>
+#include <SeedFill.h>
+
+#include <QSize>
+
+#include "DebugImages.h"
+#include "TaskStatus.h"
+
+using namespace imageproc;
+
+BinaryImage findBorderShadows(const BinaryImage& image, const TaskStatus& status, DebugImages* dbg) {
+  BinaryImage seed(openBrick(image, QSize(200, 14), BLACK));
+  if (dbg) {
+    dbg->add(seed, "horShadowsSeed");
+  }
+
+  status.throwIfCancelled();
+
+  {
+    const BinaryImage verSeed(openBrick(image, QSize(14, 300), BLACK));
+    if (dbg) {
+      dbg->add(verSeed, "verShadowsSeed");
+    }
+    status.throwIfCancelled();
+
+    rasterOp<RopOr<RopSrc, RopDst>>(seed, verSeed);
+  }
+  if (dbg) {
+    dbg->add(seed, "shadowsSeed");
+  }
+
+  status.throwIfCancelled();
+
+  BinaryImage dilated(dilateBrick(image, QSize(3, 3)));
+  if (dbg) {
+    dbg->add(dilated, "dilated");
+  }
+
+  status.throwIfCancelled();
+
+  BinaryImage shadows(seedFill(seed, dilated, CONN8));
+  if (dbg) {
+    dbg->add(shadows, "shadowsDilated");
+  }
+  return shadows;
+}
@@ -0,0 +1,33 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#ifndef SCANTAILOR_CORE_BORDERSHADOWS_H_
+#define SCANTAILOR_CORE_BORDERSHADOWS_H_
+
+class DebugImages;
+class TaskStatus;
+
+namespace imageproc {
+class BinaryImage;
+}
+
+/**
+ * \brief Finds the dark areas scanners leave around a page.
+ *
+ * Long and thick horizontal and vertical black bars are taken as the seeds
+ * of the shadows, which are then grown into the black areas connected to them.
+ * Page splitting and content box detection both use it to tell shadows from
+ * the content of a page.
+ *
+ * \param image A black and white image of about 150 DPI.  The brick sizes
+ *        used to find the seeds assume that resolution.
+ * \param status For asynchronous task cancellation, checked between the steps.
+ * \param dbg The sink for intermediate images used for debugging purposes.
+ *        This argument is optional.
+ * \return The shadows, grown by a pixel into the white areas around them.
+ */
+imageproc::BinaryImage findBorderShadows(const imageproc::BinaryImage& image,
+                                         const TaskStatus& status,
+                                         DebugImages* dbg = nullptr);
+
+#endif  // ifndef SCANTAILOR_CORE_BORDERSHADOWS_H_
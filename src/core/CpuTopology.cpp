@@ -0,0 +1,145 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include "CpuTopology.h"
+
+#include <QDir>
+#include <QFile>
+#include <QStringList>
+#include <algorithm>
+#include <map>
+#include <utility>
+
+namespace {
+QString readLine(const QString& path) {
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    return QString();
+  }
+  return QString::fromLatin1(file.readLine()).trimmed();
+}
+
+int readInt(const QString& path, const int defaultValue) {
+  bool ok = false;
+  const int value = readLine(path).toInt(&ok);
+  return ok ? value : defaultValue;
+}
+
+int readL3Domain(const QString& cpuDir) {
+  const QDir cacheDir(cpuDir + "/cache");
+  for (const QString& index : cacheDir.entryList(QStringList("index*"), QDir::Dirs)) {
+    const QString indexDir(cacheDir.filePath(index));
+    if (readInt(indexDir + "/level", 0) != 3) {
+      continue;
+    }
+    const CpuTopology::CpuSet sharedCpus(CpuTopology::parseCpuList(readLine(indexDir + "/shared_cpu_list")));
+    if (!sharedCpus.empty()) {
+      return sharedCpus.front();
+    }
+  }
+  return -1;
+}
+}  // namespace
+
+const char* const CpuTopology::DEFAULT_SYSFS_ROOT = "/sys/devices/system";
+
+CpuTopology::CpuTopology(std::vector<LogicalCpu> cpus) : m_cpus(std::move(cpus)) {}
+
+CpuTopology CpuTopology::probe(const QString& sysfsRoot) {
+  const CpuSet online(parseCpuList(readLine(sysfsRoot + "/cpu/online")));
+  if (online.empty()) {
+    return CpuTopology();
+  }
+
+  std::map<int, int> nodeOfCpu;
+  const QDir nodeRoot(sysfsRoot + "/node");
+  for (const QString& nodeName : nodeRoot.entryList(QStringList("node*"), QDir::Dirs)) {
+    bool ok = false;
+    const int node = nodeName.mid(4).toInt(&ok);
+    if (!ok) {
+      continue;
+    }
+    for (const int cpu : parseCpuList(readLine(nodeRoot.filePath(nodeName) + "/cpulist"))) {
+      nodeOfCpu[cpu] = node;
+    }
+  }
+
+  std::vector<LogicalCpu> cpus;
+  cpus.reserve(online.size());
+  for (const int id : online) {
+    const QString cpuDir(QString("%1/cpu/cpu%2").arg(sysfsRoot).arg(id));
+    LogicalCpu cpu;
+    cpu.id = id;
+    cpu.packageId = readInt(cpuDir + "/topology/physical_package_id", 0);
+    // Without core information, every logical CPU is taken to be a core of its own.
+    cpu.coreId = readInt(cpuDir + "/topology/core_id", id);
+    cpu.l3Domain = readL3Domain(cpuDir);
+    const auto node = nodeOfCpu.find(id);
+    cpu.numaNode = (node != nodeOfCpu.end()) ? node->second : -1;
+    cpus.push_back(cpu);
+  }
+  return CpuTopology(std::move(cpus));
+}
+
+CpuTopology::CpuSet CpuTopology::parseCpuList(const QString& list) {
+  CpuSet cpus;
+  for (const QString& range : list.split(',', Qt::SkipEmptyParts)) {
+    const QStringList bounds(range.trimmed().split('-'));
+    bool firstOk = false;
+    bool lastOk = false;
+    const int first = bounds.front().toInt(&firstOk);
+    const int last = (bounds.size() == 2) ? bounds.back().toInt(&lastOk) : first;
+    if (!firstOk || ((bounds.size() == 2) && !lastOk) || (bounds.size() > 2) || (first < 0) || (last < first)) {
+      return CpuSet();
+    }
+    for (int cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+
+  std::sort(cpus.begin(), cpus.end());
+  cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+  return cpus;
+}
+
+CpuTopology::CpuSet CpuTopology::allCpus() const {
+  CpuSet cpus;
+  cpus.reserve(m_cpus.size());
+  for (const LogicalCpu& cpu : m_cpus) {
+    cpus.push_back(cpu.id);
+  }
+  return cpus;
+}
+
+template <typename KeyFunc>
+std::vector<CpuTopology::CpuSet> CpuTopology::groupBy(KeyFunc key) const {
+  // m_cpus is sorted by id, so both the groups and their members
+  // come out ordered by the lowest CPU id.
+  std::vector<CpuSet> groups;
+  std::vector<decltype(key(m_cpus.front()))> keys;
+  for (const LogicalCpu& cpu : m_cpus) {
+    const auto k = key(cpu);
+    const auto it = std::find(keys.begin(), keys.end(), k);
+    if (it == keys.end()) {
+      keys.push_back(k);
+      groups.push_back(CpuSet{cpu.id});
+    } else {
+      groups[it - keys.begin()].push_back(cpu.id);
+    }
+  }
+  return groups;
+}
+
+std::vector<CpuTopology::CpuSet> CpuTopology::physicalCores() const {
+  return groupBy([](const LogicalCpu& cpu) { return std::make_pair(cpu.packageId, cpu.coreId); });
+}
+
+std::vector<CpuTopology::CpuSet> CpuTopology::l3Domains() const {
+  return groupBy([](const LogicalCpu& cpu) {
+    return (cpu.l3Domain >= 0) ? std::make_pair(0, cpu.l3Domain) : std::make_pair(1, cpu.packageId);
+  });
+}
+
+std::vector<CpuTopology::CpuSet> CpuTopology::numaNodes() const {
+  return groupBy([](const LogicalCpu& cpu) { return std::max(cpu.numaNode, 0); });
+}
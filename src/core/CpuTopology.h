@@ -0,0 +1,93 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#ifndef SCANTAILOR_CORE_CPUTOPOLOGY_H_
+#define SCANTAILOR_CORE_CPUTOPOLOGY_H_
+
+#include <QString>
+#include <vector>
+
+/**
+ * \brief The layout of logical CPUs into cores, L3 cache domains and NUMA nodes.
+ *
+ * Only Linux exposes this in a form we can read, through sysfs.  Elsewhere,
+ * or if sysfs can't be read, the topology is null.
+ */
+class CpuTopology {
+ public:
+  struct LogicalCpu {
+    int id = -1;
+    int packageId = 0;
+    int coreId = 0;
+    /** The lowest numbered CPU sharing the L3 cache with this one, or -1 if unknown. */
+    int l3Domain = -1;
+    /** -1 if unknown. */
+    int numaNode = -1;
+  };
+
+  /** A set of logical CPU ids, in ascending order. */
+  using CpuSet = std::vector<int>;
+
+  static const char* const DEFAULT_SYSFS_ROOT;
+
+  /**
+   * \brief Constructs a null topology.
+   */
+  CpuTopology() = default;
+
+  /**
+   * \brief Reads the topology of the online CPUs.
+   *
+   * \param sysfsRoot The directory containing the "cpu" and "node" directories,
+   *        normally /sys/devices/system.
+   */
+  static CpuTopology probe(const QString& sysfsRoot = QString::fromLatin1(DEFAULT_SYSFS_ROOT));
+
+  /**
+   * \brief Parses the list format used by sysfs, like "0-3,8,10-11".
+   *
+   * \return The CPU ids in ascending order, or an empty set if the list is malformed.
+   */
+  static CpuSet parseCpuList(const QString& list);
+
+  bool isNull() const { return m_cpus.empty(); }
+
+  /** Sorted by id. */
+  const std::vector<LogicalCpu>& cpus() const { return m_cpus; }
+
+  CpuSet allCpus() const;
+
+  /**
+   * \brief Logical CPUs grouped by the physical core they belong to.
+   *
+   * SMT siblings end up in the same group.  Groups are ordered
+   * by their lowest CPU id.
+   */
+  std::vector<CpuSet> physicalCores() const;
+
+  /**
+   * \brief Logical CPUs grouped by the L3 cache they share,
+   *        which on AMD processors corresponds to a CCX.
+   *
+   * CPUs with no L3 information are grouped by package.
+   */
+  std::vector<CpuSet> l3Domains() const;
+
+  /**
+   * \brief Logical CPUs grouped by NUMA node.
+   *
+   * Without NUMA information, all CPUs form a single node.
+   */
+  std::vector<CpuSet> numaNodes() const;
+
+ private:
+  explicit CpuTopology(std::vector<LogicalCpu> cpus);
+
+  template <typename KeyFunc>
+  std::vector<CpuSet> groupBy(KeyFunc key) const;
+
+  std::vector<LogicalCpu> m_cpus;
+};
+
+
+#endif  // ifndef SCANTAILOR_CORE_CPUTOPOLOGY_H_
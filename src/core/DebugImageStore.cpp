@@ -0,0 +1,379 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include "DebugImageStore.h"
+
+#include <BinaryImage.h>
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QImageWriter>
+#include <QTemporaryFile>
+#include <QVector>
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "AutoRemovingFile.h"
+
+using namespace imageproc;
+
+namespace {
+const quint32 RAW_MAGIC = 0x53544449;  // "STDI"
+
+enum RawKind : quint32 { RAW_QIMAGE, RAW_BINARY_IMAGE };
+
+struct RawHeader {
+  quint32 magic;
+  quint32 kind;
+  qint32 width;
+  qint32 height;
+  qint32 format;
+  qint32 bytesPerLine;
+  qint32 colorCount;
+};
+
+qint64 readMemoryBudget() {
+  constexpr int defaultMegabytes = 256;
+  constexpr int maximumMegabytes = 16384;
+  bool ok = false;
+  int megabytes = qEnvironmentVariableIntValue("SCANTAILOR_DEBUG_IMAGES_MB", &ok);
+  if (!ok) {
+    megabytes = defaultMegabytes;
+  }
+  return static_cast<qint64>(std::clamp(megabytes, 0, maximumMegabytes)) * 1024 * 1024;
+}
+
+bool writeBlock(QFile& file, const void* data, const qint64 size) {
+  return file.write(static_cast<const char*>(data), size) == size;
+}
+
+bool readBlock(QFile& file, void* data, const qint64 size) {
+  return file.read(static_cast<char*>(data), size) == size;
+}
+
+bool writeRaw(QFile& file, const QImage& image) {
+  const QVector<QRgb> colorTable(image.colorTable());
+  const RawHeader header{RAW_MAGIC,          RAW_QIMAGE,          image.width(),    image.height(),
+                         int(image.format()), image.bytesPerLine(), colorTable.size()};
+  return writeBlock(file, &header, sizeof(header))
+         && writeBlock(file, colorTable.constData(), colorTable.size() * qint64(sizeof(QRgb)))
+         && writeBlock(file, image.constBits(), image.sizeInBytes());
+}
+
+bool writeRaw(QFile& file, const BinaryImage& image) {
+  const int wpl = image.wordsPerLine();
+  const RawHeader header{RAW_MAGIC, RAW_BINARY_IMAGE, image.width(), image.height(), 0, wpl * 4, 0};
+  return writeBlock(file, &header, sizeof(header))
+         && writeBlock(file, image.data(), qint64(wpl) * image.height() * 4);
+}
+
+QImage readRaw(const QString& filePath) {
+  QFile file(filePath);
+  RawHeader header{};
+  if (!file.open(QIODevice::ReadOnly) || !readBlock(file, &header, sizeof(header)) || (header.magic != RAW_MAGIC)) {
+    return QImage();
+  }
+
+  if (header.kind == RAW_BINARY_IMAGE) {
+    BinaryImage image(header.width, header.height);
+    if ((image.wordsPerLine() * 4 != header.bytesPerLine)
+        || !readBlock(file, image.data(), qint64(header.bytesPerLine) * header.height)) {
+      return QImage();
+    }
+    return image.toQImage();
+  }
+
+  QVector<QRgb> colorTable(header.colorCount);
+  if (!readBlock(file, colorTable.data(), colorTable.size() * qint64(sizeof(QRgb)))) {
+    return QImage();
+  }
+  QImage image(header.width, header.height, static_cast<QImage::Format>(header.format));
+  if ((image.bytesPerLine() != header.bytesPerLine) || !readBlock(file, image.bits(), image.sizeInBytes())) {
+    return QImage();
+  }
+  if (!colorTable.isEmpty()) {
+    image.setColorTable(colorTable);
+  }
+  return image;
+}
+}  // namespace
+
+/**
+ * \brief The state shared by the store, its background thread and the images it produced.
+ *
+ * Captured images may outlive the store, so they keep this object alive.
+ */
+class DebugImageStore::Shared {
+ public:
+  explicit Shared(qint64 memoryBudget) : memoryBudget(memoryBudget) {}
+
+  void track(const std::shared_ptr<Entry>& entry);
+
+  void spill(const std::weak_ptr<Entry>& weakEntry);
+
+  void enqueue(std::function<void()> job);
+
+  const qint64 memoryBudget;
+
+  // Everything below, as well as the state of every entry, is protected by this mutex.
+  std::mutex mutex;
+  std::condition_variable jobsAvailable;
+  std::condition_variable idle;
+  std::deque<std::function<void()>> jobs;
+  bool busy = false;
+  bool stopping = false;
+
+  // Entries in the order of capturing.  Spilling starts from the oldest ones.
+  std::deque<std::weak_ptr<Entry>> entries;
+  int numLiveEntries = 0;
+  qint64 bytesInMemory = 0;
+  qint64 bytesQueuedForSpill = 0;
+  int numSpilled = 0;
+};
+
+
+class DebugImageStore::Entry : public DebugImageHandle {
+ public:
+  enum State { IN_MEMORY, SPILL_QUEUED, SPILLED, SPILL_FAILED };
+
+  Entry(std::shared_ptr<Shared> shared, const QImage& image)
+      : shared(std::move(shared)), image(image), isBinary(false), bytes(image.sizeInBytes()) {}
+
+  Entry(std::shared_ptr<Shared> shared, const BinaryImage& image)
+      : shared(std::move(shared)),
+        binaryImage(image),
+        isBinary(true),
+        bytes(qint64(image.wordsPerLine()) * image.height() * 4) {}
+
+  ~Entry() override;
+
+  QImage load() const override;
+
+  const std::shared_ptr<Shared> shared;
+  QImage image;
+  BinaryImage binaryImage;
+  const bool isBinary;
+  const qint64 bytes;
+  State state = IN_MEMORY;
+  AutoRemovingFile spillFile;
+};
+
+
+DebugImageStore::Entry::~Entry() {
+  std::lock_guard<std::mutex> lock(shared->mutex);
+  --shared->numLiveEntries;
+  if (state == SPILLED) {
+    --shared->numSpilled;
+  } else {
+    shared->bytesInMemory -= bytes;
+    if (state == SPILL_QUEUED) {
+      shared->bytesQueuedForSpill -= bytes;
+    }
+  }
+}
+
+QImage DebugImageStore::Entry::load() const {
+  BinaryImage binaryCopy;
+  QString spillFilePath;
+  {
+    std::lock_guard<std::mutex> lock(shared->mutex);
+    if (state == SPILLED) {
+      spillFilePath = spillFile.get();
+    } else if (isBinary) {
+      binaryCopy = binaryImage;
+    } else {
+      return image;
+    }
+  }
+
+  if (!spillFilePath.isEmpty()) {
+    return readRaw(spillFilePath);
+  }
+  return binaryCopy.toQImage();
+}
+
+void DebugImageStore::Shared::track(const std::shared_ptr<Entry>& entry) {
+  // The last reference to an entry must not be dropped under the mutex,
+  // as the destructor locks it.
+  std::vector<std::shared_ptr<Entry>> keepAlive;
+  bool spillQueued = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++numLiveEntries;
+    bytesInMemory += entry->bytes;
+    if (int(entries.size()) > 2 * numLiveEntries + 16) {
+      entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                   [](const std::weak_ptr<Entry>& weakEntry) { return weakEntry.expired(); }),
+                    entries.end());
+    }
+    entries.push_back(entry);
+
+    while ((bytesInMemory - bytesQueuedForSpill > memoryBudget) && !entries.empty()) {
+      std::shared_ptr<Entry> oldest(entries.front().lock());
+      entries.pop_front();
+      if (!oldest) {
+        continue;
+      }
+      keepAlive.push_back(oldest);
+      if (oldest->state != Entry::IN_MEMORY) {
+        continue;
+      }
+
+      oldest->state = Entry::SPILL_QUEUED;
+      bytesQueuedForSpill += oldest->bytes;
+      const std::weak_ptr<Entry> weakEntry(oldest);
+      jobs.push_back([this, weakEntry]() { spill(weakEntry); });
+      spillQueued = true;
+    }
+  }
+
+  if (spillQueued) {
+    jobsAvailable.notify_one();
+  }
+}
+
+void DebugImageStore::Shared::spill(const std::weak_ptr<Entry>& weakEntry) {
+  const std::shared_ptr<Entry> entry(weakEntry.lock());
+  if (!entry) {
+    return;
+  }
+
+  QImage image;
+  BinaryImage binaryImage;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if ((entry->state != Entry::SPILL_QUEUED) || stopping) {
+      return;
+    }
+    image = entry->image;
+    binaryImage = entry->binaryImage;
+  }
+
+  QTemporaryFile file(QDir::tempPath() + "/scantailor-dbg-XXXXXX.raw");
+  bool written = false;
+  if (file.open()) {
+    file.setAutoRemove(false);
+    written = entry->isBinary ? writeRaw(file, binaryImage) : writeRaw(file, image);
+    file.close();
+    if (!written) {
+      file.remove();
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  bytesQueuedForSpill -= entry->bytes;
+  if (!written) {
+    qWarning() << "DebugImageStore: failed to spill a debug image to disk";
+    entry->state = Entry::SPILL_FAILED;
+    return;
+  }
+  entry->spillFile.reset(file.fileName());
+  entry->image = QImage();
+  entry->binaryImage = BinaryImage();
+  entry->state = Entry::SPILLED;
+  bytesInMemory -= entry->bytes;
+  ++numSpilled;
+}
+
+void DebugImageStore::Shared::enqueue(std::function<void()> job) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    jobs.push_back(std::move(job));
+  }
+  jobsAvailable.notify_one();
+}
+
+DebugImageStore& DebugImageStore::instance() {
+  static DebugImageStore store(readMemoryBudget());
+  return store;
+}
+
+DebugImageStore::DebugImageStore(const qint64 memoryBudget)
+    : m_shared(std::make_shared<Shared>(memoryBudget)), m_worker([this]() { workerLoop(); }) {}
+
+DebugImageStore::~DebugImageStore() {
+  {
+    std::lock_guard<std::mutex> lock(m_shared->mutex);
+    m_shared->stopping = true;
+  }
+  m_shared->jobsAvailable.notify_one();
+  m_worker.join();
+}
+
+void DebugImageStore::workerLoop() {
+  Shared& shared = *m_shared;
+  std::unique_lock<std::mutex> lock(shared.mutex);
+  while (true) {
+    shared.jobsAvailable.wait(lock, [&shared]() { return shared.stopping || !shared.jobs.empty(); });
+    if (shared.jobs.empty()) {
+      break;
+    }
+
+    std::function<void()> job(std::move(shared.jobs.front()));
+    shared.jobs.pop_front();
+    shared.busy = true;
+    lock.unlock();
+
+    job();
+    // Captured images must be released outside of the mutex.
+    job = nullptr;
+
+    lock.lock();
+    shared.busy = false;
+    if (shared.jobs.empty()) {
+      shared.idle.notify_all();
+    }
+  }
+}
+
+std::shared_ptr<const DebugImageHandle> DebugImageStore::add(const QImage& image) {
+  const auto entry = std::make_shared<Entry>(m_shared, image);
+  m_shared->track(entry);
+  return entry;
+}
+
+std::shared_ptr<const DebugImageHandle> DebugImageStore::add(const BinaryImage& image) {
+  const auto entry = std::make_shared<Entry>(m_shared, image);
+  m_shared->track(entry);
+  return entry;
+}
+
+void DebugImageStore::exportPng(const std::shared_ptr<const DebugImageHandle>& image, const QString& filePath) {
+  if (!image) {
+    return;
+  }
+  m_shared->enqueue([image, filePath]() {
+    QImageWriter writer(filePath, "png");
+    writer.setCompression(2);  // Trade space for speed.
+    if (!writer.write(image->load())) {
+      qWarning() << "DebugImageStore: failed to write" << filePath;
+    }
+  });
+}
+
+void DebugImageStore::flush() {
+  std::unique_lock<std::mutex> lock(m_shared->mutex);
+  m_shared->idle.wait(lock, [this]() { return m_shared->jobs.empty() && !m_shared->busy; });
+}
+
+qint64 DebugImageStore::memoryBudget() const {
+  return m_shared->memoryBudget;
+}
+
+qint64 DebugImageStore::bytesInMemory() const {
+  std::lock_guard<std::mutex> lock(m_shared->mutex);
+  return m_shared->bytesInMemory;
+}
+
+int DebugImageStore::numSpilledImages() const {
+  std::lock_guard<std::mutex> lock(m_shared->mutex);
+  return m_shared->numSpilled;
+}
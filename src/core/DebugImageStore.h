@@ -0,0 +1,84 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#ifndef SCANTAILOR_CORE_DEBUGIMAGESTORE_H_
+#define SCANTAILOR_CORE_DEBUGIMAGESTORE_H_
+
+#include <QString>
+#include <QtGlobal>
+#include <memory>
+#include <thread>
+
+#include "DebugImageHandle.h"
+#include "NonCopyable.h"
+
+class QImage;
+
+namespace imageproc {
+class BinaryImage;
+}
+
+/**
+ * \brief Keeps captured debug images in memory up to a byte budget.
+ *
+ * Capturing an image only takes a reference to its (implicitly shared) data.
+ * Once the images held in memory exceed the budget, the oldest ones are
+ * written to temporary files in a raw format by a background thread and
+ * released.  Nothing is encoded until an image is actually requested.
+ */
+class DebugImageStore {
+  DECLARE_NON_COPYABLE(DebugImageStore)
+
+ public:
+  /**
+   * \brief The store shared by all the filters.
+   *
+   * The budget is taken from the SCANTAILOR_DEBUG_IMAGES_MB environment
+   * variable, if set.
+   */
+  static DebugImageStore& instance();
+
+  explicit DebugImageStore(qint64 memoryBudget);
+
+  /**
+   * \brief Finishes pending PNG exports, then stops the background thread.
+   */
+  ~DebugImageStore();
+
+  std::shared_ptr<const DebugImageHandle> add(const QImage& image);
+
+  std::shared_ptr<const DebugImageHandle> add(const imageproc::BinaryImage& image);
+
+  /**
+   * \brief Writes the image to a PNG file in the background thread.
+   */
+  void exportPng(const std::shared_ptr<const DebugImageHandle>& image, const QString& filePath);
+
+  /**
+   * \brief Blocks until the background thread has nothing left to do.
+   */
+  void flush();
+
+  qint64 memoryBudget() const;
+
+  /**
+   * \brief The total size of the captured images that have not been spilled to disk yet.
+   */
+  qint64 bytesInMemory() const;
+
+  /**
+   * \brief The number of captured images that currently live on disk.
+   */
+  int numSpilledImages() const;
+
+ private:
+  class Entry;
+  class Shared;
+
+  void workerLoop();
+
+  std::shared_ptr<Shared> m_shared;
+  std::thread m_worker;
+};
+
+#endif  // ifndef SCANTAILOR_CORE_DEBUGIMAGESTORE_H_
@@ -31,24 +31,24 @@ class DebugImageView::ImageLoadResult : public AbstractCommand<void> {
 
 class DebugImageView::ImageLoader : public AbstractCommand<BackgroundExecutor::TaskResultPtr> {
  public:
-  ImageLoader(DebugImageView* owner, const QString& filePath) : m_owner(owner), m_filePath(filePath) {}
+  ImageLoader(DebugImageView* owner, std::shared_ptr<const DebugImageHandle> image)
+      : m_owner(owner), m_image(std::move(image)) {}
 
   BackgroundExecutor::TaskResultPtr operator()() override {
-    QImage image(m_filePath);
-    return std::make_shared<ImageLoadResult>(m_owner, image);
+    return std::make_shared<ImageLoadResult>(m_owner, m_image->load());
   }
 
  private:
   QPointer<DebugImageView> m_owner;
-  QString m_filePath;
+  std::shared_ptr<const DebugImageHandle> m_image;
 };
 
 
-DebugImageView::DebugImageView(AutoRemovingFile file,
+DebugImageView::DebugImageView(std::shared_ptr<const DebugImageHandle> image,
                                const std::function<QWidget*(const QImage&)>& imageViewFactory,
                                QWidget* parent)
     : QStackedWidget(parent),
-      m_file(file),
+      m_image(std::move(image)),
       m_imageViewFactory(imageViewFactory),
       m_placeholderWidget(new ProcessingIndicationWidget(this)),
       m_isLive(false) {
@@ -57,7 +57,7 @@ DebugImageView::DebugImageView(AutoRemovingFile file,
 
 void DebugImageView::setLive(const bool live) {
   if (live && !m_isLive) {
-    ImageViewBase::backgroundExecutor().enqueueTask(std::make_shared<ImageLoader>(this, m_file.get()));
+    ImageViewBase::backgroundExecutor().enqueueTask(std::make_shared<ImageLoader>(this, m_image));
   } else if (!live && m_isLive) {
     if (QWidget* wgt = currentWidget()) {
       if (wgt != m_placeholderWidget) {
@@ -8,8 +8,9 @@
 #include <QWidget>
 #include <boost/intrusive/list.hpp>
 #include <functional>
+#include <memory>
 
-#include "AutoRemovingFile.h"
+#include "DebugImageHandle.h"
 
 class QImage;
 
@@ -17,7 +18,7 @@ class DebugImageView
     : public QStackedWidget,
       public boost::intrusive::list_base_hook<boost::intrusive::link_mode<boost::intrusive::auto_unlink>> {
  public:
-  explicit DebugImageView(AutoRemovingFile file,
+  explicit DebugImageView(std::shared_ptr<const DebugImageHandle> image,
                           const std::function<QWidget*(const QImage&)>& imageViewFactory
                           = std::function<QWidget*(const QImage&)>(),
                           QWidget* parent = nullptr);
@@ -34,7 +35,7 @@ class DebugImageView
 
   void imageLoaded(const QImage& image);
 
-  AutoRemovingFile m_file;
+  std::shared_ptr<const DebugImageHandle> m_image;
   std::function<QWidget*(const QImage&)> m_imageViewFactory;
   QWidget* m_placeholderWidget;
   bool m_isLive;
@@ -5,51 +5,96 @@
 
 #include <BinaryImage.h>
 
+#include <QDebug>
 #include <QDir>
+#include <QFileInfo>
 #include <QImage>
-#include <QImageWriter>
-#include <QTemporaryFile>
+#include <QRegularExpression>
 
-void DebugImagesImpl::add(const QImage& image,
-                          const QString& label,
-                          const std::function<QWidget*(const QImage&)>& imageViewFactory) {
-  QTemporaryFile file(QDir::tempPath() + "/scantailor-dbg-XXXXXX.png");
-  if (!file.open()) {
-    return;
+#include "DebugImageStore.h"
+#include "PageId.h"
+
+namespace {
+QString sanitizedFileNamePart(QString str) {
+  static const QRegularExpression unsafeChars("[^A-Za-z0-9_.-]+");
+  return str.replace(unsafeChars, "_");
+}
+}  // namespace
+
+DebugImagesImpl::DebugImagesImpl() : DebugImagesImpl(true, QString()) {}
+
+DebugImagesImpl::DebugImagesImpl(const bool keepForDisplay, const QString& dumpPrefix)
+    : m_keepForDisplay(keepForDisplay), m_dumpPrefix(dumpPrefix), m_numDumped(0) {}
+
+std::unique_ptr<DebugImagesImpl> DebugImagesImpl::create(const bool debug,
+                                                         const QString& stage,
+                                                         const PageId& pageId) {
+  const QString dumpDir = qEnvironmentVariable("SCANTAILOR_DEBUG_DUMP_DIR");
+  if (dumpDir.isEmpty()) {
+    if (!debug) {
+      return nullptr;
+    }
+    return std::make_unique<DebugImagesImpl>();
   }
 
-  AutoRemovingFile aremFile(file.fileName());
-  file.setAutoRemove(false);
+  if (!QDir().mkpath(dumpDir)) {
+    qWarning() << "DebugImagesImpl: can't create" << dumpDir;
+    return debug ? std::make_unique<DebugImagesImpl>() : nullptr;
+  }
 
-  QImageWriter writer(&file, "png");
-  writer.setCompression(2);  // Trade space for speed.
-  if (!writer.write(image)) {
-    return;
+  QString prefix = QFileInfo(pageId.imageId().filePath()).completeBaseName();
+  if (pageId.imageId().isMultiPageFile()) {
+    prefix += QString("_p%1").arg(pageId.imageId().page());
   }
+  prefix += '_' + pageId.subPageAsString() + '_' + stage;
+  prefix = QDir(dumpDir).filePath(sanitizedFileNamePart(prefix));
 
-  m_sequence.push_back(std::make_shared<Item>(aremFile, label, imageViewFactory));
+  return std::unique_ptr<DebugImagesImpl>(new DebugImagesImpl(debug, prefix));
+}
+
+void DebugImagesImpl::add(const QImage& image,
+                          const QString& label,
+                          const std::function<QWidget*(const QImage&)>& imageViewFactory) {
+  addHandle(DebugImageStore::instance().add(image), label, imageViewFactory);
 }
 
 void DebugImagesImpl::add(const imageproc::BinaryImage& image,
                           const QString& label,
                           const std::function<QWidget*(const QImage&)>& imageViewFactory) {
-  add(image.toQImage(), label, imageViewFactory);
+  addHandle(DebugImageStore::instance().add(image), label, imageViewFactory);
+}
+
+void DebugImagesImpl::addHandle(std::shared_ptr<const DebugImageHandle> image,
+                                const QString& label,
+                                const std::function<QWidget*(const QImage&)>& imageViewFactory) {
+  if (!m_dumpPrefix.isEmpty()) {
+    const QString filePath = QString("%1_%2_%3.png")
+                                 .arg(m_dumpPrefix)
+                                 .arg(++m_numDumped, 2, 10, QChar('0'))
+                                 .arg(sanitizedFileNamePart(label));
+    DebugImageStore::instance().exportPng(image, filePath);
+  }
+  if (m_keepForDisplay) {
+    m_sequence.emplace_back(std::move(image), label, imageViewFactory);
+  }
 }
 
-AutoRemovingFile DebugImagesImpl::retrieveNext(QString* label,
-                                               std::function<QWidget*(const QImage&)>* imageViewFactory) {
+std::shared_ptr<const DebugImageHandle> DebugImagesImpl::retrieveNext(
+    QString* label,
+    std::function<QWidget*(const QImage&)>* imageViewFactory) {
   if (m_sequence.empty()) {
-    return AutoRemovingFile();
+    return nullptr;
   }
 
-  AutoRemovingFile file(m_sequence.front()->file);
+  Item& item = m_sequence.front();
+  std::shared_ptr<const DebugImageHandle> image(std::move(item.image));
   if (label) {
-    *label = m_sequence.front()->label;
+    *label = item.label;
   }
   if (imageViewFactory) {
-    *imageViewFactory = m_sequence.front()->imageViewFactory;
+    *imageViewFactory = item.imageViewFactory;
   }
 
   m_sequence.pop_front();
-  return file;
+  return image;
 }
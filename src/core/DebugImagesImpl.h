@@ -11,13 +11,28 @@
 #include <functional>
 #include <memory>
 
-#include "AutoRemovingFile.h"
+class PageId;
 
 /**
  * \brief A sequence of image + label pairs.
+ *
+ * Images are kept by DebugImageStore and are only encoded when viewed
+ * or dumped.
  */
 class DebugImagesImpl : public DebugImages {
  public:
+  DebugImagesImpl();
+
+  /**
+   * \brief Creates a sequence for a filter task.
+   *
+   * Returns null, unless \p debug is set or the SCANTAILOR_DEBUG_DUMP_DIR
+   * environment variable names a directory to dump the images of every
+   * processed page into as PNG files.  In the latter case, the images
+   * are only kept for display if \p debug is set.
+   */
+  static std::unique_ptr<DebugImagesImpl> create(bool debug, const QString& stage, const PageId& pageId);
+
   void add(const QImage& image,
            const QString& label,
            const std::function<QWidget*(const QImage&)>& imageViewFactory
@@ -35,24 +50,34 @@ class DebugImagesImpl : public DebugImages {
    *
    * The label and viewer widget factory (that may not be bound)
    * are returned by taking pointers to them as arguments.
-   * Returns a null AutoRemovingFile if image sequence is empty.
+   * Returns null if image sequence is empty.
    */
-  AutoRemovingFile retrieveNext(QString* label = nullptr,
-                                std::function<QWidget*(const QImage&)>* imageViewFactory = nullptr) override;
+  std::shared_ptr<const DebugImageHandle> retrieveNext(
+      QString* label = nullptr,
+      std::function<QWidget*(const QImage&)>* imageViewFactory = nullptr) override;
 
  private:
   struct Item {
-    AutoRemovingFile file;
+    std::shared_ptr<const DebugImageHandle> image;
     QString label;
     std::function<QWidget*(const QImage&)> imageViewFactory;
 
-    Item(AutoRemovingFile f, const QString& l, const std::function<QWidget*(const QImage&)>& imf)
-        : file(f), label(l), imageViewFactory(imf) {}
-
-    virtual ~Item() = default;
+    Item(std::shared_ptr<const DebugImageHandle> i,
+         const QString& l,
+         const std::function<QWidget*(const QImage&)>& imf)
+        : image(std::move(i)), label(l), imageViewFactory(imf) {}
   };
 
-  std::deque<std::shared_ptr<Item>> m_sequence;
+  DebugImagesImpl(bool keepForDisplay, const QString& dumpPrefix);
+
+  void addHandle(std::shared_ptr<const DebugImageHandle> image,
+                 const QString& label,
+                 const std::function<QWidget*(const QImage&)>& imageViewFactory);
+
+  std::deque<Item> m_sequence;
+  bool m_keepForDisplay;
+  QString m_dumpPrefix;
+  int m_numDumped;
 };
 
 
@@ -20,10 +20,15 @@
 #include <Transform.h>
 
 #include <QDebug>
+#include <algorithm>
+#include <atomic>
 #include <boost/lambda/bind.hpp>
 #include <boost/lambda/control_structures.hpp>
 #include <boost/lambda/lambda.hpp>
+#include <thread>
+#include <vector>
 
+#include "BatchProcessingContext.h"
 #include "DebugImages.h"
 #include "ImageTransformation.h"
 #include "TaskStatus.h"
@@ -39,6 +44,40 @@ static double maskCoverage(const BinaryImage& mask) {
   return black / static_cast<double>(mask.width() * mask.height());
 }
 
+/**
+ * Builds a mask of \p reducedSize with black pixels where the background
+ * is to be sampled, from the area to consider and the optional user mask.
+ */
+static BinaryImage buildConsiderationMask(const QSize& inputSize,
+                                          const QSize& reducedSize,
+                                          const QPolygonF& areaToConsider,
+                                          const BinaryImage* userMask,
+                                          const double minMaskCoverage) {
+  BinaryImage mask(reducedSize, BLACK);
+
+  if (!areaToConsider.isEmpty()) {
+    QTransform xform;
+    xform.scale((double) reducedSize.width() / inputSize.width(), (double) reducedSize.height() / inputSize.height());
+    PolygonRasterizer::fillExcept(mask, WHITE, xform.map(areaToConsider), Qt::WindingFill);
+  }
+
+  if (userMask && (userMask->size() == inputSize) && !userMask->isNull()) {
+    // Downscale user mask to reducedSize and AND with existing mask.
+    GrayImage userMaskGray(userMask->toQImage());
+    GrayImage maskGray(scaleToGray(userMaskGray, reducedSize));
+    BinaryImage downscaledUserMask(maskGray, BinaryThreshold(1));
+    rasterOp<RopAnd<RopSrc, RopDst>>(mask, downscaledUserMask);
+    if (minMaskCoverage > 0.0) {
+      const double coverage = maskCoverage(mask);
+      if (coverage < minMaskCoverage) {
+        // Not enough paper-like pixels; fall back to original mask.
+        mask.fill(WHITE);
+      }
+    }
+  }
+  return mask;
+}
+
 struct AbsoluteDifference {
   static uint8_t transform(uint8_t src, uint8_t dst) { return static_cast<uint8_t>(std::abs(int(src) - int(dst))); }
 };
@@ -174,28 +213,7 @@ imageproc::PolynomialSurface estimateBackground(const GrayImage& input,
   const uint8_t* const bgData = background.data();
   const int bgStride = background.stride();
 
-  BinaryImage mask(background.size(), BLACK);
-
-  if (!areaToConsider.isEmpty()) {
-    QTransform xform;
-    xform.scale((double) reducedSize.width() / input.width(), (double) reducedSize.height() / input.height());
-    PolygonRasterizer::fillExcept(mask, WHITE, xform.map(areaToConsider), Qt::WindingFill);
-  }
-
-  if (userMask && (userMask->size() == input.size()) && !userMask->isNull()) {
-    // Downscale user mask to reducedSize and AND with existing mask.
-    GrayImage userMaskGray(userMask->toQImage());
-    GrayImage maskGray(scaleToGray(userMaskGray, reducedSize));
-    BinaryImage downscaledUserMask(maskGray, BinaryThreshold(1));
-    rasterOp<RopAnd<RopSrc, RopDst>>(mask, downscaledUserMask);
-    if (minMaskCoverage > 0.0) {
-      const double coverage = maskCoverage(mask);
-      if (coverage < minMaskCoverage) {
-        // Not enough paper-like pixels; fall back to original mask.
-        mask.fill(WHITE);
-      }
-    }
-  }
+  BinaryImage mask(buildConsiderationMask(input.size(), reducedSize, areaToConsider, userMask, minMaskCoverage));
 
   if (dbg) {
     dbg->add(mask, "areaToConsider");
@@ -315,3 +333,250 @@ imageproc::PolynomialSurface estimateBackground(const GrayImage& input,
   status.throwIfCancelled();
   return PolynomialSurface(8, 5, background, mask);
 }  // estimateBackground
+
+namespace {
+// The grid of estimateBackgroundTiled() has this many tiles along the longer side of a page.
+const int TILES_ALONG_LONGER_SIDE = 32;
+// Tiles with a smaller fraction of considered pixels don't produce a sample.
+const double MIN_TILE_COVERAGE = 0.25;
+// The surface degrees.  Unlike the polynomial method, the tiled one doesn't favor any orientation.
+const int TILED_SURFACE_DEGREE = 6;
+const int IRLS_ITERATIONS = 10;
+// Tukey's biweight tuning constant and the lowest residual scale in gray levels.
+const double TUKEY_C = 4.685;
+const double MIN_RESIDUAL_SCALE = 2.0;
+// Text, pictures and dark surroundings are all darker than the paper, so samples
+// lighter than the surface are given this many times wider a cutoff.
+const double LIGHTER_CUTOFF_FACTOR = 3.0;
+
+struct TileSample {
+  QPointF center;
+  double value = 0.0;
+  double coverage = 0.0;
+};
+
+/**
+ * The mean of the considered pixels of \p tile between the 50th and the 90th
+ * percentile.  The lower half belongs to text, and the upper tail to noise.
+ */
+TileSample measureTile(const GrayImage& input,
+                       const QRect& tile,
+                       const BinaryImage& mask,
+                       const std::vector<int>& maskColumns,
+                       const std::vector<int>& maskRows) {
+  int histogram[256] = {};
+  int considered = 0;
+
+  const uint8_t* inputLine = input.data() + tile.top() * input.stride();
+  const uint32_t* const maskData = mask.data();
+  const int maskStride = mask.wordsPerLine();
+  const uint32_t msb = uint32_t(1) << 31;
+  for (int y = tile.top(); y <= tile.bottom(); ++y, inputLine += input.stride()) {
+    const uint32_t* maskLine = maskData + maskRows[y] * maskStride;
+    for (int x = tile.left(); x <= tile.right(); ++x) {
+      const int mx = maskColumns[x];
+      if (maskLine[mx >> 5] & (msb >> (mx & 31))) {
+        ++histogram[inputLine[x]];
+        ++considered;
+      }
+    }
+  }
+
+  TileSample sample;
+  sample.center = QRectF(tile).center();
+  const int area = tile.width() * tile.height();
+  if (considered == 0 || considered < MIN_TILE_COVERAGE * area) {
+    return sample;
+  }
+
+  const int from = considered / 2;
+  const int to = std::max(from + 1, considered * 9 / 10);
+  int64_t sum = 0;
+  int rank = 0;
+  for (int level = 0; level < 256 && rank < to; ++level) {
+    const int count = std::min(rank + histogram[level], to) - std::max(rank, from);
+    if (count > 0) {
+      sum += int64_t(count) * level;
+    }
+    rank += histogram[level];
+  }
+
+  sample.value = static_cast<double>(sum) / (to - from);
+  sample.coverage = static_cast<double>(considered) / area;
+  return sample;
+}
+
+/**
+ * Tile rows are independent of each other, so they are spread over threads,
+ * leaving room for the other pages processed in parallel.
+ */
+int numTileThreads(const int numTileRows) {
+  const int hardware = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  const int perTask = hardware / std::max(1, batch_processing::activeTaskCount());
+  return std::clamp(perTask, 1, std::max(1, numTileRows));
+}
+
+std::vector<TileSample> measureTiles(const GrayImage& input,
+                                     const BinaryImage& mask,
+                                     const int tileSize,
+                                     const TaskStatus& status) {
+  const int width = input.width();
+  const int height = input.height();
+  const int tileCols = (width + tileSize - 1) / tileSize;
+  const int tileRows = (height + tileSize - 1) / tileSize;
+
+  std::vector<int> maskColumns(static_cast<size_t>(width));
+  for (int x = 0; x < width; ++x) {
+    maskColumns[x] = static_cast<int>(int64_t(x) * mask.width() / width);
+  }
+  std::vector<int> maskRows(static_cast<size_t>(height));
+  for (int y = 0; y < height; ++y) {
+    maskRows[y] = static_cast<int>(int64_t(y) * mask.height() / height);
+  }
+
+  std::vector<TileSample> tiles(static_cast<size_t>(tileCols * tileRows));
+  std::atomic<int> nextRow(0);
+  const auto worker = [&]() {
+    for (int row = nextRow++; row < tileRows && !status.isCancelled(); row = nextRow++) {
+      for (int col = 0; col < tileCols; ++col) {
+        const QRect tile(QRect(col * tileSize, row * tileSize, tileSize, tileSize) & input.rect());
+        tiles[row * tileCols + col] = measureTile(input, tile, mask, maskColumns, maskRows);
+      }
+    }
+  };
+
+  const int numThreads = numTileThreads(tileRows);
+  std::vector<std::thread> threads;
+  for (int i = 1; i < numThreads; ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  return tiles;
+}
+
+double median(std::vector<double>& values) {
+  const auto middle = values.begin() + values.size() / 2;
+  std::nth_element(values.begin(), middle, values.end());
+  return *middle;
+}
+
+/**
+ * Fits a surface to the tile samples with iteratively reweighted least squares,
+ * using Tukey's biweight on the residuals scaled by their median absolute deviation.
+ * A picture covering a third of the page contaminates the first fits too much
+ * for a symmetric cutoff to ever reject it, hence LIGHTER_CUTOFF_FACTOR.
+ */
+PolynomialSurface fitTiles(const std::vector<TileSample>& tiles, const QSize& size, const TaskStatus& status) {
+  std::vector<PolynomialSurface::Sample> samples;
+  std::vector<double> coverages;
+  for (const TileSample& tile : tiles) {
+    if (tile.coverage > 0.0) {
+      samples.push_back({tile.center, tile.value, tile.coverage});
+      coverages.push_back(tile.coverage);
+    }
+  }
+
+  // A low degree start keeps the surface from bending towards pictures
+  // before their tiles are recognized as outliers.
+  PolynomialSurface surface(2, 2, size, samples);
+  if (samples.empty()) {
+    return surface;
+  }
+
+  std::vector<double> residuals(samples.size());
+  std::vector<double> absResiduals(samples.size());
+  for (int iteration = 0; iteration < IRLS_ITERATIONS; ++iteration) {
+    status.throwIfCancelled();
+
+    for (size_t i = 0; i < samples.size(); ++i) {
+      residuals[i] = samples[i].value - surface.valueAt(samples[i].pos, size);
+      absResiduals[i] = std::abs(residuals[i]);
+    }
+    const double scale = std::max(1.4826 * median(absResiduals), MIN_RESIDUAL_SCALE);
+    const double cutoff = TUKEY_C * scale;
+
+    for (size_t i = 0; i < samples.size(); ++i) {
+      const double u = residuals[i] / (residuals[i] > 0.0 ? cutoff * LIGHTER_CUTOFF_FACTOR : cutoff);
+      const double biweight = (std::abs(u) < 1.0) ? (1.0 - u * u) * (1.0 - u * u) : 0.0;
+      samples[i].weight = coverages[i] * biweight;
+    }
+
+    surface = PolynomialSurface(TILED_SURFACE_DEGREE, TILED_SURFACE_DEGREE, size, samples);
+  }
+  return surface;
+}
+
+GrayImage visualizeTiles(const std::vector<TileSample>& tiles, const QSize& gridSize, const bool weights) {
+  GrayImage image(gridSize);
+  uint8_t* line = image.data();
+  for (int row = 0; row < gridSize.height(); ++row, line += image.stride()) {
+    for (int col = 0; col < gridSize.width(); ++col) {
+      const TileSample& tile = tiles[row * gridSize.width() + col];
+      const double value = weights ? tile.coverage * 255.0 : tile.value;
+      line[col] = static_cast<uint8_t>(qBound(0, static_cast<int>(value + 0.5), 255));
+    }
+  }
+  return image;
+}
+}  // namespace
+
+imageproc::PolynomialSurface estimateBackgroundTiled(const GrayImage& input,
+                                                     const QPolygonF& areaToConsider,
+                                                     const TaskStatus& status,
+                                                     DebugImages* dbg,
+                                                     const BinaryImage* userMask,
+                                                     double minMaskCoverage) {
+  if (input.isNull()) {
+    return PolynomialSurface(0, 0, input);
+  }
+
+  QSize reducedSize(input.size());
+  reducedSize.scale(300, 300, Qt::KeepAspectRatio);
+  BinaryImage mask(buildConsiderationMask(input.size(), reducedSize, areaToConsider, userMask, minMaskCoverage));
+  if (dbg) {
+    dbg->add(mask, "areaToConsider");
+  }
+
+  status.throwIfCancelled();
+
+  const int longerSide = std::max(input.width(), input.height());
+  const int tileSize = std::max(1, (longerSide + TILES_ALONG_LONGER_SIDE - 1) / TILES_ALONG_LONGER_SIDE);
+  const QSize gridSize((input.width() + tileSize - 1) / tileSize, (input.height() + tileSize - 1) / tileSize);
+
+  std::vector<TileSample> tiles(measureTiles(input, mask, tileSize, status));
+  status.throwIfCancelled();
+
+  const bool noSamples
+      = std::none_of(tiles.begin(), tiles.end(), [](const TileSample& tile) { return tile.coverage > 0.0; });
+  if (noSamples) {
+    // Nothing passed the mask.  Sampling the whole page is better than an empty surface.
+    mask.fill(BLACK);
+    tiles = measureTiles(input, mask, tileSize, status);
+    status.throwIfCancelled();
+  }
+
+  if (dbg) {
+    dbg->add(visualizeTiles(tiles, gridSize, false), "tile_values");
+    dbg->add(visualizeTiles(tiles, gridSize, true), "tile_coverage");
+  }
+  return fitTiles(tiles, input.size(), status);
+}  // estimateBackgroundTiled
+
+imageproc::PolynomialSurface estimateBackground(const BackgroundEstimationMethod method,
+                                                const GrayImage& input,
+                                                const QPolygonF& areaToConsider,
+                                                const TaskStatus& status,
+                                                DebugImages* dbg,
+                                                const BinaryImage* mask,
+                                                const double minMaskCoverage) {
+  switch (method) {
+    case BackgroundEstimationMethod::TILED_ROBUST:
+      return estimateBackgroundTiled(input, areaToConsider, status, dbg, mask, minMaskCoverage);
+    case BackgroundEstimationMethod::POLYNOMIAL:
+      break;
+  }
+  return estimateBackground(input, areaToConsider, status, dbg, mask, minMaskCoverage);
+}
@@ -49,4 +49,50 @@ imageproc::PolynomialSurface estimateBackground(const imageproc::GrayImage& inpu
                                                 const imageproc::BinaryImage* mask = nullptr,
                                                 double minMaskCoverage = 0.0);
 
+/**
+ * \brief Selects how estimateBackground() models the page background.
+ */
+enum class BackgroundEstimationMethod {
+  /**
+   * Morphological preprocessing of a 300x300 px proxy followed by
+   * a polynomial fit to all the unmasked pixels.
+   */
+  POLYNOMIAL,
+  /**
+   * Trimmed upper percentiles of full resolution tiles, fitted with
+   * iteratively reweighted least squares.  Tiles are processed in parallel.
+   */
+  TILED_ROBUST
+};
+
+/**
+ * \brief Estimates a grayscale background of a scanned page with the given method.
+ *
+ * The parameters besides \p method are the same as in estimateBackground() above.
+ */
+imageproc::PolynomialSurface estimateBackground(BackgroundEstimationMethod method,
+                                                const imageproc::GrayImage& input,
+                                                const QPolygonF& areaToConsider,
+                                                const TaskStatus& status,
+                                                DebugImages* dbg = nullptr,
+                                                const imageproc::BinaryImage* mask = nullptr,
+                                                double minMaskCoverage = 0.0);
+
+/**
+ * \brief The BackgroundEstimationMethod::TILED_ROBUST estimator.
+ *
+ * The page is split into a grid of tiles.  Each tile contributes the mean of
+ * its considered pixels between the 50th and the 90th percentile, which
+ * skips text and keeps the paper.  Tiles covered by pictures or dark
+ * surroundings are then rejected as outliers by an asymmetric Tukey's biweight
+ * while fitting the surface.  Unlike estimateBackground(), this one doesn't
+ * expect the orientation to be correct.
+ */
+imageproc::PolynomialSurface estimateBackgroundTiled(const imageproc::GrayImage& input,
+                                                     const QPolygonF& areaToConsider,
+                                                     const TaskStatus& status,
+                                                     DebugImages* dbg = nullptr,
+                                                     const imageproc::BinaryImage* mask = nullptr,
+                                                     double minMaskCoverage = 0.0);
+
 #endif
@@ -4,22 +4,68 @@
 #include "FilterData.h"
 
 #include <Grayscale.h>
+#include <Scale.h>
+#include <Transform.h>
 
+#include <QColor>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QTransform>
+#include <algorithm>
+#include <cmath>
+
+#include "Dpi.h"
 #include "Dpm.h"
 
 using namespace imageproc;
 
+class FilterData::AnalysisCache {
+ public:
+  QMutex mutex;
+  GrayImage grayImage150dpi;
+};
+
+class FilterData::GrayImageHolder {
+ public:
+  QMutex mutex;
+  GrayImage grayImage;
+};
+
 FilterData::FilterData(const QImage& image)
-    : m_origImage(image), m_grayImage(toGrayscale(m_origImage)), m_xform(image.rect(), Dpm(image)) {}
+    : m_origImage(image),
+      m_grayImage(std::make_shared<GrayImageHolder>()),
+      m_xform(image.rect(), Dpm(image)),
+      m_analysisCache(std::make_shared<AnalysisCache>()) {
+  if (isBitonalImage(m_origImage)) {
+    // A 1-bit page takes 8 times less memory than its grayscale version.
+    m_binaryImage = BinaryImage(m_origImage);
+  } else {
+    m_grayImage->grayImage = toGrayscale(m_origImage);
+  }
+}
 
 FilterData::FilterData(const FilterData& other, const ImageTransformation& xform)
     : m_origImage(other.m_origImage),
+      m_binaryImage(other.m_binaryImage),
       m_grayImage(other.m_grayImage),
       m_xform(xform),
-      m_imageParams(other.m_imageParams) {}
+      m_imageParams(other.m_imageParams),
+      m_analysisCache(std::make_shared<AnalysisCache>()) {}
 
 FilterData::FilterData(const FilterData& other) = default;
 
+bool FilterData::isBitonalImage(const QImage& image) {
+  if ((image.format() != QImage::Format_Mono) && (image.format() != QImage::Format_MonoLSB)) {
+    return false;
+  }
+  if (image.colorCount() != 2) {
+    return false;
+  }
+  const int gray0 = qGray(image.color(0));
+  const int gray1 = qGray(image.color(1));
+  return ((gray0 == 0) && (gray1 == 255)) || ((gray0 == 255) && (gray1 == 0));
+}
+
 imageproc::BinaryThreshold FilterData::bwThreshold() const {
   return m_imageParams.getBwThreshold();
 }
@@ -32,6 +78,60 @@ imageproc::BinaryThreshold FilterData::bwThresholdBlackOnWhite() const {
   return isBlackOnWhite() ? bwThreshold() : BinaryThreshold(256 - int(bwThreshold()));
 }
 
+const GrayImage& FilterData::grayImage() const {
+  QMutexLocker locker(&m_grayImage->mutex);
+  if (m_grayImage->grayImage.isNull() && !m_origImage.isNull()) {
+    m_grayImage->grayImage = toGrayscale(m_origImage);
+  }
+  return m_grayImage->grayImage;
+}
+
+imageproc::BinaryImage FilterData::binaryImageBlackOnWhite() const {
+  return isBlackOnWhite() ? m_binaryImage : m_binaryImage.inverted();
+}
+
 imageproc::GrayImage FilterData::grayImageBlackOnWhite() const {
-  return isBlackOnWhite() ? m_grayImage : m_grayImage.inverted();
+  return isBlackOnWhite() ? grayImage() : grayImage().inverted();
+}
+
+GrayImage FilterData::grayImage150dpi() const {
+  QMutexLocker locker(&m_analysisCache->mutex);
+  if (!m_analysisCache->grayImage150dpi.isNull()) {
+    return m_analysisCache->grayImage150dpi;
+  }
+
+  ImageTransformation xform150dpi(m_xform);
+  xform150dpi.preScaleToDpi(Dpi(150, 150));
+  if (xform150dpi.resultingRect().toRect().isEmpty()) {
+    return GrayImage();
+  }
+
+  GrayImage grayImage;
+  QTransform toGrayImage;
+  const Dpi origDpi(m_xform.origDpi());
+  if (isBitonal() && (origDpi.horizontal() > 150) && (origDpi.vertical() > 150)) {
+    // Shrink the bits straight to gray at about 150 DPI first, so that
+    // neither a full resolution grayscale copy nor transforming one is needed.
+    const QSize proxySize(
+        std::max(1, static_cast<int>(std::lround(m_binaryImage.width() * 150.0 / origDpi.horizontal()))),
+        std::max(1, static_cast<int>(std::lround(m_binaryImage.height() * 150.0 / origDpi.vertical()))));
+    grayImage = scaleToGray(binaryImageBlackOnWhite(), proxySize);
+    toGrayImage = QTransform::fromScale(double(proxySize.width()) / m_binaryImage.width(),
+                                        double(proxySize.height()) / m_binaryImage.height());
+  } else {
+    grayImage = grayImageBlackOnWhite();
+  }
+
+  const uint8_t darkestGrayLevel = imageproc::darkestGrayLevel(grayImage);
+  const QColor outsideColor(darkestGrayLevel, darkestGrayLevel, darkestGrayLevel);
+  m_analysisCache->grayImage150dpi
+      = transformToGray(grayImage, toGrayImage.inverted() * xform150dpi.transform(),
+                        xform150dpi.resultingRect().toRect(), OutsidePixels::assumeColor(outsideColor));
+  return m_analysisCache->grayImage150dpi;
+}
+
+void FilterData::updateImageParams(const ImageSettings::PageParams& imageParams) {
+  m_imageParams = imageParams;
+  // The analysis images depend on whether the image is black on white.
+  m_analysisCache = std::make_shared<AnalysisCache>();
 }
@@ -4,10 +4,12 @@
 #ifndef SCANTAILOR_CORE_FILTERDATA_H_
 #define SCANTAILOR_CORE_FILTERDATA_H_
 
+#include <BinaryImage.h>
 #include <BinaryThreshold.h>
 #include <GrayImage.h>
 
 #include <QImage>
+#include <memory>
 
 #include "ImageSettings.h"
 #include "ImageTransformation.h"
@@ -27,6 +29,32 @@ class FilterData {
 
   const QImage& origImage() const;
 
+  /**
+   * \brief Whether the original is a 1-bit black and white image, like a CCITT G4 scan.
+   *
+   * For those, binaryImage() is what gets worked on wherever possible, and
+   * grayImage() is only made on first use, for the things that need it.
+   */
+  bool isBitonal() const;
+
+  /**
+   * \brief Whether a FilterData made from \p image would be isBitonal().
+   *
+   * Only pure black and white palettes count.  Anything else would come out
+   * as different gray levels in grayImage().
+   */
+  static bool isBitonalImage(const QImage& image);
+
+  /**
+   * \brief The original as a binary image.  Null unless isBitonal().
+   */
+  const imageproc::BinaryImage& binaryImage() const;
+
+  /**
+   * \brief binaryImage(), inverted if the page isn't black on white.
+   */
+  imageproc::BinaryImage binaryImageBlackOnWhite() const;
+
   const imageproc::GrayImage& grayImage() const;
 
   bool isBlackOnWhite() const;
@@ -35,13 +63,29 @@ class FilterData {
 
   imageproc::GrayImage grayImageBlackOnWhite() const;
 
+  /**
+   * \brief grayImageBlackOnWhite() transformed by xform() and scaled to 150 DPI.
+   *
+   * The areas outside of the image are filled with its darkest gray level,
+   * so that they look like the scanner background.  This is what the page box
+   * and the content box are detected on.  It's computed on first use and shared
+   * with the copies of this object, as long as the transformation stays the same.
+   */
+  imageproc::GrayImage grayImage150dpi() const;
+
   void updateImageParams(const ImageSettings::PageParams& imageParams);
 
  private:
+  class AnalysisCache;
+  class GrayImageHolder;
+
   QImage m_origImage;
-  imageproc::GrayImage m_grayImage;
+  imageproc::BinaryImage m_binaryImage;
+  // Shared with all the copies, whatever their transformation.
+  std::shared_ptr<GrayImageHolder> m_grayImage;
   ImageTransformation m_xform;
   ImageSettings::PageParams m_imageParams;
+  std::shared_ptr<AnalysisCache> m_analysisCache;
 };
 
 
@@ -53,12 +97,12 @@ inline const QImage& FilterData::origImage() const {
   return m_origImage;
 }
 
-inline const imageproc::GrayImage& FilterData::grayImage() const {
-  return m_grayImage;
+inline bool FilterData::isBitonal() const {
+  return !m_binaryImage.isNull();
 }
 
-inline void FilterData::updateImageParams(const ImageSettings::PageParams& imageParams) {
-  m_imageParams = imageParams;
+inline const imageproc::BinaryImage& FilterData::binaryImage() const {
+  return m_binaryImage;
 }
 
 
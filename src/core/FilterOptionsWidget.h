@@ -30,6 +30,15 @@ class FilterOptionsWidget : public QWidget {
 
   void invalidateAllThumbnails();
 
+  /**
+   * \brief To be emitted once for all the pages a bulk change has touched.
+   *
+   * Unlike emitting invalidateThumbnail(PageId) per page, this lets the thumbnail
+   * view rebuild and lay out the affected thumbnails in one go, and unlike
+   * invalidateAllThumbnails(), it leaves the rest of the thumbnails alone.
+   */
+  void invalidateThumbnails(const std::set<PageId>& pages);
+
   /**
    * After we've got rid of "Widest Page" / "Tallest Page" links,
    * there is no one using this signal.  It's a candidate for removal.
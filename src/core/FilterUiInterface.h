@@ -5,6 +5,7 @@
 #define SCANTAILOR_CORE_FILTERUIINTERFACE_H_
 
 #include <memory>
+#include <set>
 
 #include "AbstractCommand.h"
 #include "PageId.h"
@@ -32,6 +33,8 @@ class FilterUiInterface {
 
   virtual void invalidateThumbnail(const PageId& pageId) = 0;
 
+  virtual void invalidateThumbnails(const std::set<PageId>& pages) = 0;
+
   virtual void invalidateAllThumbnails() = 0;
 
   /**
@@ -6,6 +6,7 @@
 #include <QFile>
 #include <QFileInfo>
 #include <QImage>
+#include <QThread>
 #include <QtGui/QImageReader>
 
 #include <algorithm>
@@ -24,6 +25,7 @@
 #endif
 
 #include "ImageId.h"
+#include "IsolatedImageDecoder.h"
 #include "PdfReader.h"
 #include "TiffReader.h"
 
@@ -253,6 +255,64 @@ class DecodedImageCache {
   std::atomic<std::uint64_t> m_pdfRasterizations{0};
   std::atomic<std::uint64_t> m_decodedBytes{0};
 };
+
+/**
+ * Decoders running their helpers, one per thread decoding at the same time.
+ */
+class IsolatedDecoderPool {
+ public:
+  static IsolatedDecoderPool& instance() {
+    static IsolatedDecoderPool pool;
+    return pool;
+  }
+
+  static bool isEnabled() {
+    static const bool enabled
+        = IsolatedImageDecoder::isSupported() && (qEnvironmentVariableIntValue("SCANTAILOR_ISOLATED_DECODING") != 0);
+    return enabled;
+  }
+
+  QImage decode(const QString& filePath, const int pageNum) {
+    std::unique_ptr<IsolatedImageDecoder> decoder(acquire());
+    QString errorMessage;
+    const QImage image(decoder->decode(filePath, pageNum, &errorMessage));
+    release(std::move(decoder));
+    if (image.isNull()) {
+      // LoadFileTask reports the page as failed to load.
+      qWarning("%s", qPrintable(errorMessage));
+    }
+    return image;
+  }
+
+ private:
+  IsolatedDecoderPool() = default;
+
+  std::unique_ptr<IsolatedImageDecoder> acquire() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    const int maxDecoders = std::max(1, QThread::idealThreadCount());
+    m_freeCondition.wait(lock, [&] { return !m_idle.empty() || (m_created < maxDecoders); });
+    if (!m_idle.empty()) {
+      std::unique_ptr<IsolatedImageDecoder> decoder(std::move(m_idle.back()));
+      m_idle.pop_back();
+      return decoder;
+    }
+    ++m_created;
+    return std::make_unique<IsolatedImageDecoder>(IsolatedImageDecoder::defaultHelperPath());
+  }
+
+  void release(std::unique_ptr<IsolatedImageDecoder> decoder) {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_idle.push_back(std::move(decoder));
+    }
+    m_freeCondition.notify_one();
+  }
+
+  std::mutex m_mutex;
+  std::condition_variable m_freeCondition;
+  std::list<std::unique_ptr<IsolatedImageDecoder>> m_idle;
+  int m_created = 0;
+};
 }  // namespace
 
 QImage ImageLoader::load(const ImageId& imageId) {
@@ -269,14 +329,21 @@ QImage ImageLoader::load(const QString& filePath, const int pageNum) {
       return PdfReader::readImage(filePath, pageNum, pdfRenderDpi);
     }
 
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly)) {
-      return QImage();
+    if (IsolatedDecoderPool::isEnabled()) {
+      return IsolatedDecoderPool::instance().decode(filePath, pageNum);
     }
-    return load(file, pageNum);
+    return decodeFile(filePath, pageNum);
   });
 }
 
+QImage ImageLoader::decodeFile(const QString& filePath, const int pageNum) {
+  QFile file(filePath);
+  if (!file.open(QIODevice::ReadOnly)) {
+    return QImage();
+  }
+  return load(file, pageNum);
+}
+
 QImage ImageLoader::load(QIODevice& ioDev, const int pageNum) {
   if (TiffReader::canRead(ioDev)) {
     return TiffReader::readImage(ioDev, pageNum);
@@ -31,6 +31,16 @@ class ImageLoader {
 
   static QImage load(QIODevice& ioDev, int pageNum);
 
+  /**
+   * \brief Decodes a page of a raster image file in this process, bypassing
+   *        the cache.  PDF files aren't handled here.
+   *
+   * This is what the isolated decoder helper runs.  load() decodes in the
+   * helper instead when the SCANTAILOR_ISOLATED_DECODING environment
+   * variable is set, see IsolatedImageDecoder.
+   */
+  static QImage decodeFile(const QString& filePath, int pageNum);
+
   static void invalidate(const QString& filePath);
 
   static Statistics statistics();
@@ -0,0 +1,76 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include "InputFingerprint.h"
+
+#include <QImage>
+#include <QPointF>
+#include <QPolygonF>
+#include <QRectF>
+#include <QString>
+#include <QTransform>
+
+InputFingerprint::InputFingerprint() : m_hash(QCryptographicHash::Md5) {}
+
+InputFingerprint& InputFingerprint::operator<<(const int value) {
+  m_hash.addData(QByteArrayView(reinterpret_cast<const char*>(&value), sizeof(value)));
+  return *this;
+}
+
+InputFingerprint& InputFingerprint::operator<<(const double value) {
+  // Make 0.0 and -0.0 hash the same, as they compare equal.
+  const double normalized = (value == 0.0) ? 0.0 : value;
+  m_hash.addData(QByteArrayView(reinterpret_cast<const char*>(&normalized), sizeof(normalized)));
+  return *this;
+}
+
+InputFingerprint& InputFingerprint::operator<<(const QString& value) {
+  // The length goes first, so that "ab" + "c" differs from "a" + "bc".
+  *this << int(value.size());
+  m_hash.addData(QByteArrayView(reinterpret_cast<const char*>(value.utf16()), value.size() * sizeof(char16_t)));
+  return *this;
+}
+
+InputFingerprint& InputFingerprint::operator<<(const QPointF& value) {
+  return *this << value.x() << value.y();
+}
+
+InputFingerprint& InputFingerprint::operator<<(const QRectF& value) {
+  return *this << value.x() << value.y() << value.width() << value.height();
+}
+
+InputFingerprint& InputFingerprint::operator<<(const QPolygonF& value) {
+  *this << int(value.size());
+  for (const QPointF& point : value) {
+    *this << point;
+  }
+  return *this;
+}
+
+InputFingerprint& InputFingerprint::operator<<(const QTransform& value) {
+  return *this << value.m11() << value.m12() << value.m13() << value.m21() << value.m22() << value.m23() << value.m31()
+               << value.m32() << value.m33();
+}
+
+InputFingerprint& InputFingerprint::operator<<(const QImage& value) {
+  *this << value.width() << value.height() << int(value.format());
+  if (value.isNull()) {
+    return *this;
+  }
+
+  // The padding at the end of the lines is left out, as it's undefined.
+  const int lineBytes = static_cast<int>((qint64(value.width()) * value.depth() + 7) / 8);
+  for (int y = 0; y < value.height(); ++y) {
+    m_hash.addData(QByteArrayView(reinterpret_cast<const char*>(value.constScanLine(y)), lineBytes));
+  }
+  if (!value.colorTable().isEmpty()) {
+    const QList<QRgb> colorTable(value.colorTable());
+    m_hash.addData(
+        QByteArrayView(reinterpret_cast<const char*>(colorTable.constData()), colorTable.size() * sizeof(QRgb)));
+  }
+  return *this;
+}
+
+QByteArray InputFingerprint::result() const {
+  return m_hash.result();
+}
@@ -0,0 +1,58 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#ifndef SCANTAILOR_CORE_INPUTFINGERPRINT_H_
+#define SCANTAILOR_CORE_INPUTFINGERPRINT_H_
+
+#include <QByteArray>
+#include <QCryptographicHash>
+
+#include "NonCopyable.h"
+
+class QImage;
+class QPointF;
+class QPolygonF;
+class QRectF;
+class QString;
+class QTransform;
+
+/**
+ * \brief Accumulates the inputs of a computation into a short digest.
+ *
+ * Two digests are equal if the same values were fed in the same order,
+ * which lets a result computed earlier be checked against the inputs
+ * at hand without keeping the inputs themselves around.
+ */
+class InputFingerprint {
+  DECLARE_NON_COPYABLE(InputFingerprint)
+
+ public:
+  InputFingerprint();
+
+  InputFingerprint& operator<<(int value);
+
+  InputFingerprint& operator<<(double value);
+
+  InputFingerprint& operator<<(const QString& value);
+
+  InputFingerprint& operator<<(const QPointF& value);
+
+  InputFingerprint& operator<<(const QRectF& value);
+
+  InputFingerprint& operator<<(const QPolygonF& value);
+
+  InputFingerprint& operator<<(const QTransform& value);
+
+  /**
+   * \brief Adds the size, the format and the pixels of an image.
+   */
+  InputFingerprint& operator<<(const QImage& value);
+
+  QByteArray result() const;
+
+ private:
+  QCryptographicHash m_hash;
+};
+
+
+#endif  // ifndef SCANTAILOR_CORE_INPUTFINGERPRINT_H_
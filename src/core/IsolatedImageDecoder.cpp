@@ -0,0 +1,716 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include "IsolatedImageDecoder.h"
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QImageReader>
+#include <QList>
+#include <QPixelFormat>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <new>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+extern char** environ;
+#endif
+
+#include "ImageLoader.h"
+#include "TiffReader.h"
+
+namespace {
+const char HELPER_ENV_VAR[] = "SCANTAILOR_DECODE_HELPER";
+const char HELPER_NAME[] = "scantailor-decode-helper";
+
+const uint32_t REQUEST_MAGIC = 0x53544452;
+const uint32_t REPLY_MAGIC = 0x53544441;
+const uint32_t IMAGE_MAGIC = 0x53544449;
+const uint32_t PROTOCOL_VERSION = 1;
+const uint32_t MAX_PATH_BYTES = 64 * 1024;
+const uint32_t MAX_MESSAGE_BYTES = 4096;
+
+struct RequestHeader {
+  uint32_t magic;
+  uint32_t version;
+  int32_t pageNum;
+  uint32_t pathBytes;
+};
+
+enum ReplyStatus : int32_t { REPLY_IMAGE, REPLY_NO_IMAGE, REPLY_FAILED };
+
+/**
+ * A REPLY_IMAGE reply comes with the shared memory file descriptor attached.
+ * The other ones may be followed by a message of messageBytes.
+ */
+struct ReplyHeader {
+  uint32_t magic;
+  int32_t status;
+  uint64_t imageBytes;
+  uint32_t messageBytes;
+  uint32_t reserved;
+};
+
+/**
+ * The start of the shared memory.  It's followed by the color table,
+ * and then, at pixelOffset, by the pixels.
+ */
+struct ImageHeader {
+  uint32_t magic;
+  uint32_t version;
+  int32_t width;
+  int32_t height;
+  int32_t bytesPerLine;
+  int32_t format;
+  int32_t dotsPerMeterX;
+  int32_t dotsPerMeterY;
+  uint32_t colorCount;
+  uint32_t reserved;
+  uint64_t pixelOffset;
+};
+
+const uint64_t PIXEL_ALIGNMENT = 64;
+
+#ifndef _WIN32
+// The helper gets its end of the socket as this descriptor.
+const int HELPER_SOCKET_FD = 3;
+
+#ifdef MSG_NOSIGNAL
+const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+// SO_NOSIGPIPE is set on the socket instead.
+const int SEND_FLAGS = 0;
+#endif
+
+bool sendFully(const int fd, const void* data, size_t size) {
+  const auto* bytes = static_cast<const char*>(data);
+  while (size > 0) {
+    const ssize_t sent = ::send(fd, bytes, size, SEND_FLAGS);
+    if (sent < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    bytes += sent;
+    size -= static_cast<size_t>(sent);
+  }
+  return true;
+}
+
+bool sendWithFd(const int socketFd, const void* data, const size_t size, const int fdToSend) {
+  iovec iov;
+  iov.iov_base = const_cast<void*>(data);
+  iov.iov_len = size;
+
+  union {
+    cmsghdr header;
+    char buffer[CMSG_SPACE(sizeof(int))];
+  } control;
+  std::memset(&control, 0, sizeof(control));
+
+  msghdr message;
+  std::memset(&message, 0, sizeof(message));
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+  message.msg_control = control.buffer;
+  message.msg_controllen = sizeof(control.buffer);
+
+  cmsghdr* const cmsg = CMSG_FIRSTHDR(&message);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+  std::memcpy(CMSG_DATA(cmsg), &fdToSend, sizeof(int));
+
+  ssize_t sent;
+  do {
+    sent = ::sendmsg(socketFd, &message, SEND_FLAGS);
+  } while ((sent < 0) && (errno == EINTR));
+  if (sent < 0) {
+    return false;
+  }
+  // The descriptor went with the first byte.
+  return sendFully(socketFd, static_cast<const char*>(data) + sent, size - static_cast<size_t>(sent));
+}
+
+bool readFully(const int fd, void* data, size_t size) {
+  auto* bytes = static_cast<char*>(data);
+  while (size > 0) {
+    const ssize_t received = ::read(fd, bytes, size);
+    if (received < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    if (received == 0) {
+      return false;
+    }
+    bytes += received;
+    size -= static_cast<size_t>(received);
+  }
+  return true;
+}
+
+enum ReadResult { READ_OK, READ_EOF, READ_TIMEOUT };
+
+/**
+ * Reads exactly \p size bytes before the deadline, picking up a file descriptor
+ * that may come along.  An error on the socket counts as the end of it.
+ */
+ReadResult readWithDeadline(const int fd,
+                            void* data,
+                            size_t size,
+                            const std::chrono::steady_clock::time_point deadline,
+                            int* receivedFd) {
+  auto* bytes = static_cast<char*>(data);
+  while (size > 0) {
+    const auto remaining
+        = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+    if (remaining <= 0) {
+      return READ_TIMEOUT;
+    }
+
+    pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    const int ready = ::poll(&pfd, 1, static_cast<int>(std::min<long long>(remaining, std::numeric_limits<int>::max())));
+    if (ready < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return READ_EOF;
+    }
+    if (ready == 0) {
+      continue;
+    }
+
+    iovec iov;
+    iov.iov_base = bytes;
+    iov.iov_len = size;
+    union {
+      cmsghdr header;
+      char buffer[CMSG_SPACE(sizeof(int))];
+    } control;
+    msghdr message;
+    std::memset(&message, 0, sizeof(message));
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control.buffer;
+    message.msg_controllen = sizeof(control.buffer);
+
+    const ssize_t received = ::recvmsg(fd, &message, 0);
+    if (received < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return READ_EOF;
+    }
+    if (received == 0) {
+      return READ_EOF;
+    }
+
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&message); cmsg; cmsg = CMSG_NXTHDR(&message, cmsg)) {
+      if ((cmsg->cmsg_level == SOL_SOCKET) && (cmsg->cmsg_type == SCM_RIGHTS)) {
+        int fdReceived = -1;
+        std::memcpy(&fdReceived, CMSG_DATA(cmsg), sizeof(int));
+        if (receivedFd && (*receivedFd < 0)) {
+          *receivedFd = fdReceived;
+        } else {
+          ::close(fdReceived);
+        }
+      }
+    }
+
+    bytes += received;
+    size -= static_cast<size_t>(received);
+  }
+  return READ_OK;
+}  // readWithDeadline
+
+void setCloseOnExec(const int fd) {
+  ::fcntl(fd, F_SETFD, ::fcntl(fd, F_GETFD) | FD_CLOEXEC);
+}
+
+int createSharedMemory(const uint64_t size) {
+  int fd = -1;
+#ifdef MFD_CLOEXEC
+  fd = ::memfd_create("scantailor-decoded-image", MFD_CLOEXEC);
+#endif
+  if (fd < 0) {
+    // No memfd on this system.  An unlinked temporary file works the same way.
+    QByteArray pathTemplate(QFile::encodeName(QDir::tempPath() + "/scantailor-decoded-XXXXXX"));
+    fd = ::mkstemp(pathTemplate.data());
+    if (fd < 0) {
+      return -1;
+    }
+    ::unlink(pathTemplate.constData());
+    setCloseOnExec(fd);
+  }
+  if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+    ::close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+bool sendStatus(const int socketFd, const ReplyStatus status, const QString& message) {
+  const QByteArray messageBytes(message.toUtf8().left(MAX_MESSAGE_BYTES));
+  ReplyHeader reply;
+  std::memset(&reply, 0, sizeof(reply));
+  reply.magic = REPLY_MAGIC;
+  reply.status = status;
+  reply.messageBytes = static_cast<uint32_t>(messageBytes.size());
+  return sendFully(socketFd, &reply, sizeof(reply)) && sendFully(socketFd, messageBytes.constData(), messageBytes.size());
+}
+
+bool sendImage(const int socketFd, const QImage& image) {
+  const QList<QRgb> colorTable(image.colorTable());
+  const uint64_t colorTableBytes = uint64_t(colorTable.size()) * sizeof(QRgb);
+
+  ImageHeader header;
+  std::memset(&header, 0, sizeof(header));
+  header.magic = IMAGE_MAGIC;
+  header.version = PROTOCOL_VERSION;
+  header.width = image.width();
+  header.height = image.height();
+  header.bytesPerLine = static_cast<int32_t>(image.bytesPerLine());
+  header.format = image.format();
+  header.dotsPerMeterX = image.dotsPerMeterX();
+  header.dotsPerMeterY = image.dotsPerMeterY();
+  header.colorCount = static_cast<uint32_t>(colorTable.size());
+  header.pixelOffset = (sizeof(header) + colorTableBytes + PIXEL_ALIGNMENT - 1) / PIXEL_ALIGNMENT * PIXEL_ALIGNMENT;
+  const uint64_t totalBytes = header.pixelOffset + uint64_t(image.sizeInBytes());
+
+  const int shm = createSharedMemory(totalBytes);
+  if (shm < 0) {
+    return sendStatus(socketFd, REPLY_FAILED, QStringLiteral("Could not allocate shared memory"));
+  }
+  void* const memory = ::mmap(nullptr, totalBytes, PROT_READ | PROT_WRITE, MAP_SHARED, shm, 0);
+  if (memory == MAP_FAILED) {
+    ::close(shm);
+    return sendStatus(socketFd, REPLY_FAILED, QStringLiteral("Could not map shared memory"));
+  }
+  auto* const bytes = static_cast<char*>(memory);
+  std::memcpy(bytes, &header, sizeof(header));
+  std::memcpy(bytes + sizeof(header), colorTable.constData(), colorTableBytes);
+  std::memcpy(bytes + header.pixelOffset, image.constBits(), image.sizeInBytes());
+  ::munmap(memory, totalBytes);
+
+  ReplyHeader reply;
+  std::memset(&reply, 0, sizeof(reply));
+  reply.magic = REPLY_MAGIC;
+  reply.status = REPLY_IMAGE;
+  reply.imageBytes = totalBytes;
+  const bool sent = sendWithFd(socketFd, &reply, sizeof(reply), shm);
+  ::close(shm);
+  return sent;
+}  // sendImage
+
+/**
+ * Makes the helper get SIGXCPU once the current decode exceeds its CPU time budget.
+ */
+void limitCpuTimeOfNextDecode(const int cpuSeconds) {
+  rusage usage;
+  if (::getrusage(RUSAGE_SELF, &usage) != 0) {
+    return;
+  }
+  const rlim_t usedSeconds = static_cast<rlim_t>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + 1);
+  rlimit limit;
+  if (::getrlimit(RLIMIT_CPU, &limit) != 0) {
+    return;
+  }
+  // Only the soft limit moves, as an unprivileged process can't raise the hard one.
+  limit.rlim_cur = usedSeconds + static_cast<rlim_t>(cpuSeconds);
+  if ((limit.rlim_max != RLIM_INFINITY) && (limit.rlim_cur > limit.rlim_max)) {
+    limit.rlim_cur = limit.rlim_max;
+  }
+  if (::setrlimit(RLIMIT_CPU, &limit) != 0) {
+    qWarning("decode helper: can't limit the CPU time: %s", std::strerror(errno));
+  }
+}
+
+struct SharedImageMapping {
+  void* address;
+  size_t size;
+};
+
+void unmapSharedImage(void* info) {
+  auto* const mapping = static_cast<SharedImageMapping*>(info);
+  ::munmap(mapping->address, mapping->size);
+  delete mapping;
+}
+
+/**
+ * Wraps the shared memory from the helper into a QImage, without copying the pixels.
+ * The mapping is private, so the image may be modified.
+ */
+QImage mapSharedImage(const int fd, const uint64_t size, QString* errorMessage) {
+  struct stat fileStat;
+  if ((::fstat(fd, &fileStat) != 0) || (uint64_t(fileStat.st_size) < size) || (size < sizeof(ImageHeader))) {
+    *errorMessage = QStringLiteral("The decode helper sent a malformed image");
+    return QImage();
+  }
+  void* const memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  if (memory == MAP_FAILED) {
+    *errorMessage = QStringLiteral("Could not map the decoded image");
+    return QImage();
+  }
+  auto* const bytes = static_cast<uchar*>(memory);
+
+  ImageHeader header;
+  std::memcpy(&header, bytes, sizeof(header));
+
+  bool valid = (header.magic == IMAGE_MAGIC) && (header.version == PROTOCOL_VERSION) && (header.width > 0)
+               && (header.height > 0) && (header.format > QImage::Format_Invalid)
+               && (header.format < QImage::NImageFormats) && (header.colorCount <= 256)
+               && (header.pixelOffset % PIXEL_ALIGNMENT == 0)
+               && (header.pixelOffset >= sizeof(header) + uint64_t(header.colorCount) * sizeof(QRgb));
+  if (valid) {
+    const auto format = static_cast<QImage::Format>(header.format);
+    const uint64_t minBytesPerLine = (uint64_t(header.width) * QImage::toPixelFormat(format).bitsPerPixel() + 7) / 8;
+    valid = (header.bytesPerLine > 0) && (uint64_t(header.bytesPerLine) >= minBytesPerLine)
+            && (header.pixelOffset + uint64_t(header.bytesPerLine) * uint64_t(header.height) <= size);
+  }
+  if (!valid) {
+    ::munmap(memory, size);
+    *errorMessage = QStringLiteral("The decode helper sent a malformed image");
+    return QImage();
+  }
+
+  QImage image(bytes + header.pixelOffset, header.width, header.height, header.bytesPerLine,
+               static_cast<QImage::Format>(header.format), &unmapSharedImage, new SharedImageMapping{memory, size});
+  if (header.colorCount > 0) {
+    QList<QRgb> colorTable(header.colorCount);
+    std::memcpy(colorTable.data(), bytes + sizeof(header), header.colorCount * sizeof(QRgb));
+    image.setColorTable(colorTable);
+  }
+  image.setDotsPerMeterX(header.dotsPerMeterX);
+  image.setDotsPerMeterY(header.dotsPerMeterY);
+  return image;
+}  // mapSharedImage
+#endif  // ifndef _WIN32
+
+void setError(QString* errorMessage, const QString& message) {
+  if (errorMessage) {
+    *errorMessage = message;
+  }
+}
+}  // namespace
+
+IsolatedImageDecoder::IsolatedImageDecoder(const QString& helperPath, const Limits& limits)
+    : m_helperPath(helperPath), m_limits(limits) {}
+
+IsolatedImageDecoder::~IsolatedImageDecoder() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  stop();
+}
+
+bool IsolatedImageDecoder::isSupported() {
+#ifdef _WIN32
+  return false;
+#else
+  return true;
+#endif
+}
+
+QString IsolatedImageDecoder::defaultHelperPath() {
+  const QString overridden(qEnvironmentVariable(HELPER_ENV_VAR));
+  if (!overridden.isEmpty()) {
+    return overridden;
+  }
+  return QDir(QCoreApplication::applicationDirPath()).filePath(HELPER_NAME);
+}
+
+int IsolatedImageDecoder::startCount() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_startCount;
+}
+
+int64_t IsolatedImageDecoder::helperProcessId() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_pid;
+}
+
+QImage IsolatedImageDecoder::decode(const QString& filePath, const int pageNum, QString* errorMessage) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  QString error;
+  const QImage image(decodeLocked(filePath, pageNum, &error));
+  setError(errorMessage, error);
+  return image;
+}
+
+#ifdef _WIN32
+
+bool IsolatedImageDecoder::ensureRunning(QString* errorMessage) {
+  *errorMessage = QStringLiteral("Decoding in a separate process is not supported on this system");
+  return false;
+}
+
+void IsolatedImageDecoder::stop() {}
+
+QImage IsolatedImageDecoder::decodeLocked(const QString&, int, QString* errorMessage) {
+  ensureRunning(errorMessage);
+  return QImage();
+}
+
+int IsolatedImageDecoder::serve(int, const Limits&) {
+  return 1;
+}
+
+#else  // ifdef _WIN32
+
+bool IsolatedImageDecoder::ensureRunning(QString* errorMessage) {
+  if (m_pid > 0) {
+    int status = 0;
+    if (::waitpid(static_cast<pid_t>(m_pid), &status, WNOHANG) == 0) {
+      return true;
+    }
+    // It died while idle, and has been reaped just now.
+    m_pid = -1;
+    stop();
+  }
+
+  int fds[2];
+  int socketType = SOCK_STREAM;
+#ifdef SOCK_CLOEXEC
+  socketType |= SOCK_CLOEXEC;
+#endif
+  if (::socketpair(AF_UNIX, socketType, 0, fds) != 0) {
+    *errorMessage = QStringLiteral("Could not create a socket for the decode helper: %1").arg(strerror(errno));
+    return false;
+  }
+  setCloseOnExec(fds[0]);
+  setCloseOnExec(fds[1]);
+#ifdef SO_NOSIGPIPE
+  const int noSigPipe = 1;
+  ::setsockopt(fds[0], SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+#endif
+
+  int childFd = fds[1];
+  if (childFd == HELPER_SOCKET_FD) {
+    // dup2() onto itself wouldn't clear the close-on-exec flag.
+    childFd = ::fcntl(fds[1], F_DUPFD_CLOEXEC, HELPER_SOCKET_FD + 1);
+    ::close(fds[1]);
+  }
+
+  const QByteArray helperPath(QFile::encodeName(m_helperPath));
+  const QByteArray socketArg("--socket-fd=" + QByteArray::number(HELPER_SOCKET_FD));
+  const QByteArray addressSpaceArg("--address-space-mb="
+                                   + QByteArray::number(qulonglong(m_limits.addressSpaceBytes / (1024 * 1024))));
+  const QByteArray imageArg("--image-mb=" + QByteArray::number(qulonglong(m_limits.imageBytes / (1024 * 1024))));
+  const QByteArray cpuArg("--cpu-seconds=" + QByteArray::number(m_limits.cpuSeconds));
+  char* const argv[] = {const_cast<char*>(helperPath.constData()),      const_cast<char*>(socketArg.constData()),
+                        const_cast<char*>(addressSpaceArg.constData()), const_cast<char*>(imageArg.constData()),
+                        const_cast<char*>(cpuArg.constData()),          nullptr};
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, childFd, HELPER_SOCKET_FD);
+  pid_t pid = -1;
+  const int spawnError = ::posix_spawn(&pid, helperPath.constData(), &actions, nullptr, argv, environ);
+  posix_spawn_file_actions_destroy(&actions);
+  ::close(childFd);
+
+  if (spawnError != 0) {
+    ::close(fds[0]);
+    *errorMessage = QStringLiteral("Could not start the decode helper %1: %2").arg(m_helperPath, strerror(spawnError));
+    return false;
+  }
+
+  m_pid = pid;
+  m_socket = fds[0];
+  ++m_startCount;
+  return true;
+}  // IsolatedImageDecoder::ensureRunning
+
+void IsolatedImageDecoder::stop() {
+  if (m_socket >= 0) {
+    ::close(m_socket);
+    m_socket = -1;
+  }
+  if (m_pid > 0) {
+    ::kill(static_cast<pid_t>(m_pid), SIGKILL);
+    ::waitpid(static_cast<pid_t>(m_pid), nullptr, 0);
+    m_pid = -1;
+  }
+}
+
+QImage IsolatedImageDecoder::decodeLocked(const QString& filePath, const int pageNum, QString* errorMessage) {
+  const QByteArray path(filePath.toUtf8());
+  if (uint32_t(path.size()) > MAX_PATH_BYTES) {
+    *errorMessage = QStringLiteral("The file path is too long");
+    return QImage();
+  }
+
+  RequestHeader request;
+  std::memset(&request, 0, sizeof(request));
+  request.magic = REQUEST_MAGIC;
+  request.version = PROTOCOL_VERSION;
+  request.pageNum = pageNum;
+  request.pathBytes = static_cast<uint32_t>(path.size());
+
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(m_limits.timeoutMsec);
+  bool sent = false;
+  // A helper that died between the requests is only noticed here, so give a fresh one a try.
+  for (int attempt = 0; (attempt < 2) && !sent; ++attempt) {
+    if (!ensureRunning(errorMessage)) {
+      return QImage();
+    }
+    sent = sendFully(m_socket, &request, sizeof(request)) && sendFully(m_socket, path.constData(), path.size());
+    if (!sent) {
+      stop();
+    }
+  }
+  if (!sent) {
+    *errorMessage = QStringLiteral("Could not send a request to the decode helper");
+    return QImage();
+  }
+
+  ReplyHeader reply;
+  int shm = -1;
+  const ReadResult result = readWithDeadline(m_socket, &reply, sizeof(reply), deadline, &shm);
+  if (result == READ_TIMEOUT) {
+    stop();
+    *errorMessage = QStringLiteral("Decoding %1 took too long").arg(filePath);
+    return QImage();
+  }
+  if (result == READ_EOF) {
+    // Reap the helper to find out what happened to it.
+    ::close(m_socket);
+    m_socket = -1;
+    ::kill(static_cast<pid_t>(m_pid), SIGKILL);
+    int status = 0;
+    ::waitpid(static_cast<pid_t>(m_pid), &status, 0);
+    m_pid = -1;
+
+    if (WIFSIGNALED(status) && (WTERMSIG(status) == SIGXCPU)) {
+      *errorMessage = QStringLiteral("Decoding %1 took too much CPU time").arg(filePath);
+    } else if (WIFSIGNALED(status) && (WTERMSIG(status) != SIGKILL)) {
+      *errorMessage = QStringLiteral("The decoder crashed on %1 (signal %2)").arg(filePath).arg(WTERMSIG(status));
+    } else {
+      *errorMessage = QStringLiteral("The decoder exited unexpectedly on %1").arg(filePath);
+    }
+    return QImage();
+  }
+
+  if ((reply.magic != REPLY_MAGIC) || (reply.messageBytes > MAX_MESSAGE_BYTES)
+      || ((reply.status == REPLY_IMAGE) && (shm < 0))) {
+    if (shm >= 0) {
+      ::close(shm);
+    }
+    stop();
+    *errorMessage = QStringLiteral("The decode helper sent a malformed reply");
+    return QImage();
+  }
+
+  QByteArray message(static_cast<int>(reply.messageBytes), '\0');
+  if ((reply.messageBytes > 0)
+      && (readWithDeadline(m_socket, message.data(), message.size(), deadline, nullptr) != READ_OK)) {
+    if (shm >= 0) {
+      ::close(shm);
+    }
+    stop();
+    *errorMessage = QStringLiteral("The decode helper sent a malformed reply");
+    return QImage();
+  }
+
+  QImage image;
+  switch (reply.status) {
+    case REPLY_IMAGE:
+      image = mapSharedImage(shm, reply.imageBytes, errorMessage);
+      break;
+    case REPLY_NO_IMAGE:
+      *errorMessage = QStringLiteral("%1 could not be decoded").arg(filePath);
+      break;
+    default:
+      *errorMessage = QStringLiteral("Decoding %1 failed: %2").arg(filePath, QString::fromUtf8(message));
+      break;
+  }
+  if (shm >= 0) {
+    // The mapping, if any, stays valid.
+    ::close(shm);
+  }
+  return image;
+}  // IsolatedImageDecoder::decodeLocked
+
+int IsolatedImageDecoder::serve(const int socketFd, const Limits& limits) {
+  ::signal(SIGPIPE, SIG_IGN);
+
+  rlimit addressSpace;
+  addressSpace.rlim_cur = static_cast<rlim_t>(limits.addressSpaceBytes);
+  addressSpace.rlim_max = static_cast<rlim_t>(limits.addressSpaceBytes);
+  if (::setrlimit(RLIMIT_AS, &addressSpace) != 0) {
+    qWarning("decode helper: can't limit the address space: %s", std::strerror(errno));
+  }
+
+  // RLIMIT_AS isn't enforced everywhere (macOS accepts it and ignores it),
+  // so the decoders are also told to refuse images declaring too many pixels.
+  // A zero allocation limit would mean no limit at all.
+  const int imageMegabytes = static_cast<int>(std::clamp<uint64_t>(limits.imageBytes / (1024 * 1024), uint64_t(1),
+                                                                   uint64_t(std::numeric_limits<int>::max())));
+  QImageReader::setAllocationLimit(imageMegabytes);
+  TiffReader::setAllocationLimit(imageMegabytes);
+
+  while (true) {
+    RequestHeader request;
+    if (!readFully(socketFd, &request, sizeof(request))) {
+      // The application went away.
+      return 0;
+    }
+    if ((request.magic != REQUEST_MAGIC) || (request.version != PROTOCOL_VERSION)
+        || (request.pathBytes > MAX_PATH_BYTES)) {
+      return 1;
+    }
+    QByteArray path(static_cast<int>(request.pathBytes), '\0');
+    if (!readFully(socketFd, path.data(), path.size())) {
+      return 0;
+    }
+
+    limitCpuTimeOfNextDecode(limits.cpuSeconds);
+
+    QImage image;
+    QString error;
+    try {
+      image = ImageLoader::decodeFile(QString::fromUtf8(path), request.pageNum);
+    } catch (const std::bad_alloc&) {
+      error = QStringLiteral("Out of memory");
+    } catch (const std::exception& e) {
+      error = QString::fromUtf8(e.what());
+    }
+
+    bool sent;
+    if (!error.isEmpty()) {
+      sent = sendStatus(socketFd, REPLY_FAILED, error);
+    } else if (image.isNull()) {
+      sent = sendStatus(socketFd, REPLY_NO_IMAGE, QString());
+    } else {
+      sent = sendImage(socketFd, image);
+    }
+    if (!sent) {
+      return 1;
+    }
+  }
+}  // IsolatedImageDecoder::serve
+
+#endif  // ifdef _WIN32
@@ -0,0 +1,105 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#ifndef SCANTAILOR_CORE_ISOLATEDIMAGEDECODER_H_
+#define SCANTAILOR_CORE_ISOLATEDIMAGEDECODER_H_
+
+#include <QString>
+#include <cstdint>
+#include <mutex>
+
+#include "NonCopyable.h"
+
+class QImage;
+
+/**
+ * \brief Decodes images in a helper process, so that a corrupt or malicious
+ *        file crashing the decoder or exhausting the memory only takes down
+ *        the helper.
+ *
+ * The helper (scantailor-decode-helper, see serve()) gets the file path and
+ * the page over a socket and sends the pixels back in a shared memory file:
+ * a memfd on Linux, an unlinked temporary file elsewhere.  The helper runs
+ * with limits on its address space and on the CPU time of each decode, and
+ * a decode taking longer than the timeout gets the helper killed.  Images
+ * whose declared size exceeds a limit aren't decoded at all, which also
+ * works where the address space limit doesn't.  A helper
+ * that died is started again on the next request.
+ *
+ * Requests to one decoder are serialized, so concurrent decoding needs one
+ * decoder per thread.  Only POSIX systems are supported, see isSupported().
+ */
+class IsolatedImageDecoder {
+  DECLARE_NON_COPYABLE(IsolatedImageDecoder)
+
+ public:
+  struct Limits {
+    /** The address space of the helper.  Not enforced on macOS. */
+    uint64_t addressSpaceBytes = uint64_t(4096) * 1024 * 1024;
+    /** The memory a single decoded image may take.  Checked before decoding, on any system. */
+    uint64_t imageBytes = uint64_t(1024) * 1024 * 1024;
+    /** The CPU time a single decode may take. */
+    int cpuSeconds = 60;
+    /** The wall clock time a single decode may take, including the helper startup. */
+    int timeoutMsec = 120000;
+  };
+
+  explicit IsolatedImageDecoder(const QString& helperPath, const Limits& limits = Limits());
+
+  /**
+   * Stops the helper.
+   */
+  ~IsolatedImageDecoder();
+
+  static bool isSupported();
+
+  /**
+   * \brief The helper next to the application executable, unless overridden
+   *        by the SCANTAILOR_DECODE_HELPER environment variable.
+   */
+  static QString defaultHelperPath();
+
+  /**
+   * \brief Decodes a page of an image file.
+   *
+   * \return The image, or a null image on failure, in which case the reason
+   *         is stored to \p errorMessage, if provided.
+   */
+  QImage decode(const QString& filePath, int pageNum, QString* errorMessage = nullptr);
+
+  /**
+   * \brief The number of times the helper was started.
+   */
+  int startCount() const;
+
+  /**
+   * \brief The process id of the helper, or -1 if it's not running.
+   */
+  int64_t helperProcessId() const;
+
+  /**
+   * \brief The request loop of the helper process.
+   *
+   * \param socketFd The helper's end of the socket.
+   * \param limits The limits to apply to this process.
+   * \return The exit code for the helper.
+   */
+  static int serve(int socketFd, const Limits& limits);
+
+ private:
+  bool ensureRunning(QString* errorMessage);
+
+  void stop();
+
+  QImage decodeLocked(const QString& filePath, int pageNum, QString* errorMessage);
+
+  const QString m_helperPath;
+  const Limits m_limits;
+  mutable std::mutex m_mutex;
+  int64_t m_pid = -1;
+  int m_socket = -1;
+  int m_startCount = 0;
+};
+
+
+#endif  // ifndef SCANTAILOR_CORE_ISOLATEDIMAGEDECODER_H_
@@ -0,0 +1,388 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include "JpegLosslessTransform.h"
+
+#include <QTransform>
+#include <algorithm>
+#include <cmath>
+#include <csetjmp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "NonCopyable.h"
+
+extern "C" {
+#include <jpeglib.h>
+}
+
+namespace {
+/*============================= JpegErrorManager ===========================*/
+
+class JpegErrorManager : public jpeg_error_mgr {
+  DECLARE_NON_COPYABLE(JpegErrorManager)
+
+ public:
+  JpegErrorManager() : jpeg_error_mgr() {
+    jpeg_std_error(this);
+    error_exit = &JpegErrorManager::errorExit;
+  }
+
+  jmp_buf& jmpBuf() { return m_jmpBuf; }
+
+ private:
+  static void errorExit(j_common_ptr cinfo) { longjmp(static_cast<JpegErrorManager*>(cinfo->err)->jmpBuf(), 1); }
+
+  jmp_buf m_jmpBuf{};
+};
+
+/*=============================== TransformJob =============================*/
+
+/**
+ * Everything libjpeg allocates for a transformation.  It's created before
+ * setjmp(), so it's destroyed properly even if libjpeg bails out with longjmp().
+ */
+class TransformJob {
+  DECLARE_NON_COPYABLE(TransformJob)
+
+ public:
+  TransformJob() {
+    src.err = &errMgr;
+    jpeg_create_decompress(&src);
+    dst.err = &errMgr;
+    jpeg_create_compress(&dst);
+  }
+
+  ~TransformJob() {
+    jpeg_destroy_compress(&dst);
+    jpeg_destroy_decompress(&src);
+    free(outBuffer);
+  }
+
+  JpegErrorManager errMgr;
+  jpeg_decompress_struct src{};
+  jpeg_compress_struct dst{};
+  std::vector<jvirt_barray_ptr> dstArrays;
+  std::vector<std::pair<JDIMENSION, JDIMENSION>> dstArraySizes;
+  unsigned char* outBuffer = nullptr;
+  unsigned long outSize = 0;
+};
+
+void setSource(jpeg_decompress_struct& src, const QByteArray& jpeg) {
+  jpeg_mem_src(&src, (unsigned char*) jpeg.constData(), static_cast<unsigned long>(jpeg.size()));
+}
+
+/**
+ * Baseline or progressive 8-bit grayscale and YCbCr.  CMYK and friends
+ * are rare enough not to bother.
+ */
+bool isSupported(const jpeg_decompress_struct& src) {
+  if (src.data_precision != 8) {
+    return false;
+  }
+  if ((src.num_components == 1) && (src.jpeg_color_space == JCS_GRAYSCALE)) {
+    // Otherwise the iMCU size is ambiguous.
+    return (src.comp_info[0].h_samp_factor == 1) && (src.comp_info[0].v_samp_factor == 1);
+  }
+  return (src.num_components == 3) && (src.jpeg_color_space == JCS_YCbCr);
+}
+
+QSize samplingFactors(const jpeg_decompress_struct& src, const int component) {
+  return QSize(src.comp_info[component].h_samp_factor, src.comp_info[component].v_samp_factor);
+}
+
+QSize maxSamplingFactors(const jpeg_decompress_struct& src) {
+  QSize maxFactors(1, 1);
+  for (int c = 0; c < src.num_components; ++c) {
+    maxFactors = maxFactors.expandedTo(samplingFactors(src, c));
+  }
+  return maxFactors;
+}
+
+JDIMENSION divRoundUp(const long value, const long divisor) {
+  return static_cast<JDIMENSION>((value + divisor - 1) / divisor);
+}
+
+JDIMENSION roundUp(const long value, const long multiple) {
+  return divRoundUp(value, multiple) * static_cast<JDIMENSION>(multiple);
+}
+
+/**
+ * Rotates a block of coefficients in natural order.  Transposing the block
+ * transposes its spectrum, and mirroring it negates the odd frequencies
+ * in the mirrored direction.
+ */
+void transformBlock(const JCOEF* in, JCOEF* out, const int rotation) {
+  for (int r = 0; r < DCTSIZE; ++r) {
+    for (int c = 0; c < DCTSIZE; ++c) {
+      switch (rotation) {
+        case 90:
+          // Transpose, then mirror horizontally.
+          out[r * DCTSIZE + c] = (c & 1) ? -in[c * DCTSIZE + r] : in[c * DCTSIZE + r];
+          break;
+        case 180:
+          out[r * DCTSIZE + c] = ((r + c) & 1) ? -in[r * DCTSIZE + c] : in[r * DCTSIZE + c];
+          break;
+        case 270:
+          // Transpose, then mirror vertically.
+          out[r * DCTSIZE + c] = (r & 1) ? -in[c * DCTSIZE + r] : in[c * DCTSIZE + r];
+          break;
+        default:
+          out[r * DCTSIZE + c] = in[r * DCTSIZE + c];
+          break;
+      }
+    }
+  }
+}
+
+/**
+ * Has libjpeg keep the COM and the APPn markers, like ICC profiles and EXIF data.
+ */
+void saveMarkers(jpeg_decompress_struct& src) {
+  jpeg_save_markers(&src, JPEG_COM, 0xFFFF);
+  for (int i = 0; i < 16; ++i) {
+    jpeg_save_markers(&src, JPEG_APP0 + i, 0xFFFF);
+  }
+}
+
+bool hasSignature(const jpeg_saved_marker_ptr marker, const int code, const char* signature, const size_t length) {
+  return (marker->marker == code) && (marker->data_length >= length)
+         && (std::memcmp(marker->data, signature, length) == 0);
+}
+
+/**
+ * Writes the markers saved by saveMarkers(), except the JFIF and the Adobe ones
+ * that libjpeg has written already, like jpegtran does.
+ */
+void copyMarkers(const jpeg_decompress_struct& src, jpeg_compress_struct& dst) {
+  for (jpeg_saved_marker_ptr marker = src.marker_list; marker; marker = marker->next) {
+    if (dst.write_JFIF_header && hasSignature(marker, JPEG_APP0, "JFIF", 5)) {
+      continue;
+    }
+    if (dst.write_Adobe_marker && hasSignature(marker, JPEG_APP0 + 14, "Adobe", 5)) {
+      continue;
+    }
+    jpeg_write_marker(&dst, marker->marker, marker->data, marker->data_length);
+  }
+}
+
+bool isRightAngle(const int rotation) {
+  return (rotation == 0) || (rotation == 90) || (rotation == 180) || (rotation == 270);
+}
+
+bool isInteger(const double value) {
+  return std::abs(value - std::round(value)) < 1e-6;
+}
+}  // namespace
+
+bool JpegLosslessTransform::readGeometry(const QByteArray& jpeg, QSize* imageSize, QSize* mcuSize) {
+  TransformJob job;
+  if (setjmp(job.errMgr.jmpBuf())) {
+    // Returning from longjmp().
+    return false;
+  }
+
+  setSource(job.src, jpeg);
+  if ((jpeg_read_header(&job.src, TRUE) != JPEG_HEADER_OK) || !isSupported(job.src)) {
+    return false;
+  }
+
+  *imageSize = QSize(job.src.image_width, job.src.image_height);
+  *mcuSize = maxSamplingFactors(job.src) * DCTSIZE;
+  return true;
+}
+
+bool JpegLosslessTransform::decompose(const QTransform& sourceToOutput,
+                                      const QSize& outputSize,
+                                      int* rotation,
+                                      QRect* sourceRect) {
+  if (outputSize.isEmpty() || (sourceToOutput.type() > QTransform::TxRotate)) {
+    return false;
+  }
+
+  const double m11 = sourceToOutput.m11();
+  const double m12 = sourceToOutput.m12();
+  const double m21 = sourceToOutput.m21();
+  const double m22 = sourceToOutput.m22();
+  const double epsilon = 1e-9;
+  if ((std::abs(m11 - 1) < epsilon) && (std::abs(m22 - 1) < epsilon) && (std::abs(m12) < epsilon)
+      && (std::abs(m21) < epsilon)) {
+    *rotation = 0;
+  } else if ((std::abs(m12 - 1) < epsilon) && (std::abs(m21 + 1) < epsilon) && (std::abs(m11) < epsilon)
+             && (std::abs(m22) < epsilon)) {
+    *rotation = 90;
+  } else if ((std::abs(m11 + 1) < epsilon) && (std::abs(m22 + 1) < epsilon) && (std::abs(m12) < epsilon)
+             && (std::abs(m21) < epsilon)) {
+    *rotation = 180;
+  } else if ((std::abs(m12 + 1) < epsilon) && (std::abs(m21 - 1) < epsilon) && (std::abs(m11) < epsilon)
+             && (std::abs(m22) < epsilon)) {
+    *rotation = 270;
+  } else {
+    return false;
+  }
+
+  if (!isInteger(sourceToOutput.dx()) || !isInteger(sourceToOutput.dy())) {
+    // Every output pixel has to be a source pixel.
+    return false;
+  }
+
+  const QRectF area(sourceToOutput.inverted().mapRect(QRectF(QPointF(0, 0), QSizeF(outputSize))));
+  *sourceRect = QRect(qRound(area.left()), qRound(area.top()), qRound(area.width()), qRound(area.height()));
+  return true;
+}  // JpegLosslessTransform::decompose
+
+QRect JpegLosslessTransform::alignCrop(const QRect& sourceRect,
+                                       const int rotation,
+                                       const QSize& mcuSize,
+                                       const QSize& imageSize) {
+  if (sourceRect.isEmpty() || mcuSize.isEmpty() || !isRightAngle(rotation)) {
+    return QRect();
+  }
+
+  // Edges as in [left, right) and [top, bottom).
+  int left = sourceRect.left();
+  int top = sourceRect.top();
+  int right = sourceRect.right() + 1;
+  int bottom = sourceRect.bottom() + 1;
+  const int mcuW = mcuSize.width();
+  const int mcuH = mcuSize.height();
+
+  // The source edges that become the left and the top ones.
+  const bool alignLeft = (rotation == 0) || (rotation == 90);
+  const bool alignTop = (rotation == 0) || (rotation == 270);
+  if (alignLeft) {
+    left -= left % mcuW;
+  } else {
+    right += (mcuW - right % mcuW) % mcuW;
+  }
+  if (alignTop) {
+    top -= top % mcuH;
+  } else {
+    bottom += (mcuH - bottom % mcuH) % mcuH;
+  }
+
+  const QRect aligned(QPoint(left, top), QPoint(right - 1, bottom - 1));
+  if (!QRect(QPoint(0, 0), imageSize).contains(aligned)) {
+    return QRect();
+  }
+  return aligned;
+}  // JpegLosslessTransform::alignCrop
+
+QByteArray JpegLosslessTransform::transform(const QByteArray& jpeg, const QRect& sourceRect, const int rotation) {
+  TransformJob job;
+  if (setjmp(job.errMgr.jmpBuf())) {
+    // Returning from longjmp().
+    return QByteArray();
+  }
+
+  jpeg_decompress_struct& src = job.src;
+  jpeg_compress_struct& dst = job.dst;
+
+  setSource(src, jpeg);
+  saveMarkers(src);
+  if ((jpeg_read_header(&src, TRUE) != JPEG_HEADER_OK) || !isSupported(src)) {
+    return QByteArray();
+  }
+
+  const QSize imageSize(src.image_width, src.image_height);
+  const QSize maxFactors(maxSamplingFactors(src));
+  if (alignCrop(sourceRect, rotation, maxFactors * DCTSIZE, imageSize) != sourceRect) {
+    return QByteArray();
+  }
+
+  const bool transposed = (rotation == 90) || (rotation == 270);
+  const QSize outSize(transposed ? sourceRect.size().transposed() : sourceRect.size());
+  const QSize dstMaxFactors(transposed ? maxFactors.transposed() : maxFactors);
+
+  // The destination arrays have to be requested before the source ones are realized.
+  for (int c = 0; c < src.num_components; ++c) {
+    const QSize factors(transposed ? samplingFactors(src, c).transposed() : samplingFactors(src, c));
+    const JDIMENSION widthInBlocks
+        = divRoundUp(long(outSize.width()) * factors.width(), long(dstMaxFactors.width()) * DCTSIZE);
+    const JDIMENSION heightInBlocks
+        = divRoundUp(long(outSize.height()) * factors.height(), long(dstMaxFactors.height()) * DCTSIZE);
+    const JDIMENSION arrayWidth = roundUp(widthInBlocks, factors.width());
+    const JDIMENSION arrayHeight = roundUp(heightInBlocks, factors.height());
+    job.dstArrays.push_back((*src.mem->request_virt_barray)((j_common_ptr) &src, JPOOL_IMAGE, FALSE, arrayWidth,
+                                                             arrayHeight, JDIMENSION(factors.height())));
+    job.dstArraySizes.emplace_back(arrayWidth, arrayHeight);
+  }
+
+  jvirt_barray_ptr* srcArrays = jpeg_read_coefficients(&src);
+  if (!srcArrays) {
+    return QByteArray();
+  }
+
+  for (int c = 0; c < src.num_components; ++c) {
+    const jpeg_component_info& srcComp = src.comp_info[c];
+    const QSize factors(samplingFactors(src, c));
+    const int blockW = maxFactors.width() * DCTSIZE / factors.width();
+    const int blockH = maxFactors.height() * DCTSIZE / factors.height();
+    // Only the aligned ones of these are used, so the divisions are exact.
+    const int leftBlock = sourceRect.left() / blockW;
+    const int topBlock = sourceRect.top() / blockH;
+    const int rightBlock = (sourceRect.right() + 1) / blockW;
+    const int bottomBlock = (sourceRect.bottom() + 1) / blockH;
+
+    const JDIMENSION dstWidth = job.dstArraySizes[c].first;
+    const JDIMENSION dstHeight = job.dstArraySizes[c].second;
+    for (JDIMENSION dy = 0; dy < dstHeight; ++dy) {
+      JBLOCKARRAY dstRow = (*src.mem->access_virt_barray)((j_common_ptr) &src, job.dstArrays[c], dy, 1, TRUE);
+      for (JDIMENSION dx = 0; dx < dstWidth; ++dx) {
+        long sx = 0;
+        long sy = 0;
+        switch (rotation) {
+          case 90:
+            sx = leftBlock + long(dy);
+            sy = bottomBlock - 1 - long(dx);
+            break;
+          case 180:
+            sx = rightBlock - 1 - long(dx);
+            sy = bottomBlock - 1 - long(dy);
+            break;
+          case 270:
+            sx = rightBlock - 1 - long(dy);
+            sy = topBlock + long(dx);
+            break;
+          default:
+            sx = leftBlock + long(dx);
+            sy = topBlock + long(dy);
+            break;
+        }
+
+        JCOEF* out = dstRow[0][dx];
+        if ((sx < 0) || (sy < 0) || (sx >= long(srcComp.width_in_blocks)) || (sy >= long(srcComp.height_in_blocks))) {
+          // Padding past the edges of the result.
+          std::fill(out, out + DCTSIZE2, JCOEF(0));
+          continue;
+        }
+        JBLOCKARRAY srcRow
+            = (*src.mem->access_virt_barray)((j_common_ptr) &src, srcArrays[c], JDIMENSION(sy), 1, FALSE);
+        transformBlock(srcRow[0][sx], out, rotation);
+      }
+    }
+  }
+
+  jpeg_copy_critical_parameters(&src, &dst);
+  dst.image_width = JDIMENSION(outSize.width());
+  dst.image_height = JDIMENSION(outSize.height());
+  if (transposed) {
+    for (int c = 0; c < dst.num_components; ++c) {
+      std::swap(dst.comp_info[c].h_samp_factor, dst.comp_info[c].v_samp_factor);
+    }
+    std::swap(dst.X_density, dst.Y_density);
+  }
+  // The source Huffman tables aren't carried over anyway.
+  dst.optimize_coding = TRUE;
+
+  jpeg_mem_dest(&dst, &job.outBuffer, &job.outSize);
+  jpeg_write_coefficients(&dst, job.dstArrays.data());
+  copyMarkers(src, dst);
+  jpeg_finish_compress(&dst);
+  jpeg_finish_decompress(&src);
+
+  return QByteArray(reinterpret_cast<const char*>(job.outBuffer), static_cast<int>(job.outSize));
+}  // JpegLosslessTransform::transform
@@ -0,0 +1,66 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#ifndef SCANTAILOR_CORE_JPEGLOSSLESSTRANSFORM_H_
+#define SCANTAILOR_CORE_JPEGLOSSLESSTRANSFORM_H_
+
+#include <QByteArray>
+#include <QRect>
+#include <QSize>
+
+class QTransform;
+
+/**
+ * \brief Rotates JPEG images by multiples of 90 degrees and crops them
+ *        without decoding, the way jpegtran does.
+ *
+ * The DCT coefficients of every block are rearranged and copied into
+ * the new file, so no quality is lost and no time is spent on the IDCT
+ * and the re-encoding.
+ *
+ * The catch is that blocks can't be split, so the crop edges that end up
+ * at the top and the left of the result have to be on iMCU boundaries
+ * of the source.  alignCrop() moves them there.
+ */
+class JpegLosslessTransform {
+ public:
+  /**
+   * \brief Reads the image size and the size of an iMCU from a JPEG header.
+   *
+   * \return False if the data isn't a JPEG this class can transform.
+   */
+  static bool readGeometry(const QByteArray& jpeg, QSize* imageSize, QSize* mcuSize);
+
+  /**
+   * \brief Figures out whether a transformation is a rotation by a multiple
+   *        of 90 degrees followed by an integer translation.
+   *
+   * \param sourceToOutput Maps source image coordinates to those of the output image.
+   * \param outputSize The size of the output image.
+   * \param rotation Receives the clockwise rotation in degrees.
+   * \param sourceRect Receives the area of the source image that maps to the output image.
+   * \return True if that's the case.
+   */
+  static bool decompose(const QTransform& sourceToOutput, const QSize& outputSize, int* rotation, QRect* sourceRect);
+
+  /**
+   * \brief Grows \p sourceRect so that the edges of it that become the top
+   *        and the left ones after a rotation are on iMCU boundaries.
+   *
+   * \return The aligned rectangle, or a null one if it doesn't fit the image.
+   */
+  static QRect alignCrop(const QRect& sourceRect, int rotation, const QSize& mcuSize, const QSize& imageSize);
+
+  /**
+   * \brief Crops the source to \p sourceRect and then rotates it clockwise by \p rotation degrees.
+   *
+   * \p sourceRect has to be aligned already, see alignCrop().  The COM and APPn
+   * markers, like ICC profiles and EXIF data, are copied over.
+   *
+   * \return The resulting JPEG, or an empty array on failure.
+   */
+  static QByteArray transform(const QByteArray& jpeg, const QRect& sourceRect, int rotation);
+};
+
+
+#endif  // ifndef SCANTAILOR_CORE_JPEGLOSSLESSTRANSFORM_H_
@@ -100,7 +100,11 @@ void LoadFileTask::overrideDpi(QImage& image) const {
   image.setDotsPerMeterY(dpm.vertical());
 }
 
-void LoadFileTask::convertToSupportedFormat(QImage& image) const {
+void LoadFileTask::convertToSupportedFormat(QImage& image) {
+  if (FilterData::isBitonalImage(image)) {
+    // Kept as is, see FilterData::isBitonal().
+    return;
+  }
   if (((image.format() == QImage::Format_Indexed8) && !image.isGrayscale()) || (image.depth() > 8)) {
     const QImage::Format fmt = image.hasAlphaChannel() ? QImage::Format_ARGB32 : QImage::Format_RGB32;
     image = image.convertToFormat(fmt);
@@ -35,6 +35,14 @@ class LoadFileTask : public BackgroundTask {
 
   FilterResultPtr operator()() override;
 
+  /**
+   * \brief Converts a loaded image to one of the formats the filters work on.
+   *
+   * Color images become 32-bit, 1-bit black and white ones stay as they are,
+   * and everything else becomes grayscale.
+   */
+  static void convertToSupportedFormat(QImage& image);
+
  private:
   class ErrorResult;
 
@@ -42,8 +50,6 @@ class LoadFileTask : public BackgroundTask {
 
   void overrideDpi(QImage& image) const;
 
-  void convertToSupportedFormat(QImage& image) const;
-
   std::shared_ptr<ThumbnailPixmapCache> m_thumbnailCache;
   ImageId m_imageId;
   ImageMetadata m_imageMetadata;
@@ -3,10 +3,7 @@
 
 #include "OrderByCompletenessProvider.h"
 
-bool OrderByCompletenessProvider::precedes(const PageId&, bool lhsIncomplete, const PageId&, bool rhsIncomplete) const {
-  if (lhsIncomplete != rhsIncomplete) {
-    // Incomplete pages go to the back.
-    return rhsIncomplete;
-  }
-  return true;
+PageOrderKey OrderByCompletenessProvider::sortKey(const PageId&, const bool incomplete) const {
+  // Incomplete pages go to the back.
+  return PageOrderKey(incomplete ? 1 : 0);
 }
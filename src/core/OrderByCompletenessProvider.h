@@ -10,7 +10,7 @@ class OrderByCompletenessProvider : public PageOrderProvider {
  public:
   OrderByCompletenessProvider() = default;
 
-  bool precedes(const PageId&, bool lhsIncomplete, const PageId&, bool rhsIncomplete) const override;
+  PageOrderKey sortKey(const PageId& page, bool incomplete) const override;
 };
 
 
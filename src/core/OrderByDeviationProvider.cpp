@@ -6,13 +6,11 @@
 OrderByDeviationProvider::OrderByDeviationProvider(const DeviationProvider<PageId>& deviationProvider)
     : m_deviationProvider(&deviationProvider) {}
 
-bool OrderByDeviationProvider::precedes(const PageId& lhsPage,
-                                        bool lhsIncomplete,
-                                        const PageId& rhsPage,
-                                        bool rhsIncomplete) const {
-  if (lhsIncomplete != rhsIncomplete) {
-    // Invalid (unknown) sizes go to the back.
-    return lhsIncomplete;
+PageOrderKey OrderByDeviationProvider::sortKey(const PageId& page, const bool incomplete) const {
+  if (incomplete) {
+    // Incomplete pages go to the front.
+    return PageOrderKey(0);
   }
-  return (m_deviationProvider->getDeviationValue(lhsPage) > m_deviationProvider->getDeviationValue(rhsPage));
+  // Greater deviations go first.
+  return PageOrderKey(1, -m_deviationProvider->getDeviationValue(page));
 }
@@ -12,7 +12,7 @@ class OrderByDeviationProvider : public PageOrderProvider {
  public:
   explicit OrderByDeviationProvider(const DeviationProvider<PageId>& deviationProvider);
 
-  bool precedes(const PageId& lhsPage, bool lhsIncomplete, const PageId& rhsPage, bool rhsIncomplete) const override;
+  PageOrderKey sortKey(const PageId& page, bool incomplete) const override;
 
  private:
   const DeviationProvider<PageId>* m_deviationProvider;
@@ -13,6 +13,7 @@
 #include "AbstractRelinker.h"
 #include "PageId.h"
 #include "RelinkablePath.h"
+#include "TiffBookContainer.h"
 
 OutputFileNameGenerator::OutputFileNameGenerator()
     : m_disambiguator(std::make_shared<FileNameDisambiguator>()), m_outDir(), m_layoutDirection(Qt::LeftToRight) {}
@@ -29,6 +30,28 @@ OutputFileNameGenerator::OutputFileNameGenerator(std::shared_ptr<FileNameDisambi
 void OutputFileNameGenerator::performRelinking(const AbstractRelinker& relinker) {
   m_disambiguator->performRelinking(relinker);
   m_outDir = relinker.substitutionPathFor(RelinkablePath(m_outDir, RelinkablePath::Dir));
+  updateBookContainer();
+}
+
+void OutputFileNameGenerator::setOutDir(const QString& outDir) {
+  m_outDir = outDir;
+  updateBookContainer();
+}
+
+void OutputFileNameGenerator::setOutputFormat(const OutputImageFormat format) {
+  m_outputFormat = format;
+  updateBookContainer();
+}
+
+void OutputFileNameGenerator::updateBookContainer() {
+  if ((m_outputFormat != OutputImageFormat::TIFF_BOOK) || m_outDir.isEmpty()) {
+    m_bookContainer.reset();
+    return;
+  }
+  const QString filePath(QDir(m_outDir).absoluteFilePath(QStringLiteral("book.tif")));
+  if (!m_bookContainer || (m_bookContainer->filePath() != filePath)) {
+    m_bookContainer = TiffBookContainer::shared(filePath);
+  }
 }
 
 QString OutputFileNameGenerator::formatExtension() const {
@@ -12,12 +12,15 @@
 
 class PageId;
 class AbstractRelinker;
+class TiffBookContainer;
 
 // Output format enum for file naming
 enum class OutputImageFormat {
   TIFF,
   PNG,
-  JPEG
+  JPEG,
+  // All the pages in a single BigTIFF, see bookContainer().
+  TIFF_BOOK
 };
 
 // TIFF compression options
@@ -41,7 +44,7 @@ class OutputFileNameGenerator {
 
   const QString& outDir() const { return m_outDir; }
 
-  void setOutDir(const QString& outDir) { m_outDir = outDir; }
+  void setOutDir(const QString& outDir);
 
   FileNameDisambiguator* disambiguator() { return m_disambiguator.get(); }
 
@@ -49,7 +52,7 @@ class OutputFileNameGenerator {
 
   // Output format settings
   OutputImageFormat outputFormat() const { return m_outputFormat; }
-  void setOutputFormat(OutputImageFormat format) { m_outputFormat = format; }
+  void setOutputFormat(OutputImageFormat format);
 
   OutputTiffCompression tiffCompression() const { return m_tiffCompression; }
   void setTiffCompression(OutputTiffCompression compression) { m_tiffCompression = compression; }
@@ -68,13 +71,24 @@ class OutputFileNameGenerator {
   // Get file extension for current format (without dot)
   QString formatExtension() const;
 
+  /**
+   * \brief The container the output pages go to instead of their own files.
+   *
+   * Null unless the format is OutputImageFormat::TIFF_BOOK.  The pages are
+   * stored under their fileNameFor() names.
+   */
+  const std::shared_ptr<TiffBookContainer>& bookContainer() const { return m_bookContainer; }
+
  private:
+  void updateBookContainer();
+
   std::shared_ptr<FileNameDisambiguator> m_disambiguator;
   QString m_outDir;
   Qt::LayoutDirection m_layoutDirection;
   OutputImageFormat m_outputFormat = OutputImageFormat::TIFF;
   OutputTiffCompression m_tiffCompression = OutputTiffCompression::LZW;
   int m_jpegQuality = 90;
+  std::shared_ptr<TiffBookContainer> m_bookContainer;
 };
 
 
@@ -0,0 +1,32 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include "PageOrderKey.h"
+
+PageOrderKey PageOrderKey::withPageIdTieBreak(const int rank, const double value, const PageId& pageId) {
+  PageOrderKey key(rank, value);
+  key.m_pageId = pageId;
+  key.m_pageIdOrder = 1;
+  return key;
+}
+
+PageOrderKey PageOrderKey::reversed() const {
+  PageOrderKey key(*this);
+  key.m_rank = -m_rank;
+  key.m_value = -m_value;
+  key.m_pageIdOrder = -m_pageIdOrder;
+  return key;
+}
+
+bool PageOrderKey::operator<(const PageOrderKey& other) const {
+  if (m_rank != other.m_rank) {
+    return m_rank < other.m_rank;
+  }
+  if (m_value != other.m_value) {
+    return m_value < other.m_value;
+  }
+  if ((m_pageIdOrder == 0) || (m_pageIdOrder != other.m_pageIdOrder)) {
+    return false;
+  }
+  return (m_pageIdOrder > 0) ? (m_pageId < other.m_pageId) : (other.m_pageId < m_pageId);
+}
@@ -0,0 +1,46 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#ifndef SCANTAILOR_CORE_PAGEORDERKEY_H_
+#define SCANTAILOR_CORE_PAGEORDERKEY_H_
+
+#include "PageId.h"
+
+/**
+ * \brief The position of a page in some page ordering.
+ *
+ * Keys are compared by rank first, then by value and then, if the key
+ * was built with a PageId tie break, by PageId.  Keys are cheap to copy
+ * and compare, so a page sequence can be sorted without going back to
+ * the settings for every comparison.
+ */
+class PageOrderKey {
+  // Member-wise copying is OK.
+ public:
+  PageOrderKey() = default;
+
+  explicit PageOrderKey(int rank, double value = 0.0) : m_rank(rank), m_value(value) {}
+
+  /**
+   * Keys with an equal rank and value are ordered by \p pageId.
+   */
+  static PageOrderKey withPageIdTieBreak(int rank, double value, const PageId& pageId);
+
+  /**
+   * \brief Returns a key that orders pages in exactly the opposite way.
+   */
+  PageOrderKey reversed() const;
+
+  bool operator<(const PageOrderKey& other) const;
+
+ private:
+  int m_rank = 0;
+  double m_value = 0.0;
+  PageId m_pageId;
+
+  // 1 means ascending PageId order, -1 descending, 0 no tie break.
+  int m_pageIdOrder = 0;
+};
+
+
+#endif  // ifndef SCANTAILOR_CORE_PAGEORDERKEY_H_
@@ -3,13 +3,20 @@
 
 #include "PageOrderProvider.h"
 
+bool PageOrderProvider::precedes(const PageId& lhsPage,
+                                 const bool lhsIncomplete,
+                                 const PageId& rhsPage,
+                                 const bool rhsIncomplete) const {
+  return sortKey(lhsPage, lhsIncomplete) < sortKey(rhsPage, rhsIncomplete);
+}
+
 std::shared_ptr<const PageOrderProvider> PageOrderProvider::reversed() const {
   class ReversedPageOrderProvider : public PageOrderProvider {
    public:
     explicit ReversedPageOrderProvider(const PageOrderProvider* parent) : m_parent(parent->shared_from_this()) {}
 
-    bool precedes(const PageId& lhsPage, bool lhsIncomplete, const PageId& rhsPage, bool rhsIncomplete) const override {
-      return m_parent->precedes(rhsPage, rhsIncomplete, lhsPage, lhsIncomplete);
+    PageOrderKey sortKey(const PageId& page, bool incomplete) const override {
+      return m_parent->sortKey(page, incomplete).reversed();
     }
 
    private:
@@ -6,7 +6,7 @@
 
 #include <memory>
 
-class PageId;
+#include "PageOrderKey.h"
 
 /**
  * A base interface for different page ordering strategies.
@@ -15,12 +15,20 @@ class PageOrderProvider : public std::enable_shared_from_this<PageOrderProvider>
  public:
   virtual ~PageOrderProvider() = default;
 
+  /**
+   * Returns the sort key of a page.  Pages with lesser keys go first.
+   * \p incomplete indicates whether a page is represented by IncompleteThumbnail.
+   */
+  virtual PageOrderKey sortKey(const PageId& page, bool incomplete) const = 0;
+
   /**
    * Returns true if \p lhsPage precedes \p rhsPage.
    * \p lhsIncomplete and \p rhsIncomplete indicate whether
    * a page is represented by IncompleteThumbnail.
+   *
+   * \note When ordering many pages, prefer computing sortKey() once per page.
    */
-  virtual bool precedes(const PageId& lhsPage, bool lhsIncomplete, const PageId& rhsPage, bool rhsIncomplete) const = 0;
+  bool precedes(const PageId& lhsPage, bool lhsIncomplete, const PageId& rhsPage, bool rhsIncomplete) const;
 
   virtual std::shared_ptr<const PageOrderProvider> reversed() const;
 };
@@ -3,29 +3,35 @@
 
 #include "PageSequence.h"
 
+PageSequence::PageSequence() : m_pages(std::make_shared<std::vector<PageInfo>>()) {}
+
 void PageSequence::append(const PageInfo& pageInfo) {
-  m_pages.push_back(pageInfo);
+  if (m_pages.use_count() > 1) {
+    // Leave the other copies alone.
+    m_pages = std::make_shared<std::vector<PageInfo>>(*m_pages);
+  }
+  m_pages->push_back(pageInfo);
 }
 
 size_t PageSequence::numPages() const {
-  return m_pages.size();
+  return m_pages->size();
 }
 
 const PageInfo& PageSequence::pageAt(const size_t idx) const {
-  return m_pages.at(idx);  // may throw
+  return m_pages->at(idx);  // may throw
 }
 
 const PageInfo& PageSequence::pageAt(const PageId page) const {
-  auto it(m_pages.begin());
-  const auto end(m_pages.end());
+  auto it(m_pages->begin());
+  const auto end(m_pages->end());
   for (; it != end && it->id() != page; ++it) {
   }
   return *it;
 }
 
 int PageSequence::pageNo(const PageId& page) const {
-  auto it(m_pages.begin());
-  const auto end(m_pages.end());
+  auto it(m_pages->begin());
+  const auto end(m_pages->end());
   int res = 0;
   for (; it != end && it->id() != page; ++it, ++res) {
   }
@@ -35,7 +41,7 @@ int PageSequence::pageNo(const PageId& page) const {
 std::set<PageId> PageSequence::selectAll() const {
   std::set<PageId> selection;
 
-  for (const PageInfo& pageInfo : m_pages) {
+  for (const PageInfo& pageInfo : *m_pages) {
     selection.insert(pageInfo.id());
   }
   return selection;
@@ -44,8 +50,8 @@ std::set<PageId> PageSequence::selectAll() const {
 std::set<PageId> PageSequence::selectPagePlusFollowers(const PageId& page) const {
   std::set<PageId> selection;
 
-  auto it(m_pages.begin());
-  const auto end(m_pages.end());
+  auto it(m_pages->begin());
+  const auto end(m_pages->end());
   for (; it != end && it->id() != page; ++it) {
     // Continue until we have a match.
   }
@@ -58,8 +64,8 @@ std::set<PageId> PageSequence::selectPagePlusFollowers(const PageId& page) const
 std::set<PageId> PageSequence::selectEveryOther(const PageId& base) const {
   std::set<PageId> selection;
 
-  auto it(m_pages.begin());
-  const auto end(m_pages.end());
+  auto it(m_pages->begin());
+  const auto end(m_pages->end());
   for (; it != end && it->id() != base; ++it) {
     // Continue until we have a match.
   }
@@ -67,9 +73,9 @@ std::set<PageId> PageSequence::selectEveryOther(const PageId& base) const {
     return selection;
   }
 
-  const int baseIdx = static_cast<int>(it - m_pages.begin());
+  const int baseIdx = static_cast<int>(it - m_pages->begin());
   int idx = 0;
-  for (const PageInfo& pageInfo : m_pages) {
+  for (const PageInfo& pageInfo : *m_pages) {
     if (((idx - baseIdx) & 1) == 0) {
       selection.insert(pageInfo.id());
     }
@@ -78,18 +84,10 @@ std::set<PageId> PageSequence::selectEveryOther(const PageId& base) const {
   return selection;
 }
 
-std::vector<PageInfo>::iterator PageSequence::begin() {
-  return m_pages.begin();
-}
-
-std::vector<PageInfo>::iterator PageSequence::end() {
-  return m_pages.end();
-}
-
 std::vector<PageInfo>::const_iterator PageSequence::begin() const {
-  return m_pages.cbegin();
+  return m_pages->cbegin();
 }
 
 std::vector<PageInfo>::const_iterator PageSequence::end() const {
-  return m_pages.cend();
+  return m_pages->cend();
 }
@@ -5,14 +5,24 @@
 #define SCANTAILOR_CORE_PAGESEQUENCE_H_
 
 #include <cstddef>
+#include <memory>
 #include <set>
 #include <vector>
 
 #include "PageInfo.h"
 
+/**
+ * \brief An ordered list of pages.
+ *
+ * Copies share the pages until one of them is appended to, so passing
+ * sequences around by value is cheap.  That's what lets
+ * ProjectPages::toPageSequence() hand out the same snapshot to everyone.
+ */
 class PageSequence {
   // Member-wise copying is OK.
  public:
+  PageSequence();
+
   void append(const PageInfo& pageInfo);
 
   size_t numPages() const;
@@ -29,16 +39,12 @@ class PageSequence {
 
   std::set<PageId> selectEveryOther(const PageId& base) const;
 
-  std::vector<PageInfo>::iterator begin();
-
-  std::vector<PageInfo>::iterator end();
-
   std::vector<PageInfo>::const_iterator begin() const;
 
   std::vector<PageInfo>::const_iterator end() const;
 
  private:
-  std::vector<PageInfo> m_pages;
+  std::shared_ptr<std::vector<PageInfo>> m_pages;
 };
 
 
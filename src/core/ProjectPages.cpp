@@ -41,6 +41,7 @@ ProjectPages::ProjectPages(const std::vector<ImageInfo>& info, const Qt::LayoutD
 
     m_images.push_back(imageDesc);
   }
+  rebuildIndex();
 }
 
 ProjectPages::ProjectPages(const std::vector<ImageFileInfo>& files,
@@ -59,6 +60,7 @@ ProjectPages::ProjectPages(const std::vector<ImageFileInfo>& files,
       m_images.emplace_back(id, metadata, pages);
     }
   }
+  rebuildIndex();
 }
 
 ProjectPages::~ProjectPages() = default;
@@ -82,12 +84,39 @@ void ProjectPages::initSubPagesInOrder(const Qt::LayoutDirection layoutDirection
   }
 }
 
+void ProjectPages::rebuildIndex() {
+  m_indexById.clear();
+  m_indexById.reserve(m_images.size());
+  for (size_t i = 0; i < m_images.size(); ++i) {
+    // Should the same image be there twice, the first one wins, like it did with a linear search.
+    m_indexById.emplace(m_images[i].id, i);
+  }
+}
+
+int ProjectPages::indexOf(const ImageId& imageId) const {
+  const auto it(m_indexById.find(imageId));
+  if (it == m_indexById.end()) {
+    return -1;
+  }
+  return static_cast<int>(it->second);
+}
+
+uint64_t ProjectPages::version() const {
+  QMutexLocker locker(&m_mutex);
+  return m_version;
+}
+
 PageSequence ProjectPages::toPageSequence(const PageView view) const {
-  PageSequence pages;
+  assert(view == IMAGE_VIEW || view == PAGE_VIEW);
 
-  if (view == PAGE_VIEW) {
-    QMutexLocker locker(&m_mutex);
+  QMutexLocker locker(&m_mutex);
+
+  if (m_pageSequenceVersions[view] == m_version) {
+    return m_pageSequences[view];
+  }
 
+  PageSequence pages;
+  if (view == PAGE_VIEW) {
     const auto numImages = static_cast<int>(m_images.size());
     for (int i = 0; i < numImages; ++i) {
       const ImageDesc& image = m_images[i];
@@ -99,10 +128,6 @@ PageSequence ProjectPages::toPageSequence(const PageView view) const {
       }
     }
   } else {
-    assert(view == IMAGE_VIEW);
-
-    QMutexLocker locker(&m_mutex);
-
     const auto numImages = static_cast<int>(m_images.size());
     for (int i = 0; i < numImages; ++i) {
       const ImageDesc& image = m_images[i];
@@ -110,6 +135,9 @@ PageSequence ProjectPages::toPageSequence(const PageView view) const {
       pages.append(PageInfo(id, image.metadata, image.numLogicalPages, image.leftHalfRemoved, image.rightHalfRemoved));
     }
   }
+
+  m_pageSequences[view] = pages;
+  m_pageSequenceVersions[view] = m_version;
   return pages;
 }  // ProjectPages::toPageSequence
 
@@ -140,6 +168,8 @@ void ProjectPages::performRelinking(const AbstractRelinker& relinker) {
     const QString newPath(relinker.substitutionPathFor(oldPath));
     image.id.setFilePath(newPath);
   }
+  rebuildIndex();
+  ++m_version;
 }
 
 void ProjectPages::setLayoutTypeFor(const ImageId& imageId, const LayoutType layout) {
@@ -314,32 +344,30 @@ void ProjectPages::updateMetadataFrom(const std::vector<ImageFileInfo>& files) {
       image.metadata = it->second;
     }
   }
+  ++m_version;
 }
 
 void ProjectPages::setLayoutTypeForImpl(const ImageId& imageId, const LayoutType layout, bool* modified) {
-  const int numPages = (layout == TWO_PAGE_LAYOUT ? 2 : 1);
-  const auto numImages = static_cast<int>(m_images.size());
-  for (int i = 0; i < numImages; ++i) {
-    ImageDesc& image = m_images[i];
-    if (image.id == imageId) {
-      int adjustedNumPages = numPages;
-      if ((numPages == 2) && (image.leftHalfRemoved != image.rightHalfRemoved)) {
-        // Both can't be removed, but we handle that case anyway
-        // by treating it like none are removed.
-        --adjustedNumPages;
-      }
-
-      const int delta = adjustedNumPages - image.numLogicalPages;
-      if (delta == 0) {
-        break;
-      }
+  const int idx = indexOf(imageId);
+  if (idx < 0) {
+    return;
+  }
+  ImageDesc& image = m_images[idx];
 
-      image.numLogicalPages = adjustedNumPages;
+  int numPages = (layout == TWO_PAGE_LAYOUT ? 2 : 1);
+  if ((numPages == 2) && (image.leftHalfRemoved != image.rightHalfRemoved)) {
+    // Both can't be removed, but we handle that case anyway
+    // by treating it like none are removed.
+    --numPages;
+  }
 
-      *modified = true;
-      break;
-    }
+  if (numPages == image.numLogicalPages) {
+    return;
   }
+
+  image.numLogicalPages = numPages;
+  ++m_version;
+  *modified = true;
 }
 
 void ProjectPages::setLayoutTypeForAllPagesImpl(const LayoutType layout, bool* modified) {
@@ -363,44 +391,44 @@ void ProjectPages::setLayoutTypeForAllPagesImpl(const LayoutType layout, bool* m
     image.numLogicalPages = adjustedNumPages;
     *modified = true;
   }
+  if (*modified) {
+    ++m_version;
+  }
 }
 
 void ProjectPages::autoSetLayoutTypeForImpl(const ImageId& imageId, const OrthogonalRotation rotation, bool* modified) {
-  const auto numImages = static_cast<int>(m_images.size());
-  for (int i = 0; i < numImages; ++i) {
-    ImageDesc& image = m_images[i];
-    if (image.id == imageId) {
-      int numPages = adviseNumberOfLogicalPages(image.metadata, rotation);
-      if ((numPages == 2) && (image.leftHalfRemoved != image.rightHalfRemoved)) {
-        // Both can't be removed, but we handle that case anyway
-        // by treating it like none are removed.
-        --numPages;
-      }
-
-      const int delta = numPages - image.numLogicalPages;
-      if (delta == 0) {
-        break;
-      }
+  const int idx = indexOf(imageId);
+  if (idx < 0) {
+    return;
+  }
+  ImageDesc& image = m_images[idx];
 
-      image.numLogicalPages = numPages;
+  int numPages = adviseNumberOfLogicalPages(image.metadata, rotation);
+  if ((numPages == 2) && (image.leftHalfRemoved != image.rightHalfRemoved)) {
+    // Both can't be removed, but we handle that case anyway
+    // by treating it like none are removed.
+    --numPages;
+  }
 
-      *modified = true;
-      break;
-    }
+  if (numPages == image.numLogicalPages) {
+    return;
   }
+
+  image.numLogicalPages = numPages;
+  ++m_version;
+  *modified = true;
 }
 
 void ProjectPages::updateImageMetadataImpl(const ImageId& imageId, const ImageMetadata& metadata, bool* modified) {
-  const auto numImages = static_cast<int>(m_images.size());
-  for (int i = 0; i < numImages; ++i) {
-    ImageDesc& image = m_images[i];
-    if (image.id == imageId) {
-      if (image.metadata != metadata) {
-        image.metadata = metadata;
-        *modified = true;
-      }
-      break;
-    }
+  const int idx = indexOf(imageId);
+  if (idx < 0) {
+    return;
+  }
+  ImageDesc& image = m_images[idx];
+  if (image.metadata != metadata) {
+    image.metadata = metadata;
+    ++m_version;
+    *modified = true;
   }
 }
 
@@ -411,12 +439,9 @@ std::vector<PageInfo> ProjectPages::insertImageImpl(const ImageInfo& newImage,
                                                     bool& modified) {
   std::vector<PageInfo> logicalPages;
 
-  auto it(m_images.begin());
-  const auto end(m_images.end());
-  for (; it != end && it->id != existing; ++it) {
-    // Continue until we find the existing image.
-  }
-  if (it == end) {
+  const int existingIdx = indexOf(existing);
+  auto it(existingIdx < 0 ? m_images.end() : m_images.begin() + existingIdx);
+  if (it == m_images.end()) {
     // Existing image not found.
     if (!((beforeOrAfter == BEFORE) && existing.isNull())) {
       return logicalPages;
@@ -440,6 +465,8 @@ std::vector<PageInfo> ProjectPages::insertImageImpl(const ImageInfo& newImage,
   }
 
   m_images.insert(it, imageDesc);
+  rebuildIndex();
+  ++m_version;
 
   PageInfo pageInfoTempl(PageId(newImage.id(), PageId::SINGLE_PAGE), imageDesc.metadata, imageDesc.numLogicalPages,
                          imageDesc.leftHalfRemoved, imageDesc.rightHalfRemoved);
@@ -494,6 +521,10 @@ void ProjectPages::removePagesImpl(const std::set<PageId>& toRemove, bool& modif
   }
 
   newImages.swap(m_images);
+  if (modified) {
+    rebuildIndex();
+    ++m_version;
+  }
 }  // ProjectPages::removePagesImpl
 
 PageInfo ProjectPages::unremovePageImpl(const PageId& pageId, bool& modified) {
@@ -502,17 +533,13 @@ PageInfo ProjectPages::unremovePageImpl(const PageId& pageId, bool& modified) {
     return PageInfo();
   }
 
-  auto it(m_images.begin());
-  const auto end(m_images.end());
-  for (; it != end && it->id != pageId.imageId(); ++it) {
-    // Continue until we find the corresponding image.
-  }
-  if (it == end) {
+  const int idx = indexOf(pageId.imageId());
+  if (idx < 0) {
     // The corresponding image wasn't found.
     return PageInfo();
   }
 
-  ImageDesc& image = *it;
+  ImageDesc& image = m_images[idx];
 
   if (image.numLogicalPages != 1) {
     return PageInfo();
@@ -527,6 +554,7 @@ PageInfo ProjectPages::unremovePageImpl(const PageId& pageId, bool& modified) {
   }
 
   image.numLogicalPages = 2;
+  ++m_version;
   return PageInfo(pageId, image.metadata, image.numLogicalPages, image.leftHalfRemoved, image.rightHalfRemoved);
 }  // ProjectPages::unremovePageImpl
 
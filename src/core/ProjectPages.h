@@ -9,7 +9,9 @@
 #include <QString>
 #include <Qt>
 #include <cstddef>
+#include <cstdint>
 #include <set>
+#include <unordered_map>
 #include <vector>
 
 #include "BeforeOrAfter.h"
@@ -18,13 +20,13 @@
 #include "NonCopyable.h"
 #include "PageId.h"
 #include "PageInfo.h"
+#include "PageSequence.h"
 #include "PageView.h"
 #include "VirtualFunction.h"
 
 class ImageFileInfo;
 class ImageInfo;
 class OrthogonalRotation;
-class PageSequence;
 class RelinkablePath;
 class AbstractRelinker;
 class QDomElement;
@@ -48,8 +50,20 @@ class ProjectPages : public QObject {
 
   Qt::LayoutDirection layoutDirection() const;
 
+  /**
+   * \brief Returns a snapshot of the pages.
+   *
+   * The snapshot is built once per version and then shared by all the callers,
+   * so calling this often is cheap.  Later modifications don't affect snapshots
+   * already handed out.
+   */
   PageSequence toPageSequence(PageView view) const;
 
+  /**
+   * \brief A number that grows every time the pages are modified.
+   */
+  uint64_t version() const;
+
   void listRelinkablePaths(const VirtualFunction<void, const RelinkablePath&>& sink) const;
 
   /**
@@ -134,6 +148,13 @@ class ProjectPages : public QObject {
 
   void initSubPagesInOrder(Qt::LayoutDirection layoutDirection);
 
+  void rebuildIndex();
+
+  /**
+   * \return The position of the image in m_images or -1 if it's not there.
+   */
+  int indexOf(const ImageId& imageId) const;
+
   void setLayoutTypeForImpl(const ImageId& imageId, LayoutType layout, bool* modified);
 
   void setLayoutTypeForAllPagesImpl(LayoutType layout, bool* modified);
@@ -154,7 +175,12 @@ class ProjectPages : public QObject {
 
   mutable QMutex m_mutex;
   std::vector<ImageDesc> m_images;
+  std::unordered_map<ImageId, size_t> m_indexById;
   PageId::SubPage m_subPagesInOrder[2];
+  uint64_t m_version = 1;
+  // Indexed by PageView.  A zero version means the snapshot hasn't been built yet.
+  mutable PageSequence m_pageSequences[2];
+  mutable uint64_t m_pageSequenceVersions[2] = {0, 0};
 };
 
 
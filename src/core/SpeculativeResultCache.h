@@ -0,0 +1,135 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#ifndef SCANTAILOR_CORE_SPECULATIVERESULTCACHE_H_
+#define SCANTAILOR_CORE_SPECULATIVERESULTCACHE_H_
+
+#include <foundation/NonCopyable.h>
+
+#include <QByteArray>
+#include <QMutex>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+
+/**
+ * \brief Results of work done ahead of the user asking for it.
+ *
+ * Every result is stored along with a fingerprint of the inputs it was
+ * computed from (see InputFingerprint), and is only handed out for the same
+ * fingerprint.  That way a result computed before the user changed something
+ * upstream simply goes unused, without anyone having to track the change.
+ * Stale results are dropped once found, and the oldest ones are evicted
+ * when there are more than \p capacity of them.
+ *
+ * All the methods are thread-safe.
+ */
+template <typename K, typename Result, typename Hash = std::hash<K>>
+class SpeculativeResultCache {
+  DECLARE_NON_COPYABLE(SpeculativeResultCache)
+ public:
+  explicit SpeculativeResultCache(size_t capacity = 16) : m_capacity(capacity) {}
+
+  void store(const K& key, const QByteArray& fingerprint, const Result& result);
+
+  bool contains(const K& key, const QByteArray& fingerprint) const;
+
+  /**
+   * \brief Whether there is a result for \p key, whatever inputs it was computed from.
+   *
+   * Lets the caller skip computing the fingerprint when there is nothing to look up.
+   */
+  bool contains(const K& key) const;
+
+  /**
+   * \brief Looks up a result computed from the same inputs.
+   *
+   * \return True if found, in which case it's copied to \p result.
+   *         A result stored for \p key but for other inputs is dropped.
+   */
+  bool find(const K& key, const QByteArray& fingerprint, Result* result);
+
+  void remove(const K& key);
+
+  void clear();
+
+  size_t size() const;
+
+ private:
+  struct Entry {
+    QByteArray fingerprint;
+    Result result;
+    uint64_t serial;
+  };
+
+  mutable QMutex m_mutex;
+  std::unordered_map<K, Entry, Hash> m_entries;
+  size_t m_capacity;
+  uint64_t m_nextSerial = 0;
+};
+
+
+template <typename K, typename Result, typename Hash>
+void SpeculativeResultCache<K, Result, Hash>::store(const K& key, const QByteArray& fingerprint, const Result& result) {
+  QMutexLocker locker(&m_mutex);
+  m_entries[key] = Entry{fingerprint, result, m_nextSerial++};
+
+  while (m_entries.size() > m_capacity) {
+    auto oldest = m_entries.begin();
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+      if (it->second.serial < oldest->second.serial) {
+        oldest = it;
+      }
+    }
+    m_entries.erase(oldest);
+  }
+}
+
+template <typename K, typename Result, typename Hash>
+bool SpeculativeResultCache<K, Result, Hash>::contains(const K& key, const QByteArray& fingerprint) const {
+  QMutexLocker locker(&m_mutex);
+  const auto it = m_entries.find(key);
+  return (it != m_entries.end()) && (it->second.fingerprint == fingerprint);
+}
+
+template <typename K, typename Result, typename Hash>
+bool SpeculativeResultCache<K, Result, Hash>::contains(const K& key) const {
+  QMutexLocker locker(&m_mutex);
+  return m_entries.find(key) != m_entries.end();
+}
+
+template <typename K, typename Result, typename Hash>
+bool SpeculativeResultCache<K, Result, Hash>::find(const K& key, const QByteArray& fingerprint, Result* result) {
+  QMutexLocker locker(&m_mutex);
+  const auto it = m_entries.find(key);
+  if (it == m_entries.end()) {
+    return false;
+  }
+  if (it->second.fingerprint != fingerprint) {
+    m_entries.erase(it);
+    return false;
+  }
+  *result = it->second.result;
+  return true;
+}
+
+template <typename K, typename Result, typename Hash>
+void SpeculativeResultCache<K, Result, Hash>::remove(const K& key) {
+  QMutexLocker locker(&m_mutex);
+  m_entries.erase(key);
+}
+
+template <typename K, typename Result, typename Hash>
+void SpeculativeResultCache<K, Result, Hash>::clear() {
+  QMutexLocker locker(&m_mutex);
+  m_entries.clear();
+}
+
+template <typename K, typename Result, typename Hash>
+size_t SpeculativeResultCache<K, Result, Hash>::size() const {
+  QMutexLocker locker(&m_mutex);
+  return m_entries.size();
+}
+
+#endif  // ifndef SCANTAILOR_CORE_SPECULATIVERESULTCACHE_H_
@@ -9,7 +9,7 @@ StageSequence::StageSequence(const std::shared_ptr<ProjectPages>& pages,
                              const PageSelectionAccessor& pageSelectionAccessor)
     : m_fixOrientationFilter(std::make_shared<fix_orientation::Filter>(pageSelectionAccessor)),
       m_pageSplitFilter(std::make_shared<page_split::Filter>(pages, pageSelectionAccessor)),
-      m_deskewFilter(std::make_shared<deskew::Filter>(pageSelectionAccessor)),
+      m_deskewFilter(std::make_shared<deskew::Filter>(pages, pageSelectionAccessor)),
       m_pageBoxFilter(std::make_shared<page_box::Filter>(pageSelectionAccessor)),
       m_selectContentFilter(std::make_shared<select_content::Filter>(pageSelectionAccessor)),
       m_pageLayoutFilter(std::make_shared<page_layout::Filter>(pages, pageSelectionAccessor)),
@@ -0,0 +1,165 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include "ThreadPlacement.h"
+
+#include <QMutexLocker>
+#include <algorithm>
+
+#ifdef Q_OS_LINUX
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+// Whether the current thread was pinned by a slot, and therefore needs
+// to be released when the policy no longer asks for pinning.
+thread_local bool t_threadPinned = false;
+
+/**
+ * Takes one CPU set from each group in turn, so that the first N slots
+ * are spread evenly over the groups.
+ */
+std::vector<CpuTopology::CpuSet> interleave(const std::vector<std::vector<CpuTopology::CpuSet>>& groups) {
+  std::vector<CpuTopology::CpuSet> result;
+  size_t longest = 0;
+  for (const auto& group : groups) {
+    longest = std::max(longest, group.size());
+  }
+  for (size_t i = 0; i < longest; ++i) {
+    for (const auto& group : groups) {
+      if (i < group.size()) {
+        result.push_back(group[i]);
+      }
+    }
+  }
+  return result;
+}
+
+/**
+ * One slot per CPU in the domain, each allowed to run anywhere within it.
+ */
+std::vector<CpuTopology::CpuSet> slotsConfinedTo(const CpuTopology::CpuSet& domain) {
+  return std::vector<CpuTopology::CpuSet>(domain.size(), domain);
+}
+}  // namespace
+
+QString threadPlacementPolicyToString(const ThreadPlacementPolicy policy) {
+  switch (policy) {
+    case ThreadPlacementPolicy::ANY_CPU:
+      return "any";
+    case ThreadPlacementPolicy::PHYSICAL_CORES:
+      return "physical-cores";
+    case ThreadPlacementPolicy::SINGLE_L3_DOMAIN:
+      return "l3-domain";
+    case ThreadPlacementPolicy::SINGLE_NUMA_NODE:
+      return "numa-node";
+    case ThreadPlacementPolicy::NODE_LOCAL_PAGES:
+      return "node-local-pages";
+  }
+  return QString();
+}
+
+ThreadPlacementPolicy threadPlacementPolicyFromString(const QString& str, bool* ok) {
+  for (const ThreadPlacementPolicy policy :
+       {ThreadPlacementPolicy::ANY_CPU, ThreadPlacementPolicy::PHYSICAL_CORES, ThreadPlacementPolicy::SINGLE_L3_DOMAIN,
+        ThreadPlacementPolicy::SINGLE_NUMA_NODE, ThreadPlacementPolicy::NODE_LOCAL_PAGES}) {
+    if (str == threadPlacementPolicyToString(policy)) {
+      if (ok) {
+        *ok = true;
+      }
+      return policy;
+    }
+  }
+  if (ok) {
+    *ok = false;
+  }
+  return ThreadPlacementPolicy::ANY_CPU;
+}
+
+/*============================ ThreadPlacement ============================*/
+
+ThreadPlacement::ThreadPlacement(const ThreadPlacementPolicy policy, const CpuTopology& topology)
+    : m_policy(policy), m_allCpus(topology.allCpus()) {
+  if (topology.isNull()) {
+    return;
+  }
+
+  switch (policy) {
+    case ThreadPlacementPolicy::ANY_CPU:
+      break;
+    case ThreadPlacementPolicy::PHYSICAL_CORES:
+      for (const CpuTopology::CpuSet& siblings : topology.physicalCores()) {
+        m_slotCpus.push_back(CpuTopology::CpuSet{siblings.front()});
+      }
+      break;
+    case ThreadPlacementPolicy::SINGLE_L3_DOMAIN:
+      m_slotCpus = slotsConfinedTo(topology.l3Domains().front());
+      break;
+    case ThreadPlacementPolicy::SINGLE_NUMA_NODE:
+      m_slotCpus = slotsConfinedTo(topology.numaNodes().front());
+      break;
+    case ThreadPlacementPolicy::NODE_LOCAL_PAGES: {
+      std::vector<std::vector<CpuTopology::CpuSet>> perNode;
+      for (const CpuTopology::CpuSet& node : topology.numaNodes()) {
+        perNode.push_back(slotsConfinedTo(node));
+      }
+      m_slotCpus = interleave(perNode);
+      break;
+    }
+  }
+  m_slotBusy.resize(m_slotCpus.size(), false);
+}
+
+int ThreadPlacement::acquireSlot() {
+  const QMutexLocker locker(&m_mutex);
+  const auto it = std::find(m_slotBusy.begin(), m_slotBusy.end(), false);
+  if (it == m_slotBusy.end()) {
+    return -1;
+  }
+  *it = true;
+  return static_cast<int>(it - m_slotBusy.begin());
+}
+
+void ThreadPlacement::releaseSlot(const int index) {
+  const QMutexLocker locker(&m_mutex);
+  m_slotBusy[index] = false;
+}
+
+bool ThreadPlacement::pinCurrentThread(const CpuTopology::CpuSet& cpus) {
+#ifdef Q_OS_LINUX
+  if (cpus.empty()) {
+    return false;
+  }
+
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (const int cpu : cpus) {
+    if (cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &set);
+    }
+  }
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+  Q_UNUSED(cpus);
+  return false;
+#endif
+}
+
+/*========================= ThreadPlacement::Slot =========================*/
+
+ThreadPlacement::Slot::Slot(ThreadPlacement& placement) : m_placement(placement), m_index(placement.acquireSlot()) {
+  if (m_index >= 0) {
+    t_threadPinned = pinCurrentThread(m_placement.m_slotCpus[m_index]) || t_threadPinned;
+  } else if (t_threadPinned) {
+    // Pinned under a different policy.
+    pinCurrentThread(m_placement.m_allCpus);
+    t_threadPinned = false;
+  }
+}
+
+ThreadPlacement::Slot::~Slot() {
+  if (m_index >= 0) {
+    m_placement.releaseSlot(m_index);
+  }
+}
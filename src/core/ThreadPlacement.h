@@ -0,0 +1,97 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#ifndef SCANTAILOR_CORE_THREADPLACEMENT_H_
+#define SCANTAILOR_CORE_THREADPLACEMENT_H_
+
+#include <QMutex>
+#include <QString>
+#include <vector>
+
+#include "CpuTopology.h"
+
+enum class ThreadPlacementPolicy {
+  /** Let the OS schedule worker threads freely. */
+  ANY_CPU,
+  /** One worker per physical core, pinned to it, leaving SMT siblings idle. */
+  PHYSICAL_CORES,
+  /** Workers confined to the first L3 cache domain (CCX). */
+  SINGLE_L3_DOMAIN,
+  /** Workers confined to the first NUMA node. */
+  SINGLE_NUMA_NODE,
+  /**
+   * Workers spread over all NUMA nodes, each one confined to its node.
+   * A page is processed start to finish by a single worker, so the buffers
+   * it allocates are first touched, and therefore placed, on that node.
+   */
+  NODE_LOCAL_PAGES
+};
+
+QString threadPlacementPolicyToString(ThreadPlacementPolicy policy);
+
+/**
+ * \return The policy, or ANY_CPU if \p str doesn't name one, in which case *ok is set to false.
+ */
+ThreadPlacementPolicy threadPlacementPolicyFromString(const QString& str, bool* ok = nullptr);
+
+/**
+ * \brief Assigns worker threads to CPU sets according to a ThreadPlacementPolicy.
+ *
+ * The policy translates into a number of slots, each with a CPU set.
+ * A worker acquires a free slot for the duration of a task and pins itself
+ * to its CPU set.  As the pool never runs more threads than there are slots,
+ * a free slot is always available.
+ */
+class ThreadPlacement {
+ public:
+  /**
+   * \brief Pins the current thread to the slot it holds.
+   */
+  class Slot {
+   public:
+    explicit Slot(ThreadPlacement& placement);
+
+    ~Slot();
+
+    Slot(const Slot&) = delete;
+
+    Slot& operator=(const Slot&) = delete;
+
+   private:
+    ThreadPlacement& m_placement;
+    int m_index;
+  };
+
+  ThreadPlacement(ThreadPlacementPolicy policy, const CpuTopology& topology);
+
+  ThreadPlacementPolicy policy() const { return m_policy; }
+
+  /**
+   * \return The maximum number of threads the policy makes sense for,
+   *         or 0 if the policy doesn't restrict it.
+   */
+  int maxThreads() const { return static_cast<int>(m_slotCpus.size()); }
+
+  const std::vector<CpuTopology::CpuSet>& slotCpus() const { return m_slotCpus; }
+
+  /**
+   * \brief Restricts the current thread to the given CPUs.
+   *
+   * \return false if not supported on this platform or the call failed.
+   */
+  static bool pinCurrentThread(const CpuTopology::CpuSet& cpus);
+
+ private:
+  int acquireSlot();
+
+  void releaseSlot(int index);
+
+  ThreadPlacementPolicy m_policy;
+  CpuTopology::CpuSet m_allCpus;
+  std::vector<CpuTopology::CpuSet> m_slotCpus;
+  std::vector<bool> m_slotBusy;
+  QMutex m_mutex;
+};
+
+
+#endif  // ifndef SCANTAILOR_CORE_THREADPLACEMENT_H_
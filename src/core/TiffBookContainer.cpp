@@ -0,0 +1,369 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include "TiffBookContainer.h"
+
+#include <tiffio.h>
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "TiffReader.h"
+#include "TiffWriter.h"
+#include "Utils.h"
+
+namespace {
+struct TiffCloser {
+  void operator()(TIFF* tif) const { TIFFClose(tif); }
+};
+
+using TiffPtr = std::unique_ptr<TIFF, TiffCloser>;
+
+TiffPtr openTiff(const QString& filePath, const char* mode) {
+#ifdef _WIN32
+  return TiffPtr(TIFFOpenW(reinterpret_cast<const wchar_t*>(filePath.utf16()), mode));
+#else
+  return TiffPtr(TIFFOpen(QFile::encodeName(filePath).constData(), mode));
+#endif
+}
+
+const TiffBookContainer::Layer ALL_LAYERS[]
+    = {TiffBookContainer::FOREGROUND_LAYER, TiffBookContainer::BACKGROUND_LAYER,
+       TiffBookContainer::ORIGINAL_BACKGROUND_LAYER, TiffBookContainer::AUTOMASK_LAYER,
+       TiffBookContainer::SPECKLES_LAYER};
+
+bool layerFromName(const QString& name, TiffBookContainer::Layer* layer) {
+  for (const TiffBookContainer::Layer candidate : ALL_LAYERS) {
+    if (TiffBookContainer::layerName(candidate) == name) {
+      *layer = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Writes a page directory followed by its layers as SubIFDs.
+ */
+bool writePageDirectories(TIFF* tif,
+                          const QString& key,
+                          const uint64_t stamp,
+                          const QImage& image,
+                          const TiffBookContainer::Layers& layers) {
+  const QByteArray pageName(key.toUtf8());
+  const QByteArray stampString(QByteArray::number(qulonglong(stamp)));
+  TIFFSetField(tif, TIFFTAG_SUBFILETYPE, uint32_t(FILETYPE_PAGE));
+  TIFFSetField(tif, TIFFTAG_PAGENAME, pageName.constData());
+  TIFFSetField(tif, TIFFTAG_IMAGEDESCRIPTION, stampString.constData());
+  if (!layers.empty()) {
+    // The actual offsets get filled in as the SubIFDs are written.
+    std::vector<toff_t> subIfdOffsets(layers.size(), 0);
+    TIFFSetField(tif, TIFFTAG_SUBIFD, uint16_t(layers.size()), subIfdOffsets.data());
+  }
+  if (!TiffWriter::writeDirectory(tif, image) || !TIFFWriteDirectory(tif)) {
+    return false;
+  }
+
+  for (const auto& layerAndImage : layers) {
+    const QByteArray name(TiffBookContainer::layerName(layerAndImage.first).toLatin1());
+    TIFFSetField(tif, TIFFTAG_PAGENAME, name.constData());
+    if (!TiffWriter::writeDirectory(tif, layerAndImage.second) || !TIFFWriteDirectory(tif)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Fills in a page entry from the current directory of the main chain,
+ * visiting its SubIFDs and returning back to it.
+ *
+ * \return The key of the page, or a null string if the directory isn't a named page.
+ */
+QString readPageEntry(TIFF* tif,
+                      uint64_t offset,
+                      uint64_t& stamp,
+                      std::map<TiffBookContainer::Layer, uint64_t>& layerOffsets) {
+  char* pageName = nullptr;
+  if (!TIFFGetField(tif, TIFFTAG_PAGENAME, &pageName) || !pageName) {
+    return QString();
+  }
+  const QString key(QString::fromUtf8(pageName));
+
+  char* stampString = nullptr;
+  if (TIFFGetField(tif, TIFFTAG_IMAGEDESCRIPTION, &stampString) && stampString) {
+    stamp = QByteArray(stampString).toULongLong();
+  }
+
+  uint16_t subIfdCount = 0;
+  toff_t* subIfds = nullptr;
+  if (TIFFGetField(tif, TIFFTAG_SUBIFD, &subIfdCount, &subIfds) && (subIfdCount > 0)) {
+    // The array belongs to the current directory, which is about to change.
+    const std::vector<toff_t> subIfdOffsets(subIfds, subIfds + subIfdCount);
+    for (const toff_t subIfdOffset : subIfdOffsets) {
+      if (!TIFFSetSubDirectory(tif, subIfdOffset)) {
+        continue;
+      }
+      char* name = nullptr;
+      TiffBookContainer::Layer layer;
+      if (TIFFGetField(tif, TIFFTAG_PAGENAME, &name) && name && layerFromName(QString::fromLatin1(name), &layer)) {
+        layerOffsets[layer] = subIfdOffset;
+      }
+    }
+    TIFFSetSubDirectory(tif, offset);
+  }
+  return key;
+}
+}  // namespace
+
+TiffBookContainer::TiffBookContainer(const QString& filePath) : m_filePath(filePath) {
+  m_valid = loadIndex();
+}
+
+std::shared_ptr<TiffBookContainer> TiffBookContainer::shared(const QString& filePath) {
+  static QMutex mutex;
+  static std::map<QString, std::weak_ptr<TiffBookContainer>> containers;
+
+  const QMutexLocker locker(&mutex);
+  std::weak_ptr<TiffBookContainer>& weakContainer = containers[QFileInfo(filePath).absoluteFilePath()];
+  std::shared_ptr<TiffBookContainer> container(weakContainer.lock());
+  if (!container) {
+    container = std::make_shared<TiffBookContainer>(filePath);
+    weakContainer = container;
+  }
+  return container;
+}
+
+QString TiffBookContainer::layerName(const Layer layer) {
+  switch (layer) {
+    case FOREGROUND_LAYER:
+      return "foreground";
+    case BACKGROUND_LAYER:
+      return "background";
+    case ORIGINAL_BACKGROUND_LAYER:
+      return "original_background";
+    case AUTOMASK_LAYER:
+      return "automask";
+    case SPECKLES_LAYER:
+      return "speckles";
+  }
+  return QString();
+}
+
+bool TiffBookContainer::isValid() const {
+  const QMutexLocker locker(&m_mutex);
+  return m_valid;
+}
+
+int TiffBookContainer::pageCount() const {
+  const QMutexLocker locker(&m_mutex);
+  return m_index.size();
+}
+
+bool TiffBookContainer::contains(const QString& key) const {
+  const QMutexLocker locker(&m_mutex);
+  return m_index.contains(key);
+}
+
+bool TiffBookContainer::loadIndex() {
+  m_index.clear();
+  m_lastOffset = 0;
+  m_chainLength = 0;
+  // Starting from the current time keeps a recreated file from handing out
+  // the stamps a project might still have recorded for the old one.
+  m_nextStamp = static_cast<uint64_t>(std::max<qint64>(1, QDateTime::currentMSecsSinceEpoch()));
+
+  if (!QFileInfo::exists(m_filePath)) {
+    return true;
+  }
+
+  const TiffPtr tif(openTiff(m_filePath, "r"));
+  if (!tif) {
+    return false;
+  }
+
+  do {
+    PageEntry entry;
+    entry.offset = TIFFCurrentDirOffset(tif.get());
+    entry.chainIndex = m_chainLength++;
+    m_lastOffset = entry.offset;
+
+    const QString key(readPageEntry(tif.get(), entry.offset, entry.stamp, entry.layerOffsets));
+    m_nextStamp = std::max(m_nextStamp, entry.stamp + 1);
+    if (!key.isNull()) {
+      // An earlier directory with the same key is one whose replacement was interrupted.
+      m_index.insert(key, std::move(entry));
+    }
+  } while (TIFFReadDirectory(tif.get()));
+  return true;
+}
+
+uint64_t TiffBookContainer::pageStamp(const QString& key) const {
+  const QMutexLocker locker(&m_mutex);
+  const auto it = m_index.constFind(key);
+  return (it == m_index.constEnd()) ? 0 : it->stamp;
+}
+
+bool TiffBookContainer::hasLayer(const QString& key, const Layer layer) const {
+  const QMutexLocker locker(&m_mutex);
+  const auto it = m_index.constFind(key);
+  return (it != m_index.constEnd()) && (it->layerOffsets.count(layer) != 0);
+}
+
+QStringList TiffBookContainer::keys() const {
+  const QMutexLocker locker(&m_mutex);
+  return keysLocked();
+}
+
+QStringList TiffBookContainer::keysLocked() const {
+  std::vector<std::pair<int, QString>> ordered;
+  ordered.reserve(m_index.size());
+  for (auto it = m_index.constBegin(); it != m_index.constEnd(); ++it) {
+    ordered.emplace_back(it->chainIndex, it.key());
+  }
+  std::sort(ordered.begin(), ordered.end());
+
+  QStringList keys;
+  for (const auto& indexAndKey : ordered) {
+    keys.push_back(indexAndKey.second);
+  }
+  return keys;
+}
+
+QImage TiffBookContainer::readPage(const QString& key) const {
+  const QMutexLocker locker(&m_mutex);
+  const auto it = m_index.constFind(key);
+  if (it == m_index.constEnd()) {
+    return QImage();
+  }
+  return readDirectory(it->offset);
+}
+
+QImage TiffBookContainer::readLayer(const QString& key, const Layer layer) const {
+  const QMutexLocker locker(&m_mutex);
+  const auto it = m_index.constFind(key);
+  if (it == m_index.constEnd()) {
+    return QImage();
+  }
+  const auto layerIt = it->layerOffsets.find(layer);
+  if (layerIt == it->layerOffsets.end()) {
+    return QImage();
+  }
+  return readDirectory(layerIt->second);
+}
+
+QImage TiffBookContainer::readDirectory(const uint64_t offset) const {
+  QFile file(m_filePath);
+  if (!file.open(QIODevice::ReadOnly)) {
+    return QImage();
+  }
+  return TiffReader::readImageAtOffset(file, offset);
+}
+
+bool TiffBookContainer::writePage(const QString& key, const QImage& image, const Layers& layers) {
+  const QMutexLocker locker(&m_mutex);
+  if (!m_valid || key.isEmpty() || image.isNull()) {
+    return false;
+  }
+
+  const uint64_t stamp = m_nextStamp++;
+  {
+    // New directories get linked to the end of the chain in the append mode.
+    const bool appending = m_chainLength > 0;
+    const TiffPtr tif(openTiff(m_filePath, appending ? "a" : "w8"));
+    if (!tif || !writePageDirectories(tif.get(), key, stamp, image, layers)) {
+      m_valid = loadIndex();
+      return false;
+    }
+  }
+
+  PageEntry entry;
+  entry.chainIndex = m_chainLength;
+  {
+    // The new directory is the one following the former last one,
+    // so there is no need to walk the chain.
+    const TiffPtr tif(openTiff(m_filePath, "r"));
+    if (!tif) {
+      m_valid = loadIndex();
+      return false;
+    }
+    if (m_chainLength > 0) {
+      if (!TIFFSetSubDirectory(tif.get(), m_lastOffset) || !TIFFReadDirectory(tif.get())) {
+        m_valid = loadIndex();
+        return false;
+      }
+    }
+    entry.offset = TIFFCurrentDirOffset(tif.get());
+    readPageEntry(tif.get(), entry.offset, entry.stamp, entry.layerOffsets);
+  }
+  m_lastOffset = entry.offset;
+  ++m_chainLength;
+
+  const auto oldIt = m_index.find(key);
+  if (oldIt != m_index.end()) {
+    const int oldChainIndex = oldIt->chainIndex;
+    m_index.erase(oldIt);
+
+    bool unlinked = false;
+    {
+      const TiffPtr tif(openTiff(m_filePath, "r+"));
+      // Directory numbers are 1-based here.
+      unlinked = tif && TIFFUnlinkDirectory(tif.get(), static_cast<tdir_t>(oldChainIndex + 1));
+    }
+    if (unlinked) {
+      --m_chainLength;
+      --entry.chainIndex;
+      for (PageEntry& other : m_index) {
+        if (other.chainIndex > oldChainIndex) {
+          --other.chainIndex;
+        }
+      }
+    }
+    // Otherwise the old directory stays in the chain, shadowed by the new one.
+  }
+
+  m_index.insert(key, std::move(entry));
+  return true;
+}  // TiffBookContainer::writePage
+
+bool TiffBookContainer::compact() {
+  const QMutexLocker locker(&m_mutex);
+  if (!m_valid) {
+    return false;
+  }
+  if (m_chainLength == 0) {
+    return true;
+  }
+
+  const QString tempFilePath(m_filePath + ".compact");
+  bool ok = true;
+  {
+    const TiffPtr tif(openTiff(tempFilePath, "w8"));
+    ok = static_cast<bool>(tif);
+    for (const QString& key : keysLocked()) {
+      if (!ok) {
+        break;
+      }
+      const PageEntry entry(m_index.value(key));
+      Layers layers;
+      for (const auto& layerAndOffset : entry.layerOffsets) {
+        layers[layerAndOffset.first] = readDirectory(layerAndOffset.second);
+      }
+      ok = writePageDirectories(tif.get(), key, entry.stamp, readDirectory(entry.offset), layers);
+    }
+  }
+
+  if (!ok || !Utils::overwritingRename(tempFilePath, m_filePath)) {
+    QFile::remove(tempFilePath);
+    return false;
+  }
+
+  m_valid = loadIndex();
+  return m_valid;
+}  // TiffBookContainer::compact
@@ -0,0 +1,141 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#ifndef SCANTAILOR_CORE_TIFFBOOKCONTAINER_H_
+#define SCANTAILOR_CORE_TIFFBOOKCONTAINER_H_
+
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <cstdint>
+#include <map>
+#include <memory>
+
+#include "NonCopyable.h"
+
+/**
+ * \brief Keeps all the output pages of a project in a single BigTIFF file.
+ *
+ * Every page is a directory (IFD) of the main chain, named by its key through
+ * the PageName tag.  The split output layers of a page are stored as SubIFDs
+ * of the page's directory.
+ *
+ * Replacing a page appends a new directory and only then unlinks the old one
+ * from the chain, so the file is never left without the page.  Should the
+ * unlinking not happen, the last directory with a given key wins.  The data
+ * of unlinked directories stays in the file until compact() is called.
+ *
+ * The object keeps an index of the pages, built once when it's constructed
+ * and kept up to date by writePage() and compact(), so looking up a page
+ * doesn't touch the file.  Every page also carries a stamp, kept in its
+ * ImageDescription tag, which is what tells one version of a page from
+ * another, even after compacting.
+ *
+ * All the member functions may be called concurrently.  Two objects must not
+ * be writing to the same file though.
+ */
+class TiffBookContainer {
+  DECLARE_NON_COPYABLE(TiffBookContainer)
+
+ public:
+  enum Layer { FOREGROUND_LAYER, BACKGROUND_LAYER, ORIGINAL_BACKGROUND_LAYER, AUTOMASK_LAYER, SPECKLES_LAYER };
+
+  using Layers = std::map<Layer, QImage>;
+
+  /**
+   * \brief Opens the container and builds its index.
+   *
+   * The file doesn't have to exist.  It will be created by the first writePage().
+   */
+  explicit TiffBookContainer(const QString& filePath);
+
+  /**
+   * \brief Returns the object for \p filePath shared by everyone writing to it.
+   *
+   * A new one is made if no one holds the one made before.
+   */
+  static std::shared_ptr<TiffBookContainer> shared(const QString& filePath);
+
+  const QString& filePath() const { return m_filePath; }
+
+  /**
+   * \brief Returns false if the file exists but couldn't be read as a TIFF.
+   */
+  bool isValid() const;
+
+  int pageCount() const;
+
+  bool contains(const QString& key) const;
+
+  /**
+   * \brief Returns a value that changes every time the page is written,
+   *        or 0 if there is no such page.
+   *
+   * The value is kept by compact().
+   */
+  uint64_t pageStamp(const QString& key) const;
+
+  bool hasLayer(const QString& key, Layer layer) const;
+
+  /**
+   * \brief The keys of the pages, in the order they are stored in.
+   */
+  QStringList keys() const;
+
+  /**
+   * \return The page, or a null image if there is no such page or it couldn't be read.
+   */
+  QImage readPage(const QString& key) const;
+
+  /**
+   * \return The layer, or a null image if there is no such layer or it couldn't be read.
+   */
+  QImage readLayer(const QString& key, Layer layer) const;
+
+  /**
+   * \brief Adds a page, or replaces the page with the same key.
+   *
+   * \return True on success, false on failure.
+   */
+  bool writePage(const QString& key, const QImage& image, const Layers& layers = Layers());
+
+  /**
+   * \brief Rewrites the file without the data of the replaced pages.
+   *
+   * The file is replaced atomically, so it stays intact if compacting fails.
+   *
+   * \return True on success, false on failure.
+   */
+  bool compact();
+
+  static QString layerName(Layer layer);
+
+ private:
+  struct PageEntry {
+    uint64_t offset = 0;
+    uint64_t stamp = 0;
+    int chainIndex = 0;
+    std::map<Layer, uint64_t> layerOffsets;
+  };
+
+  bool loadIndex();
+
+  QStringList keysLocked() const;
+
+  QImage readDirectory(uint64_t offset) const;
+
+  mutable QMutex m_mutex;
+  QString m_filePath;
+  QHash<QString, PageEntry> m_index;
+  /** The offset of the last directory of the main chain. */
+  uint64_t m_lastOffset = 0;
+  /** The number of directories in the main chain, including the unnamed ones. */
+  int m_chainLength = 0;
+  uint64_t m_nextStamp = 1;
+  bool m_valid = true;
+};
+
+
+#endif  // ifndef SCANTAILOR_CORE_TIFFBOOKCONTAINER_H_
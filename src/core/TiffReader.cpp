@@ -9,8 +9,10 @@
 #include <QDebug>
 #include <QIODevice>
 #include <QImage>
+#include <atomic>
 #include <cassert>
 #include <cmath>
+#include <cstdint>
 
 #include "Dpm.h"
 #include "ImageMetadata.h"
@@ -241,7 +243,37 @@ static void convertAbgrToArgb(const uint32_t* src, uint32_t* dst, int count) {
   }
 }
 
+static std::atomic<int> allocationLimitMb(0);
+
+void TiffReader::setAllocationLimit(const int megabytes) {
+  allocationLimitMb = megabytes;
+}
+
+int TiffReader::allocationLimit() {
+  return allocationLimitMb;
+}
+
+static bool exceedsAllocationLimit(const int width, const int height, const int bitsPerPixel) {
+  const int limitMb = allocationLimitMb;
+  if (limitMb <= 0) {
+    return false;
+  }
+  const uint64_t bytesPerLine = (uint64_t(width) * bitsPerPixel + 31) / 32 * 4;
+  return bytesPerLine * uint64_t(height) > uint64_t(limitMb) * 1024 * 1024;
+}
+
 QImage TiffReader::readImage(QIODevice& device, const int pageNum) {
+  return readImageImpl(device, pageNum, 0);
+}
+
+QImage TiffReader::readImageAtOffset(QIODevice& device, const uint64_t directoryOffset) {
+  if (directoryOffset == 0) {
+    return QImage();
+  }
+  return readImageImpl(device, 0, directoryOffset);
+}
+
+QImage TiffReader::readImageImpl(QIODevice& device, const int pageNum, const uint64_t directoryOffset) {
   if (!device.isReadable()) {
     return QImage();
   }
@@ -261,12 +293,21 @@ QImage TiffReader::readImage(QIODevice& device, const int pageNum) {
     return QImage();
   }
 
-  if (!TIFFSetDirectory(tif.handle(), (uint16_t) pageNum)) {
+  if (directoryOffset != 0) {
+    if (!TIFFSetSubDirectory(tif.handle(), directoryOffset)) {
+      return QImage();
+    }
+  } else if (!TIFFSetDirectory(tif.handle(), (uint16_t) pageNum)) {
     return QImage();
   }
 
   const TiffInfo info(tif, header);
 
+  const int bitsPerPixel = info.mapsToBinaryOrIndexed8() ? ((info.bitsPerSample == 1) ? 1 : 8) : 32;
+  if (exceedsAllocationLimit(info.width, info.height, bitsPerPixel)) {
+    return QImage();
+  }
+
   const ImageMetadata metadata(currentPageMetadata(tif));
 
   QImage image;
@@ -316,7 +357,7 @@ QImage TiffReader::readImage(QIODevice& device, const int pageNum) {
     image.setDotsPerMeterY(dpm.vertical());
   }
   return image;
-}  // TiffReader::readImage
+}  // TiffReader::readImageImpl
 
 TiffReader::TiffHeader TiffReader::readHeader(QIODevice& device) {
   unsigned char data[4];
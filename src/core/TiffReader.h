@@ -4,6 +4,8 @@
 #ifndef SCANTAILOR_CORE_TIFFREADER_H_
 #define SCANTAILOR_CORE_TIFFREADER_H_
 
+#include <cstdint>
+
 #include "ImageMetadataLoader.h"
 #include "VirtualFunction.h"
 
@@ -30,6 +32,29 @@ class TiffReader {
    */
   static QImage readImage(QIODevice& device, int pageNum = 0);
 
+  /**
+   * \brief Limits the memory a decoded image may take.
+   *
+   * Images that would take more aren't decoded at all.  libtiff doesn't go
+   * through QImageReader, so QImageReader::setAllocationLimit() doesn't
+   * cover TIFF files.
+   *
+   * \param megabytes The limit, or 0 for no limit, which is the default.
+   */
+  static void setAllocationLimit(int megabytes);
+
+  static int allocationLimit();
+
+  /**
+   * \brief Reads the image from the directory (IFD) at the given file offset.
+   *
+   * This makes it possible to read SubIFDs and directories unlinked
+   * from the main chain, as well as to skip walking the chain.
+   *
+   * \return The resulting image, or a null image in case of failure.
+   */
+  static QImage readImageAtOffset(QIODevice& device, uint64_t directoryOffset);
+
  private:
   class TiffHeader;
   class TiffHandle;
@@ -43,6 +68,12 @@ class TiffReader {
 
   static bool checkHeader(const TiffHeader& header);
 
+  /**
+   * Reads the directory at \p directoryOffset, or, if it's zero,
+   * the \p pageNum'th directory of the main chain.
+   */
+  static QImage readImageImpl(QIODevice& device, int pageNum, uint64_t directoryOffset);
+
   static ImageMetadata currentPageMetadata(const TiffHandle& tif);
 
   static Dpi getDpi(float xres, float yres, unsigned resUnit);
@@ -158,10 +158,18 @@ bool TiffWriter::writeImage(QIODevice& device, const QImage& image) {
     return false;
   }
 
-  TIFFSetField(tif.handle(), TIFFTAG_IMAGEWIDTH, uint32_t(image.width()));
-  TIFFSetField(tif.handle(), TIFFTAG_IMAGELENGTH, uint32_t(image.height()));
-  TIFFSetField(tif.handle(), TIFFTAG_SAMPLEFORMAT, SAMPLEFORMAT_UINT);
-  TIFFSetField(tif.handle(), TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+  return writeDirectory(tif.handle(), image);
+}  // TiffWriter::writeImage
+
+bool TiffWriter::writeDirectory(TIFF* tif, const QImage& image) {
+  if (image.isNull()) {
+    return false;
+  }
+
+  TIFFSetField(tif, TIFFTAG_IMAGEWIDTH, uint32_t(image.width()));
+  TIFFSetField(tif, TIFFTAG_IMAGELENGTH, uint32_t(image.height()));
+  TIFFSetField(tif, TIFFTAG_SAMPLEFORMAT, SAMPLEFORMAT_UINT);
+  TIFFSetField(tif, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
   setDpm(tif, Dpm(image));
 
   switch (image.format()) {
@@ -176,12 +184,12 @@ bool TiffWriter::writeImage(QIODevice& device, const QImage& image) {
   } else {
     return writeRGB32Image(tif, image.convertToFormat(QImage::Format_RGB32));
   }
-}  // TiffWriter::writeImage
+}  // TiffWriter::writeDirectory
 
 /**
  * Set the physical resolution, if it's defined.
  */
-void TiffWriter::setDpm(const TiffHandle& tif, const Dpm& dpm) {
+void TiffWriter::setDpm(TIFF* tif, const Dpm& dpm) {
   using namespace constants;
 
   if (dpm.isNull()) {
@@ -204,13 +212,13 @@ void TiffWriter::setDpm(const TiffHandle& tif, const Dpm& dpm) {
     unit = RESUNIT_INCH;
   }
 
-  TIFFSetField(tif.handle(), TIFFTAG_XRESOLUTION, xres);
-  TIFFSetField(tif.handle(), TIFFTAG_YRESOLUTION, yres);
-  TIFFSetField(tif.handle(), TIFFTAG_RESOLUTIONUNIT, unit);
+  TIFFSetField(tif, TIFFTAG_XRESOLUTION, xres);
+  TIFFSetField(tif, TIFFTAG_YRESOLUTION, yres);
+  TIFFSetField(tif, TIFFTAG_RESOLUTIONUNIT, unit);
 }
 
-bool TiffWriter::writeBitonalOrIndexed8Image(const TiffHandle& tif, const QImage& image) {
-  TIFFSetField(tif.handle(), TIFFTAG_SAMPLESPERPIXEL, uint16_t(1));
+bool TiffWriter::writeBitonalOrIndexed8Image(TIFF* tif, const QImage& image) {
+  TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, uint16_t(1));
 
   uint16_t bitsPerSample = 8;
   uint16_t photometric = PHOTOMETRIC_PALETTE;
@@ -241,15 +249,15 @@ bool TiffWriter::writeBitonalOrIndexed8Image(const TiffHandle& tif, const QImage
   }
 
   if (image.format() == QImage::Format_Indexed8) {
-    TIFFSetField(tif.handle(), TIFFTAG_COMPRESSION,
+    TIFFSetField(tif, TIFFTAG_COMPRESSION,
                  uint16_t(ApplicationSettings::getInstance().getTiffColorCompression()));
   } else {
-    TIFFSetField(tif.handle(), TIFFTAG_COMPRESSION,
+    TIFFSetField(tif, TIFFTAG_COMPRESSION,
                  uint16_t(ApplicationSettings::getInstance().getTiffBwCompression()));
   }
 
-  TIFFSetField(tif.handle(), TIFFTAG_BITSPERSAMPLE, bitsPerSample);
-  TIFFSetField(tif.handle(), TIFFTAG_PHOTOMETRIC, photometric);
+  TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE, bitsPerSample);
+  TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, photometric);
 
   if (photometric == PHOTOMETRIC_PALETTE) {
     const int numColors = 1 << bitsPerSample;
@@ -266,7 +274,7 @@ bool TiffWriter::writeBitonalOrIndexed8Image(const TiffHandle& tif, const QImage
       pg[i] = static_cast<unsigned short>((0xFFFF * qGreen(rgb) + 128) / 255);
       pb[i] = static_cast<unsigned short>((0xFFFF * qBlue(rgb) + 128) / 255);
     }
-    TIFFSetField(tif.handle(), TIFFTAG_COLORMAP, &pr[0], &pg[0], &pb[0]);
+    TIFFSetField(tif, TIFFTAG_COLORMAP, &pr[0], &pg[0], &pb[0]);
   }
 
   if (image.format() == QImage::Format_Indexed8) {
@@ -280,19 +288,19 @@ bool TiffWriter::writeBitonalOrIndexed8Image(const TiffHandle& tif, const QImage
   }
 }  // TiffWriter::writeBitonalOrIndexed8Image
 
-bool TiffWriter::writeRGB32Image(const TiffHandle& tif, const QImage& image) {
+bool TiffWriter::writeRGB32Image(TIFF* tif, const QImage& image) {
   assert(image.format() == QImage::Format_RGB32);
 
-  TIFFSetField(tif.handle(), TIFFTAG_SAMPLESPERPIXEL, uint16_t(3));
-  TIFFSetField(tif.handle(), TIFFTAG_COMPRESSION,
+  TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, uint16_t(3));
+  TIFFSetField(tif, TIFFTAG_COMPRESSION,
                uint16_t(ApplicationSettings::getInstance().getTiffColorCompression()));
-  TIFFSetField(tif.handle(), TIFFTAG_BITSPERSAMPLE, uint16_t(8));
-  TIFFSetField(tif.handle(), TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
+  TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE, uint16_t(8));
+  TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
 
   const int width = image.width();
   const int height = image.height();
-  const uint32_t rowsPerStrip = TIFFDefaultStripSize(tif.handle(), 0);
-  TIFFSetField(tif.handle(), TIFFTAG_ROWSPERSTRIP, rowsPerStrip);
+  const uint32_t rowsPerStrip = TIFFDefaultStripSize(tif, 0);
+  TIFFSetField(tif, TIFFTAG_ROWSPERSTRIP, rowsPerStrip);
 
   const uint32_t stripRows = std::max<uint32_t>(1, rowsPerStrip);
   std::vector<uint8_t> tmpStrip(width * stripRows * 3);
@@ -315,26 +323,26 @@ bool TiffWriter::writeRGB32Image(const TiffHandle& tif, const QImage& image) {
     }
     const tstrip_t stripIndex = static_cast<tstrip_t>(stripStart / stripRows);
     const tsize_t byteCount = static_cast<tsize_t>(rows) * width * 3;
-    if (TIFFWriteEncodedStrip(tif.handle(), stripIndex, tmpStrip.data(), byteCount) == -1) {
+    if (TIFFWriteEncodedStrip(tif, stripIndex, tmpStrip.data(), byteCount) == -1) {
       return false;
     }
   }
   return true;
 }  // TiffWriter::writeRGB32Image
 
-bool TiffWriter::writeARGB32Image(const TiffHandle& tif, const QImage& image) {
+bool TiffWriter::writeARGB32Image(TIFF* tif, const QImage& image) {
   assert(image.format() == QImage::Format_ARGB32);
 
-  TIFFSetField(tif.handle(), TIFFTAG_SAMPLESPERPIXEL, uint16_t(4));
-  TIFFSetField(tif.handle(), TIFFTAG_COMPRESSION,
+  TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, uint16_t(4));
+  TIFFSetField(tif, TIFFTAG_COMPRESSION,
                uint16_t(ApplicationSettings::getInstance().getTiffColorCompression()));
-  TIFFSetField(tif.handle(), TIFFTAG_BITSPERSAMPLE, uint16_t(8));
-  TIFFSetField(tif.handle(), TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
+  TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE, uint16_t(8));
+  TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
 
   const int width = image.width();
   const int height = image.height();
-  const uint32_t rowsPerStrip = TIFFDefaultStripSize(tif.handle(), 0);
-  TIFFSetField(tif.handle(), TIFFTAG_ROWSPERSTRIP, rowsPerStrip);
+  const uint32_t rowsPerStrip = TIFFDefaultStripSize(tif, 0);
+  TIFFSetField(tif, TIFFTAG_ROWSPERSTRIP, rowsPerStrip);
 
   const uint32_t stripRows = std::max<uint32_t>(1, rowsPerStrip);
   std::vector<uint8_t> tmpStrip(width * stripRows * 4);
@@ -358,14 +366,14 @@ bool TiffWriter::writeARGB32Image(const TiffHandle& tif, const QImage& image) {
     }
     const tstrip_t stripIndex = static_cast<tstrip_t>(stripStart / stripRows);
     const tsize_t byteCount = static_cast<tsize_t>(rows) * width * 4;
-    if (TIFFWriteEncodedStrip(tif.handle(), stripIndex, tmpStrip.data(), byteCount) == -1) {
+    if (TIFFWriteEncodedStrip(tif, stripIndex, tmpStrip.data(), byteCount) == -1) {
       return false;
     }
   }
   return true;
 }  // TiffWriter::writeARGB32Image
 
-bool TiffWriter::write8bitLines(const TiffHandle& tif, const QImage& image) {
+bool TiffWriter::write8bitLines(TIFF* tif, const QImage& image) {
   const int width = image.width();
   const int height = image.height();
 
@@ -377,14 +385,14 @@ bool TiffWriter::write8bitLines(const TiffHandle& tif, const QImage& image) {
   for (int y = 0; y < height; ++y) {
     const uint8_t* srcLine = image.scanLine(y);
     memcpy(&tmpLine[0], srcLine, tmpLine.size());
-    if (TIFFWriteScanline(tif.handle(), &tmpLine[0], y) == -1) {
+    if (TIFFWriteScanline(tif, &tmpLine[0], y) == -1) {
       return false;
     }
   }
   return true;
 }
 
-bool TiffWriter::writeBinaryLinesAsIs(const TiffHandle& tif, const QImage& image) {
+bool TiffWriter::writeBinaryLinesAsIs(TIFF* tif, const QImage& image) {
   const int width = image.width();
   const int height = image.height();
   // TIFFWriteScanline() can actually modify the data you pass it,
@@ -396,14 +404,14 @@ bool TiffWriter::writeBinaryLinesAsIs(const TiffHandle& tif, const QImage& image
   for (int y = 0; y < height; ++y) {
     const uint8_t* srcLine = image.scanLine(y);
     memcpy(&tmpLine[0], srcLine, bpl);
-    if (TIFFWriteScanline(tif.handle(), &tmpLine[0], y) == -1) {
+    if (TIFFWriteScanline(tif, &tmpLine[0], y) == -1) {
       return false;
     }
   }
   return true;
 }
 
-bool TiffWriter::writeBinaryLinesReversed(const TiffHandle& tif, const QImage& image) {
+bool TiffWriter::writeBinaryLinesReversed(TIFF* tif, const QImage& image) {
   const int width = image.width();
   const int height = image.height();
 
@@ -415,7 +423,7 @@ bool TiffWriter::writeBinaryLinesReversed(const TiffHandle& tif, const QImage& i
     for (int i = 0; i < bpl; ++i) {
       tmpLine[i] = m_reverseBitsLUT[srcLine[i]];
     }
-    if (TIFFWriteScanline(tif.handle(), &tmpLine[0], y) == -1) {
+    if (TIFFWriteScanline(tif, &tmpLine[0], y) == -1) {
       return false;
     }
   }
@@ -5,6 +5,7 @@
 #define SCANTAILOR_CORE_TIFFWRITER_H_
 
 #include <tiff.h>
+#include <tiffio.h>
 
 #include <cstddef>
 #include <cstdint>
@@ -35,22 +36,33 @@ class TiffWriter {
    */
   static bool writeImage(QIODevice& device, const QImage& image);
 
+  /**
+   * \brief Fills the current directory of an open TIFF with a QImage.
+   *
+   * Sets the image related tags and writes the image data, leaving
+   * it to the caller to set any other tags and to finish the directory
+   * with TIFFWriteDirectory().  This is how multi-directory files are built.
+   *
+   * \return True on success, false on failure.
+   */
+  static bool writeDirectory(TIFF* tif, const QImage& image);
+
  private:
   class TiffHandle;
 
-  static void setDpm(const TiffHandle& tif, const Dpm& dpm);
+  static void setDpm(TIFF* tif, const Dpm& dpm);
 
-  static bool writeBitonalOrIndexed8Image(const TiffHandle& tif, const QImage& image);
+  static bool writeBitonalOrIndexed8Image(TIFF* tif, const QImage& image);
 
-  static bool writeRGB32Image(const TiffHandle& tif, const QImage& image);
+  static bool writeRGB32Image(TIFF* tif, const QImage& image);
 
-  static bool writeARGB32Image(const TiffHandle& tif, const QImage& image);
+  static bool writeARGB32Image(TIFF* tif, const QImage& image);
 
-  static bool write8bitLines(const TiffHandle& tif, const QImage& image);
+  static bool write8bitLines(TIFF* tif, const QImage& image);
 
-  static bool writeBinaryLinesAsIs(const TiffHandle& tif, const QImage& image);
+  static bool writeBinaryLinesAsIs(TIFF* tif, const QImage& image);
 
-  static bool writeBinaryLinesReversed(const TiffHandle& tif, const QImage& image);
+  static bool writeBinaryLinesReversed(TIFF* tif, const QImage& image);
 
   static const uint8_t m_reverseBitsLUT[256];
 };
@@ -4,9 +4,13 @@
 #include "WorkerThreadPool.h"
 
 #include <QCoreApplication>
+#include <QDebug>
+#include <QThread>
 #include <QThreadPool>
+#include <optional>
 #include <utility>
 
+#include "ApplicationSettings.h"
 #include "BatchProcessingContext.h"
 #include "OutOfMemoryHandler.h"
 
@@ -39,7 +43,24 @@ class WorkerThreadPool::TaskErrorEvent : public QEvent {
 };
 
 
-WorkerThreadPool::WorkerThreadPool(QObject* parent) : QObject(parent), m_pool(new QThreadPool(this)) {
+WorkerThreadPool::WorkerThreadPool(QObject* parent)
+    : QObject(parent),
+      m_pool(new QThreadPool(this)),
+      m_speculativePool(new QThreadPool(this)),
+      m_topology(CpuTopology::probe()) {
+  // Once running, a speculative task only gets the CPU time no one else wants.
+  // On Linux, that's SCHED_IDLE, which a thread can't leave without privileges,
+  // hence the threads of their own.
+  m_speculativePool->setThreadPriority(QThread::IdlePriority);
+
+  // Set by the --thread-placement command line option, see main().
+  const QString placementOverride = qEnvironmentVariable("SCANTAILOR_THREAD_PLACEMENT");
+  if (!placementOverride.isEmpty()) {
+    m_placementOverride = threadPlacementPolicyFromString(placementOverride, &m_hasPlacementOverride);
+    if (!m_hasPlacementOverride) {
+      qWarning() << "Unknown thread placement policy:" << placementOverride;
+    }
+  }
   updateNumberOfThreads();
 }
 
@@ -47,6 +68,7 @@ WorkerThreadPool::~WorkerThreadPool() = default;
 
 void WorkerThreadPool::shutdown() {
   m_pool->waitForDone();
+  m_speculativePool->waitForDone();
 }
 
 bool WorkerThreadPool::hasSpareCapacity() const {
@@ -56,11 +78,18 @@ bool WorkerThreadPool::hasSpareCapacity() const {
 void WorkerThreadPool::submitTask(const BackgroundTaskPtr& task) {
   class Runnable : public QRunnable {
    public:
-    Runnable(WorkerThreadPool& owner, BackgroundTaskPtr task) : m_owner(owner), m_task(std::move(task)) {
+    Runnable(WorkerThreadPool& owner, BackgroundTaskPtr task, std::shared_ptr<ThreadPlacement> placement)
+        : m_owner(owner), m_task(std::move(task)), m_placement(std::move(placement)) {
       setAutoDelete(true);
     }
 
     void run() override {
+      const bool speculative = m_task->type() == BackgroundTask::SPECULATIVE;
+      // Speculative tasks leave the CPUs to pin to for the others.
+      std::optional<ThreadPlacement::Slot> slot;
+      if (!speculative) {
+        slot.emplace(*m_placement);
+      }
       const batch_processing::TaskScope batchTaskScope(m_task->type() == BackgroundTask::BATCH);
       if (m_task->isCancelled()) {
         return;
@@ -68,28 +97,36 @@ void WorkerThreadPool::submitTask(const BackgroundTaskPtr& task) {
 
       try {
         const FilterResultPtr result((*m_task)());
-        if (result) {
+        // Speculative tasks leave their results in caches.  Anything they return,
+        // like a file loading error, will come up again once the page is visited.
+        if (result && !speculative) {
           QCoreApplication::postEvent(&m_owner, new TaskResultEvent(m_task, result));
         }
       } catch (const std::bad_alloc&) {
         OutOfMemoryHandler::instance().handleOutOfMemorySituation();
       } catch (const std::exception& e) {
         qWarning() << "Exception in worker thread:" << e.what();
-        QCoreApplication::postEvent(&m_owner, new TaskErrorEvent(m_task, QString::fromStdString(e.what())));
+        if (!speculative) {
+          QCoreApplication::postEvent(&m_owner, new TaskErrorEvent(m_task, QString::fromStdString(e.what())));
+        }
       } catch (...) {
         qWarning() << "Unknown exception in worker thread";
-        QCoreApplication::postEvent(&m_owner, new TaskErrorEvent(m_task, QStringLiteral("Unknown exception")));
+        if (!speculative) {
+          QCoreApplication::postEvent(&m_owner, new TaskErrorEvent(m_task, QStringLiteral("Unknown exception")));
+        }
       }
     }
 
    private:
     WorkerThreadPool& m_owner;
     BackgroundTaskPtr m_task;
+    std::shared_ptr<ThreadPlacement> m_placement;
   };
 
 
   updateNumberOfThreads();
-  m_pool->start(new Runnable(*this, task));
+  QThreadPool* const pool = (task->type() == BackgroundTask::SPECULATIVE) ? m_speculativePool : m_pool;
+  pool->start(new Runnable(*this, task, m_placement));
 }  // WorkerThreadPool::submitTask
 
 void WorkerThreadPool::customEvent(QEvent* event) {
@@ -101,12 +138,18 @@ void WorkerThreadPool::customEvent(QEvent* event) {
 }
 
 void WorkerThreadPool::updateNumberOfThreads() {
+  updateThreadPlacement();
+
   int maxThreads = QThread::idealThreadCount();
   // Restricting num of processors for 32-bit due to
   // address space constraints.
   if (sizeof(void*) <= 4) {
     maxThreads = std::min(maxThreads, 2);
   }
+  // Pinning policies make no sense with more threads than CPU sets to pin to.
+  if (m_placement->maxThreads() > 0) {
+    maxThreads = std::min(maxThreads, m_placement->maxThreads());
+  }
 
   int numThreads = m_settings.value("settings/batch_processing_threads", maxThreads).toInt();
   bool overrideOk = false;
@@ -117,4 +160,18 @@ void WorkerThreadPool::updateNumberOfThreads() {
   numThreads = std::max(1, numThreads);
   numThreads = std::min(numThreads, maxThreads);
   m_pool->setMaxThreadCount(numThreads);
+  m_speculativePool->setMaxThreadCount(numThreads);
+}
+
+void WorkerThreadPool::updateThreadPlacement() {
+  ThreadPlacementPolicy policy
+      = threadPlacementPolicyFromString(ApplicationSettings::getInstance().getThreadPlacement());
+  if (m_hasPlacementOverride) {
+    policy = m_placementOverride;
+  }
+
+  // Tasks already running keep the placement they were started with.
+  if (!m_placement || (m_placement->policy() != policy)) {
+    m_placement = std::make_shared<ThreadPlacement>(policy, m_topology);
+  }
 }
@@ -10,6 +10,7 @@
 
 #include "BackgroundTask.h"
 #include "FilterResult.h"
+#include "ThreadPlacement.h"
 
 class QThreadPool;
 
@@ -51,8 +52,15 @@ class WorkerThreadPool : public QObject {
 
   void updateNumberOfThreads();
 
+  void updateThreadPlacement();
+
   QThreadPool* m_pool;
+  QThreadPool* m_speculativePool;
   QSettings m_settings;
+  CpuTopology m_topology;
+  std::shared_ptr<ThreadPlacement> m_placement;
+  ThreadPlacementPolicy m_placementOverride = ThreadPlacementPolicy::ANY_CPU;
+  bool m_hasPlacementOverride = false;
 };
 
 
@@ -19,8 +19,9 @@
 #include "Utils.h"
 
 namespace deskew {
-Filter::Filter(const PageSelectionAccessor& pageSelectionAccessor)
-    : m_settings(std::make_shared<Settings>()),
+Filter::Filter(std::shared_ptr<ProjectPages> pages, const PageSelectionAccessor& pageSelectionAccessor)
+    : m_pages(std::move(pages)),
+      m_settings(std::make_shared<Settings>()),
       m_imageSettings(std::make_shared<ImageSettings>()),
       m_selectedPageOrder(0) {
   m_optionsWidget.reset(new OptionsWidget(m_settings, pageSelectionAccessor));
@@ -118,7 +119,13 @@ std::shared_ptr<Task> Filter::createTask(const PageId& pageId,
                                          const bool batchProcessing,
                                          const bool debug) {
   return std::make_shared<Task>(std::static_pointer_cast<Filter>(shared_from_this()), m_settings, m_imageSettings,
-                                std::move(nextTask), pageId, batchProcessing, debug);
+                                m_pages, std::move(nextTask), pageId, batchProcessing, debug, /*speculative=*/false);
+}
+
+std::shared_ptr<Task> Filter::createSpeculativeTask(const PageId& pageId, std::shared_ptr<page_box::Task> nextTask) {
+  return std::make_shared<Task>(std::static_pointer_cast<Filter>(shared_from_this()), m_settings, m_imageSettings,
+                                m_pages, std::move(nextTask), pageId, /*batchProcessing=*/true, /*debug=*/false,
+                                /*speculative=*/true);
 }
 
 std::shared_ptr<CacheDrivenTask> Filter::createCacheDrivenTask(
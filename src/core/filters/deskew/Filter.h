@@ -17,6 +17,7 @@
 class QString;
 class PageSelectionAccessor;
 class ImageSettings;
+class ProjectPages;
 
 namespace page_box {
 class Task;
@@ -34,7 +35,7 @@ class Filter : public AbstractFilter {
 
   Q_DECLARE_TR_FUNCTIONS(deskew::Filter)
  public:
-  explicit Filter(const PageSelectionAccessor& pageSelectionAccessor);
+  Filter(std::shared_ptr<ProjectPages> pages, const PageSelectionAccessor& pageSelectionAccessor);
 
   ~Filter() override;
 
@@ -57,6 +58,14 @@ class Filter : public AbstractFilter {
                                    bool batchProcessing,
                                    bool debug);
 
+  /**
+   * \brief Creates a task that only replays the stored parameters, so that a speculative
+   *        task further down the chain gets the page as the user would see it.
+   *
+   * See Task::process().
+   */
+  std::shared_ptr<Task> createSpeculativeTask(const PageId& pageId, std::shared_ptr<page_box::Task> nextTask);
+
   std::shared_ptr<CacheDrivenTask> createCacheDrivenTask(std::shared_ptr<page_box::CacheDrivenTask> nextTask);
 
   OptionsWidget* optionsWidget();
@@ -78,6 +87,7 @@ class Filter : public AbstractFilter {
 
   void loadImageSettings(const ProjectReader& reader, const QDomElement& imageSettingsEl);
 
+  std::shared_ptr<ProjectPages> m_pages;
   std::shared_ptr<Settings> m_settings;
   std::shared_ptr<ImageSettings> m_imageSettings;
   SafeDeletingQObjectPtr<OptionsWidget> m_optionsWidget;
@@ -44,13 +44,7 @@ void OptionsWidget::appliedTo(const std::set<PageId>& pages) {
   const Params params(m_uiData.effectiveDeskewAngle(), m_uiData.dependencies(), m_uiData.mode());
   m_settings->setDegrees(pages, params);
 
-  if (pages.size() > 1) {
-    emit invalidateAllThumbnails();
-  } else {
-    for (const PageId& pageId : pages) {
-      emit invalidateThumbnail(pageId);
-    }
-  }
+  emit invalidateThumbnails(pages);
 }
 
 void OptionsWidget::appliedToAllPages(const std::set<PageId>& pages) {
@@ -3,13 +3,37 @@
 
 #include "Settings.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
 #include "../../Utils.h"
 #include "AbstractRelinker.h"
+#include "PageSequence.h"
 #include "RelinkablePath.h"
 
 using namespace core;
 
 namespace deskew {
+namespace {
+const int NEIGHBORS_PER_SIDE = 3;
+const int MIN_NEIGHBORS = 3;
+// How far from the page to look for pages with a detected skew.
+const int MAX_NEIGHBOR_DISTANCE = 10;
+// The maximum median absolute deviation of the neighbor skews, in degrees.
+const double MAX_NEIGHBOR_SPREAD = 0.5;
+
+double median(std::vector<double> values) {
+  const auto middle = values.begin() + values.size() / 2;
+  std::nth_element(values.begin(), middle, values.end());
+  if (values.size() % 2 != 0) {
+    return *middle;
+  }
+  return 0.5 * (*middle + *std::max_element(values.begin(), middle));
+}
+}  // namespace
+
 Settings::Settings() {
   m_deviationProvider.setComputeValueByKey([this](const PageId& pageId) -> double {
     auto it(m_perPageParams.find(pageId));
@@ -27,6 +51,7 @@ void Settings::clear() {
   QMutexLocker locker(&m_mutex);
   m_perPageParams.clear();
   m_deviationProvider.clear();
+  m_detectedSkews.clear();
 }
 
 void Settings::performRelinking(const AbstractRelinker& relinker) {
@@ -46,6 +71,15 @@ void Settings::performRelinking(const AbstractRelinker& relinker) {
   for (const PerPageParams::value_type& kv : m_perPageParams) {
     m_deviationProvider.addOrUpdate(kv.first);
   }
+
+  DetectedSkews newSkews;
+  for (const DetectedSkews::value_type& kv : m_detectedSkews) {
+    const RelinkablePath oldPath(kv.first.imageId().filePath(), RelinkablePath::File);
+    PageId newPageId(kv.first);
+    newPageId.imageId().setFilePath(relinker.substitutionPathFor(oldPath));
+    newSkews.emplace(newPageId, kv.second);
+  }
+  m_detectedSkews.swap(newSkews);
 }
 
 void Settings::setPageParams(const PageId& pageId, const Params& params) {
@@ -58,6 +92,7 @@ void Settings::clearPageParams(const PageId& pageId) {
   QMutexLocker locker(&m_mutex);
   m_perPageParams.erase(pageId);
   m_deviationProvider.remove(pageId);
+  m_detectedSkews.erase(pageId);
 }
 
 std::unique_ptr<Params> Settings::getPageParams(const PageId& pageId) const {
@@ -87,4 +122,50 @@ bool Settings::isParamsNull(const PageId& pageId) const {
 const DeviationProvider<PageId>& Settings::deviationProvider() const {
   return m_deviationProvider;
 }
+
+void Settings::addDetectedSkew(const PageId& pageId, const double skewAngle) {
+  QMutexLocker locker(&m_mutex);
+  m_detectedSkews[pageId] = skewAngle;
+}
+
+bool Settings::predictSkew(const PageId& pageId, const PageSequence& pages, double* skewAngle) const {
+  const int pageNo = pages.pageNo(pageId);
+  if (pageNo < 0) {
+    return false;
+  }
+  const int numPages = static_cast<int>(pages.numPages());
+
+  std::vector<double> neighbors;
+  {
+    QMutexLocker locker(&m_mutex);
+    for (const int step : {-1, 1}) {
+      int found = 0;
+      for (int i = pageNo + step; (i >= 0) && (i < numPages) && (std::abs(i - pageNo) <= MAX_NEIGHBOR_DISTANCE)
+                                  && (found < NEIGHBORS_PER_SIDE);
+           i += step) {
+        const auto it = m_detectedSkews.find(pages.pageAt(static_cast<size_t>(i)).id());
+        if (it != m_detectedSkews.end()) {
+          neighbors.push_back(it->second);
+          ++found;
+        }
+      }
+    }
+  }
+
+  if (static_cast<int>(neighbors.size()) < MIN_NEIGHBORS) {
+    return false;
+  }
+
+  const double center = median(neighbors);
+  std::vector<double> deviations;
+  for (const double angle : neighbors) {
+    deviations.push_back(std::abs(angle - center));
+  }
+  if (median(deviations) > MAX_NEIGHBOR_SPREAD) {
+    return false;
+  }
+
+  *skewAngle = center;
+  return true;
+}
 }  // namespace deskew
\ No newline at end of file
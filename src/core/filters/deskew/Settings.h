@@ -16,6 +16,7 @@
 #include "Params.h"
 
 class AbstractRelinker;
+class PageSequence;
 
 namespace deskew {
 class Settings {
@@ -42,12 +43,30 @@ class Settings {
 
   const DeviationProvider<PageId>& deviationProvider() const;
 
+  /**
+   * \brief Remembers a confidently detected skew of a page.
+   *
+   * \param skewAngle The skew, as reported by imageproc::Skew::angle().
+   */
+  void addDetectedSkew(const PageId& pageId, double skewAngle);
+
+  /**
+   * \brief Predicts the skew of a page from the detected skews of its neighbors.
+   *
+   * Takes the median of up to three detected skews on each side of the page,
+   * in the order of \p pages.  Returns false if there are too few of them
+   * or they disagree too much to be trusted.
+   */
+  bool predictSkew(const PageId& pageId, const PageSequence& pages, double* skewAngle) const;
+
  private:
   using PerPageParams = std::unordered_map<PageId, Params>;
+  using DetectedSkews = std::unordered_map<PageId, double>;
 
   mutable QMutex m_mutex;
   PerPageParams m_perPageParams;
   DeviationProvider<PageId> m_deviationProvider;
+  DetectedSkews m_detectedSkews;
 };
 }  // namespace deskew
 #endif  // ifndef SCANTAILOR_DESKEW_SETTINGS_H_
@@ -27,6 +27,7 @@
 #include "FilterUiInterface.h"
 #include "ImageView.h"
 #include "OptionsWidget.h"
+#include "ProjectPages.h"
 #include "TaskStatus.h"
 #include "filters/page_box/Task.h"
 
@@ -62,19 +63,21 @@ class Task::UiUpdater : public FilterResult {
 Task::Task(std::shared_ptr<Filter> filter,
            std::shared_ptr<Settings> settings,
            std::shared_ptr<ImageSettings> imageSettings,
+           std::shared_ptr<ProjectPages> pages,
            std::shared_ptr<page_box::Task> nextTask,
            const PageId& pageId,
            const bool batchProcessing,
-           const bool debug)
+           const bool debug,
+           const bool speculative)
     : m_filter(std::move(filter)),
       m_settings(std::move(settings)),
       m_imageSettings(std::move(imageSettings)),
+      m_pages(std::move(pages)),
       m_nextTask(std::move(nextTask)),
       m_pageId(pageId),
-      m_batchProcessing(batchProcessing) {
-  if (debug) {
-    m_dbg = std::make_unique<DebugImagesImpl>();
-  }
+      m_batchProcessing(batchProcessing),
+      m_speculative(speculative) {
+  m_dbg = DebugImagesImpl::create(debug, "deskew", m_pageId);
 }
 
 Task::~Task() = default;
@@ -85,6 +88,18 @@ FilterResultPtr Task::process(const TaskStatus& status, FilterData data) {
   const Dependencies deps(data.xform().preCropArea(), data.xform().preRotation());
 
   std::unique_ptr<Params> params(m_settings->getPageParams(m_pageId));
+  if (m_speculative) {
+    const std::unique_ptr<ImageSettings::PageParams> imageParams = m_imageSettings->getPageParams(m_pageId);
+    if (!params || !imageParams || !deps.matches(params->dependencies()) || !m_nextTask) {
+      return nullptr;
+    }
+    data.updateImageParams(*imageParams);
+
+    ImageTransformation newXform(data.xform());
+    newXform.setPostRotation(params->deskewAngle());
+    return m_nextTask->process(status, FilterData(data, newXform));
+  }
+
   updateFilterData(status, data, (!params || !deps.matches(params->dependencies())));
 
   OptionsWidget::UiData uiData;
@@ -110,9 +125,13 @@ FilterResultPtr Task::process(const TaskStatus& status, FilterData data) {
     status.throwIfCancelled();
 
     if (boundedImageArea.isValid()) {
-      BinaryImage rotatedImage(orthogonalRotation(
-          BinaryImage(data.grayImageBlackOnWhite(), boundedImageArea, data.bwThresholdBlackOnWhite()),
-          data.xform().preRotation().toDegrees()));
+      const int degrees = data.xform().preRotation().toDegrees();
+      BinaryImage rotatedImage(
+          data.isBitonal()
+              ? orthogonalRotation(data.binaryImageBlackOnWhite(), boundedImageArea, degrees)
+              : orthogonalRotation(
+                  BinaryImage(data.grayImageBlackOnWhite(), boundedImageArea, data.bwThresholdBlackOnWhite()),
+                  degrees));
       if (m_dbg) {
         m_dbg->add(rotatedImage, "bw_rotated");
       }
@@ -128,10 +147,19 @@ FilterResultPtr Task::process(const TaskStatus& status, FilterData data) {
 
       SkewFinder skewFinder;
       skewFinder.setResolutionRatio((double) rotatedDpm.horizontal() / rotatedDpm.vertical());
+      double expectedSkew = 0.0;
+      if (m_settings->predictSkew(m_pageId, m_pages->toPageSequence(PAGE_VIEW), &expectedSkew)) {
+        skewFinder.setExpectedSkew(expectedSkew);
+      }
       const Skew skew(skewFinder.findSkew(rotatedImage));
 
       if (skew.confidence() >= Skew::GOOD_CONFIDENCE) {
         uiData.setEffectiveDeskewAngle(-skew.angle());
+        m_settings->addDetectedSkew(m_pageId, skew.angle());
+      } else if (skew.isConfidenceEstimated()) {
+        // The neighbors vouch for the angle, but it mustn't become
+        // a neighbor's evidence in turn.
+        uiData.setEffectiveDeskewAngle(-skew.angle());
       } else {
         uiData.setEffectiveDeskewAngle(0);
       }
@@ -210,6 +238,16 @@ void Task::updateFilterData(const TaskStatus& status, FilterData& data, bool nee
   const std::unique_ptr<ImageSettings::PageParams> params = m_imageSettings->getPageParams(m_pageId);
   if (!needUpdate && params) {
     data.updateImageParams(*params);
+  } else if (data.isBitonal()) {
+    // Any threshold between black and white gives the same bits.
+    bool isBlackOnWhite = true;
+    if (ApplicationSettings::getInstance().isBlackOnWhiteDetectionEnabled()) {
+      isBlackOnWhite = BlackOnWhiteEstimator::isBlackOnWhite(data.binaryImage(), data.xform(), status, m_dbg.get());
+    }
+    ImageSettings::PageParams newParams(BinaryThreshold(128), isBlackOnWhite);
+
+    m_imageSettings->setPageParams(m_pageId, newParams);
+    data.updateImageParams(newParams);
   } else {
     const GrayImage& img = data.grayImage();
     BinaryImage mask(img.size(), BLACK);
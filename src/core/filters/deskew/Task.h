@@ -17,6 +17,7 @@ class QImage;
 class QSize;
 class Dpi;
 class DebugImages;
+class ProjectPages;
 
 namespace imageproc {
 class BinaryImage;
@@ -37,13 +38,19 @@ class Task {
   Task(std::shared_ptr<Filter> filter,
        std::shared_ptr<Settings> settings,
        std::shared_ptr<ImageSettings> imageSettings,
+       std::shared_ptr<ProjectPages> pages,
        std::shared_ptr<page_box::Task> nextTask,
        const PageId& pageId,
        bool batchProcessing,
-       bool debug);
+       bool debug,
+       bool speculative);
 
   virtual ~Task();
 
+  /**
+   * In the speculative mode, the skew is neither detected nor stored.  Unless the
+   * stored one still applies, nothing is returned and the chain stops here.
+   */
   FilterResultPtr process(const TaskStatus& status, FilterData data);
 
  private:
@@ -60,10 +67,12 @@ class Task {
   std::shared_ptr<Filter> m_filter;
   std::shared_ptr<Settings> m_settings;
   std::shared_ptr<ImageSettings> m_imageSettings;
+  std::shared_ptr<ProjectPages> m_pages;
   std::shared_ptr<page_box::Task> m_nextTask;
   std::unique_ptr<DebugImages> m_dbg;
   PageId m_pageId;
   bool m_batchProcessing;
+  bool m_speculative;
 };
 }  // namespace deskew
 #endif  // ifndef SCANTAILOR_DESKEW_TASK_H_
@@ -29,6 +29,7 @@ OptionsWidget::OptionsWidget(std::shared_ptr<Settings> settings, const PageSelec
   formatCombo->addItem(tr("TIFF"), static_cast<int>(OutputFormat::TIFF));
   formatCombo->addItem(tr("PNG"), static_cast<int>(OutputFormat::PNG));
   formatCombo->addItem(tr("JPEG"), static_cast<int>(OutputFormat::JPEG));
+  formatCombo->addItem(tr("TIFF book (single file)"), static_cast<int>(OutputFormat::TIFF_BOOK));
 
   // Set up compression combo box (for TIFF)
   compressionCombo->addItem(tr("LZW"), static_cast<int>(TiffCompression::LZW));
@@ -333,7 +334,7 @@ void OptionsWidget::updateFormatOptions() {
   const OutputFormat format = m_settings->outputFormat();
 
   // Show compression options only for TIFF
-  const bool showCompression = (format == OutputFormat::TIFF);
+  const bool showCompression = (format == OutputFormat::TIFF) || (format == OutputFormat::TIFF_BOOK);
   compressionLabel->setVisible(showCompression);
   compressionCombo->setVisible(showCompression);
 
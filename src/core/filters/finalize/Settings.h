@@ -41,7 +41,8 @@ inline ColorMode applyAutoColorModePolicy(ColorMode detectedMode, AutoColorModeP
 enum class OutputFormat {
   TIFF,
   PNG,
-  JPEG
+  JPEG,
+  TIFF_BOOK
 };
 
 // TIFF compression options
@@ -71,7 +71,8 @@ Task::~Task() = default;
 FilterResultPtr Task::process(const TaskStatus& status, const FilterData& data, const QPolygonF& contentRectPhys) {
   status.throwIfCancelled();
 
-  const QImage& image = data.origImage();
+  // The color detection works on 8 and 32-bit images.
+  const QImage& image = data.isBitonal() ? data.grayImage().toQImage() : data.origImage();
   const QRect contentBox = contentRectPhys.boundingRect().toRect().intersected(image.rect());
 
   // Consult the cached detection before doing any full-resolution preparation.
@@ -13,6 +13,7 @@
 #include "FilterUiInterface.h"
 #include "ImageSettings.h"
 #include "OptionsWidget.h"
+#include "ProjectPages.h"
 #include "ProjectReader.h"
 #include "ProjectWriter.h"
 #include "Settings.h"
@@ -51,6 +52,8 @@ void Filter::preUpdateUI(FilterUiInterface* ui, const PageInfo& pageInfo) {
 
 QDomElement Filter::saveSettings(const ProjectWriter& writer, QDomDocument& doc) const {
   QDomElement filterEl(doc.createElement("fix-orientation"));
+  // Projects without this attribute predate orientation detection.
+  filterEl.setAttribute("decidedRotations", "1");
   writer.enumImages(
       [&](const ImageId& imageId, const int numericId) { this->writeParams(doc, filterEl, imageId, numericId); });
 
@@ -90,6 +93,14 @@ void Filter::loadSettings(const ProjectReader& reader, const QDomElement& filter
     m_settings->applyRotation(imageId, rotation);
   }
 
+  if (filterEl.attribute("decidedRotations") != "1") {
+    // Older projects didn't save zero rotations, whether chosen by the user or not.
+    // Leave all of their images alone rather than letting the detection override them.
+    for (const PageInfo& page : reader.pages()->toPageSequence(IMAGE_VIEW)) {
+      m_settings->markOrientationDecided(page.imageId());
+    }
+  }
+
   loadImageSettings(reader, filterEl.namedItem("image-settings").toElement());
 }  // Filter::loadSettings
 
@@ -97,7 +108,12 @@ std::shared_ptr<Task> Filter::createTask(const PageId& pageId,
                                          std::shared_ptr<page_split::Task> nextTask,
                                          const bool batchProcessing) {
   return std::make_shared<Task>(pageId, std::static_pointer_cast<Filter>(shared_from_this()), m_settings,
-                                m_imageSettings, std::move(nextTask), batchProcessing);
+                                m_imageSettings, std::move(nextTask), batchProcessing, /*speculative=*/false);
+}
+
+std::shared_ptr<Task> Filter::createSpeculativeTask(const PageId& pageId, std::shared_ptr<page_split::Task> nextTask) {
+  return std::make_shared<Task>(pageId, std::static_pointer_cast<Filter>(shared_from_this()), m_settings,
+                                m_imageSettings, std::move(nextTask), /*batchProcessing=*/true, /*speculative=*/true);
 }
 
 std::shared_ptr<CacheDrivenTask> Filter::createCacheDrivenTask(std::shared_ptr<page_split::CacheDrivenTask> nextTask) {
@@ -106,7 +122,9 @@ std::shared_ptr<CacheDrivenTask> Filter::createCacheDrivenTask(std::shared_ptr<p
 
 void Filter::writeParams(QDomDocument& doc, QDomElement& filterEl, const ImageId& imageId, int numericId) const {
   const OrthogonalRotation rotation(m_settings->getRotationFor(imageId));
-  if (rotation.toDegrees() == 0) {
+  // A zero rotation is only worth saving if it was decided on, as otherwise
+  // orientation detection would reconsider the image after reloading.
+  if ((rotation.toDegrees() == 0) && m_settings->isOrientationDetectionNeeded(imageId)) {
     return;
   }
 
@@ -122,7 +140,7 @@ void Filter::loadDefaultSettings(const PageInfo& pageInfo) {
   if (!m_settings->isRotationNull(pageInfo.id().imageId()))
     return;
 
-  m_settings->applyRotation(pageInfo.id().imageId(), Utils::getDefaultOrthogonalRotation());
+  m_settings->applyDefaultRotation(pageInfo.id().imageId(), Utils::getDefaultOrthogonalRotation());
 }
 
 OptionsWidget* Filter::optionsWidget() {
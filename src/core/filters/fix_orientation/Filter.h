@@ -60,10 +60,20 @@ class Filter : public AbstractFilter {
                                    std::shared_ptr<page_split::Task> nextTask,
                                    bool batchProcessing);
 
+  /**
+   * \brief Creates a task that only replays the stored parameters, so that a speculative
+   *        task further down the chain gets the page as the user would see it.
+   *
+   * See Task::process().
+   */
+  std::shared_ptr<Task> createSpeculativeTask(const PageId& pageId, std::shared_ptr<page_split::Task> nextTask);
+
   std::shared_ptr<CacheDrivenTask> createCacheDrivenTask(std::shared_ptr<page_split::CacheDrivenTask> nextTask);
 
   OptionsWidget* optionsWidget();
 
+  std::shared_ptr<Settings> settings() const { return m_settings; }
+
  private:
   void writeParams(QDomDocument& doc, QDomElement& filterEl, const ImageId& imageId, int numericId) const;
 
@@ -0,0 +1,311 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include "OrientationDetector.h"
+
+#include <Binarize.h>
+#include <BinaryImage.h>
+#include <ConnectivityMap.h>
+#include <GrayImage.h>
+#include <Scale.h>
+
+#include <QSize>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "DebugImages.h"
+#include "Dpi.h"
+#include "TaskStatus.h"
+
+namespace fix_orientation {
+using namespace imageproc;
+
+const double DetectedOrientation::GOOD_CONFIDENCE = 0.25;
+
+OrthogonalRotation DetectedOrientation::rotation() const {
+  OrthogonalRotation rotation;
+  for (int degrees = 0; degrees < m_degrees; degrees += 90) {
+    rotation.nextClockwiseDirection();
+  }
+  return rotation;
+}
+
+const int OrientationDetector::PROXY_DPI = 100;
+
+namespace {
+// Fewer glyphs than that reaching out of the x-height band say nothing about up and down.
+const int MIN_SIGNIFICANT_COMPONENTS = 20;
+
+// Limits of the glyph size relative to PROXY_DPI.  Bigger components are
+// pictures, rules, frames or scanner borders that would distort the profiles.
+const double MAX_GLYPH_LENGTH_INCHES = 0.6;
+const double MAX_GLYPH_THICKNESS_INCHES = 0.3;
+
+bool isAboveProxyResolution(const Dpi& dpi) {
+  return !dpi.isNull()
+         && ((dpi.horizontal() > OrientationDetector::PROXY_DPI) || (dpi.vertical() > OrientationDetector::PROXY_DPI));
+}
+
+QSize proxySize(const QSize& imageSize, const Dpi& dpi) {
+  const int proxyDpi = OrientationDetector::PROXY_DPI;
+  const int width = std::max(1, (imageSize.width() * proxyDpi + dpi.horizontal() / 2) / dpi.horizontal());
+  const int height = std::max(1, (imageSize.height() * proxyDpi + dpi.vertical() / 2) / dpi.vertical());
+  return QSize(width, height);
+}
+}  // namespace
+
+OrientationDetector::OrientationDetector() = default;
+
+DetectedOrientation OrientationDetector::detect(const TaskStatus& status,
+                                                const GrayImage& image,
+                                                const Dpi& dpi,
+                                                DebugImages* dbg) const {
+  if (image.isNull()) {
+    return DetectedOrientation();
+  }
+
+  GrayImage proxyGray(image);
+  if (isAboveProxyResolution(dpi)) {
+    proxyGray = scaleToGray(image, proxySize(image.size(), dpi));
+  }
+  return detectOnProxy(status, proxyGray, dbg);
+}
+
+DetectedOrientation OrientationDetector::detect(const TaskStatus& status,
+                                                const BinaryImage& image,
+                                                const Dpi& dpi,
+                                                DebugImages* dbg) const {
+  if (image.isNull()) {
+    return DetectedOrientation();
+  }
+
+  if (isAboveProxyResolution(dpi)) {
+    return detectOnProxy(status, scaleToGray(image, proxySize(image.size(), dpi)), dbg);
+  }
+
+  // Binarizing the grayscale version would give these very bits.
+  if (dbg) {
+    dbg->add(image, "orientation_proxy");
+  }
+  return detect(image);
+}
+
+DetectedOrientation OrientationDetector::detectOnProxy(const TaskStatus& status,
+                                                       const GrayImage& proxyGray,
+                                                       DebugImages* dbg) const {
+  status.throwIfCancelled();
+
+  const BinaryImage proxy(binarizeOtsu(proxyGray));
+  if (dbg) {
+    dbg->add(proxy, "orientation_proxy");
+  }
+
+  status.throwIfCancelled();
+
+  return detect(proxy);
+}
+
+DetectedOrientation OrientationDetector::detect(const BinaryImage& proxy) const {
+  if (proxy.isNull()) {
+    return DetectedOrientation();
+  }
+
+  const int width = proxy.width();
+  const int height = proxy.height();
+  const ConnectivityMap cmap(proxy, CONN8);
+  if (cmap.maxLabel() == 0) {
+    return DetectedOrientation();
+  }
+
+  std::vector<Component> components(cmap.maxLabel() + 1, Component{width, height, -1, -1});
+  const uint32_t* mapLine = cmap.data();
+  const int mapStride = cmap.stride();
+  for (int y = 0; y < height; ++y, mapLine += mapStride) {
+    for (int x = 0; x < width; ++x) {
+      if (const uint32_t label = mapLine[x]) {
+        Component& comp = components[label];
+        comp.left = std::min(comp.left, x);
+        comp.top = std::min(comp.top, y);
+        comp.right = std::max(comp.right, x);
+        comp.bottom = std::max(comp.bottom, y);
+      }
+    }
+  }
+
+  // Only text-like components take part in the analysis.
+  const auto maxLength = static_cast<int>(std::lround(PROXY_DPI * MAX_GLYPH_LENGTH_INCHES));
+  const auto maxThickness = static_cast<int>(std::lround(PROXY_DPI * MAX_GLYPH_THICKNESS_INCHES));
+  std::vector<bool> isGlyph(components.size(), false);
+  std::vector<Component> glyphs;
+  glyphs.reserve(components.size());
+  for (size_t label = 1; label < components.size(); ++label) {
+    const Component& comp = components[label];
+    const int compWidth = comp.right - comp.left + 1;
+    const int compHeight = comp.bottom - comp.top + 1;
+    if ((std::max(compWidth, compHeight) < 2) || (std::max(compWidth, compHeight) > maxLength)
+        || (std::min(compWidth, compHeight) > maxThickness)) {
+      continue;
+    }
+    isGlyph[label] = true;
+    glyphs.push_back(comp);
+  }
+  if (glyphs.empty()) {
+    return DetectedOrientation();
+  }
+
+  std::vector<int> rowProfile(height, 0);
+  std::vector<int> colProfile(width, 0);
+  mapLine = cmap.data();
+  for (int y = 0; y < height; ++y, mapLine += mapStride) {
+    for (int x = 0; x < width; ++x) {
+      if (isGlyph[mapLine[x]]) {
+        ++rowProfile[y];
+        ++colProfile[x];
+      }
+    }
+  }
+
+  // Text lines make the profile across them alternate between the lines
+  // and the gaps in between, while the profile along the lines stays smooth.
+  const double rowRoughness = profileRoughness(rowProfile);
+  const double colRoughness = profileRoughness(colProfile);
+  const double maxRoughness = std::max(rowRoughness, colRoughness);
+  if (maxRoughness <= 0.0) {
+    return DetectedOrientation();
+  }
+  const bool horizontalLines = rowRoughness >= colRoughness;
+  const double lineConfidence = std::fabs(rowRoughness - colRoughness) / maxRoughness;
+
+  const LineStats stats = horizontalLines ? analyzeLines(rowProfile, glyphs, true)
+                                          : analyzeLines(colProfile, glyphs, false);
+  const int significant = stats.ascenders + stats.descenders;
+  const bool upright = stats.ascenders >= stats.descenders;
+  double senseConfidence = 0.0;
+  if (significant >= MIN_SIGNIFICANT_COMPONENTS) {
+    senseConfidence = double(std::abs(stats.ascenders - stats.descenders)) / significant;
+  }
+
+  // Vertical lines with ascenders pointing left become upright
+  // after a clockwise rotation.
+  int degrees;
+  if (horizontalLines) {
+    degrees = upright ? 0 : 180;
+  } else {
+    degrees = upright ? 90 : 270;
+  }
+
+  return DetectedOrientation(degrees, std::min(lineConfidence, senseConfidence));
+}  // OrientationDetector::detect
+
+double OrientationDetector::profileRoughness(const std::vector<int>& profile) {
+  double sumSqDiff = 0.0;
+  double sumSq = 0.0;
+  for (size_t i = 0; i < profile.size(); ++i) {
+    const double val = profile[i];
+    sumSq += val * val;
+    if (i > 0) {
+      const double diff = val - profile[i - 1];
+      sumSqDiff += diff * diff;
+    }
+  }
+  if (sumSq <= 0.0) {
+    return 0.0;
+  }
+  return sumSqDiff / sumSq;
+}
+
+/**
+ * The cores of text lines (the x-height bands) are where the profile across
+ * the lines is dense.  A glyph reaching out of its band on the "top" side
+ * counts as an ascender, one reaching out on the "bottom" side as a descender.
+ * For vertical lines, "top" is the left side, which becomes the top after
+ * a clockwise rotation.
+ */
+OrientationDetector::LineStats OrientationDetector::analyzeLines(const std::vector<int>& profile,
+                                                                 const std::vector<Component>& components,
+                                                                 const bool horizontalLines) {
+  LineStats stats;
+
+  std::vector<int> nonZero;
+  nonZero.reserve(profile.size());
+  for (const int val : profile) {
+    if (val > 0) {
+      nonZero.push_back(val);
+    }
+  }
+  if (nonZero.empty()) {
+    return stats;
+  }
+  const auto p90 = nonZero.begin() + (nonZero.size() * 9) / 10;
+  std::nth_element(nonZero.begin(), p90, nonZero.end());
+  const int coreThreshold = std::max(1, static_cast<int>(*p90 * 0.4));
+
+  struct Band {
+    int first;
+    int last;
+  };
+  std::vector<Band> bands;
+  std::vector<int> bandAt(profile.size(), -1);
+  for (int i = 0; i < static_cast<int>(profile.size());) {
+    if (profile[i] < coreThreshold) {
+      ++i;
+      continue;
+    }
+    const int first = i;
+    while (i < static_cast<int>(profile.size()) && profile[i] >= coreThreshold) {
+      ++i;
+    }
+    if (i - first >= 2) {
+      std::fill(bandAt.begin() + first, bandAt.begin() + i, static_cast<int>(bands.size()));
+      bands.push_back(Band{first, i - 1});
+    }
+  }
+  if (bands.empty()) {
+    return stats;
+  }
+
+  std::vector<int> overlaps(bands.size(), 0);
+  for (const Component& comp : components) {
+    const int first = horizontalLines ? comp.top : comp.left;
+    const int last = horizontalLines ? comp.bottom : comp.right;
+
+    // Assign the component to the band it overlaps the most.
+    // Components not touching any band (dots, accents, noise) are skipped.
+    int bestBand = -1;
+    int bestOverlap = 0;
+    for (int i = first; i <= last; ++i) {
+      const int band = bandAt[i];
+      if (band < 0) {
+        continue;
+      }
+      if (++overlaps[band] > bestOverlap) {
+        bestOverlap = overlaps[band];
+        bestBand = band;
+      }
+    }
+    for (int i = first; i <= last; ++i) {
+      if (bandAt[i] >= 0) {
+        overlaps[bandAt[i]] = 0;
+      }
+    }
+    if (bestBand < 0) {
+      continue;
+    }
+
+    const Band& band = bands[bestBand];
+    const int bandSize = band.last - band.first + 1;
+    if (last - first + 1 > bandSize * 3) {
+      continue;
+    }
+    const int margin = std::max(1, bandSize / 4);
+    if (first < band.first - margin) {
+      ++stats.ascenders;
+    }
+    if (last > band.last + margin) {
+      ++stats.descenders;
+    }
+  }
+  return stats;
+}  // OrientationDetector::analyzeLines
+}  // namespace fix_orientation
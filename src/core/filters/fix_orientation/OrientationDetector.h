@@ -0,0 +1,136 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#ifndef SCANTAILOR_FIX_ORIENTATION_ORIENTATIONDETECTOR_H_
+#define SCANTAILOR_FIX_ORIENTATION_ORIENTATIONDETECTOR_H_
+
+#include <vector>
+
+#include "NonCopyable.h"
+#include "OrthogonalRotation.h"
+
+class TaskStatus;
+class DebugImages;
+class Dpi;
+
+namespace imageproc {
+class BinaryImage;
+class GrayImage;
+}  // namespace imageproc
+
+namespace fix_orientation {
+/**
+ * \brief The result of the "detect orientation" operation.
+ * \see OrientationDetector
+ */
+class DetectedOrientation {
+ public:
+  /**
+   * \brief The threshold separating good and poor confidence values.
+   * \see confidence()
+   */
+  static const double GOOD_CONFIDENCE;
+
+  DetectedOrientation() : m_degrees(0), m_confidence(0.0) {}
+
+  DetectedOrientation(int degrees, double confidence) : m_degrees(degrees), m_confidence(confidence) {}
+
+  /**
+   * \brief The clockwise rotation that makes the page upright.
+   *
+   * One of 0, 90, 180 or 270.
+   */
+  int degrees() const { return m_degrees; }
+
+  OrthogonalRotation rotation() const;
+
+  /**
+   * \brief Get the confidence value in [0, 1] range.
+   *
+   * Everything above or equal to GOOD_CONFIDENCE means both the direction
+   * of text lines and the up/down sense of the glyphs were clear.
+   */
+  double confidence() const { return m_confidence; }
+
+ private:
+  int m_degrees;
+  double m_confidence;
+};
+
+
+/**
+ * \brief OCR-free detector of 90/180/270 degree page rotations.
+ *
+ * The page is analyzed on a binarized proxy of about PROXY_DPI dots per inch.
+ * Text-like connected components are selected first.  The direction of text
+ * lines is then decided by comparing the roughness of the row and column
+ * projection profiles of those components: text lines produce a strongly
+ * alternating profile across the lines and a flat one along them.
+ * The up/down sense is decided by the asymmetry between ascenders and
+ * descenders relative to the x-height band of each line, as latin, cyrillic
+ * and greek scripts have considerably more ascenders (including capitals
+ * and digits) than descenders.
+ */
+class OrientationDetector {
+  DECLARE_NON_COPYABLE(OrientationDetector)
+
+ public:
+  static const int PROXY_DPI;
+
+  OrientationDetector();
+
+  /**
+   * \brief Detects the orientation of a black-on-white grayscale page.
+   *
+   * \param status Used for cancellation.
+   * \param image The unrotated page image.
+   * \param dpi The resolution of \p image.
+   * \param dbg The sink for debugging images, may be null.
+   */
+  DetectedOrientation detect(const TaskStatus& status,
+                             const imageproc::GrayImage& image,
+                             const Dpi& dpi,
+                             DebugImages* dbg = nullptr) const;
+
+  /**
+   * \brief Same as above, for a black-on-white bitonal page.
+   *
+   * The proxy is made from the bits directly, with no full resolution grayscale copy.
+   */
+  DetectedOrientation detect(const TaskStatus& status,
+                             const imageproc::BinaryImage& image,
+                             const Dpi& dpi,
+                             DebugImages* dbg = nullptr) const;
+
+  /**
+   * \brief Detects the orientation of a binarized proxy image.
+   *
+   * The image is expected to be at about PROXY_DPI.
+   */
+  DetectedOrientation detect(const imageproc::BinaryImage& proxy) const;
+
+ private:
+  struct Component {
+    int left;
+    int top;
+    int right;
+    int bottom;
+  };
+
+  struct LineStats {
+    int ascenders = 0;
+    int descenders = 0;
+  };
+
+  DetectedOrientation detectOnProxy(const TaskStatus& status,
+                                    const imageproc::GrayImage& proxyGray,
+                                    DebugImages* dbg) const;
+
+  static double profileRoughness(const std::vector<int>& profile);
+
+  static LineStats analyzeLines(const std::vector<int>& profile,
+                                const std::vector<Component>& components,
+                                bool horizontalLines);
+};
+}  // namespace fix_orientation
+#endif  // ifndef SCANTAILOR_FIX_ORIENTATION_ORIENTATIONDETECTOR_H_
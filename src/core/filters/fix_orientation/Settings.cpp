@@ -17,6 +17,7 @@ Settings::~Settings() = default;
 void Settings::clear() {
   QMutexLocker locker(&m_mutex);
   m_perImageRotation.clear();
+  m_orientationDecided.clear();
 }
 
 void Settings::performRelinking(const AbstractRelinker& relinker) {
@@ -31,11 +32,22 @@ void Settings::performRelinking(const AbstractRelinker& relinker) {
   }
 
   m_perImageRotation.swap(newRotations);
+
+  std::unordered_set<ImageId> newDecided;
+  for (const ImageId& imageId : m_orientationDecided) {
+    const RelinkablePath oldPath(imageId.filePath(), RelinkablePath::File);
+    ImageId newImageId(imageId);
+    newImageId.setFilePath(relinker.substitutionPathFor(oldPath));
+    newDecided.insert(newImageId);
+  }
+
+  m_orientationDecided.swap(newDecided);
 }
 
 void Settings::applyRotation(const ImageId& imageId, const OrthogonalRotation rotation) {
   QMutexLocker locker(&m_mutex);
   setImageRotationLocked(imageId, rotation);
+  m_orientationDecided.insert(imageId);
 }
 
 void Settings::applyRotation(const std::set<PageId>& pages, const OrthogonalRotation rotation) {
@@ -43,9 +55,26 @@ void Settings::applyRotation(const std::set<PageId>& pages, const OrthogonalRota
 
   for (const PageId& page : pages) {
     setImageRotationLocked(page.imageId(), rotation);
+    m_orientationDecided.insert(page.imageId());
   }
 }
 
+void Settings::applyDefaultRotation(const ImageId& imageId, const OrthogonalRotation rotation) {
+  QMutexLocker locker(&m_mutex);
+  setImageRotationLocked(imageId, rotation);
+}
+
+void Settings::applyDetectedRotation(const ImageId& imageId, const OrthogonalRotation rotation) {
+  QMutexLocker locker(&m_mutex);
+  setImageRotationLocked(imageId, rotation);
+  m_orientationDecided.insert(imageId);
+}
+
+void Settings::markOrientationDecided(const ImageId& imageId) {
+  QMutexLocker locker(&m_mutex);
+  m_orientationDecided.insert(imageId);
+}
+
 OrthogonalRotation Settings::getRotationFor(const ImageId& imageId) const {
   QMutexLocker locker(&m_mutex);
 
@@ -65,4 +94,9 @@ bool Settings::isRotationNull(const ImageId& imageId) const {
   QMutexLocker locker(&m_mutex);
   return (m_perImageRotation.find(imageId) == m_perImageRotation.end());
 }
+
+bool Settings::isOrientationDetectionNeeded(const ImageId& imageId) const {
+  QMutexLocker locker(&m_mutex);
+  return (m_orientationDecided.find(imageId) == m_orientationDecided.end());
+}
 }  // namespace fix_orientation
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include <QMutex>
 #include <set>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "ImageId.h"
 #include "NonCopyable.h"
@@ -28,14 +29,46 @@ class Settings {
 
   void performRelinking(const AbstractRelinker& relinker);
 
+  /**
+   * \brief Sets the rotation chosen by the user.
+   *
+   * Such images are excluded from automatic orientation detection.
+   */
   void applyRotation(const ImageId& imageId, OrthogonalRotation rotation);
 
   void applyRotation(const std::set<PageId>& pages, OrthogonalRotation rotation);
 
+  /**
+   * \brief Sets the rotation coming from the default parameters profile.
+   *
+   * Unlike applyRotation(), automatic orientation detection may still override it.
+   */
+  void applyDefaultRotation(const ImageId& imageId, OrthogonalRotation rotation);
+
+  /**
+   * \brief Sets the rotation found by automatic orientation detection.
+   *
+   * The detection won't run again for this image.
+   */
+  void applyDetectedRotation(const ImageId& imageId, OrthogonalRotation rotation);
+
+  /**
+   * \brief Marks the image as analyzed while keeping its current rotation.
+   *
+   * Used when the detection wasn't confident enough to change anything.
+   */
+  void markOrientationDecided(const ImageId& imageId);
+
   OrthogonalRotation getRotationFor(const ImageId& imageId) const;
 
   bool isRotationNull(const ImageId& imageId) const;
 
+  /**
+   * \brief Returns true if neither the user nor the orientation detector
+   *        has decided on the rotation of this image yet.
+   */
+  bool isOrientationDetectionNeeded(const ImageId& imageId) const;
+
  private:
   using PerImageRotation = std::unordered_map<ImageId, OrthogonalRotation>;
 
@@ -43,6 +76,7 @@ class Settings {
 
   mutable QMutex m_mutex;
   PerImageRotation m_perImageRotation;
+  std::unordered_set<ImageId> m_orientationDecided;
 };
 }  // namespace fix_orientation
 #endif  // ifndef SCANTAILOR_FIX_ORIENTATION_SETTINGS_H_
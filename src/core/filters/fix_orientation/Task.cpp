@@ -4,14 +4,17 @@
 #include "Task.h"
 
 #include <UnitsProvider.h>
+#include <core/ApplicationSettings.h>
 
 #include <utility>
 
+#include "Dpi.h"
 #include "Dpm.h"
 #include "Filter.h"
 #include "FilterUiInterface.h"
 #include "ImageView.h"
 #include "OptionsWidget.h"
+#include "OrientationDetector.h"
 #include "Settings.h"
 #include "TaskStatus.h"
 #include "filters/page_split/Task.h"
@@ -46,14 +49,16 @@ Task::Task(const PageId& pageId,
            std::shared_ptr<Settings> settings,
            std::shared_ptr<ImageSettings> imageSettings,
            std::shared_ptr<page_split::Task> nextTask,
-           const bool batchProcessing)
+           const bool batchProcessing,
+           const bool speculative)
     : m_filter(std::move(filter)),
       m_nextTask(std::move(nextTask)),
       m_settings(std::move(settings)),
       m_imageSettings(std::move(imageSettings)),
       m_pageId(pageId),
       m_imageId(m_pageId.imageId()),
-      m_batchProcessing(batchProcessing) {}
+      m_batchProcessing(batchProcessing),
+      m_speculative(speculative) {}
 
 Task::~Task() = default;
 
@@ -61,7 +66,20 @@ FilterResultPtr Task::process(const TaskStatus& status, FilterData data) {
   // This function is executed from the worker thread.
   status.throwIfCancelled();
 
-  updateFilterData(data);
+  const bool needDetection = m_batchProcessing && ApplicationSettings::getInstance().isAutoOrientationDetectionEnabled()
+                             && m_settings->isOrientationDetectionNeeded(m_imageId);
+  if (m_speculative) {
+    const std::unique_ptr<ImageSettings::PageParams> params = m_imageSettings->getPageParams(m_pageId);
+    if (!params || needDetection) {
+      return nullptr;
+    }
+    data.updateImageParams(*params);
+  } else {
+    updateFilterData(data);
+    if (needDetection) {
+      detectOrientation(status, data);
+    }
+  }
 
   ImageTransformation xform(data.xform());
   xform.setPreRotation(m_settings->getRotationFor(m_imageId));
@@ -77,13 +95,30 @@ void Task::updateFilterData(FilterData& data) {
   if (const std::unique_ptr<ImageSettings::PageParams> params = m_imageSettings->getPageParams(m_pageId)) {
     data.updateImageParams(*params);
   } else {
-    ImageSettings::PageParams newParams(BinaryThreshold::otsuThreshold(data.grayImage()), true);
+    // Any threshold between black and white gives the same bits for a bitonal page.
+    const BinaryThreshold threshold(data.isBitonal() ? BinaryThreshold(128)
+                                                     : BinaryThreshold::otsuThreshold(data.grayImage()));
+    ImageSettings::PageParams newParams(threshold, true);
 
     m_imageSettings->setPageParams(m_pageId, newParams);
     data.updateImageParams(newParams);
   }
 }
 
+void Task::detectOrientation(const TaskStatus& status, const FilterData& data) {
+  OrientationDetector detector;
+  const Dpi dpi(Dpm(data.origImage()));
+  const DetectedOrientation orientation = data.isBitonal()
+                                              ? detector.detect(status, data.binaryImageBlackOnWhite(), dpi)
+                                              : detector.detect(status, data.grayImageBlackOnWhite(), dpi);
+
+  if (orientation.confidence() >= DetectedOrientation::GOOD_CONFIDENCE) {
+    m_settings->applyDetectedRotation(m_imageId, orientation.rotation());
+  } else {
+    m_settings->markOrientationDecided(m_imageId);
+  }
+}
+
 /*============================ Task::UiUpdater ========================*/
 
 Task::UiUpdater::UiUpdater(std::shared_ptr<Filter> filter,
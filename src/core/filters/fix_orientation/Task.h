@@ -32,10 +32,15 @@ class Task {
        std::shared_ptr<Settings> settings,
        std::shared_ptr<ImageSettings> imageSettings,
        std::shared_ptr<page_split::Task> nextTask,
-       bool batchProcessing);
+       bool batchProcessing,
+       bool speculative);
 
   virtual ~Task();
 
+  /**
+   * In the speculative mode, nothing is detected and nothing is stored.  If the page
+   * has yet to be processed for real, nothing is returned and the chain stops here.
+   */
   FilterResultPtr process(const TaskStatus& status, FilterData data);
 
  private:
@@ -43,6 +48,8 @@ class Task {
 
   void updateFilterData(FilterData& data);
 
+  void detectOrientation(const TaskStatus& status, const FilterData& data);
+
   std::shared_ptr<Filter> m_filter;
   std::shared_ptr<page_split::Task> m_nextTask;  // if null, this task is the final one
   std::shared_ptr<Settings> m_settings;
@@ -50,6 +57,7 @@ class Task {
   PageId m_pageId;
   ImageId m_imageId;
   bool m_batchProcessing;
+  bool m_speculative;
 };
 }  // namespace fix_orientation
 #endif  // ifndef SCANTAILOR_FIX_ORIENTATION_TASK_H_
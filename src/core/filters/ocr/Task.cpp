@@ -21,6 +21,7 @@
 #include "OptionsWidget.h"
 #include "Settings.h"
 #include "TaskStatus.h"
+#include "TiffBookContainer.h"
 #include "filters/output/Task.h"
 
 namespace ocr {
@@ -152,6 +153,9 @@ FilterResultPtr Task::process(const TaskStatus& status, const FilterData& data,
                  << "size:" << outputImage.width() << "x" << outputImage.height();
       }
     }
+    if (outputImage.isNull() && m_outFileNameGen.bookContainer()) {
+      outputImage = m_outFileNameGen.bookContainer()->readPage(QFileInfo(outputFilePath).fileName());
+    }
 
     if (outputImage.isNull()) {
       qWarning() << "OCR: Output image unavailable" << outputFilePath;
@@ -16,6 +16,7 @@ BlackWhiteOptions::BlackWhiteOptions()
       m_savitzkyGolaySmoothingEnabled(true),
       m_morphologicalSmoothingEnabled(true),
       m_normalizeIllumination(true),
+      m_backgroundEstimationMethod(BackgroundEstimationMethod::POLYNOMIAL),
       m_windowSize(200),
       m_sauvolaCoef(0.34),
       m_wolfLowerBound(1),
@@ -28,6 +29,7 @@ BlackWhiteOptions::BlackWhiteOptions(const QDomElement& el)
       m_savitzkyGolaySmoothingEnabled(el.attribute("savitzkyGolaySmoothing") == "1"),
       m_morphologicalSmoothingEnabled(el.attribute("morphologicalSmoothing") == "1"),
       m_normalizeIllumination(el.attribute("normalizeIlluminationBW") == "1"),
+      m_backgroundEstimationMethod(parseBackgroundEstimationMethod(el.attribute("backgroundEstimation"))),
       m_windowSize(el.attribute("windowSize").toInt()),
       m_sauvolaCoef(el.attribute("sauvolaCoef").toDouble()),
       m_wolfLowerBound(el.attribute("wolfLowerBound").toInt()),
@@ -42,6 +44,7 @@ QDomElement BlackWhiteOptions::toXml(QDomDocument& doc, const QString& name) con
   el.setAttribute("savitzkyGolaySmoothing", m_savitzkyGolaySmoothingEnabled ? "1" : "0");
   el.setAttribute("morphologicalSmoothing", m_morphologicalSmoothingEnabled ? "1" : "0");
   el.setAttribute("normalizeIlluminationBW", m_normalizeIllumination ? "1" : "0");
+  el.setAttribute("backgroundEstimation", formatBackgroundEstimationMethod(m_backgroundEstimationMethod));
   el.setAttribute("windowSize", m_windowSize);
   el.setAttribute("sauvolaCoef", Utils::doubleToString(m_sauvolaCoef));
   el.setAttribute("wolfLowerBound", m_wolfLowerBound);
@@ -56,7 +59,8 @@ bool BlackWhiteOptions::operator==(const BlackWhiteOptions& other) const {
   return (m_thresholdAdjustment == other.m_thresholdAdjustment)
          && (m_savitzkyGolaySmoothingEnabled == other.m_savitzkyGolaySmoothingEnabled)
          && (m_morphologicalSmoothingEnabled == other.m_morphologicalSmoothingEnabled)
-         && (m_normalizeIllumination == other.m_normalizeIllumination) && (m_windowSize == other.m_windowSize)
+         && (m_normalizeIllumination == other.m_normalizeIllumination)
+         && (m_backgroundEstimationMethod == other.m_backgroundEstimationMethod) && (m_windowSize == other.m_windowSize)
          && (m_sauvolaCoef == other.m_sauvolaCoef) && (m_wolfLowerBound == other.m_wolfLowerBound)
          && (m_wolfUpperBound == other.m_wolfUpperBound) && (m_wolfCoef == other.m_wolfCoef)
          && (m_binarizationMethod == other.m_binarizationMethod)
@@ -183,6 +187,27 @@ QString BlackWhiteOptions::formatBinarizationMethod(BinarizationMethod type) {
   return str;
 }
 
+BackgroundEstimationMethod BlackWhiteOptions::parseBackgroundEstimationMethod(const QString& str) {
+  if (str == "tiled") {
+    return BackgroundEstimationMethod::TILED_ROBUST;
+  } else {
+    return BackgroundEstimationMethod::POLYNOMIAL;
+  }
+}
+
+QString BlackWhiteOptions::formatBackgroundEstimationMethod(const BackgroundEstimationMethod method) {
+  QString str = "";
+  switch (method) {
+    case BackgroundEstimationMethod::POLYNOMIAL:
+      str = "polynomial";
+      break;
+    case BackgroundEstimationMethod::TILED_ROBUST:
+      str = "tiled";
+      break;
+  }
+  return str;
+}
+
 /*=============================== BlackWhiteOptions::ColorSegmenterOptions ==================================*/
 
 BlackWhiteOptions::ColorSegmenterOptions::ColorSegmenterOptions()
@@ -4,6 +4,8 @@
 #ifndef SCANTAILOR_OUTPUT_BLACKWHITEOPTIONS_H_
 #define SCANTAILOR_OUTPUT_BLACKWHITEOPTIONS_H_
 
+#include "EstimateBackground.h"
+
 class QString;
 class QDomDocument;
 class QDomElement;
@@ -72,6 +74,13 @@ class BlackWhiteOptions {
 
   void setNormalizeIllumination(bool val);
 
+  /**
+   * \brief How the background is estimated when normalizing illumination.
+   */
+  BackgroundEstimationMethod backgroundEstimationMethod() const;
+
+  void setBackgroundEstimationMethod(BackgroundEstimationMethod method);
+
   bool isSavitzkyGolaySmoothingEnabled() const;
 
   void setSavitzkyGolaySmoothingEnabled(bool savitzkyGolaySmoothingEnabled);
@@ -113,11 +122,16 @@ class BlackWhiteOptions {
 
   static QString formatBinarizationMethod(BinarizationMethod type);
 
+  static BackgroundEstimationMethod parseBackgroundEstimationMethod(const QString& str);
+
+  static QString formatBackgroundEstimationMethod(BackgroundEstimationMethod method);
+
 
   int m_thresholdAdjustment;
   bool m_savitzkyGolaySmoothingEnabled;
   bool m_morphologicalSmoothingEnabled;
   bool m_normalizeIllumination;
+  BackgroundEstimationMethod m_backgroundEstimationMethod;
   int m_windowSize;
   double m_sauvolaCoef;
   int m_wolfLowerBound;
@@ -208,6 +222,14 @@ inline void BlackWhiteOptions::setNormalizeIllumination(bool val) {
   m_normalizeIllumination = val;
 }
 
+inline BackgroundEstimationMethod BlackWhiteOptions::backgroundEstimationMethod() const {
+  return m_backgroundEstimationMethod;
+}
+
+inline void BlackWhiteOptions::setBackgroundEstimationMethod(BackgroundEstimationMethod method) {
+  m_backgroundEstimationMethod = method;
+}
+
 inline const BlackWhiteOptions::ColorSegmenterOptions& BlackWhiteOptions::getColorSegmenterOptions() const {
   return m_colorSegmenterOptions;
 }
@@ -20,6 +20,7 @@
 #include "Utils.h"
 #include "core/AbstractFilterDataCollector.h"
 #include "core/ThumbnailCollector.h"
+#include "core/TiffBookContainer.h"
 
 namespace output {
 CacheDrivenTask::CacheDrivenTask(std::shared_ptr<Settings> settings, const OutputFileNameGenerator& outFileNameGen)
@@ -93,6 +94,11 @@ void CacheDrivenTask::process(const PageInfo& pageInfo,
         needReprocess = true;
         break;
       }
+      if (const std::shared_ptr<TiffBookContainer> book = m_outFileNameGen.bookContainer()) {
+        needReprocess
+            = !Utils::isBookPageUpToDate(*book, outFileInfo.fileName(), *storedOutputParams, renderParams, false, false);
+        break;
+      }
       if (!renderParams.splitOutput()) {
         if (!outFileInfo.exists()) {
           needReprocess = true;
@@ -47,6 +47,17 @@ void ColorParams::setColorModePresetSet(bool presetSet) {
   m_colorModePresetSet = presetSet;
 }
 
+bool ColorParams::operator==(const ColorParams& other) const {
+  return (m_colorMode == other.m_colorMode) && (m_colorModeUserSet == other.m_colorModeUserSet)
+         && (m_colorModePresetSet == other.m_colorModePresetSet)
+         && (m_colorCommonOptions == other.m_colorCommonOptions) && (m_bwOptions == other.m_bwOptions)
+         && (m_photoAdjustments == other.m_photoAdjustments);
+}
+
+bool ColorParams::operator!=(const ColorParams& other) const {
+  return !(*this == other);
+}
+
 ColorMode ColorParams::parseColorMode(const QString& str) {
   if (str == "bw") {
     return BLACK_AND_WHITE;
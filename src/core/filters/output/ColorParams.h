@@ -61,6 +61,10 @@ class ColorParams {
 
   void setPhotoAdjustments(const weasel::PhotoAdjustments& adj);
 
+  bool operator==(const ColorParams& other) const;
+
+  bool operator!=(const ColorParams& other) const;
+
  private:
   static ColorMode parseColorMode(const QString& str);
 
@@ -24,6 +24,10 @@ class DepthPerception {
 
   double value() const;
 
+  bool operator==(const DepthPerception& other) const { return m_value == other.m_value; }
+
+  bool operator!=(const DepthPerception& other) const { return !(*this == other); }
+
   static constexpr double minValue();
 
   static constexpr double defaultValue();
@@ -0,0 +1,199 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include "DespeckleImageView.h"
+
+#include <QPainter>
+#include <QPointer>
+#include <atomic>
+#include <cmath>
+#include <set>
+#include <utility>
+
+#include "AbstractCommand.h"
+#include "BackgroundExecutor.h"
+#include "ImagePresentation.h"
+
+namespace output {
+class DespeckleImageView::TileCancelHandle {
+ public:
+  void cancel() { m_cancelled.store(true, std::memory_order_relaxed); }
+
+  bool isCancelled() const { return m_cancelled.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<bool> m_cancelled{false};
+};
+
+
+class DespeckleImageView::TileTask : public AbstractCommand<BackgroundExecutor::TaskResultPtr> {
+ public:
+  TileTask(DespeckleImageView* owner,
+           std::shared_ptr<const DespeckleVisualization> visualization,
+           std::shared_ptr<TileCancelHandle> cancelHandle,
+           const DespeckleTileCache::Key& key);
+
+  BackgroundExecutor::TaskResultPtr operator()() override;
+
+ private:
+  QPointer<DespeckleImageView> m_owner;
+  std::shared_ptr<const DespeckleVisualization> m_visualization;
+  std::shared_ptr<TileCancelHandle> m_cancelHandle;
+  DespeckleTileCache::Key m_key;
+};
+
+
+class DespeckleImageView::TileResult : public AbstractCommand<void> {
+ public:
+  TileResult(QPointer<DespeckleImageView> owner,
+             std::shared_ptr<TileCancelHandle> cancelHandle,
+             const DespeckleTileCache::Key& key,
+             QImage tile);
+
+  // This method is called from the main thread.
+  void operator()() override;
+
+ private:
+  QPointer<DespeckleImageView> m_owner;
+  std::shared_ptr<TileCancelHandle> m_cancelHandle;
+  DespeckleTileCache::Key m_key;
+  QImage m_tile;
+};
+
+
+/*========================== DespeckleImageView ===========================*/
+
+DespeckleImageView::DespeckleImageView(const DespeckleVisualization& visualization,
+                                       std::shared_ptr<DespeckleTileCache> tileCache,
+                                       const Margins& margins)
+    : ImageViewBase(visualization.image(),
+                    visualization.downscaledImage(),
+                    ImagePresentation(QTransform(), QRectF(visualization.image().rect())),
+                    margins),
+      m_visualization(std::make_shared<const DespeckleVisualization>(visualization)),
+      m_tileCache(std::move(tileCache)),
+      m_dragHandler(*this),
+      m_zoomHandler(*this) {
+  rootInteractionHandler().makeLastFollower(*this);
+  rootInteractionHandler().makeLastFollower(m_dragHandler);
+  rootInteractionHandler().makeLastFollower(m_zoomHandler);
+}
+
+DespeckleImageView::~DespeckleImageView() {
+  cancelPendingTiles();
+}
+
+void DespeckleImageView::onPaint(QPainter& painter, const InteractionState& interaction) {
+  const QRect imageRect(m_visualization->image().rect());
+  const QRect visibleRect(
+      widgetToImage().map(QRectF(viewport()->rect())).boundingRect().toAlignedRect().intersected(imageRect));
+
+  const int zoom = zoomLevel();
+  const int span = DespeckleVisualization::TILE_SIZE << zoom;
+
+  painter.setWorldTransform(imageToVirtual() * painter.worldTransform());
+  painter.setRenderHint(QPainter::SmoothPixmapTransform);
+
+  std::set<DespeckleTileCache::Key> visibleTiles;
+  if (!visibleRect.isEmpty()) {
+    for (int row = visibleRect.top() / span; row <= visibleRect.bottom() / span; ++row) {
+      for (int col = visibleRect.left() / span; col <= visibleRect.right() / span; ++col) {
+        const DespeckleTileCache::Key key{m_visualization->level(), zoom, col, row};
+        visibleTiles.insert(key);
+
+        const QImage tile(m_tileCache->find(key));
+        if (tile.isNull()) {
+          requestTile(key);
+        } else {
+          painter.drawImage(QRectF(m_visualization->tileRect(zoom, col, row)), tile);
+        }
+      }
+    }
+  }
+
+  // Don't keep rendering what was scrolled or zoomed away from.
+  for (auto it = m_pendingTiles.begin(); it != m_pendingTiles.end();) {
+    if (visibleTiles.count(it->first) == 0) {
+      it->second->cancel();
+      it = m_pendingTiles.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+int DespeckleImageView::zoomLevel() const {
+  const double scale = std::sqrt(std::abs(imageToWidget().determinant()));
+  if (scale <= 0) {
+    return 0;
+  }
+  const auto level = static_cast<int>(std::floor(std::log2(1.0 / scale)));
+  return qBound(0, level, MAX_ZOOM_LEVEL);
+}
+
+void DespeckleImageView::requestTile(const DespeckleTileCache::Key& key) {
+  if (m_pendingTiles.count(key) != 0) {
+    return;
+  }
+
+  auto cancelHandle = std::make_shared<TileCancelHandle>();
+  m_pendingTiles.emplace(key, cancelHandle);
+
+  const auto task = std::make_shared<TileTask>(this, m_visualization, std::move(cancelHandle), key);
+  backgroundExecutor().enqueueTask(task);
+}
+
+void DespeckleImageView::tileReady(const DespeckleTileCache::Key& key, const QImage& tile) {
+  m_pendingTiles.erase(key);
+  m_tileCache->insert(key, tile);
+  update();
+}
+
+void DespeckleImageView::cancelPendingTiles() {
+  for (const auto& keyAndHandle : m_pendingTiles) {
+    keyAndHandle.second->cancel();
+  }
+  m_pendingTiles.clear();
+}
+
+/*============================== TileTask ===============================*/
+
+DespeckleImageView::TileTask::TileTask(DespeckleImageView* owner,
+                                       std::shared_ptr<const DespeckleVisualization> visualization,
+                                       std::shared_ptr<TileCancelHandle> cancelHandle,
+                                       const DespeckleTileCache::Key& key)
+    : m_owner(owner),
+      m_visualization(std::move(visualization)),
+      m_cancelHandle(std::move(cancelHandle)),
+      m_key(key) {}
+
+BackgroundExecutor::TaskResultPtr DespeckleImageView::TileTask::operator()() {
+  if (m_cancelHandle->isCancelled()) {
+    return nullptr;
+  }
+
+  QImage tile(m_visualization->renderTile(m_key.zoomLevel, m_key.col, m_key.row));
+  if (tile.isNull() || m_cancelHandle->isCancelled()) {
+    return nullptr;
+  }
+  return std::make_shared<TileResult>(m_owner, m_cancelHandle, m_key, std::move(tile));
+}
+
+/*============================= TileResult ==============================*/
+
+DespeckleImageView::TileResult::TileResult(QPointer<DespeckleImageView> owner,
+                                           std::shared_ptr<TileCancelHandle> cancelHandle,
+                                           const DespeckleTileCache::Key& key,
+                                           QImage tile)
+    : m_owner(std::move(owner)), m_cancelHandle(std::move(cancelHandle)), m_key(key), m_tile(std::move(tile)) {}
+
+void DespeckleImageView::TileResult::operator()() {
+  if (m_cancelHandle->isCancelled()) {
+    return;
+  }
+
+  if (DespeckleImageView* owner = m_owner) {
+    owner->tileReady(m_key, m_tile);
+  }
+}
+}  // namespace output
@@ -0,0 +1,69 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#ifndef SCANTAILOR_OUTPUT_DESPECKLEIMAGEVIEW_H_
+#define SCANTAILOR_OUTPUT_DESPECKLEIMAGEVIEW_H_
+
+#include <QImage>
+#include <map>
+#include <memory>
+
+#include "DespeckleTileCache.h"
+#include "DespeckleVisualization.h"
+#include "DragHandler.h"
+#include "ImageViewBase.h"
+#include "InteractionHandler.h"
+#include "Margins.h"
+#include "ZoomHandler.h"
+
+namespace output {
+/**
+ * \brief Shows a DespeckleVisualization, rendering only the tiles in view.
+ *
+ * The plain output is painted by ImageViewBase, while the highlighted tiles
+ * covering the viewport are rendered in background and painted over it.
+ * Tiles are rendered at the power of two zoom level closest to the display
+ * scale from above, so that zooming out doesn't render full resolution tiles
+ * for the whole page.
+ */
+class DespeckleImageView : public ImageViewBase, protected InteractionHandler {
+  Q_OBJECT
+ public:
+  static constexpr int MAX_ZOOM_LEVEL = 5;
+
+  /**
+   * \param visualization A non-null visualization.
+   * \param tileCache The cache to take tiles from and put rendered tiles to.
+   *        It's meant to outlive a particular view, so that switching between
+   *        despeckle levels reuses the tiles rendered before.
+   */
+  DespeckleImageView(const DespeckleVisualization& visualization,
+                     std::shared_ptr<DespeckleTileCache> tileCache,
+                     const Margins& margins = Margins());
+
+  ~DespeckleImageView() override;
+
+ protected:
+  void onPaint(QPainter& painter, const InteractionState& interaction) override;
+
+ private:
+  class TileCancelHandle;
+  class TileTask;
+  class TileResult;
+
+  int zoomLevel() const;
+
+  void requestTile(const DespeckleTileCache::Key& key);
+
+  void tileReady(const DespeckleTileCache::Key& key, const QImage& tile);
+
+  void cancelPendingTiles();
+
+  std::shared_ptr<const DespeckleVisualization> m_visualization;
+  std::shared_ptr<DespeckleTileCache> m_tileCache;
+  std::map<DespeckleTileCache::Key, std::shared_ptr<TileCancelHandle>> m_pendingTiles;
+  DragHandler m_dragHandler;
+  ZoomHandler m_zoomHandler;
+};
+}  // namespace output
+#endif  // ifndef SCANTAILOR_OUTPUT_DESPECKLEIMAGEVIEW_H_
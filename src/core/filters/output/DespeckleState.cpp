@@ -23,7 +23,7 @@ DespeckleState::DespeckleState(const QImage& output,
 }
 
 DespeckleVisualization DespeckleState::visualize() const {
-  return DespeckleVisualization(m_everythingMixed, m_speckles, m_dpi);
+  return DespeckleVisualization(m_everythingMixed, m_speckles, m_dpi, m_despeckleLevel);
 }
 
 DespeckleState DespeckleState::redespeckle(const double level, const TaskStatus& status, DebugImages* dbg) const {
@@ -0,0 +1,42 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include "DespeckleTileCache.h"
+
+#include <algorithm>
+
+namespace output {
+DespeckleTileCache::DespeckleTileCache(const size_t capacity) : m_capacity(std::max<size_t>(capacity, 1)) {}
+
+QImage DespeckleTileCache::find(const Key& key) {
+  const auto it = m_tiles.find(key);
+  if (it == m_tiles.end()) {
+    return QImage();
+  }
+
+  m_lru.splice(m_lru.begin(), m_lru, it->second.lruPos);
+  return it->second.tile;
+}
+
+void DespeckleTileCache::insert(const Key& key, const QImage& tile) {
+  const auto it = m_tiles.find(key);
+  if (it != m_tiles.end()) {
+    it->second.tile = tile;
+    m_lru.splice(m_lru.begin(), m_lru, it->second.lruPos);
+    return;
+  }
+
+  while (m_tiles.size() >= m_capacity) {
+    m_tiles.erase(m_lru.back());
+    m_lru.pop_back();
+  }
+
+  m_lru.push_front(key);
+  m_tiles.emplace(key, Entry{tile, m_lru.begin()});
+}
+
+void DespeckleTileCache::clear() {
+  m_tiles.clear();
+  m_lru.clear();
+}
+}  // namespace output
@@ -0,0 +1,67 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#ifndef SCANTAILOR_OUTPUT_DESPECKLETILECACHE_H_
+#define SCANTAILOR_OUTPUT_DESPECKLETILECACHE_H_
+
+#include <QImage>
+#include <cstddef>
+#include <list>
+#include <map>
+#include <tuple>
+
+namespace output {
+/**
+ * \brief Keeps the most recently used tiles of despeckle visualizations.
+ *
+ * Tiles are keyed by the despeckle level as well, so that going back
+ * to a level seen before doesn't require rendering anything.
+ * Not thread-safe: meant to be accessed from the GUI thread only.
+ */
+class DespeckleTileCache {
+ public:
+  struct Key {
+    double level;
+    int zoomLevel;
+    int col;
+    int row;
+
+    bool operator<(const Key& other) const {
+      return std::tie(level, zoomLevel, col, row) < std::tie(other.level, other.zoomLevel, other.col, other.row);
+    }
+  };
+
+  static constexpr size_t DEFAULT_CAPACITY = 192;
+
+  explicit DespeckleTileCache(size_t capacity = DEFAULT_CAPACITY);
+
+  /**
+   * \brief Looks up a tile, marking it as the most recently used one.
+   *
+   * \return The tile, or a null image if it's not in the cache.
+   */
+  QImage find(const Key& key);
+
+  /**
+   * \brief Stores a tile, evicting the least recently used ones if necessary.
+   */
+  void insert(const Key& key, const QImage& tile);
+
+  size_t size() const { return m_tiles.size(); }
+
+  void clear();
+
+ private:
+  using LruList = std::list<Key>;
+
+  struct Entry {
+    QImage tile;
+    LruList::iterator lruPos;
+  };
+
+  std::map<Key, Entry> m_tiles;
+  LruList m_lru;  // Most recently used tiles go first.
+  size_t m_capacity;
+};
+}  // namespace output
+#endif  // ifndef SCANTAILOR_OUTPUT_DESPECKLETILECACHE_H_
@@ -10,9 +10,10 @@
 #include "AbstractCommand.h"
 #include "BackgroundExecutor.h"
 #include "BackgroundTask.h"
-#include "BasicImageView.h"
 #include "DebugImagesImpl.h"
 #include "Despeckle.h"
+#include "DespeckleImageView.h"
+#include "DespeckleTileCache.h"
 #include "DespeckleVisualization.h"
 #include "ImageViewBase.h"
 #include "OutputMargins.h"
@@ -87,13 +88,14 @@ DespeckleView::DespeckleView(const DespeckleState& despeckleState,
                              bool debug)
     : m_despeckleState(despeckleState),
       m_processingIndicator(new ProcessingIndicationWidget(this)),
+      m_tileCache(std::make_shared<DespeckleTileCache>()),
       m_despeckleLevel(despeckleState.level()),
       m_debug(debug) {
   addWidget(m_processingIndicator);
 
   if (!visualization.isNull()) {
     // Create the image view.
-    auto widget = std::make_unique<BasicImageView>(visualization.image(), visualization.downscaledImage());
+    auto widget = std::make_unique<DespeckleImageView>(visualization, m_tileCache);
     setCurrentIndex(addWidget(widget.release()));
     emit imageViewCreated(dynamic_cast<ImageViewBase*>(widget.get()));
   }
@@ -162,16 +164,15 @@ void DespeckleView::despeckleDone(const DespeckleState& despeckleState,
 
   removeImageViewWidget();
 
-  std::unique_ptr<QWidget> widget
-      = std::make_unique<BasicImageView>(visualization.image(), visualization.downscaledImage(), OutputMargins());
+  std::unique_ptr<QWidget> widget = std::make_unique<DespeckleImageView>(visualization, m_tileCache, OutputMargins());
 
   if (dbg && !dbg->empty()) {
     auto tabWidget = std::make_unique<TabbedDebugImages>();
     tabWidget->addTab(widget.release(), "Main");
-    AutoRemovingFile file;
+    std::shared_ptr<const DebugImageHandle> image;
     QString label;
-    while (!(file = dbg->retrieveNext(&label)).get().isNull()) {
-      tabWidget->addTab(new DebugImageView(file), label);
+    while ((image = dbg->retrieveNext(&label))) {
+      tabWidget->addTab(new DebugImageView(image), label);
     }
     widget = std::move(tabWidget);
   }
@@ -20,6 +20,7 @@ class ProcessingIndicationWidget;
 class ImageViewBase;
 
 namespace output {
+class DespeckleTileCache;
 class DespeckleVisualization;
 
 class DespeckleView : public QStackedWidget {
@@ -70,6 +71,7 @@ class DespeckleView : public QStackedWidget {
   DespeckleState m_despeckleState;
   std::shared_ptr<TaskCancelHandle> m_cancelHandle;
   ProcessingIndicationWidget* m_processingIndicator;
+  std::shared_ptr<DespeckleTileCache> m_tileCache;
   double m_despeckleLevel;
   bool m_debug;
 };
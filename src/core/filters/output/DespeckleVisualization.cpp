@@ -3,46 +3,126 @@
 
 #include "DespeckleVisualization.h"
 
-#include <BinaryImage.h>
+#include <RasterOp.h>
 #include <SEDM.h>
 
-#include <QPainter>
+#include <algorithm>
+#include <cmath>
 
-#include "Dpi.h"
 #include "ImageViewBase.h"
 
 using namespace imageproc;
 
 namespace output {
+namespace {
+const float ALPHA_UPPER_BOUND = 0.7f;
+const float NO_SPECKLES_OVERLAY_ALPHA = 0.3f;
+
+void blendRed(uint32_t& pixel, const float alpha) {
+  const float alpha2 = 1.0f - alpha;
+  const float overlayR = 255;
+  const float overlayG = 0;
+  const float overlayB = 0;
+  const float r = overlayR * alpha + qRed(pixel) * alpha2;
+  const float g = overlayG * alpha + qGreen(pixel) * alpha2;
+  const float b = overlayB * alpha + qBlue(pixel) * alpha2;
+  pixel = qRgb(int(r), int(g), int(b));
+}
+
+bool isBlack(const uint32_t pixel) {
+  return (pixel & 0x00ffffff) == 0x0;
+}
+}  // namespace
+
 DespeckleVisualization::DespeckleVisualization(const QImage& output,
                                                const imageproc::BinaryImage& speckles,
-                                               const Dpi& dpi) {
+                                               const Dpi& dpi,
+                                               const double level)
+    : m_speckles(speckles), m_dpi(dpi), m_level(level) {
   if (output.isNull()) {
     // This can happen in batch processing mode.
     return;
   }
 
   m_image = output.convertToFormat(QImage::Format_RGB32);
+  m_radius = static_cast<float>(45.0 * std::max(dpi.horizontal(), dpi.vertical()) / 600);
+  m_hasSpeckles = !speckles.isNull() && (speckles.countBlackPixels() > 0);
+
+  m_downscaledImage = ImageViewBase::createDownscaledImage(m_image);
+}
+
+QRect DespeckleVisualization::tileRect(const int zoomLevel, const int col, const int row) const {
+  const int span = TILE_SIZE << zoomLevel;
+  return QRect(col * span, row * span, span, span).intersected(m_image.rect());
+}
 
-  if (!speckles.isNull()) {
-    colorizeSpeckles(m_image, speckles, dpi);
+QImage DespeckleVisualization::renderTile(const int zoomLevel, const int col, const int row) const {
+  const QRect rect(tileRect(zoomLevel, col, row));
+  if (rect.isEmpty()) {
+    return QImage();
   }
 
-  m_downscaledImage = ImageViewBase::createDownscaledImage(m_image);
+  QImage tile(render(rect));
+  if (zoomLevel == 0) {
+    return tile;
+  }
+
+  const int scale = 1 << zoomLevel;
+  const QSize size((rect.width() + scale - 1) / scale, (rect.height() + scale - 1) / scale);
+  return tile.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
 }
 
-void DespeckleVisualization::colorizeSpeckles(QImage& image, const imageproc::BinaryImage& speckles, const Dpi& dpi) {
+QImage DespeckleVisualization::render(const QRect& rect) const {
+  const QRect area(rect.intersected(m_image.rect()));
+  if (area.isEmpty()) {
+    return QImage();
+  }
+
+  QImage image(m_image.copy(area));
+  if (!m_speckles.isNull()) {
+    colorizeSpeckles(image, area);
+  }
+  return image;
+}
+
+void DespeckleVisualization::colorizeSpeckles(QImage& image, const QRect& rect) const {
   const int w = image.width();
   const int h = image.height();
   auto* imageLine = (uint32_t*) image.bits();
   const int imageStride = image.bytesPerLine() / 4;
 
+  if (!m_hasSpeckles) {
+    // The distance to the nearest speckle is infinite everywhere.
+    for (int y = 0; y < h; ++y) {
+      for (int x = 0; x < w; ++x) {
+        if (!isBlack(imageLine[x])) {
+          blendRed(imageLine[x], NO_SPECKLES_OVERLAY_ALPHA);
+        }
+      }
+      imageLine += imageStride;
+    }
+    return;
+  }
+
+  // Pixels farther than m_radius from any speckle are left alone, so only
+  // the speckles within that distance of the rect matter.  The extra pixel
+  // covers rounding in the alpha computation below.
+  const int margin = static_cast<int>(std::ceil(m_radius)) + 1;
+  const QRect neighbourhood(rect.adjusted(-margin, -margin, margin, margin).intersected(m_speckles.rect()));
+  if (m_speckles.countBlackPixels(neighbourhood) == 0) {
+    return;
+  }
+
+  BinaryImage speckles(neighbourhood.size());
+  rasterOp<RopSrc>(speckles, speckles.rect(), m_speckles, neighbourhood.topLeft());
+
   const SEDM sedm(speckles, SEDM::DIST_TO_BLACK, SEDM::DIST_TO_NO_BORDERS);
-  const uint32_t* sedmLine = sedm.data();
   const int sedmStride = sedm.stride();
+  const QPoint offset(rect.topLeft() - neighbourhood.topLeft());
+  const uint32_t* sedmLine = sedm.data() + offset.y() * sedmStride + offset.x();
 
-  const float radius = static_cast<float>(45.0 * std::max(dpi.horizontal(), dpi.vertical()) / 600);
-  const float sqRadius = radius * radius;
+  const float sqRadius = m_radius * m_radius;
+  const float scale = ALPHA_UPPER_BOUND / sqRadius;
 
   for (int y = 0; y < h; ++y) {
     for (int x = 0; x < w; ++x) {
@@ -51,24 +131,14 @@ void DespeckleVisualization::colorizeSpeckles(QImage& image, const imageproc::Bi
         // Speckle pixel.
         imageLine[x] = 0xffff0000;  // opaque red
         continue;
-      } else if ((imageLine[x] & 0x00ffffff) == 0x0) {
+      } else if (isBlack(imageLine[x])) {
         // Non-speckle black pixel.
         continue;
       }
 
-      const float alphaUpperBound = 0.7f;
-      const float noSpecklesOverlayAlpha = 0.3f;
-      const float scale = alphaUpperBound / sqRadius;
-      const float alpha = (sqDist == SEDM::INF_DIST) ? noSpecklesOverlayAlpha : alphaUpperBound - scale * sqDist;
+      const float alpha = ALPHA_UPPER_BOUND - scale * sqDist;
       if (alpha > 0) {
-        const float alpha2 = 1.0f - alpha;
-        const float overlayR = 255;
-        const float overlayG = 0;
-        const float overlayB = 0;
-        const float r = overlayR * alpha + qRed(imageLine[x]) * alpha2;
-        const float g = overlayG * alpha + qGreen(imageLine[x]) * alpha2;
-        const float b = overlayB * alpha + qBlue(imageLine[x]) * alpha2;
-        imageLine[x] = qRgb(int(r), int(g), int(b));
+        blendRed(imageLine[x], alpha);
       }
     }
     sedmLine += sedmStride;
@@ -5,17 +5,33 @@
 #ifndef SCANTAILOR_OUTPUT_DESPECKLEVISUALIZATION_H_
 #define SCANTAILOR_OUTPUT_DESPECKLEVISUALIZATION_H_
 
-#include <QImage>
+#include <BinaryImage.h>
 
-class Dpi;
+#include <QImage>
+#include <QRect>
 
-namespace imageproc {
-class BinaryImage;
-}
+#include "Dpi.h"
 
 namespace output {
+/**
+ * \brief Highlights the speckles removed from the output.
+ *
+ * Speckles are painted red, with a red halo fading out around them.
+ * Nothing is colorized up front: the highlighting is rendered on demand,
+ * in tiles, for the areas actually being looked at.  That's because the halo
+ * only reaches a few dozen pixels from a speckle, so a distance field computed
+ * over a tile expanded by the halo radius gives exactly the same pixels as
+ * the one computed over the whole page.
+ */
 class DespeckleVisualization {
  public:
+  /**
+   * A tile is TILE_SIZE pixels across at full resolution.  At zoom level
+   * n it covers TILE_SIZE << n pixels of the output and gets downscaled
+   * to TILE_SIZE.
+   */
+  static constexpr int TILE_SIZE = 256;
+
   /*
    * Constructs a null visualization.
    */
@@ -27,20 +43,53 @@ class DespeckleVisualization {
    * \param speckles Speckles detected in the image.
    *        If this one is null, it is considered no speckles were detected.
    * \param dpi Dots-per-inch of both images.
+   * \param level The despeckle level the speckles were detected with.
+   *        It only serves to tell apart the tiles of different visualizations.
    */
-  DespeckleVisualization(const QImage& output, const imageproc::BinaryImage& speckles, const Dpi& dpi);
+  DespeckleVisualization(const QImage& output, const imageproc::BinaryImage& speckles, const Dpi& dpi, double level = 0);
 
   bool isNull() const;
 
+  /**
+   * \brief The output without any highlighting.
+   *
+   * The tiles are meant to be painted over it.
+   */
   const QImage& image() const;
 
   const QImage& downscaledImage() const;
 
+  double level() const;
+
+  /**
+   * \brief The area of image() covered by a tile, clipped to image().
+   */
+  QRect tileRect(int zoomLevel, int col, int row) const;
+
+  /**
+   * \brief Renders a tile.  Can be called from any thread.
+   *
+   * \return An image of tileRect(zoomLevel, col, row).size() >> zoomLevel pixels,
+   *         or a null image if the tile is outside of image().
+   */
+  QImage renderTile(int zoomLevel, int col, int row) const;
+
+  /**
+   * \brief Renders an arbitrary area of image() at full resolution.
+   *        Can be called from any thread.
+   */
+  QImage render(const QRect& rect) const;
+
  private:
-  static void colorizeSpeckles(QImage& image, const imageproc::BinaryImage& speckles, const Dpi& dpi);
+  void colorizeSpeckles(QImage& image, const QRect& rect) const;
 
   QImage m_image;
   QImage m_downscaledImage;
+  imageproc::BinaryImage m_speckles;
+  Dpi m_dpi;
+  double m_level = 0;
+  float m_radius = 0;
+  bool m_hasSpeckles = false;
 };
 
 
@@ -51,5 +100,9 @@ inline const QImage& DespeckleVisualization::image() const {
 inline const QImage& DespeckleVisualization::downscaledImage() const {
   return m_downscaledImage;
 }
+
+inline double DespeckleVisualization::level() const {
+  return m_level;
+}
 }  // namespace output
 #endif  // ifndef SCANTAILOR_OUTPUT_DESPECKLEVISUALIZATION_H_
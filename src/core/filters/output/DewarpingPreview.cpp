@@ -0,0 +1,116 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include "DewarpingPreview.h"
+
+#include <DistortionModel.h>
+#include <Dpi.h>
+#include <Dpm.h>
+#include <RasterDewarper.h>
+#include <Transform.h>
+
+#include <QColor>
+#include <QPolygonF>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+using namespace imageproc;
+using namespace dewarping;
+
+namespace output {
+namespace {
+std::vector<QPointF> mapPolyline(const std::vector<QPointF>& polyline, const QTransform& xform) {
+  std::vector<QPointF> mapped;
+  mapped.reserve(polyline.size());
+  for (const QPointF& pt : polyline) {
+    mapped.push_back(xform.map(pt));
+  }
+  return mapped;
+}
+
+QRectF mappedBoundingRect(const DistortionModel& model, const QTransform& xform) {
+  QPolygonF points;
+  for (const QPointF& pt : model.topCurve().polyline()) {
+    points << xform.map(pt);
+  }
+  for (const QPointF& pt : model.bottomCurve().polyline()) {
+    points << xform.map(pt);
+  }
+  return points.boundingRect();
+}
+}  // namespace
+
+/*=========================== DewarpingPreview ===========================*/
+
+DewarpingPreview::DewarpingPreview(const QImage& image) {
+  if (image.isNull()) {
+    return;
+  }
+
+  const Dpm dpm(image);
+  const Dpi dpi(dpm.isNull() ? Dpi(300, 300) : Dpi(dpm));
+  const double xScale = std::min(1.0, double(PROXY_DPI) / dpi.horizontal());
+  const double yScale = std::min(1.0, double(PROXY_DPI) / dpi.vertical());
+  const QSize proxySize(std::max(1, static_cast<int>(std::lround(image.width() * xScale))),
+                        std::max(1, static_cast<int>(std::lround(image.height() * yScale))));
+
+  m_imageToProxy = QTransform::fromScale(double(proxySize.width()) / image.width(),
+                                         double(proxySize.height()) / image.height());
+  if (proxySize == image.size()) {
+    m_proxy = image;
+  } else {
+    m_proxy = transform(image, m_imageToProxy, QRect(QPoint(0, 0), proxySize), OutsidePixels::assumeColor(Qt::white));
+  }
+}
+
+DewarpingPreview::Geometry DewarpingPreview::geometry(const DistortionModel& model,
+                                                      const double depthPerception) const {
+  return Geometry(model, depthPerception, m_imageToProxy);
+}
+
+QImage DewarpingPreview::render(const DistortionModel& model, const double depthPerception) const {
+  if (isNull() || !model.isValid()) {
+    return QImage();
+  }
+
+  try {
+    const Geometry geom(model, depthPerception, m_imageToProxy);
+    if (geom.size().isEmpty()) {
+      return QImage();
+    }
+    return RasterDewarper::dewarp(m_proxy, geom.size(), geom.dewarper(), geom.modelDomain(), Qt::white);
+  } catch (const std::runtime_error&) {
+    // Still probably a bad model, even though DistortionModel::isValid() was true.
+    return QImage();
+  }
+}
+
+/*====================== DewarpingPreview::Geometry ======================*/
+
+DewarpingPreview::Geometry::Geometry(const DistortionModel& model,
+                                     const double depthPerception,
+                                     const QTransform& imageToTarget)
+    : m_dewarper(mapPolyline(model.topCurve().polyline(), imageToTarget),
+                 mapPolyline(model.bottomCurve().polyline(), imageToTarget),
+                 depthPerception),
+      m_targetToImage(imageToTarget.inverted()) {
+  const QRectF targetBounds(mappedBoundingRect(model, imageToTarget));
+  // The same vertical shrinking as in the output, but the result is moved
+  // to the origin, as the preview has no content box to be placed in.
+  const QRectF domain(model.modelDomain(m_dewarper, imageToTarget, targetBounds));
+  m_modelDomain = QRectF(QPointF(0, 0), domain.size());
+}
+
+QSize DewarpingPreview::Geometry::size() const {
+  return QSize(static_cast<int>(std::lround(m_modelDomain.width())),
+               static_cast<int>(std::lround(m_modelDomain.height())));
+}
+
+QPointF DewarpingPreview::Geometry::mapToImage(const QPointF& dewarpedPt) const {
+  const QPointF crvPt((dewarpedPt.x() - m_modelDomain.left()) / m_modelDomain.width(),
+                      (dewarpedPt.y() - m_modelDomain.top()) / m_modelDomain.height());
+  return m_targetToImage.map(m_dewarper.mapToWarpedSpace(crvPt));
+}
+}  // namespace output
@@ -0,0 +1,96 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#ifndef SCANTAILOR_OUTPUT_DEWARPINGPREVIEW_H_
+#define SCANTAILOR_OUTPUT_DEWARPINGPREVIEW_H_
+
+#include <CylindricalSurfaceDewarper.h>
+
+#include <QImage>
+#include <QPointF>
+#include <QRectF>
+#include <QSize>
+#include <QTransform>
+
+namespace dewarping {
+class DistortionModel;
+}
+
+namespace output {
+/**
+ * \brief A low resolution copy of a page that can be dewarped fast enough
+ *        to follow the mouse while the distortion model is being edited.
+ *
+ * The full resolution output is only regenerated once the user lets go of
+ * a handle.  Until then, DewarpingView shows this proxy warped through the
+ * same CylindricalSurfaceDewarper the output generator would use.
+ */
+class DewarpingPreview {
+ public:
+  static constexpr int PROXY_DPI = 100;
+
+  /**
+   * \brief Maps between a dewarped image and the original image.
+   *
+   * The dewarped image covers the model domain translated to the origin,
+   * so its size only depends on the model and the target resolution.
+   */
+  class Geometry {
+   public:
+    /**
+     * \param imageToTarget Transforms from the original image coordinates,
+     *        where the curves are defined, to the coordinates of the image
+     *        being dewarped.
+     * \throw std::runtime_error For models CylindricalSurfaceDewarper can't handle.
+     */
+    Geometry(const dewarping::DistortionModel& model, double depthPerception, const QTransform& imageToTarget);
+
+    const dewarping::CylindricalSurfaceDewarper& dewarper() const { return m_dewarper; }
+
+    const QRectF& modelDomain() const { return m_modelDomain; }
+
+    QSize size() const;
+
+    /**
+     * \brief Maps a point of the dewarped image to the original image coordinates.
+     */
+    QPointF mapToImage(const QPointF& dewarpedPt) const;
+
+   private:
+    dewarping::CylindricalSurfaceDewarper m_dewarper;
+    QTransform m_targetToImage;
+    QRectF m_modelDomain;
+  };
+
+  /**
+   * \brief Constructs a null preview.
+   */
+  DewarpingPreview() = default;
+
+  /**
+   * \param image The original image the distortion model is defined on.
+   *        Its resolution is taken from the image itself.
+   */
+  explicit DewarpingPreview(const QImage& image);
+
+  bool isNull() const { return m_proxy.isNull(); }
+
+  const QImage& proxy() const { return m_proxy; }
+
+  const QTransform& imageToProxy() const { return m_imageToProxy; }
+
+  Geometry geometry(const dewarping::DistortionModel& model, double depthPerception) const;
+
+  /**
+   * \brief Dewarps the proxy.  Can be called from any thread.
+   *
+   * \return The dewarped proxy, or a null image if the model can't be dewarped.
+   */
+  QImage render(const dewarping::DistortionModel& model, double depthPerception) const;
+
+ private:
+  QImage m_proxy;
+  QTransform m_imageToProxy;
+};
+}  // namespace output
+#endif  // ifndef SCANTAILOR_OUTPUT_DEWARPINGPREVIEW_H_
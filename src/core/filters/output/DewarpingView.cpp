@@ -7,9 +7,16 @@
 
 #include <QDebug>
 #include <QPainter>
+#include <QPointer>
 #include <QShortcut>
+#include <atomic>
 #include <boost/bind/bind.hpp>
+#include <mutex>
+#include <utility>
 
+#include "AbstractCommand.h"
+#include "BackgroundExecutor.h"
+#include "DewarpingPreview.h"
 #include "ImagePresentation.h"
 #include "ToLineProjector.h"
 #include "spfit/ConstraintSet.h"
@@ -18,6 +25,75 @@
 #include "spfit/SplineFitter.h"
 
 namespace output {
+/**
+ * Builds the low resolution proxy the first time a preview is rendered,
+ * in the background, so views the user never drags in don't pay for it.
+ */
+class DewarpingView::PreviewSource {
+ public:
+  explicit PreviewSource(const QImage& image) : m_image(image) {}
+
+  const DewarpingPreview& preview() {
+    std::call_once(m_previewBuilt, [this]() {
+      m_preview = DewarpingPreview(m_image);
+      m_image = QImage();
+    });
+    return m_preview;
+  }
+
+ private:
+  QImage m_image;
+  std::once_flag m_previewBuilt;
+  DewarpingPreview m_preview;
+};
+
+
+class DewarpingView::PreviewCancelHandle {
+ public:
+  void cancel() { m_cancelled.store(true, std::memory_order_relaxed); }
+
+  bool isCancelled() const { return m_cancelled.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<bool> m_cancelled{false};
+};
+
+
+class DewarpingView::PreviewTask : public AbstractCommand<BackgroundExecutor::TaskResultPtr> {
+ public:
+  PreviewTask(DewarpingView* owner,
+              std::shared_ptr<PreviewSource> previewSource,
+              std::shared_ptr<PreviewCancelHandle> cancelHandle,
+              const dewarping::DistortionModel& distortionModel,
+              double depthPerception);
+
+  BackgroundExecutor::TaskResultPtr operator()() override;
+
+ private:
+  QPointer<DewarpingView> m_owner;
+  std::shared_ptr<PreviewSource> m_previewSource;
+  std::shared_ptr<PreviewCancelHandle> m_cancelHandle;
+  dewarping::DistortionModel m_distortionModel;
+  double m_depthPerception;
+};
+
+
+class DewarpingView::PreviewResult : public AbstractCommand<void> {
+ public:
+  PreviewResult(QPointer<DewarpingView> owner, std::shared_ptr<PreviewCancelHandle> cancelHandle, QImage frame);
+
+  // This method is called from the main thread.
+  void operator()() override;
+
+ private:
+  QPointer<DewarpingView> m_owner;
+  std::shared_ptr<PreviewCancelHandle> m_cancelHandle;
+  QImage m_frame;
+};
+
+
+/*============================ DewarpingView ==============================*/
+
 DewarpingView::DewarpingView(const QImage& image,
                              const ImagePixmapUnion& downscaledImage,
                              const QTransform& imageToVirt,
@@ -36,7 +112,8 @@ DewarpingView::DewarpingView(const QImage& image,
       m_topSpline(*this),
       m_bottomSpline(*this),
       m_dragHandler(*this),
-      m_zoomHandler(*this) {
+      m_zoomHandler(*this),
+      m_previewSource(std::make_shared<PreviewSource>(image)) {
   setMouseTracking(true);
 
   const QPolygonF sourceContentRect(virtualToImage().map(virtContentRect));
@@ -98,7 +175,9 @@ DewarpingView::DewarpingView(const QImage& image,
   });
 }
 
-DewarpingView::~DewarpingView() = default;
+DewarpingView::~DewarpingView() {
+  cancelPreview();
+}
 
 void DewarpingView::initNewSpline(XSpline& spline,
                                   const QPointF& p1,
@@ -220,6 +299,10 @@ void DewarpingView::onPaint(QPainter& painter, const InteractionState& interacti
 
   paintXSpline(painter, interaction, m_topSpline);
   paintXSpline(painter, interaction, m_bottomSpline);
+
+  if (!m_previewFrame.isNull()) {
+    paintPreview(painter);
+  }
 }  // DewarpingView::onPaint
 
 void DewarpingView::paintXSpline(QPainter& painter,
@@ -272,16 +355,67 @@ void DewarpingView::curveModified(int curveIdx) {
   } else {
     m_distortionModel.setBottomCurve(dewarping::Curve(m_bottomSpline.spline()));
   }
+  if (interactionState().captured()) {
+    // A handle is being dragged.
+    requestPreview();
+  }
   update();
 }
 
 void DewarpingView::dragFinished() {
+  // The full resolution output is about to be regenerated.
+  cancelPreview();
+  m_previewFrame = QImage();
+  update();
+
   if ((m_dewarpingOptions.dewarpingMode() == AUTO) || (m_dewarpingOptions.dewarpingMode() == MARGINAL)) {
     m_dewarpingOptions.setDewarpingMode(MANUAL);
   }
   emit distortionModelChanged(m_distortionModel);
 }
 
+void DewarpingView::requestPreview() {
+  cancelPreview();
+  m_previewCancelHandle = std::make_shared<PreviewCancelHandle>();
+
+  const auto task = std::make_shared<PreviewTask>(this, m_previewSource, m_previewCancelHandle, m_distortionModel,
+                                                  m_depthPerception.value());
+  backgroundExecutor().enqueueTask(task);
+}
+
+void DewarpingView::previewReady(const QImage& frame) {
+  m_previewFrame = frame;
+  update();
+}
+
+void DewarpingView::cancelPreview() {
+  if (m_previewCancelHandle) {
+    m_previewCancelHandle->cancel();
+    m_previewCancelHandle.reset();
+  }
+}
+
+void DewarpingView::paintPreview(QPainter& painter) const {
+  // The dewarped proxy goes to the top-right corner, in widget coordinates.
+  const int margin = 8;
+  const QSizeF maxSize(width() * 0.35, height() * 0.35);
+  const QSizeF frameSize(QSizeF(m_previewFrame.size()).scaled(maxSize, Qt::KeepAspectRatio));
+  const QRectF target(QPointF(width() - margin - frameSize.width(), margin), frameSize);
+
+  painter.save();
+  painter.setWorldMatrixEnabled(false);
+  painter.setRenderHint(QPainter::SmoothPixmapTransform);
+  painter.drawImage(target, m_previewFrame);
+
+  QPen framePen(Qt::blue);
+  framePen.setCosmetic(true);
+  framePen.setWidthF(1.2);
+  painter.setPen(framePen);
+  painter.setBrush(Qt::NoBrush);
+  painter.drawRect(target);
+  painter.restore();
+}
+
 /** Source image coordinates to widget coordinates. */
 QPointF DewarpingView::sourceToWidget(const QPointF& pt) const {
   return virtualToWidget().map(imageToVirtual().map(pt));
@@ -348,4 +482,52 @@ QPolygonF DewarpingView::virtMarginArea(int marginIdx) const {
   poly << vertBoundary.pointAt(min) + normal.pointAt(normalMax) - normal.p1();
   return m_virtDisplayArea.intersected(poly);
 }  // DewarpingView::virtMarginArea
+
+/*============================= PreviewTask ============================*/
+
+DewarpingView::PreviewTask::PreviewTask(DewarpingView* owner,
+                                        std::shared_ptr<PreviewSource> previewSource,
+                                        std::shared_ptr<PreviewCancelHandle> cancelHandle,
+                                        const dewarping::DistortionModel& distortionModel,
+                                        const double depthPerception)
+    : m_owner(owner),
+      m_previewSource(std::move(previewSource)),
+      m_cancelHandle(std::move(cancelHandle)),
+      m_distortionModel(distortionModel),
+      m_depthPerception(depthPerception) {}
+
+BackgroundExecutor::TaskResultPtr DewarpingView::PreviewTask::operator()() {
+  // The mouse has moved on since this frame was requested.
+  if (m_cancelHandle->isCancelled()) {
+    return nullptr;
+  }
+
+  const DewarpingPreview& preview = m_previewSource->preview();
+  if (preview.isNull() || m_cancelHandle->isCancelled()) {
+    return nullptr;
+  }
+
+  QImage frame(preview.render(m_distortionModel, m_depthPerception));
+  if (frame.isNull() || m_cancelHandle->isCancelled()) {
+    return nullptr;
+  }
+  return std::make_shared<PreviewResult>(m_owner, m_cancelHandle, std::move(frame));
+}
+
+/*============================= PreviewResult ==========================*/
+
+DewarpingView::PreviewResult::PreviewResult(QPointer<DewarpingView> owner,
+                                            std::shared_ptr<PreviewCancelHandle> cancelHandle,
+                                            QImage frame)
+    : m_owner(std::move(owner)), m_cancelHandle(std::move(cancelHandle)), m_frame(std::move(frame)) {}
+
+void DewarpingView::PreviewResult::operator()() {
+  if (m_cancelHandle->isCancelled()) {
+    return;
+  }
+
+  if (DewarpingView* owner = m_owner) {
+    owner->previewReady(m_frame);
+  }
+}
 }  // namespace output
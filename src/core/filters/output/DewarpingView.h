@@ -4,10 +4,12 @@
 #ifndef SCANTAILOR_OUTPUT_DEWARPINGVIEW_H_
 #define SCANTAILOR_OUTPUT_DEWARPINGVIEW_H_
 
+#include <QImage>
 #include <QPointF>
 #include <QPolygonF>
 #include <QRectF>
 #include <QTransform>
+#include <memory>
 #include <vector>
 
 #include "DepthPerception.h"
@@ -52,6 +54,11 @@ class DewarpingView : public ImageViewBase, protected InteractionHandler {
   void onPaint(QPainter& painter, const InteractionState& interaction) override;
 
  private:
+  class PreviewSource;
+  class PreviewCancelHandle;
+  class PreviewTask;
+  class PreviewResult;
+
   static void initNewSpline(XSpline& spline,
                             const QPointF& p1,
                             const QPointF& p2,
@@ -65,6 +72,19 @@ class DewarpingView : public ImageViewBase, protected InteractionHandler {
 
   void dragFinished();
 
+  /**
+   * \brief Starts warping the proxy image through the current model in the background.
+   *
+   * A frame still being prepared for an older model is abandoned.
+   */
+  void requestPreview();
+
+  void previewReady(const QImage& frame);
+
+  void cancelPreview();
+
+  void paintPreview(QPainter& painter) const;
+
   QPointF sourceToWidget(const QPointF& pt) const;
 
   QPointF widgetToSource(const QPointF& pt) const;
@@ -81,6 +101,9 @@ class DewarpingView : public ImageViewBase, protected InteractionHandler {
   DragHandler m_dragHandler;
   ZoomHandler m_zoomHandler;
   QShortcut* m_removeControlPointShortcut;
+  std::shared_ptr<PreviewSource> m_previewSource;
+  std::shared_ptr<PreviewCancelHandle> m_previewCancelHandle;
+  QImage m_previewFrame;
 };
 }  // namespace output
 #endif  // ifndef SCANTAILOR_OUTPUT_DEWARPINGVIEW_H_
@@ -0,0 +1,211 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include "DistortionModelEstimator.h"
+
+#include <BinaryImage.h>
+#include <BinaryThreshold.h>
+#include <DistortionModel.h>
+#include <DistortionModelBuilder.h>
+#include <Dpi.h>
+#include <Scale.h>
+#include <TopBottomEdgeTracer.h>
+#include <XSpline.h>
+#include <imageproc/OrthogonalRotation.h>
+
+#include <QImage>
+#include <QLineF>
+#include <QPointF>
+#include <QRect>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "DebugImages.h"
+#include "OrthogonalRotation.h"
+#include "TaskStatus.h"
+
+using namespace imageproc;
+using namespace dewarping;
+
+namespace output {
+namespace {
+// At full resolution, that's how many white pixels in a row were taken to be the margin.
+const int FULL_RESOLUTION_MARGIN_RUN = 16;
+
+std::vector<QPointF> mapPolyline(const std::vector<QPointF>& polyline, const QTransform& xform) {
+  std::vector<QPointF> mapped;
+  mapped.reserve(polyline.size());
+  for (const QPointF& pt : polyline) {
+    mapped.push_back(xform.map(pt));
+  }
+  return mapped;
+}
+
+void movePointToTopMargin(const BinaryImage& bwImage, XSpline& spline, const int idx, const int runLength) {
+  QPointF pos = spline.controlPointPosition(idx);
+
+  for (int j = 0; j < pos.y(); j++) {
+    if (bwImage.getPixel(static_cast<int>(pos.x()), j) == WHITE) {
+      int count = 0;
+      for (int jj = j; jj < (j + runLength); jj++) {
+        if (bwImage.getPixel(static_cast<int>(pos.x()), jj) == WHITE) {
+          count++;
+        }
+      }
+
+      if (count == runLength) {
+        pos.setY(j);
+        spline.moveControlPoint(idx, pos);
+        break;
+      }
+    }
+  }
+}
+
+void movePointToBottomMargin(const BinaryImage& bwImage, XSpline& spline, const int idx, const int runLength) {
+  QPointF pos = spline.controlPointPosition(idx);
+
+  for (int j = bwImage.height() - 1; j > pos.y(); j--) {
+    if (bwImage.getPixel(static_cast<int>(pos.x()), j) == WHITE) {
+      int count = 0;
+      for (int jj = j; jj > (j - runLength); jj--) {
+        if (bwImage.getPixel(static_cast<int>(pos.x()), jj) == WHITE) {
+          count++;
+        }
+      }
+
+      if (count == runLength) {
+        pos.setY(j);
+        spline.moveControlPoint(idx, pos);
+        break;
+      }
+    }
+  }
+}
+
+/**
+ * Sets up a spline going along \p line, with a few extra control points
+ * near the binding side of the page.
+ */
+XSpline marginalSpline(const QLineF& line, const QLineF& intermediateLine, const PageId::SubPage subPage) {
+  const int maxRedPoints = 5;
+  XSpline spline;
+  spline.appendControlPoint(line.p1(), 0);
+  if ((subPage == PageId::SINGLE_PAGE) || (subPage == PageId::LEFT_PAGE)) {
+    for (int i = 29 - maxRedPoints; i < 29; i++) {
+      spline.appendControlPoint(intermediateLine.pointAt((float) i / 29.0), 1);
+    }
+  } else {
+    for (int i = 1; i <= maxRedPoints; i++) {
+      spline.appendControlPoint(intermediateLine.pointAt((float) i / 29.0), 1);
+    }
+  }
+  spline.appendControlPoint(line.p2(), 0);
+  return spline;
+}
+
+void drawPoint(QImage& image, const QPointF& pt) {
+  const QPoint pts = pt.toPoint();
+  const QRect rect(QRect(pts.x() - 5, pts.y() - 5, 10, 10).intersected(image.rect()));
+  for (int i = rect.left(); i <= rect.right(); i++) {
+    for (int j = rect.top(); j <= rect.bottom(); j++) {
+      image.setPixel(i, j, qRgb(255, 0, 0));
+    }
+  }
+}
+}  // namespace
+
+DistortionModelEstimator::DistortionModelEstimator(const GrayImage& original,
+                                                   const Dpi& originalDpi,
+                                                   const int proxyDpi) {
+  const Dpi dpi(originalDpi.isNull() ? Dpi(300, 300) : originalDpi);
+  const double xScale = std::min(1.0, double(proxyDpi) / dpi.horizontal());
+  const double yScale = std::min(1.0, double(proxyDpi) / dpi.vertical());
+
+  if ((xScale >= 1.0) && (yScale >= 1.0)) {
+    m_proxy = original;
+  } else {
+    const QSize proxySize(std::max(1, static_cast<int>(std::lround(original.width() * xScale))),
+                          std::max(1, static_cast<int>(std::lround(original.height() * yScale))));
+    m_proxy = scaleToGray(original, proxySize);
+    m_originalToProxy = QTransform::fromScale(double(proxySize.width()) / original.width(),
+                                              double(proxySize.height()) / original.height());
+    m_proxyToOriginal = m_originalToProxy.inverted();
+  }
+
+  // The margin search goes along columns, so it's the vertical scale that matters.
+  m_marginRunLength = std::max(2, static_cast<int>(std::lround(FULL_RESOLUTION_MARGIN_RUN * m_originalToProxy.m22())));
+}
+
+DistortionModel DistortionModelEstimator::buildAutoModel(DistortionModelBuilder builder,
+                                                         const TaskStatus& status,
+                                                         DebugImages* dbg) const {
+  builder.transform(m_originalToProxy);
+
+  TopBottomEdgeTracer::trace(m_proxy, builder.verticalBounds(), builder, status, dbg);
+
+  DistortionModel model;
+  if (dbg) {
+    const QImage background(m_proxy.toQImage());
+    model = builder.tryBuildModel(dbg, &background);
+  } else {
+    model = builder.tryBuildModel();
+  }
+
+  if (model.isValid()) {
+    model.setTopCurve(Curve(mapPolyline(model.topCurve().polyline(), m_proxyToOriginal)));
+    model.setBottomCurve(Curve(mapPolyline(model.bottomCurve().polyline(), m_proxyToOriginal)));
+  }
+  return model;
+}
+
+DistortionModel DistortionModelEstimator::buildMarginalModel(const DistortionModel& trivialModel,
+                                                             const OrthogonalRotation& preRotation,
+                                                             const PageId::SubPage subPage,
+                                                             DebugImages* dbg) const {
+  const QTransform transform(m_originalToProxy * preRotation.transform(m_proxy.size()));
+  const QTransform invTransform(transform.inverted());
+
+  const BinaryImage bwImage(orthogonalRotation(BinaryImage(m_proxy, BinaryThreshold(64)), preRotation.toDegrees()));
+
+  const std::vector<QPointF>& topPolyline = trivialModel.topCurve().polyline();
+  const std::vector<QPointF>& bottomPolyline = trivialModel.bottomCurve().polyline();
+  const QLineF topLine(transform.map(topPolyline.front()), transform.map(topPolyline.back()));
+  const QLineF bottomLine(transform.map(bottomPolyline.front()), transform.map(bottomPolyline.back()));
+
+  XSpline topSpline(marginalSpline(topLine, topLine, subPage));
+  for (int i = 0; i <= topSpline.numSegments(); i++) {
+    movePointToTopMargin(bwImage, topSpline, i, m_marginRunLength);
+  }
+
+  // The intermediate points start on the top line and get moved down to the bottom margin.
+  XSpline bottomSpline(marginalSpline(bottomLine, topLine, subPage));
+  for (int i = 0; i <= bottomSpline.numSegments(); i++) {
+    movePointToBottomMargin(bwImage, bottomSpline, i, m_marginRunLength);
+  }
+
+  if (dbg) {
+    QImage outImage(bwImage.toQImage().convertToFormat(QImage::Format_RGB32));
+    for (int i = 0; i <= topSpline.numSegments(); i++) {
+      drawPoint(outImage, topSpline.controlPointPosition(i));
+    }
+    for (int i = 0; i <= bottomSpline.numSegments(); i++) {
+      drawPoint(outImage, bottomSpline.controlPointPosition(i));
+    }
+    dbg->add(outImage, "marginal dewarping");
+  }
+
+  for (int i = 0; i <= topSpline.numSegments(); i++) {
+    topSpline.moveControlPoint(i, invTransform.map(topSpline.controlPointPosition(i)));
+  }
+  for (int i = 0; i <= bottomSpline.numSegments(); i++) {
+    bottomSpline.moveControlPoint(i, invTransform.map(bottomSpline.controlPointPosition(i)));
+  }
+
+  DistortionModel model;
+  model.setTopCurve(Curve(topSpline));
+  model.setBottomCurve(Curve(bottomSpline));
+  return model;
+}  // DistortionModelEstimator::buildMarginalModel
+}  // namespace output
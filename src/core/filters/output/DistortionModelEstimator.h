@@ -0,0 +1,76 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#ifndef SCANTAILOR_OUTPUT_DISTORTIONMODELESTIMATOR_H_
+#define SCANTAILOR_OUTPUT_DISTORTIONMODELESTIMATOR_H_
+
+#include <GrayImage.h>
+
+#include <QTransform>
+
+#include "PageId.h"
+
+class DebugImages;
+class Dpi;
+class OrthogonalRotation;
+class TaskStatus;
+
+namespace dewarping {
+class DistortionModel;
+class DistortionModelBuilder;
+}  // namespace dewarping
+
+namespace output {
+/**
+ * \brief Finds distortion models on a reduced resolution copy of the original.
+ *
+ * Neither tracing the page edges nor looking for the margins needs the full
+ * resolution, so both work on a proxy of about PROXY_DPI.  Everything going
+ * in and coming out is in the original image coordinates.
+ */
+class DistortionModelEstimator {
+ public:
+  static constexpr int PROXY_DPI = 150;
+
+  /**
+   * \param original The grayscale original the model is defined on.
+   * \param originalDpi Its resolution.  A null one is taken to be 300 DPI.
+   * \param proxyDpi The resolution to work at.  Originals not above it are used as they are.
+   */
+  DistortionModelEstimator(const imageproc::GrayImage& original, const Dpi& originalDpi, int proxyDpi = PROXY_DPI);
+
+  const imageproc::GrayImage& proxy() const { return m_proxy; }
+
+  const QTransform& originalToProxy() const { return m_originalToProxy; }
+
+  /**
+   * \brief Adds the traced top and bottom page edges to the curves already
+   *        collected and picks the best pair.
+   *
+   * \param builder The vertical bounds and the text lines found so far.
+   * \return A model that may be invalid.
+   */
+  dewarping::DistortionModel buildAutoModel(dewarping::DistortionModelBuilder builder,
+                                            const TaskStatus& status,
+                                            DebugImages* dbg) const;
+
+  /**
+   * \brief Moves the curves of a trivial model out to the page margins,
+   *        near the binding side of the page.
+   *
+   * \return A model that may be invalid.
+   */
+  dewarping::DistortionModel buildMarginalModel(const dewarping::DistortionModel& trivialModel,
+                                                const OrthogonalRotation& preRotation,
+                                                PageId::SubPage subPage,
+                                                DebugImages* dbg) const;
+
+ private:
+  imageproc::GrayImage m_proxy;
+  QTransform m_originalToProxy;
+  QTransform m_proxyToOriginal;
+  // How many white pixels in a row mark the margin.
+  int m_marginRunLength;
+};
+}  // namespace output
+#endif  // ifndef SCANTAILOR_OUTPUT_DISTORTIONMODELESTIMATOR_H_
@@ -523,6 +523,16 @@ void OptionsWidget::equalizeIlluminationToggled(const bool checked) {
   blackWhiteOptions.setNormalizeIllumination(checked);
   m_colorParams.setBlackWhiteOptions(blackWhiteOptions);
   m_settings->setColorParams(m_pageId, m_colorParams);
+  tiledBackgroundEstimationCB->setEnabled(checked && !passThroughCheckBox->isChecked());
+  emit reloadRequested();
+}
+
+void OptionsWidget::tiledBackgroundEstimationToggled(const bool checked) {
+  BlackWhiteOptions blackWhiteOptions(m_colorParams.blackWhiteOptions());
+  blackWhiteOptions.setBackgroundEstimationMethod(checked ? BackgroundEstimationMethod::TILED_ROBUST
+                                                          : BackgroundEstimationMethod::POLYNOMIAL);
+  m_colorParams.setBlackWhiteOptions(blackWhiteOptions);
+  m_settings->setColorParams(m_pageId, m_colorParams);
   emit reloadRequested();
 }
 
@@ -753,17 +763,7 @@ void OptionsWidget::applyColorsButtonClicked() {
 }
 
 void OptionsWidget::dpiChanged(const std::set<PageId>& pages, const Dpi& dpi) {
-  for (const PageId& pageId : pages) {
-    m_settings->setDpi(pageId, dpi);
-  }
-
-  if (pages.size() > 1) {
-    emit invalidateAllThumbnails();
-  } else {
-    for (const PageId& pageId : pages) {
-      emit invalidateThumbnail(pageId);
-    }
-  }
+  emit invalidateThumbnails(m_settings->applyBulkUpdate(pages, Settings::BulkUpdate().setDpi(dpi)));
 
   if (pages.find(m_pageId) != pages.end()) {
     m_outputDpi = dpi;
@@ -773,10 +773,8 @@ void OptionsWidget::dpiChanged(const std::set<PageId>& pages, const Dpi& dpi) {
 }
 
 void OptionsWidget::applyColorsConfirmed(const std::set<PageId>& pages) {
-  for (const PageId& pageId : pages) {
-    m_settings->setColorParams(pageId, m_colorParams);
-    m_settings->setPictureShapeOptions(pageId, m_pictureShapeOptions);
-  }
+  m_settings->applyBulkUpdate(
+      pages, Settings::BulkUpdate().setColorParams(m_colorParams).setPictureShapeOptions(m_pictureShapeOptions));
 
   // Request batch processing of ALL pages (including current if present)
   if (!pages.empty()) {
@@ -816,17 +814,8 @@ void OptionsWidget::applySplittingButtonClicked() {
 }
 
 void OptionsWidget::applySplittingOptionsConfirmed(const std::set<PageId>& pages) {
-  for (const PageId& pageId : pages) {
-    m_settings->setSplittingOptions(pageId, m_splittingOptions);
-  }
-
-  if (pages.size() > 1) {
-    emit invalidateAllThumbnails();
-  } else {
-    for (const PageId& pageId : pages) {
-      emit invalidateThumbnail(pageId);
-    }
-  }
+  emit invalidateThumbnails(
+      m_settings->applyBulkUpdate(pages, Settings::BulkUpdate().setSplittingOptions(m_splittingOptions)));
 
   if (pages.find(m_pageId) != pages.end()) {
     emit reloadRequested();
@@ -920,17 +909,8 @@ void OptionsWidget::applyDespeckleButtonClicked() {
 }
 
 void OptionsWidget::applyDespeckleConfirmed(const std::set<PageId>& pages) {
-  for (const PageId& pageId : pages) {
-    m_settings->setDespeckleLevel(pageId, m_despeckleLevel);
-  }
-
-  if (pages.size() > 1) {
-    emit invalidateAllThumbnails();
-  } else {
-    for (const PageId& pageId : pages) {
-      emit invalidateThumbnail(pageId);
-    }
-  }
+  emit invalidateThumbnails(
+      m_settings->applyBulkUpdate(pages, Settings::BulkUpdate().setDespeckleLevel(m_despeckleLevel)));
 
   if (pages.find(m_pageId) != pages.end()) {
     emit reloadRequested();
@@ -946,17 +926,7 @@ void OptionsWidget::changeDewarpingButtonClicked() {
 }
 
 void OptionsWidget::dewarpingChanged(const std::set<PageId>& pages, const DewarpingOptions& opt) {
-  for (const PageId& pageId : pages) {
-    m_settings->setDewarpingOptions(pageId, opt);
-  }
-
-  if (pages.size() > 1) {
-    emit invalidateAllThumbnails();
-  } else {
-    for (const PageId& pageId : pages) {
-      emit invalidateThumbnail(pageId);
-    }
-  }
+  emit invalidateThumbnails(m_settings->applyBulkUpdate(pages, Settings::BulkUpdate().setDewarpingOptions(opt)));
 
   if (pages.find(m_pageId) != pages.end()) {
     if (m_dewarpingOptions != opt) {
@@ -1018,17 +988,8 @@ void OptionsWidget::applyDepthPerceptionButtonClicked() {
 }
 
 void OptionsWidget::applyDepthPerceptionConfirmed(const std::set<PageId>& pages) {
-  for (const PageId& pageId : pages) {
-    m_settings->setDepthPerception(pageId, m_depthPerception);
-  }
-
-  if (pages.size() > 1) {
-    emit invalidateAllThumbnails();
-  } else {
-    for (const PageId& pageId : pages) {
-      emit invalidateThumbnail(pageId);
-    }
-  }
+  emit invalidateThumbnails(
+      m_settings->applyBulkUpdate(pages, Settings::BulkUpdate().setDepthPerception(m_depthPerception)));
 
   if (pages.find(m_pageId) != pages.end()) {
     emit reloadRequested();
@@ -1166,6 +1127,9 @@ void OptionsWidget::updateColorsDisplay() {
   // Hide BW illumination option for color/grayscale modes
   const bool isColorOrGrayscale = (colorMode == COLOR_GRAYSCALE || colorMode == COLOR || colorMode == GRAYSCALE);
   equalizeIlluminationCB->setVisible(!isColorOrGrayscale);
+  tiledBackgroundEstimationCB->setChecked(blackWhiteOptions.backgroundEstimationMethod()
+                                          == BackgroundEstimationMethod::TILED_ROBUST);
+  tiledBackgroundEstimationCB->setVisible(!isColorOrGrayscale);
 
   // Photo adjustments sliders
   const weasel::PhotoAdjustments& adj = m_colorParams.photoAdjustments();
@@ -1307,6 +1271,7 @@ void OptionsWidget::updateColorsDisplay() {
   fillMarginsCB->setEnabled(!pt);
   fillOffcutCB->setEnabled(!pt);
   equalizeIlluminationCB->setEnabled(!pt);
+  tiledBackgroundEstimationCB->setEnabled(!pt && blackWhiteOptions.normalizeIllumination());
   savitzkyGolaySmoothingCB->setEnabled(!pt);
   morphologicalSmoothingCB->setEnabled(!pt);
   thresholdOptions->setEnabled(!pt);
@@ -1621,6 +1586,7 @@ void OptionsWidget::setupUiConnections() {
   CONNECT(fillMarginsCB, SIGNAL(clicked(bool)), this, SLOT(fillMarginsToggled(bool)));
   CONNECT(fillOffcutCB, SIGNAL(clicked(bool)), this, SLOT(fillOffcutToggled(bool)));
   CONNECT(equalizeIlluminationCB, SIGNAL(clicked(bool)), this, SLOT(equalizeIlluminationToggled(bool)));
+  CONNECT(tiledBackgroundEstimationCB, SIGNAL(clicked(bool)), this, SLOT(tiledBackgroundEstimationToggled(bool)));
   CONNECT(tempSlider, SIGNAL(valueChanged(int)), this, SLOT(photoAdjTempChanged(int)));
   CONNECT(tintSlider, SIGNAL(valueChanged(int)), this, SLOT(photoAdjTintChanged(int)));
   CONNECT(exposureSlider, SIGNAL(valueChanged(int)), this, SLOT(photoAdjExposureChanged(int)));
@@ -1714,23 +1680,17 @@ void OptionsWidget::applyColorParamsToSelectedPages(bool triggerBatchProcessing)
   // Only apply to multiple pages if current page is in selection and there are multiple selected
   if (selectedPages.size() > 1 && selectedPages.find(m_pageId) != selectedPages.end()) {
     const ColorMode colorMode = effectiveColorMode();
-    std::set<PageId> pagesToReprocess;
+    // The current page is included in the batch and will be processed along with others.
+    const std::set<PageId>& pagesToReprocess = selectedPages;
     m_colorParams.setColorMode(colorMode);
-    m_settings->setColorParams(m_pageId, m_colorParams);
-
-    for (const PageId& pageId : selectedPages) {
-      if (pageId == m_pageId) {
-        // Include current page in batch - it will be processed along with others
-        pagesToReprocess.insert(pageId);
-        continue;
-      }
-
-      m_settings->setColorParams(pageId, m_colorParams);
-      pagesToReprocess.insert(pageId);
-
-      // Also update finalize settings so finalize filter stays in sync
-      if (m_finalizeSettings) {
-        m_finalizeSettings->setColorMode(pageId, toFinalizeColorMode(colorMode));
+    m_settings->applyBulkUpdate(selectedPages, Settings::BulkUpdate().setColorParams(m_colorParams));
+
+    // Also update finalize settings so finalize filter stays in sync
+    if (m_finalizeSettings) {
+      for (const PageId& pageId : selectedPages) {
+        if (pageId != m_pageId) {
+          m_finalizeSettings->setColorMode(pageId, toFinalizeColorMode(colorMode));
+        }
       }
     }
 
@@ -128,6 +128,8 @@ class OptionsWidget : public FilterOptionsWidget, private Ui::OptionsWidget {
 
   void equalizeIlluminationToggled(bool checked);
 
+  void tiledBackgroundEstimationToggled(bool checked);
+
   void photoAdjTempChanged(int value);
   void photoAdjTintChanged(int value);
   void photoAdjExposureChanged(int value);
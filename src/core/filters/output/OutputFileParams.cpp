@@ -26,6 +26,15 @@ OutputFileParams::OutputFileParams(const QDomElement& el) : m_size(-1), m_modifi
   }
 }
 
+OutputFileParams OutputFileParams::forBookPage(const uint64_t stamp) {
+  // A changed stamp is a changed file, so it takes the place of the size.
+  OutputFileParams params;
+  if (stamp != 0) {
+    params.m_size = static_cast<qint64>(stamp);
+  }
+  return params;
+}
+
 QDomElement OutputFileParams::toXml(QDomDocument& doc, const QString& name) const {
   if (isValid()) {
     QDomElement el(doc.createElement(name));
@@ -5,6 +5,7 @@
 #define SCANTAILOR_OUTPUT_OUTPUTFILEPARAMS_H_
 
 #include <QtGlobal>
+#include <cstdint>
 #include <ctime>
 
 class QDomDocument;
@@ -23,6 +24,13 @@ class OutputFileParams {
 
   explicit OutputFileParams(const QDomElement& el);
 
+  /**
+   * \brief Identifies a page of a TiffBookContainer by its stamp.
+   *
+   * \see TiffBookContainer::pageStamp()
+   */
+  static OutputFileParams forBookPage(uint64_t stamp);
+
   QDomElement toXml(QDomDocument& doc, const QString& name) const;
 
   bool isValid() const;
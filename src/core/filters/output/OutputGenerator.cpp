@@ -16,6 +16,7 @@
 #include <DrawOver.h>
 #include <GrayRasterOp.h>
 #include <Grayscale.h>
+#include <HitMissPipeline.h>
 #include <InfluenceMap.h>
 #include <Morphology.h>
 #include <OrthogonalRotation.h>
@@ -27,7 +28,6 @@
 #include <Scale.h>
 #include <SeedFill.h>
 #include <TextLineTracer.h>
-#include <TopBottomEdgeTracer.h>
 #include <Transform.h>
 #include <core/ApplicationSettings.h>
 #include <imageproc/BackgroundColorCalculator.h>
@@ -49,6 +49,7 @@
 #include <QTransform>
 #include <boost/bind/bind.hpp>
 #include <BitOps.h>
+#include <algorithm>
 #include <cmath>
 #include <exception>
 #include <functional>
@@ -59,6 +60,7 @@
 #include "WhiteBalance.h"
 #include "weasel/TonalCurve.h"
 #include "DewarpingOptions.h"
+#include "DistortionModelEstimator.h"
 #include "Dpm.h"
 #include "EstimateBackground.h"
 #include "FillColorProperty.h"
@@ -142,10 +144,26 @@ class OutputGenerator::Processor {
                                                     BinaryImage* autoPictureMask,
                                                     BinaryImage* specklesImage);
 
+  /**
+   * \brief Whether a bitonal input can go to the B&W output without a grayscale detour.
+   *
+   * That's the case when there is nothing gray to compute: no color segmentation,
+   * no dewarping, no photo adjustments, and no resampling beyond rotating and cropping.
+   */
+  bool isBitonalRouteApplicable(const FilterData& input) const;
+
+  std::unique_ptr<OutputImage> processBitonal(const ZoneSet& fillZones, BinaryImage* specklesImage);
+
   std::unique_ptr<OutputImage> buildEmptyImage() const;
 
+  bool isPostDeskewEnabled() const;
+
   double findSkew(const QImage& image) const;
 
+  double findPostDeskewSkew(const QImage& src,
+                            const DistortionModel& distortionModel,
+                            const DepthPerception& depthPerception) const;
+
   void setupTrivialDistortionModel(DistortionModel& distortionModel) const;
 
   static CylindricalSurfaceDewarper createDewarper(const DistortionModel& distortionModel,
@@ -157,7 +175,8 @@ class OutputGenerator::Processor {
                 const QTransform& srcToOutput,
                 const DistortionModel& distortionModel,
                 const DepthPerception& depthPerception,
-                const QColor& bgColor) const;
+                const QColor& bgColor,
+                const QTransform& postTransform = QTransform()) const;
 
   GrayImage normalizeIlluminationGray(const QImage& input,
                                       const QPolygonF& areaToConsider,
@@ -171,10 +190,18 @@ class OutputGenerator::Processor {
                                        const QRect& sourceRect,
                                        const QRect& sourceSubRect) const;
 
+  /**
+   * \param withPaintedZones Whether to apply the ZONEPAINTER2 and ZONEERASER3 zones too.
+   *        Those don't depend on the content, so the dewarping path applies them
+   *        to the dewarped mask instead, see paintPictureZones().
+   */
   void modifyBinarizationMask(BinaryImage& bwMask,
                               BinaryImage& bwContent,
                               const QRect& maskRect,
-                              const ZoneSet& zones) const;
+                              const ZoneSet& zones,
+                              bool withPaintedZones = true) const;
+
+  BinaryImage dewarpContentAreaMask(const DewarpingPointMapper& mapper) const;
 
   BinaryThreshold adjustThreshold(BinaryThreshold threshold) const;
 
@@ -247,6 +274,8 @@ class OutputGenerator::Processor {
   bool m_blackOnWhite;
   QImage m_inputOrigImage;
   GrayImage m_inputGrayImage;
+  // Set instead of the above when processBitonal() is to be used.
+  BinaryImage m_inputBinaryImage;
   bool m_colorOriginal;
 
   const TaskStatus& m_status;
@@ -737,6 +766,42 @@ Zone createPictureZoneFromPoly(const QPolygonF& polygon) {
   return Zone(SerializableSpline(polygon), propertySet);
 }
 
+// Zone and content area outlines get a vertex at least every that many original
+// image pixels before being dewarped, so their edges follow the curvature.
+const double DEWARPED_OUTLINE_STEP = 4.0;
+
+QPolygonF zoneToOutput(const Zone& zone, const std::function<QPointF(const QPointF&)>& origToOutput) {
+  QPolygonF poly(PolygonUtils::densify(zone.spline().toPolygon(), DEWARPED_OUTLINE_STEP));
+  for (QPointF& pt : poly) {
+    pt = origToOutput(pt);
+  }
+  return poly;
+}
+
+/**
+ * Passes 4 and 5 of building the picture mask: ZONEPAINTER2 zones are made
+ * pictures and ZONEERASER3 zones are made not pictures, whatever the content.
+ */
+void paintPictureZones(BinaryImage& bwMask,
+                       const ZoneSet& zones,
+                       const std::function<QPolygonF(const QPolygonF&)>& origToMask) {
+  using PLP = PictureLayerProperty;
+
+  // Pass 4: ZONEPAINTER2
+  for (const Zone& zone : zones) {
+    if (zone.properties().locateOrDefault<PLP>()->layer() == PLP::ZONEPAINTER2) {
+      PolygonRasterizer::fill(bwMask, WHITE, origToMask(zone.spline().toPolygon()), Qt::WindingFill);
+    }
+  }
+
+  // Pass 5: ZONEERASER3
+  for (const Zone& zone : zones) {
+    if (zone.properties().locateOrDefault<PLP>()->layer() == PLP::ZONEERASER3) {
+      PolygonRasterizer::fill(bwMask, BLACK, origToMask(zone.spline().toPolygon()), Qt::WindingFill);
+    }
+  }
+}
+
 void applyFillZonesInPlace(QImage& img,
                            const ZoneSet& zones,
                            const std::function<QPointF(const QPointF&)>& origToOutput,
@@ -753,7 +818,7 @@ void applyFillZonesInPlace(QImage& img,
 
     for (const Zone& zone : zones) {
       const QColor color(zone.properties().locateOrDefault<FillColorProperty>()->color());
-      const QPolygonF poly(zone.spline().transformed(origToOutput).toPolygon());
+      const QPolygonF poly(zoneToOutput(zone, origToOutput));
       painter.setBrush(color);
       painter.drawPolygon(poly, Qt::WindingFill);
     }
@@ -784,7 +849,7 @@ void applyFillZonesInPlace(BinaryImage& img,
   for (const Zone& zone : zones) {
     const QColor color(zone.properties().locateOrDefault<FillColorProperty>()->color());
     const BWColor bwColor = qGray(color.rgb()) < 128 ? BLACK : WHITE;
-    const QPolygonF poly(zone.spline().transformed(origToOutput).toPolygon());
+    const QPolygonF poly(zoneToOutput(zone, origToOutput));
     PolygonRasterizer::fill(img, bwColor, poly, Qt::WindingFill);
   }
 }
@@ -832,7 +897,7 @@ void applyFillZonesToMask(BinaryImage& mask,
   }
 
   for (const Zone& zone : zones) {
-    const QPolygonF poly(zone.spline().transformed(origToOutput).toPolygon());
+    const QPolygonF poly(zoneToOutput(zone, origToOutput));
     PolygonRasterizer::fill(mask, fillColor, poly, Qt::WindingFill);
   }
 }
@@ -1050,71 +1115,6 @@ std::vector<QRect> findRectAreas(const BinaryImage& mask, BWColor contentColor,
   return areas;
 }
 
-void applyAffineTransform(QImage& image, const QTransform& xform, const QColor& outsideColor) {
-  if (xform.isIdentity()) {
-    return;
-  }
-  image = transform(image, xform, image.rect(), OutsidePixels::assumeWeakColor(outsideColor));
-}
-
-void applyAffineTransform(BinaryImage& image, const QTransform& xform, const BWColor outsideColor) {
-  if (xform.isIdentity()) {
-    return;
-  }
-  const QColor color = (outsideColor == BLACK) ? Qt::black : Qt::white;
-  QImage converted = image.toQImage();
-  applyAffineTransform(converted, xform, color);
-  image = BinaryImage(converted);
-}
-
-void hitMissReplaceAllDirections(BinaryImage& img,
-                                 const char* const pattern,
-                                 const int patternWidth,
-                                 const int patternHeight) {
-  hitMissReplaceInPlace(img, WHITE, pattern, patternWidth, patternHeight);
-
-  std::vector<char> patternData(static_cast<unsigned long long int>(patternWidth * patternHeight), ' ');
-  char* const newPattern = &patternData[0];
-
-  // Rotate 90 degrees clockwise.
-  const char* p = pattern;
-  int newWidth = patternHeight;
-  int newHeight = patternWidth;
-  for (int y = 0; y < patternHeight; ++y) {
-    for (int x = 0; x < patternWidth; ++x, ++p) {
-      const int newX = patternHeight - 1 - y;
-      const int newY = x;
-      newPattern[newY * newWidth + newX] = *p;
-    }
-  }
-  hitMissReplaceInPlace(img, WHITE, newPattern, newWidth, newHeight);
-
-  // Rotate upside down.
-  p = pattern;
-  newWidth = patternWidth;
-  newHeight = patternHeight;
-  for (int y = 0; y < patternHeight; ++y) {
-    for (int x = 0; x < patternWidth; ++x, ++p) {
-      const int newX = patternWidth - 1 - x;
-      const int newY = patternHeight - 1 - y;
-      newPattern[newY * newWidth + newX] = *p;
-    }
-  }
-  hitMissReplaceInPlace(img, WHITE, newPattern, newWidth, newHeight);
-  // Rotate 90 degrees counter-clockwise.
-  p = pattern;
-  newWidth = patternHeight;
-  newHeight = patternWidth;
-  for (int y = 0; y < patternHeight; ++y) {
-    for (int x = 0; x < patternWidth; ++x, ++p) {
-      const int newX = y;
-      const int newY = patternWidth - 1 - x;
-      newPattern[newY * newWidth + newX] = *p;
-    }
-  }
-  hitMissReplaceInPlace(img, WHITE, newPattern, newWidth, newHeight);
-}
-
 QSize calcLocalWindowSize(const Dpi& dpi) {
   const QSizeF sizeMm(3, 30);
   const QSizeF sizeInch(sizeMm * constants::MM2INCH);
@@ -1130,66 +1130,6 @@ QSize calcLocalWindowSize(const Dpi& dpi) {
   return sizePixels;
 }
 
-void movePointToTopMargin(BinaryImage& bwImage, XSpline& spline, int idx) {
-  QPointF pos = spline.controlPointPosition(idx);
-
-  for (int j = 0; j < pos.y(); j++) {
-    if (bwImage.getPixel(static_cast<int>(pos.x()), j) == WHITE) {
-      int count = 0;
-      int checkNum = 16;
-
-      for (int jj = j; jj < (j + checkNum); jj++) {
-        if (bwImage.getPixel(static_cast<int>(pos.x()), jj) == WHITE) {
-          count++;
-        }
-      }
-
-      if (count == checkNum) {
-        pos.setY(j);
-        spline.moveControlPoint(idx, pos);
-        break;
-      }
-    }
-  }
-}
-
-void movePointToBottomMargin(BinaryImage& bwImage, XSpline& spline, int idx) {
-  QPointF pos = spline.controlPointPosition(idx);
-
-  for (int j = bwImage.height() - 1; j > pos.y(); j--) {
-    if (bwImage.getPixel(static_cast<int>(pos.x()), j) == WHITE) {
-      int count = 0;
-      int checkNum = 16;
-
-      for (int jj = j; jj > (j - checkNum); jj--) {
-        if (bwImage.getPixel(static_cast<int>(pos.x()), jj) == WHITE) {
-          count++;
-        }
-      }
-
-      if (count == checkNum) {
-        pos.setY(j);
-
-        spline.moveControlPoint(idx, pos);
-
-        break;
-      }
-    }
-  }
-}
-
-void drawPoint(QImage& image, const QPointF& pt) {
-  QPoint pts = pt.toPoint();
-
-  for (int i = pts.x() - 10; i < pts.x() + 10; i++) {
-    for (int j = pts.y() - 10; j < pts.y() + 10; j++) {
-      QPoint p1(i, j);
-
-      image.setPixel(p1, qRgb(255, 0, 0));
-    }
-  }
-}
-
 void movePointToTopMargin(BinaryImage& bwImage, std::vector<QPointF>& polyline, int idx) {
   QPointF& pos = polyline[idx];
 
@@ -1305,14 +1245,35 @@ void OutputGenerator::Processor::updateBlackOnWhite(const FilterData& input) {
   m_blackOnWhite = params.isBlackOnWhite();
 }
 
+bool OutputGenerator::Processor::isBitonalRouteApplicable(const FilterData& input) const {
+  if (!input.isBitonal() || !m_renderParams.binaryOutput() || m_renderParams.needColorSegmentation()) {
+    return false;
+  }
+  if ((m_dewarpingOptions.dewarpingMode() != OFF) || !m_colorParams.photoAdjustments().isDefault()) {
+    return false;
+  }
+
+  const QTransform& xform = m_xform.transform();
+  const double xScale = std::hypot(xform.m11(), xform.m12());
+  const double yScale = std::hypot(xform.m21(), xform.m22());
+  return (std::abs(xScale - 1.0) < 1e-3) && (std::abs(yScale - 1.0) < 1e-3);
+}
+
 void OutputGenerator::Processor::initFilterData(const FilterData& input) {
   updateBlackOnWhite(input);
 
+  if (isBitonalRouteApplicable(input)) {
+    m_inputBinaryImage = m_blackOnWhite ? input.binaryImage() : input.binaryImage().inverted();
+    m_colorOriginal = false;
+    return;
+  }
+
   // Determine if output should be color based on mode and input
   const ColorMode colorMode = m_colorParams.colorMode();
 
   // Start from the true source image (non-inverted). Apply adjustments before any black-on-white inversion.
-  QImage wbOrigImage = input.origImage();
+  // A bitonal original taking this route gets adjusted like the grayscale one it used to be loaded as.
+  QImage wbOrigImage = input.isBitonal() ? input.grayImage().toQImage() : input.origImage();
 
   // Apply photo adjustments (temp/tint + tonal curve) via LUT-based pipeline
   const weasel::PhotoAdjustments& adj = m_colorParams.photoAdjustments();
@@ -1361,6 +1322,9 @@ std::unique_ptr<OutputImage> OutputGenerator::Processor::processImpl(ZoneSet& pi
   if (m_blank) {
     return buildEmptyImage();
   }
+  if (!m_inputBinaryImage.isNull()) {
+    return processBitonal(fillZones, specklesImage);
+  }
 
   m_outsideBackgroundColor = BackgroundColorCalculator::calcDominantBackgroundColor(
       m_colorOriginal ? m_inputOrigImage : m_inputGrayImage, m_outCropAreaInOriginalCs);
@@ -1374,6 +1338,52 @@ std::unique_ptr<OutputImage> OutputGenerator::Processor::processImpl(ZoneSet& pi
   }
 }
 
+std::unique_ptr<OutputImage> OutputGenerator::Processor::processBitonal(const ZoneSet& fillZones,
+                                                                        BinaryImage* specklesImage) {
+  // There is no illumination to normalize, no noise for the Wiener filter and
+  // nothing to smooth or threshold, so the bits are only rotated and cropped.
+  BinaryImage bwContent = transform(m_inputBinaryImage, m_xform.transform(), m_croppedContentRect, WHITE);
+  m_inputBinaryImage.release();  // Save memory.
+  if (m_dbg) {
+    m_dbg->add(bwContent, "transformed");
+  }
+  m_status.throwIfCancelled();
+
+  // Crop the same way binarize() does.
+  const QPolygonF contentArea(m_croppedContentArea.translated(-m_croppedContentRect.topLeft()));
+  QPainterPath path;
+  path.addPolygon(contentArea);
+  if (!path.contains(QRectF(bwContent.rect()))) {
+    BinaryImage contentMask(bwContent.size(), BLACK);
+    PolygonRasterizer::fillExcept(contentMask, WHITE, contentArea, Qt::WindingFill);
+    contentMask = erodeBrick(contentMask, QSize(3, 3), WHITE);
+    rasterOp<RopAnd<RopSrc, RopDst>>(bwContent, contentMask);
+  }
+
+  if (m_renderParams.needMorphologicalSmoothing()) {
+    morphologicalSmoothInPlace(bwContent);
+    m_status.throwIfCancelled();
+  }
+
+  BinaryImage dst(m_targetSize, WHITE);
+  rasterOp<RopSrc>(dst, m_croppedContentRect, bwContent, QPoint(0, 0));
+  bwContent.release();  // Save memory.
+
+  // Despeckling has to stay the last operation affecting the binary output,
+  // see processWithoutDewarping().
+  maybeDespeckleInPlace(dst, m_outRect, m_outRect, m_despeckleLevel, specklesImage, m_dpi);
+
+  if (!m_blackOnWhite) {
+    dst.invert();
+  }
+
+  applyFillZonesInPlace(dst, fillZones, m_xform.transform());
+
+  OutputImageBuilder imageBuilder;
+  imageBuilder.setImage(dst.toQImage());
+  return imageBuilder.build();
+}
+
 std::unique_ptr<OutputImage> OutputGenerator::Processor::processWithoutDewarping(ZoneSet& pictureZones,
                                                                                  const ZoneSet& fillZones,
                                                                                  BinaryImage* autoPictureMask,
@@ -1730,7 +1740,8 @@ std::unique_ptr<OutputImage> OutputGenerator::Processor::processWithDewarping(Zo
     }
     // BW mask end
 
-    modifyBinarizationMask(warpedBwMask, warpedBwContent, m_workingBoundingRect, pictureZones);
+    // The painted zones go to the dewarped mask later.
+    modifyBinarizationMask(warpedBwMask, warpedBwContent, m_workingBoundingRect, pictureZones, false);
     warpedBwContent.release();  // Save memory.
     if (m_dbg) {
       m_dbg->add(warpedBwMask, "warpedBwMask with zones");
@@ -1745,27 +1756,27 @@ std::unique_ptr<OutputImage> OutputGenerator::Processor::processWithDewarping(Zo
   }
   warpedGrayOutput = GrayImage();  // Save memory.
 
+  // The post-deskew rotation is done by the dewarping itself, so that
+  // the original gets resampled only once.
   QTransform rotateXform;
   QImage dewarped;
   try {
-    dewarped = dewarp(QTransform(), normalizedOriginal, m_xform.transform(), distortionModel, depthPerception,
-                      m_outsideBackgroundColor);
-
-    const double deskewAngle = -findSkew(dewarped);
+    const double deskewAngle = -findPostDeskewSkew(normalizedOriginal, distortionModel, depthPerception);
     rotateXform = Utils::rotate(deskewAngle, m_outRect);
+    dewarped = dewarp(QTransform(), normalizedOriginal, m_xform.transform(), distortionModel, depthPerception,
+                      m_outsideBackgroundColor, rotateXform);
     m_dewarpingOptions.setPostDeskewAngle(deskewAngle);
   } catch (const std::runtime_error&) {
     // Probably an impossible distortion model.  Let's fall back to a trivial one.
     setupTrivialDistortionModel(distortionModel);
     m_dewarpingOptions.setPostDeskewAngle(.0);
+    rotateXform = QTransform();
 
     dewarped = dewarp(QTransform(), normalizedOriginal, m_xform.transform(), distortionModel, depthPerception,
                       m_outsideBackgroundColor);
   }
   normalizedOriginal = QImage();  // Save memory.
   m_settings->setDewarpingOptions(m_pageId, m_dewarpingOptions);
-  applyAffineTransform(dewarped, rotateXform, m_outsideBackgroundColor);
-  normalizedOriginal = QImage();  // Save memory.
   if (m_dbg) {
     m_dbg->add(dewarped, "dewarped");
   }
@@ -1776,13 +1787,10 @@ std::unique_ptr<OutputImage> OutputGenerator::Processor::processWithDewarping(Zo
   const std::function<QPointF(const QPointF&)> origToOutput(
       boost::bind(&DewarpingPointMapper::mapToDewarpedSpace, mapper, boost::placeholders::_1));
 
-  BinaryImage dewarpingContentAreaMask(m_inputGrayImage.size(), BLACK);
-  {
-    fillMarginsInPlace(dewarpingContentAreaMask, m_contentAreaInOriginalCs, WHITE);
-    dewarpingContentAreaMask = BinaryImage(dewarp(QTransform(), dewarpingContentAreaMask.toQImage(),
-                                                  m_xform.transform(), distortionModel, depthPerception, Qt::white));
-  }
-  applyAffineTransform(dewarpingContentAreaMask, rotateXform, WHITE);
+  // Unlike the one above, this one maps things exactly where dewarp() puts the pixels.
+  const DewarpingPointMapper maskMapper(distortionModel, depthPerception.value(), m_xform.transform(), m_outRect,
+                                        rotateXform);
+  const BinaryImage dewarpingContentAreaMask(dewarpContentAreaMask(maskMapper));
 
   if (m_renderParams.binaryOutput()) {
     QImage dewarpedAndMaybeSmoothed;
@@ -1859,9 +1867,11 @@ std::unique_ptr<OutputImage> OutputGenerator::Processor::processWithDewarping(Zo
         = m_xform.transform() * QTransform().translate(-m_workingBoundingRect.left(), -m_workingBoundingRect.top());
     QTransform workingToOutputCs = QTransform().translate(m_workingBoundingRect.left(), m_workingBoundingRect.top());
     dewarpedBwMask = BinaryImage(dewarp(origToWorkingCs, warpedBwMask.toQImage(), workingToOutputCs, distortionModel,
-                                        depthPerception, Qt::black));
+                                        depthPerception, Qt::black, rotateXform));
     warpedBwMask.release();
-    applyAffineTransform(dewarpedBwMask, rotateXform, BLACK);
+    paintPictureZones(dewarpedBwMask, pictureZones, [&maskMapper](const QPolygonF& poly) {
+      return maskMapper.mapPolygonToDewarpedSpace(poly, DEWARPED_OUTLINE_STEP);
+    });
     fillMarginsInPlace(dewarpedBwMask, dewarpingContentAreaMask, BLACK);
     if (m_dbg) {
       m_dbg->add(dewarpedBwMask, "dewarpedBwMask");
@@ -1912,9 +1922,8 @@ std::unique_ptr<OutputImage> OutputGenerator::Processor::processWithDewarping(Zo
             origWithoutIllumination = m_inputGrayImage;
           }
           dewarped = dewarp(QTransform(), origWithoutIllumination, m_xform.transform(), distortionModel,
-                            depthPerception, m_outsideBackgroundColor);
+                            depthPerception, m_outsideBackgroundColor, rotateXform);
         }
-        applyAffineTransform(dewarped, rotateXform, m_outsideBackgroundColor);
         m_status.throwIfCancelled();
       }
 
@@ -2123,8 +2132,8 @@ GrayImage OutputGenerator::Processor::normalizeIlluminationGray(const QImage& in
 
   PolynomialSurface bgPs(1, 1, toBeNormalized);  // dummy init to satisfy compiler; replaced below
   try {
-    bgPs = estimateBackground(toBeNormalized, transformedConsiderationArea, m_status, m_dbg,
-                              bgMask.isNull() ? nullptr : &bgMask, 0.05);
+    bgPs = estimateBackground(m_colorParams.blackWhiteOptions().backgroundEstimationMethod(), toBeNormalized, transformedConsiderationArea,
+                              m_status, m_dbg, bgMask.isNull() ? nullptr : &bgMask, 0.05);
   } catch (const std::exception& e) {
     qWarning() << "normalizeIlluminationGray: estimateBackground failed, skipping equalization:" << e.what();
     if (background) {
@@ -2211,7 +2220,8 @@ BinaryImage OutputGenerator::Processor::estimateBinarizationMask(const GrayImage
 void OutputGenerator::Processor::modifyBinarizationMask(BinaryImage& bwMask,
                                                         BinaryImage& bwContent,
                                                         const QRect& maskRect,
-                                                        const ZoneSet& zones) const {
+                                                        const ZoneSet& zones,
+                                                        const bool withPaintedZones) const {
   QTransform xform = m_xform.transform();
   xform *= QTransform().translate(-maskRect.x(), -maskRect.y());
   BinaryImage bwContentBG(bwContent);
@@ -2247,23 +2257,31 @@ void OutputGenerator::Processor::modifyBinarizationMask(BinaryImage& bwMask,
   }
   BinaryImageXOR(bwMask, bwContentBG, BLACK);
 
-  // Pass 4: ZONEPAINTER2
-  for (const Zone& zone : zones) {
-    if (zone.properties().locateOrDefault<PLP>()->layer() == PLP::ZONEPAINTER2) {
-      const QPolygonF poly(zone.spline().toPolygon());
-      PolygonRasterizer::fill(bwMask, WHITE, xform.map(poly), Qt::WindingFill);
-    }
+  if (withPaintedZones) {
+    paintPictureZones(bwMask, zones, [&xform](const QPolygonF& poly) { return xform.map(poly); });
   }
 
-  // Pass 5: ZONEERASER3
-  for (const Zone& zone : zones) {
-    if (zone.properties().locateOrDefault<PLP>()->layer() == PLP::ZONEERASER3) {
-      const QPolygonF poly(zone.spline().toPolygon());
-      PolygonRasterizer::fill(bwMask, BLACK, xform.map(poly), Qt::WindingFill);
+  BinaryImageXOR(bwContent, bwMask, WHITE);
+}
+
+/**
+ * The content area of the original, as a mask in the coordinates of the dewarped output.
+ * Black is inside.  Mapping the outline gives the same mask as dewarping a raster
+ * of the whole original would, at a fraction of the cost.
+ *
+ * \param mapper Has to be set up with m_outRect, like dewarp() is, rather than the content rect.
+ */
+BinaryImage OutputGenerator::Processor::dewarpContentAreaMask(const DewarpingPointMapper& mapper) const {
+  BinaryImage mask(m_outRect.size(), WHITE);
+  const QPolygonF contentArea(mapper.mapPolygonToDewarpedSpace(m_contentAreaInOriginalCs, DEWARPED_OUTLINE_STEP));
+  for (const QPointF& pt : contentArea) {
+    if (!std::isfinite(pt.x()) || !std::isfinite(pt.y())) {
+      // An empty model domain.  dewarp() gives a blank image then.
+      return mask;
     }
   }
-
-  BinaryImageXOR(bwContent, bwMask, WHITE);
+  PolygonRasterizer::fill(mask, BLACK, contentArea, Qt::WindingFill);
+  return mask;
 }
 
 
@@ -2327,7 +2345,8 @@ QImage OutputGenerator::Processor::dewarp(const QTransform& origToSrc,
                                           const QTransform& srcToOutput,
                                           const DistortionModel& distortionModel,
                                           const DepthPerception& depthPerception,
-                                          const QColor& bgColor) const {
+                                          const QColor& bgColor,
+                                          const QTransform& postTransform) const {
   const CylindricalSurfaceDewarper dewarper(createDewarper(distortionModel, origToSrc, depthPerception.value()));
 
   // Model domain is a rectangle in output image coordinates that
@@ -2338,7 +2357,7 @@ QImage OutputGenerator::Processor::dewarp(const QTransform& origToSrc,
     out.fill(0xff);  // white
     return out;
   }
-  return RasterDewarper::dewarp(src, m_outRect.size(), dewarper, modelDomain, bgColor);
+  return RasterDewarper::dewarp(src, m_outRect.size(), dewarper, modelDomain, bgColor, postTransform);
 }
 
 GrayImage OutputGenerator::Processor::detectPictures(const GrayImage& input300dpi) const {
@@ -2454,6 +2473,10 @@ BinaryThreshold OutputGenerator::Processor::calcBinarizationThreshold(const QIma
 }
 
 void OutputGenerator::Processor::morphologicalSmoothInPlace(BinaryImage& binImg) const {
+  // All the patterns are applied in a single pass over the image,
+  // which gives the same result as applying them one by one.
+  HitMissPipeline pipeline(WHITE);
+
   // When removing black noise, remove small ones first.
 
   {
@@ -2461,11 +2484,9 @@ void OutputGenerator::Processor::morphologicalSmoothInPlace(BinaryImage& binImg)
         = "XXX"
           " - "
           "   ";
-    hitMissReplaceAllDirections(binImg, pattern, 3, 3);
+    pipeline.addPatternAllDirections(pattern, 3, 3);
   }
 
-  m_status.throwIfCancelled();
-
   {
     const char pattern[]
         = "X ?"
@@ -2474,11 +2495,9 @@ void OutputGenerator::Processor::morphologicalSmoothInPlace(BinaryImage& binImg)
           "X- "
           "X  "
           "X ?";
-    hitMissReplaceAllDirections(binImg, pattern, 3, 6);
+    pipeline.addPatternAllDirections(pattern, 3, 6);
   }
 
-  m_status.throwIfCancelled();
-
   {
     const char pattern[]
         = "X ?"
@@ -2490,11 +2509,9 @@ void OutputGenerator::Processor::morphologicalSmoothInPlace(BinaryImage& binImg)
           "X  "
           "X ?"
           "X ?";
-    hitMissReplaceAllDirections(binImg, pattern, 3, 9);
+    pipeline.addPatternAllDirections(pattern, 3, 9);
   }
 
-  m_status.throwIfCancelled();
-
   {
     const char pattern[]
         = "XX?"
@@ -2506,11 +2523,9 @@ void OutputGenerator::Processor::morphologicalSmoothInPlace(BinaryImage& binImg)
           "XX "
           "XX?"
           "XX?";
-    hitMissReplaceAllDirections(binImg, pattern, 3, 9);
+    pipeline.addPatternAllDirections(pattern, 3, 9);
   }
 
-  m_status.throwIfCancelled();
-
   {
     const char pattern[]
         = "XX?"
@@ -2519,19 +2534,21 @@ void OutputGenerator::Processor::morphologicalSmoothInPlace(BinaryImage& binImg)
           "X+ "
           "XX "
           "XX?";
-    hitMissReplaceAllDirections(binImg, pattern, 3, 6);
+    pipeline.addPatternAllDirections(pattern, 3, 6);
   }
 
-  m_status.throwIfCancelled();
-
   {
     const char pattern[]
         = "   "
           "X+X"
           "XXX";
-    hitMissReplaceAllDirections(binImg, pattern, 3, 3);
+    pipeline.addPatternAllDirections(pattern, 3, 3);
   }
 
+  m_status.throwIfCancelled();
+
+  pipeline.applyInPlace(binImg);
+
   if (m_dbg) {
     m_dbg->add(binImg, "edges_smoothed");
   }
@@ -2798,9 +2815,13 @@ void OutputGenerator::Processor::maybeDespeckleInPlace(BinaryImage& image,
   m_status.throwIfCancelled();
 }
 
+bool OutputGenerator::Processor::isPostDeskewEnabled() const {
+  return m_dewarpingOptions.needPostDeskew()
+         && ((m_dewarpingOptions.dewarpingMode() == MARGINAL) || (m_dewarpingOptions.dewarpingMode() == MANUAL));
+}
+
 double OutputGenerator::Processor::findSkew(const QImage& image) const {
-  if (m_dewarpingOptions.needPostDeskew()
-      && ((m_dewarpingOptions.dewarpingMode() == MARGINAL) || (m_dewarpingOptions.dewarpingMode() == MANUAL))) {
+  if (isPostDeskewEnabled()) {
     const BinaryImage bwImage(image, BinaryThreshold::otsuThreshold(GrayscaleHistogram(image)));
     const Skew skew = SkewFinder().findSkew(bwImage);
     if ((skew.angle() != .0) && (skew.confidence() >= Skew::GOOD_CONFIDENCE)) {
@@ -2810,6 +2831,34 @@ double OutputGenerator::Processor::findSkew(const QImage& image) const {
   return .0;
 }
 
+/**
+ * Finds the skew of the dewarped \p src, like findSkew() does, but on a reduced
+ * resolution dewarped proxy, so that the full resolution output can be produced
+ * in one pass, with the post-deskew rotation included.
+ */
+double OutputGenerator::Processor::findPostDeskewSkew(const QImage& src,
+                                                      const DistortionModel& distortionModel,
+                                                      const DepthPerception& depthPerception) const {
+  if (!isPostDeskewEnabled()) {
+    return .0;
+  }
+
+  const CylindricalSurfaceDewarper dewarper(createDewarper(distortionModel, QTransform(), depthPerception.value()));
+  const QRectF modelDomain(distortionModel.modelDomain(dewarper, m_xform.transform(), m_outRect).toRect());
+  if (modelDomain.isEmpty()) {
+    return .0;
+  }
+
+  // The skew finder doesn't gain anything from more than 200 DPI.
+  const double maxDpi = std::max(m_dpi.horizontal(), m_dpi.vertical());
+  const double scale = (maxDpi > 200) ? 200 / maxDpi : 1.0;
+  const QTransform toProxy(QTransform().scale(scale, scale));
+  const QSize proxySize(std::max(1, qRound(m_outRect.width() * scale)),
+                        std::max(1, qRound(m_outRect.height() * scale)));
+  return findSkew(
+      RasterDewarper::dewarp(src, proxySize, dewarper, toProxy.mapRect(modelDomain), m_outsideBackgroundColor));
+}
+
 QImage OutputGenerator::Processor::segmentImage(const BinaryImage& image, const QImage& colorImage) const {
   const BlackWhiteOptions::ColorSegmenterOptions& segmenterOptions
       = m_colorParams.blackWhiteOptions().getColorSegmenterOptions();
@@ -2923,21 +2972,15 @@ DistortionModel OutputGenerator::Processor::buildAutoDistortionModel(const GrayI
   TextLineTracer::trace(warpedGrayOutput, m_dpi, m_contentRectInWorkingCs, modelBuilder, m_status, m_dbg);
   modelBuilder.transform(toOriginal);
 
-  TopBottomEdgeTracer::trace(m_inputGrayImage, modelBuilder.verticalBounds(), modelBuilder, m_status, m_dbg);
-
-  DistortionModel distortionModel = modelBuilder.tryBuildModel(m_dbg, &m_inputGrayImage.toQImage());
+  const DistortionModelEstimator estimator(m_inputGrayImage, m_xform.origDpi());
+  DistortionModel distortionModel = estimator.buildAutoModel(modelBuilder, m_status, m_dbg);
   if (!distortionModel.isValid()) {
     setupTrivialDistortionModel(distortionModel);
   }
 
-  BinaryImage bwImage(m_inputGrayImage, BinaryThreshold(64));
-
-  QTransform transform = m_xform.preRotation().transform(bwImage.size());
+  QTransform transform = m_xform.preRotation().transform(m_inputGrayImage.size());
   QTransform invTransform = transform.inverted();
 
-  int degrees = m_xform.preRotation().toDegrees();
-  bwImage = orthogonalRotation(bwImage, degrees);
-
   const std::vector<QPointF>& topPolyline0 = distortionModel.topCurve().polyline();
   const std::vector<QPointF>& bottomPolyline0 = distortionModel.bottomCurve().polyline();
 
@@ -3033,93 +3076,15 @@ DistortionModel OutputGenerator::Processor::buildAutoDistortionModel(const GrayI
 }
 
 DistortionModel OutputGenerator::Processor::buildMarginalDistortionModel() const {
-  BinaryImage bwImage(m_inputGrayImage, BinaryThreshold(64));
-
-  QTransform transform = m_xform.preRotation().transform(bwImage.size());
-  QTransform invTransform = transform.inverted();
-
-  int degrees = m_xform.preRotation().toDegrees();
-  bwImage = orthogonalRotation(bwImage, degrees);
-
-  DistortionModel distortionModel;
-  setupTrivialDistortionModel(distortionModel);
-
-  int maxRedPoints = 5;
-  XSpline topSpline;
-
-  const std::vector<QPointF>& topPolyline = distortionModel.topCurve().polyline();
-
-  const QLineF topLine(transform.map(topPolyline.front()), transform.map(topPolyline.back()));
-
-  topSpline.appendControlPoint(topLine.p1(), 0);
-
-  if ((m_pageId.subPage() == PageId::SINGLE_PAGE) || (m_pageId.subPage() == PageId::LEFT_PAGE)) {
-    for (int i = 29 - maxRedPoints; i < 29; i++) {
-      topSpline.appendControlPoint(topLine.pointAt((float) i / 29.0), 1);
-    }
-  } else {
-    for (int i = 1; i <= maxRedPoints; i++) {
-      topSpline.appendControlPoint(topLine.pointAt((float) i / 29.0), 1);
-    }
-  }
-
-  topSpline.appendControlPoint(topLine.p2(), 0);
-
-  for (int i = 0; i <= topSpline.numSegments(); i++) {
-    movePointToTopMargin(bwImage, topSpline, i);
-  }
-
-  for (int i = 0; i <= topSpline.numSegments(); i++) {
-    topSpline.moveControlPoint(i, invTransform.map(topSpline.controlPointPosition(i)));
-  }
-
-  distortionModel.setTopCurve(Curve(topSpline));
-
-
-  XSpline bottomSpline;
-
-  const std::vector<QPointF>& bottomPolyline = distortionModel.bottomCurve().polyline();
-
-  const QLineF bottomLine(transform.map(bottomPolyline.front()), transform.map(bottomPolyline.back()));
-
-  bottomSpline.appendControlPoint(bottomLine.p1(), 0);
-
-  if ((m_pageId.subPage() == PageId::SINGLE_PAGE) || (m_pageId.subPage() == PageId::LEFT_PAGE)) {
-    for (int i = 29 - maxRedPoints; i < 29; i++) {
-      bottomSpline.appendControlPoint(topLine.pointAt((float) i / 29.0), 1);
-    }
-  } else {
-    for (int i = 1; i <= maxRedPoints; i++) {
-      bottomSpline.appendControlPoint(topLine.pointAt((float) i / 29.0), 1);
-    }
-  }
-
-  bottomSpline.appendControlPoint(bottomLine.p2(), 0);
-
-  for (int i = 0; i <= bottomSpline.numSegments(); i++) {
-    movePointToBottomMargin(bwImage, bottomSpline, i);
-  }
-
-  for (int i = 0; i <= bottomSpline.numSegments(); i++) {
-    bottomSpline.moveControlPoint(i, invTransform.map(bottomSpline.controlPointPosition(i)));
-  }
-
-  distortionModel.setBottomCurve(Curve(bottomSpline));
+  DistortionModel trivialModel;
+  setupTrivialDistortionModel(trivialModel);
 
+  const DistortionModelEstimator estimator(m_inputGrayImage, m_xform.origDpi());
+  DistortionModel distortionModel
+      = estimator.buildMarginalModel(trivialModel, m_xform.preRotation(), m_pageId.subPage(), m_dbg);
   if (!distortionModel.isValid()) {
     setupTrivialDistortionModel(distortionModel);
   }
-
-  if (m_dbg) {
-    QImage outImage(bwImage.toQImage().convertToFormat(QImage::Format_RGB32));
-    for (int i = 0; i <= topSpline.numSegments(); i++) {
-      drawPoint(outImage, topSpline.controlPointPosition(i));
-    }
-    for (int i = 0; i <= bottomSpline.numSegments(); i++) {
-      drawPoint(outImage, bottomSpline.controlPointPosition(i));
-    }
-    m_dbg->add(outImage, "marginal dewarping");
-  }
   return distortionModel;
 }
 }  // namespace output
@@ -91,6 +91,12 @@ QDomElement OutputImageParams::toXml(QDomDocument& doc, const QString& name) con
   return el;
 }
 
+bool OutputImageParams::isGeometryOnly() const {
+  return m_outputProcessingParams.passThrough() && m_colorParams.photoAdjustments().isDefault()
+         && (m_outputProcessingParams.brightness() == 0.0) && (m_outputProcessingParams.contrast() == 0.0)
+         && !m_outputProcessingParams.autoLevels();
+}
+
 bool OutputImageParams::matches(const OutputImageParams& other) const {
   if (m_size != other.m_size) {
     return false;
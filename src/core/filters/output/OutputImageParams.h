@@ -74,6 +74,14 @@ class OutputImageParams {
    */
   bool matches(const OutputImageParams& other) const;
 
+  /**
+   * \brief Returns true if the output image is the source image transformed
+   *        geometrically, with the pixel values left as they are.
+   *
+   * That's the case for pass-through pages without any photo or tonal adjustments.
+   */
+  bool isGeometryOnly() const;
+
  private:
   class PartialXform {
    public:
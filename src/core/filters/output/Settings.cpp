@@ -209,6 +209,24 @@ void Settings::setDespeckleLevel(const PageId& pageId, double level) {
   }
 }
 
+std::set<PageId> Settings::applyBulkUpdate(const std::set<PageId>& pages, const BulkUpdate& update) {
+  const QMutexLocker locker(&m_mutex);
+
+  std::set<PageId> changedPages;
+  for (const PageId& pageId : pages) {
+    const auto it(m_perPageParams.find(pageId));
+    if (it == m_perPageParams.end()) {
+      Params params;
+      update.applyTo(params);
+      m_perPageParams.insert(it, PerPageParams::value_type(pageId, params));
+      changedPages.insert(changedPages.end(), pageId);
+    } else if (update.applyTo(it->second)) {
+      changedPages.insert(changedPages.end(), pageId);
+    }
+  }
+  return changedPages;
+}
+
 std::unique_ptr<OutputParams> Settings::getOutputParams(const PageId& pageId) const {
   const QMutexLocker locker(&m_mutex);
 
@@ -368,4 +386,73 @@ void Settings::clearManualWhiteBalanceColor(const PageId& pageId) {
   m_manualWhiteBalanceColors.erase(pageId);
 }
 
+/*=============================== Settings::BulkUpdate ===============================*/
+
+Settings::BulkUpdate& Settings::BulkUpdate::setColorParams(const ColorParams& prms) {
+  m_colorParams = prms;
+  return *this;
+}
+
+Settings::BulkUpdate& Settings::BulkUpdate::setPictureShapeOptions(const PictureShapeOptions& pictureShapeOptions) {
+  m_pictureShapeOptions = pictureShapeOptions;
+  return *this;
+}
+
+Settings::BulkUpdate& Settings::BulkUpdate::setDpi(const Dpi& dpi) {
+  m_dpi = dpi;
+  return *this;
+}
+
+Settings::BulkUpdate& Settings::BulkUpdate::setDewarpingOptions(const DewarpingOptions& opt) {
+  m_dewarpingOptions = opt;
+  return *this;
+}
+
+Settings::BulkUpdate& Settings::BulkUpdate::setSplittingOptions(const SplittingOptions& opt) {
+  m_splittingOptions = opt;
+  return *this;
+}
+
+Settings::BulkUpdate& Settings::BulkUpdate::setDepthPerception(const DepthPerception& depthPerception) {
+  m_depthPerception = depthPerception;
+  return *this;
+}
+
+Settings::BulkUpdate& Settings::BulkUpdate::setDespeckleLevel(const double level) {
+  m_despeckleLevel = level;
+  return *this;
+}
+
+bool Settings::BulkUpdate::applyTo(Params& params) const {
+  bool changed = false;
+  if (m_colorParams && (params.colorParams() != *m_colorParams)) {
+    params.setColorParams(*m_colorParams);
+    changed = true;
+  }
+  if (m_pictureShapeOptions && (params.pictureShapeOptions() != *m_pictureShapeOptions)) {
+    params.setPictureShapeOptions(*m_pictureShapeOptions);
+    changed = true;
+  }
+  if (m_dpi && (params.outputDpi() != *m_dpi)) {
+    params.setOutputDpi(*m_dpi);
+    changed = true;
+  }
+  if (m_dewarpingOptions && (params.dewarpingOptions() != *m_dewarpingOptions)) {
+    params.setDewarpingOptions(*m_dewarpingOptions);
+    changed = true;
+  }
+  if (m_splittingOptions && (params.splittingOptions() != *m_splittingOptions)) {
+    params.setSplittingOptions(*m_splittingOptions);
+    changed = true;
+  }
+  if (m_depthPerception && (params.depthPerception() != *m_depthPerception)) {
+    params.setDepthPerception(*m_depthPerception);
+    changed = true;
+  }
+  if (m_despeckleLevel && (params.despeckleLevel() != *m_despeckleLevel)) {
+    params.setDespeckleLevel(*m_despeckleLevel);
+    changed = true;
+  }
+  return changed;
+}
 }  // namespace output
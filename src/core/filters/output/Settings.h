@@ -9,6 +9,8 @@
 #include <QColor>
 #include <QMutex>
 #include <memory>
+#include <optional>
+#include <set>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -34,6 +36,44 @@ class Settings {
   DECLARE_NON_COPYABLE(Settings)
 
  public:
+  /**
+   * \brief A set of parameter changes to be applied to many pages at once.
+   *
+   * \see applyBulkUpdate()
+   */
+  class BulkUpdate {
+   public:
+    BulkUpdate& setColorParams(const ColorParams& prms);
+
+    BulkUpdate& setPictureShapeOptions(const PictureShapeOptions& pictureShapeOptions);
+
+    BulkUpdate& setDpi(const Dpi& dpi);
+
+    BulkUpdate& setDewarpingOptions(const DewarpingOptions& opt);
+
+    BulkUpdate& setSplittingOptions(const SplittingOptions& opt);
+
+    BulkUpdate& setDepthPerception(const DepthPerception& depthPerception);
+
+    BulkUpdate& setDespeckleLevel(double level);
+
+   private:
+    friend class Settings;
+
+    /**
+     * \return true if any of the parameters were different before.
+     */
+    bool applyTo(Params& params) const;
+
+    std::optional<ColorParams> m_colorParams;
+    std::optional<PictureShapeOptions> m_pictureShapeOptions;
+    std::optional<Dpi> m_dpi;
+    std::optional<DewarpingOptions> m_dewarpingOptions;
+    std::optional<SplittingOptions> m_splittingOptions;
+    std::optional<DepthPerception> m_depthPerception;
+    std::optional<double> m_despeckleLevel;
+  };
+
   Settings();
 
   virtual ~Settings();
@@ -64,6 +104,14 @@ class Settings {
 
   void setDespeckleLevel(const PageId& pageId, double level);
 
+  /**
+   * \brief Applies \p update to every page in \p pages under a single lock.
+   *
+   * \return The pages whose parameters have actually changed.  Only these
+   *         need their thumbnails invalidated.
+   */
+  std::set<PageId> applyBulkUpdate(const std::set<PageId>& pages, const BulkUpdate& update);
+
   std::unique_ptr<OutputParams> getOutputParams(const PageId& pageId) const;
 
   void removeOutputParams(const PageId& pageId);
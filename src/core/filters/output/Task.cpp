@@ -7,6 +7,8 @@
 #include <PolygonUtils.h>
 #include <UnitsProvider.h>
 #include <core/ApplicationSettings.h>
+#include <core/JpegLosslessTransform.h>
+#include <core/TiffBookContainer.h>
 #include <core/TiffWriter.h>
 
 #include <QDir>
@@ -14,6 +16,7 @@
 #include <algorithm>
 #include <boost/bind/bind.hpp>
 #include <cmath>
+#include <optional>
 #include <utility>
 
 #include "DebugImagesImpl.h"
@@ -67,6 +70,72 @@ bool writeOutputImage(const QString& filePath, const QImage& image, const Output
   }
 }
 
+/**
+ * Writes the output by rotating and cropping a JPEG source in the DCT domain,
+ * if the output is nothing more than that.  As blocks can't be split, that's
+ * only possible if the crop edges that become the top and the left ones are on
+ * the iMCU boundaries of the source.  Otherwise the output would get larger
+ * than the normal one, and its content shifted.
+ *
+ * \return The output image as written, or a null image if it has to be
+ *         generated the normal way.
+ */
+QImage writeLosslessJpegOutput(const QString& filePath,
+                               const PageId& pageId,
+                               const ImageTransformation& xform,
+                               const QImage& origImage,
+                               const OutputImageParams& outputImageParams,
+                               const ZoneSet& fillZones,
+                               const OutputFileNameGenerator& outFileNameGen) {
+  if ((outFileNameGen.outputFormat() != OutputImageFormat::JPEG) || !outputImageParams.isGeometryOnly()
+      || !fillZones.empty() || (pageId.imageId().zeroBasedPage() != 0)) {
+    return QImage();
+  }
+
+  const QRect outputRect(xform.resultingRect().toRect());
+  const QRect croppedRect(xform.resultingPreCropArea().boundingRect().toRect().intersected(outputRect));
+  if (croppedRect != outputRect) {
+    // Parts of the output are filled with white.
+    return QImage();
+  }
+
+  int rotation = 0;
+  QRect sourceRect;
+  const QTransform sourceToOutput(xform.transform()
+                                  * QTransform::fromTranslate(-outputRect.left(), -outputRect.top()));
+  if (!JpegLosslessTransform::decompose(sourceToOutput, outputRect.size(), &rotation, &sourceRect)) {
+    return QImage();
+  }
+
+  QFile sourceFile(pageId.imageId().filePath());
+  if (!sourceFile.open(QIODevice::ReadOnly)) {
+    return QImage();
+  }
+  const QByteArray source(sourceFile.readAll());
+  QSize imageSize;
+  QSize mcuSize;
+  if (!JpegLosslessTransform::readGeometry(source, &imageSize, &mcuSize) || (imageSize != origImage.size())) {
+    return QImage();
+  }
+
+  if (JpegLosslessTransform::alignCrop(sourceRect, rotation, mcuSize, imageSize) != sourceRect) {
+    return QImage();
+  }
+  const QByteArray output(JpegLosslessTransform::transform(source, sourceRect, rotation));
+  if (output.isEmpty()) {
+    return QImage();
+  }
+
+  QFile outFile(filePath);
+  if (!outFile.open(QIODevice::WriteOnly) || (outFile.write(output) != output.size())) {
+    outFile.remove();
+    return QImage();
+  }
+  outFile.close();
+  // The pixels are those of the source, no need to decode what was written.
+  return origImage.copy(sourceRect).transformed(QTransform().rotate(rotation));
+}  // writeLosslessJpegOutput
+
 class BatchUiUpdater : public FilterResult {
  public:
   BatchUiUpdater(std::shared_ptr<Filter> filter, const PageId& pageId)
@@ -140,9 +209,7 @@ Task::Task(std::shared_ptr<Filter> filter,
       m_lastTab(lastTab),
       m_batchProcessing(batch),
       m_debug(debug) {
-  if (debug) {
-    m_dbg = std::make_unique<DebugImagesImpl>();
-  }
+  m_dbg = DebugImagesImpl::create(debug, "output", m_pageId);
 }
 
 Task::~Task() = default;
@@ -187,6 +254,11 @@ FilterResultPtr Task::process(const TaskStatus& status,
   const QString specklesFilePath(QDir(specklesDir).absoluteFilePath(outFileInfo.fileName()));
   QFileInfo specklesFileInfo(specklesFilePath);
 
+  // With the book output format, the page and all its layers go to the book
+  // instead of the files above, under the name the output file would have.
+  const std::shared_ptr<TiffBookContainer> book(m_outFileNameGen.bookContainer());
+  const QString bookKey(outFileInfo.fileName());
+
   const bool needPictureEditor = renderParams.mixedOutput() && !m_batchProcessing;
   const bool needSpecklesImage
       = ((params.despeckleLevel() != .0) && renderParams.needBinarization() && !m_batchProcessing);
@@ -244,6 +316,11 @@ FilterResultPtr Task::process(const TaskStatus& status,
       needReprocess = true;
       break;
     }
+    if (book) {
+      needReprocess = !Utils::isBookPageUpToDate(*book, bookKey, *storedOutputParams, renderParams,
+                                                 needPictureEditor, needSpecklesImage);
+      break;
+    }
     if (!renderParams.splitOutput()) {
       if (!outFileInfo.exists()) {
         needReprocess = true;
@@ -305,43 +382,46 @@ FilterResultPtr Task::process(const TaskStatus& status,
   BinaryImage specklesImg;
 
   if (!needReprocess) {
-    QFile outFile(outFilePath);
-    if (outFile.open(QIODevice::ReadOnly)) {
-      outImg = ImageLoader::load(outFile, 0);
-    }
-    if (outImg.isNull() && renderParams.splitOutput()) {
-      OutputImageBuilder imageBuilder;
-      QFile foregroundFile(foregroundFilePath);
-      if (foregroundFile.open(QIODevice::ReadOnly)) {
-        imageBuilder.setForegroundImage(ImageLoader::load(foregroundFile, 0));
+    // Loads either a layer of the page in the book or the file it would otherwise be written to.
+    const auto loadImage = [&book, &bookKey](const QString& filePath,
+                                             const std::optional<TiffBookContainer::Layer> layer) -> QImage {
+      if (book) {
+        return layer ? book->readLayer(bookKey, *layer) : book->readPage(bookKey);
       }
-      QFile backgroundFile(backgroundFilePath);
-      if (backgroundFile.open(QIODevice::ReadOnly)) {
-        imageBuilder.setBackgroundImage(ImageLoader::load(backgroundFile, 0));
+      QFile file(filePath);
+      if (!file.open(QIODevice::ReadOnly)) {
+        return QImage();
       }
-      if (renderParams.originalBackground()) {
-        QFile originalBackgroundFile(originalBackgroundFilePath);
-        if (originalBackgroundFile.open(QIODevice::ReadOnly)) {
-          imageBuilder.setOriginalBackgroundImage(ImageLoader::load(originalBackgroundFile, 0));
+      return ImageLoader::load(file, 0);
+    };
+
+    outImg = loadImage(outFilePath, std::nullopt);
+    if (outImg.isNull() && renderParams.splitOutput()) {
+      const QImage foregroundImg(loadImage(foregroundFilePath, TiffBookContainer::FOREGROUND_LAYER));
+      const QImage backgroundImg(loadImage(backgroundFilePath, TiffBookContainer::BACKGROUND_LAYER));
+      const QImage originalBackgroundImg(
+          renderParams.originalBackground()
+              ? loadImage(originalBackgroundFilePath, TiffBookContainer::ORIGINAL_BACKGROUND_LAYER)
+              : QImage());
+      if (!foregroundImg.isNull() && !backgroundImg.isNull()
+          && (!renderParams.originalBackground() || !originalBackgroundImg.isNull())) {
+        OutputImageBuilder imageBuilder;
+        imageBuilder.setForegroundImage(foregroundImg).setBackgroundImage(backgroundImg);
+        if (renderParams.originalBackground()) {
+          imageBuilder.setOriginalBackgroundImage(originalBackgroundImg);
         }
+        outImg = *imageBuilder.build();
       }
-      outImg = *imageBuilder.build();
     }
     needReprocess = outImg.isNull();
 
     if (needPictureEditor && !needReprocess) {
-      QFile automaskFile(automaskFilePath);
-      if (automaskFile.open(QIODevice::ReadOnly)) {
-        automaskImg = BinaryImage(ImageLoader::load(automaskFile, 0));
-      }
+      automaskImg = BinaryImage(loadImage(automaskFilePath, TiffBookContainer::AUTOMASK_LAYER));
       needReprocess = automaskImg.isNull() || automaskImg.size() != outImg.size();
     }
 
     if (needSpecklesImage && !needReprocess) {
-      QFile specklesFile(specklesFilePath);
-      if (specklesFile.open(QIODevice::ReadOnly)) {
-        specklesImg = BinaryImage(ImageLoader::load(specklesFile, 0));
-      }
+      specklesImg = BinaryImage(loadImage(specklesFilePath, TiffBookContainer::SPECKLES_LAYER));
       needReprocess = specklesImg.isNull();
     }
   }
@@ -353,69 +433,97 @@ FilterResultPtr Task::process(const TaskStatus& status,
 
     if (isPassThrough) {
       // Pass-through mode: apply geometric transforms (page split, deskew) but skip heavy processing
-      QImage origImage = data.origImage();
-
-      // Apply photo adjustments (temp/tint + tonal curve) before the geometric transform,
-      // matching the order OutputGenerator uses for the normal path.
-      const weasel::PhotoAdjustments& adj = params.colorParams().photoAdjustments();
-      if (!adj.isDefault()) {
-        origImage = weasel::TonalCurve::apply(origImage, adj.temp(), adj.tint(), adj.exposure(),
-                                              adj.contrast(), adj.highlights(), adj.shadows(),
-                                              adj.whites(), adj.blacks());
-      }
 
-      const QRect outputRect = newXform.resultingRect().toRect();
+      // A JPEG that only gets rotated and cropped is transformed without decoding.
+      outImg = writeLosslessJpegOutput(outFilePath, m_pageId, newXform, data.origImage(), newOutputImageParams,
+                                       newFillZones, m_outFileNameGen);
+      const bool writtenLosslessly = !outImg.isNull();
+
+      if (!writtenLosslessly) {
+        QImage origImage = data.isBitonal() ? data.grayImage().toQImage() : data.origImage();
+
+        // Apply photo adjustments (temp/tint + tonal curve) before the geometric transform,
+        // matching the order OutputGenerator uses for the normal path.
+        const weasel::PhotoAdjustments& adj = params.colorParams().photoAdjustments();
+        if (!adj.isDefault()) {
+          origImage = weasel::TonalCurve::apply(origImage, adj.temp(), adj.tint(), adj.exposure(),
+                                                adj.contrast(), adj.highlights(), adj.shadows(),
+                                                adj.whites(), adj.blacks());
+        }
 
-      // Clip the output rect to the pre-crop area (page split boundary) so pixels
-      // from the other half of a two-page spread don't bleed into the margins.
-      const QPolygonF preCropArea = newXform.resultingPreCropArea();
-      const QRect croppedRect = preCropArea.boundingRect().toRect().intersected(outputRect);
+        const QRect outputRect = newXform.resultingRect().toRect();
+
+        // Clip the output rect to the pre-crop area (page split boundary) so pixels
+        // from the other half of a two-page spread don't bleed into the margins.
+        const QPolygonF preCropArea = newXform.resultingPreCropArea();
+        const QRect croppedRect = preCropArea.boundingRect().toRect().intersected(outputRect);
+
+        // Transform source image into the clipped rect
+        QImage croppedImg = transform(origImage, newXform.transform(), croppedRect,
+                                      OutsidePixels::assumeColor(Qt::white));
+
+        // Place onto white canvas of the full output size
+        outImg = QImage(outputRect.size(), croppedImg.format());
+        outImg.fill(Qt::white);
+        const int offsetX = croppedRect.left() - outputRect.left();
+        const int offsetY = croppedRect.top() - outputRect.top();
+        {
+          QPainter painter(&outImg);
+          painter.drawImage(offsetX, offsetY, croppedImg);
+        }
 
-      // Transform source image into the clipped rect
-      QImage croppedImg = transform(origImage, newXform.transform(), croppedRect,
-                                    OutsidePixels::assumeColor(Qt::white));
+        // Apply brightness/contrast adjustments even in pass-through mode
+        const double brightness = outputProcessingParams.brightness();
+        const double contrast = outputProcessingParams.contrast();
+        const bool autoLevels = outputProcessingParams.autoLevels();
 
-      // Place onto white canvas of the full output size
-      outImg = QImage(outputRect.size(), croppedImg.format());
-      outImg.fill(Qt::white);
-      const int offsetX = croppedRect.left() - outputRect.left();
-      const int offsetY = croppedRect.top() - outputRect.top();
-      {
-        QPainter painter(&outImg);
-        painter.drawImage(offsetX, offsetY, croppedImg);
-      }
+        if (autoLevels || brightness != 0.0 || contrast != 0.0) {
+          QImage work = outImg.convertToFormat(QImage::Format_ARGB32);
+          const int w = work.width();
+          const int h = work.height();
 
-      // Apply brightness/contrast adjustments even in pass-through mode
-      const double brightness = outputProcessingParams.brightness();
-      const double contrast = outputProcessingParams.contrast();
-      const bool autoLevels = outputProcessingParams.autoLevels();
-
-      if (autoLevels || brightness != 0.0 || contrast != 0.0) {
-        QImage work = outImg.convertToFormat(QImage::Format_ARGB32);
-        const int w = work.width();
-        const int h = work.height();
-
-        // Auto levels: stretch histogram to full 0-255 range
-        if (autoLevels) {
-          int minVal = 255, maxVal = 0;
-          for (int y = 0; y < h; ++y) {
-            const QRgb* line = reinterpret_cast<const QRgb*>(work.constScanLine(y));
-            for (int x = 0; x < w; ++x) {
-              const QRgb p = line[x];
-              const int gray = (qRed(p) + qGreen(p) + qBlue(p)) / 3;
-              minVal = std::min(minVal, gray);
-              maxVal = std::max(maxVal, gray);
+          // Auto levels: stretch histogram to full 0-255 range
+          if (autoLevels) {
+            int minVal = 255, maxVal = 0;
+            for (int y = 0; y < h; ++y) {
+              const QRgb* line = reinterpret_cast<const QRgb*>(work.constScanLine(y));
+              for (int x = 0; x < w; ++x) {
+                const QRgb p = line[x];
+                const int gray = (qRed(p) + qGreen(p) + qBlue(p)) / 3;
+                minVal = std::min(minVal, gray);
+                maxVal = std::max(maxVal, gray);
+              }
+            }
+            if (maxVal > minVal) {
+              const double scale = 255.0 / (maxVal - minVal);
+              for (int y = 0; y < h; ++y) {
+                QRgb* line = reinterpret_cast<QRgb*>(work.scanLine(y));
+                for (int x = 0; x < w; ++x) {
+                  const QRgb p = line[x];
+                  int r = static_cast<int>((qRed(p) - minVal) * scale);
+                  int g = static_cast<int>((qGreen(p) - minVal) * scale);
+                  int b = static_cast<int>((qBlue(p) - minVal) * scale);
+                  r = std::clamp(r, 0, 255);
+                  g = std::clamp(g, 0, 255);
+                  b = std::clamp(b, 0, 255);
+                  line[x] = qRgb(r, g, b);
+                }
+              }
             }
           }
-          if (maxVal > minVal) {
-            const double scale = 255.0 / (maxVal - minVal);
+
+          // Apply brightness/contrast
+          if (brightness != 0.0 || contrast != 0.0) {
+            const int bShift = static_cast<int>(brightness * 255.0);
+            const double cMul = std::max(0.2, std::pow(2.0, contrast * 1.3));
+
             for (int y = 0; y < h; ++y) {
               QRgb* line = reinterpret_cast<QRgb*>(work.scanLine(y));
               for (int x = 0; x < w; ++x) {
                 const QRgb p = line[x];
-                int r = static_cast<int>((qRed(p) - minVal) * scale);
-                int g = static_cast<int>((qGreen(p) - minVal) * scale);
-                int b = static_cast<int>((qBlue(p) - minVal) * scale);
+                int r = static_cast<int>((qRed(p) - 128) * cMul + 128 + bShift);
+                int g = static_cast<int>((qGreen(p) - 128) * cMul + 128 + bShift);
+                int b = static_cast<int>((qBlue(p) - 128) * cMul + 128 + bShift);
                 r = std::clamp(r, 0, 255);
                 g = std::clamp(g, 0, 255);
                 b = std::clamp(b, 0, 255);
@@ -423,33 +531,15 @@ FilterResultPtr Task::process(const TaskStatus& status,
               }
             }
           }
-        }
 
-        // Apply brightness/contrast
-        if (brightness != 0.0 || contrast != 0.0) {
-          const int bShift = static_cast<int>(brightness * 255.0);
-          const double cMul = std::max(0.2, std::pow(2.0, contrast * 1.3));
-
-          for (int y = 0; y < h; ++y) {
-            QRgb* line = reinterpret_cast<QRgb*>(work.scanLine(y));
-            for (int x = 0; x < w; ++x) {
-              const QRgb p = line[x];
-              int r = static_cast<int>((qRed(p) - 128) * cMul + 128 + bShift);
-              int g = static_cast<int>((qGreen(p) - 128) * cMul + 128 + bShift);
-              int b = static_cast<int>((qBlue(p) - 128) * cMul + 128 + bShift);
-              r = std::clamp(r, 0, 255);
-              g = std::clamp(g, 0, 255);
-              b = std::clamp(b, 0, 255);
-              line[x] = qRgb(r, g, b);
-            }
-          }
+          outImg = work.convertToFormat(outImg.format());
         }
-
-        outImg = work.convertToFormat(outImg.format());
       }
 
       bool invalidateParams = false;
-      if (!writeOutputImage(outFilePath, outImg, m_outFileNameGen)) {
+      if (book) {
+        invalidateParams = !book->writePage(bookKey, outImg);
+      } else if (!writtenLosslessly && !writeOutputImage(outFilePath, outImg, m_outFileNameGen)) {
         invalidateParams = true;
       } else {
         deleteMutuallyExclusiveOutputFiles();
@@ -464,7 +554,8 @@ FilterResultPtr Task::process(const TaskStatus& status,
         m_settings->removeOutputParams(m_pageId);
       } else {
         const OutputParams outParams(
-            newOutputImageParams, OutputFileParams(sourceFileInfo), OutputFileParams(QFileInfo(outFilePath)),
+            newOutputImageParams, OutputFileParams(sourceFileInfo),
+            book ? OutputFileParams::forBookPage(book->pageStamp(bookKey)) : OutputFileParams(QFileInfo(outFilePath)),
             OutputFileParams(), OutputFileParams(), OutputFileParams(), OutputFileParams(), OutputFileParams(),
             newPictureZones, newFillZones);
         m_settings->setOutputParams(m_pageId, outParams);
@@ -492,6 +583,7 @@ FilterResultPtr Task::process(const TaskStatus& status,
       }
 
       bool invalidateParams = false;
+      TiffBookContainer::Layers bookLayers;
       {
         std::unique_ptr<OutputImage> outputImage
             = generator.process(status, data, newPictureZones, newFillZones, distortionModel, params.depthPerception(),
@@ -519,6 +611,9 @@ FilterResultPtr Task::process(const TaskStatus& status,
         if (!outputImageWithForeground) {
           qWarning() << "Output: Failed to cast to OutputImageWithForeground for split output";
           invalidateParams = true;
+        } else if (book) {
+          bookLayers[TiffBookContainer::FOREGROUND_LAYER] = outputImageWithForeground->getForegroundImage();
+          bookLayers[TiffBookContainer::BACKGROUND_LAYER] = outputImageWithForeground->getBackgroundImage();
         } else {
           QDir().mkdir(foregroundDir);
           QDir().mkdir(backgroundDir);
@@ -533,6 +628,9 @@ FilterResultPtr Task::process(const TaskStatus& status,
           if (!outputImageWithOrigBg) {
             qWarning() << "Output: Failed to cast to OutputImageWithOriginalBackground";
             invalidateParams = true;
+          } else if (book) {
+            bookLayers[TiffBookContainer::ORIGINAL_BACKGROUND_LAYER]
+                = outputImageWithOrigBg->getOriginalBackgroundImage();
           } else {
             QDir().mkdir(originalBackgroundDir);
             if (!TiffWriter::writeImage(originalBackgroundFilePath,
@@ -554,10 +652,13 @@ FilterResultPtr Task::process(const TaskStatus& status,
       QFile::remove(backgroundFilePath);
     }
 
-    if (!writeOutputImage(outFilePath, outImg, m_outFileNameGen)) {
-      invalidateParams = true;
-    } else {
-      deleteMutuallyExclusiveOutputFiles();
+    // A page of the book is written below, together with its layers.
+    if (!book) {
+      if (!writeOutputImage(outFilePath, outImg, m_outFileNameGen)) {
+        invalidateParams = true;
+      } else {
+        deleteMutuallyExclusiveOutputFiles();
+      }
     }
 
     if (writeSpecklesFile && specklesImg.isNull()) {
@@ -567,7 +668,17 @@ FilterResultPtr Task::process(const TaskStatus& status,
       BinaryImage(outImg.size(), WHITE).swap(specklesImg);
     }
 
-    if (writeAutomask) {
+    if (book) {
+      if (writeAutomask) {
+        bookLayers[TiffBookContainer::AUTOMASK_LAYER] = automaskImg.toQImage();
+      }
+      if (writeSpecklesFile) {
+        bookLayers[TiffBookContainer::SPECKLES_LAYER] = specklesImg.toQImage();
+      }
+      if (!book->writePage(bookKey, outImg, bookLayers)) {
+        invalidateParams = true;
+      }
+    } else if (writeAutomask) {
       // Note that QDir::mkdir() will fail if the parent directory,
       // that is $OUT/cache doesn't exist. We want that behaviour,
       // as otherwise when loading a project from a different machine,
@@ -579,7 +690,7 @@ FilterResultPtr Task::process(const TaskStatus& status,
         invalidateParams = true;
       }
     }
-    if (writeSpecklesFile) {
+    if (writeSpecklesFile && !book) {
       if (!QDir().mkpath(specklesDir)) {
         invalidateParams = true;
       } else if (!TiffWriter::writeImage(specklesFilePath, specklesImg.toQImage())) {
@@ -589,6 +700,14 @@ FilterResultPtr Task::process(const TaskStatus& status,
 
     if (invalidateParams) {
       m_settings->removeOutputParams(m_pageId);
+    } else if (book) {
+      // Everything is in the book, so the page stamp stands for all of it.
+      const OutputParams outParams(newOutputImageParams, OutputFileParams(sourceFileInfo),
+                                   OutputFileParams::forBookPage(book->pageStamp(bookKey)), OutputFileParams(),
+                                   OutputFileParams(), OutputFileParams(), OutputFileParams(), OutputFileParams(),
+                                   newPictureZones, newFillZones);
+
+      m_settings->setOutputParams(m_pageId, outParams);
     } else {
       // Note that we can't reuse *_file_info objects
       // as we've just overwritten those files.
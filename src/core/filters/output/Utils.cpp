@@ -11,7 +11,10 @@
 #include <QTransform>
 
 #include "Dpi.h"
+#include "OutputParams.h"
 #include "Params.h"
+#include "RenderParams.h"
+#include "TiffBookContainer.h"
 
 namespace output {
 QString Utils::automaskDir(const QString& outDir) {
@@ -65,4 +68,29 @@ Params Utils::buildDefaultParams() {
                 outputParams.getPictureShapeOptions(), dewarping::DistortionModel(), outputParams.getDepthPerception(),
                 outputParams.getDewarpingOptions(), outputParams.getDespeckleLevel());
 }
+
+bool Utils::isBookPageUpToDate(const TiffBookContainer& book,
+                               const QString& key,
+                               const OutputParams& outputParams,
+                               const RenderParams& renderParams,
+                               const bool needAutomask,
+                               const bool needSpeckles) {
+  // The layers are written along with the page, so its stamp covers them too.
+  if (!outputParams.outputFileParams().matches(OutputFileParams::forBookPage(book.pageStamp(key)))) {
+    return false;
+  }
+  if (renderParams.splitOutput()) {
+    if (!book.hasLayer(key, TiffBookContainer::FOREGROUND_LAYER)
+        || !book.hasLayer(key, TiffBookContainer::BACKGROUND_LAYER)) {
+      return false;
+    }
+    if (renderParams.originalBackground() && !book.hasLayer(key, TiffBookContainer::ORIGINAL_BACKGROUND_LAYER)) {
+      return false;
+    }
+  }
+  if (needAutomask && !book.hasLayer(key, TiffBookContainer::AUTOMASK_LAYER)) {
+    return false;
+  }
+  return !needSpeckles || book.hasLayer(key, TiffBookContainer::SPECKLES_LAYER);
+}
 }  // namespace output
\ No newline at end of file
@@ -8,9 +8,12 @@ class Dpi;
 class QString;
 class QTransform;
 class QRect;
+class TiffBookContainer;
 
 namespace output {
+class OutputParams;
 class Params;
+class RenderParams;
 
 class Utils {
  public:
@@ -33,6 +36,20 @@ class Utils {
   static QTransform rotate(double degrees, const QRect& imageRect);
 
   static Params buildDefaultParams();
+
+  /**
+   * \brief Checks that \p book still holds the page \p outputParams were stored for,
+   *        along with the layers the page needs.
+   *
+   * This is what stands for the output file checks when the output goes to
+   * a book container.  It only looks at the index of the container.
+   */
+  static bool isBookPageUpToDate(const TiffBookContainer& book,
+                                 const QString& key,
+                                 const OutputParams& outputParams,
+                                 const RenderParams& renderParams,
+                                 bool needAutomask,
+                                 bool needSpeckles);
 };
 }  // namespace output
 #endif
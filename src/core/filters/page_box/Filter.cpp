@@ -152,7 +152,13 @@ std::shared_ptr<Task> Filter::createTask(const PageId& pageId,
                                          bool batch,
                                          bool debug) {
   return std::make_shared<Task>(std::static_pointer_cast<Filter>(shared_from_this()), std::move(nextTask), m_settings,
-                                pageId, batch, debug);
+                                pageId, batch, debug, /*speculative=*/false);
+}
+
+std::shared_ptr<Task> Filter::createSpeculativeTask(const PageId& pageId,
+                                                    std::shared_ptr<select_content::Task> nextTask) {
+  return std::make_shared<Task>(std::static_pointer_cast<Filter>(shared_from_this()), std::move(nextTask), m_settings,
+                                pageId, /*batch=*/true, /*debug=*/false, /*speculative=*/true);
 }
 
 std::shared_ptr<CacheDrivenTask> Filter::createCacheDrivenTask(
@@ -53,6 +53,14 @@ class Filter : public AbstractFilter {
                                    bool batch,
                                    bool debug);
 
+  /**
+   * \brief Creates a task that only replays the stored parameters, so that a speculative
+   *        task further down the chain gets the page as the user would see it.
+   *
+   * See Task::process().
+   */
+  std::shared_ptr<Task> createSpeculativeTask(const PageId& pageId, std::shared_ptr<select_content::Task> nextTask);
+
   std::shared_ptr<CacheDrivenTask> createCacheDrivenTask(
       std::shared_ptr<select_content::CacheDrivenTask> nextTask);
 
@@ -8,28 +8,15 @@
 namespace page_box {
 OrderByHeightProvider::OrderByHeightProvider(std::shared_ptr<Settings> settings) : m_settings(std::move(settings)) {}
 
-bool OrderByHeightProvider::precedes(const PageId& lhsPage,
-                                     const bool lhsIncomplete,
-                                     const PageId& rhsPage,
-                                     const bool rhsIncomplete) const {
-  const std::unique_ptr<Params> lhsParams(m_settings->getPageParams(lhsPage));
-  const std::unique_ptr<Params> rhsParams(m_settings->getPageParams(rhsPage));
+PageOrderKey OrderByHeightProvider::sortKey(const PageId& page, const bool incomplete) const {
+  const std::unique_ptr<Params> params(m_settings->getPageParams(page));
 
-  QRectF lhsRect;
-  if (lhsParams) {
-    lhsRect = lhsParams->pageRect();
+  QRectF rect;
+  if (params) {
+    rect = params->pageRect();
   }
-  QRectF rhsRect;
-  if (rhsParams) {
-    rhsRect = rhsParams->pageRect();
-  }
-
-  const bool lhsValid = !lhsIncomplete && lhsRect.isValid();
-  const bool rhsValid = !rhsIncomplete && rhsRect.isValid();
 
-  if (lhsValid != rhsValid) {
-    return lhsValid;
-  }
-  return lhsRect.height() < rhsRect.height();
+  const bool valid = !incomplete && rect.isValid();
+  return PageOrderKey(valid ? 0 : 1, rect.height());
 }
 }  // namespace page_box
@@ -14,7 +14,7 @@ class OrderByHeightProvider : public PageOrderProvider {
  public:
   explicit OrderByHeightProvider(std::shared_ptr<Settings> settings);
 
-  bool precedes(const PageId& lhsPage, bool lhsIncomplete, const PageId& rhsPage, bool rhsIncomplete) const override;
+  PageOrderKey sortKey(const PageId& page, bool incomplete) const override;
 
  private:
   std::shared_ptr<Settings> m_settings;
@@ -3,12 +3,22 @@
 
 #include "PageFinder.h"
 
-#include <Binarize.h>
 #include <BinaryImage.h>
-#include <GrayRasterOp.h>
-#include <Transform.h>
-
-#include <QDebug>
+#include <BinaryThreshold.h>
+#include <BitOps.h>
+#include <GrayImage.h>
+#include <Grayscale.h>
+#include <IntegralImage.h>
+
+#include <QRect>
+#include <QRectF>
+#include <QSize>
+#include <QSizeF>
+#include <QTransform>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
 
 #include "DebugImages.h"
 #include "FilterData.h"
@@ -17,6 +27,59 @@
 namespace page_box {
 using namespace imageproc;
 
+/**
+ * \brief Per-row and per-column black pixel counts of a binary image.
+ *
+ * Everything is collected from whole 32-bit words.
+ */
+class PageFinder::Profiles {
+ public:
+  explicit Profiles(const BinaryImage& image);
+
+  int width() const { return m_width; }
+
+  int height() const { return m_height; }
+
+  const std::vector<int>& rowBlackCounts() const { return m_rowBlack; }
+
+  const std::vector<int>& colBlackCounts() const { return m_colBlack; }
+
+ private:
+  int m_width;
+  int m_height;
+  std::vector<int> m_rowBlack;
+  std::vector<int> m_colBlack;
+};
+
+PageFinder::Profiles::Profiles(const BinaryImage& image)
+    : m_width(image.width()), m_height(image.height()), m_rowBlack(m_height, 0), m_colBlack(m_width, 0) {
+  const int wpl = image.wordsPerLine();
+  const int lastWordIdx = wpl - 1;
+  const uint32_t lastWordMask = ~uint32_t(0) << ((32 - m_width % 32) % 32);
+  const uint32_t* line = image.data();
+
+  for (int y = 0; y < m_height; ++y, line += wpl) {
+    int count = 0;
+    for (int i = 0; i <= lastWordIdx; ++i) {
+      uint32_t word = line[i];
+      if (i == lastWordIdx) {
+        word &= lastWordMask;
+      }
+      if (!word) {
+        continue;
+      }
+      count += countNonZeroBits(word);
+      int* const colBlack = &m_colBlack[i * 32];
+      do {
+        const int bit = countMostSignificantZeroes(word);
+        ++colBlack[bit];
+        word &= ~(uint32_t(0x80000000) >> bit);
+      } while (word);
+    }
+    m_rowBlack[y] = count;
+  }
+}
+
 QRectF PageFinder::findPageBox(const TaskStatus& status,
                                const FilterData& data,
                                bool fineTune,
@@ -30,157 +93,241 @@ QRectF PageFinder::findPageBox(const TaskStatus& status,
     return QRectF();
   }
 
-  double to150 = 150.0 / 25.4;
-  auto expWidth = int(to150 * box.width());
-  auto expHeight = int(to150 * box.height());
+  const double to150 = 150.0 / 25.4;
+  const QSize expectedSize(box.isEmpty() ? QSize() : QSize(int(to150 * box.width()), int(to150 * box.height())));
 
-#ifdef DEBUG
-  std::cout << "dpi: " << data.xform().origDpi().horizontal() << std::endl;
-  std::cout << "tolerance: " << tolerance << std::endl;
-  std::cout << "expWidth = " << expWidth << "; expHeight" << expHeight << std::endl;
-#endif
-
-  const GrayImage dataGrayImage = data.grayImageBlackOnWhite();
-  const uint8_t darkestGrayLevel = imageproc::darkestGrayLevel(dataGrayImage);
-  const QColor outsideColor(darkestGrayLevel, darkestGrayLevel, darkestGrayLevel);
-
-  QImage gray150(transformToGray(dataGrayImage, xform150dpi.transform(), xform150dpi.resultingRect().toRect(),
-                                 OutsidePixels::assumeColor(outsideColor)));
+  // Shared with the content box detection, which runs on the same image.
+  const GrayImage gray150(data.grayImage150dpi());
   if (dbg) {
     dbg->add(gray150, "gray150");
   }
 
-
-  std::vector<QRect> rects;
-  std::vector<BinaryImage> bwimages;
-
-
-  bwimages.push_back(peakThreshold(gray150));
-  bwimages.push_back(binarizeOtsu(gray150));
-  bwimages.push_back(binarizeMokji(gray150));
-  bwimages.push_back(binarizeSauvola(gray150, gray150.size()));
-  bwimages.push_back(binarizeWolf(gray150, gray150.size()));
-  if (dbg) {
-    dbg->add(bwimages[0], "peakThreshold");
-    dbg->add(bwimages[1], "OtsuThreshold");
-    dbg->add(bwimages[2], "MokjiThreshold");
-    dbg->add(bwimages[3], "SauvolaThreshold");
-    dbg->add(bwimages[4], "WolfThreshold");
+  if (gray150.isNull()) {
+    return QRectF();
   }
 
+  status.throwIfCancelled();
+
   QRect contentRect(0, 0, 0, 0);
-  double errWidth = 1.0;
-  double errHeight = 1.0;
-
-  if (box.isEmpty()) {
-    QImage bwimg(bwimages[3].toQImage());
-    contentRect = detectBorders(bwimg);
-    if (fineTune) {
-      fineTuneCorners(bwimg, contentRect, QSize(0, 0), 1.0);
+  if (expectedSize.isEmpty()) {
+    const BinaryImage bw150(binarize(gray150, false).front());
+    if (dbg) {
+      dbg->add(bw150, "SauvolaThreshold");
     }
+    contentRect = findPageBorders(bw150, fineTune, QSize(), 1.0);
   } else {
-    for (uint32_t i = 0; i < bwimages.size(); ++i) {
-      QImage bwimg(bwimages[i].toQImage());
-      rects.push_back(QRect(detectBorders(bwimg)));
-      if (fineTune) {
-        fineTuneCorners(bwimg, rects[i], QSize(expWidth, expHeight), tolerance);
+    // Each binarization finds the page edges well on some scans only,
+    // so take the edges whose distances best match the expected size.
+    const std::vector<BinaryImage> bwImages(binarize(gray150, true));
+    if (dbg) {
+      const char* const labels[] = {"peakThreshold", "OtsuThreshold", "MokjiThreshold", "SauvolaThreshold",
+                                    "WolfThreshold"};
+      for (size_t i = 0; i < bwImages.size(); ++i) {
+        dbg->add(bwImages[i], labels[i]);
       }
-#ifdef DEBUG
-      std::cout << "width = " << rects[i].width() << "; height=" << rects[i].height() << std::endl;
-#endif
+    }
 
-      double errW = double(std::abs(expWidth - rects[i].width())) / double(expWidth);
-      double errH = double(std::abs(expHeight - rects[i].height())) / double(expHeight);
-#ifdef DEBUG
-      std::cout << "errW=" << errW << "; errH" << errH << std::endl;
-#endif
+    double errWidth = 1.0;
+    double errHeight = 1.0;
+    for (const BinaryImage& bw150 : bwImages) {
+      status.throwIfCancelled();
 
+      const QRect rect(findPageBorders(bw150, fineTune, expectedSize, tolerance));
+      const double errW = double(std::abs(expectedSize.width() - rect.width())) / expectedSize.width();
+      const double errH = double(std::abs(expectedSize.height() - rect.height())) / expectedSize.height();
       if (errW < errWidth) {
-        contentRect.setLeft(rects[i].left());
-        contentRect.setRight(rects[i].right());
+        contentRect.setLeft(rect.left());
+        contentRect.setRight(rect.right());
         errWidth = errW;
       }
       if (errH < errHeight) {
-        contentRect.setTop(rects[i].top());
-        contentRect.setBottom(rects[i].bottom());
+        contentRect.setTop(rect.top());
+        contentRect.setBottom(rect.bottom());
         errHeight = errH;
       }
     }
   }
-#ifdef DEBUG
-  std::cout << "width = " << contentRect.width() << "; height=" << contentRect.height() << std::endl;
-#endif
 
   QTransform combinedXform(xform150dpi.transform().inverted());
   combinedXform *= data.xform().transform();
-  QRectF result = combinedXform.map(QRectF(contentRect)).boundingRect();
-  return result;
+  return combinedXform.map(QRectF(contentRect)).boundingRect();
 }  // PageFinder::findPageBox
 
-QRect PageFinder::detectBorders(const QImage& img) {
-  int l = 0, t = 0, r = img.width() - 1, b = img.height() - 1;
-  int xmid = r / 2;
-  int ymid = b / 2;
+/**
+ * The local thresholds are those of binarizeSauvola() and binarizeWolf()
+ * with windows of the image size, which are computed from the same integral
+ * images.  Sauvola's threshold is applied in the same pass that collects the
+ * window statistics Wolf's one needs.
+ */
+std::vector<BinaryImage> PageFinder::binarize(const GrayImage& gray, const bool allMethods) {
+  std::vector<BinaryImage> images;
+  if (gray.isNull()) {
+    return images;
+  }
+
+  if (allMethods) {
+    const GrayscaleHistogram histogram(gray);
+    images.emplace_back(gray.toQImage(), BinaryThreshold::peakThreshold(histogram));
+    images.emplace_back(gray.toQImage(), BinaryThreshold::otsuThreshold(histogram));
+    images.emplace_back(gray.toQImage(), BinaryThreshold::mokjiThreshold(gray));
+  }
+
+  const int w = gray.width();
+  const int h = gray.height();
+  const uint8_t* const grayData = gray.data();
+  const int grayStride = gray.stride();
+
+  IntegralImage<uint32_t> integralImage(w, h);
+  IntegralImage<uint64_t> integralSqimage(w, h);
+  uint32_t minGrayLevel = 255;
+
+  const uint8_t* grayLine = grayData;
+  for (int y = 0; y < h; ++y, grayLine += grayStride) {
+    integralImage.beginRow();
+    integralSqimage.beginRow();
+    for (int x = 0; x < w; ++x) {
+      const uint32_t pixel = grayLine[x];
+      integralImage.push(pixel);
+      integralSqimage.push(pixel * pixel);
+      minGrayLevel = std::min(minGrayLevel, pixel);
+    }
+  }
+
+  const int windowLowerHalf = h >> 1;
+  const int windowUpperHalf = h - windowLowerHalf;
+  const int windowLeftHalf = w >> 1;
+  const int windowRightHalf = w - windowLeftHalf;
+  const uint32_t msb = uint32_t(1) << 31;
+
+  BinaryImage sauvola(w, h, WHITE);
+  uint32_t* const sauvolaData = sauvola.data();
+  const int sauvolaWpl = sauvola.wordsPerLine();
+  std::vector<float> means;
+  std::vector<float> deviations;
+  if (allMethods) {
+    means.resize(size_t(w) * h);
+    deviations.resize(size_t(w) * h);
+  }
+  double maxDeviation = 0;
+
+  grayLine = grayData;
+  for (int y = 0; y < h; ++y, grayLine += grayStride) {
+    const int top = std::max(0, y - windowLowerHalf);
+    const int bottom = std::min(h, y + windowUpperHalf);
+    uint32_t* const sauvolaLine = sauvolaData + y * sauvolaWpl;
+    for (int x = 0; x < w; ++x) {
+      const int left = std::max(0, x - windowLeftHalf);
+      const int right = std::min(w, x + windowRightHalf);
+      const int area = (bottom - top) * (right - left);
+      const QRect rect(left, top, right - left, bottom - top);
+      const double windowSum = integralImage.sum(rect);
+      const double windowSqsum = integralSqimage.sum(rect);
+
+      const double rArea = 1.0 / area;
+      const double mean = windowSum * rArea;
+      const double sqmean = windowSqsum * rArea;
+      const double deviation = std::sqrt(std::fabs(sqmean - mean * mean));
+
+      const double threshold = mean * (1.0 + 0.34 * (deviation / 128.0 - 1.0));
+      if (int(grayLine[x]) < threshold) {
+        sauvolaLine[x >> 5] |= msb >> (x & 31);
+      }
 
-  l = detectEdge(img, l, r, 1, ymid, Qt::Horizontal);
-  t = detectEdge(img, t, b, 1, xmid, Qt::Vertical);
-  r = detectEdge(img, r, 0, -1, ymid, Qt::Horizontal);
-  b = detectEdge(img, b, t, -1, xmid, Qt::Vertical);
-  return QRect(l, t, r - l + 1, b - t + 1);
+      if (allMethods) {
+        maxDeviation = std::max(maxDeviation, deviation);
+        means[size_t(w) * y + x] = float(mean);
+        deviations[size_t(w) * y + x] = float(deviation);
+      }
+    }
+  }
+  images.push_back(sauvola);
+
+  if (allMethods) {
+    BinaryImage wolf(w, h, WHITE);
+    uint32_t* wolfLine = wolf.data();
+    const int wolfWpl = wolf.wordsPerLine();
+
+    grayLine = grayData;
+    for (int y = 0; y < h; ++y, grayLine += grayStride, wolfLine += wolfWpl) {
+      for (int x = 0; x < w; ++x) {
+        const float mean = means[size_t(w) * y + x];
+        const float deviation = deviations[size_t(w) * y + x];
+        const double a = 1.0 - deviation / maxDeviation;
+        const double threshold = mean - 0.3 * a * (mean - minGrayLevel);
+        if ((grayLine[x] < 1) || ((grayLine[x] <= 254) && (int(grayLine[x]) < threshold))) {
+          wolfLine[x >> 5] |= msb >> (x & 31);
+        }
+      }
+    }
+    images.push_back(wolf);
+  }
+  return images;
+}  // PageFinder::binarize
+
+QRect PageFinder::findPageBorders(const BinaryImage& image,
+                                  const bool fineTune,
+                                  const QSize& expectedSize,
+                                  const double tolerance) {
+  if (image.isNull()) {
+    return QRect();
+  }
+
+  const Profiles profiles(image);
+  const std::vector<int>& rowBlack = profiles.rowBlackCounts();
+  const std::vector<int>& colBlack = profiles.colBlackCounts();
+
+  // A border line is one at least 95% black.
+  const auto minRowBlack = int(profiles.width() * 0.95);
+  const auto minColBlack = int(profiles.height() * 0.95);
+
+  const int l = detectEdge(colBlack, 0, profiles.width() - 1, 1, minColBlack);
+  const int t = detectEdge(rowBlack, 0, profiles.height() - 1, 1, minRowBlack);
+  const int r = detectEdge(colBlack, profiles.width() - 1, 0, -1, minColBlack);
+  const int b = detectEdge(rowBlack, profiles.height() - 1, t, -1, minRowBlack);
+
+  QRect rect(l, t, r - l + 1, b - t + 1);
+  if (fineTune) {
+    fineTuneCorners(image, rect, expectedSize, tolerance);
+  }
+  return rect;
 }
 
 /**
- * shift edge while points around mid are black
+ * Moves the edge inwards while lines are black, allowing short non-black gaps.
  */
-int PageFinder::detectEdge(const QImage& img, int start, int end, int inc, int mid, Qt::Orientation orient) {
-  int minSize = 10;
+int PageFinder::detectEdge(const std::vector<int>& blackCounts,
+                           const int start,
+                           const int end,
+                           const int inc,
+                           const int minBlack) {
+  const int maxGap = 10;
   int gap = 0;
-  int i = start, edge = start;
-  int ms = 0;
-  int me = 2 * mid;
-  auto minBp = int(double(me - ms) * 0.95);
-  Qt::GlobalColor black = Qt::color1;
-
-  while (i != end) {
-    int blackPixels = 0;
-
-    for (int j = ms; j != me; j++) {
-      int x = i, y = j;
-      if (orient == Qt::Vertical) {
-        x = j;
-        y = i;
-      }
-      int pixel = img.pixelIndex(x, y);
-      if (pixel == black) {
-        ++blackPixels;
-      }
-    }
+  int edge = start;
 
-    if (blackPixels < minBp) {
+  for (int i = start; i != end; i += inc) {
+    if (blackCounts[i] < minBlack) {
       ++gap;
     } else {
       gap = 0;
       edge = i;
     }
 
-    if (gap > minSize) {
+    if (gap > maxGap) {
       break;
     }
-
-    i += inc;
   }
   return edge;
-}  // PageFinder::detectEdge
+}
 
-void PageFinder::fineTuneCorners(const QImage& img, QRect& rect, const QSize& size, double tolerance) {
+void PageFinder::fineTuneCorners(const BinaryImage& image, QRect& rect, const QSize& size, double tolerance) {
   int l = rect.left(), t = rect.top(), r = rect.right(), b = rect.bottom();
   bool done = false;
 
   while (!done) {
-    done = fineTuneCorner(img, l, t, r, b, 1, 1, size, tolerance);
-    done &= fineTuneCorner(img, r, t, l, b, -1, 1, size, tolerance);
-    done &= fineTuneCorner(img, l, b, r, t, 1, -1, size, tolerance);
-    done &= fineTuneCorner(img, r, b, l, t, -1, -1, size, tolerance);
+    done = fineTuneCorner(image, l, t, r, b, 1, 1, size, tolerance);
+    done &= fineTuneCorner(image, r, t, l, b, -1, 1, size, tolerance);
+    done &= fineTuneCorner(image, l, b, r, t, 1, -1, size, tolerance);
+    done &= fineTuneCorner(image, r, b, l, t, -1, -1, size, tolerance);
   }
 
   rect.setLeft(l);
@@ -190,9 +337,9 @@ void PageFinder::fineTuneCorners(const QImage& img, QRect& rect, const QSize& si
 }
 
 /**
- * shift edges until given corner is out of black
+ * Shifts the corner diagonally while it stays on black pixels.
  */
-bool PageFinder::fineTuneCorner(const QImage& img,
+bool PageFinder::fineTuneCorner(const BinaryImage& image,
                                 int& x,
                                 int& y,
                                 int maxX,
@@ -201,24 +348,24 @@ bool PageFinder::fineTuneCorner(const QImage& img,
                                 int incY,
                                 const QSize& size,
                                 double tolerance) {
-  auto widthT = static_cast<int>(size.width() * (1.0 - tolerance));
-  auto heightT = static_cast<int>(size.height() * (1.0 - tolerance));
+  const auto widthT = static_cast<int>(size.width() * (1.0 - tolerance));
+  const auto heightT = static_cast<int>(size.height() * (1.0 - tolerance));
 
-  Qt::GlobalColor black = Qt::color1;
-  int pixel = img.pixelIndex(x, y);
-  int tx = x + incX;
-  int ty = y + incY;
-  int w = std::abs(maxX - x);
-  int h = std::abs(maxY - y);
+  const int tx = x + incX;
+  const int ty = y + incY;
+  const int w = std::abs(maxX - x);
+  const int h = std::abs(maxY - y);
 
   if ((!size.isEmpty()) && ((w < widthT) || (h < heightT))) {
     return true;
   }
-  if ((pixel != black) || (tx < 0) || (tx > (img.width() - 1)) || (ty < 0) || (ty > (img.height() - 1))) {
+  const uint32_t word = image.data()[y * image.wordsPerLine() + (x >> 5)];
+  const bool black = (word >> (31 - (x & 31))) & 1;
+  if (!black || (tx < 0) || (tx > (image.width() - 1)) || (ty < 0) || (ty > (image.height() - 1))) {
     return true;
   }
   x = tx;
   y = ty;
   return false;
 }
-}  // namespace page_box
\ No newline at end of file
+}  // namespace page_box
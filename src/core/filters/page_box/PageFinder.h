@@ -4,16 +4,11 @@
 #ifndef SCANTAILOR_PAGE_BOX_PAGEFINDER_H_
 #define SCANTAILOR_PAGE_BOX_PAGEFINDER_H_
 
-#include <BinaryThreshold.h>
-
-#include <Qt>
-
-#include "Margins.h"
+#include <vector>
 
 class TaskStatus;
 class DebugImages;
 class FilterData;
-class QImage;
 class QRect;
 class QRectF;
 class QSizeF;
@@ -21,9 +16,20 @@ class QSize;
 
 namespace imageproc {
 class BinaryImage;
+class GrayImage;
 }
 
 namespace page_box {
+/**
+ * \brief Finds the physical page inside a scan with dark scanner borders.
+ *
+ * The page image is binarized at 150 dpi: once with Sauvola's method, or,
+ * if the page size is known, with five methods, taking the edges that best
+ * match the expected size.  The two local thresholds share one pair of
+ * integral images, see binarize().  The border detection works on
+ * black pixel counts of every row and column, collected directly from the
+ * words of the binary image, and the corner refinement on its bits.
+ */
 class PageFinder {
  public:
   static QRectF findPageBox(const TaskStatus& status,
@@ -33,14 +39,42 @@ class PageFinder {
                             double tolerance,
                             DebugImages* dbg = nullptr);
 
+  /**
+   * \brief Finds the page borders on an already binarized image.
+   *
+   * \param image The binarized page, normally at 150 dpi.
+   * \param fineTune Whether to shrink the box while its corners are black.
+   * \param expectedSize The expected page size in pixels, or an empty
+   *        size if unknown.  Corner refinement stops when the box becomes
+   *        smaller than allowed by \p tolerance.
+   * \param tolerance Relative tolerance for \p expectedSize.
+   * \return The page box in \p image coordinates.
+   */
+  static QRect findPageBorders(const imageproc::BinaryImage& image,
+                               bool fineTune,
+                               const QSize& expectedSize,
+                               double tolerance);
+
+  /**
+   * \brief Makes the binarizations the page borders are looked for on.
+   *
+   * \param gray The page, normally at 150 dpi.
+   * \param allMethods If false, only the Sauvola binarization is made.
+   *        Otherwise, these are, in order: peakThreshold(), binarizeOtsu(),
+   *        binarizeMokji(), binarizeSauvola() and binarizeWolf(), the last two
+   *        with windows of the image size.
+   * \return The binarizations, identical to the ones the above functions produce.
+   */
+  static std::vector<imageproc::BinaryImage> binarize(const imageproc::GrayImage& gray, bool allMethods);
+
  private:
-  static QRect detectBorders(const QImage& img);
+  class Profiles;
 
-  static int detectEdge(const QImage& img, int start, int end, int inc, int mid, Qt::Orientation orient);
+  static int detectEdge(const std::vector<int>& blackCounts, int start, int end, int inc, int minBlack);
 
-  static void fineTuneCorners(const QImage& img, QRect& rect, const QSize& size, double tolerance);
+  static void fineTuneCorners(const imageproc::BinaryImage& image, QRect& rect, const QSize& size, double tolerance);
 
-  static bool fineTuneCorner(const QImage& img,
+  static bool fineTuneCorner(const imageproc::BinaryImage& image,
                              int& x,
                              int& y,
                              int maxX,
@@ -52,15 +52,15 @@ Task::Task(std::shared_ptr<Filter> filter,
            std::shared_ptr<Settings> settings,
            const PageId& pageId,
            const bool batch,
-           const bool debug)
+           const bool debug,
+           const bool speculative)
     : m_filter(std::move(filter)),
       m_nextTask(std::move(nextTask)),
       m_settings(std::move(settings)),
       m_pageId(pageId),
-      m_batchProcessing(batch) {
-  if (debug) {
-    m_dbg = std::make_unique<DebugImagesImpl>();
-  }
+      m_batchProcessing(batch),
+      m_speculative(speculative) {
+  m_dbg = DebugImagesImpl::create(debug, "page_box", m_pageId);
 }
 
 Task::~Task() = default;
@@ -79,6 +79,13 @@ FilterResultPtr Task::process(const TaskStatus& status, const FilterData& data)
     newParams.setDependencies(deps);
   }
 
+  if (m_speculative) {
+    if (!params || !deps.compatibleWith(params->dependencies()) || params->pageRect().isNull() || !m_nextTask) {
+      return nullptr;
+    }
+    return m_nextTask->process(status, data);
+  }
+
   bool needUpdate = false;
   if (!params || !deps.compatibleWith(params->dependencies(), &needUpdate)) {
     QRectF pageRect(newParams.pageRect());
@@ -32,10 +32,15 @@ class Task {
        std::shared_ptr<Settings> settings,
        const PageId& pageId,
        bool batch,
-       bool debug);
+       bool debug,
+       bool speculative);
 
   virtual ~Task();
 
+  /**
+   * In the speculative mode, the page box is neither detected nor stored.  Unless the
+   * stored one still applies, nothing is returned and the chain stops here.
+   */
   FilterResultPtr process(const TaskStatus& status, const FilterData& data);
 
  private:
@@ -47,6 +52,7 @@ class Task {
   std::unique_ptr<DebugImages> m_dbg;
   PageId m_pageId;
   bool m_batchProcessing;
+  bool m_speculative;
 };
 }  // namespace page_box
 #endif
@@ -14,6 +14,7 @@
 #include <QPainterPath>
 #include <boost/bind/bind.hpp>
 #include <boost/lambda/lambda.hpp>
+#include <utility>
 
 #include "ImagePresentation.h"
 #include "OptionsWidget.h"
@@ -166,11 +167,11 @@ ImageView::ImageView(const std::shared_ptr<Settings>& settings,
 ImageView::~ImageView() = default;
 
 void ImageView::marginsSetExternally(const Margins& marginsMm) {
-  const AggregateSizeChanged changed = commitHardMargins(marginsMm);
+  std::set<PageId> affectedPages(commitHardMargins(marginsMm));
 
   recalcBoxesAndFit(marginsMm);
 
-  invalidateThumbnails(changed);
+  invalidateAffectedThumbnails(std::move(affectedPages));
 }
 
 void ImageView::leftRightLinkToggled(const bool linked) {
@@ -182,12 +183,12 @@ void ImageView::leftRightLinkToggled(const bool linked) {
       marginsMm.setLeft(newMargin);
       marginsMm.setRight(newMargin);
 
-      const AggregateSizeChanged changed = commitHardMargins(marginsMm);
+      std::set<PageId> affectedPages(commitHardMargins(marginsMm));
 
       recalcBoxesAndFit(marginsMm);
       emit marginsSetLocally(marginsMm);
 
-      invalidateThumbnails(changed);
+      invalidateAffectedThumbnails(std::move(affectedPages));
     }
   }
 }
@@ -201,12 +202,12 @@ void ImageView::topBottomLinkToggled(const bool linked) {
       marginsMm.setTop(newMargin);
       marginsMm.setBottom(newMargin);
 
-      const AggregateSizeChanged changed = commitHardMargins(marginsMm);
+      std::set<PageId> affectedPages(commitHardMargins(marginsMm));
 
       recalcBoxesAndFit(marginsMm);
       emit marginsSetLocally(marginsMm);
 
-      invalidateThumbnails(changed);
+      invalidateAffectedThumbnails(std::move(affectedPages));
     }
   }
 }
@@ -214,7 +215,9 @@ void ImageView::topBottomLinkToggled(const bool linked) {
 void ImageView::alignmentChanged(const Alignment& alignment) {
   m_alignment = alignment;
 
-  const Settings::AggregateSizeChanged sizeChanged = m_settings->setPageAlignment(m_pageId, alignment);
+  const QSizeF aggSizeBefore(m_settings->getAggregateHardSizeMM());
+  m_settings->setPageAlignment(m_pageId, alignment);
+  const QSizeF aggSizeAfter(m_settings->getAggregateHardSizeMM());
 
   recalcBoxesAndFit(calcHardMarginsMM());
 
@@ -223,11 +226,7 @@ void ImageView::alignmentChanged(const Alignment& alignment) {
 
   enableMiddleRectInteraction(isShowingMiddleRectEnabled());
 
-  if (sizeChanged == Settings::AGGREGATE_SIZE_CHANGED) {
-    emit invalidateAllThumbnails();
-  } else {
-    emit invalidateThumbnail(m_pageId);
-  }
+  invalidateAffectedThumbnails(m_settings->getPagesAffectedByAggregateSizeChange(aggSizeBefore, aggSizeAfter));
 }
 
 void ImageView::aggregateHardSizeChanged() {
@@ -492,7 +491,7 @@ void ImageView::middleRectDragContinuation(const int edgeMask, const QPointF& mo
 }  // ImageView::middleRectDragContinuation
 
 void ImageView::dragFinished() {
-  const AggregateSizeChanged aggSizeChanged(commitHardMargins(calcHardMarginsMM()));
+  std::set<PageId> affectedPages(commitHardMargins(calcHardMarginsMM()));
 
   const QRectF extendedViewport(maxViewportRect().adjusted(-0.5, -0.5, 0.5, 0.5));
   if (extendedViewport.contains(m_beforeResizing.middleWidgetRect)) {
@@ -501,7 +500,7 @@ void ImageView::dragFinished() {
     updatePresentationTransform(DONT_FIT);
   }
 
-  invalidateThumbnails(aggSizeChanged);
+  invalidateAffectedThumbnails(std::move(affectedPages));
 }
 
 /**
@@ -643,25 +642,20 @@ QSizeF ImageView::origRectToSizeMM(const QRectF& rect) const {
   return sizeMm;
 }
 
-ImageView::AggregateSizeChanged ImageView::commitHardMargins(const Margins& marginsMm) {
+std::set<PageId> ImageView::commitHardMargins(const Margins& marginsMm) {
   m_settings->setHardMarginsMM(m_pageId, marginsMm);
   m_aggregateHardSizeMM = m_settings->getAggregateHardSizeMM();
 
-  AggregateSizeChanged changed = AGGREGATE_SIZE_UNCHANGED;
-  if (m_committedAggregateHardSizeMM != m_aggregateHardSizeMM) {
-    changed = AGGREGATE_SIZE_CHANGED;
-  }
+  std::set<PageId> affectedPages(
+      m_settings->getPagesAffectedByAggregateSizeChange(m_committedAggregateHardSizeMM, m_aggregateHardSizeMM));
 
   m_committedAggregateHardSizeMM = m_aggregateHardSizeMM;
-  return changed;
+  return affectedPages;
 }
 
-void ImageView::invalidateThumbnails(const AggregateSizeChanged aggSizeChanged) {
-  if (aggSizeChanged == AGGREGATE_SIZE_CHANGED) {
-    emit invalidateAllThumbnails();
-  } else {
-    emit invalidateThumbnail(m_pageId);
-  }
+void ImageView::invalidateAffectedThumbnails(std::set<PageId> affectedPages) {
+  affectedPages.insert(m_pageId);
+  emit invalidateThumbnails(affectedPages);
 }
 
 void ImageView::updatePhysSize() {
@@ -14,6 +14,7 @@
 #include <QSizeF>
 #include <QTransform>
 #include <memory>
+#include <set>
 #include <unordered_map>
 
 #include "Alignment.h"
@@ -51,6 +52,8 @@ class ImageView : public ImageViewBase, private InteractionHandler {
 
   void invalidateThumbnail(const PageId& pageId);
 
+  void invalidateThumbnails(const std::set<PageId>& pages);
+
   void invalidateAllThumbnails();
 
   void marginsSetLocally(const Margins& marginsMm);
@@ -75,8 +78,6 @@ class ImageView : public ImageViewBase, private InteractionHandler {
 
   enum FitMode { FIT, DONT_FIT };
 
-  enum AggregateSizeChanged { AGGREGATE_SIZE_UNCHANGED, AGGREGATE_SIZE_CHANGED };
-
   struct StateBeforeResizing {
     /**
      * Transformation from virtual image coordinates to widget coordinates.
@@ -135,9 +136,18 @@ class ImageView : public ImageViewBase, private InteractionHandler {
 
   QSizeF origRectToSizeMM(const QRectF& rect) const;
 
-  AggregateSizeChanged commitHardMargins(const Margins& marginsMm);
+  /**
+   * \brief Stores the hard margins of this page.
+   *
+   * \return Other pages whose soft margins were changed by the
+   *         resulting change of the aggregate size.
+   */
+  std::set<PageId> commitHardMargins(const Margins& marginsMm);
 
-  void invalidateThumbnails(AggregateSizeChanged aggSizeChanged);
+  /**
+   * \brief Invalidates the thumbnails of this page and \p affectedPages at once.
+   */
+  void invalidateAffectedThumbnails(std::set<PageId> affectedPages);
 
   void setupContextMenuInteraction();
 
@@ -404,15 +404,13 @@ void OptionsWidget::applyAlignment(const std::set<PageId>& pages) {
     return;
   }
 
-  for (const PageId& pageId : pages) {
-    if (pageId == m_pageId) {
-      continue;
-    }
+  std::set<PageId> otherPages(pages);
+  otherPages.erase(m_pageId);
 
-    m_settings->setPageAlignment(pageId, m_alignment);
-  }
+  const QSizeF aggSizeBefore(m_settings->getAggregateHardSizeMM());
+  m_settings->setPageAlignment(otherPages, m_alignment);
 
-  emit invalidateAllThumbnails();
+  invalidateChangedThumbnails(pages, aggSizeBefore);
 }
 
 void OptionsWidget::updateMarginsDisplay() {
@@ -625,19 +623,24 @@ void OptionsWidget::applyAlignmentToSelectedPages() {
 
   // Only apply to multiple pages if current page is in selection and there are multiple selected
   if (selectedPages.size() > 1 && selectedPages.find(m_pageId) != selectedPages.end()) {
-    for (const PageId& pageId : selectedPages) {
-      if (pageId == m_pageId) {
-        continue;
-      }
+    std::set<PageId> otherPages(selectedPages);
+    otherPages.erase(m_pageId);
 
-      m_settings->setPageAlignment(pageId, m_alignment);
-    }
-    emit invalidateAllThumbnails();
-    // Also explicitly invalidate current page to ensure it gets proper thumbnail treatment
-    emit invalidateThumbnail(m_pageId);
+    const QSizeF aggSizeBefore(m_settings->getAggregateHardSizeMM());
+    m_settings->setPageAlignment(otherPages, m_alignment);
+    // The current page is among the selected ones, so it gets invalidated as well.
+    invalidateChangedThumbnails(selectedPages, aggSizeBefore);
   }
 }
 
+void OptionsWidget::invalidateChangedThumbnails(const std::set<PageId>& changedPages, const QSizeF& aggSizeBeforeMm) {
+  std::set<PageId> pages(
+      m_settings->getPagesAffectedByAggregateSizeChange(aggSizeBeforeMm, m_settings->getAggregateHardSizeMM()));
+  pages.insert(changedPages.begin(), changedPages.end());
+
+  emit invalidateThumbnails(pages);
+}
+
 void OptionsWidget::applyFullBleedToSelectedPages() {
   const std::set<PageId> selectedPages = m_pageSelectionAccessor.selectedPages();
 
@@ -8,6 +8,7 @@
 #include <core/ConnectionManager.h>
 
 #include <QIcon>
+#include <QSizeF>
 #include <list>
 #include <memory>
 #include <set>
@@ -121,6 +122,12 @@ class OptionsWidget : public FilterOptionsWidget, public UnitsListener, private
 
   void applyAlignmentToSelectedPages();
 
+  /**
+   * \brief Invalidates the changed pages and the pages whose soft margins
+   *        were changed by the resulting change of the aggregate size.
+   */
+  void invalidateChangedThumbnails(const std::set<PageId>& changedPages, const QSizeF& aggSizeBeforeMm);
+
   void applyFullBleedToSelectedPages();
 
   void updateSelectionIndicator();
@@ -10,33 +10,18 @@
 namespace page_layout {
 OrderByWidthProvider::OrderByWidthProvider(std::shared_ptr<Settings> settings) : m_settings(std::move(settings)) {}
 
-bool OrderByWidthProvider::precedes(const PageId& lhsPage,
-                                    const bool lhsIncomplete,
-                                    const PageId& rhsPage,
-                                    const bool rhsIncomplete) const {
-  const std::unique_ptr<Params> lhsParams(m_settings->getPageParams(lhsPage));
-  const std::unique_ptr<Params> rhsParams(m_settings->getPageParams(rhsPage));
-
-  QSizeF lhsSize;
-  if (lhsParams) {
-    const Margins margins(lhsParams->hardMarginsMM());
-    lhsSize = lhsParams->contentSizeMM();
-    lhsSize += QSizeF(margins.left() + margins.right(), margins.top() + margins.bottom());
-  }
-  QSizeF rhsSize;
-  if (rhsParams) {
-    const Margins margins(rhsParams->hardMarginsMM());
-    rhsSize = rhsParams->contentSizeMM();
-    rhsSize += QSizeF(margins.left() + margins.right(), margins.top() + margins.bottom());
+PageOrderKey OrderByWidthProvider::sortKey(const PageId& page, const bool incomplete) const {
+  const std::unique_ptr<Params> params(m_settings->getPageParams(page));
+
+  QSizeF size;
+  if (params) {
+    const Margins margins(params->hardMarginsMM());
+    size = params->contentSizeMM();
+    size += QSizeF(margins.left() + margins.right(), margins.top() + margins.bottom());
   }
 
-  const bool lhsValid = !lhsIncomplete && lhsSize.isValid();
-  const bool rhsValid = !rhsIncomplete && rhsSize.isValid();
-
-  if (lhsValid != rhsValid) {
-    // Invalid (unknown) sizes go to the back.
-    return lhsValid;
-  }
-  return lhsSize.width() < rhsSize.width();
-}  // OrderByWidthProvider::precedes
+  // Invalid (unknown) sizes go to the back.
+  const bool valid = !incomplete && size.isValid();
+  return PageOrderKey(valid ? 0 : 1, size.width());
+}
 }  // namespace page_layout
\ No newline at end of file
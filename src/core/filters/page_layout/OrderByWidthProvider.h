@@ -14,7 +14,7 @@ class OrderByWidthProvider : public PageOrderProvider {
  public:
   explicit OrderByWidthProvider(std::shared_ptr<Settings> settings);
 
-  bool precedes(const PageId& lhsPage, bool lhsIncomplete, const PageId& rhsPage, bool rhsIncomplete) const override;
+  PageOrderKey sortKey(const PageId& page, bool incomplete) const override;
 
  private:
   std::shared_ptr<Settings> m_settings;
@@ -24,6 +24,7 @@
 #include "PageSequence.h"
 #include "Params.h"
 #include "RelinkablePath.h"
+#include "Utils.h"
 
 
 using namespace ::boost;
@@ -153,6 +154,8 @@ class Settings::Impl {
 
   AggregateSizeChanged setPageAlignment(const PageId& pageId, const Alignment& alignment);
 
+  AggregateSizeChanged setPageAlignment(const std::set<PageId>& pageIds, const Alignment& alignment);
+
   void disableAlignmentForPages(const std::vector<PageId>& pageIds);
 
   AggregateSizeChanged setContentSizeMM(const PageId& pageId, const QSizeF& contentSizeMm);
@@ -165,6 +168,9 @@ class Settings::Impl {
 
   QSizeF getAggregateHardSizeMM(const PageId& pageId, const QSizeF& hardSizeMm, const Alignment& alignment) const;
 
+  std::set<PageId> getPagesAffectedByAggregateSizeChange(const QSizeF& aggHardSizeBeforeMm,
+                                                         const QSizeF& aggHardSizeAfterMm) const;
+
   std::vector<Settings::PageSizeInfo> getPagesWithExcessiveSoftMargins(double threshold) const;
 
   std::vector<Settings::OutlierPageInfo> getOutlierPages(double deviationThreshold) const;
@@ -285,6 +291,11 @@ Settings::AggregateSizeChanged Settings::setPageAlignment(const PageId& pageId,
   return m_impl->setPageAlignment(pageId, alignment);
 }
 
+Settings::AggregateSizeChanged Settings::setPageAlignment(const std::set<PageId>& pageIds,
+                                                          const Alignment& alignment) {
+  return m_impl->setPageAlignment(pageIds, alignment);
+}
+
 void Settings::disableAlignmentForPages(const std::vector<PageId>& pageIds) {
   m_impl->disableAlignmentForPages(pageIds);
 }
@@ -307,6 +318,11 @@ QSizeF Settings::getAggregateHardSizeMM(const PageId& pageId,
   return m_impl->getAggregateHardSizeMM(pageId, hardSizeMm, alignment);
 }
 
+std::set<PageId> Settings::getPagesAffectedByAggregateSizeChange(const QSizeF& aggHardSizeBeforeMm,
+                                                                 const QSizeF& aggHardSizeAfterMm) const {
+  return m_impl->getPagesAffectedByAggregateSizeChange(aggHardSizeBeforeMm, aggHardSizeAfterMm);
+}
+
 std::vector<Settings::PageSizeInfo> Settings::getPagesWithExcessiveSoftMargins(double threshold) const {
   return m_impl->getPagesWithExcessiveSoftMargins(threshold);
 }
@@ -599,6 +615,32 @@ Settings::AggregateSizeChanged Settings::Impl::setPageAlignment(const PageId& pa
   }
 }
 
+Settings::AggregateSizeChanged Settings::Impl::setPageAlignment(const std::set<PageId>& pageIds,
+                                                                const Alignment& alignment) {
+  const QMutexLocker locker(&m_mutex);
+
+  const QSizeF aggSizeBefore(getAggregateHardSizeMMLocked());
+
+  for (const PageId& pageId : pageIds) {
+    const Container::iterator it(m_items.find(pageId));
+    if (it == m_items.end()) {
+      const Item item(pageId, m_defaultHardMarginsMM, m_invalidRect, m_invalidRect, m_invalidSize, alignment,
+                      m_autoMarginsDefault, false);
+      m_items.insert(it, item);
+    } else {
+      m_items.modify(it, ModifyAlignment(alignment));
+    }
+    m_deviationProvider.addOrUpdate(pageId);
+  }
+
+  const QSizeF aggSizeAfter(getAggregateHardSizeMMLocked());
+  if (aggSizeBefore == aggSizeAfter) {
+    return AGGREGATE_SIZE_UNCHANGED;
+  } else {
+    return AGGREGATE_SIZE_CHANGED;
+  }
+}
+
 void Settings::Impl::disableAlignmentForPages(const std::vector<PageId>& pageIds) {
   const QMutexLocker locker(&m_mutex);
 
@@ -719,6 +761,37 @@ QSizeF Settings::Impl::getAggregateHardSizeMM(const PageId& pageId,
   return QSizeF(width, height);
 }  // Settings::Impl::getAggregateHardSizeMM
 
+std::set<PageId> Settings::Impl::getPagesAffectedByAggregateSizeChange(const QSizeF& aggHardSizeBeforeMm,
+                                                                       const QSizeF& aggHardSizeAfterMm) const {
+  std::set<PageId> pages;
+  if (aggHardSizeBeforeMm == aggHardSizeAfterMm) {
+    return pages;
+  }
+
+  const QMutexLocker locker(&m_mutex);
+
+  for (const Item& item : m_unorderedItems) {
+    if (!item.alignedWithOthers()) {
+      continue;
+    }
+    if (!item.contentSizeMM.isValid()) {
+      pages.insert(item.pageId);
+      continue;
+    }
+
+    const QSizeF hardSizeMm(item.hardWidthMM(), item.hardHeightMM());
+    const Margins before(Utils::calcSoftMarginsMM(hardSizeMm, aggHardSizeBeforeMm, item.alignment, item.contentRect,
+                                                  item.contentSizeMM, item.pageRect));
+    const Margins after(Utils::calcSoftMarginsMM(hardSizeMm, aggHardSizeAfterMm, item.alignment, item.contentRect,
+                                                 item.contentSizeMM, item.pageRect));
+    if ((before.left() != after.left()) || (before.top() != after.top()) || (before.right() != after.right())
+        || (before.bottom() != after.bottom())) {
+      pages.insert(item.pageId);
+    }
+  }
+  return pages;
+}  // Settings::Impl::getPagesAffectedByAggregateSizeChange
+
 bool Settings::Impl::isPageAutoMarginsEnabled(const PageId& pageId) {
   const QMutexLocker locker(&m_mutex);
 
@@ -7,6 +7,7 @@
 #include <DeviationProvider.h>
 
 #include <memory>
+#include <set>
 #include <vector>
 
 #include "Margins.h"
@@ -149,6 +150,13 @@ class Settings {
    */
   AggregateSizeChanged setPageAlignment(const PageId& pageId, const Alignment& alignment);
 
+  /**
+   * \brief Sets the same alignment for many pages under a single lock.
+   *
+   * The aggregate size is compared once, before and after all the pages are updated.
+   */
+  AggregateSizeChanged setPageAlignment(const std::set<PageId>& pageIds, const Alignment& alignment);
+
   /**
    * \brief Disables alignment for multiple pages.
    *
@@ -182,6 +190,18 @@ class Settings {
    */
   QSizeF getAggregateHardSizeMM(const PageId& pageId, const QSizeF& hardSizeMm, const Alignment& alignment) const;
 
+  /**
+   * \brief Returns pages whose layout differs between two aggregate sizes.
+   *
+   * The aggregate size only affects a page through its soft margins.
+   * Soft margins are calculated for every page with both sizes, and pages
+   * where they differ are returned.  Pages not aligned with others are
+   * never returned, while pages without a known content size always are.
+   * Use it to invalidate only the pages affected by an aggregate size change.
+   */
+  std::set<PageId> getPagesAffectedByAggregateSizeChange(const QSizeF& aggHardSizeBeforeMm,
+                                                         const QSizeF& aggHardSizeAfterMm) const;
+
   /**
    * \brief Returns pages where soft margins would exceed the given threshold.
    *
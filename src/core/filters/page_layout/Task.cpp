@@ -3,6 +3,7 @@
 
 #include "Task.h"
 
+#include <set>
 #include <utility>
 
 #include "Dpm.h"
@@ -29,7 +30,7 @@ class Task::UiUpdater : public FilterResult {
             const ImageTransformation& xform,
             const ContentMask& contentMask,
             const QRectF& adaptedContentRect,
-            bool aggSizeChanged,
+            std::set<PageId> affectedPages,
             bool batch);
 
   void updateUI(FilterUiInterface* ui) override;
@@ -45,7 +46,7 @@ class Task::UiUpdater : public FilterResult {
   ContentMask m_contentMask;
   ImageTransformation m_xform;
   QRectF m_adaptedContentRect;
-  bool m_aggSizeChanged;
+  std::set<PageId> m_affectedPages;
   bool m_batchProcessing;
 };
 
@@ -94,9 +95,12 @@ FilterResultPtr Task::process(const TaskStatus& status,
     newXform.setPostCropArea(Utils::shiftToRoundedOrigin(newXform.transform().map(pageRectPhys)));
     return m_nextTask->process(status, FilterData(data, newXform), contentRectPhys);
   } else {
+    // Other pages only need to be refreshed if the aggregate size change moved their borders.
+    std::set<PageId> affectedPages(
+        m_settings->getPagesAffectedByAggregateSizeChange(aggHardSizeBefore, aggHardSizeAfter));
     return std::make_shared<UiUpdater>(m_filter, m_settings, m_pageId, data.origImage(), data.xform(),
                                        ContentMask(data.grayImageBlackOnWhite(), data.xform(), status),
-                                       adaptedContentRect, aggHardSizeBefore != aggHardSizeAfter, m_batchProcessing);
+                                       adaptedContentRect, std::move(affectedPages), m_batchProcessing);
   }
 }
 
@@ -109,7 +113,7 @@ Task::UiUpdater::UiUpdater(std::shared_ptr<Filter> filter,
                            const ImageTransformation& xform,
                            const ContentMask& contentMask,
                            const QRectF& adaptedContentRect,
-                           const bool aggSizeChanged,
+                           std::set<PageId> affectedPages,
                            const bool batch)
     : m_filter(std::move(filter)),
       m_settings(std::move(settings)),
@@ -119,16 +123,13 @@ Task::UiUpdater::UiUpdater(std::shared_ptr<Filter> filter,
       m_contentMask(contentMask),
       m_xform(xform),
       m_adaptedContentRect(adaptedContentRect),
-      m_aggSizeChanged(aggSizeChanged),
+      m_affectedPages(std::move(affectedPages)),
       m_batchProcessing(batch) {}
 
 void Task::UiUpdater::updateUI(FilterUiInterface* ui) {
   // This function is executed from the GUI thread.
-  if (m_aggSizeChanged) {
-    ui->invalidateAllThumbnails();
-  } else {
-    ui->invalidateThumbnail(m_pageId);
-  }
+  m_affectedPages.insert(m_pageId);
+  ui->invalidateThumbnails(m_affectedPages);
 
   if (m_batchProcessing) {
     return;
@@ -144,6 +145,8 @@ void Task::UiUpdater::updateUI(FilterUiInterface* ui) {
 
   QObject::connect(view, SIGNAL(invalidateThumbnail(const PageId&)), optWidget,
                    SIGNAL(invalidateThumbnail(const PageId&)));
+  QObject::connect(view, SIGNAL(invalidateThumbnails(const std::set<PageId>&)), optWidget,
+                   SIGNAL(invalidateThumbnails(const std::set<PageId>&)));
   QObject::connect(view, SIGNAL(invalidateAllThumbnails()), optWidget, SIGNAL(invalidateAllThumbnails()));
   QObject::connect(view, SIGNAL(marginsSetLocally(const Margins&)), optWidget,
                    SLOT(marginsSetExternally(const Margins&)));
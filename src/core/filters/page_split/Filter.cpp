@@ -144,7 +144,13 @@ std::shared_ptr<Task> Filter::createTask(const PageInfo& pageInfo,
                                          const bool batchProcessing,
                                          const bool debug) {
   return std::make_shared<Task>(std::static_pointer_cast<Filter>(shared_from_this()), m_settings, m_pages,
-                                std::move(nextTask), pageInfo, batchProcessing, debug);
+                                std::move(nextTask), pageInfo, batchProcessing, debug, /*speculative=*/false);
+}
+
+std::shared_ptr<Task> Filter::createSpeculativeTask(const PageInfo& pageInfo, std::shared_ptr<deskew::Task> nextTask) {
+  return std::make_shared<Task>(std::static_pointer_cast<Filter>(shared_from_this()), m_settings, m_pages,
+                                std::move(nextTask), pageInfo, /*batchProcessing=*/true, /*debug=*/false,
+                                /*speculative=*/true);
 }
 
 std::shared_ptr<CacheDrivenTask> Filter::createCacheDrivenTask(std::shared_ptr<deskew::CacheDrivenTask> nextTask) {
@@ -62,6 +62,14 @@ class Filter : public AbstractFilter {
                                    bool batchProcessing,
                                    bool debug);
 
+  /**
+   * \brief Creates a task that only replays the stored parameters, so that a speculative
+   *        task further down the chain gets the page as the user would see it.
+   *
+   * See Task::process().
+   */
+  std::shared_ptr<Task> createSpeculativeTask(const PageInfo& pageInfo, std::shared_ptr<deskew::Task> nextTask);
+
   std::shared_ptr<CacheDrivenTask> createCacheDrivenTask(std::shared_ptr<deskew::CacheDrivenTask> nextTask);
 
   OptionsWidget* optionsWidget();
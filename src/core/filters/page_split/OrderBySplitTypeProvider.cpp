@@ -3,55 +3,28 @@
 
 #include "OrderBySplitTypeProvider.h"
 
-#include <cassert>
 #include <utility>
 
 namespace page_split {
 OrderBySplitTypeProvider::OrderBySplitTypeProvider(std::shared_ptr<Settings> settings)
     : m_settings(std::move(settings)) {}
 
-bool OrderBySplitTypeProvider::precedes(const PageId& lhsPage,
-                                        const bool lhsIncomplete,
-                                        const PageId& rhsPage,
-                                        const bool rhsIncomplete) const {
-  if (lhsIncomplete != rhsIncomplete) {
-    // Pages with question mark go to the bottom.
-    return rhsIncomplete;
-  } else if (lhsIncomplete) {
-    assert(rhsIncomplete);
-    // Two pages with question marks are ordered naturally.
-    return lhsPage < rhsPage;
+PageOrderKey OrderBySplitTypeProvider::sortKey(const PageId& page, const bool incomplete) const {
+  if (incomplete) {
+    // Pages with question mark go to the bottom and are ordered naturally.
+    return PageOrderKey::withPageIdTieBreak(1, 0.0, page);
   }
 
-  assert(!lhsIncomplete);
-  assert(!rhsIncomplete);
+  const Settings::Record record(m_settings->getPageRecord(page.imageId()));
+  const Params* params = record.params();
 
-  const Settings::Record lhsRecord(m_settings->getPageRecord(lhsPage.imageId()));
-  const Settings::Record rhsRecord(m_settings->getPageRecord(rhsPage.imageId()));
-
-  const Params* lhsParams = lhsRecord.params();
-  const Params* rhsParams = rhsRecord.params();
-
-  int lhsLayoutType = lhsRecord.combinedLayoutType();
-  if (lhsParams) {
-    lhsLayoutType = lhsParams->pageLayout().toLayoutType();
+  int layoutType = record.combinedLayoutType();
+  if (params) {
+    layoutType = params->pageLayout().toLayoutType();
   }
-  if (lhsLayoutType == AUTO_LAYOUT_TYPE) {
-    lhsLayoutType = 100;  // To force it below pages with known layout.
-  }
-
-  int rhsLayoutType = rhsRecord.combinedLayoutType();
-  if (rhsParams) {
-    rhsLayoutType = rhsParams->pageLayout().toLayoutType();
-  }
-  if (rhsLayoutType == AUTO_LAYOUT_TYPE) {
-    rhsLayoutType = 100;  // To force it below pages with known layout.
-  }
-
-  if (lhsLayoutType == rhsLayoutType) {
-    return lhsPage < rhsPage;
-  } else {
-    return lhsLayoutType < rhsLayoutType;
+  if (layoutType == AUTO_LAYOUT_TYPE) {
+    layoutType = 100;  // To force it below pages with known layout.
   }
-}  // OrderBySplitTypeProvider::precedes
+  return PageOrderKey::withPageIdTieBreak(0, layoutType, page);
+}
 }  // namespace page_split
\ No newline at end of file
@@ -31,10 +31,12 @@
 #include <boost/lambda/lambda.hpp>
 
 #include "AppleVisionDetector.h"
+#include "BorderShadows.h"
 #include "ContentSpanFinder.h"
 #include "DebugImages.h"
 #include "ImageMetadata.h"
 #include "ImageTransformation.h"
+#include "NullTaskStatus.h"
 #include "OrthogonalRotation.h"
 #include "PageLayout.h"
 #include "ProjectPages.h"
@@ -668,24 +670,7 @@ BinaryImage PageLayoutEstimator::removeGarbageAnd2xDownscale(const BinaryImage&
     dbg->add(reduced, "garbage_removed");
   }
 
-  BinaryImage horSeed(openBrick(reduced, QSize(200, 14), BLACK));
-  BinaryImage verSeed(openBrick(reduced, QSize(14, 300), BLACK));
-
-  rasterOp<RopOr<RopSrc, RopDst>>(horSeed, verSeed);
-  BinaryImage seed(horSeed.release());
-  verSeed.release();
-  if (dbg) {
-    dbg->add(seed, "shadows_seed");
-  }
-
-  BinaryImage dilated(dilateBrick(reduced, QSize(3, 3)));
-
-  BinaryImage shadowsDilated(seedFill(seed, dilated, CONN8));
-  dilated.release();
-  if (dbg) {
-    dbg->add(shadowsDilated, "shadowsDilated");
-  }
-
+  const BinaryImage shadowsDilated(findBorderShadows(reduced, NullTaskStatus(), dbg));
   rasterOp<RopSubtract<RopDst, RopSrc>>(reduced, shadowsDilated);
   return reduced;
 }  // PageLayoutEstimator::removeGarbageAnd2xDownscale
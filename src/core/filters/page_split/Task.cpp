@@ -74,16 +74,16 @@ Task::Task(std::shared_ptr<Filter> filter,
            std::shared_ptr<deskew::Task> nextTask,
            const PageInfo& pageInfo,
            const bool batchProcessing,
-           const bool debug)
+           const bool debug,
+           const bool speculative)
     : m_filter(std::move(filter)),
       m_settings(std::move(settings)),
       m_pages(std::move(pages)),
       m_nextTask(std::move(nextTask)),
       m_pageInfo(pageInfo),
-      m_batchProcessing(batchProcessing) {
-  if (debug) {
-    m_dbg = std::make_unique<DebugImagesImpl>();
-  }
+      m_batchProcessing(batchProcessing),
+      m_speculative(speculative) {
+  m_dbg = DebugImagesImpl::create(debug, "page_split", m_pageInfo.id());
 }
 
 Task::~Task() = default;
@@ -114,6 +114,18 @@ FilterResultPtr Task::process(const TaskStatus& status, const FilterData& data)
         && record.combinedLayoutType() == AUTO_LAYOUT_TYPE
         && params->pageLayout().type() == PageLayout::SINGLE_PAGE_UNCUT;
 
+    if (m_speculative) {
+      if (!params || !deps.compatibleWith(*params) || staleAutoSingleUncut) {
+        return nullptr;
+      }
+      PageLayout correctedPageLayout = params->pageLayout();
+      PageLayoutAdapter::correctPageLayoutType(&correctedPageLayout);
+      if (correctedPageLayout.type() != params->pageLayout().type()) {
+        return nullptr;
+      }
+      break;
+    }
+
     if (!params || !deps.compatibleWith(*params) || staleAutoSingleUncut) {
       qDebug() << "PageSplit Task: recomputing"
                << "pdfPage=" << m_pageInfo.imageId().page()
@@ -201,7 +213,9 @@ FilterResultPtr Task::process(const TaskStatus& status, const FilterData& data)
   uiData.setPageLayout(layout);
   uiData.setSplitLineMode(record.params()->splitLineMode());
 
-  m_pages->setLayoutTypeFor(m_pageInfo.imageId(), toPageLayoutType(layout));
+  if (!m_speculative) {
+    m_pages->setLayoutTypeFor(m_pageInfo.imageId(), toPageLayoutType(layout));
+  }
 
   if (m_nextTask != nullptr) {
     ImageTransformation newXform(data.xform());
@@ -36,10 +36,15 @@ class Task {
        std::shared_ptr<deskew::Task> nextTask,
        const PageInfo& pageInfo,
        bool batchProcessing,
-       bool debug);
+       bool debug,
+       bool speculative);
 
   virtual ~Task();
 
+  /**
+   * In the speculative mode, the layout is neither detected nor stored.  If the stored
+   * one doesn't apply, nothing is returned and the chain stops here.
+   */
   FilterResultPtr process(const TaskStatus& status, const FilterData& data);
 
  private:
@@ -52,6 +57,7 @@ class Task {
   std::unique_ptr<DebugImages> m_dbg;
   PageInfo m_pageInfo;
   bool m_batchProcessing;
+  bool m_speculative;
 };
 }  // namespace page_split
 #endif  // ifndef SCANTAILOR_PAGE_SPLIT_TASK_H_
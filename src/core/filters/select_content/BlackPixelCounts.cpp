@@ -0,0 +1,48 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include "BlackPixelCounts.h"
+
+#include <BinaryImage.h>
+
+using namespace imageproc;
+
+namespace select_content {
+BlackPixelCounts::BlackPixelCounts(const BinaryImage& image) : m_integralImage(image.size()) {
+  const int width = image.width();
+  const int height = image.height();
+  const uint32_t* line = image.data();
+  const int wpl = image.wordsPerLine();
+  const uint32_t msb = uint32_t(1) << 31;
+
+  for (int y = 0; y < height; ++y, line += wpl) {
+    m_integralImage.beginRow();
+    for (int x = 0; x < width; ++x) {
+      m_integralImage.push((line[x >> 5] & (msb >> (x & 31))) ? 1 : 0);
+    }
+  }
+}
+
+int BlackPixelCounts::count(const QRect& rect) const {
+  if (rect.isEmpty()) {
+    return 0;
+  }
+  return static_cast<int>(m_integralImage.sum(rect));
+}
+
+SlicedHistogram BlackPixelCounts::histogram(const QRect& area, const SlicedHistogram::Type type) const {
+  SlicedHistogram hist;
+  if (type == SlicedHistogram::ROWS) {
+    hist.setSize(static_cast<size_t>(area.height()));
+    for (int y = area.top(); y <= area.bottom(); ++y) {
+      hist[y - area.top()] = count(QRect(area.left(), y, area.width(), 1));
+    }
+  } else {
+    hist.setSize(static_cast<size_t>(area.width()));
+    for (int x = area.left(); x <= area.right(); ++x) {
+      hist[x - area.left()] = count(QRect(x, area.top(), 1, area.height()));
+    }
+  }
+  return hist;
+}
+}  // namespace select_content
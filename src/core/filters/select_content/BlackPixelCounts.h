@@ -0,0 +1,49 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#ifndef SCANTAILOR_SELECT_CONTENT_BLACKPIXELCOUNTS_H_
+#define SCANTAILOR_SELECT_CONTENT_BLACKPIXELCOUNTS_H_
+
+#include <IntegralImage.h>
+#include <SlicedHistogram.h>
+
+#include <QRect>
+#include <cstdint>
+
+#include "NonCopyable.h"
+
+namespace imageproc {
+class BinaryImage;
+}
+
+namespace select_content {
+/**
+ * \brief Counts the black pixels of a binary image within rectangles in constant time.
+ *
+ * Trimming the content box asks for such counts over and over, while
+ * the images it asks about stay the same.
+ */
+class BlackPixelCounts {
+  DECLARE_NON_COPYABLE(BlackPixelCounts)
+
+ public:
+  explicit BlackPixelCounts(const imageproc::BinaryImage& image);
+
+  /**
+   * \brief The number of black pixels in \p rect.
+   *
+   * \note \p rect must be within the image area.
+   */
+  int count(const QRect& rect) const;
+
+  /**
+   * \brief The same as imageproc::SlicedHistogram(image, area, type),
+   *        in time proportional to the number of lines in \p area.
+   */
+  imageproc::SlicedHistogram histogram(const QRect& area, imageproc::SlicedHistogram::Type type) const;
+
+ private:
+  imageproc::IntegralImage<uint32_t> m_integralImage;
+};
+}  // namespace select_content
+#endif  // ifndef SCANTAILOR_SELECT_CONTENT_BLACKPIXELCOUNTS_H_
@@ -26,15 +26,39 @@
 #include <cmath>
 #include <queue>
 
+#include "BlackPixelCounts.h"
+#include "BorderShadows.h"
 #include "DebugImages.h"
 #include "Despeckle.h"
 #include "FilterData.h"
+#include "ImageId.h"
 #include "Settings.h"
 #include "TaskStatus.h"
 
 namespace select_content {
 using namespace imageproc;
 
+/**
+ * The pixel counts of the images that stay the same while the content box is being trimmed.
+ */
+class ContentBoxFinder::PixelCounts {
+ public:
+  PixelCounts(const BinaryImage& content, const BinaryImage& contentBlocks, const BinaryImage& text)
+      : m_content(content), m_contentBlocks(contentBlocks), m_text(text) {}
+
+  const BlackPixelCounts& content() const { return m_content; }
+
+  const BlackPixelCounts& contentBlocks() const { return m_contentBlocks; }
+
+  const BlackPixelCounts& text() const { return m_text; }
+
+ private:
+  BlackPixelCounts m_content;
+  BlackPixelCounts m_contentBlocks;
+  BlackPixelCounts m_text;
+};
+
+
 class ContentBoxFinder::Garbage {
  public:
   enum Type { HOR, VERT };
@@ -92,15 +116,10 @@ QRectF ContentBoxFinder::findContentBox(const TaskStatus& status,
     return QRectF();
   }
 
-  const GrayImage dataGrayImage = data.grayImageBlackOnWhite();
-  const uint8_t darkestGrayLevel = imageproc::darkestGrayLevel(dataGrayImage);
-  const QColor outsideColor(darkestGrayLevel, darkestGrayLevel, darkestGrayLevel);
-
-  QImage gray150(transformToGray(dataGrayImage, xform150dpi.transform(), xform150dpi.resultingRect().toRect(),
-                                 OutsidePixels::assumeColor(outsideColor)));
-  // Note that we fill new areas that appear as a result of
-  // rotation with black, not white.  Filling them with white
+  // The areas that appear as a result of rotation are filled with
+  // the darkest gray level, not white.  Filling them with white
   // may be bad for detecting the shadow around the page.
+  const QImage gray150(data.grayImage150dpi());
   if (dbg) {
     dbg->add(gray150, "gray150");
   }
@@ -121,41 +140,7 @@ QRectF ContentBoxFinder::findContentBox(const TaskStatus& status,
     dbg->add(bw150, "page_mask_applied");
   }
 
-  BinaryImage horShadowsSeed(openBrick(bw150, QSize(200, 14), BLACK));
-  if (dbg) {
-    dbg->add(horShadowsSeed, "horShadowsSeed");
-  }
-
-  status.throwIfCancelled();
-
-  BinaryImage verShadowsSeed(openBrick(bw150, QSize(14, 300), BLACK));
-  if (dbg) {
-    dbg->add(verShadowsSeed, "verShadowsSeed");
-  }
-
-  status.throwIfCancelled();
-
-  BinaryImage shadowsSeed(horShadowsSeed.release());
-  rasterOp<RopOr<RopSrc, RopDst>>(shadowsSeed, verShadowsSeed);
-  verShadowsSeed.release();
-  if (dbg) {
-    dbg->add(shadowsSeed, "shadowsSeed");
-  }
-
-  status.throwIfCancelled();
-
-  BinaryImage dilated(dilateBrick(bw150, QSize(3, 3)));
-  if (dbg) {
-    dbg->add(dilated, "dilated");
-  }
-
-  status.throwIfCancelled();
-
-  BinaryImage shadowsDilated(seedFill(shadowsSeed, dilated, CONN8));
-  dilated.release();
-  if (dbg) {
-    dbg->add(shadowsDilated, "shadowsDilated");
-  }
+  BinaryImage shadowsDilated(findBorderShadows(bw150, status, dbg));
 
   status.throwIfCancelled();
 
@@ -303,18 +288,21 @@ QRectF ContentBoxFinder::findContentBox(const TaskStatus& status,
   rasterOp<RopAnd<RopSrc, RopDst>>(textMask, content);
 
   QRect contentRect(contentBlocks.contentBoundingBox());
-  // Temporarily reuse horShadowsSeed and verShadowsSeed.
-  // It's OK they are null.
-  segmentGarbage(garbage, horShadowsSeed, verShadowsSeed, dbg);
+  BinaryImage initialHorGarbage;
+  BinaryImage initialVertGarbage;
+  segmentGarbage(garbage, initialHorGarbage, initialVertGarbage, dbg);
   garbage.release();
 
   if (dbg) {
-    dbg->add(horShadowsSeed, "initial_hor_garbage");
-    dbg->add(verShadowsSeed, "initial_vert_garbage");
+    dbg->add(initialHorGarbage, "initial_hor_garbage");
+    dbg->add(initialVertGarbage, "initial_vert_garbage");
   }
 
-  Garbage horGarbage(Garbage::HOR, horShadowsSeed.release());
-  Garbage vertGarbage(Garbage::VERT, verShadowsSeed.release());
+  Garbage horGarbage(Garbage::HOR, initialHorGarbage.release());
+  Garbage vertGarbage(Garbage::VERT, initialVertGarbage.release());
+
+  const PixelCounts counts(content, contentBlocks, textMask);
+  textMask.release();
 
   enum Side { LEFT = 1, RIGHT = 2, TOP = 4, BOTTOM = 8 };
 
@@ -326,7 +314,7 @@ QRectF ContentBoxFinder::findContentBox(const TaskStatus& status,
     if (sideMask & LEFT) {
       sideMask &= ~LEFT;
       oldContentRect = contentRect;
-      contentRect = trimLeft(content, contentBlocks, textMask, contentRect, vertGarbage, dbg);
+      contentRect = trimLeft(content, contentBlocks, counts, contentRect, vertGarbage, dbg);
 
       status.throwIfCancelled();
 
@@ -341,7 +329,7 @@ QRectF ContentBoxFinder::findContentBox(const TaskStatus& status,
     if (sideMask & RIGHT) {
       sideMask &= ~RIGHT;
       oldContentRect = contentRect;
-      contentRect = trimRight(content, contentBlocks, textMask, contentRect, vertGarbage, dbg);
+      contentRect = trimRight(content, contentBlocks, counts, contentRect, vertGarbage, dbg);
 
       status.throwIfCancelled();
 
@@ -356,7 +344,7 @@ QRectF ContentBoxFinder::findContentBox(const TaskStatus& status,
     if (sideMask & TOP) {
       sideMask &= ~TOP;
       oldContentRect = contentRect;
-      contentRect = trimTop(content, contentBlocks, textMask, contentRect, horGarbage, dbg);
+      contentRect = trimTop(content, contentBlocks, counts, contentRect, horGarbage, dbg);
 
       status.throwIfCancelled();
 
@@ -371,7 +359,7 @@ QRectF ContentBoxFinder::findContentBox(const TaskStatus& status,
     if (sideMask & BOTTOM) {
       sideMask &= ~BOTTOM;
       oldContentRect = contentRect;
-      contentRect = trimBottom(content, contentBlocks, textMask, contentRect, horGarbage, dbg);
+      contentRect = trimBottom(content, contentBlocks, counts, contentRect, horGarbage, dbg);
 
       status.throwIfCancelled();
 
@@ -403,6 +391,22 @@ QRectF ContentBoxFinder::findContentBox(const TaskStatus& status,
   return combinedXform.map(QRectF(contentRect)).boundingRect().intersected(data.xform().resultingRect());
 }  // ContentBoxFinder::findContentBox
 
+QByteArray ContentBoxFinder::fingerprint(const ImageId& imageId,
+                                         const FilterData& data,
+                                         const QRectF& pageRect,
+                                         const std::shared_ptr<Settings>& settings) {
+  const ImageTransformation& xform = data.xform();
+
+  InputFingerprint fingerprint;
+  fingerprint << imageId.filePath() << imageId.page();
+  fingerprint << data.origImage().width() << data.origImage().height() << int(data.isBlackOnWhite());
+  fingerprint << xform.origDpi().horizontal() << xform.origDpi().vertical() << xform.transform()
+              << xform.resultingRect();
+  fingerprint << pageRect;
+  fingerprint << (settings ? settings->contentFillFactor() : 0.65) << (settings ? settings->borderTolerance() : 2);
+  return fingerprint.result();
+}
+
 namespace {
 struct Bounds {
   // All are inclusive.
@@ -896,11 +900,11 @@ imageproc::BinaryImage ContentBoxFinder::estimateTextMask(const imageproc::Binar
 
 QRect ContentBoxFinder::trimLeft(const imageproc::BinaryImage& content,
                                  const imageproc::BinaryImage& contentBlocks,
-                                 const imageproc::BinaryImage& text,
+                                 const PixelCounts& counts,
                                  const QRect& area,
                                  Garbage& garbage,
                                  DebugImages* const dbg) {
-  const SlicedHistogram hist(contentBlocks, area, SlicedHistogram::COLS);
+  const SlicedHistogram hist(counts.contentBlocks().histogram(area, SlicedHistogram::COLS));
 
   size_t start = 0;
   while (start < hist.size()) {
@@ -929,7 +933,7 @@ QRect ContentBoxFinder::trimLeft(const imageproc::BinaryImage& content,
     }
 
     bool canRetryGrouped = false;
-    const QRect res = trim(content, contentBlocks, text, area, newArea, removedArea, garbage, canRetryGrouped, dbg);
+    const QRect res = trim(content, contentBlocks, counts, area, newArea, removedArea, garbage, canRetryGrouped, dbg);
     if (canRetryGrouped) {
       start = firstNonWs - area.left();
     } else {
@@ -941,11 +945,11 @@ QRect ContentBoxFinder::trimLeft(const imageproc::BinaryImage& content,
 
 QRect ContentBoxFinder::trimRight(const imageproc::BinaryImage& content,
                                   const imageproc::BinaryImage& contentBlocks,
-                                  const imageproc::BinaryImage& text,
+                                  const PixelCounts& counts,
                                   const QRect& area,
                                   Garbage& garbage,
                                   DebugImages* const dbg) {
-  const SlicedHistogram hist(contentBlocks, area, SlicedHistogram::COLS);
+  const SlicedHistogram hist(counts.contentBlocks().histogram(area, SlicedHistogram::COLS));
 
   auto start = static_cast<int>(hist.size() - 1);
   while (start >= 0) {
@@ -974,7 +978,7 @@ QRect ContentBoxFinder::trimRight(const imageproc::BinaryImage& content,
     }
 
     bool canRetryGrouped = false;
-    const QRect res = trim(content, contentBlocks, text, area, newArea, removedArea, garbage, canRetryGrouped, dbg);
+    const QRect res = trim(content, contentBlocks, counts, area, newArea, removedArea, garbage, canRetryGrouped, dbg);
     if (canRetryGrouped) {
       start = firstNonWs - area.left();
     } else {
@@ -986,11 +990,11 @@ QRect ContentBoxFinder::trimRight(const imageproc::BinaryImage& content,
 
 QRect ContentBoxFinder::trimTop(const imageproc::BinaryImage& content,
                                 const imageproc::BinaryImage& contentBlocks,
-                                const imageproc::BinaryImage& text,
+                                const PixelCounts& counts,
                                 const QRect& area,
                                 Garbage& garbage,
                                 DebugImages* const dbg) {
-  const SlicedHistogram hist(contentBlocks, area, SlicedHistogram::ROWS);
+  const SlicedHistogram hist(counts.contentBlocks().histogram(area, SlicedHistogram::ROWS));
 
   size_t start = 0;
   while (start < hist.size()) {
@@ -1019,7 +1023,7 @@ QRect ContentBoxFinder::trimTop(const imageproc::BinaryImage& content,
     }
 
     bool canRetryGrouped = false;
-    const QRect res = trim(content, contentBlocks, text, area, newArea, removedArea, garbage, canRetryGrouped, dbg);
+    const QRect res = trim(content, contentBlocks, counts, area, newArea, removedArea, garbage, canRetryGrouped, dbg);
     if (canRetryGrouped) {
       start = firstNonWs - area.top();
     } else {
@@ -1031,11 +1035,11 @@ QRect ContentBoxFinder::trimTop(const imageproc::BinaryImage& content,
 
 QRect ContentBoxFinder::trimBottom(const imageproc::BinaryImage& content,
                                    const imageproc::BinaryImage& contentBlocks,
-                                   const imageproc::BinaryImage& text,
+                                   const PixelCounts& counts,
                                    const QRect& area,
                                    Garbage& garbage,
                                    DebugImages* const dbg) {
-  const SlicedHistogram hist(contentBlocks, area, SlicedHistogram::ROWS);
+  const SlicedHistogram hist(counts.contentBlocks().histogram(area, SlicedHistogram::ROWS));
 
   auto start = static_cast<int>(hist.size() - 1);
   while (start >= 0) {
@@ -1064,7 +1068,7 @@ QRect ContentBoxFinder::trimBottom(const imageproc::BinaryImage& content,
     }
 
     bool canRetryGrouped = false;
-    const QRect res = trim(content, contentBlocks, text, area, newArea, removedArea, garbage, canRetryGrouped, dbg);
+    const QRect res = trim(content, contentBlocks, counts, area, newArea, removedArea, garbage, canRetryGrouped, dbg);
     if (canRetryGrouped) {
       start = firstNonWs - area.top();
     } else {
@@ -1076,7 +1080,7 @@ QRect ContentBoxFinder::trimBottom(const imageproc::BinaryImage& content,
 
 QRect ContentBoxFinder::trim(const imageproc::BinaryImage& content,
                              const imageproc::BinaryImage& contentBlocks,
-                             const imageproc::BinaryImage& text,
+                             const PixelCounts& counts,
                              const QRect& area,
                              const QRect& newArea,
                              const QRect& removedArea,
@@ -1125,7 +1129,7 @@ QRect ContentBoxFinder::trim(const imageproc::BinaryImage& content,
     return area;
   }
 
-  const int contentPixels = content.countBlackPixels(removedArea);
+  const int contentPixels = counts.content().count(removedArea);
 
   const bool verticalCut = (newArea.top() == area.top() && newArea.bottom() == area.bottom());
   // qDebug() << "vertical cut: " << verticalCut;
@@ -1135,7 +1139,7 @@ QRect ContentBoxFinder::trim(const imageproc::BinaryImage& content,
   // as garbage.
   double proximityBias = verticalCut ? 0.5 : 0.65;
 
-  const int numTextPixels = text.countBlackPixels(removedArea);
+  const int numTextPixels = counts.text().count(removedArea);
   if (numTextPixels == 0) {
     proximityBias = verticalCut ? 0.4 : 0.5;
   } else {
@@ -1160,45 +1164,52 @@ QRect ContentBoxFinder::trim(const imageproc::BinaryImage& content,
     proximityBias = qBound(0.0, proximityBias, 1.0);
   }
 
-  BinaryImage remainingContent(contentBlocks.size(), WHITE);
-  rasterOp<RopSrc>(remainingContent, newArea, content, newArea.topLeft());
-  rasterOp<RopAnd<RopSrc, RopDst>>(remainingContent, newArea, contentBlocks, newArea.topLeft());
-
-  const SEDM dmToOthers(remainingContent, SEDM::DIST_TO_BLACK, SEDM::DIST_TO_NO_BORDERS);
-  remainingContent.release();
-
   double sumDistToGarbage = 0;
   double sumDistToOthers = 0;
 
-  const uint32_t* cbLine = contentBlocks.data();
-  const int cbStride = contentBlocks.wordsPerLine();
-  const uint32_t msb = uint32_t(1) << 31;
-
-  const uint32_t* dmGarbageLine = garbage.sedm().data();
-  const uint32_t* dmOthersLine = dmToOthers.data();
-  const int dmStride = dmToOthers.stride();
-
-  int count = 0;
-  cbLine += cbStride * removedArea.top();
-  dmGarbageLine += dmStride * removedArea.top();
-  dmOthersLine += dmStride * removedArea.top();
-  for (int y = removedArea.top(); y <= removedArea.bottom(); ++y) {
-    for (int x = removedArea.left(); x <= removedArea.right(); ++x) {
-      if (cbLine[x >> 5] & (msb >> (x & 31))) {
-        sumDistToGarbage += std::sqrt((double) dmGarbageLine[x]);
-        sumDistToOthers += std::sqrt((double) dmOthersLine[x]);
-        ++count;
+  // Without any content blocks in the removed area both sums stay at zero,
+  // so there is no need to build the distance maps.
+  if (counts.contentBlocks().count(removedArea) != 0) {
+    // The distances are exact and all the black pixels are within newArea,
+    // so a map covering just the current area gives the same distances
+    // as one covering the whole image.
+    const QRect newAreaInArea(newArea.translated(-area.topLeft()));
+    BinaryImage remainingContent(area.size(), WHITE);
+    rasterOp<RopSrc>(remainingContent, newAreaInArea, content, newArea.topLeft());
+    rasterOp<RopAnd<RopSrc, RopDst>>(remainingContent, newAreaInArea, contentBlocks, newArea.topLeft());
+
+    const SEDM dmToOthers(remainingContent, SEDM::DIST_TO_BLACK, SEDM::DIST_TO_NO_BORDERS);
+    remainingContent.release();
+
+    const uint32_t* cbLine = contentBlocks.data();
+    const int cbStride = contentBlocks.wordsPerLine();
+    const uint32_t msb = uint32_t(1) << 31;
+
+    const SEDM& dmToGarbage = garbage.sedm();
+    const uint32_t* dmGarbageLine = dmToGarbage.data();
+    const int dmGarbageStride = dmToGarbage.stride();
+    const uint32_t* dmOthersLine = dmToOthers.data() - area.left();
+    const int dmOthersStride = dmToOthers.stride();
+
+    cbLine += cbStride * removedArea.top();
+    dmGarbageLine += dmGarbageStride * removedArea.top();
+    dmOthersLine += dmOthersStride * (removedArea.top() - area.top());
+    for (int y = removedArea.top(); y <= removedArea.bottom(); ++y) {
+      for (int x = removedArea.left(); x <= removedArea.right(); ++x) {
+        if (cbLine[x >> 5] & (msb >> (x & 31))) {
+          sumDistToGarbage += std::sqrt((double) dmGarbageLine[x]);
+          sumDistToOthers += std::sqrt((double) dmOthersLine[x]);
+        }
       }
+      cbLine += cbStride;
+      dmGarbageLine += dmGarbageStride;
+      dmOthersLine += dmOthersStride;
     }
-    cbLine += cbStride;
-    dmGarbageLine += dmStride;
-    dmOthersLine += dmStride;
   }
 
   // qDebug() << "proximityBias = " << proximityBias;
   // qDebug() << "sumDistToGarbage = " << sumDistToGarbage;
   // qDebug() << "sumDistToOthers = " << sumDistToOthers;
-  // qDebug() << "count = " << count;
 
   sumDistToGarbage *= proximityBias;
   sumDistToOthers *= 1.0 - proximityBias;
@@ -1353,6 +1364,7 @@ void ContentBoxFinder::Garbage::add(const BinaryImage& garbage, const QRect& rec
 const SEDM& ContentBoxFinder::Garbage::sedm() {
   if (m_sedmUpdatePending) {
     m_sedm = SEDM(m_garbage, SEDM::DIST_TO_BLACK, m_sedmBorders);
+    m_sedmUpdatePending = false;
   }
   return m_sedm;
 }
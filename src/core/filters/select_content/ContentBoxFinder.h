@@ -6,11 +6,13 @@
 
 #include <BinaryThreshold.h>
 
+#include <QByteArray>
 #include <memory>
 
 class TaskStatus;
 class DebugImages;
 class FilterData;
+class ImageId;
 class QImage;
 class QRect;
 class QRectF;
@@ -33,8 +35,22 @@ class ContentBoxFinder {
                                const std::shared_ptr<Settings>& settings = nullptr,
                                DebugImages* dbg = nullptr);
 
+  /**
+   * \brief Digests everything findContentBox() depends on.
+   *
+   * Equal fingerprints mean findContentBox() would return the same box,
+   * so a box found earlier, maybe speculatively, may be reused.  The image
+   * is identified by \p imageId rather than by its pixels, which would take
+   * longer to digest than some detections take.
+   */
+  static QByteArray fingerprint(const ImageId& imageId,
+                                const FilterData& data,
+                                const QRectF& pageRect,
+                                const std::shared_ptr<Settings>& settings = nullptr);
+
  private:
   class Garbage;
+  class PixelCounts;
 
   static void segmentGarbage(const imageproc::BinaryImage& garbage,
                              imageproc::BinaryImage& horGarbage,
@@ -56,35 +72,35 @@ class ContentBoxFinder {
 
   static QRect trimLeft(const imageproc::BinaryImage& content,
                         const imageproc::BinaryImage& contentBlocks,
-                        const imageproc::BinaryImage& textMask,
+                        const PixelCounts& counts,
                         const QRect& area,
                         Garbage& garbage,
                         DebugImages* dbg);
 
   static QRect trimRight(const imageproc::BinaryImage& content,
                          const imageproc::BinaryImage& contentBlocks,
-                         const imageproc::BinaryImage& textMask,
+                         const PixelCounts& counts,
                          const QRect& area,
                          Garbage& garbage,
                          DebugImages* dbg);
 
   static QRect trimTop(const imageproc::BinaryImage& content,
                        const imageproc::BinaryImage& contentBlocks,
-                       const imageproc::BinaryImage& textMask,
+                       const PixelCounts& counts,
                        const QRect& area,
                        Garbage& garbage,
                        DebugImages* dbg);
 
   static QRect trimBottom(const imageproc::BinaryImage& content,
                           const imageproc::BinaryImage& contentBlocks,
-                          const imageproc::BinaryImage& textMask,
+                          const PixelCounts& counts,
                           const QRect& area,
                           Garbage& garbage,
                           DebugImages* dbg);
 
   static QRect trim(const imageproc::BinaryImage& content,
                     const imageproc::BinaryImage& contentBlocks,
-                    const imageproc::BinaryImage& textMask,
+                    const PixelCounts& counts,
                     const QRect& area,
                     const QRect& newArea,
                     const QRect& removedArea,
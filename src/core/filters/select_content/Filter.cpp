@@ -142,7 +142,12 @@ std::shared_ptr<Task> Filter::createTask(const PageId& pageId,
                                          bool batch,
                                          bool debug) {
   return std::make_shared<Task>(std::static_pointer_cast<Filter>(shared_from_this()), std::move(nextTask), m_settings,
-                                m_pageBoxSettings, pageId, batch, debug);
+                                m_pageBoxSettings, pageId, batch, debug, /*speculative=*/false);
+}
+
+std::shared_ptr<Task> Filter::createSpeculativeTask(const PageId& pageId) {
+  return std::make_shared<Task>(std::static_pointer_cast<Filter>(shared_from_this()), nullptr, m_settings,
+                                m_pageBoxSettings, pageId, /*batch=*/true, /*debug=*/false, /*speculative=*/true);
 }
 
 std::shared_ptr<CacheDrivenTask> Filter::createCacheDrivenTask(std::shared_ptr<page_layout::CacheDrivenTask> nextTask) {
@@ -68,6 +68,12 @@ class Filter : public AbstractFilter {
                                    bool batch,
                                    bool debug);
 
+  /**
+   * \brief Creates a task detecting the content box ahead of the user getting
+   *        to this stage, see Task::process().
+   */
+  std::shared_ptr<Task> createSpeculativeTask(const PageId& pageId);
+
   std::shared_ptr<CacheDrivenTask> createCacheDrivenTask(std::shared_ptr<page_layout::CacheDrivenTask> nextTask);
 
   OptionsWidget* optionsWidget();
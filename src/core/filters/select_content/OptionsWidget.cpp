@@ -125,13 +125,10 @@ void OptionsWidget::applySelection(const std::set<PageId>& pages, const bool app
                       m_uiData.contentDetectionMode(), m_uiData.pageDetectionMode(),
                       m_uiData.isFineTuningCornersEnabled());
 
-  for (const PageId& pageId : pages) {
-    if (m_pageId == pageId) {
-      continue;
-    }
-
+  std::set<PageId> otherPages(pages);
+  otherPages.erase(m_pageId);
+  m_settings->updatePageParams(otherPages, [&](const Params* oldParams) {
     Params newParams(params);
-    std::unique_ptr<Params> oldParams = m_settings->getPageParams(pageId);
     if (oldParams) {
       if (newParams.pageDetectionMode() == MODE_MANUAL) {
         if (!applyPageBox) {
@@ -160,16 +157,10 @@ void OptionsWidget::applySelection(const std::set<PageId>& pages, const bool app
       }
     }
 
-    m_settings->setPageParams(pageId, newParams);
-  }
+    return newParams;
+  });
 
-  if (pages.size() > 1) {
-    emit invalidateAllThumbnails();
-  } else {
-    for (const PageId& pageId : pages) {
-      emit invalidateThumbnail(pageId);
-    }
-  }
+  emit invalidateThumbnails(pages);
 
   emit reloadRequested();
 }  // OptionsWidget::applySelection
@@ -8,29 +8,16 @@
 namespace select_content {
 OrderByHeightProvider::OrderByHeightProvider(std::shared_ptr<Settings> settings) : m_settings(std::move(settings)) {}
 
-bool OrderByHeightProvider::precedes(const PageId& lhsPage,
-                                     const bool lhsIncomplete,
-                                     const PageId& rhsPage,
-                                     const bool rhsIncomplete) const {
-  const std::unique_ptr<Params> lhsParams(m_settings->getPageParams(lhsPage));
-  const std::unique_ptr<Params> rhsParams(m_settings->getPageParams(rhsPage));
+PageOrderKey OrderByHeightProvider::sortKey(const PageId& page, const bool incomplete) const {
+  const std::unique_ptr<Params> params(m_settings->getPageParams(page));
 
-  QSizeF lhsSize;
-  if (lhsParams) {
-    lhsSize = lhsParams->contentSizeMM();
+  QSizeF size;
+  if (params) {
+    size = params->contentSizeMM();
   }
-  QSizeF rhsSize;
-  if (rhsParams) {
-    rhsSize = rhsParams->contentSizeMM();
-  }
-
-  const bool lhsValid = !lhsIncomplete && lhsSize.isValid();
-  const bool rhsValid = !rhsIncomplete && rhsSize.isValid();
 
-  if (lhsValid != rhsValid) {
-    // Invalid (unknown) sizes go to the back.
-    return lhsValid;
-  }
-  return lhsSize.height() < rhsSize.height();
+  // Invalid (unknown) sizes go to the back.
+  const bool valid = !incomplete && size.isValid();
+  return PageOrderKey(valid ? 0 : 1, size.height());
 }
 }  // namespace select_content
\ No newline at end of file
@@ -31,6 +31,7 @@ void Settings::clear() {
   QMutexLocker locker(&m_mutex);
   m_pageParams.clear();
   m_deviationProvider.clear();
+  m_speculativeContentBoxes.clear();
 }
 
 void Settings::performRelinking(const AbstractRelinker& relinker) {
@@ -45,6 +46,7 @@ void Settings::performRelinking(const AbstractRelinker& relinker) {
   }
 
   m_pageParams.swap(newParams);
+  m_speculativeContentBoxes.clear();
 
   m_deviationProvider.clear();
   for (const PageParams::value_type& kv : m_pageParams) {
@@ -58,6 +60,19 @@ void Settings::setPageParams(const PageId& pageId, const Params& params) {
   m_deviationProvider.addOrUpdate(pageId);
 }
 
+void Settings::updatePageParams(const std::set<PageId>& pages, const std::function<Params(const Params*)>& update) {
+  QMutexLocker locker(&m_mutex);
+  for (const PageId& pageId : pages) {
+    const auto it(m_pageParams.find(pageId));
+    if (it == m_pageParams.end()) {
+      m_pageParams.emplace(pageId, update(nullptr));
+    } else {
+      it->second = update(&it->second);
+    }
+    m_deviationProvider.addOrUpdate(pageId);
+  }
+}
+
 void Settings::clearPageParams(const PageId& pageId) {
   QMutexLocker locker(&m_mutex);
   m_pageParams.erase(pageId);
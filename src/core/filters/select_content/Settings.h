@@ -5,9 +5,13 @@
 #define SCANTAILOR_SELECT_CONTENT_SETTINGS_H_
 
 #include <DeviationProvider.h>
+#include <SpeculativeResultCache.h>
 
 #include <QMutex>
+#include <QRectF>
+#include <functional>
 #include <memory>
+#include <set>
 #include <unordered_map>
 
 #include "NonCopyable.h"
@@ -31,6 +35,15 @@ class Settings {
 
   void setPageParams(const PageId& pageId, const Params& params);
 
+  /**
+   * \brief Replaces the parameters of all of \p pages under a single lock.
+   *
+   * \param update Makes the new parameters of a page from its old ones,
+   *        or from nullptr if the page has none.  It's called with the lock
+   *        held, so it must not call back into the settings.
+   */
+  void updatePageParams(const std::set<PageId>& pages, const std::function<Params(const Params*)>& update);
+
   void clearPageParams(const PageId& pageId);
 
   std::unique_ptr<Params> getPageParams(const PageId& pageId) const;
@@ -53,6 +66,13 @@ class Settings {
   int borderTolerance() const;
   void setBorderTolerance(int pixels);
 
+  /**
+   * \brief Content boxes detected ahead of the user reaching this stage.
+   *
+   * They are stored against ContentBoxFinder::fingerprint(), see Task.
+   */
+  SpeculativeResultCache<PageId, QRectF>& speculativeContentBoxes() { return m_speculativeContentBoxes; }
+
  private:
   using PageParams = std::unordered_map<PageId, Params>;
 
@@ -63,6 +83,7 @@ class Settings {
   DeviationProvider<PageId> m_deviationProvider;
   double m_contentFillFactor = 0.65;
   int m_borderTolerance = 2;
+  SpeculativeResultCache<PageId, QRectF> m_speculativeContentBoxes;
 };
 }  // namespace select_content
 #endif  // ifndef SCANTAILOR_SELECT_CONTENT_SETTINGS_H_
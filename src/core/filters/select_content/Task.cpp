@@ -16,7 +16,6 @@
 #include "FilterUiInterface.h"
 #include "ImageView.h"
 #include "OptionsWidget.h"
-#include "PageFinder.h"
 #include "TaskStatus.h"
 #include "filters/page_box/Settings.h"
 #include "filters/page_layout/Task.h"
@@ -58,16 +57,16 @@ Task::Task(std::shared_ptr<Filter> filter,
            std::shared_ptr<page_box::Settings> pageBoxSettings,
            const PageId& pageId,
            const bool batch,
-           const bool debug)
+           const bool debug,
+           const bool speculative)
     : m_filter(std::move(filter)),
       m_nextTask(std::move(nextTask)),
       m_settings(std::move(settings)),
       m_pageBoxSettings(std::move(pageBoxSettings)),
       m_pageId(pageId),
-      m_batchProcessing(batch) {
-  if (debug) {
-    m_dbg = std::make_unique<DebugImagesImpl>();
-  }
+      m_batchProcessing(batch),
+      m_speculative(speculative) {
+  m_dbg = DebugImagesImpl::create(debug, "select_content", m_pageId);
 }
 
 Task::~Task() = default;
@@ -115,7 +114,7 @@ FilterResultPtr Task::process(const TaskStatus& status, const FilterData& data)
 
     if (needUpdateContentBox) {
       if (newParams.contentDetectionMode() == MODE_AUTO) {
-        contentRect = ContentBoxFinder::findContentBox(status, data, pageRect, m_settings, m_dbg.get());
+        contentRect = findContentBox(status, data, pageRect);
       } else if (newParams.contentDetectionMode() == MODE_DISABLED) {
         contentRect = pageRect;
       }
@@ -129,6 +128,10 @@ FilterResultPtr Task::process(const TaskStatus& status, const FilterData& data)
     }
   }
 
+  if (m_speculative) {
+    return nullptr;
+  }
+
   OptionsWidget::UiData uiData;
   uiData.setSizeCalc(physSizeCalc);
   uiData.setContentRect(newParams.contentRect());
@@ -151,6 +154,34 @@ FilterResultPtr Task::process(const TaskStatus& status, const FilterData& data)
   }
 }  // Task::process
 
+QRectF Task::findContentBox(const TaskStatus& status, const FilterData& data, const QRectF& pageRect) {
+  if (m_dbg) {
+    // The debug images are only produced by an actual detection.
+    return ContentBoxFinder::findContentBox(status, data, pageRect, m_settings, m_dbg.get());
+  }
+
+  SpeculativeResultCache<PageId, QRectF>& speculativeBoxes = m_settings->speculativeContentBoxes();
+  QRectF contentRect;
+  if (m_speculative) {
+    const QByteArray fingerprint(ContentBoxFinder::fingerprint(m_pageId.imageId(), data, pageRect, m_settings));
+    if (!speculativeBoxes.contains(m_pageId, fingerprint)) {
+      contentRect = ContentBoxFinder::findContentBox(status, data, pageRect, m_settings);
+      speculativeBoxes.store(m_pageId, fingerprint, contentRect);
+    }
+    return contentRect;
+  }
+
+  // Only the pages speculated on have anything to look up.
+  if (speculativeBoxes.contains(m_pageId)
+      && speculativeBoxes.find(m_pageId, ContentBoxFinder::fingerprint(m_pageId.imageId(), data, pageRect, m_settings),
+                               &contentRect)) {
+    // Once the box makes it to the page parameters, it's not needed here anymore.
+    speculativeBoxes.remove(m_pageId);
+    return contentRect;
+  }
+  return ContentBoxFinder::findContentBox(status, data, pageRect, m_settings);
+}
+
 /*============================ Task::UiUpdater ==========================*/
 
 Task::UiUpdater::UiUpdater(std::shared_ptr<Filter> filter,
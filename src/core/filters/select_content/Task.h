@@ -40,15 +40,23 @@ class Task {
        std::shared_ptr<page_box::Settings> pageBoxSettings,
        const PageId& pageId,
        bool batch,
-       bool debug);
+       bool debug,
+       bool speculative);
 
   virtual ~Task();
 
+  /**
+   * In the speculative mode, the content box is only detected if visiting the page
+   * would need it detected, and is put to Settings::speculativeContentBoxes()
+   * rather than to the page parameters.  Nothing is returned then.
+   */
   FilterResultPtr process(const TaskStatus& status, const FilterData& data);
 
  private:
   class UiUpdater;
 
+  QRectF findContentBox(const TaskStatus& status, const FilterData& data, const QRectF& pageRect);
+
   std::shared_ptr<Filter> m_filter;
   std::shared_ptr<page_layout::Task> m_nextTask;
   std::shared_ptr<Settings> m_settings;
@@ -56,6 +64,7 @@ class Task {
   std::unique_ptr<DebugImages> m_dbg;
   PageId m_pageId;
   bool m_batchProcessing;
+  bool m_speculative;
 };
 }  // namespace select_content
 #endif  // ifndef SCANTAILOR_SELECT_CONTENT_TASK_H_
@@ -0,0 +1,39 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+// output::Settings as core_tests sees it: the unmodified source, with each of
+// its lockers counted, so that the tests can bound how often an operation takes
+// the settings lock.  This object comes ahead of the output library on the
+// link line and defines every symbol of the library's copy, so that copy is
+// never pulled into core_tests; the application keeps the plain QMutexLocker.
+
+#include "CountingOutputSettings.h"
+
+#include <atomic>
+
+// Everything Settings.cpp includes, so that the substitution below only
+// applies to the body of Settings.cpp.
+#include "AbstractRelinker.h"
+#include "RelinkablePath.h"
+#include "Utils.h"
+#include "filters/output/FillColorProperty.h"
+#include "filters/output/PictureLayerProperty.h"
+#include "filters/output/Settings.h"
+
+namespace Tests {
+namespace {
+std::atomic<int> lockCount(0);
+}  // namespace
+
+CountingMutexLocker::CountingMutexLocker(QMutex* mutex) : m_locker(mutex) {
+  lockCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+int outputSettingsLockCount() {
+  return lockCount.load(std::memory_order_relaxed);
+}
+}  // namespace Tests
+
+#define QMutexLocker Tests::CountingMutexLocker
+#include "filters/output/Settings.cpp"
+#undef QMutexLocker
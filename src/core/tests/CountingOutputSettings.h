@@ -0,0 +1,30 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#ifndef SCANTAILOR_TESTS_COUNTINGOUTPUTSETTINGS_H_
+#define SCANTAILOR_TESTS_COUNTINGOUTPUTSETTINGS_H_
+
+#include <QMutex>
+#include <QMutexLocker>
+
+namespace Tests {
+/**
+ * \brief Takes the place of QMutexLocker in the output::Settings that core_tests links.
+ *
+ * Locks the mutex exactly as QMutexLocker does and counts the acquisition.
+ */
+class CountingMutexLocker {
+ public:
+  explicit CountingMutexLocker(QMutex* mutex);
+
+ private:
+  QMutexLocker<QMutex> m_locker;
+};
+
+/**
+ * \return How many times output::Settings has taken its lock in this process.
+ */
+int outputSettingsLockCount();
+}  // namespace Tests
+
+#endif
@@ -0,0 +1,633 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+// End-to-end regression driver.  Renders the synthetic page corpus, runs
+// every processing stage up to Output on it without the GUI and fingerprints
+// the per-stage results.
+//
+//   pipeline_regression --record golden.json [--strict-hashes] [--tolerance deskew.angle_deg=0.1]
+//   pipeline_regression --compare golden.json [--tolerance deskew.angle_deg=0.1] [--output actual.json]
+//
+// Exit status: 0 when the results match, 1 on regressions, 2 on errors.
+//
+// A recording keeps the tolerances of every metric, and whether output
+// hashes must match, next to the values, so a golden file carries its own
+// comparison rules.  --tolerance and --strict-hashes override them.
+//
+// A golden file with "partial": true only pins what it lists: pages, stages
+// and values it leaves out aren't compared.  That's how the expectations
+// known from the way the corpus is rendered are kept without a recording.
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QSettings>
+#include <QTemporaryDir>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "BackgroundTask.h"
+#include "FileNameDisambiguator.h"
+#include "FilterResult.h"
+#include "ImageFileInfo.h"
+#include "ImageLoader.h"
+#include "ImageMetadata.h"
+#include "LoadFileTask.h"
+#include "Margins.h"
+#include "OutputFileNameGenerator.h"
+#include "PageRange.h"
+#include "PageSelectionAccessor.h"
+#include "PageSelectionProvider.h"
+#include "PageSequence.h"
+#include "ProjectPages.h"
+#include "StageSequence.h"
+#include "SyntheticPageCorpus.h"
+#include "ThumbnailPixmapCache.h"
+#include "Utils.h"
+#include "filters/deskew/Params.h"
+#include "filters/deskew/Settings.h"
+#include "filters/deskew/Task.h"
+#include "filters/finalize/Task.h"
+#include "filters/fix_orientation/Settings.h"
+#include "filters/fix_orientation/Task.h"
+#include "filters/output/Task.h"
+#include "filters/page_box/Task.h"
+#include "filters/page_layout/Settings.h"
+#include "filters/page_layout/Task.h"
+#include "filters/page_split/Params.h"
+#include "filters/page_split/Settings.h"
+#include "filters/page_split/Task.h"
+#include "filters/select_content/Params.h"
+#include "filters/select_content/Settings.h"
+#include "filters/select_content/Task.h"
+
+namespace {
+const int FORMAT_VERSION = 1;
+const int SIGNATURE_SIZE = 32;
+
+class AllPagesSelectionProvider : public PageSelectionProvider {
+ public:
+  explicit AllPagesSelectionProvider(std::shared_ptr<ProjectPages> pages) : m_pages(std::move(pages)) {}
+
+  PageSequence allPages() const override { return m_pages->toPageSequence(PAGE_VIEW); }
+
+  std::set<PageId> selectedPages() const override { return {}; }
+
+  std::vector<PageRange> selectedRanges() const override { return {}; }
+
+ private:
+  std::shared_ptr<ProjectPages> m_pages;
+};
+
+double rounded(const double value, const int decimals) {
+  const double scale = std::pow(10.0, decimals);
+  return std::round(value * scale) / scale;
+}
+
+bool isMissing(const QJsonValue& value) {
+  return value.isNull() || value.isUndefined();
+}
+
+QJsonArray rectToJson(const QRectF& rect) {
+  return {rounded(rect.x(), 2), rounded(rect.y(), 2), rounded(rect.width(), 2), rounded(rect.height(), 2)};
+}
+
+QString layoutTypeName(const page_split::PageLayout::Type type) {
+  switch (type) {
+    case page_split::PageLayout::SINGLE_PAGE_UNCUT:
+      return "single_page_uncut";
+    case page_split::PageLayout::SINGLE_PAGE_CUT:
+      return "single_page_cut";
+    case page_split::PageLayout::TWO_PAGES:
+      return "two_pages";
+  }
+  return QString();
+}
+
+/**
+ * A coarse grid of mean luminance values, as a hex string.
+ * Small rendering differences move these values by a little,
+ * while real changes of the output move them by a lot.
+ */
+QString perceptualSignature(const QImage& image) {
+  const QImage gray(image.convertToFormat(QImage::Format_Grayscale8));
+  const int width = gray.width();
+  const int height = gray.height();
+  QByteArray cells;
+  for (int cy = 0; cy < SIGNATURE_SIZE; ++cy) {
+    const int y0 = cy * height / SIGNATURE_SIZE;
+    const int y1 = std::max(y0 + 1, (cy + 1) * height / SIGNATURE_SIZE);
+    for (int cx = 0; cx < SIGNATURE_SIZE; ++cx) {
+      const int x0 = cx * width / SIGNATURE_SIZE;
+      const int x1 = std::max(x0 + 1, (cx + 1) * width / SIGNATURE_SIZE);
+      qint64 sum = 0;
+      for (int y = y0; y < std::min(y1, height); ++y) {
+        const uchar* line = gray.constScanLine(y);
+        for (int x = x0; x < std::min(x1, width); ++x) {
+          sum += line[x];
+        }
+      }
+      const qint64 area = qint64(std::min(y1, height) - y0) * (std::min(x1, width) - x0);
+      cells.append(static_cast<char>(area > 0 ? (sum + area / 2) / area : 255));
+    }
+  }
+  return QString::fromLatin1(cells.toHex());
+}
+
+QJsonObject fingerprintOutput(const QString& filePath) {
+  const QImage image(ImageLoader::load(filePath));
+  if (image.isNull()) {
+    return {};
+  }
+
+  // Hash the pixels rather than the file, so that encoder changes don't show up.
+  const QImage rgb(image.convertToFormat(QImage::Format_RGB32));
+  QCryptographicHash hash(QCryptographicHash::Sha256);
+  for (int y = 0; y < rgb.height(); ++y) {
+    hash.addData(QByteArrayView(rgb.constScanLine(y), rgb.width() * 4));
+  }
+
+  return {{"width", image.width()},
+          {"height", image.height()},
+          {"sha256", QString::fromLatin1(hash.result().toHex())},
+          {"signature", perceptualSignature(image)}};
+}
+
+class PipelineRunner {
+ public:
+  PipelineRunner(const QStringList& inputFiles, const QString& outDir);
+
+  bool run();
+
+  QJsonObject fingerprint() const;
+
+ private:
+  BackgroundTaskPtr createCompositeTask(const PageInfo& page, int lastFilterIdx);
+
+  std::shared_ptr<ProjectPages> m_pages;
+  std::unique_ptr<StageSequence> m_stages;
+  OutputFileNameGenerator m_outFileNameGen;
+  std::shared_ptr<ThumbnailPixmapCache> m_thumbnailCache;
+};
+
+
+PipelineRunner::PipelineRunner(const QStringList& inputFiles, const QString& outDir) {
+  std::vector<ImageFileInfo> files;
+  for (const QString& filePath : inputFiles) {
+    const QImage image(filePath);
+    const ImageMetadata metadata(image.size(), Dpi(qRound(image.dotsPerMeterX() * 0.0254),
+                                                   qRound(image.dotsPerMeterY() * 0.0254)));
+    files.emplace_back(QFileInfo(filePath), std::vector<ImageMetadata>{metadata});
+  }
+
+  m_pages = std::make_shared<ProjectPages>(files, ProjectPages::AUTO_PAGES, Qt::LeftToRight);
+  m_stages = std::make_unique<StageSequence>(
+      m_pages, PageSelectionAccessor(std::make_shared<AllPagesSelectionProvider>(m_pages)));
+  m_outFileNameGen = OutputFileNameGenerator(std::make_shared<FileNameDisambiguator>(), outDir, Qt::LeftToRight);
+  for (const PageInfo& page : m_pages->toPageSequence(IMAGE_VIEW)) {
+    m_outFileNameGen.disambiguator()->registerFile(page.imageId().filePath());
+  }
+  m_thumbnailCache = core::Utils::createThumbnailCache(outDir);
+}
+
+BackgroundTaskPtr PipelineRunner::createCompositeTask(const PageInfo& page, const int lastFilterIdx) {
+  const StageSequence& stages = *m_stages;
+  std::shared_ptr<output::Task> outputTask;
+  std::shared_ptr<finalize::Task> finalizeTask;
+  std::shared_ptr<page_layout::Task> pageLayoutTask;
+  std::shared_ptr<select_content::Task> selectContentTask;
+  std::shared_ptr<page_box::Task> pageBoxTask;
+  std::shared_ptr<deskew::Task> deskewTask;
+  std::shared_ptr<page_split::Task> pageSplitTask;
+
+  if (lastFilterIdx >= stages.outputFilterIdx()) {
+    outputTask = stages.outputFilter()->createTask(page.id(), m_thumbnailCache, m_outFileNameGen, true, false);
+  }
+  if (lastFilterIdx >= stages.finalizeFilterIdx()) {
+    finalizeTask
+        = stages.finalizeFilter()->createTask(page.id(), outputTask, stages.outputFilter()->settings(), true);
+  }
+  if (lastFilterIdx >= stages.pageLayoutFilterIdx()) {
+    pageLayoutTask = stages.pageLayoutFilter()->createTask(page.id(), finalizeTask, true, false);
+  }
+  if (lastFilterIdx >= stages.selectContentFilterIdx()) {
+    selectContentTask = stages.selectContentFilter()->createTask(page.id(), pageLayoutTask, true, false);
+  }
+  if (lastFilterIdx >= stages.pageBoxFilterIdx()) {
+    pageBoxTask = stages.pageBoxFilter()->createTask(page.id(), selectContentTask, true, false);
+  }
+  if (lastFilterIdx >= stages.deskewFilterIdx()) {
+    deskewTask = stages.deskewFilter()->createTask(page.id(), pageBoxTask, true, false);
+  }
+  if (lastFilterIdx >= stages.pageSplitFilterIdx()) {
+    pageSplitTask = stages.pageSplitFilter()->createTask(page, deskewTask, true, false);
+  }
+  const std::shared_ptr<fix_orientation::Task> fixOrientationTask
+      = stages.fixOrientationFilter()->createTask(page.id(), pageSplitTask, true);
+
+  return std::make_shared<LoadFileTask>(BackgroundTask::BATCH, page, m_thumbnailCache, m_pages, fixOrientationTask);
+}
+
+/**
+ * Runs the stages one at a time over all the pages, like batch processing
+ * does when started from each stage in turn.  That makes the results
+ * independent from the processing order of the pages.
+ */
+bool PipelineRunner::run() {
+  for (int filterIdx = m_stages->fixOrientationFilterIdx(); filterIdx <= m_stages->outputFilterIdx(); ++filterIdx) {
+    const PageView view = m_stages->filterAt(filterIdx)->getView();
+    for (const PageInfo& page : m_pages->toPageSequence(view)) {
+      for (int i = 0; i < m_stages->count(); ++i) {
+        m_stages->filterAt(i)->loadDefaultSettings(page);
+      }
+
+      FilterResultPtr result;
+      try {
+        result = (*createCompositeTask(page, filterIdx))();
+      } catch (const std::exception& e) {
+        std::fprintf(stderr, "%s failed on %s: %s\n", qPrintable(m_stages->filterAt(filterIdx)->getName()),
+                     qPrintable(page.imageId().filePath()), e.what());
+        return false;
+      }
+      if (!result || !result->filter()) {
+        std::fprintf(stderr, "%s failed on %s\n", qPrintable(m_stages->filterAt(filterIdx)->getName()),
+                     qPrintable(page.imageId().filePath()));
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+QJsonObject PipelineRunner::fingerprint() const {
+  QJsonObject pages;
+  for (const PageInfo& page : m_pages->toPageSequence(PAGE_VIEW)) {
+    const PageId& pageId = page.id();
+    QJsonObject stages;
+
+    stages["fix_orientation"] = QJsonObject{
+        {"rotation", m_stages->fixOrientationFilter()->settings()->getRotationFor(pageId.imageId()).toDegrees()}};
+
+    const page_split::Settings::Record record(
+        m_stages->pageSplitFilter()->settings()->getPageRecord(pageId.imageId()));
+    if (const page_split::Params* params = record.params()) {
+      const page_split::PageLayout& layout = params->pageLayout();
+      QJsonArray cutters;
+      for (int i = 0; i < layout.numCutters(); ++i) {
+        const QLineF line(layout.cutterLine(i));
+        cutters.append(QJsonArray{rounded(line.x1(), 2), rounded(line.y1(), 2), rounded(line.x2(), 2),
+                                  rounded(line.y2(), 2)});
+      }
+      stages["page_split"] = QJsonObject{{"layout", layoutTypeName(layout.type())}, {"cutters", cutters}};
+    }
+
+    if (const std::unique_ptr<deskew::Params> params = m_stages->deskewFilter()->settings()->getPageParams(pageId)) {
+      stages["deskew"] = QJsonObject{{"angle", rounded(params->deskewAngle(), 4)}};
+    }
+
+    if (const std::unique_ptr<select_content::Params> params
+        = m_stages->selectContentFilter()->settings()->getPageParams(pageId)) {
+      stages["select_content"] = QJsonObject{{"content_box", rectToJson(params->contentRect())},
+                                             {"page_box", rectToJson(params->pageRect())}};
+    }
+
+    const Margins margins(m_stages->pageLayoutFilter()->settings()->getHardMarginsMM(pageId));
+    const QJsonArray hardMargins{rounded(margins.left(), 2), rounded(margins.top(), 2), rounded(margins.right(), 2),
+                                 rounded(margins.bottom(), 2)};
+    stages["page_layout"] = QJsonObject{{"hard_margins_mm", hardMargins}};
+
+    const QJsonObject output(fingerprintOutput(m_outFileNameGen.filePathFor(pageId)));
+    if (!output.isEmpty()) {
+      stages["output"] = output;
+    }
+
+    pages[QFileInfo(pageId.imageId().filePath()).fileName() + '#' + pageId.subPageAsString()] = stages;
+  }
+  return QJsonObject{{"format", FORMAT_VERSION}, {"pages", pages}};
+}
+
+/*============================== Comparison ================================*/
+
+class Comparison {
+ public:
+  Comparison(const std::map<QString, double>& tolerances, bool strictHashes)
+      : m_tolerances(tolerances), m_strictHashes(strictHashes), m_partial(false), m_numFailures(0) {}
+
+  void compare(const QJsonObject& golden, const QJsonObject& actual);
+
+  int numFailures() const { return m_numFailures; }
+
+ private:
+  void comparePage(const QString& page, const QJsonObject& golden, const QJsonObject& actual);
+
+  void compareNumbers(const QString& page, const QString& metric, const QJsonArray& golden, const QJsonArray& actual);
+
+  void compareOutput(const QString& page, const QJsonObject& golden, const QJsonObject& actual);
+
+  void fail(const QString& page, const QString& message);
+
+  const std::map<QString, double>& m_tolerances;
+  const bool m_strictHashes;
+  bool m_partial;
+  int m_numFailures;
+};
+
+
+void Comparison::fail(const QString& page, const QString& message) {
+  ++m_numFailures;
+  std::printf("FAIL %s: %s\n", qPrintable(page), qPrintable(message));
+}
+
+void Comparison::compare(const QJsonObject& golden, const QJsonObject& actual) {
+  if (golden["format"].toInt() != FORMAT_VERSION) {
+    fail("*", QString("golden file format %1, expected %2").arg(golden["format"].toInt()).arg(FORMAT_VERSION));
+    return;
+  }
+  m_partial = golden["partial"].toBool();
+
+  const QJsonObject goldenPages(golden["pages"].toObject());
+  const QJsonObject actualPages(actual["pages"].toObject());
+  for (auto it = goldenPages.begin(); it != goldenPages.end(); ++it) {
+    if (!actualPages.contains(it.key())) {
+      fail(it.key(), "page is missing");
+      continue;
+    }
+    comparePage(it.key(), it.value().toObject(), actualPages[it.key()].toObject());
+  }
+  for (auto it = actualPages.begin(); it != actualPages.end(); ++it) {
+    if (!m_partial && !goldenPages.contains(it.key())) {
+      fail(it.key(), "unexpected page");
+    }
+  }
+}
+
+void Comparison::comparePage(const QString& page, const QJsonObject& golden, const QJsonObject& actual) {
+  for (const QString& stage : {"fix_orientation", "page_split", "deskew", "select_content", "page_layout", "output"}) {
+    if ((golden.contains(stage) != actual.contains(stage)) && !(m_partial && !golden.contains(stage))) {
+      fail(page, QString("%1 results %2").arg(stage, golden.contains(stage) ? "are missing" : "appeared"));
+    }
+  }
+
+  const QJsonObject goldenSplit(golden["page_split"].toObject());
+  const QJsonObject actualSplit(actual["page_split"].toObject());
+  if (isMissing(goldenSplit["layout"]) && m_partial) {
+    // Not pinned.
+  } else if (goldenSplit["layout"] != actualSplit["layout"]) {
+    fail(page, QString("page_split.layout: golden %1, actual %2")
+                   .arg(goldenSplit["layout"].toString(), actualSplit["layout"].toString()));
+  } else {
+    const QJsonArray goldenCutters(goldenSplit["cutters"].toArray());
+    const QJsonArray actualCutters(actualSplit["cutters"].toArray());
+    if (goldenCutters.size() == actualCutters.size()) {
+      for (int i = 0; i < goldenCutters.size(); ++i) {
+        compareNumbers(page, "page_split.cutter_px", goldenCutters[i].toArray(), actualCutters[i].toArray());
+      }
+    }
+  }
+
+  compareNumbers(page, "fix_orientation.rotation", {golden["fix_orientation"]["rotation"]},
+                 {actual["fix_orientation"]["rotation"]});
+  compareNumbers(page, "deskew.angle_deg", {golden["deskew"]["angle"]}, {actual["deskew"]["angle"]});
+  compareNumbers(page, "select_content.content_box_px", golden["select_content"]["content_box"].toArray(),
+                 actual["select_content"]["content_box"].toArray());
+  compareNumbers(page, "select_content.page_box_px", golden["select_content"]["page_box"].toArray(),
+                 actual["select_content"]["page_box"].toArray());
+  compareNumbers(page, "page_layout.margin_mm", golden["page_layout"]["hard_margins_mm"].toArray(),
+                 actual["page_layout"]["hard_margins_mm"].toArray());
+  compareOutput(page, golden["output"].toObject(), actual["output"].toObject());
+}
+
+void Comparison::compareNumbers(const QString& page,
+                                const QString& metric,
+                                const QJsonArray& golden,
+                                const QJsonArray& actual) {
+  if (m_partial && golden.isEmpty()) {
+    return;
+  }
+  if (golden.size() != actual.size()) {
+    fail(page, QString("%1: golden has %2 values, actual %3").arg(metric).arg(golden.size()).arg(actual.size()));
+    return;
+  }
+
+  const double tolerance = m_tolerances.at(metric);
+  for (int i = 0; i < golden.size(); ++i) {
+    if (isMissing(golden[i]) && (isMissing(actual[i]) || m_partial)) {
+      continue;
+    }
+    const double goldenValue = golden[i].toDouble();
+    const double actualValue = actual[i].toDouble();
+    if (!(std::abs(goldenValue - actualValue) <= tolerance)) {
+      fail(page, QString("%1[%2]: golden %3, actual %4, tolerance %5")
+                     .arg(metric)
+                     .arg(i)
+                     .arg(goldenValue)
+                     .arg(actualValue)
+                     .arg(tolerance));
+    }
+  }
+}
+
+void Comparison::compareOutput(const QString& page, const QJsonObject& golden, const QJsonObject& actual) {
+  if (golden.isEmpty() || actual.isEmpty()) {
+    return;
+  }
+
+  compareNumbers(page, "output.size_px", {golden["width"], golden["height"]}, {actual["width"], actual["height"]});
+
+  const QByteArray goldenCells(QByteArray::fromHex(golden["signature"].toString().toLatin1()));
+  const QByteArray actualCells(QByteArray::fromHex(actual["signature"].toString().toLatin1()));
+  if (goldenCells.size() != actualCells.size() || goldenCells.isEmpty()) {
+    fail(page, "output.perceptual: signatures are not comparable");
+  } else {
+    double sum = 0.0;
+    for (int i = 0; i < goldenCells.size(); ++i) {
+      sum += std::abs(int(uchar(goldenCells[i])) - int(uchar(actualCells[i])));
+    }
+    const double meanDifference = sum / goldenCells.size();
+    const double tolerance = m_tolerances.at("output.perceptual");
+    if (meanDifference > tolerance) {
+      fail(page, QString("output.perceptual: mean difference %1, tolerance %2").arg(meanDifference).arg(tolerance));
+    }
+  }
+
+  if (golden["sha256"] != actual["sha256"]) {
+    if (m_strictHashes) {
+      fail(page, "output.sha256 differs");
+    } else {
+      std::printf("NOTE %s: output pixels differ from the golden ones\n", qPrintable(page));
+    }
+  }
+}
+
+std::map<QString, double> defaultTolerances() {
+  return {{"fix_orientation.rotation", 0.0},
+          {"page_split.cutter_px", 3.0},
+          {"deskew.angle_deg", 0.05},
+          {"select_content.content_box_px", 4.0},
+          {"select_content.page_box_px", 4.0},
+          {"page_layout.margin_mm", 0.5},
+          {"output.size_px", 2.0},
+          {"output.perceptual", 3.0}};
+}
+
+QJsonObject tolerancesToJson(const std::map<QString, double>& tolerances) {
+  QJsonObject json;
+  for (const auto& [metric, tolerance] : tolerances) {
+    json[metric] = tolerance;
+  }
+  return json;
+}
+
+/**
+ * Sets the tolerances a golden file carries.
+ *
+ * \return False if the file names a metric that doesn't exist.
+ */
+bool applyTolerances(const QJsonObject& json, std::map<QString, double>& tolerances) {
+  for (auto it = json.begin(); it != json.end(); ++it) {
+    if ((tolerances.count(it.key()) == 0) || !it.value().isDouble()) {
+      std::fprintf(stderr, "Bad tolerance in the golden file: %s\n", qPrintable(it.key()));
+      return false;
+    }
+    tolerances[it.key()] = it.value().toDouble();
+  }
+  return true;
+}
+
+bool writeJson(const QString& filePath, const QJsonObject& json) {
+  QSaveFile file(filePath);
+  return file.open(QIODevice::WriteOnly) && (file.write(QJsonDocument(json).toJson(QJsonDocument::Indented)) >= 0)
+         && file.commit();
+}
+
+bool readJson(const QString& filePath, QJsonObject* json) {
+  QFile file(filePath);
+  if (!file.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+  const QJsonDocument doc(QJsonDocument::fromJson(file.readAll()));
+  *json = doc.object();
+  return doc.isObject();
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+  }
+  QApplication app(argc, argv);
+  QApplication::setOrganizationName("scantailor-pipeline-regression");
+  QApplication::setApplicationName("scantailor-pipeline-regression");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription(
+      "Runs all the processing stages on a synthetic corpus and fingerprints the results.");
+  parser.addHelpOption();
+  const QCommandLineOption recordOption("record", "Write the results to <golden> as the new reference.", "golden");
+  const QCommandLineOption compareOption("compare", "Compare the results against <golden>.", "golden");
+  const QCommandLineOption outputOption("output", "Also write the results to <file>.", "file");
+  const QCommandLineOption toleranceOption("tolerance", "Override a tolerance, e.g. deskew.angle_deg=0.1.",
+                                           "metric=value");
+  const QCommandLineOption strictOption("strict-hashes", "Treat any change of output pixels as a failure.");
+  const QCommandLineOption workDirOption("work-dir", "Keep the corpus and the output in <dir>.", "dir");
+  parser.addOptions({recordOption, compareOption, outputOption, toleranceOption, strictOption, workDirOption});
+  parser.process(app);
+
+  if (parser.isSet(recordOption) == parser.isSet(compareOption)) {
+    std::fprintf(stderr, "Exactly one of --record and --compare is required.\n");
+    return 2;
+  }
+
+  std::map<QString, double> tolerances(defaultTolerances());
+  std::map<QString, double> toleranceOverrides;
+  for (const QString& override : parser.values(toleranceOption)) {
+    const int sep = override.indexOf('=');
+    bool ok = false;
+    const double value = (sep > 0) ? override.mid(sep + 1).toDouble(&ok) : 0.0;
+    if (!ok || (tolerances.count(override.left(sep)) == 0)) {
+      std::fprintf(stderr, "Bad tolerance: %s\n", qPrintable(override));
+      return 2;
+    }
+    toleranceOverrides[override.left(sep)] = value;
+  }
+
+  QJsonObject golden;
+  if (parser.isSet(compareOption)) {
+    if (!readJson(parser.value(compareOption), &golden)) {
+      std::fprintf(stderr, "Failed to read %s\n", qPrintable(parser.value(compareOption)));
+      return 2;
+    }
+    if (!applyTolerances(golden["tolerances"].toObject(), tolerances)) {
+      return 2;
+    }
+  }
+  for (const auto& [metric, tolerance] : toleranceOverrides) {
+    tolerances[metric] = tolerance;
+  }
+  const bool strictHashes = parser.isSet(strictOption) || golden["strict_hashes"].toBool();
+
+  QTemporaryDir tempDir;
+  const QString workDir = parser.isSet(workDirOption) ? parser.value(workDirOption) : tempDir.path();
+  if (workDir.isEmpty() || !QDir().mkpath(workDir)) {
+    std::fprintf(stderr, "Can't create the work directory.\n");
+    return 2;
+  }
+
+  // Keep the user's defaults and profiles out of the results.
+  QSettings::setDefaultFormat(QSettings::IniFormat);
+  QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, QDir(workDir).filePath("settings"));
+
+  const QStringList inputFiles(Tests::writeSyntheticPageCorpus(QDir(workDir).filePath("input")));
+  if (inputFiles.isEmpty()) {
+    std::fprintf(stderr, "Failed to write the synthetic corpus.\n");
+    return 2;
+  }
+
+  const QString outDir(QDir(workDir).filePath("out"));
+  QDir().mkpath(outDir);
+  PipelineRunner runner(inputFiles, outDir);
+  if (!runner.run()) {
+    return 2;
+  }
+  const QJsonObject results(runner.fingerprint());
+
+  if (parser.isSet(outputOption) && !writeJson(parser.value(outputOption), results)) {
+    std::fprintf(stderr, "Failed to write %s\n", qPrintable(parser.value(outputOption)));
+    return 2;
+  }
+
+  if (parser.isSet(recordOption)) {
+    QJsonObject recording(results);
+    recording["tolerances"] = tolerancesToJson(tolerances);
+    recording["strict_hashes"] = strictHashes;
+    if (!writeJson(parser.value(recordOption), recording)) {
+      std::fprintf(stderr, "Failed to write %s\n", qPrintable(parser.value(recordOption)));
+      return 2;
+    }
+    std::printf("Recorded %d pages.\n", results["pages"].toObject().size());
+    return 0;
+  }
+
+  Comparison comparison(tolerances, strictHashes);
+  comparison.compare(golden, results);
+  if (comparison.numFailures() > 0) {
+    std::printf("%d regressions.\n", comparison.numFailures());
+    return 1;
+  }
+  std::printf("All %d pages match.\n", results["pages"].toObject().size());
+  return 0;
+}
@@ -0,0 +1,269 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include "SyntheticPageCorpus.h"
+
+#include <QDir>
+#include <QImageWriter>
+#include <QPainter>
+#include <QTransform>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+namespace Tests {
+namespace {
+const int DPI = 200;
+// A5 at 200 DPI.
+const int PAGE_WIDTH = 1165;
+const int PAGE_HEIGHT = 1654;
+
+const QRgb INK = qRgb(25, 25, 25);
+
+/**
+ * std::uniform_int_distribution is implementation-defined, while the raw
+ * output of std::mt19937 is not.  The corpus must not depend on the standard
+ * library it was built with.
+ */
+class Rng {
+ public:
+  explicit Rng(const uint32_t seed) : m_engine(seed) {}
+
+  int range(const int from, const int to) {
+    return from + static_cast<int>(m_engine() % static_cast<uint32_t>(to - from + 1));
+  }
+
+ private:
+  std::mt19937 m_engine;
+};
+
+int clampToByte(const double value) {
+  return std::clamp(static_cast<int>(std::lround(value)), 0, 255);
+}
+
+QImage makePaper(const int width, const int height, const QRgb paperColor, Rng& rng) {
+  QImage image(width, height, QImage::Format_RGB32);
+  for (int y = 0; y < height; ++y) {
+    auto* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+    for (int x = 0; x < width; ++x) {
+      const int noise = rng.range(-6, 6);
+      line[x] = qRgb(clampToByte(qRed(paperColor) + noise), clampToByte(qGreen(paperColor) + noise),
+                     clampToByte(qBlue(paperColor) + noise));
+    }
+  }
+  return image;
+}
+
+QRect textArea(const int pageLeft) {
+  return QRect(pageLeft + 130, 150, PAGE_WIDTH - 260, PAGE_HEIGHT - 320);
+}
+
+/**
+ * Lays out paragraphs of "words" made of glyph-sized blocks with ascenders and descenders.
+ */
+std::vector<QRectF> layoutGlyphs(const QRect& area, Rng& rng) {
+  const int lineHeight = 34;
+  const int xHeight = 13;
+  const int ascent = 20;
+  const int descent = 6;
+
+  std::vector<QRectF> glyphs;
+  int baseline = area.top() + ascent;
+  int lineInParagraph = 0;
+  int paragraphLength = rng.range(6, 11);
+  while (baseline + descent <= area.bottom()) {
+    const bool lastLine = lineInParagraph == paragraphLength - 1;
+    const int right = lastLine ? area.left() + area.width() * rng.range(30, 80) / 100 : area.right();
+    int x = area.left() + (lineInParagraph == 0 ? 40 : 0);
+    while (true) {
+      std::vector<int> widths(static_cast<size_t>(rng.range(1, 9)));
+      int wordWidth = 0;
+      for (int& width : widths) {
+        width = rng.range(7, 13);
+        wordWidth += width + 2;
+      }
+      if (x + wordWidth > right) {
+        break;
+      }
+      for (const int width : widths) {
+        const int kind = rng.range(0, 9);
+        if (kind < 2) {
+          glyphs.emplace_back(x, baseline - ascent, width, ascent);
+        } else if (kind == 2) {
+          glyphs.emplace_back(x, baseline - xHeight, width, xHeight + descent);
+        } else {
+          glyphs.emplace_back(x, baseline - xHeight, width, xHeight);
+        }
+        x += width + 2;
+      }
+      x += 12;
+    }
+
+    baseline += lineHeight;
+    if (lastLine) {
+      lineInParagraph = 0;
+      paragraphLength = rng.range(6, 11);
+      baseline += lineHeight / 2;
+    } else {
+      ++lineInParagraph;
+    }
+  }
+  return glyphs;
+}
+
+/**
+ * \param curvature The vertical displacement of the middle of a line relative to its ends,
+ *        the way lines bend towards the spine of an open book.
+ */
+void drawGlyphs(QImage& image,
+                const std::vector<QRectF>& glyphs,
+                const double skewAngleDeg = 0.0,
+                const double curvature = 0.0) {
+  QPainter painter(&image);
+  painter.setPen(Qt::NoPen);
+  painter.setBrush(QColor(INK));
+  const QPointF center(image.width() / 2.0, image.height() / 2.0);
+  painter.translate(center);
+  painter.rotate(skewAngleDeg);
+  painter.translate(-center);
+
+  const double halfWidth = image.width() / 2.0;
+  for (const QRectF& glyph : glyphs) {
+    const double t = (glyph.center().x() - center.x()) / halfWidth;
+    painter.drawRect(glyph.translated(0.0, std::round(curvature * (1.0 - t * t))));
+  }
+}
+
+void drawPhoto(QImage& image, const QRect& area, Rng& rng) {
+  for (int y = area.top(); y <= area.bottom(); ++y) {
+    auto* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+    for (int x = area.left(); x <= area.right(); ++x) {
+      const double fx = x * 0.021;
+      const double fy = y * 0.017;
+      const int noise = rng.range(-6, 6);
+      line[x] = qRgb(clampToByte(120 + 90 * std::sin(fx) * std::cos(fy) + noise),
+                     clampToByte(110 + 70 * std::sin(fx * 1.7 + 1.0) + noise),
+                     clampToByte(100 + 60 * std::cos(fy * 1.3) + noise));
+    }
+  }
+}
+
+void drawScannerBorders(QImage& image, Rng& rng) {
+  const QRgb dark = qRgb(30, 30, 30);
+  for (int y = 0; y < image.height(); ++y) {
+    auto* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+    const int width = 60 + rng.range(0, 15);
+    std::fill(line, line + width, dark);
+  }
+  std::vector<int> bottomEdge(static_cast<size_t>(image.width()));
+  for (int& edge : bottomEdge) {
+    edge = image.height() - 55 - rng.range(0, 15);
+  }
+  for (int y = image.height() - 70; y < image.height(); ++y) {
+    auto* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+    for (int x = 0; x < image.width(); ++x) {
+      if (y >= bottomEdge[x]) {
+        line[x] = dark;
+      }
+    }
+  }
+}
+
+void darkenGutter(QImage& image) {
+  const int center = image.width() / 2;
+  const int halfWidth = 60;
+  for (int y = 0; y < image.height(); ++y) {
+    auto* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+    for (int x = center - halfWidth; x <= center + halfWidth; ++x) {
+      const double factor = 0.55 + 0.45 * std::abs(x - center) / halfWidth;
+      const QRgb px = line[x];
+      line[x] = qRgb(clampToByte(qRed(px) * factor), clampToByte(qGreen(px) * factor),
+                     clampToByte(qBlue(px) * factor));
+    }
+  }
+}
+
+QImage textPage(Rng& rng, const double skewAngleDeg = 0.0, const double curvature = 0.0) {
+  QImage image(makePaper(PAGE_WIDTH, PAGE_HEIGHT, qRgb(242, 242, 242), rng));
+  drawGlyphs(image, layoutGlyphs(textArea(0), rng), skewAngleDeg, curvature);
+  return image;
+}
+
+QImage textAndPhotoPage(Rng& rng) {
+  QImage image(makePaper(PAGE_WIDTH, PAGE_HEIGHT, qRgb(240, 236, 226), rng));
+  const QRect area(textArea(0));
+  const QRect photo(area.left(), 700, area.width(), 520);
+  drawGlyphs(image, layoutGlyphs(QRect(area.left(), area.top(), area.width(), photo.top() - 40 - area.top()), rng));
+  drawPhoto(image, photo, rng);
+  drawGlyphs(image, layoutGlyphs(QRect(area.left(), photo.bottom() + 40, area.width(),
+                                       area.bottom() - photo.bottom() - 40),
+                                 rng));
+  return image;
+}
+
+QImage twoPageSpread(Rng& rng) {
+  QImage image(makePaper(PAGE_WIDTH * 2, PAGE_HEIGHT, qRgb(242, 242, 242), rng));
+  std::vector<QRectF> glyphs(layoutGlyphs(textArea(0), rng));
+  const std::vector<QRectF> rightGlyphs(layoutGlyphs(textArea(PAGE_WIDTH), rng));
+  glyphs.insert(glyphs.end(), rightGlyphs.begin(), rightGlyphs.end());
+  drawGlyphs(image, glyphs);
+  darkenGutter(image);
+  return image;
+}
+
+QImage toGrayscale(const QImage& image) {
+  return image.convertToFormat(QImage::Format_Grayscale8);
+}
+}  // namespace
+
+std::vector<SyntheticPage> renderSyntheticPageCorpus() {
+  std::vector<SyntheticPage> pages;
+
+  Rng textRng(1);
+  pages.push_back({"01_text", toGrayscale(textPage(textRng))});
+
+  Rng photoRng(2);
+  pages.push_back({"02_text_photo", textAndPhotoPage(photoRng)});
+
+  Rng skewRng(3);
+  pages.push_back({"03_skewed", toGrayscale(textPage(skewRng, 3.0))});
+
+  Rng curvedRng(4);
+  pages.push_back({"04_curved", toGrayscale(textPage(curvedRng, 0.0, 24.0))});
+
+  Rng bordersRng(5);
+  QImage bordered(textPage(bordersRng, -1.2));
+  drawScannerBorders(bordered, bordersRng);
+  pages.push_back({"05_dark_borders", toGrayscale(bordered)});
+
+  Rng spreadRng(6);
+  pages.push_back({"06_two_page_spread", toGrayscale(twoPageSpread(spreadRng))});
+
+  Rng rotatedRng(7);
+  pages.push_back({"07_rotated", toGrayscale(textPage(rotatedRng).transformed(QTransform().rotate(90)))});
+
+  return pages;
+}
+
+QStringList writeSyntheticPageCorpus(const QString& dir) {
+  if (!QDir().mkpath(dir)) {
+    return {};
+  }
+
+  const int dotsPerMeter = static_cast<int>(std::lround(DPI / 0.0254));
+  QStringList files;
+  for (SyntheticPage& page : renderSyntheticPageCorpus()) {
+    page.image.setDotsPerMeterX(dotsPerMeter);
+    page.image.setDotsPerMeterY(dotsPerMeter);
+
+    const QString filePath = QDir(dir).absoluteFilePath(page.name + ".png");
+    QImageWriter writer(filePath, "png");
+    if (!writer.write(page.image)) {
+      return {};
+    }
+    files.push_back(filePath);
+  }
+  return files;
+}
+}  // namespace Tests
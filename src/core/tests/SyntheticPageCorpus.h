@@ -0,0 +1,36 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#ifndef SCANTAILOR_CORE_TESTS_SYNTHETICPAGECORPUS_H_
+#define SCANTAILOR_CORE_TESTS_SYNTHETICPAGECORPUS_H_
+
+#include <QImage>
+#include <QString>
+#include <QStringList>
+#include <vector>
+
+namespace Tests {
+struct SyntheticPage {
+  QString name;
+  QImage image;
+};
+
+/**
+ * \brief Renders a small set of scan-like pages covering the cases the
+ *        processing stages have to deal with.
+ *
+ * Text is rendered as glyph-shaped blocks rather than with a font, so the
+ * result doesn't depend on the fonts installed.  The pages are generated
+ * from fixed seeds and are the same on every run.
+ */
+std::vector<SyntheticPage> renderSyntheticPageCorpus();
+
+/**
+ * \brief Renders the corpus into \p dir as PNG files.
+ *
+ * \return The absolute paths of the written files, or an empty list on failure.
+ */
+QStringList writeSyntheticPageCorpus(const QString& dir);
+}  // namespace Tests
+
+#endif  // ifndef SCANTAILOR_CORE_TESTS_SYNTHETICPAGECORPUS_H_
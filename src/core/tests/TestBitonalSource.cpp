@@ -0,0 +1,228 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+// Checks that 1-bit originals are kept as binary images by FilterData, and
+// that what gets analyzed and output stays close to what the grayscale route gives.
+
+#include <BinaryImage.h>
+#include <DistortionModel.h>
+#include <Dpi.h>
+#include <GrayImage.h>
+#include <Grayscale.h>
+#include <Morphology.h>
+#include <RasterOp.h>
+
+#include <QImage>
+#include <QPolygonF>
+#include <QRect>
+#include <QRectF>
+#include <QSize>
+#include <QTemporaryDir>
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+
+#include "FilterData.h"
+#include "ImageId.h"
+#include "ImageLoader.h"
+#include "ImageSettings.h"
+#include "LoadFileTask.h"
+#include "NullTaskStatus.h"
+#include "PageId.h"
+#include "TiffWriter.h"
+#include "ZoneSet.h"
+#include "filters/output/ColorParams.h"
+#include "filters/output/DepthPerception.h"
+#include "filters/output/OutputGenerator.h"
+#include "filters/output/Settings.h"
+
+namespace Tests {
+using namespace imageproc;
+
+namespace {
+// 300 DPI in dots per meter.
+const int DPM_300 = 11811;
+
+/**
+ * Something like a page of text, 4 x 5.33 inches at 300 DPI.
+ */
+QImage bitonalScan() {
+  BinaryImage page(QSize(1200, 1600), WHITE);
+  for (int y = 100; y < 1500; y += 40) {
+    for (int x = 100 + (y % 3) * 10; x < 1080; x += 60) {
+      page.fill(QRect(x, y, 45, 24), BLACK);
+    }
+  }
+  QImage image(page.toQImage());
+  image.setDotsPerMeterX(DPM_300);
+  image.setDotsPerMeterY(DPM_300);
+  return image;
+}
+
+double meanAbsDifference(const GrayImage& img1, const GrayImage& img2) {
+  BOOST_REQUIRE(img1.size() == img2.size());
+  double sum = 0;
+  for (int y = 0; y < img1.height(); ++y) {
+    const uint8_t* line1 = img1.data() + y * img1.stride();
+    const uint8_t* line2 = img2.data() + y * img2.stride();
+    for (int x = 0; x < img1.width(); ++x) {
+      sum += std::abs(int(line1[x]) - int(line2[x]));
+    }
+  }
+  return sum / (img1.width() * img1.height());
+}
+
+/**
+ * Runs the B&W output of \p scan, slightly rotated as after deskewing.
+ * A 1-bit \p scan takes the bitonal route, anything else the gray one.
+ */
+BinaryImage renderBlackAndWhite(const QImage& scan, const output::BlackWhiteOptions& options) {
+  const PageId pageId(ImageId(QStringLiteral("/tmp/bitonal-output.tif")));
+  auto settings = std::make_shared<output::Settings>();
+  output::ColorParams colorParams;
+  colorParams.setColorMode(output::BLACK_AND_WHITE);
+  colorParams.setBlackWhiteOptions(options);
+  settings->setColorParams(pageId, colorParams);
+
+  const FilterData data(scan);
+  ImageTransformation xform(data.xform());
+  xform.setPostRotation(1.5);
+  xform.postScaleToDpi(Dpi(300, 300));
+
+  const output::OutputGenerator generator(xform, QPolygonF(QRectF(60, 60, 1080, 1480)));
+  ZoneSet pictureZones;
+  const ZoneSet fillZones;
+  dewarping::DistortionModel distortionModel;
+  const std::unique_ptr<output::OutputImage> outputImage
+      = generator.process(NullTaskStatus(), FilterData(data, xform), pictureZones, fillZones, distortionModel,
+                          output::DepthPerception(), nullptr, nullptr, nullptr, pageId, settings);
+  BOOST_REQUIRE(outputImage != nullptr);
+  return BinaryImage(outputImage->toImage());
+}
+
+/**
+ * Checks that the two routes mostly disagree along glyph edges: a pixel being
+ * on either side of an edge is rounding, a blob of differences is not.
+ */
+void checkCloseToGrayRoute(const output::BlackWhiteOptions& options) {
+  const QImage scan(bitonalScan());
+  const BinaryImage bitonal(renderBlackAndWhite(scan, options));
+  const BinaryImage gray(renderBlackAndWhite(scan.convertToFormat(QImage::Format_Grayscale8), options));
+  BOOST_REQUIRE(bitonal.size() == gray.size());
+  BOOST_REQUIRE(bitonal.countBlackPixels() > 0);
+
+  BinaryImage difference(bitonal);
+  rasterOp<RopXor<RopSrc, RopDst>>(difference, gray);
+  const double differentShare = double(difference.countBlackPixels()) / (difference.width() * difference.height());
+  BOOST_TEST_MESSAGE("pixels differing from the gray route: " << differentShare * 100 << "%");
+  BOOST_CHECK_LT(differentShare, 0.03);
+
+  // Rounded glyph corners may leave a few thicker spots, but nothing like a missing glyph.
+  const BinaryImage thickDifference(erodeBrick(difference, QSize(3, 3), WHITE));
+  BOOST_CHECK_LT(double(thickDifference.countBlackPixels()) / (difference.width() * difference.height()), 0.001);
+}
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(BitonalSourceTestSuite)
+
+BOOST_AUTO_TEST_CASE(test_only_black_and_white_originals_are_bitonal) {
+  const QImage scan(bitonalScan());
+  BOOST_CHECK(FilterData(scan).isBitonal());
+  BOOST_CHECK(FilterData(scan.convertToFormat(QImage::Format_MonoLSB)).isBitonal());
+  BOOST_CHECK(!FilterData(scan.convertToFormat(QImage::Format_Grayscale8)).isBitonal());
+  BOOST_CHECK(FilterData(scan.convertToFormat(QImage::Format_Grayscale8)).binaryImage().isNull());
+
+  // Two colors that aren't black and white.
+  QImage tinted(scan);
+  tinted.setColor(0, qRgb(255, 0, 0));
+  tinted.setColor(1, qRgb(0, 0, 255));
+  BOOST_CHECK(!FilterData(tinted).isBitonal());
+}
+
+BOOST_AUTO_TEST_CASE(test_loaded_bitonal_files_stay_bitonal) {
+  QTemporaryDir dir;
+  BOOST_REQUIRE(dir.isValid());
+  const QImage scan(bitonalScan());
+  const QString bitonalPath(dir.filePath("bitonal.tif"));
+  BOOST_REQUIRE(TiffWriter::writeImage(bitonalPath, scan));
+
+  QImage image(ImageLoader::load(bitonalPath));
+  BOOST_REQUIRE(!image.isNull());
+  LoadFileTask::convertToSupportedFormat(image);
+  const FilterData data(image);
+  BOOST_CHECK(data.isBitonal());
+  BOOST_CHECK(data.binaryImage() == BinaryImage(scan));
+
+  // Gray and tinted pages are still converted to grayscale.
+  const QString grayPath(dir.filePath("gray.tif"));
+  BOOST_REQUIRE(TiffWriter::writeImage(grayPath, scan.convertToFormat(QImage::Format_Grayscale8)));
+  QImage gray(ImageLoader::load(grayPath));
+  LoadFileTask::convertToSupportedFormat(gray);
+  BOOST_CHECK(!FilterData(gray).isBitonal());
+  BOOST_CHECK(gray.isGrayscale());
+
+  QImage tinted(scan);
+  tinted.setColor(0, qRgb(255, 0, 0));
+  tinted.setColor(1, qRgb(0, 0, 255));
+  LoadFileTask::convertToSupportedFormat(tinted);
+  BOOST_CHECK(!FilterData(tinted).isBitonal());
+  BOOST_CHECK_EQUAL(tinted.depth(), 8);
+}
+
+BOOST_AUTO_TEST_CASE(test_gray_image_is_made_on_demand) {
+  const QImage scan(bitonalScan());
+  const FilterData data(scan);
+  BOOST_CHECK(data.binaryImage() == BinaryImage(scan));
+  BOOST_CHECK(data.grayImage() == GrayImage(toGrayscale(scan)));
+
+  // Copies share it.
+  const FilterData copy(data, data.xform());
+  BOOST_CHECK(&copy.grayImage() == &data.grayImage());
+}
+
+BOOST_AUTO_TEST_CASE(test_black_on_white) {
+  const FilterData data(bitonalScan());
+  BOOST_CHECK(data.binaryImageBlackOnWhite() == data.binaryImage());
+
+  FilterData inverted(data);
+  inverted.updateImageParams(ImageSettings::PageParams(BinaryThreshold(128), false));
+  BOOST_CHECK(inverted.binaryImageBlackOnWhite() == data.binaryImage().inverted());
+}
+
+BOOST_AUTO_TEST_CASE(test_150dpi_image_is_close_to_gray_route) {
+  const QImage scan(bitonalScan());
+  const GrayImage bitonal(FilterData(scan).grayImage150dpi());
+  const GrayImage gray(FilterData(scan.convertToFormat(QImage::Format_Grayscale8)).grayImage150dpi());
+  BOOST_REQUIRE(bitonal.size() == QSize(600, 800));
+
+  const double difference = meanAbsDifference(bitonal, gray);
+  BOOST_TEST_MESSAGE("mean difference from the gray route: " << difference << " gray levels");
+  BOOST_CHECK_LT(difference, 2.0);
+}
+
+BOOST_AUTO_TEST_CASE(test_rotated_output_is_close_to_gray_route) {
+  checkCloseToGrayRoute(output::BlackWhiteOptions());
+}
+
+// The bitonal route has nothing to threshold, so it ignores the threshold
+// adjustment and the binarization method. On a 1-bit page those only used to
+// move pixels along the edges, which the check above tolerates.
+BOOST_AUTO_TEST_CASE(test_threshold_settings_are_irrelevant_to_bitonal_pages) {
+  for (const int adjustment : {-30, 30}) {
+    BOOST_TEST_MESSAGE("threshold adjustment " << adjustment);
+    output::BlackWhiteOptions options;
+    options.setThresholdAdjustment(adjustment);
+    checkCloseToGrayRoute(options);
+  }
+  for (const output::BinarizationMethod method : {output::T_SAUVOLA, output::T_WOLF}) {
+    BOOST_TEST_MESSAGE("binarization method " << method);
+    output::BlackWhiteOptions options;
+    options.setBinarizationMethod(method);
+    checkCloseToGrayRoute(options);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+}  // namespace Tests
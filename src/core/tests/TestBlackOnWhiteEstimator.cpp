@@ -0,0 +1,120 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include <BinaryImage.h>
+#include <BinaryThreshold.h>
+#include <GrayImage.h>
+
+#include <QImage>
+#include <QPainter>
+#include <QString>
+#include <boost/test/unit_test.hpp>
+
+#include "BlackOnWhiteEstimator.h"
+#include "Dpi.h"
+#include "ImageTransformation.h"
+#include "NullTaskStatus.h"
+#include "SyntheticPageCorpus.h"
+
+namespace Tests {
+using namespace imageproc;
+
+namespace {
+const Dpi CORPUS_DPI(200, 200);
+
+QImage corpusPage(const QString& name) {
+  for (const SyntheticPage& page : renderSyntheticPageCorpus()) {
+    if (page.name == name) {
+      return page.image;
+    }
+  }
+  return QImage();
+}
+
+GrayImage inverted(const QImage& image) {
+  return GrayImage(image).inverted();
+}
+
+/**
+ * The upper half of a text page covered by a dark photo.
+ */
+GrayImage pageWithDarkPhoto() {
+  QImage image(corpusPage("01_text").convertToFormat(QImage::Format_Grayscale8));
+  QPainter painter(&image);
+  painter.fillRect(QRect(0, 0, image.width(), image.height() / 2), QColor(35, 35, 35));
+  return GrayImage(image);
+}
+
+bool legacyIsBlackOnWhite(const GrayImage& image, const ImageTransformation& xform) {
+  const NullTaskStatus status;
+  return BlackOnWhiteEstimator::isBlackOnWhite(image, xform.resultingPreCropArea())
+         || BlackOnWhiteEstimator::isBlackOnWhiteRefining(image, xform, status);
+}
+
+/**
+ * Checks the tiered estimation against the previous one and returns
+ * whether it had to fall back to it.
+ */
+bool checkSameAsLegacy(const GrayImage& image, const bool expected) {
+  const ImageTransformation xform(QRectF(image.rect()), CORPUS_DPI);
+  const NullTaskStatus status;
+
+  const BlackOnWhiteEstimator::Statistics before(BlackOnWhiteEstimator::statistics());
+  const bool actual = BlackOnWhiteEstimator::isBlackOnWhite(image, xform, status);
+  const BlackOnWhiteEstimator::Statistics after(BlackOnWhiteEstimator::statistics());
+
+  BOOST_CHECK_EQUAL(actual, expected);
+  BOOST_CHECK_EQUAL(actual, legacyIsBlackOnWhite(image, xform));
+  BOOST_CHECK_EQUAL(after.numEstimates - before.numEstimates, 1);
+  return after.numFallbacks != before.numFallbacks;
+}
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(BlackOnWhiteEstimatorTestSuite)
+
+BOOST_AUTO_TEST_CASE(test_normal_pages_are_decided_quickly) {
+  for (const QString& name : {"01_text", "03_skewed", "04_curved", "05_dark_borders"}) {
+    BOOST_TEST_MESSAGE("page " << name.toStdString());
+    BOOST_CHECK(!checkSameAsLegacy(GrayImage(corpusPage(name)), true));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_inverted_pages) {
+  for (const QString& name : {"01_text", "03_skewed"}) {
+    const bool fallback = checkSameAsLegacy(inverted(corpusPage(name)), false);
+    BOOST_TEST_MESSAGE("page " << name.toStdString() << ", fallback: " << fallback);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_mixed_pages) {
+  const bool photoFallback = checkSameAsLegacy(GrayImage(corpusPage("02_text_photo")), true);
+  const bool darkPhotoFallback = checkSameAsLegacy(pageWithDarkPhoto(), true);
+  BOOST_TEST_MESSAGE("fallback for the text and photo page: " << photoFallback);
+  BOOST_TEST_MESSAGE("fallback for the page with a dark photo: " << darkPhotoFallback);
+}
+
+BOOST_AUTO_TEST_CASE(test_bitonal_pages) {
+  const NullTaskStatus status;
+  for (const QString& name : {"01_text", "03_skewed"}) {
+    BOOST_TEST_MESSAGE("page " << name.toStdString());
+    const BinaryImage page(GrayImage(corpusPage(name)), BinaryThreshold(128));
+    const ImageTransformation xform(QRectF(page.rect()), CORPUS_DPI);
+
+    const BlackOnWhiteEstimator::Statistics before(BlackOnWhiteEstimator::statistics());
+    BOOST_CHECK(BlackOnWhiteEstimator::isBlackOnWhite(page, xform, status));
+    const BlackOnWhiteEstimator::Statistics after(BlackOnWhiteEstimator::statistics());
+    BOOST_CHECK_EQUAL(after.numEstimates - before.numEstimates, 1);
+    BOOST_CHECK_EQUAL(after.numFallbacks, before.numFallbacks);
+
+    BOOST_CHECK(!BlackOnWhiteEstimator::isBlackOnWhite(page.inverted(), xform, status));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_fallback_rate) {
+  const BlackOnWhiteEstimator::Statistics stats(BlackOnWhiteEstimator::statistics());
+  BOOST_TEST_MESSAGE("fallbacks: " << stats.numFallbacks << " of " << stats.numEstimates << " estimates");
+  BOOST_CHECK_LE(stats.numFallbacks, stats.numEstimates);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+}  // namespace Tests
@@ -0,0 +1,168 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+// Compares the shared border shadow detection and the shared 150 DPI analysis
+// image with the code page_split, page_box and select_content used to run
+// on their own.
+
+#include <BinaryImage.h>
+#include <Connectivity.h>
+#include <GrayImage.h>
+#include <Grayscale.h>
+#include <Morphology.h>
+#include <RasterOp.h>
+#include <SeedFill.h>
+#include <Transform.h>
+
+#include <QColor>
+#include <QImage>
+#include <QPainter>
+#include <QRectF>
+#include <QTransform>
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+
+#include "BorderShadows.h"
+#include "Dpi.h"
+#include "FilterData.h"
+#include "ImageTransformation.h"
+#include "NullTaskStatus.h"
+#include "filters/page_box/PageFinder.h"
+#include "filters/page_split/LayoutType.h"
+#include "filters/page_split/PageLayout.h"
+#include "filters/page_split/PageLayoutEstimator.h"
+#include "filters/select_content/ContentBoxFinder.h"
+
+namespace Tests {
+using namespace imageproc;
+
+namespace {
+const int DOTS_PER_METER_300DPI = 11811;
+
+/**
+ * A page with lines of text blocks lying on a dark scanner lid, at 300 DPI.
+ * With \p twoPages, it's a two page spread with a blank gutter in the middle.
+ */
+QImage makeScan(const bool twoPages, const double angle) {
+  const int pageWidth = 1400;
+  const int width = twoPages ? 2 * pageWidth + 200 : pageWidth + 200;
+  QImage image(width, 2200, QImage::Format_Grayscale8);
+  image.fill(QColor(30, 30, 30));
+  image.setDotsPerMeterX(DOTS_PER_METER_300DPI);
+  image.setDotsPerMeterY(DOTS_PER_METER_300DPI);
+  {
+    QPainter painter(&image);
+    painter.translate(0.5 * image.width(), 0.5 * image.height());
+    painter.rotate(angle);
+    painter.translate(-0.5 * image.width(), -0.5 * image.height());
+    painter.fillRect(QRect(100, 80, image.width() - 200, image.height() - 160), QColor(235, 235, 235));
+
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(QColor(20, 20, 20));
+    for (int page = 0; page < (twoPages ? 2 : 1); ++page) {
+      const int left = 100 + page * pageWidth;
+      for (int y = 300; y < image.height() - 300; y += 50) {
+        for (int x = left + 200, word = 0; x < left + pageWidth - 300; ++word) {
+          const int wordWidth = 40 + (word * 29 + y) % 90;
+          painter.drawRect(x, y, wordWidth, 22);
+          x += wordWidth + 24;
+        }
+      }
+    }
+  }
+  return image;
+}
+
+BinaryImage legacyShadows(const BinaryImage& image) {
+  BinaryImage horSeed(openBrick(image, QSize(200, 14), BLACK));
+  BinaryImage verSeed(openBrick(image, QSize(14, 300), BLACK));
+  rasterOp<RopOr<RopSrc, RopDst>>(horSeed, verSeed);
+  const BinaryImage dilated(dilateBrick(image, QSize(3, 3)));
+  return seedFill(horSeed, dilated, CONN8);
+}
+
+GrayImage legacyGray150(const FilterData& data) {
+  ImageTransformation xform150dpi(data.xform());
+  xform150dpi.preScaleToDpi(Dpi(150, 150));
+
+  const GrayImage dataGrayImage = data.grayImageBlackOnWhite();
+  const uint8_t darkestGrayLevel = imageproc::darkestGrayLevel(dataGrayImage);
+  const QColor outsideColor(darkestGrayLevel, darkestGrayLevel, darkestGrayLevel);
+  return transformToGray(dataGrayImage, xform150dpi.transform(), xform150dpi.resultingRect().toRect(),
+                         OutsidePixels::assumeColor(outsideColor));
+}
+
+FilterData makeDeskewedData(const QImage& scan, const double angle) {
+  const FilterData loaded(scan);
+  ImageTransformation xform(loaded.xform());
+  xform.setPostRotation(angle);
+  return FilterData(loaded, xform);
+}
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(BorderShadowsTestSuite)
+
+BOOST_AUTO_TEST_CASE(test_shadows_match_legacy) {
+  for (const double angle : {0.0, 1.3}) {
+    const GrayImage gray150(makeDeskewedData(makeScan(false, angle), 0.0).grayImage150dpi());
+    const BinaryImage bw150(gray150, BinaryThreshold::otsuThreshold(gray150));
+    BOOST_REQUIRE(!bw150.isNull());
+
+    const BinaryImage shadows(findBorderShadows(bw150, NullTaskStatus()));
+    BOOST_CHECK(shadows == legacyShadows(bw150));
+    BOOST_CHECK(shadows.countBlackPixels() > 0);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_gray150_matches_legacy) {
+  const FilterData data(makeDeskewedData(makeScan(false, 0.7), -0.7));
+  const GrayImage gray150(data.grayImage150dpi());
+  BOOST_CHECK(gray150 == legacyGray150(data));
+
+  // Copies share the result, while a new transformation gets a new one.
+  const FilterData copy(data);
+  BOOST_CHECK(copy.grayImage150dpi().data() == gray150.data());
+
+  ImageTransformation xform(data.xform());
+  xform.setPostRotation(0.0);
+  const FilterData transformed(data, xform);
+  BOOST_CHECK(transformed.grayImage150dpi() == legacyGray150(transformed));
+  BOOST_CHECK(transformed.grayImage150dpi().size() != gray150.size());
+}
+
+BOOST_AUTO_TEST_CASE(test_content_box_does_not_depend_on_page_box_order) {
+  const QImage scan(makeScan(false, 0.5));
+  const NullTaskStatus status;
+
+  const FilterData coldData(makeDeskewedData(scan, -0.5));
+  const QRectF pageRect(coldData.xform().resultingRect());
+  const QRectF coldContentBox(
+      select_content::ContentBoxFinder::findContentBox(status, coldData, pageRect, nullptr, nullptr));
+
+  // The page box detection runs first in the pipeline and leaves the analysis image behind.
+  const FilterData warmData(makeDeskewedData(scan, -0.5));
+  const QRectF pageBox(page_box::PageFinder::findPageBox(status, warmData, true, QSizeF(), 0.1, nullptr));
+  const QRectF warmContentBox(
+      select_content::ContentBoxFinder::findContentBox(status, warmData, pageRect, nullptr, nullptr));
+
+  BOOST_REQUIRE(!coldContentBox.isEmpty());
+  BOOST_CHECK(warmContentBox == coldContentBox);
+  BOOST_CHECK(pageBox.contains(warmContentBox.center()));
+}
+
+BOOST_AUTO_TEST_CASE(test_split_line_stays_in_the_gutter) {
+  const QImage scan(makeScan(true, 0.0));
+  const FilterData data(scan);
+
+  const page_split::PageLayout layout(page_split::PageLayoutEstimator::estimatePageLayout(
+      page_split::TWO_PAGES, scan, data.xform(), BinaryThreshold::otsuThreshold(GrayImage(scan))));
+  BOOST_REQUIRE_EQUAL(layout.type(), page_split::PageLayout::TWO_PAGES);
+
+  // The text of the left page ends before x = 1200 and the right one starts after x = 1700.
+  const QLineF cutter(layout.inscribedCutterLine(0));
+  BOOST_CHECK_GT(std::min(cutter.x1(), cutter.x2()), 1200.0);
+  BOOST_CHECK_LT(std::max(cutter.x1(), cutter.x2()), 1700.0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+}  // namespace Tests
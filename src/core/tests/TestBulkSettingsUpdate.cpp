@@ -0,0 +1,239 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+// Applying a change to a whole book must give every page the same params
+// as the per-page setters would, and report the pages that actually changed
+// at once, so that the thumbnails get a single invalidation for just those.
+// The settings lock is counted by the output::Settings built for these tests,
+// see CountingOutputSettings.cpp.
+
+#include <QApplication>
+#include <QMetaObject>
+#include <QRectF>
+#include <QSignalSpy>
+#include <QSizeF>
+#include <QString>
+#include <boost/test/unit_test.hpp>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "CountingOutputSettings.h"
+#include "ImageId.h"
+#include "PageId.h"
+#include "PageRange.h"
+#include "PageSelectionAccessor.h"
+#include "PageSelectionProvider.h"
+#include "PageSequence.h"
+#include "filters/output/OptionsWidget.h"
+#include "filters/output/Settings.h"
+#include "filters/page_layout/Alignment.h"
+#include "filters/page_layout/Settings.h"
+#include "filters/select_content/Settings.h"
+
+namespace Tests {
+namespace {
+const int NUM_PAGES = 5000;
+
+PageId makePageId(const int index) {
+  return PageId(ImageId(QString("page%1.png").arg(index)));
+}
+
+std::set<PageId> makePages() {
+  std::set<PageId> pages;
+  for (int i = 0; i < NUM_PAGES; ++i) {
+    pages.insert(makePageId(i));
+  }
+  return pages;
+}
+
+void ensureApplication() {
+  static int argc = 1;
+  static char argv0[] = "test";
+  static char* argv[] = {argv0, nullptr};
+  if (!QCoreApplication::instance()) {
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+      qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    static QApplication app(argc, argv);
+  }
+}
+
+class NoSelectionProvider : public PageSelectionProvider {
+ public:
+  PageSequence allPages() const override { return PageSequence(); }
+
+  std::set<PageId> selectedPages() const override { return std::set<PageId>(); }
+
+  std::vector<PageRange> selectedRanges() const override { return std::vector<PageRange>(); }
+};
+
+output::ColorParams grayscaleColorParams() {
+  output::ColorParams colorParams;
+  colorParams.setColorMode(output::GRAYSCALE);
+  colorParams.setColorModeUserSet(true);
+  return colorParams;
+}
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(BulkSettingsUpdateTestSuite)
+
+BOOST_AUTO_TEST_CASE(test_bulk_update_reports_all_pages_at_once) {
+  const std::set<PageId> pages(makePages());
+  output::Settings settings;
+
+  // The result is what gets emitted as the one invalidateThumbnails() call.
+  const int locksBefore = outputSettingsLockCount();
+  const std::set<PageId> changed(
+      settings.applyBulkUpdate(pages, output::Settings::BulkUpdate().setDpi(Dpi(400, 400)).setDespeckleLevel(2.0)));
+  BOOST_CHECK_EQUAL(outputSettingsLockCount() - locksBefore, 1);
+  BOOST_CHECK(changed == pages);
+
+  int mismatches = 0;
+  for (const PageId& pageId : pages) {
+    const output::Params params(settings.getParams(pageId));
+    if ((params.outputDpi() != Dpi(400, 400)) || (params.despeckleLevel() != 2.0)) {
+      ++mismatches;
+    }
+  }
+  BOOST_CHECK_EQUAL(mismatches, 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_bulk_update_matches_per_page_setters) {
+  const std::set<PageId> pages(makePages());
+  output::Settings perPage;
+  output::Settings bulk;
+
+  const output::ColorParams colorParams(grayscaleColorParams());
+  const output::DepthPerception depthPerception(2.5);
+  int locksBefore = outputSettingsLockCount();
+  for (const PageId& pageId : pages) {
+    perPage.setColorParams(pageId, colorParams);
+    perPage.setDepthPerception(pageId, depthPerception);
+    perPage.setDpi(pageId, Dpi(600, 600));
+  }
+  BOOST_CHECK_EQUAL(outputSettingsLockCount() - locksBefore, 3 * NUM_PAGES);
+
+  locksBefore = outputSettingsLockCount();
+  bulk.applyBulkUpdate(pages, output::Settings::BulkUpdate()
+                                  .setColorParams(colorParams)
+                                  .setDepthPerception(depthPerception)
+                                  .setDpi(Dpi(600, 600)));
+  BOOST_CHECK_EQUAL(outputSettingsLockCount() - locksBefore, 1);
+
+  int mismatches = 0;
+  for (const PageId& pageId : pages) {
+    const output::Params expected(perPage.getParams(pageId));
+    const output::Params actual(bulk.getParams(pageId));
+    if ((expected.colorParams() != actual.colorParams()) || (expected.depthPerception() != actual.depthPerception())
+        || (expected.outputDpi() != actual.outputDpi()) || (expected.despeckleLevel() != actual.despeckleLevel())) {
+      ++mismatches;
+    }
+  }
+  BOOST_CHECK_EQUAL(mismatches, 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_changed_set_excludes_unaffected_pages) {
+  const std::set<PageId> pages(makePages());
+  output::Settings settings;
+
+  // Every tenth page already has the value being applied.
+  std::set<PageId> expectedChanged;
+  int index = 0;
+  for (const PageId& pageId : pages) {
+    if (index++ % 10 == 0) {
+      settings.setDpi(pageId, Dpi(400, 400));
+    } else {
+      settings.setDpi(pageId, Dpi(300, 300));
+      expectedChanged.insert(pageId);
+    }
+  }
+
+  const std::set<PageId> changed(settings.applyBulkUpdate(pages, output::Settings::BulkUpdate().setDpi(Dpi(400, 400))));
+  BOOST_CHECK_EQUAL(changed.size(), expectedChanged.size());
+  BOOST_CHECK(changed == expectedChanged);
+
+  // Applying the same change again touches nothing.
+  BOOST_CHECK(settings.applyBulkUpdate(pages, output::Settings::BulkUpdate().setDpi(Dpi(400, 400))).empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_options_widget_invalidates_thumbnails_once) {
+  ensureApplication();
+
+  const std::set<PageId> pages(makePages());
+  const auto settings = std::make_shared<output::Settings>();
+  output::OptionsWidget widget(settings, PageSelectionAccessor(std::make_shared<NoSelectionProvider>()));
+  QSignalSpy invalidations(&widget, SIGNAL(invalidateThumbnails(const std::set<PageId>&)));
+  BOOST_REQUIRE(invalidations.isValid());
+
+  // ChangeDpiDialog applied to the whole book.
+  const int locksBefore = outputSettingsLockCount();
+  BOOST_REQUIRE(QMetaObject::invokeMethod(&widget, "dpiChanged", Qt::DirectConnection,
+                                          Q_ARG(std::set<PageId>, pages), Q_ARG(Dpi, Dpi(400, 400))));
+  BOOST_CHECK_EQUAL(outputSettingsLockCount() - locksBefore, 1);
+  BOOST_REQUIRE_EQUAL(invalidations.count(), 1);
+  BOOST_CHECK(invalidations.front().front().value<std::set<PageId>>() == pages);
+
+  int mismatches = 0;
+  for (const PageId& pageId : pages) {
+    if (settings->getParams(pageId).outputDpi() != Dpi(400, 400)) {
+      ++mismatches;
+    }
+  }
+  BOOST_CHECK_EQUAL(mismatches, 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_page_layout_bulk_alignment) {
+  const std::set<PageId> pages(makePages());
+  page_layout::Settings perPage;
+  page_layout::Settings bulk;
+  const page_layout::Alignment alignment(page_layout::Alignment::BOTTOM, page_layout::Alignment::LEFT);
+
+  for (const PageId& pageId : pages) {
+    perPage.setPageAlignment(pageId, alignment);
+  }
+  bulk.setPageAlignment(pages, alignment);
+
+  int mismatches = 0;
+  for (const PageId& pageId : pages) {
+    if (bulk.getPageAlignment(pageId) != perPage.getPageAlignment(pageId)) {
+      ++mismatches;
+    }
+  }
+  BOOST_CHECK_EQUAL(mismatches, 0);
+  BOOST_CHECK(bulk.getAggregateHardSizeMM() == perPage.getAggregateHardSizeMM());
+}
+
+BOOST_AUTO_TEST_CASE(test_select_content_bulk_update) {
+  const std::set<PageId> pages(makePages());
+  select_content::Settings settings;
+
+  const PageId existingPage(makePageId(7));
+  select_content::Params existingParams((select_content::Dependencies()));
+  existingParams.setContentRect(QRectF(10.0, 10.0, 100.0, 100.0));
+  settings.setPageParams(existingPage, existingParams);
+
+  int updatesOfExisting = 0;
+  settings.updatePageParams(pages, [&](const select_content::Params* oldParams) {
+    select_content::Params params(oldParams ? *oldParams : select_content::Params(select_content::Dependencies()));
+    if (oldParams) {
+      ++updatesOfExisting;
+    }
+    params.setContentSizeMM(QSizeF(120.0, 180.0));
+    return params;
+  });
+
+  BOOST_CHECK_EQUAL(updatesOfExisting, 1);
+  int missing = 0;
+  for (const PageId& pageId : pages) {
+    const std::unique_ptr<select_content::Params> params(settings.getPageParams(pageId));
+    if (!params || (params->contentSizeMM() != QSizeF(120.0, 180.0))) {
+      ++missing;
+    }
+  }
+  BOOST_CHECK_EQUAL(missing, 0);
+  BOOST_CHECK(settings.getPageParams(existingPage)->contentRect() == QRectF(10.0, 10.0, 100.0, 100.0));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+}  // namespace Tests
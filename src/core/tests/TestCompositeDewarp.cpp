@@ -0,0 +1,232 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+// Checks that dewarping with the post-deskew rotation folded in puts things
+// where dewarping followed by a separate rotation does, and measures how much
+// sharper the single resampling keeps the output.
+
+#include <CylindricalSurfaceDewarper.h>
+#include <GrayImage.h>
+#include <RasterDewarper.h>
+#include <Transform.h>
+
+#include <QColor>
+#include <QImage>
+#include <QLineF>
+#include <QPointF>
+#include <QRectF>
+#include <QTransform>
+#include <algorithm>
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "Constants.h"
+
+namespace Tests {
+using namespace imageproc;
+using dewarping::CylindricalSurfaceDewarper;
+using dewarping::RasterDewarper;
+
+namespace {
+// A4 at 150 DPI.
+const QSize IMAGE_SIZE(1240, 1754);
+const QSize OUTPUT_SIZE(1000, 1400);
+const double DEPTH_PERCEPTION = 2.0;
+const double POST_DESKEW_ANGLE = 1.5;
+const int DOT_RADIUS = 5;
+
+const double CONTROL_POINTS[] = {0.2, 0.35, 0.5, 0.65, 0.8};
+
+std::vector<QPointF> bulgingLine(const QPointF& from, const QPointF& to, const double bulge) {
+  std::vector<QPointF> polyline;
+  const int numSegments = 40;
+  for (int i = 0; i <= numSegments; ++i) {
+    const double t = double(i) / numSegments;
+    polyline.push_back(QLineF(from, to).pointAt(t) + QPointF(0.0, bulge * std::sin(constants::PI * t)));
+  }
+  return polyline;
+}
+
+CylindricalSurfaceDewarper curvedPageDewarper() {
+  return CylindricalSurfaceDewarper(bulgingLine(QPointF(150, 210), QPointF(1100, 190), 70.0),
+                                    bulgingLine(QPointF(140, 1540), QPointF(1105, 1560), 35.0), DEPTH_PERCEPTION);
+}
+
+QRectF modelDomain() {
+  return QRectF(QPointF(0, 0), QSizeF(OUTPUT_SIZE));
+}
+
+/**
+ * The rotation the post-deskew stage would apply, see output::Utils::rotate().
+ */
+QTransform postDeskewRotation() {
+  const QPointF origin(QRectF(QPointF(0, 0), QSizeF(OUTPUT_SIZE)).center());
+  QTransform rotation;
+  rotation.translate(-origin.x(), -origin.y());
+  rotation *= QTransform().rotate(POST_DESKEW_ANGLE);
+  rotation *= QTransform().translate(origin.x(), origin.y());
+  return rotation;
+}
+
+/**
+ * Where the pixel of the final output at \p outputPt comes from in the original.
+ */
+QPointF outputToOriginal(const CylindricalSurfaceDewarper& dewarper, const QPointF& outputPt) {
+  const QPointF dewarpedPt(postDeskewRotation().inverted().map(outputPt));
+  const QRectF domain(modelDomain());
+  return dewarper.mapToWarpedSpace(QPointF((dewarpedPt.x() - domain.left()) / domain.width(),
+                                           (dewarpedPt.y() - domain.top()) / domain.height()));
+}
+
+QPointF controlPoint(const double u, const double v) {
+  return QPointF(u * OUTPUT_SIZE.width(), v * OUTPUT_SIZE.height());
+}
+
+QImage dottedPage(const std::vector<QPointF>& dots) {
+  GrayImage gray(IMAGE_SIZE);
+  gray.fill(0xff);
+  uint8_t* const data = gray.data();
+  const int stride = gray.stride();
+  for (const QPointF& dot : dots) {
+    // Pixel centers are at half-integer coordinates, so the dot is centered exactly at \p dot.
+    const int cx = static_cast<int>(dot.x());
+    const int cy = static_cast<int>(dot.y());
+    for (int y = cy - DOT_RADIUS - 1; y <= cy + DOT_RADIUS + 1; ++y) {
+      for (int x = cx - DOT_RADIUS - 1; x <= cx + DOT_RADIUS + 1; ++x) {
+        if (QLineF(dot, QPointF(x + 0.5, y + 0.5)).length() <= DOT_RADIUS) {
+          data[y * stride + x] = 0x00;
+        }
+      }
+    }
+  }
+  return gray.toQImage();
+}
+
+/**
+ * Text-like detail: one pixel wide strokes, a few pixels apart.
+ */
+QImage finelyDetailedPage() {
+  GrayImage gray(IMAGE_SIZE);
+  uint8_t* const data = gray.data();
+  const int stride = gray.stride();
+  for (int y = 0; y < IMAGE_SIZE.height(); ++y) {
+    for (int x = 0; x < IMAGE_SIZE.width(); ++x) {
+      const bool stroke = (x % 5 == 0) || ((y % 7 == 0) && ((x / 11) % 2 == 0));
+      data[y * stride + x] = stroke ? 0x20 : 0xf0;
+    }
+  }
+  return gray.toQImage();
+}
+
+QImage dewarpThenRotate(const QImage& src, const CylindricalSurfaceDewarper& dewarper) {
+  const QImage dewarped(RasterDewarper::dewarp(src, OUTPUT_SIZE, dewarper, modelDomain(), Qt::white));
+  return transform(dewarped, postDeskewRotation(), dewarped.rect(), OutsidePixels::assumeWeakColor(Qt::white));
+}
+
+QImage dewarpRotated(const QImage& src, const CylindricalSurfaceDewarper& dewarper) {
+  return RasterDewarper::dewarp(src, OUTPUT_SIZE, dewarper, modelDomain(), Qt::white, postDeskewRotation());
+}
+
+/**
+ * The centroid of the darkness around \p center.
+ */
+QPointF darkCentroid(const GrayImage& image, const QPointF& center) {
+  const int radius = 3 * DOT_RADIUS;
+  double sumWeight = 0;
+  double sumX = 0;
+  double sumY = 0;
+  for (int y = int(center.y()) - radius; y <= int(center.y()) + radius; ++y) {
+    for (int x = int(center.x()) - radius; x <= int(center.x()) + radius; ++x) {
+      const double weight = 255 - image.data()[y * image.stride() + x];
+      sumWeight += weight;
+      sumX += weight * (x + 0.5);
+      sumY += weight * (y + 0.5);
+    }
+  }
+  if (sumWeight == 0) {
+    return QPointF(-1000, -1000);
+  }
+  return QPointF(sumX / sumWeight, sumY / sumWeight);
+}
+
+/**
+ * Mean squared gradient over the middle of the image.  Blurring lowers it.
+ */
+double sharpness(const GrayImage& image) {
+  const int x0 = image.width() / 4;
+  const int x1 = image.width() * 3 / 4;
+  const int y0 = image.height() / 4;
+  const int y1 = image.height() * 3 / 4;
+  const uint8_t* const data = image.data();
+  const int stride = image.stride();
+  double sum = 0;
+  for (int y = y0; y < y1; ++y) {
+    for (int x = x0; x < x1; ++x) {
+      const double dx = double(data[y * stride + x + 1]) - data[y * stride + x];
+      const double dy = double(data[(y + 1) * stride + x]) - data[y * stride + x];
+      sum += dx * dx + dy * dy;
+    }
+  }
+  return sum / (double(x1 - x0) * (y1 - y0));
+}
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(CompositeDewarpTestSuite)
+
+BOOST_AUTO_TEST_CASE(test_identity_post_transform_changes_nothing) {
+  const CylindricalSurfaceDewarper dewarper(curvedPageDewarper());
+  const QImage src(finelyDetailedPage());
+  BOOST_CHECK(RasterDewarper::dewarp(src, OUTPUT_SIZE, dewarper, modelDomain(), Qt::white, QTransform())
+              == RasterDewarper::dewarp(src, OUTPUT_SIZE, dewarper, modelDomain(), Qt::white));
+}
+
+BOOST_AUTO_TEST_CASE(test_control_points_land_where_the_chain_puts_them) {
+  const CylindricalSurfaceDewarper dewarper(curvedPageDewarper());
+
+  std::vector<QPointF> dots;
+  for (const double u : CONTROL_POINTS) {
+    for (const double v : CONTROL_POINTS) {
+      dots.push_back(outputToOriginal(dewarper, controlPoint(u, v)));
+    }
+  }
+  const QImage src(dottedPage(dots));
+
+  const GrayImage composite(dewarpRotated(src, dewarper));
+  const GrayImage chain(dewarpThenRotate(src, dewarper));
+  BOOST_REQUIRE(composite.size() == OUTPUT_SIZE);
+  BOOST_REQUIRE(chain.size() == OUTPUT_SIZE);
+
+  double maxCompositeError = 0;
+  double maxDifference = 0;
+  for (const double u : CONTROL_POINTS) {
+    for (const double v : CONTROL_POINTS) {
+      const QPointF expected(controlPoint(u, v));
+      const QPointF compositePt(darkCentroid(composite, expected));
+      const QPointF chainPt(darkCentroid(chain, expected));
+      maxCompositeError = std::max(maxCompositeError, QLineF(expected, compositePt).length());
+      maxDifference = std::max(maxDifference, QLineF(chainPt, compositePt).length());
+    }
+  }
+  BOOST_TEST_MESSAGE("max control point error: " << maxCompositeError << " px, max difference from the chain: "
+                                                 << maxDifference << " px");
+  BOOST_CHECK_LT(maxCompositeError, 1.0);
+  BOOST_CHECK_LT(maxDifference, 1.0);
+}
+
+BOOST_AUTO_TEST_CASE(test_single_resampling_keeps_more_detail) {
+  const CylindricalSurfaceDewarper dewarper(curvedPageDewarper());
+  const QImage src(finelyDetailedPage());
+
+  const double dewarpedOnly
+      = sharpness(GrayImage(RasterDewarper::dewarp(src, OUTPUT_SIZE, dewarper, modelDomain(), Qt::white)));
+  const double composite = sharpness(GrayImage(dewarpRotated(src, dewarper)));
+  const double chain = sharpness(GrayImage(dewarpThenRotate(src, dewarper)));
+  BOOST_TEST_MESSAGE("mean squared gradient: " << dewarpedOnly << " dewarped without rotation, " << composite
+                                               << " rotated in one pass, " << chain << " rotated afterwards");
+  BOOST_CHECK_GT(composite, chain);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+}  // namespace Tests
@@ -0,0 +1,119 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+// Checks that the queries the content box trimming now makes give the same
+// answers as the image scans it used to make, on the synthetic page corpus.
+
+#include <BinaryImage.h>
+#include <BinaryThreshold.h>
+#include <GrayImage.h>
+#include <RasterOp.h>
+#include <SEDM.h>
+#include <SlicedHistogram.h>
+
+#include <QRect>
+#include <boost/test/unit_test.hpp>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "SyntheticPageCorpus.h"
+#include "filters/select_content/BlackPixelCounts.h"
+
+namespace Tests {
+using namespace imageproc;
+using select_content::BlackPixelCounts;
+
+namespace {
+std::vector<BinaryImage> binarizedCorpus() {
+  std::vector<BinaryImage> images;
+  for (const SyntheticPage& page : renderSyntheticPageCorpus()) {
+    const GrayImage gray(page.image);
+    images.emplace_back(gray, BinaryThreshold::otsuThreshold(gray));
+  }
+  return images;
+}
+
+QRect randomRect(std::mt19937& rng, const QSize& size) {
+  const int left = static_cast<int>(rng() % static_cast<uint32_t>(size.width()));
+  const int top = static_cast<int>(rng() % static_cast<uint32_t>(size.height()));
+  const int width = 1 + static_cast<int>(rng() % static_cast<uint32_t>(size.width() - left));
+  const int height = 1 + static_cast<int>(rng() % static_cast<uint32_t>(size.height() - top));
+  return QRect(left, top, width, height);
+}
+
+void checkSameHistograms(const SlicedHistogram& actual, const SlicedHistogram& expected) {
+  BOOST_REQUIRE_EQUAL(actual.size(), expected.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    if (actual[i] != expected[i]) {
+      BOOST_CHECK_EQUAL(actual[i], expected[i]);
+      return;
+    }
+  }
+}
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(ContentBoxTrimmingTestSuite)
+
+BOOST_AUTO_TEST_CASE(test_counts_match_image_scans) {
+  std::mt19937 rng(110);
+  for (const BinaryImage& image : binarizedCorpus()) {
+    const BlackPixelCounts counts(image);
+    BOOST_CHECK_EQUAL(counts.count(image.rect()), image.countBlackPixels());
+    BOOST_CHECK_EQUAL(counts.count(QRect()), 0);
+
+    for (int i = 0; i < 50; ++i) {
+      const QRect rect(randomRect(rng, image.size()));
+      BOOST_CHECK_EQUAL(counts.count(rect), image.countBlackPixels(rect));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_histograms_match_sliced_histogram) {
+  std::mt19937 rng(111);
+  for (const BinaryImage& image : binarizedCorpus()) {
+    const BlackPixelCounts counts(image);
+    for (int i = 0; i < 10; ++i) {
+      const QRect area(randomRect(rng, image.size()));
+      checkSameHistograms(counts.histogram(area, SlicedHistogram::ROWS),
+                          SlicedHistogram(image, area, SlicedHistogram::ROWS));
+      checkSameHistograms(counts.histogram(area, SlicedHistogram::COLS),
+                          SlicedHistogram(image, area, SlicedHistogram::COLS));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_cropped_distance_map_matches_full_one) {
+  for (const BinaryImage& image : binarizedCorpus()) {
+    // Trim the left quarter of the area, like ContentBoxFinder::trimLeft() would.
+    const QRect area(image.rect().adjusted(image.width() / 10, image.height() / 12, -image.width() / 9,
+                                           -image.height() / 11));
+    QRect newArea(area);
+    newArea.setLeft(area.left() + area.width() / 4);
+    QRect removedArea(area);
+    removedArea.setRight(newArea.left() - 1);
+
+    BinaryImage full(image.size(), WHITE);
+    rasterOp<RopSrc>(full, newArea, image, newArea.topLeft());
+    const SEDM fullMap(full, SEDM::DIST_TO_BLACK, SEDM::DIST_TO_NO_BORDERS);
+
+    BinaryImage cropped(area.size(), WHITE);
+    rasterOp<RopSrc>(cropped, newArea.translated(-area.topLeft()), image, newArea.topLeft());
+    const SEDM croppedMap(cropped, SEDM::DIST_TO_BLACK, SEDM::DIST_TO_NO_BORDERS);
+
+    int mismatches = 0;
+    for (int y = removedArea.top(); y <= removedArea.bottom(); ++y) {
+      const uint32_t* fullLine = fullMap.data() + y * fullMap.stride();
+      const uint32_t* croppedLine = croppedMap.data() + (y - area.top()) * croppedMap.stride() - area.left();
+      for (int x = removedArea.left(); x <= removedArea.right(); ++x) {
+        if (fullLine[x] != croppedLine[x]) {
+          ++mismatches;
+        }
+      }
+    }
+    BOOST_CHECK_EQUAL(mismatches, 0);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+}  // namespace Tests
@@ -0,0 +1,211 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+// Reads canned sysfs trees describing typical machines and checks that
+// CpuTopology and the thread placement policies built on it see the machine
+// the way the kernel describes it.
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QString>
+#include <QTemporaryDir>
+#include <boost/test/unit_test.hpp>
+#include <vector>
+
+#include "CpuTopology.h"
+#include "ThreadPlacement.h"
+
+namespace Tests {
+using CpuSet = CpuTopology::CpuSet;
+
+namespace {
+struct CpuFixture {
+  int id;
+  int package;
+  int core;
+  QString l3SharedList;  // Empty for no cache information.
+};
+
+struct NodeFixture {
+  int node;
+  QString cpuList;
+};
+
+/**
+ * A sysfs tree in a temporary directory, laid out like /sys/devices/system.
+ */
+class SysfsFixture {
+ public:
+  SysfsFixture(const QString& online, const std::vector<CpuFixture>& cpus, const std::vector<NodeFixture>& nodes) {
+    BOOST_REQUIRE(m_dir.isValid());
+    write("cpu/online", online);
+    for (const CpuFixture& cpu : cpus) {
+      const QString cpuDir(QString("cpu/cpu%1").arg(cpu.id));
+      write(cpuDir + "/topology/physical_package_id", QString::number(cpu.package));
+      write(cpuDir + "/topology/core_id", QString::number(cpu.core));
+      if (!cpu.l3SharedList.isEmpty()) {
+        // L1d, L1i and L2 are private, and come first, like on real hardware.
+        for (int index = 0; index < 3; ++index) {
+          const QString indexDir(QString("%1/cache/index%2").arg(cpuDir).arg(index));
+          write(indexDir + "/level", (index < 2) ? "1" : "2");
+          write(indexDir + "/shared_cpu_list", QString::number(cpu.id));
+        }
+        write(cpuDir + "/cache/index3/level", "3");
+        write(cpuDir + "/cache/index3/shared_cpu_list", cpu.l3SharedList);
+      }
+    }
+    for (const NodeFixture& node : nodes) {
+      write(QString("node/node%1/cpulist").arg(node.node), node.cpuList);
+    }
+  }
+
+  QString root() const { return m_dir.path(); }
+
+ private:
+  void write(const QString& relativePath, const QString& contents) {
+    const QString path(m_dir.filePath(relativePath));
+    BOOST_REQUIRE(QDir().mkpath(QFileInfo(path).absolutePath()));
+    QFile file(path);
+    BOOST_REQUIRE(file.open(QIODevice::WriteOnly | QIODevice::Text));
+    file.write((contents + "\n").toLatin1());
+  }
+
+  QTemporaryDir m_dir;
+};
+
+/**
+ * Two sockets with 4 cores and 2 threads per core each, enumerated the way
+ * Intel machines are: first threads of all cores, then their siblings.
+ * Every socket is a NUMA node with its own L3.
+ */
+SysfsFixture dualSocketSmt() {
+  std::vector<CpuFixture> cpus;
+  for (int id = 0; id < 16; ++id) {
+    const int package = (id / 4) % 2;
+    cpus.push_back({id, package, id % 4, (package == 0) ? "0-3,8-11" : "4-7,12-15"});
+  }
+  return SysfsFixture("0-15", cpus, {{0, "0-3,8-11"}, {1, "4-7,12-15"}});
+}
+
+/**
+ * One socket, one NUMA node, 8 cores with 2 threads each, split into
+ * two core complexes with an L3 each.
+ */
+SysfsFixture singleSocketTwoCcx() {
+  std::vector<CpuFixture> cpus;
+  for (int id = 0; id < 16; ++id) {
+    const int core = id % 8;
+    cpus.push_back({id, 0, core, (core < 4) ? "0-3,8-11" : "4-7,12-15"});
+  }
+  return SysfsFixture("0-15", cpus, {{0, "0-15"}});
+}
+
+/**
+ * CPU 1 offline, no caches or NUMA nodes exposed.
+ */
+SysfsFixture sparseVm() {
+  return SysfsFixture("0,2-3", {{0, 0, 0, ""}, {2, 0, 2, ""}, {3, 0, 3, ""}}, {});
+}
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(CpuTopologyTestSuite)
+
+BOOST_AUTO_TEST_CASE(test_cpu_list_parsing) {
+  BOOST_CHECK(CpuTopology::parseCpuList("0-3,8,10-11") == CpuSet({0, 1, 2, 3, 8, 10, 11}));
+  BOOST_CHECK(CpuTopology::parseCpuList("5") == CpuSet({5}));
+  BOOST_CHECK(CpuTopology::parseCpuList(" 4-5, 0 ") == CpuSet({0, 4, 5}));
+  BOOST_CHECK(CpuTopology::parseCpuList("0-2,1-3") == CpuSet({0, 1, 2, 3}));
+  BOOST_CHECK(CpuTopology::parseCpuList("").empty());
+  BOOST_CHECK(CpuTopology::parseCpuList("3-1").empty());
+  BOOST_CHECK(CpuTopology::parseCpuList("0-3,x").empty());
+  BOOST_CHECK(CpuTopology::parseCpuList("1-2-3").empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_dual_socket_smt) {
+  const SysfsFixture fixture(dualSocketSmt());
+  const CpuTopology topology(CpuTopology::probe(fixture.root()));
+  BOOST_REQUIRE_EQUAL(topology.cpus().size(), 16u);
+
+  const std::vector<CpuSet> cores(topology.physicalCores());
+  BOOST_REQUIRE_EQUAL(cores.size(), 8u);
+  BOOST_CHECK(cores[0] == CpuSet({0, 8}));
+  BOOST_CHECK(cores[4] == CpuSet({4, 12}));
+
+  const std::vector<CpuSet> l3Domains(topology.l3Domains());
+  BOOST_REQUIRE_EQUAL(l3Domains.size(), 2u);
+  BOOST_CHECK(l3Domains[0] == CpuSet({0, 1, 2, 3, 8, 9, 10, 11}));
+
+  const std::vector<CpuSet> nodes(topology.numaNodes());
+  BOOST_REQUIRE_EQUAL(nodes.size(), 2u);
+  BOOST_CHECK(nodes[1] == CpuSet({4, 5, 6, 7, 12, 13, 14, 15}));
+}
+
+BOOST_AUTO_TEST_CASE(test_single_socket_two_ccx) {
+  const SysfsFixture fixture(singleSocketTwoCcx());
+  const CpuTopology topology(CpuTopology::probe(fixture.root()));
+
+  BOOST_CHECK_EQUAL(topology.physicalCores().size(), 8u);
+  BOOST_CHECK_EQUAL(topology.numaNodes().size(), 1u);
+  const std::vector<CpuSet> l3Domains(topology.l3Domains());
+  BOOST_REQUIRE_EQUAL(l3Domains.size(), 2u);
+  BOOST_CHECK(l3Domains[1] == CpuSet({4, 5, 6, 7, 12, 13, 14, 15}));
+}
+
+BOOST_AUTO_TEST_CASE(test_missing_information) {
+  const SysfsFixture fixture(sparseVm());
+  const CpuTopology topology(CpuTopology::probe(fixture.root()));
+
+  BOOST_CHECK(topology.allCpus() == CpuSet({0, 2, 3}));
+  BOOST_CHECK_EQUAL(topology.physicalCores().size(), 3u);
+  // Grouped by package instead.
+  BOOST_CHECK_EQUAL(topology.l3Domains().size(), 1u);
+  BOOST_CHECK_EQUAL(topology.numaNodes().size(), 1u);
+
+  BOOST_CHECK(CpuTopology::probe(fixture.root() + "/does-not-exist").isNull());
+}
+
+BOOST_AUTO_TEST_CASE(test_placement_policies) {
+  const SysfsFixture fixture(dualSocketSmt());
+  const CpuTopology topology(CpuTopology::probe(fixture.root()));
+
+  const ThreadPlacement anyCpu(ThreadPlacementPolicy::ANY_CPU, topology);
+  BOOST_CHECK_EQUAL(anyCpu.maxThreads(), 0);
+
+  const ThreadPlacement physicalCores(ThreadPlacementPolicy::PHYSICAL_CORES, topology);
+  BOOST_REQUIRE_EQUAL(physicalCores.maxThreads(), 8);
+  for (const CpuSet& slot : physicalCores.slotCpus()) {
+    // Only the first thread of every core.
+    BOOST_REQUIRE_EQUAL(slot.size(), 1u);
+    BOOST_CHECK_LT(slot.front(), 8);
+  }
+
+  const ThreadPlacement singleNode(ThreadPlacementPolicy::SINGLE_NUMA_NODE, topology);
+  BOOST_REQUIRE_EQUAL(singleNode.maxThreads(), 8);
+  BOOST_CHECK(singleNode.slotCpus().front() == CpuSet({0, 1, 2, 3, 8, 9, 10, 11}));
+
+  const ThreadPlacement nodeLocal(ThreadPlacementPolicy::NODE_LOCAL_PAGES, topology);
+  BOOST_REQUIRE_EQUAL(nodeLocal.maxThreads(), 16);
+  // The first few threads are spread over both nodes.
+  BOOST_CHECK(nodeLocal.slotCpus()[0] == topology.numaNodes()[0]);
+  BOOST_CHECK(nodeLocal.slotCpus()[1] == topology.numaNodes()[1]);
+
+  const ThreadPlacement withoutTopology(ThreadPlacementPolicy::PHYSICAL_CORES, CpuTopology());
+  BOOST_CHECK_EQUAL(withoutTopology.maxThreads(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_policy_names_round_trip) {
+  for (const ThreadPlacementPolicy policy :
+       {ThreadPlacementPolicy::ANY_CPU, ThreadPlacementPolicy::PHYSICAL_CORES, ThreadPlacementPolicy::SINGLE_L3_DOMAIN,
+        ThreadPlacementPolicy::SINGLE_NUMA_NODE, ThreadPlacementPolicy::NODE_LOCAL_PAGES}) {
+    bool ok = false;
+    BOOST_CHECK(threadPlacementPolicyFromString(threadPlacementPolicyToString(policy), &ok) == policy);
+    BOOST_CHECK(ok);
+  }
+  bool ok = true;
+  BOOST_CHECK(threadPlacementPolicyFromString("numa", &ok) == ThreadPlacementPolicy::ANY_CPU);
+  BOOST_CHECK(!ok);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+}  // namespace Tests
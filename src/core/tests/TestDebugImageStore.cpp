@@ -0,0 +1,154 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include <BinaryImage.h>
+#include <DebugImageStore.h>
+
+#include <QColor>
+#include <QImage>
+#include <QImageReader>
+#include <QTemporaryDir>
+#include <boost/test/unit_test.hpp>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+namespace Tests {
+using namespace imageproc;
+
+namespace {
+QImage randomColorImage(const int width, const int height) {
+  QImage image(width, height, QImage::Format_RGB32);
+  for (int y = 0; y < height; ++y) {
+    auto* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+    for (int x = 0; x < width; ++x) {
+      line[x] = qRgb(std::rand() & 0xff, std::rand() & 0xff, std::rand() & 0xff);
+    }
+  }
+  return image;
+}
+
+QImage randomGrayscaleImage(const int width, const int height) {
+  QImage image(width, height, QImage::Format_Indexed8);
+  QVector<QRgb> palette(256);
+  for (int i = 0; i < 256; ++i) {
+    palette[i] = qRgb(i, i, i);
+  }
+  image.setColorTable(palette);
+  for (int y = 0; y < height; ++y) {
+    uchar* line = image.scanLine(y);
+    for (int x = 0; x < width; ++x) {
+      line[x] = static_cast<uchar>(std::rand() & 0xff);
+    }
+  }
+  return image;
+}
+
+BinaryImage randomBinaryImage(const int width, const int height) {
+  BinaryImage image(width, height, WHITE);
+  uint32_t* line = image.data();
+  const int wpl = image.wordsPerLine();
+  for (int y = 0; y < height; ++y, line += wpl) {
+    for (int x = 0; x < width; ++x) {
+      if (std::rand() & 1) {
+        line[x >> 5] |= uint32_t(1) << (31 - (x & 31));
+      }
+    }
+  }
+  return image;
+}
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(DebugImageStoreTestSuite)
+
+BOOST_AUTO_TEST_CASE(test_memory_budget_is_enforced) {
+  std::srand(0);
+  const qint64 budget = 256 * 1024;
+  DebugImageStore store(budget);
+
+  std::vector<QImage> originals;
+  std::vector<std::shared_ptr<const DebugImageHandle>> handles;
+  for (int i = 0; i < 60; ++i) {
+    const int width = 50 + std::rand() % 150;
+    const int height = 50 + std::rand() % 150;
+    switch (i % 3) {
+      case 0: {
+        const QImage image(randomColorImage(width, height));
+        originals.push_back(image);
+        handles.push_back(store.add(image));
+        break;
+      }
+      case 1: {
+        const QImage image(randomGrayscaleImage(width, height));
+        originals.push_back(image);
+        handles.push_back(store.add(image));
+        break;
+      }
+      default: {
+        const BinaryImage image(randomBinaryImage(width, height));
+        originals.push_back(image.toQImage());
+        handles.push_back(store.add(image));
+        break;
+      }
+    }
+  }
+  store.flush();
+
+  BOOST_CHECK_LE(store.bytesInMemory(), store.memoryBudget());
+  BOOST_CHECK_GT(store.numSpilledImages(), 0);
+
+  for (size_t i = 0; i < handles.size(); ++i) {
+    BOOST_TEST_CONTEXT("image " << i) {
+      BOOST_REQUIRE(handles[i]);
+      BOOST_CHECK(handles[i]->load() == originals[i]);
+    }
+  }
+
+  handles.clear();
+  BOOST_CHECK_EQUAL(store.bytesInMemory(), 0);
+  BOOST_CHECK_EQUAL(store.numSpilledImages(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_images_within_budget_stay_in_memory) {
+  std::srand(1);
+  DebugImageStore store(64 * 1024 * 1024);
+  const QImage image(randomColorImage(100, 100));
+  const auto handle = store.add(image);
+  store.flush();
+
+  BOOST_CHECK_EQUAL(store.numSpilledImages(), 0);
+  BOOST_CHECK_EQUAL(store.bytesInMemory(), image.sizeInBytes());
+  BOOST_CHECK(handle->load() == image);
+}
+
+BOOST_AUTO_TEST_CASE(test_oversized_image_is_spilled) {
+  std::srand(2);
+  DebugImageStore store(1024);
+  const BinaryImage image(randomBinaryImage(300, 200));
+  const auto handle = store.add(image);
+  store.flush();
+
+  BOOST_CHECK_EQUAL(store.numSpilledImages(), 1);
+  BOOST_CHECK_EQUAL(store.bytesInMemory(), 0);
+  BOOST_CHECK(handle->load() == image.toQImage());
+}
+
+BOOST_AUTO_TEST_CASE(test_png_export) {
+  std::srand(3);
+  QTemporaryDir dir;
+  BOOST_REQUIRE(dir.isValid());
+  const QString filePath = dir.filePath("debug.png");
+
+  DebugImageStore store(0);
+  const QImage image(randomColorImage(64, 48));
+  store.exportPng(store.add(image), filePath);
+  store.flush();
+
+  QImageReader reader(filePath, "png");
+  const QImage exported(reader.read());
+  BOOST_REQUIRE(!exported.isNull());
+  BOOST_CHECK(exported.convertToFormat(QImage::Format_RGB32) == image);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+}  // namespace Tests
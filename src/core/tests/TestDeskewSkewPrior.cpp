@@ -0,0 +1,231 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include <BinaryImage.h>
+#include <Constants.h>
+#include <SkewFinder.h>
+
+#include <QImage>
+#include <QPainter>
+#include <QString>
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <vector>
+
+#include "ImageId.h"
+#include "ImageMetadata.h"
+#include "PageId.h"
+#include "PageInfo.h"
+#include "PageSequence.h"
+#include "filters/deskew/Settings.h"
+
+namespace Tests {
+using deskew::Settings;
+using imageproc::BinaryImage;
+using imageproc::Skew;
+using imageproc::SkewFinder;
+
+namespace {
+PageId makePageId(const int index) {
+  return PageId(ImageId(QString("page%1.png").arg(index, 3, 10, QChar('0'))));
+}
+
+/**
+ * The pages in the given order of indices.
+ */
+PageSequence makePages(const std::vector<int>& indices) {
+  PageSequence pages;
+  for (const int index : indices) {
+    pages.append(PageInfo(makePageId(index), ImageMetadata(), 1, false, false));
+  }
+  return pages;
+}
+
+PageSequence makePages(const int count) {
+  std::vector<int> indices;
+  for (int i = 0; i < count; ++i) {
+    indices.push_back(i);
+  }
+  return makePages(indices);
+}
+
+/**
+ * The skew of the pages of a book drifts slowly as the pages are fed to the scanner.
+ */
+double bookPageSkew(const int index) {
+  return 0.6 * std::sin(index * 0.7) + 0.3;
+}
+
+/**
+ * A page of word-like blocks whose baselines follow y = base + tan(skew) * x,
+ * which is the clockwise skew reported by Skew::angle().
+ */
+BinaryImage makeBookPage(const int index, const double skewAngle) {
+  QImage image(1100, 1500, QImage::Format_RGB32);
+  image.fill(0xffffffff);
+  QPainter painter(&image);
+  painter.setPen(Qt::NoPen);
+  painter.setBrush(Qt::black);
+
+  const double slope = std::tan(skewAngle * constants::DEG2RAD);
+  int word = index * 7;
+  for (int base = 150; base < 1350; base += 30) {
+    for (int x = 120; x < 960; ++word) {
+      const int width = 18 + (word * 37 + base) % 50;
+      for (int dx = 0; dx < width; dx += 2) {
+        const int y = static_cast<int>(std::lround(base + slope * (x + dx)));
+        painter.drawRect(x + dx, y - 12, 2, 12);
+      }
+      x += width + 10;
+    }
+  }
+  return BinaryImage(image);
+}
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(DeskewSkewPriorTestSuite)
+
+BOOST_AUTO_TEST_CASE(test_no_prediction_without_enough_neighbors) {
+  Settings settings;
+  const PageSequence pages(makePages(10));
+  double skew = 0.0;
+  BOOST_CHECK(!settings.predictSkew(makePageId(5), pages, &skew));
+
+  settings.addDetectedSkew(makePageId(3), 1.0);
+  settings.addDetectedSkew(makePageId(4), 1.2);
+  BOOST_CHECK(!settings.predictSkew(makePageId(5), pages, &skew));
+
+  settings.addDetectedSkew(makePageId(7), 1.1);
+  BOOST_REQUIRE(settings.predictSkew(makePageId(5), pages, &skew));
+  BOOST_CHECK_CLOSE(skew, 1.1, 1e-9);
+}
+
+BOOST_AUTO_TEST_CASE(test_prediction_uses_nearest_neighbors) {
+  Settings settings;
+  const PageSequence pages(makePages(20));
+  for (int i = 0; i < 20; ++i) {
+    // The far pages must not influence the prediction.
+    settings.addDetectedSkew(makePageId(i), (i >= 7 && i <= 13) ? 0.5 : -3.0);
+  }
+
+  double skew = 0.0;
+  BOOST_REQUIRE(settings.predictSkew(makePageId(10), pages, &skew));
+  BOOST_CHECK_CLOSE(skew, 0.5, 1e-9);
+}
+
+BOOST_AUTO_TEST_CASE(test_neighbors_follow_page_order) {
+  // Page order that's the reverse of the file name order in the middle.
+  const PageSequence pages(makePages({0, 1, 2, 9, 8, 7, 6, 5, 4, 3}));
+  Settings settings;
+  settings.addDetectedSkew(makePageId(0), -2.0);
+  settings.addDetectedSkew(makePageId(1), -2.0);
+  settings.addDetectedSkew(makePageId(2), -2.0);
+  settings.addDetectedSkew(makePageId(8), 1.0);
+  settings.addDetectedSkew(makePageId(7), 1.0);
+  settings.addDetectedSkew(makePageId(6), 1.0);
+
+  // By file name, the nearest pages would be 6, 7, 8 and nothing after.
+  // In page order, they are 0, 1, 2 before it and 8, 7, 6 after it.
+  double skew = 0.0;
+  BOOST_CHECK(!settings.predictSkew(makePageId(9), pages, &skew));
+
+  // Page 5 comes after 6, 7, 8 in page order, so they are all on one side.
+  BOOST_REQUIRE(settings.predictSkew(makePageId(5), pages, &skew));
+  BOOST_CHECK_CLOSE(skew, 1.0, 1e-9);
+}
+
+BOOST_AUTO_TEST_CASE(test_prediction_excludes_the_page_itself) {
+  Settings settings;
+  const PageSequence pages(makePages(10));
+  settings.addDetectedSkew(makePageId(1), 1.0);
+  settings.addDetectedSkew(makePageId(2), 5.0);
+  settings.addDetectedSkew(makePageId(3), 1.0);
+  settings.addDetectedSkew(makePageId(4), 1.0);
+
+  double skew = 0.0;
+  BOOST_REQUIRE(settings.predictSkew(makePageId(2), pages, &skew));
+  BOOST_CHECK_CLOSE(skew, 1.0, 1e-9);
+}
+
+BOOST_AUTO_TEST_CASE(test_prediction_is_robust_to_an_outlier) {
+  Settings settings;
+  const PageSequence pages(makePages(10));
+  settings.addDetectedSkew(makePageId(1), 0.8);
+  settings.addDetectedSkew(makePageId(2), 1.0);
+  settings.addDetectedSkew(makePageId(3), -4.0);
+  settings.addDetectedSkew(makePageId(5), 1.2);
+  settings.addDetectedSkew(makePageId(6), 0.9);
+
+  double skew = 0.0;
+  BOOST_REQUIRE(settings.predictSkew(makePageId(4), pages, &skew));
+  BOOST_CHECK_CLOSE(skew, 0.9, 1e-9);
+}
+
+BOOST_AUTO_TEST_CASE(test_no_prediction_when_neighbors_disagree) {
+  Settings settings;
+  const PageSequence pages(makePages(10));
+  settings.addDetectedSkew(makePageId(1), -2.0);
+  settings.addDetectedSkew(makePageId(2), 2.0);
+  settings.addDetectedSkew(makePageId(4), -1.0);
+  settings.addDetectedSkew(makePageId(5), 3.0);
+
+  double skew = 0.0;
+  BOOST_CHECK(!settings.predictSkew(makePageId(3), pages, &skew));
+}
+
+BOOST_AUTO_TEST_CASE(test_prediction_is_cleared_with_the_page) {
+  Settings settings;
+  const PageSequence pages(makePages(10));
+  for (int i = 0; i < 3; ++i) {
+    settings.addDetectedSkew(makePageId(i), 1.0);
+  }
+  settings.clearPageParams(makePageId(0));
+
+  double skew = 0.0;
+  BOOST_CHECK(!settings.predictSkew(makePageId(3), pages, &skew));
+}
+
+BOOST_AUTO_TEST_CASE(test_book_prior_gives_same_angles_with_fewer_evaluations) {
+  const int numPages = 12;
+  Settings settings;
+  const PageSequence pages(makePages(numPages));
+  int totalFull = 0;
+  int totalGuided = 0;
+  for (int i = 0; i < numPages; ++i) {
+    const PageId pageId(makePageId(i));
+    const BinaryImage page(makeBookPage(i, bookPageSkew(i)));
+
+    SkewFinder fullFinder;
+    int fullEvaluated = 0;
+    const Skew fullSkew(fullFinder.findSkew(page, &fullEvaluated));
+    BOOST_REQUIRE(fullSkew.confidence() >= Skew::GOOD_CONFIDENCE);
+    BOOST_CHECK(std::abs(fullSkew.angle() - bookPageSkew(i)) < 0.15);
+
+    // This is what deskew::Task does.
+    SkewFinder guidedFinder;
+    double expectedSkew = 0.0;
+    const bool predicted = settings.predictSkew(pageId, pages, &expectedSkew);
+    if (predicted) {
+      guidedFinder.setExpectedSkew(expectedSkew);
+    }
+    int guidedEvaluated = 0;
+    const Skew guidedSkew(guidedFinder.findSkew(page, &guidedEvaluated));
+    if (guidedSkew.confidence() >= Skew::GOOD_CONFIDENCE) {
+      settings.addDetectedSkew(pageId, guidedSkew.angle());
+    } else {
+      BOOST_CHECK(guidedSkew.isConfidenceEstimated());
+    }
+
+    BOOST_CHECK_EQUAL(guidedSkew.angle(), fullSkew.angle());
+    BOOST_TEST_MESSAGE("page " << i << ": skew " << fullSkew.angle() << (predicted ? ", predicted" : "")
+                               << ", angles evaluated " << fullEvaluated << " -> " << guidedEvaluated);
+    totalFull += fullEvaluated;
+    totalGuided += guidedEvaluated;
+  }
+
+  BOOST_TEST_MESSAGE("total angles evaluated " << totalFull << " -> " << totalGuided);
+  BOOST_CHECK_LT(totalGuided, totalFull);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+}  // namespace Tests
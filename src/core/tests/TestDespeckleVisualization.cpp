@@ -0,0 +1,220 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+// The despeckle visualization is rendered in tiles, with distance fields
+// bounded to the neighbourhood of each tile.  The tiles must be identical
+// to the corresponding parts of the visualization computed over the whole page.
+
+#include <BinaryImage.h>
+#include <Dpi.h>
+#include <Dpm.h>
+#include <SEDM.h>
+
+#include <QImage>
+#include <QRect>
+#include <algorithm>
+#include <boost/test/unit_test.hpp>
+#include <cstdint>
+#include <random>
+
+#include "filters/output/DespeckleTileCache.h"
+#include "filters/output/DespeckleVisualization.h"
+
+namespace Tests {
+using namespace imageproc;
+using output::DespeckleTileCache;
+using output::DespeckleVisualization;
+
+namespace {
+// Deliberately not a multiple of the tile size.
+const QSize PAGE_SIZE(1100, 900);
+const Dpi DPI(300, 300);
+
+/**
+ * The way the visualization used to be built: one distance field for the whole page.
+ */
+QImage referenceVisualization(const QImage& output, const BinaryImage& speckles, const Dpi& dpi) {
+  QImage image(output.convertToFormat(QImage::Format_RGB32));
+  if (speckles.isNull()) {
+    return image;
+  }
+
+  const int w = image.width();
+  const int h = image.height();
+  auto* imageLine = (uint32_t*) image.bits();
+  const int imageStride = image.bytesPerLine() / 4;
+
+  const SEDM sedm(speckles, SEDM::DIST_TO_BLACK, SEDM::DIST_TO_NO_BORDERS);
+  const uint32_t* sedmLine = sedm.data();
+  const int sedmStride = sedm.stride();
+
+  const float radius = static_cast<float>(45.0 * std::max(dpi.horizontal(), dpi.vertical()) / 600);
+  const float sqRadius = radius * radius;
+
+  for (int y = 0; y < h; ++y) {
+    for (int x = 0; x < w; ++x) {
+      const uint32_t sqDist = sedmLine[x];
+      if (sqDist == 0) {
+        imageLine[x] = 0xffff0000;
+        continue;
+      } else if ((imageLine[x] & 0x00ffffff) == 0x0) {
+        continue;
+      }
+
+      const float alphaUpperBound = 0.7f;
+      const float noSpecklesOverlayAlpha = 0.3f;
+      const float scale = alphaUpperBound / sqRadius;
+      const float alpha = (sqDist == SEDM::INF_DIST) ? noSpecklesOverlayAlpha : alphaUpperBound - scale * sqDist;
+      if (alpha > 0) {
+        const float alpha2 = 1.0f - alpha;
+        const float r = 255 * alpha + qRed(imageLine[x]) * alpha2;
+        const float g = 0 * alpha + qGreen(imageLine[x]) * alpha2;
+        const float b = 0 * alpha + qBlue(imageLine[x]) * alpha2;
+        imageLine[x] = qRgb(int(r), int(g), int(b));
+      }
+    }
+    sedmLine += sedmStride;
+    imageLine += imageStride;
+  }
+  return image;
+}
+
+/**
+ * A light gray page with a few black bars of "text" and black speckles
+ * scattered over it, some of them touching the page edges.
+ */
+QImage makeOutput(const BinaryImage& speckles) {
+  QImage image(PAGE_SIZE, QImage::Format_RGB32);
+  image.fill(qRgb(0xf0, 0xe8, 0xe0));
+  for (int y = 100; y < PAGE_SIZE.height() - 100; y += 60) {
+    for (int x = 120; x < PAGE_SIZE.width() - 120; ++x) {
+      for (int dy = 0; dy < 20; ++dy) {
+        image.setPixel(x, y + dy, qRgb(0, 0, 0));
+      }
+    }
+  }
+  for (int y = 0; y < PAGE_SIZE.height(); ++y) {
+    for (int x = 0; x < PAGE_SIZE.width(); ++x) {
+      if (speckles.getPixel(x, y) == BLACK) {
+        image.setPixel(x, y, qRgb(0, 0, 0));
+      }
+    }
+  }
+
+  const Dpm dpm(DPI);
+  image.setDotsPerMeterX(dpm.horizontal());
+  image.setDotsPerMeterY(dpm.vertical());
+  return image;
+}
+
+BinaryImage makeSpeckles() {
+  BinaryImage speckles(PAGE_SIZE, WHITE);
+  std::mt19937 rng(115);
+  std::uniform_int_distribution<int> xDist(0, PAGE_SIZE.width() - 1);
+  std::uniform_int_distribution<int> yDist(0, PAGE_SIZE.height() - 1);
+  std::uniform_int_distribution<int> sizeDist(1, 4);
+  for (int i = 0; i < 40; ++i) {
+    speckles.fill(QRect(xDist(rng), yDist(rng), sizeDist(rng), sizeDist(rng)).intersected(speckles.rect()), BLACK);
+  }
+  speckles.fill(QRect(0, 0, 2, 2), BLACK);
+  speckles.fill(QRect(PAGE_SIZE.width() - 3, PAGE_SIZE.height() / 2, 3, 2), BLACK);
+  return speckles;
+}
+
+int countMismatchedTiles(const DespeckleVisualization& visualization, const QImage& reference, const int zoomLevel) {
+  const int span = DespeckleVisualization::TILE_SIZE << zoomLevel;
+  int mismatches = 0;
+  for (int row = 0; row * span < reference.height(); ++row) {
+    for (int col = 0; col * span < reference.width(); ++col) {
+      const QRect rect(visualization.tileRect(zoomLevel, col, row));
+      QImage expected(reference.copy(rect));
+      if (zoomLevel > 0) {
+        const int scale = 1 << zoomLevel;
+        const QSize size((rect.width() + scale - 1) / scale, (rect.height() + scale - 1) / scale);
+        expected = expected.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+      }
+      if (visualization.renderTile(zoomLevel, col, row) != expected) {
+        ++mismatches;
+      }
+    }
+  }
+  return mismatches;
+}
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(DespeckleVisualizationTestSuite)
+
+BOOST_AUTO_TEST_CASE(test_tiles_match_full_page_visualization) {
+  const BinaryImage speckles(makeSpeckles());
+  const QImage output(makeOutput(speckles));
+  const QImage reference(referenceVisualization(output, speckles, DPI));
+  const DespeckleVisualization visualization(output, speckles, DPI, 1.0);
+  BOOST_REQUIRE(!visualization.isNull());
+  BOOST_CHECK(visualization.image() == output);
+
+  for (int zoomLevel = 0; zoomLevel <= 3; ++zoomLevel) {
+    BOOST_CHECK_EQUAL(countMismatchedTiles(visualization, reference, zoomLevel), 0);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_arbitrary_areas_match_full_page_visualization) {
+  const BinaryImage speckles(makeSpeckles());
+  const QImage output(makeOutput(speckles));
+  const QImage reference(referenceVisualization(output, speckles, DPI));
+  const DespeckleVisualization visualization(output, speckles, DPI, 1.0);
+
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<int> xDist(-50, PAGE_SIZE.width());
+  std::uniform_int_distribution<int> yDist(-50, PAGE_SIZE.height());
+  std::uniform_int_distribution<int> sizeDist(1, 300);
+  int mismatches = 0;
+  for (int i = 0; i < 200; ++i) {
+    const QRect rect(xDist(rng), yDist(rng), sizeDist(rng), sizeDist(rng));
+    const QRect clipped(rect.intersected(reference.rect()));
+    if (clipped.isEmpty()) {
+      BOOST_CHECK(visualization.render(rect).isNull());
+    } else if (visualization.render(rect) != reference.copy(clipped)) {
+      ++mismatches;
+    }
+  }
+  BOOST_CHECK_EQUAL(mismatches, 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_no_speckles) {
+  const BinaryImage noSpeckles(PAGE_SIZE, WHITE);
+  const QImage output(makeOutput(noSpeckles));
+
+  // Detected, but none found: the whole page gets a uniform overlay.
+  const DespeckleVisualization emptyVisualization(output, noSpeckles, DPI);
+  BOOST_CHECK_EQUAL(countMismatchedTiles(emptyVisualization, referenceVisualization(output, noSpeckles, DPI), 0), 0);
+
+  // Not detected at all: the page is left as is.
+  const DespeckleVisualization nullVisualization(output, BinaryImage(), DPI);
+  BOOST_CHECK_EQUAL(countMismatchedTiles(nullVisualization, output, 0), 0);
+
+  BOOST_CHECK(DespeckleVisualization(QImage(), noSpeckles, DPI).isNull());
+}
+
+BOOST_AUTO_TEST_CASE(test_tile_cache_evicts_least_recently_used) {
+  DespeckleTileCache cache(3);
+  const QImage tile(16, 16, QImage::Format_RGB32);
+  const DespeckleTileCache::Key a{1.0, 0, 0, 0};
+  const DespeckleTileCache::Key b{1.0, 0, 1, 0};
+  const DespeckleTileCache::Key c{1.0, 1, 0, 0};
+  const DespeckleTileCache::Key d{2.0, 0, 0, 0};
+
+  cache.insert(a, tile);
+  cache.insert(b, tile);
+  cache.insert(c, tile);
+  BOOST_CHECK(!cache.find(a).isNull());
+  cache.insert(d, tile);
+
+  BOOST_CHECK_EQUAL(cache.size(), 3u);
+  BOOST_CHECK(!cache.find(a).isNull());
+  BOOST_CHECK(cache.find(b).isNull());
+  BOOST_CHECK(!cache.find(c).isNull());
+  BOOST_CHECK(!cache.find(d).isNull());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+}  // namespace Tests
@@ -0,0 +1,164 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+// Checks that masks made by dewarping their outlines match the ones made by
+// dewarping a raster of the whole original, the way the content area and
+// zone masks used to be made.
+
+#include <BinaryImage.h>
+#include <Curve.h>
+#include <CylindricalSurfaceDewarper.h>
+#include <DewarpingPointMapper.h>
+#include <DistortionModel.h>
+#include <PolygonRasterizer.h>
+#include <RasterDewarper.h>
+#include <RasterOp.h>
+
+#include <QImage>
+#include <QLineF>
+#include <QPointF>
+#include <QPolygonF>
+#include <QRect>
+#include <QRectF>
+#include <QTransform>
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <vector>
+
+#include "Constants.h"
+
+namespace Tests {
+using namespace imageproc;
+using dewarping::CylindricalSurfaceDewarper;
+using dewarping::DewarpingPointMapper;
+using dewarping::DistortionModel;
+using dewarping::RasterDewarper;
+
+namespace {
+// A4 at 150 DPI.
+const QSize IMAGE_SIZE(1240, 1754);
+const double DEPTH_PERCEPTION = 2.0;
+const double OUTLINE_STEP = 4.0;
+
+std::vector<QPointF> bulgingLine(const QPointF& from, const QPointF& to, const double bulge) {
+  std::vector<QPointF> polyline;
+  const int numSegments = 40;
+  for (int i = 0; i <= numSegments; ++i) {
+    const double t = double(i) / numSegments;
+    polyline.push_back(QLineF(from, to).pointAt(t) + QPointF(0.0, bulge * std::sin(constants::PI * t)));
+  }
+  return polyline;
+}
+
+DistortionModel curvedPageModel() {
+  DistortionModel model;
+  model.setTopCurve(dewarping::Curve(bulgingLine(QPointF(150, 210), QPointF(1100, 190), 70.0)));
+  model.setBottomCurve(dewarping::Curve(bulgingLine(QPointF(140, 1540), QPointF(1105, 1560), 35.0)));
+  return model;
+}
+
+QRect outRect() {
+  return QRect(QPoint(0, 0), IMAGE_SIZE);
+}
+
+/**
+ * A small rotation about the center, like the post-deskew one.
+ */
+QTransform postRotation() {
+  const QPointF origin(QRectF(outRect()).center());
+  QTransform rotation;
+  rotation.translate(-origin.x(), -origin.y());
+  rotation *= QTransform().rotate(1.5);
+  rotation *= QTransform().translate(origin.x(), origin.y());
+  return rotation;
+}
+
+BinaryImage polygonMask(const QSize& size, const QPolygonF& poly) {
+  BinaryImage mask(size, WHITE);
+  PolygonRasterizer::fill(mask, BLACK, poly, Qt::WindingFill);
+  return mask;
+}
+
+/**
+ * What OutputGenerator used to do: rasterize in the original and dewarp the raster.
+ */
+BinaryImage rasterDewarpedMask(const QPolygonF& poly, const QTransform& postTransform) {
+  const DistortionModel model(curvedPageModel());
+  const CylindricalSurfaceDewarper dewarper(model.topCurve().polyline(), model.bottomCurve().polyline(),
+                                            DEPTH_PERCEPTION);
+  const QRect modelDomain(model.modelDomain(dewarper, QTransform(), outRect()).toRect());
+  return BinaryImage(RasterDewarper::dewarp(polygonMask(IMAGE_SIZE, poly).toQImage(), IMAGE_SIZE, dewarper,
+                                            modelDomain, Qt::white, postTransform));
+}
+
+BinaryImage analyticallyDewarpedMask(const QPolygonF& poly,
+                                     const QTransform& postTransform,
+                                     const double outlineStep = OUTLINE_STEP) {
+  const DewarpingPointMapper mapper(curvedPageModel(), DEPTH_PERCEPTION, QTransform(), outRect(), postTransform);
+  return polygonMask(IMAGE_SIZE, mapper.mapPolygonToDewarpedSpace(poly, outlineStep));
+}
+
+/**
+ * Intersection over union of the black areas.
+ */
+double blackIoU(const BinaryImage& mask1, const BinaryImage& mask2) {
+  BinaryImage intersection(mask1);
+  rasterOp<RopAnd<RopSrc, RopDst>>(intersection, mask2);
+  BinaryImage united(mask1);
+  rasterOp<RopOr<RopSrc, RopDst>>(united, mask2);
+  return double(intersection.countBlackPixels()) / united.countBlackPixels();
+}
+
+QPolygonF contentArea() {
+  QPolygonF poly;
+  poly << QPointF(170, 240) << QPointF(1080, 225) << QPointF(1085, 1520) << QPointF(600, 1535)
+       << QPointF(160, 1510);
+  return poly;
+}
+
+QPolygonF zoneNearCurvedEdge() {
+  QPolygonF poly;
+  poly << QPointF(300, 300) << QPointF(950, 290) << QPointF(960, 520) << QPointF(310, 530);
+  return poly;
+}
+
+QPolygonF smallTiltedZone() {
+  QPolygonF poly;
+  poly << QPointF(700, 800) << QPointF(900, 860) << QPointF(840, 1060) << QPointF(640, 1000);
+  return poly;
+}
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(DewarpedMasksTestSuite)
+
+BOOST_AUTO_TEST_CASE(test_masks_match_the_raster_route) {
+  for (const QTransform& postTransform : {QTransform(), postRotation()}) {
+    const double contentIoU = blackIoU(analyticallyDewarpedMask(contentArea(), postTransform),
+                                       rasterDewarpedMask(contentArea(), postTransform));
+    const double zoneIoU = blackIoU(analyticallyDewarpedMask(zoneNearCurvedEdge(), postTransform),
+                                    rasterDewarpedMask(zoneNearCurvedEdge(), postTransform));
+    const double smallZoneIoU = blackIoU(analyticallyDewarpedMask(smallTiltedZone(), postTransform),
+                                         rasterDewarpedMask(smallTiltedZone(), postTransform));
+    BOOST_TEST_MESSAGE("IoU with the raster route: " << contentIoU << " content area, " << zoneIoU
+                                                     << " zone near the curved edge, " << smallZoneIoU
+                                                     << " small zone");
+    BOOST_CHECK_GT(contentIoU, 0.99);
+    BOOST_CHECK_GT(zoneIoU, 0.98);
+    BOOST_CHECK_GT(smallZoneIoU, 0.96);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_densified_outline_follows_the_curvature) {
+  const BinaryImage reference(rasterDewarpedMask(zoneNearCurvedEdge(), QTransform()));
+
+  // With a single segment per edge, only the corners get dewarped.
+  const double verticesOnly
+      = blackIoU(analyticallyDewarpedMask(zoneNearCurvedEdge(), QTransform(), 10000.0), reference);
+  const double densified = blackIoU(analyticallyDewarpedMask(zoneNearCurvedEdge(), QTransform()), reference);
+  BOOST_TEST_MESSAGE("IoU with the raster route: " << verticesOnly << " mapping vertices only, " << densified
+                                                   << " densified");
+  BOOST_CHECK_GT(densified, verticesOnly);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+}  // namespace Tests
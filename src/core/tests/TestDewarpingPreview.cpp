@@ -0,0 +1,169 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+// Checks that the low resolution preview shown while dragging the distortion
+// mesh puts things where the full resolution dewarping would.
+
+#include <DistortionModel.h>
+#include <Dpi.h>
+#include <Dpm.h>
+#include <GrayImage.h>
+
+#include <QImage>
+#include <QLineF>
+#include <QPointF>
+#include <QTransform>
+#include <algorithm>
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "Constants.h"
+#include "filters/output/DewarpingPreview.h"
+
+namespace Tests {
+using namespace imageproc;
+using dewarping::Curve;
+using dewarping::DistortionModel;
+using output::DewarpingPreview;
+
+namespace {
+// A4 at 300 DPI.
+const QSize IMAGE_SIZE(2480, 3508);
+const double DEPTH_PERCEPTION = 2.0;
+const int DOT_RADIUS = 9;
+
+const double CONTROL_POINTS[] = {0.0, 0.2, 0.35, 0.5, 0.65, 0.8, 1.0};
+
+std::vector<QPointF> bulgingLine(const QPointF& from, const QPointF& to, const double bulge) {
+  std::vector<QPointF> polyline;
+  const int numSegments = 40;
+  for (int i = 0; i <= numSegments; ++i) {
+    const double t = double(i) / numSegments;
+    polyline.push_back(QLineF(from, to).pointAt(t) + QPointF(0.0, bulge * std::sin(constants::PI * t)));
+  }
+  return polyline;
+}
+
+/**
+ * A page photographed with its top line curving down and its bottom line curving
+ * down a little less, which is what a book spread bulging towards the camera looks like.
+ */
+DistortionModel curvedPageModel() {
+  DistortionModel model;
+  model.setTopCurve(Curve(bulgingLine(QPointF(300, 420), QPointF(2200, 380), 140.0)));
+  model.setBottomCurve(Curve(bulgingLine(QPointF(280, 3080), QPointF(2210, 3120), 70.0)));
+  return model;
+}
+
+QImage pageImage(const std::vector<QPointF>& dots) {
+  GrayImage gray(IMAGE_SIZE);
+  gray.fill(0xff);
+  uint8_t* const data = gray.data();
+  const int stride = gray.stride();
+  for (const QPointF& dot : dots) {
+    const int cx = static_cast<int>(std::lround(dot.x()));
+    const int cy = static_cast<int>(std::lround(dot.y()));
+    for (int y = cy - DOT_RADIUS; y <= cy + DOT_RADIUS; ++y) {
+      for (int x = cx - DOT_RADIUS; x <= cx + DOT_RADIUS; ++x) {
+        if (((x - cx) * (x - cx) + (y - cy) * (y - cy) <= DOT_RADIUS * DOT_RADIUS) && (x >= 0) && (y >= 0)
+            && (x < IMAGE_SIZE.width()) && (y < IMAGE_SIZE.height())) {
+          data[y * stride + x] = 0x00;
+        }
+      }
+    }
+  }
+
+  QImage image(gray.toQImage());
+  const Dpm dpm(Dpi(300, 300));
+  image.setDotsPerMeterX(dpm.horizontal());
+  image.setDotsPerMeterY(dpm.vertical());
+  return image;
+}
+
+QPointF pointAt(const DewarpingPreview::Geometry& geometry, const double u, const double v) {
+  return QPointF(u * geometry.modelDomain().width(), v * geometry.modelDomain().height());
+}
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(DewarpingPreviewTestSuite)
+
+BOOST_AUTO_TEST_CASE(test_proxy_geometry_matches_full_resolution) {
+  const DistortionModel model(curvedPageModel());
+  BOOST_REQUIRE(model.isValid());
+
+  const DewarpingPreview preview(pageImage({}));
+  BOOST_REQUIRE(!preview.isNull());
+  BOOST_CHECK_SMALL(std::abs(preview.proxy().width() - IMAGE_SIZE.width() / 3.0), 1.0);
+  BOOST_CHECK_SMALL(std::abs(preview.proxy().height() - IMAGE_SIZE.height() / 3.0), 1.0);
+
+  const DewarpingPreview::Geometry full(model, DEPTH_PERCEPTION, QTransform());
+  const DewarpingPreview::Geometry proxy(preview.geometry(model, DEPTH_PERCEPTION));
+  BOOST_CHECK_SMALL(std::abs(proxy.size().width() - full.size().width() / 3.0), 1.0);
+  BOOST_CHECK_SMALL(std::abs(proxy.size().height() - full.size().height() / 3.0), 1.0);
+
+  double maxError = 0.0;
+  for (const double u : CONTROL_POINTS) {
+    for (const double v : CONTROL_POINTS) {
+      const QPointF expected(full.mapToImage(pointAt(full, u, v)));
+      const QPointF actual(proxy.mapToImage(pointAt(proxy, u, v)));
+      maxError = std::max(maxError, QLineF(expected, actual).length());
+    }
+  }
+  BOOST_TEST_MESSAGE("max control point error in full resolution pixels: " << maxError);
+  BOOST_CHECK_LT(maxError, 1.0);
+}
+
+BOOST_AUTO_TEST_CASE(test_rendered_proxy_follows_the_model) {
+  const DistortionModel model(curvedPageModel());
+  const DewarpingPreview::Geometry full(model, DEPTH_PERCEPTION, QTransform());
+
+  // Put a dot wherever the full resolution dewarping takes an interior control point from.
+  std::vector<QPointF> dots;
+  for (const double u : CONTROL_POINTS) {
+    for (const double v : CONTROL_POINTS) {
+      if ((u > 0.0) && (u < 1.0) && (v > 0.0) && (v < 1.0)) {
+        dots.push_back(full.mapToImage(pointAt(full, u, v)));
+      }
+    }
+  }
+
+  const DewarpingPreview preview(pageImage(dots));
+  const QImage frame(preview.render(model, DEPTH_PERCEPTION));
+  BOOST_REQUIRE(!frame.isNull());
+  const DewarpingPreview::Geometry proxy(preview.geometry(model, DEPTH_PERCEPTION));
+  BOOST_CHECK(frame.size() == proxy.size());
+
+  const GrayImage gray(frame);
+  const auto pixelAt = [&gray](const QPointF& pt) {
+    return int(gray.data()[std::lround(pt.y()) * gray.stride() + std::lround(pt.x())]);
+  };
+
+  int missedDots = 0;
+  int spuriousDots = 0;
+  for (const double u : CONTROL_POINTS) {
+    for (const double v : CONTROL_POINTS) {
+      if ((u > 0.0) && (u < 1.0) && (v > 0.0) && (v < 1.0)) {
+        if (pixelAt(pointAt(proxy, u, v)) > 100) {
+          ++missedDots;
+        }
+        // Halfway to the next control point there is just paper.
+        if (pixelAt(pointAt(proxy, u + 0.07, v + 0.07)) < 200) {
+          ++spuriousDots;
+        }
+      }
+    }
+  }
+  BOOST_CHECK_EQUAL(missedDots, 0);
+  BOOST_CHECK_EQUAL(spuriousDots, 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_invalid_model_gives_no_frame) {
+  const DewarpingPreview preview(pageImage({}));
+  BOOST_CHECK(preview.render(DistortionModel(), DEPTH_PERCEPTION).isNull());
+  BOOST_CHECK(DewarpingPreview().render(curvedPageModel(), DEPTH_PERCEPTION).isNull());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+}  // namespace Tests
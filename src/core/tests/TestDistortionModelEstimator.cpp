@@ -0,0 +1,197 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+// Checks that distortion models built on the reduced resolution proxy stay
+// close to the ones built on the full resolution original.
+
+#include <DistortionModel.h>
+#include <DistortionModelBuilder.h>
+#include <Dpi.h>
+#include <GrayImage.h>
+
+#include <QLineF>
+#include <QPointF>
+#include <QSize>
+#include <QTransform>
+#include <algorithm>
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "Constants.h"
+#include "NullTaskStatus.h"
+#include "OrthogonalRotation.h"
+#include "PageId.h"
+#include "filters/output/DistortionModelEstimator.h"
+
+namespace Tests {
+using namespace imageproc;
+using dewarping::Curve;
+using dewarping::DistortionModel;
+using dewarping::DistortionModelBuilder;
+using output::DistortionModelEstimator;
+
+namespace {
+// A4 at 300 DPI, as seen upright.
+const QSize UPRIGHT_SIZE(2480, 3508);
+const Dpi ORIGINAL_DPI(300, 300);
+const double MAX_DEVIATION = 1.0 * ORIGINAL_DPI.vertical() * constants::MM2INCH;
+
+double topEdge(const double x) {
+  const double t = x / UPRIGHT_SIZE.width();
+  return 250.0 + 120.0 * t * t;
+}
+
+double bottomEdge(const double x) {
+  const double t = x / UPRIGHT_SIZE.width();
+  return UPRIGHT_SIZE.height() - 250.0 - 80.0 * t * t;
+}
+
+/**
+ * A light page with the top and bottom edges curving away near the binding,
+ * on a dark background, stored the way \p preRotation says the original is.
+ */
+GrayImage scannedPage(const OrthogonalRotation& preRotation) {
+  const QSize originalSize(preRotation.unrotate(UPRIGHT_SIZE));
+  const QTransform toUpright(preRotation.transform(QSizeF(originalSize)));
+  GrayImage image(originalSize);
+  uint8_t* const data = image.data();
+  const int stride = image.stride();
+  for (int y = 0; y < originalSize.height(); ++y) {
+    for (int x = 0; x < originalSize.width(); ++x) {
+      const QPointF pt(toUpright.map(QPointF(x + 0.5, y + 0.5)));
+      const bool onPage = (pt.x() > 150) && (pt.x() < UPRIGHT_SIZE.width() - 150) && (pt.y() > topEdge(pt.x()))
+                          && (pt.y() < bottomEdge(pt.x()));
+      data[y * stride + x] = onPage ? 230 : 40;
+    }
+  }
+  return image;
+}
+
+/**
+ * A model along the content box, like Processor::setupTrivialDistortionModel() makes.
+ */
+DistortionModel trivialModel(const OrthogonalRotation& preRotation) {
+  const QSize originalSize(preRotation.unrotate(UPRIGHT_SIZE));
+  const QTransform fromUpright(preRotation.transform(QSizeF(originalSize)).inverted());
+  DistortionModel model;
+  model.setTopCurve(
+      Curve(std::vector<QPointF>{fromUpright.map(QPointF(300, 600)), fromUpright.map(QPointF(2180, 600))}));
+  model.setBottomCurve(
+      Curve(std::vector<QPointF>{fromUpright.map(QPointF(300, 2900)), fromUpright.map(QPointF(2180, 2900))}));
+  return model;
+}
+
+double distanceToSegment(const QPointF& pt, const QLineF& segment) {
+  const QPointF d(segment.p2() - segment.p1());
+  const double lengthSq = d.x() * d.x() + d.y() * d.y();
+  double t = 0;
+  if (lengthSq > 0) {
+    const QPointF v(pt - segment.p1());
+    t = std::clamp((v.x() * d.x() + v.y() * d.y()) / lengthSq, 0.0, 1.0);
+  }
+  return QLineF(pt, segment.p1() + t * d).length();
+}
+
+double distanceToPolyline(const QPointF& pt, const std::vector<QPointF>& polyline) {
+  double best = std::numeric_limits<double>::max();
+  for (size_t i = 1; i < polyline.size(); ++i) {
+    best = std::min(best, distanceToSegment(pt, QLineF(polyline[i - 1], polyline[i])));
+  }
+  return best;
+}
+
+/**
+ * How far apart the two curves get, in original image pixels.
+ */
+double curveDeviation(const Curve& curve1, const Curve& curve2) {
+  double deviation = 0;
+  for (const QPointF& pt : curve1.polyline()) {
+    deviation = std::max(deviation, distanceToPolyline(pt, curve2.polyline()));
+  }
+  for (const QPointF& pt : curve2.polyline()) {
+    deviation = std::max(deviation, distanceToPolyline(pt, curve1.polyline()));
+  }
+  return deviation;
+}
+
+double modelDeviation(const DistortionModel& model1, const DistortionModel& model2) {
+  return std::max(curveDeviation(model1.topCurve(), model2.topCurve()),
+                  curveDeviation(model1.bottomCurve(), model2.bottomCurve()));
+}
+
+DistortionModel buildAutoModel(const GrayImage& original, const int proxyDpi) {
+  DistortionModelBuilder builder(Vec2d(0, 1));
+  builder.setVerticalBounds(QLineF(200, 0, 200, UPRIGHT_SIZE.height()),
+                            QLineF(UPRIGHT_SIZE.width() - 200, 0, UPRIGHT_SIZE.width() - 200, UPRIGHT_SIZE.height()));
+  const NullTaskStatus status;
+  return DistortionModelEstimator(original, ORIGINAL_DPI, proxyDpi).buildAutoModel(builder, status, nullptr);
+}
+
+DistortionModel buildMarginalModel(const GrayImage& original,
+                                   const OrthogonalRotation& preRotation,
+                                   const PageId::SubPage subPage,
+                                   const int proxyDpi) {
+  return DistortionModelEstimator(original, ORIGINAL_DPI, proxyDpi)
+      .buildMarginalModel(trivialModel(preRotation), preRotation, subPage, nullptr);
+}
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(DistortionModelEstimatorTestSuite)
+
+BOOST_AUTO_TEST_CASE(test_proxy_resolution) {
+  const GrayImage original(scannedPage(OrthogonalRotation()));
+
+  const DistortionModelEstimator estimator(original, ORIGINAL_DPI);
+  BOOST_CHECK(estimator.proxy().size() == QSize(1240, 1754));
+  BOOST_CHECK_CLOSE(estimator.originalToProxy().m11(), 0.5, 0.01);
+
+  // Nothing gets scaled when the original isn't above the proxy resolution.
+  const DistortionModelEstimator fullResolution(original, ORIGINAL_DPI, ORIGINAL_DPI.vertical());
+  BOOST_CHECK(fullResolution.proxy().size() == original.size());
+  BOOST_CHECK(fullResolution.originalToProxy().isIdentity());
+}
+
+BOOST_AUTO_TEST_CASE(test_auto_model_is_close_to_full_resolution) {
+  const GrayImage original(scannedPage(OrthogonalRotation()));
+
+  const DistortionModel fullResolution(buildAutoModel(original, ORIGINAL_DPI.vertical()));
+  const DistortionModel proxy(buildAutoModel(original, DistortionModelEstimator::PROXY_DPI));
+  BOOST_REQUIRE(fullResolution.isValid());
+  BOOST_REQUIRE(proxy.isValid());
+
+  const double deviation = modelDeviation(fullResolution, proxy);
+  BOOST_TEST_MESSAGE("auto model deviation: " << deviation << " px");
+  BOOST_CHECK_LT(deviation, MAX_DEVIATION);
+}
+
+BOOST_AUTO_TEST_CASE(test_marginal_model_is_close_to_full_resolution) {
+  OrthogonalRotation rotated;
+  rotated.nextClockwiseDirection();
+
+  for (const OrthogonalRotation& preRotation : {OrthogonalRotation(), rotated}) {
+    const GrayImage original(scannedPage(preRotation));
+    for (const PageId::SubPage subPage : {PageId::LEFT_PAGE, PageId::RIGHT_PAGE}) {
+      const DistortionModel fullResolution(buildMarginalModel(original, preRotation, subPage, ORIGINAL_DPI.vertical()));
+      const DistortionModel proxy(
+          buildMarginalModel(original, preRotation, subPage, DistortionModelEstimator::PROXY_DPI));
+      BOOST_REQUIRE(fullResolution.isValid());
+      BOOST_REQUIRE(proxy.isValid());
+
+      const double deviation = modelDeviation(fullResolution, proxy);
+      BOOST_TEST_MESSAGE("marginal model deviation at " << preRotation.toDegrees() << " degrees: " << deviation
+                                                        << " px");
+      BOOST_CHECK_LT(deviation, MAX_DEVIATION);
+
+      // And the curves did go out to the page edges.
+      const QTransform toUpright(preRotation.transform(QSizeF(original.size())));
+      const QPointF topStart(toUpright.map(proxy.topCurve().polyline().front()));
+      BOOST_CHECK_LT(std::abs(topStart.y() - topEdge(topStart.x())), MAX_DEVIATION);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+}  // namespace Tests
@@ -0,0 +1,250 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+// Measures how well the background estimators recover a known illumination
+// of synthetic pages with text, pictures and dark surroundings.
+
+#include <BinaryImage.h>
+#include <GrayImage.h>
+#include <PolynomialSurface.h>
+
+#include <QDomDocument>
+#include <QPolygonF>
+#include <QRect>
+#include <algorithm>
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "BatchProcessingContext.h"
+#include "EstimateBackground.h"
+#include "NullTaskStatus.h"
+#include "filters/output/ColorParams.h"
+
+namespace Tests {
+using namespace imageproc;
+
+namespace {
+// A5 at 200 DPI.
+const int PAGE_WIDTH = 1165;
+const int PAGE_HEIGHT = 1654;
+
+const QRect PHOTO_AREA(130, 700, PAGE_WIDTH - 260, 520);
+
+enum Illumination { VIGNETTED, SHADED };
+
+enum Content { TEXT, TEXT_AND_PHOTO, TEXT_AND_DARK_BORDERS };
+
+struct SyntheticPage {
+  GrayImage image;
+  std::vector<double> background;
+};
+
+/**
+ * A vignetted page falls off towards the corners, the way a camera lens does.
+ * A shaded page gets darker towards the spine on the left, with a narrow shadow next to it.
+ */
+double illumination(const Illumination kind, const int x, const int y) {
+  if (kind == VIGNETTED) {
+    const double dx = (x - PAGE_WIDTH / 2.0) / (PAGE_WIDTH / 2.0);
+    const double dy = (y - PAGE_HEIGHT / 2.0) / (PAGE_HEIGHT / 2.0);
+    return 235.0 * (1.0 - 0.18 * (dx * dx + dy * dy));
+  }
+  return 160.0 + 80.0 * x / PAGE_WIDTH - 50.0 * std::exp(-x / 80.0);
+}
+
+bool isText(const int x, const int y) {
+  if ((y <= 150) || (y >= PAGE_HEIGHT - 170) || (x <= 130) || (x >= PAGE_WIDTH - 130)) {
+    return false;
+  }
+  const int lineY = y % 34;
+  const bool inLine = (lineY >= 8) && (lineY < 28);
+  const bool inWord = (x / 11) % 9 != 8;
+  const bool inGlyph = (x * 7 + y / 34 * 13) % 10 < 7;
+  return inLine && inWord && inGlyph;
+}
+
+SyntheticPage makePage(const Illumination illuminationKind, const Content content) {
+  std::mt19937 rng(static_cast<uint32_t>(illuminationKind * 10 + content));
+  SyntheticPage page{GrayImage(QSize(PAGE_WIDTH, PAGE_HEIGHT)),
+                     std::vector<double>(static_cast<size_t>(PAGE_WIDTH * PAGE_HEIGHT))};
+
+  uint8_t* line = page.image.data();
+  for (int y = 0; y < PAGE_HEIGHT; ++y, line += page.image.stride()) {
+    for (int x = 0; x < PAGE_WIDTH; ++x) {
+      const double background = illumination(illuminationKind, x, y);
+      page.background[y * PAGE_WIDTH + x] = background;
+
+      const int noise = static_cast<int>(rng() % 13) - 6;
+      int value = static_cast<int>(std::lround(background)) + noise;
+      if ((content == TEXT_AND_PHOTO) && PHOTO_AREA.contains(x, y)) {
+        value = static_cast<int>(120 + 90 * std::sin(x * 0.021) * std::cos(y * 0.017)) + noise;
+      } else if (isText(x, y)) {
+        value = 25 + noise;
+      }
+      if ((content == TEXT_AND_DARK_BORDERS) && ((x < 70) || (y > PAGE_HEIGHT - 60))) {
+        value = 30;
+      }
+      line[x] = static_cast<uint8_t>(std::clamp(value, 0, 255));
+    }
+  }
+  return page;
+}
+
+struct Errors {
+  double mean;
+  double p95;
+};
+
+Errors measureErrors(const PolynomialSurface& surface, const SyntheticPage& page) {
+  const GrayImage rendered(surface.render(page.image.size()));
+  std::vector<double> errors;
+  errors.reserve(page.background.size());
+  const uint8_t* line = rendered.data();
+  for (int y = 0; y < PAGE_HEIGHT; ++y, line += rendered.stride()) {
+    for (int x = 0; x < PAGE_WIDTH; ++x) {
+      errors.push_back(std::abs(line[x] - page.background[y * PAGE_WIDTH + x]));
+    }
+  }
+
+  double sum = 0.0;
+  for (const double error : errors) {
+    sum += error;
+  }
+  const auto p95 = errors.begin() + errors.size() * 95 / 100;
+  std::nth_element(errors.begin(), p95, errors.end());
+  return {sum / errors.size(), *p95};
+}
+
+void checkTiledAccuracy(const Illumination illuminationKind,
+                        const Content content,
+                        const double maxMeanError,
+                        const double maxP95Error) {
+  const SyntheticPage page(makePage(illuminationKind, content));
+  const NullTaskStatus status;
+
+  const Errors tiled(measureErrors(estimateBackgroundTiled(page.image, QPolygonF(), status), page));
+  const Errors polynomial(measureErrors(estimateBackground(page.image, QPolygonF(), status), page));
+  BOOST_TEST_MESSAGE("illumination " << illuminationKind << ", content " << content << ": tiled mean " << tiled.mean
+                                     << " p95 " << tiled.p95 << ", polynomial mean " << polynomial.mean << " p95 "
+                                     << polynomial.p95);
+
+  BOOST_CHECK_LT(tiled.mean, maxMeanError);
+  BOOST_CHECK_LT(tiled.p95, maxP95Error);
+}
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(EstimateBackgroundTestSuite)
+
+BOOST_AUTO_TEST_CASE(test_weighted_samples_reproduce_a_polynomial) {
+  const QSize size(400, 300);
+  const auto plane = [](const double x, const double y) { return 100.0 + 0.2 * x - 0.1 * y; };
+
+  std::vector<PolynomialSurface::Sample> samples;
+  for (int y = 0; y < size.height(); y += 20) {
+    for (int x = 0; x < size.width(); x += 20) {
+      samples.push_back({QPointF(x, y), plane(x, y), 1.0});
+    }
+  }
+  // Samples without weight must not matter.
+  samples.push_back({QPointF(200, 150), 0.0, 0.0});
+
+  const PolynomialSurface surface(2, 2, size, samples);
+  for (const QPointF& pt : {QPointF(0, 0), QPointF(399, 299), QPointF(123, 45)}) {
+    BOOST_CHECK_SMALL(surface.valueAt(pt, size) - plane(pt.x(), pt.y()), 0.05);
+  }
+
+  const GrayImage rendered(surface.render(size));
+  const int renderedValue = rendered.data()[150 * rendered.stride() + 200];
+  BOOST_CHECK_EQUAL(renderedValue, static_cast<int>(std::lround(plane(200, 150))));
+}
+
+BOOST_AUTO_TEST_CASE(test_tiled_vignetted_text) {
+  checkTiledAccuracy(VIGNETTED, TEXT, 2.5, 5.0);
+}
+
+BOOST_AUTO_TEST_CASE(test_tiled_shaded_text) {
+  checkTiledAccuracy(SHADED, TEXT, 2.5, 6.0);
+}
+
+BOOST_AUTO_TEST_CASE(test_tiled_vignetted_photo) {
+  checkTiledAccuracy(VIGNETTED, TEXT_AND_PHOTO, 3.0, 7.0);
+}
+
+BOOST_AUTO_TEST_CASE(test_tiled_shaded_photo) {
+  checkTiledAccuracy(SHADED, TEXT_AND_PHOTO, 3.0, 8.0);
+}
+
+BOOST_AUTO_TEST_CASE(test_tiled_vignetted_dark_borders) {
+  checkTiledAccuracy(VIGNETTED, TEXT_AND_DARK_BORDERS, 4.0, 10.0);
+}
+
+BOOST_AUTO_TEST_CASE(test_tiled_respects_the_mask) {
+  const SyntheticPage page(makePage(SHADED, TEXT_AND_PHOTO));
+  const NullTaskStatus status;
+
+  BinaryImage paperMask(page.image.size(), BLACK);
+  paperMask.fill(PHOTO_AREA, WHITE);
+  const QPolygonF area(QRectF(page.image.rect().adjusted(20, 20, -20, -20)));
+
+  const Errors masked(measureErrors(estimateBackgroundTiled(page.image, area, status, nullptr, &paperMask), page));
+  BOOST_CHECK_LT(masked.mean, 2.5);
+  BOOST_CHECK_LT(masked.p95, 6.0);
+}
+
+BOOST_AUTO_TEST_CASE(test_tiled_does_not_depend_on_thread_count) {
+  const SyntheticPage page(makePage(VIGNETTED, TEXT_AND_PHOTO));
+  const NullTaskStatus status;
+  const GrayImage parallel(estimateBackgroundTiled(page.image, QPolygonF(), status).render(page.image.size()));
+
+  // With this many pages in flight, the tiles are measured on the calling thread alone.
+  std::vector<std::unique_ptr<batch_processing::TaskScope>> busyTasks;
+  for (int i = 0; i < 1024; ++i) {
+    busyTasks.push_back(std::make_unique<batch_processing::TaskScope>(true));
+  }
+  const GrayImage serial(estimateBackgroundTiled(page.image, QPolygonF(), status).render(page.image.size()));
+  busyTasks.clear();
+
+  BOOST_CHECK(serial == parallel);
+}
+
+BOOST_AUTO_TEST_CASE(test_method_selection) {
+  const SyntheticPage page(makePage(VIGNETTED, TEXT));
+  const NullTaskStatus status;
+  const QSize size(page.image.size());
+
+  const GrayImage tiled(estimateBackgroundTiled(page.image, QPolygonF(), status).render(size));
+  const GrayImage polynomial(estimateBackground(page.image, QPolygonF(), status).render(size));
+  BOOST_CHECK(estimateBackground(BackgroundEstimationMethod::TILED_ROBUST, page.image, QPolygonF(), status)
+                  .render(size)
+              == tiled);
+  BOOST_CHECK(estimateBackground(BackgroundEstimationMethod::POLYNOMIAL, page.image, QPolygonF(), status).render(size)
+              == polynomial);
+}
+
+BOOST_AUTO_TEST_CASE(test_method_is_stored_with_page_params) {
+  output::BlackWhiteOptions options;
+  BOOST_CHECK(options.backgroundEstimationMethod() == BackgroundEstimationMethod::POLYNOMIAL);
+  options.setBackgroundEstimationMethod(BackgroundEstimationMethod::TILED_ROBUST);
+
+  output::ColorParams params;
+  params.setBlackWhiteOptions(options);
+  // Output params that differ in it don't match, so the output gets regenerated.
+  BOOST_CHECK(params.blackWhiteOptions() != output::BlackWhiteOptions());
+
+  QDomDocument document;
+  const output::ColorParams restored(params.toXml(document, QStringLiteral("color-params")));
+  BOOST_CHECK(restored.blackWhiteOptions().backgroundEstimationMethod() == BackgroundEstimationMethod::TILED_ROBUST);
+  BOOST_CHECK(restored.blackWhiteOptions() == options);
+
+  // Projects saved before the setting existed keep the polynomial method.
+  QDomElement el(output::BlackWhiteOptions().toXml(document, QStringLiteral("bw")));
+  el.removeAttribute(QStringLiteral("backgroundEstimation"));
+  BOOST_CHECK(output::BlackWhiteOptions(el).backgroundEstimationMethod() == BackgroundEstimationMethod::POLYNOMIAL);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+}  // namespace Tests
@@ -0,0 +1,285 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+// Feeds valid, truncated and fuzzed PNG, JPEG and TIFF files to the decode
+// helper, checking that every one of them either decodes or fails with an
+// error, and that the helper keeps serving (or gets restarted) afterwards.
+
+#ifndef _WIN32
+
+#include <signal.h>
+#include <sys/types.h>
+
+#include <QByteArray>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QString>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QtEndian>
+#include <boost/test/unit_test.hpp>
+#include <cstdint>
+
+#include "ImageLoader.h"
+#include "IsolatedImageDecoder.h"
+#include "TiffWriter.h"
+
+namespace Tests {
+namespace {
+IsolatedImageDecoder::Limits testLimits() {
+  IsolatedImageDecoder::Limits limits;
+  limits.addressSpaceBytes = uint64_t(1024) * 1024 * 1024;
+  limits.cpuSeconds = 10;
+  limits.timeoutMsec = 20000;
+  return limits;
+}
+
+QImage makeImage() {
+  QImage image(160, 120, QImage::Format_RGB32);
+  for (int y = 0; y < image.height(); ++y) {
+    for (int x = 0; x < image.width(); ++x) {
+      image.setPixel(x, y, qRgb((x * 3) & 0xff, (y * 5) & 0xff, (x ^ y) & 0xff));
+    }
+  }
+  return image;
+}
+
+QByteArray readFile(const QString& path) {
+  QFile file(path);
+  BOOST_REQUIRE(file.open(QIODevice::ReadOnly));
+  return file.readAll();
+}
+
+void writeFile(const QString& path, const QByteArray& data) {
+  QFile file(path);
+  BOOST_REQUIRE(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+  BOOST_REQUIRE(file.write(data) == data.size());
+}
+
+/**
+ * Writes the same image as PNG, JPEG and TIFF.
+ */
+QStringList writeValidFixtures(const QTemporaryDir& dir) {
+  const QImage image(makeImage());
+  const QString png(dir.filePath("valid.png"));
+  const QString jpeg(dir.filePath("valid.jpg"));
+  const QString tiff(dir.filePath("valid.tif"));
+  BOOST_REQUIRE(image.save(png, "PNG"));
+  BOOST_REQUIRE(image.save(jpeg, "JPEG", 90));
+  BOOST_REQUIRE(TiffWriter::writeImage(tiff, image));
+  return {png, jpeg, tiff};
+}
+
+/**
+ * A little-endian TIFF declaring a 60000 x 60000 grayscale image,
+ * with 16 bytes of pixel data actually present.
+ */
+QByteArray makeHugeTiff() {
+  QByteArray data;
+  auto append16 = [&data](const uint16_t value) {
+    const uint16_t le = qToLittleEndian(value);
+    data.append(reinterpret_cast<const char*>(&le), sizeof(le));
+  };
+  auto append32 = [&data](const uint32_t value) {
+    const uint32_t le = qToLittleEndian(value);
+    data.append(reinterpret_cast<const char*>(&le), sizeof(le));
+  };
+  auto appendEntry = [&](const uint16_t tag, const uint16_t type, const uint32_t value) {
+    append16(tag);
+    append16(type);
+    append32(1);
+    if (type == 3) {
+      append16(static_cast<uint16_t>(value));
+      append16(0);
+    } else {
+      append32(value);
+    }
+  };
+
+  const uint32_t dimension = 60000;
+  const uint16_t SHORT = 3;
+  const uint16_t LONG = 4;
+  data.append("II", 2);
+  append16(42);
+  append32(8 + 16);  // The pixels come first.
+  data.append(QByteArray(16, '\x7f'));
+
+  append16(9);
+  appendEntry(256, LONG, dimension);  // ImageWidth
+  appendEntry(257, LONG, dimension);  // ImageLength
+  appendEntry(258, SHORT, 8);         // BitsPerSample
+  appendEntry(259, SHORT, 1);         // Compression: none
+  appendEntry(262, SHORT, 1);         // Photometric: min-is-black
+  appendEntry(273, LONG, 8);          // StripOffsets
+  appendEntry(277, SHORT, 1);         // SamplesPerPixel
+  appendEntry(278, LONG, dimension);  // RowsPerStrip
+  appendEntry(279, LONG, 16);         // StripByteCounts
+  append32(0);
+  return data;
+}
+
+/**
+ * Decodes a file that may be damaged.  It has to either decode or fail with an error.
+ */
+void checkDecodesOrFailsCleanly(IsolatedImageDecoder& decoder, const QString& path) {
+  QString error;
+  const QImage image(decoder.decode(path, 0, &error));
+  BOOST_CHECK_MESSAGE(!image.isNull() || !error.isEmpty(), "No image and no error for " << path.toStdString());
+}
+
+void checkDecodesCorrectly(IsolatedImageDecoder& decoder, const QString& path) {
+  QString error;
+  const QImage image(decoder.decode(path, 0, &error));
+  BOOST_REQUIRE_MESSAGE(!image.isNull(), path.toStdString() << ": " << error.toStdString());
+  BOOST_CHECK(image == ImageLoader::decodeFile(path, 0));
+}
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(IsolatedImageDecoderTestSuite)
+
+BOOST_AUTO_TEST_CASE(test_valid_files_decode_as_in_process) {
+  QTemporaryDir dir;
+  BOOST_REQUIRE(dir.isValid());
+  IsolatedImageDecoder decoder(SCANTAILOR_DECODE_HELPER_PATH, testLimits());
+
+  for (const QString& path : writeValidFixtures(dir)) {
+    checkDecodesCorrectly(decoder, path);
+  }
+  // One helper serves all the requests.
+  BOOST_CHECK_EQUAL(decoder.startCount(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_truncated_files_fail_cleanly) {
+  QTemporaryDir dir;
+  BOOST_REQUIRE(dir.isValid());
+  IsolatedImageDecoder decoder(SCANTAILOR_DECODE_HELPER_PATH, testLimits());
+
+  const QStringList validPaths(writeValidFixtures(dir));
+  for (const QString& validPath : validPaths) {
+    const QByteArray data(readFile(validPath));
+    for (const int length : {0, 8, 64, int(data.size() / 2), int(data.size() - 16)}) {
+      const QString path(dir.filePath(QString("truncated-%1-%2").arg(length).arg(QFileInfo(validPath).fileName())));
+      writeFile(path, data.left(length));
+      checkDecodesOrFailsCleanly(decoder, path);
+    }
+  }
+
+  for (const QString& validPath : validPaths) {
+    checkDecodesCorrectly(decoder, validPath);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_fuzzed_files_fail_cleanly) {
+  QTemporaryDir dir;
+  BOOST_REQUIRE(dir.isValid());
+  IsolatedImageDecoder decoder(SCANTAILOR_DECODE_HELPER_PATH, testLimits());
+
+  // A fixed seed, so that a failure can be reproduced.
+  uint32_t random = 12345;
+  auto nextRandom = [&random] {
+    random = random * 1664525u + 1013904223u;
+    return random >> 8;
+  };
+
+  const QStringList validPaths(writeValidFixtures(dir));
+  for (const QString& validPath : validPaths) {
+    const QByteArray data(readFile(validPath));
+    for (int variant = 0; variant < 24; ++variant) {
+      QByteArray fuzzed(data);
+      const int mutations = 1 + int(nextRandom() % 32);
+      for (int i = 0; i < mutations; ++i) {
+        // The signature is left alone, so that the file reaches the right decoder.
+        const int offset = 8 + int(nextRandom() % uint32_t(fuzzed.size() - 8));
+        fuzzed[offset] = static_cast<char>(nextRandom() & 0xff);
+      }
+      const QString path(dir.filePath(QString("fuzzed-%1-%2").arg(variant).arg(QFileInfo(validPath).fileName())));
+      writeFile(path, fuzzed);
+      checkDecodesOrFailsCleanly(decoder, path);
+    }
+  }
+
+  for (const QString& validPath : validPaths) {
+    checkDecodesCorrectly(decoder, validPath);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_oversized_image_is_stopped_by_address_space_limit) {
+  QTemporaryDir dir;
+  BOOST_REQUIRE(dir.isValid());
+  // The 3.6 GB the file asks for is way past the limit of the test helper.
+  IsolatedImageDecoder decoder(SCANTAILOR_DECODE_HELPER_PATH, testLimits());
+
+  const QString path(dir.filePath("huge.tif"));
+  writeFile(path, makeHugeTiff());
+  QString error;
+  BOOST_CHECK(decoder.decode(path, 0, &error).isNull());
+  BOOST_CHECK(!error.isEmpty());
+
+  checkDecodesCorrectly(decoder, writeValidFixtures(dir).front());
+}
+
+BOOST_AUTO_TEST_CASE(test_oversized_image_is_refused_without_address_space_limit) {
+  QTemporaryDir dir;
+  BOOST_REQUIRE(dir.isValid());
+  // As on systems not enforcing RLIMIT_AS: only the image size limit can stop these.
+  IsolatedImageDecoder::Limits limits(testLimits());
+  limits.addressSpaceBytes = uint64_t(64) * 1024 * 1024 * 1024;
+  limits.imageBytes = uint64_t(16) * 1024 * 1024;
+  IsolatedImageDecoder decoder(SCANTAILOR_DECODE_HELPER_PATH, limits);
+
+  const QString tiffPath(dir.filePath("huge.tif"));
+  writeFile(tiffPath, makeHugeTiff());
+  QString error;
+  BOOST_CHECK(decoder.decode(tiffPath, 0, &error).isNull());
+  BOOST_CHECK(!error.isEmpty());
+
+  // 48 MB decoded, but a small file.
+  QImage large(4000, 3000, QImage::Format_RGB32);
+  large.fill(Qt::white);
+  const QString pngPath(dir.filePath("large.png"));
+  BOOST_REQUIRE(large.save(pngPath, "PNG"));
+  error.clear();
+  BOOST_CHECK(decoder.decode(pngPath, 0, &error).isNull());
+  BOOST_CHECK(!error.isEmpty());
+  BOOST_CHECK_EQUAL(decoder.startCount(), 1);
+
+  checkDecodesCorrectly(decoder, writeValidFixtures(dir).front());
+}
+
+BOOST_AUTO_TEST_CASE(test_missing_file_fails_cleanly) {
+  QTemporaryDir dir;
+  BOOST_REQUIRE(dir.isValid());
+  IsolatedImageDecoder decoder(SCANTAILOR_DECODE_HELPER_PATH, testLimits());
+
+  QString error;
+  BOOST_CHECK(decoder.decode(dir.filePath("missing.png"), 0, &error).isNull());
+  BOOST_CHECK(!error.isEmpty());
+}
+
+BOOST_AUTO_TEST_CASE(test_dead_helper_is_restarted) {
+  QTemporaryDir dir;
+  BOOST_REQUIRE(dir.isValid());
+  IsolatedImageDecoder decoder(SCANTAILOR_DECODE_HELPER_PATH, testLimits());
+  const QString path(writeValidFixtures(dir).front());
+
+  checkDecodesCorrectly(decoder, path);
+  const int64_t pid = decoder.helperProcessId();
+  BOOST_REQUIRE(pid > 0);
+  ::kill(static_cast<pid_t>(pid), SIGKILL);
+
+  // Depending on whether the helper is already gone by then, the next request
+  // either goes to a new helper or fails and leaves the restart to the one after.
+  QString error;
+  if (decoder.decode(path, 0, &error).isNull()) {
+    BOOST_CHECK(!error.isEmpty());
+  }
+  checkDecodesCorrectly(decoder, path);
+  BOOST_CHECK_EQUAL(decoder.startCount(), 2);
+  BOOST_CHECK(decoder.helperProcessId() != pid);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+}  // namespace Tests
+
+#endif  // ifndef _WIN32
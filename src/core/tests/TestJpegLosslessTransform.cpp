@@ -0,0 +1,199 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+// Rotates and crops JPEG files in the DCT domain and compares the decoded
+// results to the decoded source rotated and cropped in the pixel domain.
+// The two aren't bit-exact, as the IDCT rounds differently when its passes
+// are swapped, and chroma gets upsampled differently at the new edges,
+// but they have to be very close.
+
+#include <QBuffer>
+#include <QByteArray>
+#include <QColorSpace>
+#include <QImage>
+#include <QImageWriter>
+#include <QRect>
+#include <QTransform>
+#include <algorithm>
+#include <boost/test/unit_test.hpp>
+#include <cstdlib>
+
+#include "JpegLosslessTransform.h"
+
+namespace Tests {
+namespace {
+const QSize SOURCE_SIZE(203, 157);
+
+/**
+ * Smooth color gradients with thin dark lines over them.
+ */
+QImage makeSourceImage() {
+  QImage image(SOURCE_SIZE, QImage::Format_RGB32);
+  for (int y = 0; y < image.height(); ++y) {
+    for (int x = 0; x < image.width(); ++x) {
+      if ((x % 23 == 5) || (y % 17 == 3)) {
+        image.setPixel(x, y, qRgb(20, 20, 20));
+      } else {
+        image.setPixel(x, y, qRgb(60 + x * 3 / 4, 40 + y, 200 - (x + y) / 3));
+      }
+    }
+  }
+  return image;
+}
+
+QByteArray encode(const QImage& image) {
+  QByteArray data;
+  QBuffer buffer(&data);
+  buffer.open(QIODevice::WriteOnly);
+  BOOST_REQUIRE(image.save(&buffer, "JPEG", 95));
+  return data;
+}
+
+QImage decode(const QByteArray& data) {
+  return QImage::fromData(data, "JPEG").convertToFormat(QImage::Format_RGB32);
+}
+
+struct Difference {
+  double mean = 0;
+  int max = 0;
+};
+
+Difference compare(const QImage& actual, const QImage& expected) {
+  Difference difference;
+  long long sum = 0;
+  for (int y = 0; y < expected.height(); ++y) {
+    const auto* actualLine = reinterpret_cast<const QRgb*>(actual.constScanLine(y));
+    const auto* expectedLine = reinterpret_cast<const QRgb*>(expected.constScanLine(y));
+    for (int x = 0; x < expected.width(); ++x) {
+      for (const int shift : {0, 8, 16}) {
+        const int d = std::abs(int((actualLine[x] >> shift) & 0xff) - int((expectedLine[x] >> shift) & 0xff));
+        sum += d;
+        difference.max = std::max(difference.max, d);
+      }
+    }
+  }
+  difference.mean = double(sum) / (3.0 * expected.width() * expected.height());
+  return difference;
+}
+
+void checkTransform(const QByteArray& source, const QRect& requestedRect, const int rotation) {
+  QSize imageSize;
+  QSize mcuSize;
+  BOOST_REQUIRE(JpegLosslessTransform::readGeometry(source, &imageSize, &mcuSize));
+
+  const QRect sourceRect(JpegLosslessTransform::alignCrop(requestedRect, rotation, mcuSize, imageSize));
+  BOOST_REQUIRE(!sourceRect.isNull());
+  BOOST_CHECK(sourceRect.contains(requestedRect));
+
+  const QByteArray result(JpegLosslessTransform::transform(source, sourceRect, rotation));
+  BOOST_REQUIRE(!result.isEmpty());
+
+  const QImage actual(decode(result));
+  const QImage expected(decode(source).copy(sourceRect).transformed(QTransform().rotate(rotation)));
+  BOOST_REQUIRE(actual.size() == expected.size());
+
+  const Difference difference(compare(actual, expected));
+  BOOST_TEST_MESSAGE("rotation " << rotation << ": mean " << difference.mean << ", max " << difference.max);
+  BOOST_CHECK_LT(difference.mean, 1.0);
+  BOOST_CHECK_LE(difference.max, 16);
+}
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(JpegLosslessTransformTestSuite)
+
+BOOST_AUTO_TEST_CASE(test_identity_is_exact) {
+  const QByteArray source(encode(makeSourceImage()));
+  const QRect fullRect(QPoint(0, 0), SOURCE_SIZE);
+  const QByteArray result(JpegLosslessTransform::transform(source, fullRect, 0));
+  BOOST_REQUIRE(!result.isEmpty());
+  BOOST_CHECK(decode(result) == decode(source));
+}
+
+BOOST_AUTO_TEST_CASE(test_rotations_and_crops) {
+  const QByteArray source(encode(makeSourceImage()));
+  for (const int rotation : {0, 90, 180, 270}) {
+    checkTransform(source, QRect(21, 13, 150, 110), rotation);
+  }
+  // Crops reaching the aligned image edges.
+  checkTransform(source, QRect(0, 0, 100, 80), 0);
+  checkTransform(source, QRect(40, 0, 90, 60), 270);
+}
+
+BOOST_AUTO_TEST_CASE(test_grayscale) {
+  const QByteArray source(encode(makeSourceImage().convertToFormat(QImage::Format_Grayscale8)));
+  QSize imageSize;
+  QSize mcuSize;
+  BOOST_REQUIRE(JpegLosslessTransform::readGeometry(source, &imageSize, &mcuSize));
+  BOOST_CHECK(mcuSize == QSize(8, 8));
+  for (const int rotation : {90, 180, 270}) {
+    checkTransform(source, QRect(9, 30, 120, 101), rotation);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_markers_are_kept) {
+  QImage image(makeSourceImage());
+  image.setColorSpace(QColorSpace(QColorSpace::SRgb));
+  QByteArray source;
+  {
+    QBuffer buffer(&source);
+    buffer.open(QIODevice::WriteOnly);
+    QImageWriter writer(&buffer, "JPEG");
+    writer.setText("Description", "scanned page");
+    BOOST_REQUIRE(writer.write(image));
+  }
+  BOOST_REQUIRE(source.contains("ICC_PROFILE"));
+  BOOST_REQUIRE(source.contains("scanned page"));
+
+  const QByteArray result(JpegLosslessTransform::transform(source, QRect(16, 16, 150, 110), 90));
+  BOOST_REQUIRE(!result.isEmpty());
+  BOOST_CHECK(result.contains("ICC_PROFILE"));
+  BOOST_CHECK(result.contains("scanned page"));
+  BOOST_CHECK(QImage::fromData(result, "JPEG").colorSpace() == image.colorSpace());
+}
+
+BOOST_AUTO_TEST_CASE(test_crop_alignment) {
+  const QSize mcu(16, 16);
+  const QSize image(200, 160);
+  BOOST_CHECK(JpegLosslessTransform::alignCrop(QRect(21, 13, 150, 110), 0, mcu, image) == QRect(16, 0, 155, 123));
+  BOOST_CHECK(JpegLosslessTransform::alignCrop(QRect(21, 13, 150, 110), 180, mcu, image) == QRect(21, 13, 155, 115));
+  BOOST_CHECK(JpegLosslessTransform::alignCrop(QRect(21, 13, 150, 110), 90, mcu, image) == QRect(16, 13, 155, 115));
+  BOOST_CHECK(JpegLosslessTransform::alignCrop(QRect(21, 13, 150, 110), 270, mcu, image) == QRect(21, 0, 155, 123));
+  // The right edge would have to move past the edge of the image.
+  BOOST_CHECK(JpegLosslessTransform::alignCrop(QRect(100, 0, 100, 160), 180, mcu, image).isNull());
+
+  // Misaligned crops are refused rather than silently aligned.
+  const QByteArray source(encode(makeSourceImage()));
+  BOOST_CHECK(JpegLosslessTransform::transform(source, QRect(21, 13, 150, 110), 0).isEmpty());
+  BOOST_CHECK(JpegLosslessTransform::transform(source, QRect(0, 0, 64, 64), 45).isEmpty());
+  BOOST_CHECK(JpegLosslessTransform::transform(QByteArray("not a jpeg"), QRect(0, 0, 64, 64), 0).isEmpty());
+}
+
+BOOST_AUTO_TEST_CASE(test_decompose) {
+  int rotation = -1;
+  QRect sourceRect;
+
+  // A 203x157 source rotated clockwise and cropped by 10 pixels from every side.
+  const QTransform rotated(QTransform(0, 1, -1, 0, SOURCE_SIZE.height(), 0) * QTransform::fromTranslate(-10, -10));
+  BOOST_REQUIRE(JpegLosslessTransform::decompose(rotated, QSize(137, 183), &rotation, &sourceRect));
+  BOOST_CHECK_EQUAL(rotation, 90);
+  BOOST_CHECK(sourceRect == QRect(10, 10, 183, 137));
+
+  BOOST_REQUIRE(JpegLosslessTransform::decompose(QTransform::fromTranslate(-5, -7), QSize(50, 40), &rotation,
+                                                 &sourceRect));
+  BOOST_CHECK_EQUAL(rotation, 0);
+  BOOST_CHECK(sourceRect == QRect(5, 7, 50, 40));
+
+  BOOST_REQUIRE(JpegLosslessTransform::decompose(QTransform(-1, 0, 0, -1, 203, 157), SOURCE_SIZE, &rotation,
+                                                 &sourceRect));
+  BOOST_CHECK_EQUAL(rotation, 180);
+  BOOST_CHECK(sourceRect == QRect(QPoint(0, 0), SOURCE_SIZE));
+
+  // Deskewing, scaling and subpixel shifts need resampling.
+  BOOST_CHECK(!JpegLosslessTransform::decompose(QTransform().rotate(0.5), QSize(50, 40), &rotation, &sourceRect));
+  BOOST_CHECK(!JpegLosslessTransform::decompose(QTransform::fromScale(2, 2), QSize(50, 40), &rotation, &sourceRect));
+  BOOST_CHECK(
+      !JpegLosslessTransform::decompose(QTransform::fromTranslate(0.5, 0), QSize(50, 40), &rotation, &sourceRect));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+}  // namespace Tests
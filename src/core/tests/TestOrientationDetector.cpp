@@ -0,0 +1,133 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include <BinaryImage.h>
+#include <Dpi.h>
+#include <GrayImage.h>
+
+#include <QApplication>
+#include <QFont>
+#include <QImage>
+#include <QPainter>
+#include <QString>
+#include <QTransform>
+#include <boost/test/unit_test.hpp>
+#include <cstdlib>
+
+#include "NullTaskStatus.h"
+#include "filters/fix_orientation/OrientationDetector.h"
+
+namespace Tests {
+using namespace imageproc;
+using fix_orientation::DetectedOrientation;
+using fix_orientation::OrientationDetector;
+
+namespace {
+void ensureGuiApplication() {
+  static int argc = 1;
+  static char argv0[] = "test";
+  static char* argv[] = {argv0, nullptr};
+  // A QApplication rather than a QGuiApplication, as other suites in this
+  // process create widgets.
+  if (!QCoreApplication::instance()) {
+    static QApplication app(argc, argv);
+  }
+}
+
+/**
+ * Renders an upright page of running text at the given resolution.
+ */
+QImage renderTextPage(const int dpi) {
+  ensureGuiApplication();
+
+  QImage image(dpi * 17 / 2, dpi * 11, QImage::Format_ARGB32_Premultiplied);
+  image.fill(0xffffffff);
+
+  const QString paragraph(
+      "It was the best of times, it was the worst of times, it was the age of wisdom, "
+      "it was the age of foolishness, it was the epoch of belief, it was the epoch of "
+      "incredulity, it was the season of Light, it was the season of Darkness, it was "
+      "the spring of hope, it was the winter of despair, we had everything before us, "
+      "we had nothing before us, we were all going direct to Heaven, we were all going "
+      "direct the other way. ");
+  QString text;
+  for (int i = 0; i < 6; ++i) {
+    text += paragraph;
+  }
+
+  QPainter painter(&image);
+  painter.setPen(Qt::black);
+  QFont font("Times");
+  font.setPixelSize(dpi * 15 / 100);
+  painter.setFont(font);
+  const int margin = dpi;
+  painter.drawText(image.rect().adjusted(margin, margin, -margin, -margin), Qt::TextWordWrap, text);
+  return image;
+}
+
+// Makes a page that needs to be rotated clockwise by the given angle to become upright.
+QImage turnCounterClockwise(const QImage& image, const int degrees) {
+  return image.transformed(QTransform().rotate(-degrees));
+}
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(OrientationDetectorTestSuite)
+
+BOOST_AUTO_TEST_CASE(test_all_rotations_on_proxy) {
+  const QImage upright(renderTextPage(OrientationDetector::PROXY_DPI));
+
+  OrientationDetector detector;
+  for (int degrees = 0; degrees < 360; degrees += 90) {
+    const BinaryImage proxy(turnCounterClockwise(upright, degrees));
+    const DetectedOrientation orientation(detector.detect(proxy));
+
+    BOOST_TEST_CONTEXT("rotation " << degrees) {
+      BOOST_CHECK_EQUAL(orientation.degrees(), degrees);
+      BOOST_CHECK(orientation.confidence() >= DetectedOrientation::GOOD_CONFIDENCE);
+      BOOST_CHECK(orientation.rotation().toDegrees() == degrees);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_all_rotations_at_scanning_resolution) {
+  const int dpi = 300;
+  const QImage upright(renderTextPage(dpi));
+
+  OrientationDetector detector;
+  for (int degrees = 0; degrees < 360; degrees += 90) {
+    const GrayImage page(turnCounterClockwise(upright, degrees));
+    const DetectedOrientation orientation(detector.detect(NullTaskStatus(), page, Dpi(dpi, dpi)));
+
+    BOOST_TEST_CONTEXT("rotation " << degrees) {
+      BOOST_CHECK_EQUAL(orientation.degrees(), degrees);
+      BOOST_CHECK(orientation.confidence() >= DetectedOrientation::GOOD_CONFIDENCE);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_blank_page) {
+  BinaryImage blank(850, 1100, WHITE);
+
+  OrientationDetector detector;
+  const DetectedOrientation orientation(detector.detect(blank));
+  BOOST_CHECK_EQUAL(orientation.degrees(), 0);
+  BOOST_CHECK(orientation.confidence() < DetectedOrientation::GOOD_CONFIDENCE);
+}
+
+BOOST_AUTO_TEST_CASE(test_noise_is_not_confident) {
+  QImage image(850, 1100, QImage::Format_Mono);
+  image.fill(1);
+
+  std::srand(42);
+  const int numDots = image.width() * image.height() / 20;
+  for (int i = 0; i < numDots; ++i) {
+    image.setPixel(std::rand() % image.width(), std::rand() % image.height(), 0);
+  }
+
+  OrientationDetector detector;
+  const DetectedOrientation orientation(detector.detect(BinaryImage(image)));
+  BOOST_CHECK(orientation.confidence() < DetectedOrientation::GOOD_CONFIDENCE);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+}  // namespace Tests
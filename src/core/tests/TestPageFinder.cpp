@@ -0,0 +1,288 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+// Compares the profile-based page border detection with the previous
+// implementation, which probed QImage pixels of several binarizations,
+// pins the exact borders found on a hand-made image, and checks the page
+// box found for a known page size.
+
+#include <Binarize.h>
+#include <BinaryImage.h>
+#include <GrayImage.h>
+
+#include <QImage>
+#include <QPainter>
+#include <QRect>
+#include <QRectF>
+#include <QSizeF>
+#include <QTransform>
+#include <algorithm>
+#include <boost/test/unit_test.hpp>
+#include <cstdlib>
+#include <vector>
+
+#include "FilterData.h"
+#include "NullTaskStatus.h"
+#include "filters/page_box/PageFinder.h"
+
+namespace Tests {
+using namespace imageproc;
+using page_box::PageFinder;
+
+namespace {
+const int kScanW = 1300;
+const int kScanH = 1800;
+// 150 DPI in dots per meter.
+const int kDpm150 = 5906;
+
+/**
+ * A 150 dpi gray scan of a page lying on a dark scanner lid.
+ */
+GrayImage makeScan(const QRect& page, const double angle, const int shadowWidth, const unsigned seed) {
+  QImage image(kScanW, kScanH, QImage::Format_Grayscale8);
+  image.fill(QColor(25, 25, 25));
+  {
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    QTransform xform;
+    xform.translate(page.center().x(), page.center().y());
+    xform.rotate(angle);
+    xform.translate(-page.center().x(), -page.center().y());
+    painter.setTransform(xform);
+    painter.fillRect(page, QColor(232, 230, 228));
+
+    // Binding shadow along the left edge of the page.
+    for (int i = 0; i < shadowWidth; ++i) {
+      const int level = 120 + (110 * i) / std::max(1, shadowWidth);
+      painter.fillRect(QRect(page.left() + i, page.top(), 1, page.height()), QColor(level, level, level));
+    }
+
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(QColor(30, 30, 30));
+    for (int y = page.top() + 120; y < page.bottom() - 120; y += 28) {
+      for (int x = page.left() + 110; x < page.right() - 160; x += 70) {
+        painter.drawRect(QRect(x, y, 55, 12));
+      }
+    }
+  }
+
+  std::srand(seed);
+  for (int y = 0; y < image.height(); ++y) {
+    uchar* line = image.scanLine(y);
+    for (int x = 0; x < image.width(); ++x) {
+      const int value = line[x] + (std::rand() % 17) - 8;
+      line[x] = static_cast<uchar>(std::max(0, std::min(255, value)));
+    }
+  }
+  return GrayImage(image);
+}
+
+int legacyDetectEdge(const QImage& img, int start, int end, int inc, int mid, Qt::Orientation orient) {
+  const int minSize = 10;
+  int gap = 0;
+  int i = start, edge = start;
+  const int ms = 0;
+  const int me = 2 * mid;
+  const auto minBp = int(double(me - ms) * 0.95);
+
+  while (i != end) {
+    int blackPixels = 0;
+    for (int j = ms; j != me; j++) {
+      const int x = (orient == Qt::Vertical) ? j : i;
+      const int y = (orient == Qt::Vertical) ? i : j;
+      if (img.pixelIndex(x, y) == Qt::color1) {
+        ++blackPixels;
+      }
+    }
+    if (blackPixels < minBp) {
+      ++gap;
+    } else {
+      gap = 0;
+      edge = i;
+    }
+    if (gap > minSize) {
+      break;
+    }
+    i += inc;
+  }
+  return edge;
+}
+
+bool legacyFineTuneCorner(const QImage& img, int& x, int& y, int maxX, int maxY, int incX, int incY) {
+  const int tx = x + incX;
+  const int ty = y + incY;
+  if ((img.pixelIndex(x, y) != Qt::color1) || (tx < 0) || (tx > (img.width() - 1)) || (ty < 0)
+      || (ty > (img.height() - 1))) {
+    return true;
+  }
+  x = tx;
+  y = ty;
+  return false;
+}
+
+/**
+ * The previous implementation for the case of an unknown page size.
+ */
+QRect legacyFindPageBorders(const GrayImage& gray, const bool fineTune) {
+  const QImage img(binarizeSauvola(gray, gray.size()).toQImage());
+
+  int l = 0, t = 0, r = img.width() - 1, b = img.height() - 1;
+  const int xmid = r / 2;
+  const int ymid = b / 2;
+  l = legacyDetectEdge(img, l, r, 1, ymid, Qt::Horizontal);
+  t = legacyDetectEdge(img, t, b, 1, xmid, Qt::Vertical);
+  r = legacyDetectEdge(img, r, 0, -1, ymid, Qt::Horizontal);
+  b = legacyDetectEdge(img, b, t, -1, xmid, Qt::Vertical);
+
+  if (fineTune) {
+    bool done = false;
+    while (!done) {
+      done = legacyFineTuneCorner(img, l, t, r, b, 1, 1);
+      done &= legacyFineTuneCorner(img, r, t, l, b, -1, 1);
+      done &= legacyFineTuneCorner(img, l, b, r, t, 1, -1);
+      done &= legacyFineTuneCorner(img, r, b, l, t, -1, -1);
+    }
+  }
+  return QRect(l, t, r - l + 1, b - t + 1);
+}
+
+QRect findPageBorders(const GrayImage& gray, const bool fineTune, const QSize& expectedSize = QSize()) {
+  const BinaryImage bw(binarizeSauvola(gray, gray.size()));
+  return PageFinder::findPageBorders(bw, fineTune, expectedSize, expectedSize.isEmpty() ? 1.0 : 0.1);
+}
+
+/**
+ * A 200x120 scan with a 160x100 page at (20, 10), a black wedge in the
+ * top left corner of the page and a black diagonal streak, connected to
+ * the border at one end only, in its bottom right corner.
+ */
+BinaryImage makeBinaryScan() {
+  BinaryImage image(200, 120, BLACK);
+  image.fill(QRect(20, 10, 160, 100), WHITE);
+  for (int y = 10; y < 16; ++y) {
+    for (int x = 20; x < 26 - (y - 10); ++x) {
+      image.setPixel(x, y, BLACK);
+    }
+  }
+  for (int i = 0; i < 5; ++i) {
+    image.setPixel(179 - i, 109 - i, BLACK);
+  }
+  return image;
+}
+
+void checkEqual(const QRect& actual, const int left, const int top, const int right, const int bottom) {
+  BOOST_CHECK_EQUAL(actual.left(), left);
+  BOOST_CHECK_EQUAL(actual.top(), top);
+  BOOST_CHECK_EQUAL(actual.right(), right);
+  BOOST_CHECK_EQUAL(actual.bottom(), bottom);
+}
+
+void checkClose(const QRect& actual, const QRect& expected, const int tolerance) {
+  BOOST_TEST_CONTEXT("actual " << actual.left() << ',' << actual.top() << ',' << actual.right() << ','
+                               << actual.bottom() << " expected " << expected.left() << ',' << expected.top()
+                               << ',' << expected.right() << ',' << expected.bottom()) {
+    BOOST_CHECK_LE(std::abs(actual.left() - expected.left()), tolerance);
+    BOOST_CHECK_LE(std::abs(actual.top() - expected.top()), tolerance);
+    BOOST_CHECK_LE(std::abs(actual.right() - expected.right()), tolerance);
+    BOOST_CHECK_LE(std::abs(actual.bottom() - expected.bottom()), tolerance);
+  }
+}
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(PageFinderTestSuite)
+
+BOOST_AUTO_TEST_CASE(test_straight_page_matches_legacy) {
+  const QRect page(80, 60, 1100, 1650);
+  const GrayImage scan(makeScan(page, 0.0, 0, 1));
+
+  for (const bool fineTune : {false, true}) {
+    const QRect expected(legacyFindPageBorders(scan, fineTune));
+    const QRect actual(findPageBorders(scan, fineTune));
+    checkClose(actual, expected, 2);
+    checkClose(actual, page.adjusted(-1, -1, 1, 1), 3);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_rotated_page_matches_legacy) {
+  const QRect page(110, 90, 1060, 1600);
+  const GrayImage scan(makeScan(page, 0.8, 0, 2));
+
+  for (const bool fineTune : {false, true}) {
+    const QRect expected(legacyFindPageBorders(scan, fineTune));
+    const QRect actual(findPageBorders(scan, fineTune));
+    checkClose(actual, expected, 3);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_binding_shadow_matches_legacy) {
+  const QRect page(60, 70, 1150, 1640);
+  const GrayImage scan(makeScan(page, 0.0, 25, 3));
+
+  const QRect expected(legacyFindPageBorders(scan, true));
+  const QRect actual(findPageBorders(scan, true));
+  checkClose(actual, expected, 3);
+}
+
+BOOST_AUTO_TEST_CASE(test_page_touching_scan_edge) {
+  const QRect page(0, 0, 1200, kScanH);
+  const GrayImage scan(makeScan(page, 0.0, 0, 4));
+
+  const QRect actual(findPageBorders(scan, true));
+  checkClose(actual, legacyFindPageBorders(scan, true), 2);
+  BOOST_CHECK_EQUAL(actual.left(), 0);
+  BOOST_CHECK_EQUAL(actual.top(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_expected_size_limits_fine_tuning) {
+  const QRect page(100, 100, 1000, 1500);
+  const GrayImage scan(makeScan(page, 1.5, 0, 5));
+
+  const QSize expectedSize(page.size());
+  const QRect actual(findPageBorders(scan, true, expectedSize));
+  BOOST_CHECK_GE(actual.width(), int(expectedSize.width() * 0.9));
+  BOOST_CHECK_GE(actual.height(), int(expectedSize.height() * 0.9));
+}
+
+BOOST_AUTO_TEST_CASE(test_exact_borders) {
+  const BinaryImage image(makeBinaryScan());
+
+  // The last lines at least 95% black.
+  checkEqual(PageFinder::findPageBorders(image, false, QSize(), 1.0), 19, 9, 180, 110);
+  // The top left corner cuts through the wedge, and the bottom right one
+  // follows the streak to its end, as it stays on black pixels.
+  checkEqual(PageFinder::findPageBorders(image, true, QSize(), 1.0), 23, 13, 174, 104);
+  // Moving the corners stops before the box gets 10% smaller than expected.
+  checkEqual(PageFinder::findPageBorders(image, true, QSize(170, 105), 0.1), 23, 13, 176, 106);
+}
+
+BOOST_AUTO_TEST_CASE(test_binarizations_match_binarize_functions) {
+  const GrayImage scan(makeScan(QRect(80, 60, 1100, 1650), 0.8, 25, 7));
+
+  const std::vector<BinaryImage> all(PageFinder::binarize(scan, true));
+  BOOST_REQUIRE_EQUAL(all.size(), 5u);
+  BOOST_CHECK(all[0] == peakThreshold(scan));
+  BOOST_CHECK(all[1] == binarizeOtsu(scan));
+  BOOST_CHECK(all[2] == binarizeMokji(scan));
+  BOOST_CHECK(all[3] == binarizeSauvola(scan, scan.size()));
+  BOOST_CHECK(all[4] == binarizeWolf(scan, scan.size()));
+
+  const std::vector<BinaryImage> sauvolaOnly(PageFinder::binarize(scan, false));
+  BOOST_REQUIRE_EQUAL(sauvolaOnly.size(), 1u);
+  BOOST_CHECK(sauvolaOnly[0] == all[3]);
+}
+
+BOOST_AUTO_TEST_CASE(test_page_box_of_known_size) {
+  // A5 at 150 DPI, with a binding shadow that makes the left edge ambiguous.
+  const QRect page(150, 120, 874, 1240);
+  QImage scan(makeScan(page, 0.0, 25, 6).toQImage());
+  scan.setDotsPerMeterX(kDpm150);
+  scan.setDotsPerMeterY(kDpm150);
+
+  const NullTaskStatus status;
+  const FilterData data(scan);
+  const QRectF box(PageFinder::findPageBox(status, data, true, QSizeF(148, 210), 0.1));
+  checkClose(box.toRect(), page, 3);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+}  // namespace Tests
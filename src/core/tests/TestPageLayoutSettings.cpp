@@ -0,0 +1,183 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include <QRectF>
+#include <QSizeF>
+#include <QString>
+#include <boost/test/unit_test.hpp>
+#include <set>
+#include <vector>
+
+#include "ImageId.h"
+#include "Margins.h"
+#include "PageId.h"
+#include "filters/page_layout/Alignment.h"
+#include "filters/page_layout/Params.h"
+#include "filters/page_layout/Settings.h"
+
+namespace Tests {
+using page_layout::Alignment;
+using page_layout::Params;
+using page_layout::Settings;
+
+namespace {
+const double PIXELS_PER_MM = 4.0;
+const Margins HARD_MARGINS(10.0, 5.0, 10.0, 5.0);
+
+PageId makePageId(const int index) {
+  return PageId(ImageId(QString("page%1.png").arg(index)));
+}
+
+Alignment nullAlignment() {
+  Alignment alignment;
+  alignment.setNull(true);
+  return alignment;
+}
+
+/**
+ * Registers a page whose content is \p contentSizeMm large and is placed
+ * 20 mm away from the top-left corner of the page.
+ */
+void addPage(Settings& settings,
+             const PageId& pageId,
+             const QSizeF& contentSizeMm,
+             const Alignment& alignment,
+             const bool autoMargins = false,
+             const bool fullBleed = false) {
+  QRectF contentRect;
+  QRectF pageRect;
+  if (contentSizeMm.isValid()) {
+    contentRect = QRectF(20.0 * PIXELS_PER_MM, 20.0 * PIXELS_PER_MM, contentSizeMm.width() * PIXELS_PER_MM,
+                         contentSizeMm.height() * PIXELS_PER_MM);
+    pageRect = QRectF(0.0, 0.0, (contentSizeMm.width() + 50.0) * PIXELS_PER_MM,
+                      (contentSizeMm.height() + 60.0) * PIXELS_PER_MM);
+  }
+  settings.setPageParams(pageId,
+                         Params(HARD_MARGINS, pageRect, contentRect, contentSizeMm, alignment, autoMargins, fullBleed));
+}
+
+bool contains(const std::set<PageId>& pages, const PageId& pageId) {
+  return pages.find(pageId) != pages.end();
+}
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(PageLayoutSettingsTestSuite)
+
+BOOST_AUTO_TEST_CASE(test_foldout_invalidates_only_aligned_pages) {
+  Settings settings;
+  const QSizeF bodySize(150.0, 220.0);
+  const Alignment defaultAlignment(Alignment::TOP, Alignment::HCENTER);
+
+  std::vector<PageId> bodyPages;
+  for (int i = 0; i < 3; ++i) {
+    bodyPages.push_back(makePageId(i));
+    addPage(settings, bodyPages.back(), bodySize, defaultAlignment);
+  }
+  const PageId ownAlignmentPage(makePageId(10));
+  addPage(settings, ownAlignmentPage, bodySize, nullAlignment());
+  const PageId fullBleedPage(makePageId(11));
+  addPage(settings, fullBleedPage, bodySize, defaultAlignment, false, true);
+  const PageId autoMarginsPage(makePageId(12));
+  addPage(settings, autoMarginsPage, bodySize, defaultAlignment, true);
+  const PageId unknownSizePage(makePageId(13));
+  addPage(settings, unknownSizePage, QSizeF(), defaultAlignment, true);
+  const PageId foldout(makePageId(20));
+  addPage(settings, foldout, bodySize, defaultAlignment);
+
+  const QSizeF aggSizeBefore(settings.getAggregateHardSizeMM());
+  BOOST_REQUIRE(settings.setContentSizeMM(foldout, QSizeF(400.0, 220.0)) == Settings::AGGREGATE_SIZE_CHANGED);
+  const QSizeF aggSizeAfter(settings.getAggregateHardSizeMM());
+  BOOST_CHECK_EQUAL(aggSizeAfter.width(), 420.0);
+  BOOST_CHECK_EQUAL(aggSizeAfter.height(), aggSizeBefore.height());
+
+  const std::set<PageId> affected(settings.getPagesAffectedByAggregateSizeChange(aggSizeBefore, aggSizeAfter));
+  for (const PageId& pageId : bodyPages) {
+    BOOST_CHECK(contains(affected, pageId));
+  }
+  BOOST_CHECK(contains(affected, autoMarginsPage));
+  BOOST_CHECK(contains(affected, unknownSizePage));
+  BOOST_CHECK(!contains(affected, ownAlignmentPage));
+  BOOST_CHECK(!contains(affected, fullBleedPage));
+  // The foldout defines the new aggregate width, so it gets no soft margins either way.
+  BOOST_CHECK(!contains(affected, foldout));
+  BOOST_CHECK_EQUAL(affected.size(), bodyPages.size() + 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_unchanged_aggregate_affects_nothing) {
+  Settings settings;
+  const Alignment alignment(Alignment::VCENTER, Alignment::HCENTER);
+  addPage(settings, makePageId(0), QSizeF(150.0, 220.0), alignment);
+  addPage(settings, makePageId(1), QSizeF(140.0, 210.0), alignment);
+  addPage(settings, makePageId(2), QSizeF(), alignment, true);
+
+  const QSizeF aggSizeBefore(settings.getAggregateHardSizeMM());
+  BOOST_REQUIRE(settings.setContentSizeMM(makePageId(1), QSizeF(145.0, 215.0))
+                == Settings::AGGREGATE_SIZE_UNCHANGED);
+  const QSizeF aggSizeAfter(settings.getAggregateHardSizeMM());
+
+  BOOST_CHECK(settings.getPagesAffectedByAggregateSizeChange(aggSizeBefore, aggSizeAfter).empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_shrinking_aggregate) {
+  Settings settings;
+  const Alignment alignment(Alignment::TOP, Alignment::HCENTER);
+  const PageId bodyPage(makePageId(0));
+  addPage(settings, bodyPage, QSizeF(150.0, 220.0), alignment);
+  const PageId tallPage(makePageId(1));
+  addPage(settings, tallPage, QSizeF(150.0, 320.0), alignment);
+
+  const QSizeF aggSizeBefore(settings.getAggregateHardSizeMM());
+  BOOST_REQUIRE(settings.setPageAlignment(tallPage, nullAlignment()) == Settings::AGGREGATE_SIZE_CHANGED);
+  const QSizeF aggSizeAfter(settings.getAggregateHardSizeMM());
+
+  const std::set<PageId> affected(settings.getPagesAffectedByAggregateSizeChange(aggSizeBefore, aggSizeAfter));
+  BOOST_CHECK(contains(affected, bodyPage));
+  BOOST_CHECK(!contains(affected, tallPage));
+}
+
+BOOST_AUTO_TEST_CASE(test_alignment_and_auto_margins_combinations) {
+  const Alignment::Vertical verticals[] = {Alignment::TOP, Alignment::VCENTER, Alignment::BOTTOM, Alignment::VAUTO};
+  const Alignment::Horizontal horizontals[] = {Alignment::LEFT, Alignment::HCENTER, Alignment::RIGHT, Alignment::HAUTO};
+  // The pages are 170 x 230 mm with their hard margins, as is the aggregate size to begin with.
+  // Whichever way a page is aligned, a grown aggregate gives it soft margins it didn't have.
+  const QSizeF aggSizeChanges[] = {QSizeF(400.0, 230.0), QSizeF(170.0, 330.0), QSizeF(400.0, 330.0)};
+
+  for (const QSizeF& foldoutHardSize : aggSizeChanges) {
+    Settings settings;
+    std::set<PageId> expected;
+    int index = 0;
+    for (const Alignment::Vertical vertical : verticals) {
+      for (const Alignment::Horizontal horizontal : horizontals) {
+        for (const bool autoMargins : {false, true}) {
+          const PageId pageId(makePageId(index++));
+          addPage(settings, pageId, QSizeF(150.0, 220.0), Alignment(vertical, horizontal), autoMargins);
+          expected.insert(pageId);
+        }
+      }
+    }
+    // Pages not aligned with others never get soft margins.
+    for (const bool autoMargins : {false, true}) {
+      addPage(settings, makePageId(index++), QSizeF(150.0, 220.0), nullAlignment(), autoMargins);
+    }
+    // A page exactly as large as the foldout keeps its layout.
+    const PageId largePage(makePageId(index++));
+    addPage(settings, largePage, QSizeF(150.0, 220.0), Alignment(Alignment::TOP, Alignment::HCENTER));
+    const PageId foldout(makePageId(index++));
+    addPage(settings, foldout, QSizeF(150.0, 220.0), Alignment(Alignment::TOP, Alignment::HCENTER));
+
+    const QSizeF contentSize(foldoutHardSize.width() - 20.0, foldoutHardSize.height() - 10.0);
+    const QSizeF aggSizeBefore(settings.getAggregateHardSizeMM());
+    BOOST_REQUIRE(aggSizeBefore == QSizeF(170.0, 230.0));
+    settings.setContentSizeMM(largePage, contentSize);
+    settings.setContentSizeMM(foldout, contentSize);
+    const QSizeF aggSizeAfter(settings.getAggregateHardSizeMM());
+    BOOST_REQUIRE(aggSizeAfter == foldoutHardSize);
+
+    BOOST_TEST_CONTEXT("aggregate " << aggSizeAfter.width() << 'x' << aggSizeAfter.height()) {
+      BOOST_CHECK(settings.getPagesAffectedByAggregateSizeChange(aggSizeBefore, aggSizeAfter) == expected);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+}  // namespace Tests
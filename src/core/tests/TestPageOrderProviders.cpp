@@ -0,0 +1,315 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+// Checks that the key based page orderings are the same as the orderings
+// given by the pairwise comparators the providers used to implement.
+
+#include <QPointF>
+#include <QRectF>
+#include <QSizeF>
+#include <QString>
+#include <algorithm>
+#include <boost/test/unit_test.hpp>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "DeviationProvider.h"
+#include "ImageId.h"
+#include "Margins.h"
+#include "OrderByCompletenessProvider.h"
+#include "OrderByDeviationProvider.h"
+#include "PageId.h"
+#include "filters/page_box/OrderByHeightProvider.h"
+#include "filters/page_box/OrderByWidthProvider.h"
+#include "filters/page_box/Params.h"
+#include "filters/page_box/Settings.h"
+#include "filters/page_layout/Alignment.h"
+#include "filters/page_layout/OrderByHeightProvider.h"
+#include "filters/page_layout/OrderByWidthProvider.h"
+#include "filters/page_layout/Params.h"
+#include "filters/page_layout/Settings.h"
+#include "filters/page_split/OrderBySplitTypeProvider.h"
+#include "filters/page_split/Params.h"
+#include "filters/page_split/Settings.h"
+#include "filters/select_content/OrderByHeightProvider.h"
+#include "filters/select_content/OrderByWidthProvider.h"
+#include "filters/select_content/Params.h"
+#include "filters/select_content/Settings.h"
+
+namespace Tests {
+namespace {
+const int NUM_PAGES = 60;
+
+struct Page {
+  PageId id;
+  bool incomplete;
+};
+
+using Comparator = std::function<bool(const PageId&, bool, const PageId&, bool)>;
+
+std::vector<Page> makePages() {
+  std::vector<Page> pages;
+  for (int i = 0; i < NUM_PAGES; ++i) {
+    const auto subPage = static_cast<PageId::SubPage>(std::rand() % 3);
+    pages.push_back({PageId(ImageId(QString("page%1.png").arg(std::rand() % (NUM_PAGES / 2))), subPage),
+                     std::rand() % 4 == 0});
+  }
+  return pages;
+}
+
+/**
+ * Returns a dimension from a small set of values, so that there are many ties.
+ */
+double randomDimension() {
+  return 100.0 + 10.0 * (std::rand() % 6);
+}
+
+void checkSameOrdering(const PageOrderProvider& provider, const Comparator& legacy, const std::vector<Page>& pages) {
+  const std::shared_ptr<const PageOrderProvider> reversed(provider.reversed());
+  for (const Page& lhs : pages) {
+    for (const Page& rhs : pages) {
+      BOOST_TEST_CONTEXT(lhs.id.imageId().filePath().toStdString()
+                         << '/' << lhs.id.subPage() << (lhs.incomplete ? " incomplete" : "") << " vs "
+                         << rhs.id.imageId().filePath().toStdString() << '/' << rhs.id.subPage()
+                         << (rhs.incomplete ? " incomplete" : "")) {
+        BOOST_CHECK_EQUAL(provider.precedes(lhs.id, lhs.incomplete, rhs.id, rhs.incomplete),
+                          legacy(lhs.id, lhs.incomplete, rhs.id, rhs.incomplete));
+        BOOST_CHECK_EQUAL(reversed->precedes(lhs.id, lhs.incomplete, rhs.id, rhs.incomplete),
+                          legacy(rhs.id, rhs.incomplete, lhs.id, lhs.incomplete));
+      }
+    }
+  }
+
+  // Sorting by precomputed keys gives the same sequence as sorting by the comparator.
+  std::vector<Page> byComparator(pages);
+  std::stable_sort(byComparator.begin(), byComparator.end(), [&legacy](const Page& lhs, const Page& rhs) {
+    return legacy(lhs.id, lhs.incomplete, rhs.id, rhs.incomplete);
+  });
+
+  std::vector<std::pair<PageOrderKey, Page>> keyed;
+  for (const Page& page : pages) {
+    keyed.emplace_back(provider.sortKey(page.id, page.incomplete), page);
+  }
+  std::stable_sort(keyed.begin(), keyed.end(),
+                   [](const std::pair<PageOrderKey, Page>& lhs, const std::pair<PageOrderKey, Page>& rhs) {
+                     return lhs.first < rhs.first;
+                   });
+
+  for (size_t i = 0; i < pages.size(); ++i) {
+    BOOST_CHECK(keyed[i].second.id == byComparator[i].id);
+    BOOST_CHECK_EQUAL(keyed[i].second.incomplete, byComparator[i].incomplete);
+  }
+}
+
+template <typename Size>
+bool legacyPrecedesBySize(const Size& lhsSize,
+                          const bool lhsIncomplete,
+                          const Size& rhsSize,
+                          const bool rhsIncomplete,
+                          const bool byWidth) {
+  const bool lhsValid = !lhsIncomplete && lhsSize.isValid();
+  const bool rhsValid = !rhsIncomplete && rhsSize.isValid();
+
+  if (lhsValid != rhsValid) {
+    return lhsValid;
+  }
+  return byWidth ? (lhsSize.width() < rhsSize.width()) : (lhsSize.height() < rhsSize.height());
+}
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(PageOrderProvidersTestSuite)
+
+BOOST_AUTO_TEST_CASE(test_select_content_size_orderings) {
+  std::srand(1);
+  const std::vector<Page> pages(makePages());
+  auto settings = std::make_shared<select_content::Settings>();
+  for (const Page& page : pages) {
+    switch (std::rand() % 5) {
+      case 0:
+        // No params at all.
+        break;
+      case 1:
+        settings->setPageParams(page.id, select_content::Params(QRectF(), QSizeF(), QRectF(),
+                                                                select_content::Dependencies(), MODE_AUTO,
+                                                                MODE_AUTO, false));
+        break;
+      default: {
+        const QSizeF sizeMm(randomDimension(), randomDimension());
+        settings->setPageParams(page.id, select_content::Params(QRectF(QPointF(10, 10), sizeMm), sizeMm,
+                                                                QRectF(0, 0, 300, 400), select_content::Dependencies(),
+                                                                MODE_AUTO, MODE_AUTO, false));
+      }
+    }
+  }
+
+  const auto legacy = [&settings](const bool byWidth) {
+    return [settings, byWidth](const PageId& lhsPage, bool lhsIncomplete, const PageId& rhsPage, bool rhsIncomplete) {
+      const std::unique_ptr<select_content::Params> lhsParams(settings->getPageParams(lhsPage));
+      const std::unique_ptr<select_content::Params> rhsParams(settings->getPageParams(rhsPage));
+      const QSizeF lhsSize(lhsParams ? lhsParams->contentSizeMM() : QSizeF());
+      const QSizeF rhsSize(rhsParams ? rhsParams->contentSizeMM() : QSizeF());
+      return legacyPrecedesBySize(lhsSize, lhsIncomplete, rhsSize, rhsIncomplete, byWidth);
+    };
+  };
+
+  checkSameOrdering(*std::make_shared<select_content::OrderByWidthProvider>(settings), legacy(true), pages);
+  checkSameOrdering(*std::make_shared<select_content::OrderByHeightProvider>(settings), legacy(false), pages);
+}
+
+BOOST_AUTO_TEST_CASE(test_page_box_size_orderings) {
+  std::srand(2);
+  const std::vector<Page> pages(makePages());
+  auto settings = std::make_shared<page_box::Settings>();
+  for (const Page& page : pages) {
+    switch (std::rand() % 5) {
+      case 0:
+        break;
+      case 1:
+        settings->setPageParams(page.id, page_box::Params(QRectF(), page_box::Dependencies(), MODE_AUTO, false));
+        break;
+      default:
+        settings->setPageParams(page.id, page_box::Params(QRectF(5, 5, randomDimension(), randomDimension()),
+                                                          page_box::Dependencies(), MODE_AUTO, false));
+    }
+  }
+
+  const auto legacy = [&settings](const bool byWidth) {
+    return [settings, byWidth](const PageId& lhsPage, bool lhsIncomplete, const PageId& rhsPage, bool rhsIncomplete) {
+      const std::unique_ptr<page_box::Params> lhsParams(settings->getPageParams(lhsPage));
+      const std::unique_ptr<page_box::Params> rhsParams(settings->getPageParams(rhsPage));
+      const QRectF lhsRect(lhsParams ? lhsParams->pageRect() : QRectF());
+      const QRectF rhsRect(rhsParams ? rhsParams->pageRect() : QRectF());
+      return legacyPrecedesBySize(lhsRect, lhsIncomplete, rhsRect, rhsIncomplete, byWidth);
+    };
+  };
+
+  checkSameOrdering(*std::make_shared<page_box::OrderByWidthProvider>(settings), legacy(true), pages);
+  checkSameOrdering(*std::make_shared<page_box::OrderByHeightProvider>(settings), legacy(false), pages);
+}
+
+BOOST_AUTO_TEST_CASE(test_page_layout_size_orderings) {
+  std::srand(3);
+  const std::vector<Page> pages(makePages());
+  auto settings = std::make_shared<page_layout::Settings>();
+  for (const Page& page : pages) {
+    if (std::rand() % 5 == 0) {
+      continue;
+    }
+    const QSizeF contentSizeMm((std::rand() % 5 == 0) ? QSizeF() : QSizeF(randomDimension(), randomDimension()));
+    const Margins hardMargins(std::rand() % 3, 5.0, std::rand() % 3, 5.0);
+    settings->setPageParams(page.id,
+                            page_layout::Params(hardMargins, QRectF(0, 0, 400, 500), QRectF(20, 20, 300, 400),
+                                                contentSizeMm, page_layout::Alignment(), false, false));
+  }
+
+  const auto legacy = [&settings](const bool byWidth) {
+    return [settings, byWidth](const PageId& lhsPage, bool lhsIncomplete, const PageId& rhsPage, bool rhsIncomplete) {
+      const auto hardSize = [&settings](const PageId& pageId) {
+        const std::unique_ptr<page_layout::Params> params(settings->getPageParams(pageId));
+        QSizeF size;
+        if (params) {
+          const Margins margins(params->hardMarginsMM());
+          size = params->contentSizeMM();
+          size += QSizeF(margins.left() + margins.right(), margins.top() + margins.bottom());
+        }
+        return size;
+      };
+      return legacyPrecedesBySize(hardSize(lhsPage), lhsIncomplete, hardSize(rhsPage), rhsIncomplete, byWidth);
+    };
+  };
+
+  checkSameOrdering(*std::make_shared<page_layout::OrderByWidthProvider>(settings), legacy(true), pages);
+  checkSameOrdering(*std::make_shared<page_layout::OrderByHeightProvider>(settings), legacy(false), pages);
+}
+
+BOOST_AUTO_TEST_CASE(test_split_type_ordering) {
+  std::srand(4);
+  const std::vector<Page> pages(makePages());
+  auto settings = std::make_shared<page_split::Settings>();
+  const page_split::LayoutType layoutTypes[]
+      = {page_split::AUTO_LAYOUT_TYPE, page_split::SINGLE_PAGE_UNCUT, page_split::PAGE_PLUS_OFFCUT,
+         page_split::TWO_PAGES};
+  for (const Page& page : pages) {
+    if (std::rand() % 4 != 0) {
+      settings->setLayoutTypeFor(layoutTypes[std::rand() % 4], std::set<PageId>{page.id});
+    }
+  }
+
+  const Comparator legacy = [settings](const PageId& lhsPage, bool lhsIncomplete, const PageId& rhsPage,
+                                       bool rhsIncomplete) {
+    if (lhsIncomplete != rhsIncomplete) {
+      return rhsIncomplete;
+    } else if (lhsIncomplete) {
+      return lhsPage < rhsPage;
+    }
+
+    const auto layoutType = [&settings](const PageId& pageId) {
+      const page_split::Settings::Record record(settings->getPageRecord(pageId.imageId()));
+      int type = record.combinedLayoutType();
+      if (record.params()) {
+        type = record.params()->pageLayout().toLayoutType();
+      }
+      return (type == page_split::AUTO_LAYOUT_TYPE) ? 100 : type;
+    };
+    const int lhsLayoutType = layoutType(lhsPage);
+    const int rhsLayoutType = layoutType(rhsPage);
+    if (lhsLayoutType == rhsLayoutType) {
+      return lhsPage < rhsPage;
+    } else {
+      return lhsLayoutType < rhsLayoutType;
+    }
+  };
+
+  checkSameOrdering(*std::make_shared<page_split::OrderBySplitTypeProvider>(settings), legacy, pages);
+}
+
+BOOST_AUTO_TEST_CASE(test_deviation_ordering) {
+  std::srand(5);
+  const std::vector<Page> pages(makePages());
+  DeviationProvider<PageId> deviationProvider;
+  for (const Page& page : pages) {
+    switch (std::rand() % 6) {
+      case 0:
+        break;
+      case 1:
+        deviationProvider.addOrUpdate(page.id, std::numeric_limits<double>::quiet_NaN());
+        break;
+      default:
+        deviationProvider.addOrUpdate(page.id, 0.1 * (std::rand() % 20));
+    }
+  }
+
+  const Comparator legacy = [&deviationProvider](const PageId& lhsPage, bool lhsIncomplete, const PageId& rhsPage,
+                                                 bool rhsIncomplete) {
+    if (lhsIncomplete != rhsIncomplete) {
+      return lhsIncomplete;
+    }
+    return deviationProvider.getDeviationValue(lhsPage) > deviationProvider.getDeviationValue(rhsPage);
+  };
+
+  checkSameOrdering(*std::make_shared<OrderByDeviationProvider>(deviationProvider), legacy, pages);
+}
+
+BOOST_AUTO_TEST_CASE(test_completeness_ordering) {
+  std::srand(6);
+  const std::vector<Page> pages(makePages());
+  const auto provider = std::make_shared<OrderByCompletenessProvider>();
+  const std::shared_ptr<const PageOrderProvider> reversed(provider->reversed());
+
+  for (const Page& lhs : pages) {
+    for (const Page& rhs : pages) {
+      // Incomplete pages go to the back, the rest keeps its order.
+      BOOST_CHECK_EQUAL(provider->precedes(lhs.id, lhs.incomplete, rhs.id, rhs.incomplete),
+                        !lhs.incomplete && rhs.incomplete);
+      BOOST_CHECK_EQUAL(reversed->precedes(lhs.id, lhs.incomplete, rhs.id, rhs.incomplete),
+                        lhs.incomplete && !rhs.incomplete);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+}  // namespace Tests
@@ -0,0 +1,235 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+// Checks the ImageId index and the shared page sequence snapshots of ProjectPages,
+// with readers and writers running concurrently, and reports how per-page
+// updates scale with the number of pages.
+
+#include <QElapsedTimer>
+#include <QString>
+#include <atomic>
+#include <boost/test/unit_test.hpp>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "AbstractRelinker.h"
+#include "Dpi.h"
+#include "ImageId.h"
+#include "ImageInfo.h"
+#include "ImageMetadata.h"
+#include "OrthogonalRotation.h"
+#include "PageSequence.h"
+#include "ProjectPages.h"
+#include "RelinkablePath.h"
+
+namespace Tests {
+namespace {
+ImageId imageIdAt(const int idx) {
+  return ImageId(QString("/scans/page%1.tif").arg(idx, 5, 10, QChar('0')));
+}
+
+ImageInfo imageInfo(const ImageId& id) {
+  return ImageInfo(id, ImageMetadata(QSize(2000, 3000), Dpi(300, 300)), 1, false, false);
+}
+
+std::vector<ImageInfo> makeImages(const int count) {
+  std::vector<ImageInfo> images;
+  images.reserve(count);
+  for (int i = 0; i < count; ++i) {
+    images.push_back(imageInfo(imageIdAt(i)));
+  }
+  return images;
+}
+
+std::vector<ImageId> imageOrder(const PageSequence& pages) {
+  std::vector<ImageId> order;
+  for (const PageInfo& page : pages) {
+    if (order.empty() || order.back() != page.imageId()) {
+      order.push_back(page.imageId());
+    }
+  }
+  return order;
+}
+
+/**
+ * Checks that the sequence is a coherent picture of \p numImages images, each
+ * split into one or two pages.
+ */
+bool isConsistent(const PageSequence& pages, const int numImages) {
+  if (imageOrder(pages).size() != size_t(numImages)) {
+    return false;
+  }
+  for (const PageInfo& page : pages) {
+    const bool split = page.id().subPage() != PageId::SINGLE_PAGE;
+    if (split != (page.imageSubPages() == 2)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+class MoveToDirRelinker : public AbstractRelinker {
+ public:
+  explicit MoveToDirRelinker(const QString& dir) : m_dir(dir) {}
+
+  QString substitutionPathFor(const RelinkablePath& origPath) const override {
+    return m_dir + origPath.normalizedPath().mid(origPath.normalizedPath().lastIndexOf('/'));
+  }
+
+ private:
+  QString m_dir;
+};
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(ProjectPagesTestSuite)
+
+BOOST_AUTO_TEST_CASE(test_snapshot_is_shared_until_modified) {
+  ProjectPages pages(makeImages(10), Qt::LeftToRight);
+
+  const PageSequence first(pages.toPageSequence(PAGE_VIEW));
+  const PageSequence second(pages.toPageSequence(PAGE_VIEW));
+  BOOST_CHECK(&*first.begin() == &*second.begin());
+
+  const uint64_t version = pages.version();
+  pages.setLayoutTypeFor(imageIdAt(3), ProjectPages::ONE_PAGE_LAYOUT);  // Already one page.
+  BOOST_CHECK_EQUAL(pages.version(), version);
+  BOOST_CHECK(&*pages.toPageSequence(PAGE_VIEW).begin() == &*first.begin());
+
+  pages.setLayoutTypeFor(imageIdAt(3), ProjectPages::TWO_PAGE_LAYOUT);
+  BOOST_CHECK_GT(pages.version(), version);
+  const PageSequence third(pages.toPageSequence(PAGE_VIEW));
+  BOOST_CHECK(&*third.begin() != &*first.begin());
+  BOOST_CHECK_EQUAL(third.numPages(), size_t(11));
+}
+
+BOOST_AUTO_TEST_CASE(test_snapshot_is_unaffected_by_later_changes) {
+  ProjectPages pages(makeImages(10), Qt::LeftToRight);
+  const PageSequence before(pages.toPageSequence(PAGE_VIEW));
+  const PageSequence beforeImages(pages.toPageSequence(IMAGE_VIEW));
+
+  pages.setLayoutTypeForAllPages(ProjectPages::TWO_PAGE_LAYOUT);
+  pages.removePages({PageId(imageIdAt(0), PageId::LEFT_PAGE), PageId(imageIdAt(9), PageId::RIGHT_PAGE)});
+  pages.insertImage(imageInfo(imageIdAt(100)), AFTER, imageIdAt(4), PAGE_VIEW);
+
+  BOOST_CHECK_EQUAL(before.numPages(), size_t(10));
+  BOOST_CHECK_EQUAL(beforeImages.numPages(), size_t(10));
+  for (const PageInfo& page : before) {
+    BOOST_CHECK(page.id().subPage() == PageId::SINGLE_PAGE);
+  }
+  BOOST_CHECK_EQUAL(pages.toPageSequence(PAGE_VIEW).numPages(), size_t(19));
+  BOOST_CHECK_EQUAL(pages.toPageSequence(IMAGE_VIEW).numPages(), size_t(11));
+
+  // Appending to a copy of a snapshot leaves the snapshot alone.
+  PageSequence copy(pages.toPageSequence(IMAGE_VIEW));
+  copy.append(PageInfo(PageId(imageIdAt(200)), ImageMetadata(), 1, false, false));
+  BOOST_CHECK_EQUAL(copy.numPages(), size_t(12));
+  BOOST_CHECK_EQUAL(pages.toPageSequence(IMAGE_VIEW).numPages(), size_t(11));
+}
+
+BOOST_AUTO_TEST_CASE(test_index_follows_insertions_removals_and_relinking) {
+  ProjectPages pages(makeImages(5), Qt::LeftToRight);
+
+  pages.insertImage(imageInfo(imageIdAt(10)), BEFORE, imageIdAt(0), IMAGE_VIEW);
+  pages.insertImage(imageInfo(imageIdAt(11)), AFTER, imageIdAt(2), IMAGE_VIEW);
+  pages.insertImage(imageInfo(imageIdAt(12)), BEFORE, ImageId(), IMAGE_VIEW);
+  BOOST_CHECK(pages.insertImage(imageInfo(imageIdAt(13)), AFTER, imageIdAt(99), IMAGE_VIEW).empty());
+  pages.removePages({PageId(imageIdAt(1), PageId::SINGLE_PAGE)});
+
+  const std::vector<ImageId> expected{imageIdAt(10), imageIdAt(0), imageIdAt(2), imageIdAt(11),
+                                      imageIdAt(3),  imageIdAt(4), imageIdAt(12)};
+  BOOST_CHECK(imageOrder(pages.toPageSequence(IMAGE_VIEW)) == expected);
+
+  // Every image is found at its new position.
+  for (const ImageId& id : expected) {
+    pages.setLayoutTypeFor(id, ProjectPages::TWO_PAGE_LAYOUT);
+  }
+  BOOST_CHECK_EQUAL(pages.toPageSequence(PAGE_VIEW).numPages(), 2 * expected.size());
+
+  // Removed images aren't.
+  const uint64_t version = pages.version();
+  pages.setLayoutTypeFor(imageIdAt(1), ProjectPages::ONE_PAGE_LAYOUT);
+  BOOST_CHECK_EQUAL(pages.version(), version);
+
+  // Half of a page comes back through the index too.
+  pages.removePages({PageId(imageIdAt(3), PageId::LEFT_PAGE)});
+  BOOST_CHECK(!pages.unremovePage(PageId(imageIdAt(3), PageId::LEFT_PAGE)).isNull());
+
+  // After relinking, images are looked up by their new paths.
+  pages.performRelinking(MoveToDirRelinker("/moved"));
+  pages.setLayoutTypeFor(ImageId(QString("/moved/page00003.tif")), ProjectPages::ONE_PAGE_LAYOUT);
+  BOOST_CHECK_EQUAL(pages.toPageSequence(PAGE_VIEW).numPages(), 2 * expected.size() - 1);
+  const uint64_t relinkedVersion = pages.version();
+  pages.setLayoutTypeFor(imageIdAt(4), ProjectPages::ONE_PAGE_LAYOUT);  // The old path.
+  BOOST_CHECK_EQUAL(pages.version(), relinkedVersion);
+}
+
+BOOST_AUTO_TEST_CASE(test_concurrent_readers_and_writers) {
+  const int numImages = 200;
+  ProjectPages pages(makeImages(numImages), Qt::LeftToRight);
+
+  std::atomic<bool> done(false);
+  std::atomic<int> inconsistent(0);
+  std::atomic<int> reads(0);
+
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; ++i) {
+    readers.emplace_back([&] {
+      while (!done.load()) {
+        const PageSequence pageSequence(pages.toPageSequence(PAGE_VIEW));
+        const PageSequence imageSequence(pages.toPageSequence(IMAGE_VIEW));
+        if (!isConsistent(pageSequence, numImages) || (imageSequence.numPages() != size_t(numImages))) {
+          ++inconsistent;
+        }
+        ++reads;
+      }
+    });
+  }
+
+  std::thread writer([&] {
+    for (int round = 0; round < 20; ++round) {
+      for (int i = 0; i < numImages; ++i) {
+        const auto layout = ((i + round) % 2 == 0) ? ProjectPages::TWO_PAGE_LAYOUT : ProjectPages::ONE_PAGE_LAYOUT;
+        pages.setLayoutTypeFor(imageIdAt(i), layout);
+        pages.autoSetLayoutTypeFor(imageIdAt(numImages - 1 - i), OrthogonalRotation());
+      }
+    }
+    done = true;
+  });
+
+  writer.join();
+  for (std::thread& reader : readers) {
+    reader.join();
+  }
+
+  BOOST_TEST_MESSAGE("concurrent snapshot reads: " << reads.load());
+  BOOST_CHECK_EQUAL(inconsistent.load(), 0);
+  BOOST_CHECK(isConsistent(pages.toPageSequence(PAGE_VIEW), numImages));
+}
+
+BOOST_AUTO_TEST_CASE(test_per_page_updates_scale) {
+  // Per call, neither of these should get slower as the project grows.
+  for (const int numImages : {250, 1000, 4000}) {
+    ProjectPages pages(makeImages(numImages), Qt::LeftToRight);
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < numImages; ++i) {
+      pages.setLayoutTypeFor(imageIdAt(i), ProjectPages::TWO_PAGE_LAYOUT);
+    }
+    const qint64 updateMsec = timer.restart();
+
+    size_t totalPages = 0;
+    for (int i = 0; i < numImages; ++i) {
+      totalPages += pages.toPageSequence(PAGE_VIEW).numPages();
+    }
+    const qint64 snapshotMsec = timer.elapsed();
+
+    BOOST_TEST_MESSAGE(numImages << " images: " << updateMsec << " ms for per-page layout updates, " << snapshotMsec
+                                 << " ms for as many unchanged snapshots");
+    BOOST_CHECK_EQUAL(totalPages, size_t(2) * numImages * numImages);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+}  // namespace Tests
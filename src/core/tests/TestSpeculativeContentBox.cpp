@@ -0,0 +1,185 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+// Checks that content boxes detected speculatively are only used when
+// nothing they depend on has changed since, and measures how much faster
+// switching to Select Content gets when one is waiting there.
+
+#include <QElapsedTimer>
+#include <QImage>
+#include <QRectF>
+#include <QString>
+#include <boost/test/unit_test.hpp>
+#include <memory>
+
+#include "FilterData.h"
+#include "ImageSettings.h"
+#include "NullTaskStatus.h"
+#include "PageId.h"
+#include "SpeculativeResultCache.h"
+#include "SyntheticPageCorpus.h"
+#include "filters/select_content/ContentBoxFinder.h"
+#include "filters/select_content/Params.h"
+#include "filters/select_content/Settings.h"
+#include "filters/select_content/Task.h"
+
+namespace Tests {
+using namespace select_content;
+
+namespace {
+PageId makePageId(const QString& name) {
+  return PageId(ImageId(name + ".png"));
+}
+
+/**
+ * Runs Select Content the way it runs when the user switches to it,
+ * with the content box yet to be detected.
+ *
+ * \return The time it took, in milliseconds.
+ */
+double switchToSelectContent(const std::shared_ptr<Settings>& settings, const PageId& pageId, const FilterData& data) {
+  settings->setPageParams(pageId, Params(Dependencies()));
+  Task task(nullptr, nullptr, settings, nullptr, pageId, /*batch=*/true, /*debug=*/false, /*speculative=*/false);
+  QElapsedTimer timer;
+  timer.start();
+  task.process(NullTaskStatus(), data);
+  return timer.nsecsElapsed() / 1e6;
+}
+
+/**
+ * Runs the speculative detection for a page the user hasn't visited at Select Content yet.
+ */
+void runSpeculatively(const std::shared_ptr<Settings>& settings, const PageId& pageId, const FilterData& data) {
+  settings->setPageParams(pageId, Params(Dependencies()));
+  Task task(nullptr, nullptr, settings, nullptr, pageId, /*batch=*/true, /*debug=*/false, /*speculative=*/true);
+  BOOST_CHECK(!task.process(NullTaskStatus(), data));
+}
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(SpeculativeContentBoxTestSuite)
+
+BOOST_AUTO_TEST_CASE(test_cache_hands_out_matching_results_only) {
+  SpeculativeResultCache<int, QRectF> cache(2);
+  cache.store(1, "a", QRectF(1, 1, 10, 10));
+  cache.store(2, "b", QRectF(2, 2, 10, 10));
+
+  QRectF result;
+  BOOST_CHECK(cache.find(1, "a", &result));
+  BOOST_CHECK(result == QRectF(1, 1, 10, 10));
+  BOOST_CHECK(cache.contains(2, "b"));
+  BOOST_CHECK(!cache.contains(2, "a"));
+  BOOST_CHECK(cache.contains(2));
+  BOOST_CHECK(!cache.contains(3));
+
+  // A stale result is dropped once found.
+  BOOST_CHECK(!cache.find(2, "c", &result));
+  BOOST_CHECK(!cache.contains(2, "b"));
+  BOOST_CHECK_EQUAL(cache.size(), 1u);
+
+  // The oldest result goes first.
+  cache.store(3, "c", QRectF());
+  cache.store(4, "d", QRectF());
+  BOOST_CHECK_EQUAL(cache.size(), 2u);
+  BOOST_CHECK(!cache.contains(1, "a"));
+  BOOST_CHECK(cache.contains(4, "d"));
+}
+
+BOOST_AUTO_TEST_CASE(test_fingerprint_follows_upstream_params) {
+  const SyntheticPage page(renderSyntheticPageCorpus().front());
+  const FilterData data(page.image);
+  const ImageId imageId(makePageId(page.name).imageId());
+  const QRectF pageRect(data.xform().resultingRect());
+  const auto settings = std::make_shared<Settings>();
+  const QByteArray fingerprint(ContentBoxFinder::fingerprint(imageId, data, pageRect, settings));
+
+  BOOST_CHECK(ContentBoxFinder::fingerprint(imageId, FilterData(data), pageRect, settings) == fingerprint);
+  BOOST_CHECK(ContentBoxFinder::fingerprint(imageId, FilterData(page.image), pageRect, settings) == fingerprint);
+
+  // Deskewing differently.
+  ImageTransformation rotated(data.xform());
+  rotated.setPostRotation(0.5);
+  BOOST_CHECK(ContentBoxFinder::fingerprint(imageId, FilterData(data, rotated), pageRect, settings) != fingerprint);
+
+  // Another page box.
+  BOOST_CHECK(ContentBoxFinder::fingerprint(imageId, data, pageRect.adjusted(10, 10, -10, -10), settings)
+              != fingerprint);
+
+  // Other detection settings.
+  const auto otherSettings = std::make_shared<Settings>();
+  otherSettings->setBorderTolerance(settings->borderTolerance() + 1);
+  BOOST_CHECK(ContentBoxFinder::fingerprint(imageId, data, pageRect, otherSettings) != fingerprint);
+
+  // Another image, or another page of the same file.
+  BOOST_CHECK(ContentBoxFinder::fingerprint(makePageId(page.name + "-other").imageId(), data, pageRect, settings)
+              != fingerprint);
+  BOOST_CHECK(ContentBoxFinder::fingerprint(ImageId(imageId.filePath(), 2), data, pageRect, settings) != fingerprint);
+
+  // Inverted image.
+  FilterData inverted(data);
+  inverted.updateImageParams(ImageSettings::PageParams(data.bwThreshold(), !data.isBlackOnWhite()));
+  BOOST_CHECK(ContentBoxFinder::fingerprint(imageId, inverted, pageRect, settings) != fingerprint);
+}
+
+BOOST_AUTO_TEST_CASE(test_speculative_box_is_used_only_while_valid) {
+  const SyntheticPage page(renderSyntheticPageCorpus().front());
+  const FilterData data(page.image);
+  const PageId pageId(makePageId(page.name));
+
+  // The reference result, without speculation.
+  const auto referenceSettings = std::make_shared<Settings>();
+  switchToSelectContent(referenceSettings, pageId, data);
+  const QRectF expectedBox(referenceSettings->getPageParams(pageId)->contentRect());
+  BOOST_REQUIRE(expectedBox.isValid());
+
+  const auto settings = std::make_shared<Settings>();
+  runSpeculatively(settings, pageId, data);
+  BOOST_CHECK_EQUAL(settings->speculativeContentBoxes().size(), 1u);
+  // The page parameters are left alone.
+  BOOST_CHECK(settings->getPageParams(pageId)->contentRect().isNull());
+
+  switchToSelectContent(settings, pageId, data);
+  BOOST_CHECK(settings->getPageParams(pageId)->contentRect() == expectedBox);
+  BOOST_CHECK_EQUAL(settings->speculativeContentBoxes().size(), 0u);
+
+  // The user deskews the page differently after the speculation.
+  runSpeculatively(settings, pageId, data);
+  ImageTransformation rotated(data.xform());
+  rotated.setPostRotation(2.0);
+  const FilterData rotatedData(data, rotated);
+  switchToSelectContent(settings, pageId, rotatedData);
+  BOOST_CHECK_EQUAL(settings->speculativeContentBoxes().size(), 0u);
+
+  const auto rotatedReferenceSettings = std::make_shared<Settings>();
+  switchToSelectContent(rotatedReferenceSettings, pageId, rotatedData);
+  BOOST_CHECK(settings->getPageParams(pageId)->contentRect()
+              == rotatedReferenceSettings->getPageParams(pageId)->contentRect());
+}
+
+BOOST_AUTO_TEST_CASE(test_stage_switch_latency) {
+  double coldMs = 0;
+  double warmMs = 0;
+  for (const SyntheticPage& page : renderSyntheticPageCorpus()) {
+    const FilterData data(page.image);
+    const PageId pageId(makePageId(page.name));
+
+    const auto coldSettings = std::make_shared<Settings>();
+    const double cold = switchToSelectContent(coldSettings, pageId, data);
+
+    const auto warmSettings = std::make_shared<Settings>();
+    runSpeculatively(warmSettings, pageId, data);
+    const double warm = switchToSelectContent(warmSettings, pageId, data);
+
+    BOOST_CHECK(warmSettings->getPageParams(pageId)->contentRect()
+                == coldSettings->getPageParams(pageId)->contentRect());
+    BOOST_TEST_MESSAGE(page.name.toStdString() << ": " << cold << " ms without speculation, " << warm << " ms with it");
+    coldMs += cold;
+    warmMs += warm;
+  }
+
+  BOOST_TEST_MESSAGE("Switching to Select Content: " << coldMs << " ms without speculation, " << warmMs
+                                                      << " ms with it");
+  BOOST_CHECK_LT(warmMs, coldMs);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+}  // namespace Tests
@@ -0,0 +1,206 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+// Writes pages with and without layers into a book container, replaces some
+// of them and compacts the file, checking that the pages read back, both
+// through the live object and through one opened afresh, are the ones written.
+
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QString>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QVector>
+#include <boost/test/unit_test.hpp>
+#include <cstdint>
+#include <map>
+
+#include "TiffBookContainer.h"
+
+namespace Tests {
+namespace {
+QImage makeColorPage(const int seed) {
+  QImage image(200, 150, QImage::Format_RGB32);
+  for (int y = 0; y < image.height(); ++y) {
+    for (int x = 0; x < image.width(); ++x) {
+      image.setPixel(x, y, qRgb((x + seed) & 0xff, (y * 3 + seed) & 0xff, (x ^ y ^ seed) & 0xff));
+    }
+  }
+  return image;
+}
+
+QImage makeGrayscaleLayer(const int seed) {
+  QImage image(200, 150, QImage::Format_Indexed8);
+  QVector<QRgb> palette(256);
+  for (int i = 0; i < 256; ++i) {
+    palette[i] = qRgb(i, i, i);
+  }
+  image.setColorTable(palette);
+  for (int y = 0; y < image.height(); ++y) {
+    for (int x = 0; x < image.width(); ++x) {
+      image.setPixel(x, y, static_cast<uint>((x * y + seed) & 0xff));
+    }
+  }
+  return image;
+}
+
+QImage makeBitonalLayer(const int seed) {
+  QImage image(200, 150, QImage::Format_Mono);
+  image.setColorTable({qRgb(0xff, 0xff, 0xff), qRgb(0, 0, 0)});
+  image.fill(0);
+  for (int y = seed % 7; y < image.height(); y += 7) {
+    for (int x = 0; x < image.width(); x += 2) {
+      image.setPixel(x, y, 1);
+    }
+  }
+  return image;
+}
+
+bool samePixels(const QImage& actual, const QImage& expected) {
+  return !actual.isNull()
+         && (actual.convertToFormat(QImage::Format_RGB32) == expected.convertToFormat(QImage::Format_RGB32));
+}
+
+TiffBookContainer::Layers makeLayers(const int seed) {
+  return {{TiffBookContainer::FOREGROUND_LAYER, makeBitonalLayer(seed)},
+          {TiffBookContainer::BACKGROUND_LAYER, makeGrayscaleLayer(seed)}};
+}
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(TiffBookContainerTestSuite)
+
+BOOST_AUTO_TEST_CASE(test_pages_and_layers_round_trip) {
+  QTemporaryDir dir;
+  BOOST_REQUIRE(dir.isValid());
+  const QString path(dir.filePath("book.tif"));
+
+  {
+    TiffBookContainer book(path);
+    BOOST_REQUIRE(book.isValid());
+    BOOST_CHECK_EQUAL(book.pageCount(), 0);
+    BOOST_REQUIRE(book.writePage("page1.tif", makeColorPage(1)));
+    BOOST_REQUIRE(book.writePage("page2.tif", makeColorPage(2), makeLayers(2)));
+    BOOST_REQUIRE(book.writePage("page3.tif", makeGrayscaleLayer(3)));
+
+    BOOST_CHECK(samePixels(book.readPage("page2.tif"), makeColorPage(2)));
+    BOOST_CHECK(samePixels(book.readLayer("page2.tif", TiffBookContainer::FOREGROUND_LAYER), makeBitonalLayer(2)));
+  }
+
+  const TiffBookContainer book(path);
+  BOOST_REQUIRE(book.isValid());
+  BOOST_CHECK(book.keys() == QStringList({"page1.tif", "page2.tif", "page3.tif"}));
+  BOOST_CHECK(!book.contains("page4.tif"));
+  BOOST_CHECK_EQUAL(book.pageStamp("page4.tif"), 0u);
+  BOOST_CHECK_NE(book.pageStamp("page1.tif"), 0u);
+
+  BOOST_CHECK(samePixels(book.readPage("page1.tif"), makeColorPage(1)));
+  BOOST_CHECK(samePixels(book.readPage("page2.tif"), makeColorPage(2)));
+  BOOST_CHECK(samePixels(book.readPage("page3.tif"), makeGrayscaleLayer(3)));
+
+  BOOST_CHECK(!book.hasLayer("page1.tif", TiffBookContainer::FOREGROUND_LAYER));
+  BOOST_CHECK(book.hasLayer("page2.tif", TiffBookContainer::FOREGROUND_LAYER));
+  BOOST_CHECK(book.hasLayer("page2.tif", TiffBookContainer::BACKGROUND_LAYER));
+  BOOST_CHECK(!book.hasLayer("page2.tif", TiffBookContainer::AUTOMASK_LAYER));
+  BOOST_CHECK(samePixels(book.readLayer("page2.tif", TiffBookContainer::FOREGROUND_LAYER), makeBitonalLayer(2)));
+  BOOST_CHECK(samePixels(book.readLayer("page2.tif", TiffBookContainer::BACKGROUND_LAYER), makeGrayscaleLayer(2)));
+  BOOST_CHECK(book.readLayer("page2.tif", TiffBookContainer::SPECKLES_LAYER).isNull());
+}
+
+BOOST_AUTO_TEST_CASE(test_replacing_pages) {
+  QTemporaryDir dir;
+  BOOST_REQUIRE(dir.isValid());
+  const QString path(dir.filePath("book.tif"));
+
+  TiffBookContainer book(path);
+  for (int i = 1; i <= 4; ++i) {
+    BOOST_REQUIRE(book.writePage(QString("page%1.tif").arg(i), makeColorPage(i), makeLayers(i)));
+  }
+  const uint64_t oldStamp = book.pageStamp("page2.tif");
+
+  // Replace pages in the middle and at both ends of the chain.
+  BOOST_REQUIRE(book.writePage("page2.tif", makeColorPage(20), makeLayers(20)));
+  BOOST_REQUIRE(book.writePage("page1.tif", makeColorPage(10)));
+  BOOST_REQUIRE(book.writePage("page1.tif", makeColorPage(11), makeLayers(11)));
+  BOOST_CHECK_NE(book.pageStamp("page2.tif"), oldStamp);
+  BOOST_CHECK_EQUAL(book.pageCount(), 4);
+
+  const QStringList expectedKeys({"page3.tif", "page4.tif", "page2.tif", "page1.tif"});
+  BOOST_CHECK(book.keys() == expectedKeys);
+
+  const TiffBookContainer reopened(path);
+  BOOST_REQUIRE(reopened.isValid());
+  BOOST_CHECK(reopened.keys() == expectedKeys);
+  for (const QString& key : expectedKeys) {
+    BOOST_CHECK_EQUAL(reopened.pageStamp(key), book.pageStamp(key));
+  }
+  BOOST_CHECK(samePixels(reopened.readPage("page1.tif"), makeColorPage(11)));
+  BOOST_CHECK(samePixels(reopened.readPage("page2.tif"), makeColorPage(20)));
+  BOOST_CHECK(samePixels(reopened.readPage("page3.tif"), makeColorPage(3)));
+  BOOST_CHECK(
+      samePixels(reopened.readLayer("page2.tif", TiffBookContainer::BACKGROUND_LAYER), makeGrayscaleLayer(20)));
+  BOOST_CHECK(samePixels(reopened.readLayer("page1.tif", TiffBookContainer::FOREGROUND_LAYER), makeBitonalLayer(11)));
+}
+
+BOOST_AUTO_TEST_CASE(test_compacting) {
+  QTemporaryDir dir;
+  BOOST_REQUIRE(dir.isValid());
+  const QString path(dir.filePath("book.tif"));
+
+  TiffBookContainer book(path);
+  for (int i = 1; i <= 3; ++i) {
+    BOOST_REQUIRE(book.writePage(QString("page%1.tif").arg(i), makeColorPage(i), makeLayers(i)));
+  }
+  for (int round = 0; round < 3; ++round) {
+    BOOST_REQUIRE(book.writePage("page2.tif", makeColorPage(20 + round), makeLayers(20 + round)));
+  }
+  const QStringList keysBefore(book.keys());
+  const qint64 sizeBefore = QFileInfo(path).size();
+  std::map<QString, uint64_t> stampsBefore;
+  for (const QString& key : keysBefore) {
+    stampsBefore[key] = book.pageStamp(key);
+  }
+
+  BOOST_REQUIRE(book.compact());
+  BOOST_CHECK_LT(QFileInfo(path).size(), sizeBefore);
+  BOOST_CHECK(!QFileInfo::exists(path + ".compact"));
+  BOOST_CHECK(book.keys() == keysBefore);
+
+  // Compacting doesn't make pages look rewritten.
+  const TiffBookContainer reopened(path);
+  BOOST_CHECK(reopened.keys() == keysBefore);
+  for (const QString& key : keysBefore) {
+    BOOST_CHECK_EQUAL(book.pageStamp(key), stampsBefore[key]);
+    BOOST_CHECK_EQUAL(reopened.pageStamp(key), stampsBefore[key]);
+  }
+  BOOST_CHECK(samePixels(reopened.readPage("page2.tif"), makeColorPage(22)));
+  BOOST_CHECK(samePixels(reopened.readLayer("page2.tif", TiffBookContainer::FOREGROUND_LAYER), makeBitonalLayer(22)));
+  BOOST_CHECK(samePixels(reopened.readPage("page3.tif"), makeColorPage(3)));
+
+  // Still writable after compacting, with stamps not seen before.
+  BOOST_REQUIRE(book.writePage("page4.tif", makeColorPage(4)));
+  BOOST_REQUIRE(book.writePage("page2.tif", makeColorPage(23)));
+  BOOST_CHECK(samePixels(TiffBookContainer(path).readPage("page4.tif"), makeColorPage(4)));
+  for (const auto& keyAndStamp : stampsBefore) {
+    BOOST_CHECK_NE(book.pageStamp("page4.tif"), keyAndStamp.second);
+    BOOST_CHECK_NE(book.pageStamp("page2.tif"), keyAndStamp.second);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_not_a_tiff) {
+  QTemporaryDir dir;
+  BOOST_REQUIRE(dir.isValid());
+  const QString path(dir.filePath("book.tif"));
+  QFile file(path);
+  BOOST_REQUIRE(file.open(QIODevice::WriteOnly));
+  file.write("not a tiff");
+  file.close();
+
+  TiffBookContainer book(path);
+  BOOST_CHECK(!book.isValid());
+  BOOST_CHECK(!book.writePage("page1.tif", makeColorPage(1)));
+  BOOST_CHECK_EQUAL(QFileInfo(path).size(), 10);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+}  // namespace Tests
@@ -3,6 +3,8 @@
 
 #include "DewarpingPointMapper.h"
 
+#include <PolygonUtils.h>
+
 #include <QTransform>
 
 #include "DistortionModel.h"
@@ -47,4 +49,13 @@ QPointF DewarpingPointMapper::mapToWarpedSpace(const QPointF& dewarpedPt) const
   const double crvY = (dewarpedPtM.y() - m_modelDomainTop) * m_modelYScaleToNormalized;
   return m_dewarper.mapToWarpedSpace(QPointF(crvX, crvY));
 }
+
+QPolygonF DewarpingPointMapper::mapPolygonToDewarpedSpace(const QPolygonF& warpedPoly,
+                                                          const double maxSegmentLength) const {
+  QPolygonF dewarpedPoly(imageproc::PolygonUtils::densify(warpedPoly, maxSegmentLength));
+  for (QPointF& pt : dewarpedPoly) {
+    pt = mapToDewarpedSpace(pt);
+  }
+  return dewarpedPoly;
+}
 }  // namespace dewarping
\ No newline at end of file
@@ -4,6 +4,7 @@
 #ifndef SCANTAILOR_DEWARPING_DEWARPINGPOINTMAPPER_H_
 #define SCANTAILOR_DEWARPING_DEWARPINGPOINTMAPPER_H_
 
+#include <QtGui/QPolygonF>
 #include <QtGui/QTransform>
 
 #include "CylindricalSurfaceDewarper.h"
@@ -35,6 +36,13 @@ class DewarpingPointMapper {
    */
   QPointF mapToWarpedSpace(const QPointF& dewarpedPt) const;
 
+  /**
+   * Maps a polygon to dewarped image coordinates.  Its edges are
+   * subdivided into pieces of at most \p maxSegmentLength warped pixels
+   * first, so they follow the curvature instead of staying straight.
+   */
+  QPolygonF mapPolygonToDewarpedSpace(const QPolygonF& warpedPoly, double maxSegmentLength) const;
+
  private:
   CylindricalSurfaceDewarper m_dewarper;
   double m_modelDomainLeft;
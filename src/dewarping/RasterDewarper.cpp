@@ -5,8 +5,11 @@
 
 #include <ColorMixer.h>
 #include <GrayImage.h>
+#include <Transform.h>
 
 #include <QDebug>
+#include <QTransform>
+#include <algorithm>
 #include <cmath>
 #include <stdexcept>
 
@@ -141,257 +144,261 @@ void dewarpGeneric(const PixelType* const srcData,
 
 #elif INTERPOLATION_METHOD == INTERP_AREA_MAPPING
 
+/**
+ * Maps a quadrilateral of the source image, given by its corners, to one
+ * destination pixel, by averaging the source pixels it covers.
+ */
 template <typename ColorMixer, typename PixelType>
-void areaMapGeneratrix(const PixelType* const srcData,
+PixelType areaMapPixel(const PixelType* const srcData,
                        const QSize srcSize,
                        const int srcStride,
-                       PixelType* pDst,
-                       const QSize dstSize,
-                       const int dstStride,
                        const PixelType bgColor,
-                       const std::vector<Vec2f>& prevGridColumn,
-                       const std::vector<Vec2f>& nextGridColumn) {
+                       const Vec2f& srcTopLeft,
+                       const Vec2f& srcTopRight,
+                       const Vec2f& srcBottomLeft,
+                       const Vec2f& srcBottomRight) {
   const int sw = srcSize.width();
   const int sh = srcSize.height();
-  const int dstHeight = dstSize.height();
-
-  const Vec2f* srcLeftPoints = &prevGridColumn[0];
-  const Vec2f* srcRightPoints = &nextGridColumn[0];
 
+  // Take a mid-point of each edge, pre-multiply by 32,
+  // write the result to f_src32_quad. 16 comes from 32*0.5
   Vec2f f_src32_quad[4];
-
-  for (int dstY = 0; dstY < dstHeight; ++dstY) {
-    // Take a mid-point of each edge, pre-multiply by 32,
-    // write the result to f_src32_quad. 16 comes from 32*0.5
-    f_src32_quad[0] = 16.0f * (srcLeftPoints[0] + srcRightPoints[0]);
-    f_src32_quad[1] = 16.0f * (srcRightPoints[0] + srcRightPoints[1]);
-    f_src32_quad[2] = 16.0f * (srcRightPoints[1] + srcLeftPoints[1]);
-    f_src32_quad[3] = 16.0f * (srcLeftPoints[0] + srcLeftPoints[1]);
-    ++srcLeftPoints;
-    ++srcRightPoints;
-
-    // Calculate the bounding box of src_quad.
-
-    float fSrc32Left = f_src32_quad[0][0];
-    float fSrc32Top = f_src32_quad[0][1];
-    float fSrc32Right = fSrc32Left;
-    float fSrc32Bottom = fSrc32Top;
-
-    for (int i = 1; i < 4; ++i) {
-      const Vec2f pt(f_src32_quad[i]);
-      if (pt[0] < fSrc32Left) {
-        fSrc32Left = pt[0];
-      } else if (pt[0] > fSrc32Right) {
-        fSrc32Right = pt[0];
-      }
-      if (pt[1] < fSrc32Top) {
-        fSrc32Top = pt[1];
-      } else if (pt[1] > fSrc32Bottom) {
-        fSrc32Bottom = pt[1];
-      }
+  f_src32_quad[0] = 16.0f * (srcTopLeft + srcTopRight);
+  f_src32_quad[1] = 16.0f * (srcTopRight + srcBottomRight);
+  f_src32_quad[2] = 16.0f * (srcBottomRight + srcBottomLeft);
+  f_src32_quad[3] = 16.0f * (srcTopLeft + srcBottomLeft);
+
+  // Calculate the bounding box of src_quad.
+
+  float fSrc32Left = f_src32_quad[0][0];
+  float fSrc32Top = f_src32_quad[0][1];
+  float fSrc32Right = fSrc32Left;
+  float fSrc32Bottom = fSrc32Top;
+
+  for (int i = 1; i < 4; ++i) {
+    const Vec2f pt(f_src32_quad[i]);
+    if (pt[0] < fSrc32Left) {
+      fSrc32Left = pt[0];
+    } else if (pt[0] > fSrc32Right) {
+      fSrc32Right = pt[0];
     }
-
-    if ((fSrc32Top < -32.0f * 10000.0f) || (fSrc32Left < -32.0f * 10000.0f)
-        || (fSrc32Bottom > 32.0f * (float(sh) + 10000.f)) || (fSrc32Right > 32.0f * (float(sw) + 10000.f))) {
-      // This helps to prevent integer overflows.
-      *pDst = bgColor;
-      pDst += dstStride;
-      continue;
+    if (pt[1] < fSrc32Top) {
+      fSrc32Top = pt[1];
+    } else if (pt[1] > fSrc32Bottom) {
+      fSrc32Bottom = pt[1];
     }
+  }
 
-    // Note: the code below is more or less the same as in transformGeneric()
-    // in imageproc/Transform.cpp
-
-    // Note that without using std::floor() and std::ceil()
-    // we can't guarantee that srcBottom >= srcTop
-    // and srcRight >= srcLeft.
-    auto src32Left = (int) std::floor(fSrc32Left);
-    auto src32Right = (int) std::ceil(fSrc32Right);
-    auto src32Top = (int) std::floor(fSrc32Top);
-    auto src32Bottom = (int) std::ceil(fSrc32Bottom);
-    int srcLeft = src32Left >> 5;
-    int srcRight = (src32Right - 1) >> 5;  // inclusive
-    int srcTop = src32Top >> 5;
-    int srcBottom = (src32Bottom - 1) >> 5;  // inclusive
-    assert(srcBottom >= srcTop);
-    assert(srcRight >= srcLeft);
-
-    if ((srcBottom < 0) || (srcRight < 0) || (srcLeft >= sw) || (srcTop >= sh)) {
-      // Completely outside of src image.
-      *pDst = bgColor;
-      pDst += dstStride;
-      continue;
-    }
+  if ((fSrc32Top < -32.0f * 10000.0f) || (fSrc32Left < -32.0f * 10000.0f)
+      || (fSrc32Bottom > 32.0f * (float(sh) + 10000.f)) || (fSrc32Right > 32.0f * (float(sw) + 10000.f))) {
+    // This helps to prevent integer overflows.
+    return bgColor;
+  }
 
-    /*
-     * Note that (intval / 32) is not the same as (intval >> 5).
-     * The former rounds towards zero, while the latter rounds towards
-     * negative infinity.
-     * Likewise, (intval % 32) is not the same as (intval & 31).
-     * The following expression:
-     * topFraction = 32 - (src32Top & 31);
-     * works correctly with both positive and negative src32Top.
-     */
-
-    unsigned backgroundArea = 0;
-
-    if (srcTop < 0) {
-      const unsigned topFraction = 32 - (src32Top & 31);
-      const unsigned horFraction = src32Right - src32Left;
-      backgroundArea += topFraction * horFraction;
-      const unsigned fullPixelsVer = -1 - srcTop;
-      backgroundArea += horFraction * (fullPixelsVer << 5);
-      srcTop = 0;
-      src32Top = 0;
-    }
-    if (srcBottom >= sh) {
-      const unsigned bottomFraction = src32Bottom - (srcBottom << 5);
-      const unsigned horFraction = src32Right - src32Left;
-      backgroundArea += bottomFraction * horFraction;
-      const unsigned fullPixelsVer = srcBottom - sh;
-      backgroundArea += horFraction * (fullPixelsVer << 5);
-      srcBottom = sh - 1;     // inclusive
-      src32Bottom = sh << 5;  // exclusive
-    }
-    if (srcLeft < 0) {
-      const unsigned leftFraction = 32 - (src32Left & 31);
-      const unsigned vertFraction = src32Bottom - src32Top;
-      backgroundArea += leftFraction * vertFraction;
-      const unsigned fullPixelsHor = -1 - srcLeft;
-      backgroundArea += vertFraction * (fullPixelsHor << 5);
-      srcLeft = 0;
-      src32Left = 0;
-    }
-    if (srcRight >= sw) {
-      const unsigned rightFraction = src32Right - (srcRight << 5);
-      const unsigned vertFraction = src32Bottom - src32Top;
-      backgroundArea += rightFraction * vertFraction;
-      const unsigned fullPixelsHor = srcRight - sw;
-      backgroundArea += vertFraction * (fullPixelsHor << 5);
-      srcRight = sw - 1;     // inclusive
-      src32Right = sw << 5;  // exclusive
-    }
-    assert(srcBottom >= srcTop);
-    assert(srcRight >= srcLeft);
+  // Note: the code below is more or less the same as in transformGeneric()
+  // in imageproc/Transform.cpp
+
+  // Note that without using std::floor() and std::ceil()
+  // we can't guarantee that srcBottom >= srcTop
+  // and srcRight >= srcLeft.
+  auto src32Left = (int) std::floor(fSrc32Left);
+  auto src32Right = (int) std::ceil(fSrc32Right);
+  auto src32Top = (int) std::floor(fSrc32Top);
+  auto src32Bottom = (int) std::ceil(fSrc32Bottom);
+  int srcLeft = src32Left >> 5;
+  int srcRight = (src32Right - 1) >> 5;  // inclusive
+  int srcTop = src32Top >> 5;
+  int srcBottom = (src32Bottom - 1) >> 5;  // inclusive
+  assert(srcBottom >= srcTop);
+  assert(srcRight >= srcLeft);
+
+  if ((srcBottom < 0) || (srcRight < 0) || (srcLeft >= sw) || (srcTop >= sh)) {
+    // Completely outside of src image.
+    return bgColor;
+  }
 
-    ColorMixer mixer;
-    // if (weak_background) {
-    // backgroundArea = 0;
-    // } else {
-    mixer.add(bgColor, backgroundArea);
-    // }
+  /*
+   * Note that (intval / 32) is not the same as (intval >> 5).
+   * The former rounds towards zero, while the latter rounds towards
+   * negative infinity.
+   * Likewise, (intval % 32) is not the same as (intval & 31).
+   * The following expression:
+   * topFraction = 32 - (src32Top & 31);
+   * works correctly with both positive and negative src32Top.
+   */
 
-    const unsigned leftFraction = 32 - (src32Left & 31);
+  unsigned backgroundArea = 0;
+
+  if (srcTop < 0) {
     const unsigned topFraction = 32 - (src32Top & 31);
-    const unsigned rightFraction = src32Right - (srcRight << 5);
+    const unsigned horFraction = src32Right - src32Left;
+    backgroundArea += topFraction * horFraction;
+    const unsigned fullPixelsVer = -1 - srcTop;
+    backgroundArea += horFraction * (fullPixelsVer << 5);
+    srcTop = 0;
+    src32Top = 0;
+  }
+  if (srcBottom >= sh) {
     const unsigned bottomFraction = src32Bottom - (srcBottom << 5);
+    const unsigned horFraction = src32Right - src32Left;
+    backgroundArea += bottomFraction * horFraction;
+    const unsigned fullPixelsVer = srcBottom - sh;
+    backgroundArea += horFraction * (fullPixelsVer << 5);
+    srcBottom = sh - 1;     // inclusive
+    src32Bottom = sh << 5;  // exclusive
+  }
+  if (srcLeft < 0) {
+    const unsigned leftFraction = 32 - (src32Left & 31);
+    const unsigned vertFraction = src32Bottom - src32Top;
+    backgroundArea += leftFraction * vertFraction;
+    const unsigned fullPixelsHor = -1 - srcLeft;
+    backgroundArea += vertFraction * (fullPixelsHor << 5);
+    srcLeft = 0;
+    src32Left = 0;
+  }
+  if (srcRight >= sw) {
+    const unsigned rightFraction = src32Right - (srcRight << 5);
+    const unsigned vertFraction = src32Bottom - src32Top;
+    backgroundArea += rightFraction * vertFraction;
+    const unsigned fullPixelsHor = srcRight - sw;
+    backgroundArea += vertFraction * (fullPixelsHor << 5);
+    srcRight = sw - 1;     // inclusive
+    src32Right = sw << 5;  // exclusive
+  }
+  assert(srcBottom >= srcTop);
+  assert(srcRight >= srcLeft);
+
+  ColorMixer mixer;
+  // if (weak_background) {
+  // backgroundArea = 0;
+  // } else {
+  mixer.add(bgColor, backgroundArea);
+  // }
+
+  const unsigned leftFraction = 32 - (src32Left & 31);
+  const unsigned topFraction = 32 - (src32Top & 31);
+  const unsigned rightFraction = src32Right - (srcRight << 5);
+  const unsigned bottomFraction = src32Bottom - (srcBottom << 5);
+
+  assert(leftFraction + rightFraction + (srcRight - srcLeft - 1) * 32
+         == static_cast<unsigned>(src32Right - src32Left));
+  assert(topFraction + bottomFraction + (srcBottom - srcTop - 1) * 32
+         == static_cast<unsigned>(src32Bottom - src32Top));
+
+  const unsigned srcArea = (src32Bottom - src32Top) * (src32Right - src32Left);
+  if (srcArea == 0) {
+    return bgColor;
+  }
 
-    assert(leftFraction + rightFraction + (srcRight - srcLeft - 1) * 32
-           == static_cast<unsigned>(src32Right - src32Left));
-    assert(topFraction + bottomFraction + (srcBottom - srcTop - 1) * 32
-           == static_cast<unsigned>(src32Bottom - src32Top));
+  const PixelType* srcLine = &srcData[srcTop * srcStride];
 
-    const unsigned srcArea = (src32Bottom - src32Top) * (src32Right - src32Left);
-    if (srcArea == 0) {
-      *pDst = bgColor;
-      pDst += dstStride;
-      continue;
-    }
+  if (srcTop == srcBottom) {
+    if (srcLeft == srcRight) {
+      // dst pixel maps to a single src pixel
+      const PixelType c = srcLine[srcLeft];
+      if (backgroundArea == 0) {
+        // common case optimization
+        return c;
+      }
+      mixer.add(c, srcArea);
+    } else {
+      // dst pixel maps to a horizontal line of src pixels
+      const unsigned vertFraction = src32Bottom - src32Top;
+      const unsigned leftArea = vertFraction * leftFraction;
+      const unsigned middleArea = vertFraction << 5;
+      const unsigned rightArea = vertFraction * rightFraction;
 
-    const PixelType* srcLine = &srcData[srcTop * srcStride];
-
-    if (srcTop == srcBottom) {
-      if (srcLeft == srcRight) {
-        // dst pixel maps to a single src pixel
-        const PixelType c = srcLine[srcLeft];
-        if (backgroundArea == 0) {
-          // common case optimization
-          *pDst = c;
-          pDst += dstStride;
-          continue;
-        }
-        mixer.add(c, srcArea);
-      } else {
-        // dst pixel maps to a horizontal line of src pixels
-        const unsigned vertFraction = src32Bottom - src32Top;
-        const unsigned leftArea = vertFraction * leftFraction;
-        const unsigned middleArea = vertFraction << 5;
-        const unsigned rightArea = vertFraction * rightFraction;
+      mixer.add(srcLine[srcLeft], leftArea);
 
-        mixer.add(srcLine[srcLeft], leftArea);
+      for (int sx = srcLeft + 1; sx < srcRight; ++sx) {
+        mixer.add(srcLine[sx], middleArea);
+      }
 
-        for (int sx = srcLeft + 1; sx < srcRight; ++sx) {
-          mixer.add(srcLine[sx], middleArea);
-        }
+      mixer.add(srcLine[srcRight], rightArea);
+    }
+  } else if (srcLeft == srcRight) {
+    // dst pixel maps to a vertical line of src pixels
+    const unsigned horFraction = src32Right - src32Left;
+    const unsigned topArea = horFraction * topFraction;
+    const unsigned middleArea = horFraction << 5;
+    const unsigned bottomArea = horFraction * bottomFraction;
 
-        mixer.add(srcLine[srcRight], rightArea);
-      }
-    } else if (srcLeft == srcRight) {
-      // dst pixel maps to a vertical line of src pixels
-      const unsigned horFraction = src32Right - src32Left;
-      const unsigned topArea = horFraction * topFraction;
-      const unsigned middleArea = horFraction << 5;
-      const unsigned bottomArea = horFraction * bottomFraction;
+    srcLine += srcLeft;
+    mixer.add(*srcLine, topArea);
 
-      srcLine += srcLeft;
-      mixer.add(*srcLine, topArea);
+    srcLine += srcStride;
 
+    for (int sy = srcTop + 1; sy < srcBottom; ++sy) {
+      mixer.add(*srcLine, middleArea);
       srcLine += srcStride;
+    }
 
-      for (int sy = srcTop + 1; sy < srcBottom; ++sy) {
-        mixer.add(*srcLine, middleArea);
-        srcLine += srcStride;
-      }
+    mixer.add(*srcLine, bottomArea);
+  } else {
+    // dst pixel maps to a block of src pixels
+    const unsigned topArea = topFraction << 5;
+    const unsigned bottomArea = bottomFraction << 5;
+    const unsigned leftArea = leftFraction << 5;
+    const unsigned rightArea = rightFraction << 5;
+    const unsigned topleftArea = topFraction * leftFraction;
+    const unsigned toprightArea = topFraction * rightFraction;
+    const unsigned bottomleftArea = bottomFraction * leftFraction;
+    const unsigned bottomrightArea = bottomFraction * rightFraction;
+
+    // process the top-left corner
+    mixer.add(srcLine[srcLeft], topleftArea);
+
+    // process the top line (without corners)
+    for (int sx = srcLeft + 1; sx < srcRight; ++sx) {
+      mixer.add(srcLine[sx], topArea);
+    }
+
+    // process the top-right corner
+    mixer.add(srcLine[srcRight], toprightArea);
+
+    srcLine += srcStride;
+    // process middle lines
+    for (int sy = srcTop + 1; sy < srcBottom; ++sy) {
+      mixer.add(srcLine[srcLeft], leftArea);
 
-      mixer.add(*srcLine, bottomArea);
-    } else {
-      // dst pixel maps to a block of src pixels
-      const unsigned topArea = topFraction << 5;
-      const unsigned bottomArea = bottomFraction << 5;
-      const unsigned leftArea = leftFraction << 5;
-      const unsigned rightArea = rightFraction << 5;
-      const unsigned topleftArea = topFraction * leftFraction;
-      const unsigned toprightArea = topFraction * rightFraction;
-      const unsigned bottomleftArea = bottomFraction * leftFraction;
-      const unsigned bottomrightArea = bottomFraction * rightFraction;
-
-      // process the top-left corner
-      mixer.add(srcLine[srcLeft], topleftArea);
-
-      // process the top line (without corners)
       for (int sx = srcLeft + 1; sx < srcRight; ++sx) {
-        mixer.add(srcLine[sx], topArea);
+        mixer.add(srcLine[sx], 32 * 32);
       }
 
-      // process the top-right corner
-      mixer.add(srcLine[srcRight], toprightArea);
+      mixer.add(srcLine[srcRight], rightArea);
 
       srcLine += srcStride;
-      // process middle lines
-      for (int sy = srcTop + 1; sy < srcBottom; ++sy) {
-        mixer.add(srcLine[srcLeft], leftArea);
-
-        for (int sx = srcLeft + 1; sx < srcRight; ++sx) {
-          mixer.add(srcLine[sx], 32 * 32);
-        }
-
-        mixer.add(srcLine[srcRight], rightArea);
-
-        srcLine += srcStride;
-      }
+    }
 
-      // process bottom-left corner
-      mixer.add(srcLine[srcLeft], bottomleftArea);
+    // process bottom-left corner
+    mixer.add(srcLine[srcLeft], bottomleftArea);
 
-      // process the bottom line (without corners)
-      for (int sx = srcLeft + 1; sx < srcRight; ++sx) {
-        mixer.add(srcLine[sx], bottomArea);
-      }
-      // process the bottom-right corner
-      mixer.add(srcLine[srcRight], bottomrightArea);
+    // process the bottom line (without corners)
+    for (int sx = srcLeft + 1; sx < srcRight; ++sx) {
+      mixer.add(srcLine[sx], bottomArea);
     }
+    // process the bottom-right corner
+    mixer.add(srcLine[srcRight], bottomrightArea);
+  }
+
+  return mixer.mix(srcArea + backgroundArea);
+}  // areaMapPixel
 
-    *pDst = mixer.mix(srcArea + backgroundArea);
+template <typename ColorMixer, typename PixelType>
+void areaMapGeneratrix(const PixelType* const srcData,
+                       const QSize srcSize,
+                       const int srcStride,
+                       PixelType* pDst,
+                       const QSize dstSize,
+                       const int dstStride,
+                       const PixelType bgColor,
+                       const std::vector<Vec2f>& prevGridColumn,
+                       const std::vector<Vec2f>& nextGridColumn) {
+  const int dstHeight = dstSize.height();
+  for (int dstY = 0; dstY < dstHeight; ++dstY) {
+    *pDst = areaMapPixel<ColorMixer, PixelType>(srcData, srcSize, srcStride, bgColor, prevGridColumn[dstY],
+                                                nextGridColumn[dstY], prevGridColumn[dstY + 1],
+                                                nextGridColumn[dstY + 1]);
     pDst += dstStride;
   }
 }  // areaMapGeneratrix
@@ -442,6 +449,116 @@ void dewarpGeneric(const PixelType* const srcData,
     prevGridColumn.swap(nextGridColumn);
   }
 }  // dewarpGeneric
+
+/**
+ * Generatrices at every integer column of the dewarped image, so that points
+ * in between can be mapped to the source image without calling
+ * CylindricalSurfaceDewarper::mapGeneratrix() for each of them.
+ */
+class GeneratrixTable {
+ public:
+  GeneratrixTable(const CylindricalSurfaceDewarper& distortionModel, const QRectF& modelDomain, const int width)
+      : m_modelDomainTop(static_cast<float>(modelDomain.top())),
+        m_modelYScale(static_cast<float>(1.0 / (modelDomain.bottom() - modelDomain.top()))) {
+    CylindricalSurfaceDewarper::State state;
+    const double modelXScale = 1.0 / (modelDomain.right() - modelDomain.left());
+    m_columns.reserve(width + 1);
+    for (int x = 0; x <= width; ++x) {
+      m_columns.emplace_back(distortionModel.mapGeneratrix((x - modelDomain.left()) * modelXScale, state));
+    }
+  }
+
+  /**
+   * Maps a point of the dewarped image, which has to be within
+   * [0, width] horizontally, to the source image.
+   */
+  Vec2f map(const float x, const float y) const {
+    const float modelY = (y - m_modelDomainTop) * m_modelYScale;
+    const int lastColumn = static_cast<int>(m_columns.size()) - 1;
+    const int left = std::min(std::max(static_cast<int>(x), 0), std::max(lastColumn - 1, 0));
+    const int right = std::min(left + 1, lastColumn);
+    const Vec2f leftPt(m_columns[left].map(modelY));
+    const Vec2f rightPt(m_columns[right].map(modelY));
+    return leftPt + (rightPt - leftPt) * (x - float(left));
+  }
+
+ private:
+  struct Column {
+    explicit Column(const CylindricalSurfaceDewarper::Generatrix& generatrix)
+        : origin(generatrix.imgLine.p1()),
+          vec(generatrix.imgLine.p2() - generatrix.imgLine.p1()),
+          homog(generatrix.pln2img.mat()) {}
+
+    Vec2f map(const float modelY) const { return origin + vec * homog(modelY); }
+
+    Vec2f origin;
+    Vec2f vec;
+    HomographicTransform<1, float> homog;
+  };
+
+  std::vector<Column> m_columns;
+  float m_modelDomainTop;
+  float m_modelYScale;
+};
+
+/**
+ * Same as dewarpGeneric(), followed by \p postTransform applied to the dewarped
+ * image, but with the source image sampled only once.  The grid nodes of the
+ * destination image are mapped back through \p postTransform and then through
+ * the dewarping, and each destination pixel is area-mapped from the source
+ * quadrilateral its nodes end up at.
+ */
+template <typename ColorMixer, typename PixelType>
+void dewarpCompositeGeneric(const PixelType* const srcData,
+                            const QSize srcSize,
+                            const int srcStride,
+                            PixelType* const dstData,
+                            const QSize dstSize,
+                            const int dstStride,
+                            const CylindricalSurfaceDewarper& distortionModel,
+                            const QRectF& modelDomain,
+                            const PixelType bgColor,
+                            const QTransform& postTransform) {
+  const int dstWidth = dstSize.width();
+  const int dstHeight = dstSize.height();
+  const GeneratrixTable generatrices(distortionModel, modelDomain, dstWidth);
+
+  // Nodes falling outside of the dewarped image are moved far away,
+  // which makes the pixels around them background, as they would be
+  // if the dewarped image was transformed on its own.
+  const Vec2f outsideNode(-1e6f, -1e6f);
+  const auto maxX = static_cast<float>(dstWidth);
+  const auto maxY = static_cast<float>(dstHeight);
+
+  const QTransform dstToDewarped(postTransform.inverted());
+  const Vec2f xStep(static_cast<float>(dstToDewarped.m11()), static_cast<float>(dstToDewarped.m12()));
+
+  std::vector<Vec2f> prevGridRow(dstWidth + 1);
+  std::vector<Vec2f> nextGridRow(dstWidth + 1);
+
+  for (int dstY = 0; dstY <= dstHeight; ++dstY) {
+    const Vec2f rowOrigin(dstToDewarped.map(QPointF(0, dstY)));
+    for (int dstX = 0; dstX <= dstWidth; ++dstX) {
+      const Vec2f pt(rowOrigin + xStep * float(dstX));
+      if ((pt[0] < 0.0f) || (pt[0] > maxX) || (pt[1] < 0.0f) || (pt[1] > maxY)) {
+        nextGridRow[dstX] = outsideNode;
+      } else {
+        nextGridRow[dstX] = generatrices.map(pt[0], pt[1]);
+      }
+    }
+
+    if (dstY != 0) {
+      PixelType* const dstLine = dstData + (dstY - 1) * dstStride;
+      for (int dstX = 0; dstX < dstWidth; ++dstX) {
+        dstLine[dstX] = areaMapPixel<ColorMixer, PixelType>(srcData, srcSize, srcStride, bgColor, prevGridRow[dstX],
+                                                            prevGridRow[dstX + 1], nextGridRow[dstX],
+                                                            nextGridRow[dstX + 1]);
+      }
+    }
+
+    prevGridRow.swap(nextGridRow);
+  }
+}  // dewarpCompositeGeneric
 #endif  // INTERPOLATION_METHOD
 #if INTERPOLATION_METHOD == INTERP_BILLINEAR
 using MixingWeight = float;
@@ -449,16 +566,40 @@ using MixingWeight = float;
 using MixingWeight = unsigned;
 #endif
 
+template <typename ColorMixer, typename PixelType>
+void dewarpAndTransform(const PixelType* const srcData,
+                        const QSize srcSize,
+                        const int srcStride,
+                        PixelType* const dstData,
+                        const QSize dstSize,
+                        const int dstStride,
+                        const CylindricalSurfaceDewarper& distortionModel,
+                        const QRectF& modelDomain,
+                        const PixelType bgColor,
+                        const QTransform& postTransform) {
+#if INTERPOLATION_METHOD == INTERP_AREA_MAPPING
+  if (!postTransform.isIdentity()) {
+    dewarpCompositeGeneric<ColorMixer, PixelType>(srcData, srcSize, srcStride, dstData, dstSize, dstStride,
+                                                  distortionModel, modelDomain, bgColor, postTransform);
+    return;
+  }
+#endif
+  dewarpGeneric<ColorMixer, PixelType>(srcData, srcSize, srcStride, dstData, dstSize, dstStride, distortionModel,
+                                       modelDomain, bgColor);
+}
+
 QImage dewarpGrayscale(const QImage& src,
                        const QSize& dstSize,
                        const CylindricalSurfaceDewarper& distortionModel,
                        const QRectF& modelDomain,
-                       const QColor& bgColor) {
+                       const QColor& bgColor,
+                       const QTransform& postTransform) {
   GrayImage dst(dstSize);
   const auto bgSample = static_cast<uint8_t>(qGray(bgColor.rgb()));
   dst.fill(bgSample);
-  dewarpGeneric<GrayColorMixer<MixingWeight>, uint8_t>(src.bits(), src.size(), src.bytesPerLine(), dst.data(), dstSize,
-                                                       dst.stride(), distortionModel, modelDomain, bgSample);
+  dewarpAndTransform<GrayColorMixer<MixingWeight>, uint8_t>(src.bits(), src.size(), src.bytesPerLine(), dst.data(),
+                                                            dstSize, dst.stride(), distortionModel, modelDomain,
+                                                            bgSample, postTransform);
   return dst.toQImage();
 }
 
@@ -466,12 +607,13 @@ QImage dewarpRgb(const QImage& src,
                  const QSize& dstSize,
                  const CylindricalSurfaceDewarper& distortionModel,
                  const QRectF& modelDomain,
-                 const QColor& bgColor) {
+                 const QColor& bgColor,
+                 const QTransform& postTransform) {
   QImage dst(dstSize, QImage::Format_RGB32);
   dst.fill(bgColor.rgb());
-  dewarpGeneric<RgbColorMixer<MixingWeight>, uint32_t>((const uint32_t*) src.bits(), src.size(), src.bytesPerLine() / 4,
-                                                       (uint32_t*) dst.bits(), dstSize, dst.bytesPerLine() / 4,
-                                                       distortionModel, modelDomain, bgColor.rgb());
+  dewarpAndTransform<RgbColorMixer<MixingWeight>, uint32_t>(
+      (const uint32_t*) src.bits(), src.size(), src.bytesPerLine() / 4, (uint32_t*) dst.bits(), dstSize,
+      dst.bytesPerLine() / 4, distortionModel, modelDomain, bgColor.rgb(), postTransform);
   return dst;
 }
 
@@ -479,12 +621,13 @@ QImage dewarpArgb(const QImage& src,
                   const QSize& dstSize,
                   const CylindricalSurfaceDewarper& distortionModel,
                   const QRectF& modelDomain,
-                  const QColor& bgColor) {
+                  const QColor& bgColor,
+                  const QTransform& postTransform) {
   QImage dst(dstSize, QImage::Format_ARGB32);
   dst.fill(bgColor.rgba());
-  dewarpGeneric<ArgbColorMixer<MixingWeight>, uint32_t>(
+  dewarpAndTransform<ArgbColorMixer<MixingWeight>, uint32_t>(
       (const uint32_t*) src.bits(), src.size(), src.bytesPerLine() / 4, (uint32_t*) dst.bits(), dstSize,
-      dst.bytesPerLine() / 4, distortionModel, modelDomain, bgColor.rgba());
+      dst.bytesPerLine() / 4, distortionModel, modelDomain, bgColor.rgba(), postTransform);
   return dst;
 }
 }  // namespace
@@ -494,38 +637,59 @@ QImage RasterDewarper::dewarp(const QImage& src,
                               const CylindricalSurfaceDewarper& distortionModel,
                               const QRectF& modelDomain,
                               const QColor& bgColor) {
+  return dewarp(src, dstSize, distortionModel, modelDomain, bgColor, QTransform());
+}
+
+QImage RasterDewarper::dewarp(const QImage& src,
+                              const QSize& dstSize,
+                              const CylindricalSurfaceDewarper& distortionModel,
+                              const QRectF& modelDomain,
+                              const QColor& bgColor,
+                              const QTransform& postTransform) {
   if (modelDomain.isEmpty()) {
     throw std::invalid_argument("RasterDewarper: modelDomain is empty.");
   }
 
+#if INTERPOLATION_METHOD != INTERP_AREA_MAPPING
+  // Only area mapping can sample through the post-transform.
+  if (!postTransform.isIdentity()) {
+    const QImage dewarped(dewarp(src, dstSize, distortionModel, modelDomain, bgColor));
+    return transform(dewarped, postTransform, dewarped.rect(), OutsidePixels::assumeWeakColor(bgColor));
+  }
+#endif
+
   switch (src.format()) {
     case QImage::Format_Invalid:
       return QImage();
     case QImage::Format_RGB32:
-      return dewarpRgb(src, dstSize, distortionModel, modelDomain, bgColor);
+      return dewarpRgb(src, dstSize, distortionModel, modelDomain, bgColor, postTransform);
     case QImage::Format_ARGB32:
-      return dewarpArgb(src, dstSize, distortionModel, modelDomain, bgColor);
+      return dewarpArgb(src, dstSize, distortionModel, modelDomain, bgColor, postTransform);
     case QImage::Format_Indexed8:
       if (src.isGrayscale()) {
-        return dewarpGrayscale(src, dstSize, distortionModel, modelDomain, bgColor);
+        return dewarpGrayscale(src, dstSize, distortionModel, modelDomain, bgColor, postTransform);
       } else if (src.allGray()) {
         // Only shades of gray but non-standard palette.
-        return dewarpGrayscale(GrayImage(src).toQImage(), dstSize, distortionModel, modelDomain, bgColor);
+        return dewarpGrayscale(GrayImage(src).toQImage(), dstSize, distortionModel, modelDomain, bgColor,
+                               postTransform);
       }
       break;
     case QImage::Format_Mono:
     case QImage::Format_MonoLSB:
       if (src.allGray()) {
-        return dewarpGrayscale(GrayImage(src).toQImage(), dstSize, distortionModel, modelDomain, bgColor);
+        return dewarpGrayscale(GrayImage(src).toQImage(), dstSize, distortionModel, modelDomain, bgColor,
+                               postTransform);
       }
       break;
     default:;
   }
   // Generic case: convert to either RGB32 or ARGB32.
   if (src.hasAlphaChannel()) {
-    return dewarpArgb(src.convertToFormat(QImage::Format_ARGB32), dstSize, distortionModel, modelDomain, bgColor);
+    return dewarpArgb(src.convertToFormat(QImage::Format_ARGB32), dstSize, distortionModel, modelDomain, bgColor,
+                      postTransform);
   } else {
-    return dewarpRgb(src.convertToFormat(QImage::Format_RGB32), dstSize, distortionModel, modelDomain, bgColor);
+    return dewarpRgb(src.convertToFormat(QImage::Format_RGB32), dstSize, distortionModel, modelDomain, bgColor,
+                     postTransform);
   }
 }  // RasterDewarper::dewarp
 }  // namespace dewarping
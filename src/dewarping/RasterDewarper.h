@@ -8,6 +8,7 @@ class QImage;
 class QSize;
 class QRectF;
 class QColor;
+class QTransform;
 
 namespace dewarping {
 class CylindricalSurfaceDewarper;
@@ -19,6 +20,21 @@ class RasterDewarper {
                        const CylindricalSurfaceDewarper& distortionModel,
                        const QRectF& modelDomain,
                        const QColor& backgroundColor);
+
+  /**
+   * \brief Dewarps and then applies \p postTransform to the result, sampling
+   *        \p src only once.
+   *
+   * The result matches transforming the output of the above with
+   * \p postTransform within its own rectangle, minus the blur of a second
+   * resampling.  \p postTransform is typically a post-deskew rotation.
+   */
+  static QImage dewarp(const QImage& src,
+                       const QSize& dstSize,
+                       const CylindricalSurfaceDewarper& distortionModel,
+                       const QRectF& modelDomain,
+                       const QColor& backgroundColor,
+                       const QTransform& postTransform);
 };
 }  // namespace dewarping
 #endif
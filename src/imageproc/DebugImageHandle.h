@@ -0,0 +1,25 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#ifndef SCANTAILOR_IMAGEPROC_DEBUGIMAGEHANDLE_H_
+#define SCANTAILOR_IMAGEPROC_DEBUGIMAGEHANDLE_H_
+
+class QImage;
+
+/**
+ * \brief A captured debug image that is only converted for display on demand.
+ */
+class DebugImageHandle {
+ public:
+  virtual ~DebugImageHandle() = default;
+
+  /**
+   * \brief Returns the image, reading it back from disk if necessary.
+   *
+   * May be called from any thread.
+   */
+  virtual QImage load() const = 0;
+};
+
+
+#endif  // ifndef SCANTAILOR_IMAGEPROC_DEBUGIMAGEHANDLE_H_
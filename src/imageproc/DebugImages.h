@@ -5,10 +5,10 @@
 #define SCANTAILOR_IMAGEPROC_DEBUGIMAGES_H_
 
 #include <QString>
-#include <deque>
 #include <functional>
+#include <memory>
 
-#include "AutoRemovingFile.h"
+#include "DebugImageHandle.h"
 
 class QImage;
 class QWidget;
@@ -43,10 +43,11 @@ class DebugImages {
    *
    * The label and viewer widget factory (that may not be bound)
    * are returned by taking pointers to them as arguments.
-   * Returns a null AutoRemovingFile if image sequence is empty.
+   * Returns null if image sequence is empty.
    */
-  virtual AutoRemovingFile retrieveNext(QString* label = nullptr,
-                                        std::function<QWidget*(const QImage&)>* imageViewFactory = nullptr)
+  virtual std::shared_ptr<const DebugImageHandle> retrieveNext(
+      QString* label = nullptr,
+      std::function<QWidget*(const QImage&)>* imageViewFactory = nullptr)
       = 0;
 };
 
@@ -0,0 +1,364 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include "HitMissPipeline.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include "BinaryImage.h"
+
+namespace imageproc {
+namespace {
+// Offsets within a pattern must fit into a neighboring word.
+const int MAX_PATTERN_REACH = 63;
+
+/**
+ * Rows are stored as 64-bit words with one padding word on each side,
+ * so pixel x is at bit (64 + x) counting from the most significant bit
+ * of the first word.  Padding words and the bits beyond the image width
+ * are kept in the surroundings color.
+ */
+class RowRing {
+ public:
+  RowRing() = default;
+
+  RowRing(const int minCapacity, const int wordsPerRow) : m_wordsPerRow(wordsPerRow) {
+    int capacity = 1;
+    while (capacity < minCapacity) {
+      capacity <<= 1;
+    }
+    m_mask = capacity - 1;
+    m_data.resize(static_cast<size_t>(capacity) * wordsPerRow);
+  }
+
+  uint64_t* row(const int y) { return &m_data[static_cast<size_t>(y & m_mask) * m_wordsPerRow]; }
+
+ private:
+  std::vector<uint64_t> m_data;
+  int m_wordsPerRow = 0;
+  int m_mask = 0;
+};
+
+/**
+ * Returns pixels [64 * wordIdx + dx, 64 * wordIdx + dx + 63] of a padded row.
+ */
+inline uint64_t shiftedWord(const uint64_t* row, const int wordIdx, const int dx) {
+  const int bit = ((wordIdx + 1) << 6) + dx;
+  const int word = bit >> 6;
+  const int shift = bit & 63;
+  if (shift == 0) {
+    return row[word];
+  }
+  return (row[word] << shift) | (row[word + 1] >> (64 - shift));
+}
+}  // namespace
+
+/**
+ * Level 0 holds rows of the source image, level k holds rows
+ * after the stage k - 1 was applied.  Rows are produced on demand,
+ * strictly top to bottom on every level.
+ */
+class HitMissPipeline::Runner {
+ public:
+  Runner(const std::vector<Stage>& stages, BWColor srcSurroundings, BinaryImage& img);
+
+  void run();
+
+ private:
+  struct Level {
+    RowRing rows;
+    RowRing matches;
+    int rowsProduced = 0;
+    int matchesProduced = 0;
+  };
+
+  const uint64_t* row(int level, int y);
+
+  void produceSourceRow(int y);
+
+  void produceStageRow(int level, int y);
+
+  void produceMatchRow(int level, int y);
+
+  void storeRow(const uint64_t* row, int y);
+
+  void maskTail(uint64_t* row, uint64_t outside) const;
+
+  const std::vector<Stage>& m_stages;
+  const int m_width;
+  const int m_height;
+  const int m_srcWpl;
+  const int m_words;
+  const int m_paddedWords;
+  const uint64_t m_surroundings;
+  const uint64_t m_tailMask;
+  uint32_t* const m_data;
+  std::vector<uint64_t> m_surroundingsRow;
+  std::vector<Level> m_levels;
+};
+
+
+HitMissPipeline::HitMissPipeline(const BWColor srcSurroundings) : m_srcSurroundings(srcSurroundings) {}
+
+void HitMissPipeline::addPattern(const char* const pattern, const int patternWidth, const int patternHeight) {
+  // The same choice of origin as in hitMissReplaceInPlace().
+  const int patternLen = patternWidth * patternHeight;
+  const auto* const minusPos = static_cast<const char*>(std::memchr(pattern, '-', patternLen));
+  const auto* const plusPos = static_cast<const char*>(std::memchr(pattern, '+', patternLen));
+  const char* originPos;
+  if (minusPos && plusPos) {
+    originPos = std::min(minusPos, plusPos);
+  } else if (minusPos) {
+    originPos = minusPos;
+  } else if (plusPos) {
+    originPos = plusPos;
+  } else {
+    // No replacements requested - nothing to do.
+    return;
+  }
+
+  const int originX = static_cast<int>((originPos - pattern) % patternWidth);
+  const int originY = static_cast<int>((originPos - pattern) / patternWidth);
+
+  Stage stage;
+
+  const char* p = pattern;
+  for (int y = 0; y < patternHeight; ++y) {
+    for (int x = 0; x < patternWidth; ++x, ++p) {
+      const Offset offset{x - originX, y - originY};
+      if ((offset.dx < -MAX_PATTERN_REACH) || (offset.dx > MAX_PATTERN_REACH)) {
+        if (*p != '?') {
+          throw std::invalid_argument("HitMissPipeline: pattern is too wide");
+        }
+        continue;
+      }
+
+      switch (*p) {
+        case '-':
+          stage.blackToWhite.push_back(offset);
+          stage.replaceTop = std::min(stage.replaceTop, offset.dy);
+          stage.replaceBottom = std::max(stage.replaceBottom, offset.dy);
+          // fall through
+        case 'X':
+          stage.hits.push_back(offset);
+          break;
+        case '+':
+          stage.whiteToBlack.push_back(offset);
+          stage.replaceTop = std::min(stage.replaceTop, offset.dy);
+          stage.replaceBottom = std::max(stage.replaceBottom, offset.dy);
+          // fall through
+        case ' ':
+          stage.misses.push_back(offset);
+          break;
+        case '?':
+          continue;
+        default:
+          throw std::invalid_argument("HitMissPipeline: invalid character in pattern");
+      }
+      stage.matchTop = std::min(stage.matchTop, offset.dy);
+      stage.matchBottom = std::max(stage.matchBottom, offset.dy);
+    }
+  }
+
+  m_stages.push_back(std::move(stage));
+}  // HitMissPipeline::addPattern
+
+void HitMissPipeline::addPatternAllDirections(const char* const pattern,
+                                              const int patternWidth,
+                                              const int patternHeight) {
+  addPattern(pattern, patternWidth, patternHeight);
+
+  std::vector<char> rotated(static_cast<size_t>(patternWidth * patternHeight), ' ');
+
+  // Rotate 90 degrees clockwise.
+  const char* p = pattern;
+  for (int y = 0; y < patternHeight; ++y) {
+    for (int x = 0; x < patternWidth; ++x, ++p) {
+      rotated[x * patternHeight + (patternHeight - 1 - y)] = *p;
+    }
+  }
+  addPattern(rotated.data(), patternHeight, patternWidth);
+
+  // Rotate upside down.
+  p = pattern;
+  for (int y = 0; y < patternHeight; ++y) {
+    for (int x = 0; x < patternWidth; ++x, ++p) {
+      rotated[(patternHeight - 1 - y) * patternWidth + (patternWidth - 1 - x)] = *p;
+    }
+  }
+  addPattern(rotated.data(), patternWidth, patternHeight);
+
+  // Rotate 90 degrees counter-clockwise.
+  p = pattern;
+  for (int y = 0; y < patternHeight; ++y) {
+    for (int x = 0; x < patternWidth; ++x, ++p) {
+      rotated[(patternWidth - 1 - x) * patternHeight + y] = *p;
+    }
+  }
+  addPattern(rotated.data(), patternHeight, patternWidth);
+}
+
+void HitMissPipeline::applyInPlace(BinaryImage& img) const {
+  if (img.isNull() || m_stages.empty()) {
+    return;
+  }
+  Runner(m_stages, m_srcSurroundings, img).run();
+}
+
+/*========================== HitMissPipeline::Runner ==========================*/
+
+HitMissPipeline::Runner::Runner(const std::vector<Stage>& stages, const BWColor srcSurroundings, BinaryImage& img)
+    : m_stages(stages),
+      m_width(img.width()),
+      m_height(img.height()),
+      m_srcWpl(img.wordsPerLine()),
+      m_words((img.width() + 63) / 64),
+      m_paddedWords(m_words + 2),
+      m_surroundings(srcSurroundings == BLACK ? ~uint64_t(0) : 0),
+      m_tailMask(~uint64_t(0) << ((64 - m_width % 64) % 64)),
+      m_data(img.data()),
+      m_surroundingsRow(m_paddedWords, m_surroundings),
+      m_levels(stages.size() + 1) {
+  // A level must keep all the rows its consumer may still read.
+  // The consumer reads its input rows while matching and copies them
+  // when producing its own rows, which may lag behind the matching.
+  for (size_t i = 0; i < m_levels.size(); ++i) {
+    int capacity = 2;
+    if (i < m_stages.size()) {
+      const Stage& consumer = m_stages[i];
+      capacity = consumer.matchBottom - std::min(consumer.replaceTop, consumer.matchTop + 1) + 2;
+    }
+    m_levels[i].rows = RowRing(capacity, m_paddedWords);
+    if (i > 0) {
+      const Stage& stage = m_stages[i - 1];
+      m_levels[i].matches = RowRing(stage.replaceBottom - stage.replaceTop + 1, m_paddedWords);
+    }
+  }
+}
+
+void HitMissPipeline::Runner::run() {
+  const int lastLevel = static_cast<int>(m_stages.size());
+  for (int y = 0; y < m_height; ++y) {
+    storeRow(row(lastLevel, y), y);
+  }
+}
+
+const uint64_t* HitMissPipeline::Runner::row(const int level, const int y) {
+  if ((y < 0) || (y >= m_height)) {
+    return m_surroundingsRow.data();
+  }
+
+  Level& lv = m_levels[level];
+  while (lv.rowsProduced <= y) {
+    if (level == 0) {
+      produceSourceRow(lv.rowsProduced);
+    } else {
+      produceStageRow(level, lv.rowsProduced);
+    }
+    ++lv.rowsProduced;
+  }
+  return lv.rows.row(y);
+}
+
+void HitMissPipeline::Runner::produceSourceRow(const int y) {
+  uint64_t* const dst = m_levels[0].rows.row(y);
+  const uint32_t* const src = m_data + static_cast<size_t>(y) * m_srcWpl;
+  const auto surroundings32 = static_cast<uint32_t>(m_surroundings);
+
+  dst[0] = m_surroundings;
+  for (int i = 0; i < m_words; ++i) {
+    const uint32_t hi = src[2 * i];
+    const uint32_t lo = (2 * i + 1 < m_srcWpl) ? src[2 * i + 1] : surroundings32;
+    dst[i + 1] = (uint64_t(hi) << 32) | lo;
+  }
+  dst[m_words + 1] = m_surroundings;
+  maskTail(dst, m_surroundings);
+}
+
+void HitMissPipeline::Runner::produceStageRow(const int level, const int y) {
+  const Stage& stage = m_stages[level - 1];
+  Level& lv = m_levels[level];
+
+  // Matches with origins up to this row may modify it.
+  const int lastOrigin = std::min(m_height - 1, y - stage.replaceTop);
+  while (lv.matchesProduced <= lastOrigin) {
+    produceMatchRow(level, lv.matchesProduced);
+    ++lv.matchesProduced;
+  }
+
+  const uint64_t* const src = row(level - 1, y);
+  uint64_t* const dst = lv.rows.row(y);
+  std::copy(src, src + m_paddedWords, dst);
+
+  // Matches are found on the unmodified image, so all the
+  // replacements of a stage are independent of each other.
+  for (const Offset& offset : stage.whiteToBlack) {
+    const int origin = y - offset.dy;
+    if ((origin < 0) || (origin >= m_height)) {
+      continue;
+    }
+    const uint64_t* const matches = lv.matches.row(origin);
+    for (int i = 0; i < m_words; ++i) {
+      dst[i + 1] |= shiftedWord(matches, i, -offset.dx);
+    }
+  }
+  for (const Offset& offset : stage.blackToWhite) {
+    const int origin = y - offset.dy;
+    if ((origin < 0) || (origin >= m_height)) {
+      continue;
+    }
+    const uint64_t* const matches = lv.matches.row(origin);
+    for (int i = 0; i < m_words; ++i) {
+      dst[i + 1] &= ~shiftedWord(matches, i, -offset.dx);
+    }
+  }
+
+  // Replacements may have spilled beyond the image width.
+  maskTail(dst, m_surroundings);
+}  // HitMissPipeline::Runner::produceStageRow
+
+void HitMissPipeline::Runner::produceMatchRow(const int level, const int y) {
+  const Stage& stage = m_stages[level - 1];
+  uint64_t* const dst = m_levels[level].matches.row(y);
+
+  dst[0] = 0;
+  std::fill(dst + 1, dst + 1 + m_words, ~uint64_t(0));
+  dst[m_words + 1] = 0;
+
+  for (const Offset& hit : stage.hits) {
+    const uint64_t* const src = row(level - 1, y + hit.dy);
+    for (int i = 0; i < m_words; ++i) {
+      dst[i + 1] &= shiftedWord(src, i, hit.dx);
+    }
+  }
+  for (const Offset& miss : stage.misses) {
+    const uint64_t* const src = row(level - 1, y + miss.dy);
+    for (int i = 0; i < m_words; ++i) {
+      dst[i + 1] &= ~shiftedWord(src, i, miss.dx);
+    }
+  }
+
+  // The origin must be inside the image.
+  maskTail(dst, 0);
+}
+
+void HitMissPipeline::Runner::storeRow(const uint64_t* const row, const int y) {
+  uint32_t* const dst = m_data + static_cast<size_t>(y) * m_srcWpl;
+  for (int i = 0; i < m_words; ++i) {
+    const uint64_t word = row[i + 1];
+    dst[2 * i] = static_cast<uint32_t>(word >> 32);
+    if (2 * i + 1 < m_srcWpl) {
+      dst[2 * i + 1] = static_cast<uint32_t>(word);
+    }
+  }
+}
+
+void HitMissPipeline::Runner::maskTail(uint64_t* const row, const uint64_t outside) const {
+  uint64_t& last = row[m_words];
+  last = (last & m_tailMask) | (outside & ~m_tailMask);
+}
+}  // namespace imageproc
@@ -0,0 +1,80 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#ifndef SCANTAILOR_IMAGEPROC_HITMISSPIPELINE_H_
+#define SCANTAILOR_IMAGEPROC_HITMISSPIPELINE_H_
+
+#include <vector>
+
+#include "BWColor.h"
+
+namespace imageproc {
+class BinaryImage;
+
+/**
+ * \brief A sequence of hit-miss replacements applied in a single pass.
+ *
+ * Applying a pipeline produces exactly the same result as calling
+ * hitMissReplaceInPlace() for every added pattern in the order they
+ * were added.  The difference is that the image is read and written
+ * only once.  Every pattern becomes a stage that only keeps a small
+ * window of rows, consuming the rows produced by the previous stage
+ * as soon as they are ready.  Within a row, all the pixels are matched
+ * at once by boolean operations on shifted 64-bit words.
+ */
+class HitMissPipeline {
+ public:
+  explicit HitMissPipeline(BWColor srcSurroundings = WHITE);
+
+  /**
+   * \brief Appends a hit-miss replacement stage.
+   *
+   * \param pattern A pattern in the format of hitMissReplaceInPlace().
+   *        Patterns without replacements are ignored.
+   * \param patternWidth The width of the pattern.
+   * \param patternHeight The height of the pattern.
+   */
+  void addPattern(const char* pattern, int patternWidth, int patternHeight);
+
+  /**
+   * \brief Appends four stages: the pattern as is, then rotated by 90 degrees
+   *        clockwise, upside down and by 90 degrees counter-clockwise.
+   */
+  void addPatternAllDirections(const char* pattern, int patternWidth, int patternHeight);
+
+  bool isEmpty() const { return m_stages.empty(); }
+
+  void applyInPlace(BinaryImage& img) const;
+
+ private:
+  struct Offset {
+    int dx;
+    int dy;
+  };
+
+  /**
+   * A compiled pattern.  Offsets are relative to the pattern origin,
+   * which is one of the replacement positions.
+   */
+  struct Stage {
+    std::vector<Offset> hits;
+    std::vector<Offset> misses;
+    std::vector<Offset> whiteToBlack;
+    std::vector<Offset> blackToWhite;
+
+    // The range of rows relative to the origin that are tested.
+    int matchTop = 0;
+    int matchBottom = 0;
+
+    // The range of rows relative to the origin that are modified.
+    int replaceTop = 0;
+    int replaceBottom = 0;
+  };
+
+  class Runner;
+
+  BWColor m_srcSurroundings;
+  std::vector<Stage> m_stages;
+};
+}  // namespace imageproc
+#endif  // ifndef SCANTAILOR_IMAGEPROC_HITMISSPIPELINE_H_
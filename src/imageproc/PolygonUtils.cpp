@@ -194,4 +194,27 @@ QPolygonF PolygonUtils::convexHull(std::vector<QPointF> pointCloud) {
   }
   return poly;
 }
+
+QPolygonF PolygonUtils::densify(const QPolygonF& poly, const double maxSegmentLength) {
+  assert(maxSegmentLength > 0);
+
+  const int numVertices = poly.isClosed() ? poly.size() - 1 : poly.size();
+  if (numVertices < 2) {
+    return poly;
+  }
+
+  QPolygonF dense;
+  dense.reserve(numVertices);
+  for (int i = 0; i < numVertices; ++i) {
+    const QPointF& from = poly[i];
+    const QPointF& to = poly[(i + 1) % numVertices];
+    dense << from;
+
+    const auto numSteps = static_cast<int>(std::ceil(QLineF(from, to).length() / maxSegmentLength));
+    for (int step = 1; step < numSteps; ++step) {
+      dense << from + (to - from) * (double(step) / numSteps);
+    }
+  }
+  return dense;
+}
 }  // namespace imageproc
\ No newline at end of file
@@ -37,6 +37,17 @@ class PolygonUtils {
 
   static QPolygonF convexHull(std::vector<QPointF> pointCloud);
 
+  /**
+   * \brief Inserts vertices along the edges, so that none is longer than \p maxSegmentLength.
+   *
+   * The closing edge is treated like the others.  That's what polygons
+   * need before being put through a non-linear mapping, which only
+   * moves the vertices and would otherwise leave the edges straight.
+   *
+   * \return An unclosed polygon going through all the original vertices.
+   */
+  static QPolygonF densify(const QPolygonF& poly, double maxSegmentLength);
+
  private:
   class Before;
 
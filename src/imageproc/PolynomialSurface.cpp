@@ -106,6 +106,47 @@ PolynomialSurface::PolynomialSurface(const int horDegree,
   }
 }
 
+PolynomialSurface::PolynomialSurface(const int horDegree,
+                                     const int vertDegree,
+                                     const QSize& size,
+                                     const std::vector<Sample>& samples)
+    : m_horDegree(horDegree), m_vertDegree(vertDegree) {
+  // Note: m_horDegree and m_vertDegree may still change!
+
+  if (horDegree < 0) {
+    throw std::invalid_argument("PolynomialSurface: horizontal degree is invalid");
+  }
+  if (vertDegree < 0) {
+    throw std::invalid_argument("PolynomialSurface: vertical degree is invalid");
+  }
+
+  const auto numDataPoints = static_cast<int>(
+      std::count_if(samples.begin(), samples.end(), [](const Sample& sample) { return sample.weight > 0.0; }));
+  if (numDataPoints == 0) {
+    m_horDegree = 0;
+    m_vertDegree = 0;
+    VecT<double>(1, 0.0).swap(m_coeffs);
+    return;
+  }
+
+  maybeReduceDegrees(numDataPoints);
+
+  const int numTerms = calcNumTerms();
+  VecT<double>(numTerms, 0.0).swap(m_coeffs);
+
+  MatT<double> AtA(numTerms, numTerms);
+  VecT<double> Atb(numTerms);
+  prepareDataForLeastSquares(size, samples, AtA, Atb, m_horDegree, m_vertDegree);
+
+  fixSquareMatrixRankDeficiency(AtA);
+
+  try {
+    DynamicMatrixCalc<double> mc;
+    mc(AtA).solve(mc(Atb)).write(m_coeffs.data());
+  } catch (const std::runtime_error&) {
+  }
+}
+
 GrayImage PolynomialSurface::render(const QSize& size) const {
   if (size.isEmpty()) {
     return GrayImage();
@@ -165,6 +206,24 @@ GrayImage PolynomialSurface::render(const QSize& size) const {
   return image;
 }  // PolynomialSurface::render
 
+double PolynomialSurface::valueAt(const QPointF& pos, const QSize& size) const {
+  const double xAdjusted = pos.x() * calcScale(size.width());
+  const double yAdjusted = pos.y() * calcScale(size.height());
+
+  double sum = 0.0;
+  double yPower = 1.0;
+  int term = 0;
+  for (int i = 0; i <= m_vertDegree; ++i) {
+    double xPower = 1.0;
+    for (int j = 0; j <= m_horDegree; ++j, ++term) {
+      sum += m_coeffs[term] * yPower * xPower;
+      xPower *= xAdjusted;
+    }
+    yPower *= yAdjusted;
+  }
+  return sum * 255.0;
+}
+
 void PolynomialSurface::maybeReduceDegrees(const int numDataPoints) {
   assert(numDataPoints > 0);
 
@@ -349,6 +408,60 @@ void PolynomialSurface::prepareDataForLeastSquares(const GrayImage& image,
   }
 }  // PolynomialSurface::prepareDataForLeastSquares
 
+void PolynomialSurface::prepareDataForLeastSquares(const QSize& size,
+                                                   const std::vector<Sample>& samples,
+                                                   MatT<double>& AtA,
+                                                   VecT<double>& Atb,
+                                                   const int hDegree,
+                                                   const int vDegree) {
+  double* const AtA_data = AtA.data();
+  double* const Atb_data = Atb.data();
+
+  const auto numTerms = static_cast<int>(Atb.size());
+
+  // Pretend that both x and y positions of pixels
+  // lie in range of [0, 1].
+  const double xscale = calcScale(size.width());
+  const double yscale = calcScale(size.height());
+
+  // To force data samples into [0, 1] range.
+  const double dataScale = 1.0 / 255.0;
+
+  VecT<double> fullPowers(numTerms);
+
+  for (const Sample& sample : samples) {
+    if (sample.weight <= 0.0) {
+      continue;
+    }
+
+    const double xAdjusted = xscale * sample.pos.x();
+    const double yAdjusted = yscale * sample.pos.y();
+
+    int pos = 0;
+    double yPower = 1.0;
+    for (int i = 0; i <= vDegree; ++i) {
+      double xPower = 1.0;
+      for (int j = 0; j <= hDegree; ++j, ++pos) {
+        fullPowers[pos] = yPower * xPower;
+        xPower *= xAdjusted;
+      }
+      yPower *= yAdjusted;
+    }
+
+    const double dataPoint = dataScale * sample.value;
+    double* p_AtA = AtA_data;
+    for (int i = 0; i < numTerms; ++i) {
+      const double iVal = fullPowers[i] * sample.weight;
+      Atb_data[i] += iVal * dataPoint;
+
+      for (int j = 0; j < numTerms; ++j) {
+        *p_AtA += iVal * fullPowers[j];
+        ++p_AtA;
+      }
+    }
+  }
+}  // PolynomialSurface::prepareDataForLeastSquares
+
 void PolynomialSurface::fixSquareMatrixRankDeficiency(MatT<double>& mat) {
   assert(mat.cols() == mat.rows());
 
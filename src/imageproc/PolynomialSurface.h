@@ -4,8 +4,10 @@
 #ifndef SCANTAILOR_IMAGEPROC_POLYNOMIALSURFACE_H_
 #define SCANTAILOR_IMAGEPROC_POLYNOMIALSURFACE_H_
 
+#include <QPointF>
 #include <QSize>
 #include <cstdint>
+#include <vector>
 
 #include "MatT.h"
 #include "VecT.h"
@@ -20,6 +22,15 @@ class GrayImage;
 class PolynomialSurface {
   // Member-wise copying is OK.
  public:
+  /**
+   * \brief A gray level the surface should pass through, and how much it matters.
+   */
+  struct Sample {
+    QPointF pos;
+    double value;
+    double weight;
+  };
+
   /**
    * \brief Calculate a polynomial that approximates the given image.
    *
@@ -59,6 +70,20 @@ class PolynomialSurface {
    */
   PolynomialSurface(int horDegree, int vertDegree, const GrayImage& src, const BinaryImage& mask);
 
+  /**
+   * \brief Calculate a polynomial that approximates a set of weighted samples.
+   *
+   * \param horDegree The degree of the polynomial in horizontal direction.
+   *        Must not be negative.
+   * \param vertDegree The degree of the polynomial in vertical direction.
+   *        Must not be negative.
+   * \param size The size of the image the sample positions refer to.
+   *        Rendering the surface at this size reproduces the samples.
+   * \param samples Sample positions are in pixels of \p size, values are
+   *        gray levels.  Samples with a non-positive weight are ignored.
+   */
+  PolynomialSurface(int horDegree, int vertDegree, const QSize& size, const std::vector<Sample>& samples);
+
   /**
    * \brief Visualizes the polynomial surface as a grayscale image.
    *
@@ -66,6 +91,15 @@ class PolynomialSurface {
    */
   GrayImage render(const QSize& size) const;
 
+  /**
+   * \brief Evaluates the surface at a single point.
+   *
+   * \param pos The point in pixels of \p size.
+   * \param size The size the surface is stretched / shrunk to, as in render().
+   * \return The gray level, not clamped to [0, 255].
+   */
+  double valueAt(const QPointF& pos, const QSize& size) const;
+
  private:
   void maybeReduceDegrees(int numDataPoints);
 
@@ -86,6 +120,13 @@ class PolynomialSurface {
                                          int hDegree,
                                          int vDegree);
 
+  static void prepareDataForLeastSquares(const QSize& size,
+                                         const std::vector<Sample>& samples,
+                                         MatT<double>& AtA,
+                                         VecT<double>& Atb,
+                                         int hDegree,
+                                         int vDegree);
+
   static void fixSquareMatrixRankDeficiency(MatT<double>& mat);
 
   VecT<double> m_coeffs;
@@ -3,9 +3,15 @@
 
 #include "Scale.h"
 
+#include <QImage>
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstdint>
 #include <stdexcept>
+#include <vector>
 
+#include "BinaryImage.h"
 #include "GrayImage.h"
 
 namespace imageproc {
@@ -360,4 +366,116 @@ GrayImage scaleToGray(const GrayImage& src, const QSize& dstSize) {
   // PageLayoutEstimator and the dewarping tracers depend on.
   return scaleGrayToGray(src, dstSize);
 }
+
+/**
+ * Where source pixel \p srcIdx goes when shrinking by \p scale: the destination
+ * pixel its left (top) edge falls into, and the part of it that stays there.
+ * The rest goes to the next destination pixel.
+ */
+static void coverageSpan(const int srcIdx, const double scale, const int dstLength, int& dstIdx, double& share) {
+  const double from = srcIdx * scale;
+  dstIdx = std::min(static_cast<int>(from), dstLength - 1);
+  const double boundary = dstIdx + 1;
+  if ((from + scale <= boundary) || (dstIdx + 1 >= dstLength)) {
+    share = 1.0;
+  } else {
+    share = (boundary - from) / scale;
+  }
+}
+
+GrayImage scaleToGray(const BinaryImage& src, const QSize& dstSize) {
+  if (src.isNull()) {
+    return GrayImage();
+  }
+
+  if (!dstSize.isValid()) {
+    throw std::invalid_argument("scaleToGray: dstSize is invalid");
+  }
+
+  if (dstSize.isEmpty()) {
+    return GrayImage();
+  }
+
+  const int sw = src.width();
+  const int sh = src.height();
+  const int dw = dstSize.width();
+  const int dh = dstSize.height();
+  if ((dw > sw) || (dh > sh)) {
+    return scaleToGray(GrayImage(src.toQImage()), dstSize);
+  }
+
+  const double xScale = double(dw) / sw;
+  const double yScale = double(dh) / sh;
+  // A destination pixel is that many source pixels.
+  const double dstPixelArea = 1.0 / (xScale * yScale);
+
+  std::vector<int> dstColumn(sw);
+  std::vector<double> columnShare(sw);
+  for (int sx = 0; sx < sw; ++sx) {
+    coverageSpan(sx, xScale, dw, dstColumn[sx], columnShare[sx]);
+  }
+
+  GrayImage dst(dstSize);
+  uint8_t* const dstData = dst.data();
+  const int dstStride = dst.stride();
+
+  // Black source area collected for the destination row being built, and for the one after it.
+  std::vector<double> rowBlack(dw + 1);
+  std::vector<double> coverage(dw + 1, 0.0);
+  std::vector<double> nextCoverage(dw + 1, 0.0);
+  int coverageRow = 0;
+
+  auto emitRow = [&]() {
+    uint8_t* const line = dstData + coverageRow * dstStride;
+    for (int dx = 0; dx < dw; ++dx) {
+      const double black = std::min(1.0, coverage[dx] / dstPixelArea);
+      line[dx] = static_cast<uint8_t>(std::lround(255.0 * (1.0 - black)));
+    }
+    coverage.swap(nextCoverage);
+    std::fill(nextCoverage.begin(), nextCoverage.end(), 0.0);
+    ++coverageRow;
+  };
+
+  const int srcWpl = src.wordsPerLine();
+  const uint32_t* srcLine = src.data();
+  for (int sy = 0; sy < sh; ++sy, srcLine += srcWpl) {
+    int dy;
+    double rowShare;
+    coverageSpan(sy, yScale, dh, dy, rowShare);
+    // When shrinking, consecutive source rows never skip a destination row.
+    while (coverageRow < dy) {
+      emitRow();
+    }
+
+    bool anyBlack = false;
+    std::fill(rowBlack.begin(), rowBlack.end(), 0.0);
+    for (int word = 0; word < srcWpl; ++word) {
+      uint32_t bits = srcLine[word];
+      if (bits == 0) {
+        continue;  // 32 white pixels.
+      }
+      const int wordStart = word << 5;
+      for (int bit = 0; bits != 0; ++bit, bits <<= 1) {
+        const int sx = wordStart + bit;
+        if ((bits & (uint32_t(1) << 31)) && (sx < sw)) {
+          rowBlack[dstColumn[sx]] += columnShare[sx];
+          rowBlack[dstColumn[sx] + 1] += 1.0 - columnShare[sx];
+          anyBlack = true;
+        }
+      }
+    }
+
+    if (anyBlack) {
+      for (int dx = 0; dx < dw; ++dx) {
+        coverage[dx] += rowBlack[dx] * rowShare;
+        nextCoverage[dx] += rowBlack[dx] * (1.0 - rowShare);
+      }
+    }
+  }
+
+  while (coverageRow < dh) {
+    emitRow();
+  }
+  return dst;
+}  // scaleToGray
 }  // namespace imageproc
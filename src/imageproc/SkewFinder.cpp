@@ -4,8 +4,10 @@
 #include "SkewFinder.h"
 
 #include <QDebug>
+#include <algorithm>
 #include <cmath>
 #include <stdexcept>
+#include <vector>
 
 #include "BinaryImage.h"
 #include "BitOps.h"
@@ -26,6 +28,8 @@ const int SkewFinder::DEFAULT_COARSE_REDUCTION = 2;
 
 const int SkewFinder::DEFAULT_FINE_REDUCTION = 1;
 
+const double SkewFinder::DEFAULT_EXPECTED_SKEW_WINDOW = 2.0;
+
 const double SkewFinder::LOW_SCORE = 1000.0;
 
 SkewFinder::SkewFinder()
@@ -34,7 +38,10 @@ SkewFinder::SkewFinder()
       m_accuracy(DEFAULT_ACCURACY),
       m_resolutionRatio(1.0),
       m_coarseReduction(DEFAULT_COARSE_REDUCTION),
-      m_fineReduction(DEFAULT_FINE_REDUCTION) {}
+      m_fineReduction(DEFAULT_FINE_REDUCTION),
+      m_expectedSkew(0.0),
+      m_expectedSkewWindow(DEFAULT_EXPECTED_SKEW_WINDOW),
+      m_hasExpectedSkew(false) {}
 
 void SkewFinder::setMaxAngle(const double maxAngle) {
   if ((maxAngle < 0.0) || (maxAngle > 45.0)) {
@@ -75,7 +82,20 @@ void SkewFinder::setResolutionRatio(const double ratio) {
   m_resolutionRatio = ratio;
 }
 
-Skew SkewFinder::findSkew(const BinaryImage& image) const {
+void SkewFinder::setExpectedSkew(const double angle, const double window) {
+  if (window < 0.0) {
+    throw std::invalid_argument("SkewFinder: expected skew window is invalid");
+  }
+  m_expectedSkew = angle;
+  m_expectedSkewWindow = window;
+  m_hasExpectedSkew = true;
+}
+
+void SkewFinder::clearExpectedSkew() {
+  m_hasExpectedSkew = false;
+}
+
+Skew SkewFinder::findSkew(const BinaryImage& image, int* numEvaluatedAngles) const {
   if (image.isNull()) {
     throw std::invalid_argument("SkewFinder: null image was provided");
   }
@@ -92,29 +112,95 @@ Skew SkewFinder::findSkew(const BinaryImage& image) const {
     coarseReduced.reduce(i == 0 ? 1 : 2);
   }
 
+  int unusedCounter;
+  int& numEvaluated = numEvaluatedAngles ? *numEvaluatedAngles : unusedCounter;
+  numEvaluated = 0;
+
   BinaryImage skewed(coarseReduced.image().size());
   const double coarseStep = 1.0;  // degrees
   // Coarse linear search.
+  const int numCoarseAngles = static_cast<int>(std::floor(2.0 * m_maxAngle / coarseStep + 1e-9)) + 1;
+  std::vector<double> coarseScores(numCoarseAngles, -1.0);
+  const auto coarseScore = [&](const int idx) {
+    if (coarseScores[idx] < 0.0) {
+      coarseScores[idx] = process(coarseReduced, skewed, -m_maxAngle + idx * coarseStep);
+      ++numEvaluated;
+    }
+    return coarseScores[idx];
+  };
+
+  // Note that internally the angles have the opposite sign to Skew::angle().
+  int firstIdx = 0;
+  int lastIdx = numCoarseAngles - 1;
+  if (m_hasExpectedSkew) {
+    const double center = -m_expectedSkew + m_maxAngle;
+    firstIdx = std::max(0, static_cast<int>(std::ceil((center - m_expectedSkewWindow) / coarseStep - 1e-9)));
+    lastIdx = std::min(lastIdx, static_cast<int>(std::floor((center + m_expectedSkewWindow) / coarseStep + 1e-9)));
+  }
+
   int numCoarseScores = 0;
   double sumCoarseScores = 0.0;
   double bestCoarseScore = 0.0;
-  double bestCoarseAngle = -m_maxAngle;
-  for (double angle = -m_maxAngle; angle <= m_maxAngle; angle += coarseStep) {
-    const double score = process(coarseReduced, skewed, angle);
-    sumCoarseScores += score;
-    ++numCoarseScores;
-    if (score > bestCoarseScore) {
-      bestCoarseAngle = angle;
-      bestCoarseScore = score;
+  int bestCoarseIdx = 0;
+  const auto searchCoarse = [&](const int from, const int to) {
+    numCoarseScores = 0;
+    sumCoarseScores = 0.0;
+    bestCoarseScore = 0.0;
+    bestCoarseIdx = 0;
+    for (int idx = from; idx <= to; ++idx) {
+      const double score = coarseScore(idx);
+      sumCoarseScores += score;
+      ++numCoarseScores;
+      if (score > bestCoarseScore) {
+        bestCoarseIdx = idx;
+        bestCoarseScore = score;
+      }
+    }
+  };
+
+  bool searchFullRange = true;
+  if ((firstIdx <= lastIdx) && ((firstIdx > 0) || (lastIdx < numCoarseAngles - 1))) {
+    searchCoarse(firstIdx, lastIdx);
+    const bool peakInside = (bestCoarseScore > 0.0) && ((bestCoarseIdx > firstIdx) || (firstIdx == 0))
+                            && ((bestCoarseIdx < lastIdx) || (lastIdx == numCoarseAngles - 1));
+    if (peakInside) {
+      // Assume the angles we haven't checked score like the ends of the full range
+      // and estimate the confidence of the full search from that.
+      double sumFarScores = 0.0;
+      int numFarScores = 0;
+      for (const int idx : {0, numCoarseAngles - 1}) {
+        if ((idx < firstIdx) || (idx > lastIdx)) {
+          sumFarScores += coarseScore(idx);
+          ++numFarScores;
+        }
+      }
+      const double farScore = sumFarScores / numFarScores;
+      sumCoarseScores += farScore * (numCoarseAngles - numCoarseScores);
+      numCoarseScores = numCoarseAngles;
+      const double confidence = bestCoarseScore / sumCoarseScores * numCoarseScores - 1.0;
+      searchFullRange = (farScore >= bestCoarseScore) || (confidence < Skew::GOOD_CONFIDENCE);
     }
   }
+  if (searchFullRange) {
+    searchCoarse(0, numCoarseAngles - 1);
+  }
+  const double bestCoarseAngle = -m_maxAngle + bestCoarseIdx * coarseStep;
+
+  // The confidence of a narrowed search is estimated from the ends of the range,
+  // so it must not pass for one measured over the whole range.
+  const auto makeSkew = [searchFullRange](const double angle, const double confidence) {
+    if (searchFullRange) {
+      return Skew(angle, confidence);
+    }
+    return Skew(angle, std::min(confidence, std::nextafter(Skew::GOOD_CONFIDENCE, 0.0)), true);
+  };
 
   if (m_accuracy >= coarseStep) {
     double confidence = 0.0;
     if (numCoarseScores > 1) {
       confidence = bestCoarseScore / sumCoarseScores * numCoarseScores;
     }
-    return Skew(-bestCoarseAngle, confidence - 1.0);
+    return makeSkew(-bestCoarseAngle, confidence - 1.0);
   }
 
   for (int i = minReduction; i < m_fineReduction; ++i) {
@@ -124,20 +210,24 @@ Skew SkewFinder::findSkew(const BinaryImage& image) const {
   if (m_coarseReduction != m_fineReduction) {
     skewed = BinaryImage(fineReduced.image().size());
   }
+  const auto fineScore = [&](const double angle) {
+    ++numEvaluated;
+    return process(fineReduced, skewed, angle);
+  };
   // Fine binary search.
   double anglePlus = bestCoarseAngle + 0.5 * coarseStep;
   double angleMinus = bestCoarseAngle - 0.5 * coarseStep;
-  double scorePlus = process(fineReduced, skewed, anglePlus);
-  double scoreMinus = process(fineReduced, skewed, angleMinus);
+  double scorePlus = fineScore(anglePlus);
+  double scoreMinus = fineScore(angleMinus);
   const double fineScore1 = scorePlus;
   const double fineScore2 = scoreMinus;
   while (anglePlus - angleMinus > m_accuracy) {
     if (scorePlus > scoreMinus) {
       angleMinus = 0.5 * (anglePlus + angleMinus);
-      scoreMinus = process(fineReduced, skewed, angleMinus);
+      scoreMinus = fineScore(angleMinus);
     } else if (scorePlus < scoreMinus) {
       anglePlus = 0.5 * (anglePlus + angleMinus);
-      scorePlus = process(fineReduced, skewed, anglePlus);
+      scorePlus = fineScore(anglePlus);
     } else {
       // This protects us from unreasonably low m_accuracy.
       break;
@@ -155,10 +245,10 @@ Skew SkewFinder::findSkew(const BinaryImage& image) const {
   }
 
   if (std::abs(bestAngle) < m_minAngle) {
-    return Skew(0.0, Skew::GOOD_CONFIDENCE);
+    return makeSkew(0.0, Skew::GOOD_CONFIDENCE);
   }
   if (bestScore <= LOW_SCORE) {
-    return Skew(-bestAngle, 0.0);  // Zero confidence.
+    return makeSkew(-bestAngle, 0.0);  // Zero confidence.
   }
 
   double confidence;
@@ -172,7 +262,7 @@ Skew SkewFinder::findSkew(const BinaryImage& image) const {
     sumScores += fineScore2;
     confidence = bestScore / sumScores * numScores;
   }
-  return Skew(-bestAngle, confidence - 1.0);
+  return makeSkew(-bestAngle, confidence - 1.0);
 }  // SkewFinder::findSkew
 
 double SkewFinder::process(const BinaryImage& src, BinaryImage& dst, const double angle) const {
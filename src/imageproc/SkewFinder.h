@@ -21,9 +21,10 @@ class Skew {
    */
   static const double GOOD_CONFIDENCE;
 
-  Skew() : m_angle(0.0), m_confidence(0.0) {}
+  Skew() : m_angle(0.0), m_confidence(0.0), m_confidenceEstimated(false) {}
 
-  Skew(double angle, double confidence) : m_angle(angle), m_confidence(confidence) {}
+  Skew(double angle, double confidence, bool confidenceEstimated = false)
+      : m_angle(angle), m_confidence(confidence), m_confidenceEstimated(confidenceEstimated) {}
 
   /**
    * \brief Get the skew angle in degrees.
@@ -41,9 +42,21 @@ class Skew {
    */
   double confidence() const { return m_confidence; }
 
+  /**
+   * \brief Whether the confidence was only estimated.
+   *
+   * That's the case when the search was narrowed around the expected skew
+   * and the rest of the range wasn't checked.  Such a confidence is always
+   * kept below GOOD_CONFIDENCE, so the angle is only as good as the
+   * expectation it was searched around.
+   * \see SkewFinder::setExpectedSkew()
+   */
+  bool isConfidenceEstimated() const { return m_confidenceEstimated; }
+
  private:
   double m_angle;
   double m_confidence;
+  bool m_confidenceEstimated;
 };
 
 
@@ -61,6 +74,8 @@ class SkewFinder {
 
   static const int DEFAULT_FINE_REDUCTION;
 
+  static const double DEFAULT_EXPECTED_SKEW_WINDOW;
+
   SkewFinder();
 
   /**
@@ -125,12 +140,30 @@ class SkewFinder {
    */
   void setResolutionRatio(double ratio);
 
+  /**
+   * \brief Start the coarse search around the expected skew angle.
+   *
+   * Only the coarse angles within \p window degrees from \p angle are
+   * checked at first, plus the two ends of the full range to estimate
+   * the confidence.  If the best angle ends up on the edge of the window
+   * or the confidence is poor, the rest of the full range is searched,
+   * which gives the same result as searching it from the start.
+   * Otherwise the result has an estimated confidence.
+   * \see Skew::isConfidenceEstimated()
+   * \param angle The expected skew, in the same convention as Skew::angle().
+   */
+  void setExpectedSkew(double angle, double window = DEFAULT_EXPECTED_SKEW_WINDOW);
+
+  void clearExpectedSkew();
+
   /**
    * \brief Process the image and determine its skew.
    * \note If the image contains text columns at (slightly) different
    * angles, one of those angles will be found, with a lower confidence.
+   * \param numEvaluatedAngles If provided, receives the number of angles
+   *        the image was sheared and scored at.
    */
-  Skew findSkew(const BinaryImage& image) const;
+  Skew findSkew(const BinaryImage& image, int* numEvaluatedAngles = nullptr) const;
 
  private:
   static const double LOW_SCORE;
@@ -145,6 +178,9 @@ class SkewFinder {
   double m_resolutionRatio;
   int m_coarseReduction;
   int m_fineReduction;
+  double m_expectedSkew;
+  double m_expectedSkewWindow;
+  bool m_hasExpectedSkew;
 };
 }  // namespace imageproc
 #endif  // ifndef SCANTAILOR_IMAGEPROC_SKEWFINDER_H_
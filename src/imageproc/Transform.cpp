@@ -5,11 +5,14 @@
 
 #include <QDebug>
 #include <cassert>
+#include <cmath>
 #include <stdexcept>
 
 #include "BadAllocIfNull.h"
+#include "BinaryImage.h"
 #include "ColorMixer.h"
 #include "Grayscale.h"
+#include "RasterOp.h"
 
 namespace imageproc {
 namespace {
@@ -398,4 +401,64 @@ GrayImage transformToGray(const QImage& src,
   fixDpiInPlace(dst, src, xform);
   return dst;
 }
+
+BinaryImage transform(const BinaryImage& src,
+                      const QTransform& xform,
+                      const QRect& dstRect,
+                      const BWColor outsideColor) {
+  if (src.isNull() || dstRect.isEmpty()) {
+    return BinaryImage();
+  }
+  if (!xform.isAffine()) {
+    throw std::invalid_argument("transform: only affine transformations are supported");
+  }
+  if (!dstRect.isValid()) {
+    throw std::invalid_argument("transform: dstRect is invalid");
+  }
+
+  BinaryImage dst(dstRect.size(), outsideColor);
+
+  if ((xform.type() <= QTransform::TxTranslate) && (xform.dx() == std::floor(xform.dx()))
+      && (xform.dy() == std::floor(xform.dy()))) {
+    // Just cropping.
+    const QPoint offset(static_cast<int>(xform.dx()), static_cast<int>(xform.dy()));
+    const QRect srcSubRect(dstRect.translated(-offset).intersected(src.rect()));
+    if (!srcSubRect.isEmpty()) {
+      rasterOp<RopSrc>(dst, srcSubRect.translated(offset - dstRect.topLeft()), src, srcSubRect.topLeft());
+    }
+    return dst;
+  }
+
+  const QTransform dstToSrc(xform.inverted());
+  const QPointF srcStep(dstToSrc.map(QPointF(1, 0)) - dstToSrc.map(QPointF(0, 0)));
+
+  const int srcWidth = src.width();
+  const int srcHeight = src.height();
+  const int srcWpl = src.wordsPerLine();
+  const uint32_t* const srcData = src.data();
+  const int dstWidth = dst.width();
+  const int dstHeight = dst.height();
+  const int dstWpl = dst.wordsPerLine();
+  uint32_t* dstLine = dst.data();
+  const uint32_t msb = uint32_t(1) << 31;
+
+  for (int y = 0; y < dstHeight; ++y, dstLine += dstWpl) {
+    const QPointF srcOrigin(dstToSrc.map(QPointF(dstRect.left() + 0.5, dstRect.top() + y + 0.5)));
+    double srcX = srcOrigin.x();
+    double srcY = srcOrigin.y();
+    for (int x = 0; x < dstWidth; ++x, srcX += srcStep.x(), srcY += srcStep.y()) {
+      if ((srcX < 0) || (srcY < 0) || (srcX >= srcWidth) || (srcY >= srcHeight)) {
+        continue;
+      }
+      const auto sx = static_cast<int>(srcX);
+      const auto sy = static_cast<int>(srcY);
+      if ((srcData[sy * srcWpl + (sx >> 5)] << (sx & 31)) & msb) {
+        dstLine[x >> 5] |= msb >> (x & 31);
+      } else {
+        dstLine[x >> 5] &= ~(msb >> (x & 31));
+      }
+    }
+  }
+  return dst;
+}  // transform
 }  // namespace imageproc
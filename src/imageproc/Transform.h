@@ -8,11 +8,14 @@
 #include <QSizeF>
 #include <cstdint>
 
+#include "BWColor.h"
+
 class QImage;
 class QRect;
 class QTransform;
 
 namespace imageproc {
+class BinaryImage;
 class GrayImage;
 
 class OutsidePixels {
@@ -98,5 +101,22 @@ GrayImage transformToGray(const QImage& src,
                           const QRect& dstRect,
                           OutsidePixels outsidePixels,
                           const QSizeF& minMappingArea = QSizeF(0.9, 0.9));
+
+/**
+ * \brief Apply an affine transformation to a binary image, without going through gray.
+ *
+ * Every destination pixel takes the color of the source pixel its center maps to.
+ * At a scale of about 1, which is what rotating and cropping a scan at its own
+ * resolution is, that gives the same result as transforming to gray and
+ * thresholding, except for a pixel here and there along the edges.  For shrinking,
+ * scale to gray with scaleToGray() first, as there it's the coverage that matters.
+ *
+ * \param src The source image.
+ * \param xform The transformation from source to destination.
+ *        Only affine transformations are supported.
+ * \param dstRect The area in destination image coordinates to return.
+ * \param outsideColor The color of destination pixels mapping outside the source image.
+ */
+BinaryImage transform(const BinaryImage& src, const QTransform& xform, const QRect& dstRect, BWColor outsideColor);
 }  // namespace imageproc
 #endif  // ifndef SCANTAILOR_IMAGEPROC_TRANSFORM_H_
@@ -0,0 +1,207 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include <BWColor.h>
+#include <BinaryImage.h>
+#include <HitMissPipeline.h>
+#include <Morphology.h>
+
+#include <boost/test/unit_test.hpp>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "Utils.h"
+
+namespace imageproc {
+namespace tests {
+using namespace utils;
+
+namespace {
+struct Pattern {
+  const char* data;
+  int width;
+  int height;
+};
+
+// The edge smoothing patterns of the output stage.
+const Pattern SMOOTHING_PATTERNS[] = {{"XXX"
+                                       " - "
+                                       "   ",
+                                       3, 3},
+                                      {"X ?"
+                                       "X  "
+                                       "X- "
+                                       "X- "
+                                       "X  "
+                                       "X ?",
+                                       3, 6},
+                                      {"X ?"
+                                       "X ?"
+                                       "X  "
+                                       "X- "
+                                       "X- "
+                                       "X- "
+                                       "X  "
+                                       "X ?"
+                                       "X ?",
+                                       3, 9},
+                                      {"XX?"
+                                       "XX?"
+                                       "XX "
+                                       "X+ "
+                                       "X+ "
+                                       "X+ "
+                                       "XX "
+                                       "XX?"
+                                       "XX?",
+                                       3, 9},
+                                      {"XX?"
+                                       "XX "
+                                       "X+ "
+                                       "X+ "
+                                       "XX "
+                                       "XX?",
+                                       3, 6},
+                                      {"   "
+                                       "X+X"
+                                       "XXX",
+                                       3, 3}};
+
+/**
+ * Applies the pattern and its rotations one by one, the way
+ * the output stage used to do it.
+ */
+void referenceReplaceAllDirections(BinaryImage& img,
+                                   const BWColor srcSurroundings,
+                                   const char* const pattern,
+                                   const int patternWidth,
+                                   const int patternHeight) {
+  hitMissReplaceInPlace(img, srcSurroundings, pattern, patternWidth, patternHeight);
+
+  std::vector<char> rotated(static_cast<size_t>(patternWidth * patternHeight));
+
+  const char* p = pattern;
+  for (int y = 0; y < patternHeight; ++y) {
+    for (int x = 0; x < patternWidth; ++x, ++p) {
+      rotated[x * patternHeight + (patternHeight - 1 - y)] = *p;
+    }
+  }
+  hitMissReplaceInPlace(img, srcSurroundings, rotated.data(), patternHeight, patternWidth);
+
+  p = pattern;
+  for (int y = 0; y < patternHeight; ++y) {
+    for (int x = 0; x < patternWidth; ++x, ++p) {
+      rotated[(patternHeight - 1 - y) * patternWidth + (patternWidth - 1 - x)] = *p;
+    }
+  }
+  hitMissReplaceInPlace(img, srcSurroundings, rotated.data(), patternWidth, patternHeight);
+
+  p = pattern;
+  for (int y = 0; y < patternHeight; ++y) {
+    for (int x = 0; x < patternWidth; ++x, ++p) {
+      rotated[(patternWidth - 1 - x) * patternHeight + y] = *p;
+    }
+  }
+  hitMissReplaceInPlace(img, srcSurroundings, rotated.data(), patternHeight, patternWidth);
+}
+
+bool smoothingMatchesReference(const BinaryImage& img, const BWColor srcSurroundings) {
+  HitMissPipeline pipeline(srcSurroundings);
+  BinaryImage control(img);
+  for (const Pattern& pattern : SMOOTHING_PATTERNS) {
+    pipeline.addPatternAllDirections(pattern.data, pattern.width, pattern.height);
+    referenceReplaceAllDirections(control, srcSurroundings, pattern.data, pattern.width, pattern.height);
+  }
+
+  BinaryImage result(img);
+  pipeline.applyInPlace(result);
+  return result == control;
+}
+
+std::string randomPattern(const int width, const int height) {
+  static const char chars[] = "X -+?";
+  std::string pattern(static_cast<size_t>(width * height), '?');
+  for (char& ch : pattern) {
+    ch = chars[std::rand() % 5];
+  }
+  return pattern;
+}
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(HitMissPipelineTestSuite)
+
+BOOST_AUTO_TEST_CASE(test_empty_pipeline) {
+  const HitMissPipeline pipeline;
+  BOOST_CHECK(pipeline.isEmpty());
+
+  const BinaryImage img(randomBinaryImage(50, 20));
+  BinaryImage result(img);
+  pipeline.applyInPlace(result);
+  BOOST_CHECK(result == img);
+}
+
+BOOST_AUTO_TEST_CASE(test_smoothing_matches_sequential_replacements) {
+  std::srand(0);
+  for (const BWColor surroundings : {WHITE, BLACK}) {
+    for (int width = 1; width <= 130; ++width) {
+      for (const int height : {1, 2, 5, 17, 40}) {
+        BOOST_TEST_CONTEXT("size " << width << 'x' << height << " surroundings " << surroundings) {
+          BOOST_CHECK(smoothingMatchesReference(randomBinaryImage(width, height), surroundings));
+        }
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_smoothing_matches_on_all_small_images) {
+  const int width = 4;
+  const int height = 4;
+  for (unsigned bits = 0; bits < (1u << (width * height)); ++bits) {
+    int pixels[width * height];
+    for (int i = 0; i < width * height; ++i) {
+      pixels[i] = (bits >> i) & 1;
+    }
+    const BinaryImage img(makeBinaryImage(pixels, width, height));
+    for (const BWColor surroundings : {WHITE, BLACK}) {
+      if (!smoothingMatchesReference(img, surroundings)) {
+        BOOST_ERROR("mismatch on image " << bits << " surroundings " << surroundings);
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_random_patterns_match_sequential_replacements) {
+  std::srand(1);
+  for (int iteration = 0; iteration < 300; ++iteration) {
+    const int width = 1 + std::rand() % 150;
+    const int height = 1 + std::rand() % 30;
+    const BWColor surroundings = (iteration % 2 == 0) ? WHITE : BLACK;
+
+    HitMissPipeline pipeline(surroundings);
+    const BinaryImage img(randomBinaryImage(width, height));
+    BinaryImage control(img);
+
+    const int numPatterns = 1 + std::rand() % 4;
+    for (int i = 0; i < numPatterns; ++i) {
+      const int patternWidth = 1 + std::rand() % 5;
+      const int patternHeight = 1 + std::rand() % 5;
+      const std::string pattern(randomPattern(patternWidth, patternHeight));
+      if (std::rand() % 2 == 0) {
+        pipeline.addPattern(pattern.c_str(), patternWidth, patternHeight);
+        hitMissReplaceInPlace(control, surroundings, pattern.c_str(), patternWidth, patternHeight);
+      } else {
+        pipeline.addPatternAllDirections(pattern.c_str(), patternWidth, patternHeight);
+        referenceReplaceAllDirections(control, surroundings, pattern.c_str(), patternWidth, patternHeight);
+      }
+    }
+
+    BinaryImage result(img);
+    pipeline.applyInPlace(result);
+    BOOST_CHECK_MESSAGE(result == control, "mismatch at iteration " << iteration);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+}  // namespace tests
+}  // namespace imageproc
@@ -0,0 +1,34 @@
+// Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
+// Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
+
+#include <PolygonUtils.h>
+
+#include <QLineF>
+#include <QPointF>
+#include <QPolygonF>
+#include <boost/test/unit_test.hpp>
+
+namespace imageproc {
+namespace tests {
+BOOST_AUTO_TEST_SUITE(PolygonUtilsTestSuite)
+
+BOOST_AUTO_TEST_CASE(test_densify) {
+  QPolygonF square;
+  square << QPointF(0, 0) << QPointF(10, 0) << QPointF(10, 10) << QPointF(0, 10) << QPointF(0, 0);
+
+  const QPolygonF dense(PolygonUtils::densify(square, 4.0));
+  // Each of the four edges is split into three pieces.  The closing vertex isn't repeated.
+  BOOST_REQUIRE_EQUAL(dense.size(), 12);
+  BOOST_CHECK(dense.front() == QPointF(0, 0));
+  BOOST_CHECK(dense[3] == QPointF(10, 0));
+  for (int i = 0; i < dense.size(); ++i) {
+    BOOST_CHECK_LE(QLineF(dense[i], dense[(i + 1) % dense.size()]).length(), 4.0 + 1e-9);
+  }
+
+  // Edges short enough are left alone.
+  BOOST_CHECK_EQUAL(PolygonUtils::densify(square, 20.0).size(), 4);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+}  // namespace tests
+}  // namespace imageproc
@@ -1,6 +1,7 @@
 // Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
 // Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
 
+#include <BinaryImage.h>
 #include <GrayImage.h>
 #include <Scale.h>
 
@@ -106,6 +107,19 @@ BOOST_AUTO_TEST_CASE(test_random_image) {
   // BOOST_CHECK(checkScale(img, QSize(145, 55)));
 }
 
+BOOST_AUTO_TEST_CASE(test_binary_image) {
+  // The width isn't a multiple of 32, so partial words get checked too.
+  const BinaryImage img(randomBinaryImage(150, 100));
+  const GrayImage gray(img.toQImage());
+
+  for (const QSize& newSize : {QSize(75, 50), QSize(120, 80), QSize(37, 91), QSize(1, 1)}) {
+    BOOST_CHECK(fuzzyCompare(scaleToGray(img, newSize), areaAverageReference(gray, newSize)));
+  }
+
+  // Enlarging goes through the grayscale version.
+  BOOST_CHECK(scaleToGray(img, QSize(300, 200)) == scaleToGray(gray, QSize(300, 200)));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 }  // namespace tests
 }  // namespace imageproc
\ No newline at end of file
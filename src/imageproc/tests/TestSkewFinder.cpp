@@ -72,6 +72,69 @@ BOOST_AUTO_TEST_CASE(test_negative_detection) {
   BOOST_CHECK(skew.confidence() < Skew::GOOD_CONFIDENCE);
 }
 
+namespace {
+/**
+ * Draws lines of "words" made of solid blocks, rotated by \p angle degrees.
+ */
+QImage makeTextBlocksImage(const double angle) {
+  QImage image(1000, 800, QImage::Format_RGB32);
+  image.fill(0xffffffff);
+  QPainter painter(&image);
+  painter.setPen(Qt::NoPen);
+  painter.setBrush(Qt::black);
+  painter.translate(0.5 * image.width(), 0.5 * image.height());
+  painter.rotate(angle);
+  painter.translate(-0.5 * image.width(), -0.5 * image.height());
+
+  for (int y = 100; y < 700; y += 24) {
+    for (int x = 100, word = 0; x < 880; ++word) {
+      const int width = 20 + (word * 37 + y) % 45;
+      painter.drawRect(x, y, width, 10);
+      x += width + 12;
+    }
+  }
+  return image;
+}
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(test_expected_skew_gives_same_result) {
+  const BinaryImage image(makeTextBlocksImage(2.3));
+
+  SkewFinder fullFinder;
+  int fullEvaluated = 0;
+  const Skew fullSkew(fullFinder.findSkew(image, &fullEvaluated));
+  BOOST_REQUIRE(fullSkew.confidence() >= Skew::GOOD_CONFIDENCE);
+  BOOST_REQUIRE(std::fabs(fullSkew.angle() - 2.3) < 0.15);
+
+  SkewFinder windowedFinder;
+  windowedFinder.setExpectedSkew(2.0);
+  int windowedEvaluated = 0;
+  const Skew windowedSkew(windowedFinder.findSkew(image, &windowedEvaluated));
+  BOOST_CHECK_EQUAL(windowedSkew.angle(), fullSkew.angle());
+  // The confidence is estimated from fewer samples, so it's never reported as good.
+  BOOST_CHECK(windowedSkew.isConfidenceEstimated());
+  BOOST_CHECK(windowedSkew.confidence() < Skew::GOOD_CONFIDENCE);
+  BOOST_CHECK(!fullSkew.isConfidenceEstimated());
+  BOOST_CHECK_LT(windowedEvaluated, fullEvaluated);
+}
+
+BOOST_AUTO_TEST_CASE(test_wrong_expected_skew_falls_back_to_full_search) {
+  const BinaryImage image(makeTextBlocksImage(2.3));
+
+  SkewFinder fullFinder;
+  int fullEvaluated = 0;
+  const Skew fullSkew(fullFinder.findSkew(image, &fullEvaluated));
+
+  SkewFinder windowedFinder;
+  windowedFinder.setExpectedSkew(-3.0, 1.0);
+  int windowedEvaluated = 0;
+  const Skew windowedSkew(windowedFinder.findSkew(image, &windowedEvaluated));
+  BOOST_CHECK_EQUAL(windowedSkew.angle(), fullSkew.angle());
+  BOOST_CHECK_EQUAL(windowedSkew.confidence(), fullSkew.confidence());
+  BOOST_CHECK(!windowedSkew.isConfidenceEstimated());
+  BOOST_CHECK_EQUAL(windowedEvaluated, fullEvaluated);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 }  // namespace tests
 }  // namespace imageproc
\ No newline at end of file
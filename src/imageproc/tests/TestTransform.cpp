@@ -1,7 +1,10 @@
 // Copyright (C) 2019  Joseph Artsimovich <joseph.artsimovich@gmail.com>, 4lex4 <4lex49@zoho.com>
 // Use of this source code is governed by the GNU GPLv3 license that can be found in the LICENSE file.
 
+#include <BinaryImage.h>
 #include <Grayscale.h>
+#include <OrthogonalRotation.h>
+#include <RasterOp.h>
 #include <Transform.h>
 
 #include <QImage>
@@ -45,6 +48,62 @@ BOOST_AUTO_TEST_CASE(test_random_image) {
   BOOST_CHECK(transformToGray(img, nullXform, img.rect(), outsidePixels) == img);
 }
 
+static int countDifferentPixels(const BinaryImage& img1, const BinaryImage& img2) {
+  BOOST_REQUIRE(img1.size() == img2.size());
+  BinaryImage diff(img1);
+  rasterOp<RopXor<RopSrc, RopDst>>(diff, img2);
+  return diff.countBlackPixels();
+}
+
+BOOST_AUTO_TEST_CASE(test_binary_crop) {
+  const BinaryImage img(randomBinaryImage(100, 100));
+  const QTransform xform(QTransform::fromTranslate(-10, -20));
+  // Partly outside the source image.
+  const QRect dstRect(40, 30, 80, 70);
+
+  const BinaryImage cropped(transform(img, xform, dstRect, WHITE));
+  BOOST_REQUIRE(cropped.size() == dstRect.size());
+  for (int y = 0; y < dstRect.height(); ++y) {
+    for (int x = 0; x < dstRect.width(); ++x) {
+      const QPoint srcPt(dstRect.left() + x + 10, dstRect.top() + y + 20);
+      const BWColor expected = img.rect().contains(srcPt) ? img.getPixel(srcPt.x(), srcPt.y()) : WHITE;
+      BOOST_REQUIRE(cropped.getPixel(x, y) == expected);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_binary_orthogonal_rotation) {
+  const BinaryImage img(randomBinaryImage(70, 45));
+  // Clockwise by 90 degrees, (x, y) -> (height - y, x).
+  const QTransform xform(0, 1, -1, 0, img.height(), 0);
+  const QRect dstRect(0, 0, img.height(), img.width());
+
+  BOOST_CHECK(transform(img, xform, dstRect, WHITE) == orthogonalRotation(img, 90));
+}
+
+BOOST_AUTO_TEST_CASE(test_binary_rotation_matches_gray_route) {
+  // Something like a page of text: blocks of black a few pixels across.
+  BinaryImage img(QSize(300, 400), WHITE);
+  for (int y = 20; y < 380; y += 14) {
+    for (int x = 20 + (y % 3) * 5; x < 270; x += 23) {
+      img.fill(QRect(x, y, 15, 8), BLACK);
+    }
+  }
+
+  QTransform xform;
+  xform.translate(-150, -200);
+  xform *= QTransform().rotate(1.7);
+  xform *= QTransform().translate(160, 190);
+  const QRect dstRect(0, 0, 320, 380);
+
+  const BinaryImage bitonal(transform(img, xform, dstRect, WHITE));
+  const BinaryImage viaGray(
+      transformToGray(img.toQImage(), xform, dstRect, OutsidePixels::assumeColor(Qt::white)));
+  const int numDifferent = countDifferentPixels(bitonal, viaGray);
+  BOOST_TEST_MESSAGE("pixels different from the gray route: " << numDifferent);
+  BOOST_CHECK_LT(numDifferent, dstRect.width() * dstRect.height() / 100);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 }  // namespace tests
 }  // namespace imageproc
\ No newline at end of file